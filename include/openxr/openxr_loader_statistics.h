@@ -0,0 +1,80 @@
+/*
+** Copyright (c) 2017-2019 The Khronos Group Inc.
+**
+** Licensed under the Apache License, Version 2.0 (the "License");
+** you may not use this file except in compliance with the License.
+** You may obtain a copy of the License at
+**
+**     http://www.apache.org/licenses/LICENSE-2.0
+**
+** Unless required by applicable law or agreed to in writing, software
+** distributed under the License is distributed on an "AS IS" BASIS,
+** WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+** See the License for the specific language governing permissions and
+** limitations under the License.
+*/
+
+#ifndef OPENXR_LOADER_STATISTICS_H_
+#define OPENXR_LOADER_STATISTICS_H_ 1
+
+#include <openxr/openxr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* XR_EXTX_loader_call_statistics
+ *
+ * Implemented by the OpenXR loader itself rather than by runtimes, so it is not
+ * part of the registry.  When the extension is enabled in xrCreateInstance, the
+ * loader trampolines count every call made through them for that instance and
+ * record how long each call took to return.  The duration covers the whole call
+ * chain below the trampoline: the loader, any enabled API layers and the runtime.
+ *
+ * While the extension is enabled, xrGetInstanceProcAddr returns trampolines for
+ * every command so that all calls are counted, and XR_LOADER_DIRECT_DISPATCH is
+ * ignored.
+ *
+ * The commands are only available through xrGetInstanceProcAddr.
+ */
+#define XR_EXTX_loader_call_statistics 1
+#define XR_EXTX_loader_call_statistics_SPEC_VERSION 1
+#define XR_EXTX_LOADER_CALL_STATISTICS_EXTENSION_NAME "XR_EXTX_loader_call_statistics"
+#define XR_MAX_LOADER_COMMAND_NAME_SIZE_EXTX 64
+#define XR_LOADER_CALL_LATENCY_BUCKET_COUNT_EXTX 32
+
+/* Totals for one command.  latencyHistogram[i] counts the calls that took
+ * [2^i, 2^(i+1)) nanoseconds; bucket 0 also holds calls shorter than 1ns and
+ * the last bucket holds every call of 2^31ns or longer.
+ *
+ * This structure is not part of the registry, so it has no XrStructureType and
+ * no next chain. */
+typedef struct XrLoaderCallStatisticsEXTX {
+    char        commandName[XR_MAX_LOADER_COMMAND_NAME_SIZE_EXTX];
+    uint64_t    callCount;
+    uint64_t    totalDurationNs;
+    uint64_t    latencyHistogram[XR_LOADER_CALL_LATENCY_BUCKET_COUNT_EXTX];
+} XrLoaderCallStatisticsEXTX;
+
+/* Returns one entry for each command called at least once since the instance was
+ * created or the statistics were last reset, using the usual two-call idiom. */
+typedef XrResult (XRAPI_PTR *PFN_xrGetLoaderCallStatisticsEXTX)(XrInstance instance, uint32_t statisticCapacityInput, uint32_t* statisticCountOutput, XrLoaderCallStatisticsEXTX* statistics);
+/* Starts counting again from zero for every command. */
+typedef XrResult (XRAPI_PTR *PFN_xrResetLoaderCallStatisticsEXTX)(XrInstance instance);
+
+#ifndef XR_NO_PROTOTYPES
+XRAPI_ATTR XrResult XRAPI_CALL xrGetLoaderCallStatisticsEXTX(
+    XrInstance                                  instance,
+    uint32_t                                    statisticCapacityInput,
+    uint32_t*                                   statisticCountOutput,
+    XrLoaderCallStatisticsEXTX*                 statistics);
+
+XRAPI_ATTR XrResult XRAPI_CALL xrResetLoaderCallStatisticsEXTX(
+    XrInstance                                  instance);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
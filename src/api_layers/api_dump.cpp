@@ -18,7 +18,9 @@
 //
 
 #include "hex_and_handles.h"
+#include "layer_record_writer.h"
 #include "loader_interfaces.h"
+#include "object_info.h"
 #include "platform_utils.hpp"
 #include "xr_generated_api_dump.hpp"
 #include "xr_generated_dispatch_table.h"
@@ -26,19 +28,36 @@
 #include <openxr/openxr.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 #if defined(__GNUC__) && __GNUC__ >= 4
 #define LAYER_EXPORT __attribute__((visibility("default")))
 #elif defined(__SUNPRO_C) && (__SUNPRO_C >= 0x590)
@@ -55,23 +74,42 @@ enum ApiDumpRecordType {
     RECORD_TEXT_FILE,
     RECORD_HTML_FILE,
     RECORD_CODE_FILE,
+    RECORD_COMPACT_FILE,
+    RECORD_SUMMARY,
+    RECORD_RING_FILE,
 };
 
 struct ApiDumpRecordInfo {
     bool initialized;
     ApiDumpRecordType type;
     std::string file_name;
+    bool asynchronous;
+    bool timing;
 };
 
 static ApiDumpRecordInfo g_record_info = {};
 static std::mutex g_record_mutex = {};
 
+// The text, HTML or compact capture file being recorded to, kept open between commands.  Guarded by g_record_mutex.
+static LayerRecordFile g_record_file;
+
+// Get the record file, opening it with the given mode if it is not open yet.  Call with g_record_mutex held.
+static std::ofstream &ApiDumpLayerRecordFile(std::ios::openmode mode = std::ios::out | std::ios::app) {
+    if (g_record_info.type == RECORD_COMPACT_FILE) {
+        mode |= std::ios::binary;
+    }
+    return g_record_file.Get(g_record_info.file_name, mode);
+}
+
+// Write out what the record file is holding, if it has been a while, or always when forced.  Call with g_record_mutex
+// held.
+static void ApiDumpLayerFlushRecordFile(bool force) { g_record_file.Flush(force); }
+
 // HTML utilities
 bool ApiDumpLayerWriteHtmlHeader() {
     try {
         std::unique_lock<std::mutex> mlock(g_record_mutex);
-        std::ofstream html_file;
-        html_file.open(g_record_info.file_name, std::ios::out);
+        std::ofstream &html_file = ApiDumpLayerRecordFile(std::ios::out | std::ios::trunc);
         html_file << "<!doctype html>\n"
                      "<html>\n"
                      "    <head>\n"
@@ -179,11 +217,11 @@ bool ApiDumpLayerWriteHtmlHeader() {
 bool ApiDumpLayerWriteHtmlFooter() {
     try {
         std::unique_lock<std::mutex> mlock(g_record_mutex);
-        std::ofstream html_file;
-        html_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
+        std::ofstream &html_file = ApiDumpLayerRecordFile();
         html_file << "        </div>\n"
                      "    </body>\n"
                      "</html>";
+        html_file.close();
 
         // Writing the footer means we're done.
         if (g_record_info.initialized) {
@@ -197,210 +235,910 @@ bool ApiDumpLayerWriteHtmlFooter() {
     }
 }
 
+// Compact capture utilities
+//
+// With XR_API_DUMP_EXPORT_TYPE set to "compact", each command's contents are written to the file as they are, without
+// the text or HTML layout around them, and src/scripts/render_api_dump_capture.py turns the file into the text or HTML
+// output afterwards.  The values are still converted to strings by the generated code at call time, so this saves
+// file space rather than time in the application.  Types and names repeat from one call to the next, so each is written once, as a string record, and
+// referred to by its id after that.  Everything is in the byte order of the machine that wrote the file.
+//
+//   header:            u32 magic ("XRAD"), u32 version
+//   then records of:   u32 size (of the whole record), u32 kind, followed by
+//     string (1):      u32 id, u32 length, the string's bytes
+//     command (2):     u32 entry count, then for each entry: u32 type id, u32 name id, u32 value length, the value's bytes
+static const uint32_t kCompactCaptureMagic = 0x44415258;
+static const uint32_t kCompactCaptureVersion = 1;
+static const uint32_t kCompactCaptureStringRecord = 1;
+static const uint32_t kCompactCaptureCommandRecord = 2;
+
+// The ids given to the types and names written so far.  Guarded by g_record_mutex.
+static std::unordered_map<std::string, uint32_t> g_record_string_ids;
+
+static void ApiDumpAppendUint32(std::string &record, uint32_t value) {
+    record.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void ApiDumpAppendRecordHeader(std::string &record, uint32_t kind) {
+    // The size is filled in once the rest of the record is there
+    ApiDumpAppendUint32(record, 0);
+    ApiDumpAppendUint32(record, kind);
+}
+
+static void ApiDumpFinishRecord(std::string &record) {
+    uint32_t size = static_cast<uint32_t>(record.size());
+    memcpy(&record[0], &size, sizeof(size));
+}
+
+// Get the id for a type or name, writing out its string record first if it has not been seen before.  Call with
+// g_record_mutex held.
+static uint32_t ApiDumpCompactStringId(std::ofstream &capture_file, const std::string &value) {
+    auto found = g_record_string_ids.find(value);
+    if (found != g_record_string_ids.end()) {
+        return found->second;
+    }
+    uint32_t id = static_cast<uint32_t>(g_record_string_ids.size() + 1);
+    g_record_string_ids.emplace(value, id);
+
+    std::string record;
+    ApiDumpAppendRecordHeader(record, kCompactCaptureStringRecord);
+    ApiDumpAppendUint32(record, id);
+    ApiDumpAppendUint32(record, static_cast<uint32_t>(value.size()));
+    record += value;
+    ApiDumpFinishRecord(record);
+    capture_file.write(record.data(), record.size());
+    return id;
+}
+
+bool ApiDumpLayerWriteCompactHeader() {
+    try {
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        std::ofstream &capture_file = ApiDumpLayerRecordFile(std::ios::out | std::ios::trunc);
+        g_record_string_ids.clear();
+        std::string header;
+        ApiDumpAppendUint32(header, kCompactCaptureMagic);
+        ApiDumpAppendUint32(header, kCompactCaptureVersion);
+        capture_file.write(header.data(), header.size());
+        return capture_file.good();
+    } catch (...) {
+        return false;
+    }
+}
+
+// Ring file utilities
+//
+// With XR_API_DUMP_EXPORT_TYPE set to "ring", the text output is written into a file of fixed size, mapped into memory,
+// going back around to the start of it when it reaches the end.  This keeps only the most recent calls, however long the
+// application runs, and whatever was written is already in the file if the application crashes.
+// src/scripts/decode_api_dump_ring.py prints what the file holds, oldest first.  The file starts with a header, in the
+// byte order of the machine that wrote it, and the text follows it:
+//
+//   u32 magic ("XRAR"), u32 version, u64 capacity (of the text that follows the header), u64 head (how many bytes of text
+//   have been written in all, so the next one goes at head % capacity), u32 process id, the rest of the 64 bytes zero
+static const uint32_t kRingFileMagic = 0x52415258;
+static const uint32_t kRingFileVersion = 1;
+static const size_t kRingFileHeaderSize = 64;
+static const uint64_t kRingFileDefaultSizeMiB = 16;
+
+class ApiDumpRingFile {
+   public:
+    ApiDumpRingFile() = default;
+    ~ApiDumpRingFile() { Close(); }
+    ApiDumpRingFile(const ApiDumpRingFile &) = delete;
+    ApiDumpRingFile &operator=(const ApiDumpRingFile &) = delete;
+
+    // Create the file, replacing any that is there, with room for capacity bytes of text.
+    bool Open(const std::string &file_name, uint64_t capacity) {
+        Close();
+        _size = kRingFileHeaderSize + capacity;
+        if (!Map(file_name)) {
+            return false;
+        }
+        _capacity = capacity;
+        _head = 0;
+        memset(_data, 0, kRingFileHeaderSize);
+        Put<uint32_t>(0, kRingFileMagic);
+        Put<uint32_t>(4, kRingFileVersion);
+        Put<uint64_t>(8, _capacity);
+        Put<uint64_t>(16, _head);
+#if defined(_WIN32)
+        Put<uint32_t>(24, static_cast<uint32_t>(GetCurrentProcessId()));
+#else
+        Put<uint32_t>(24, static_cast<uint32_t>(getpid()));
+#endif
+        return true;
+    }
+
+    bool IsOpen() const { return nullptr != _data; }
+
+    // Add text after what was written last, over the oldest text once the file is full.  Only the end of text is kept if
+    // it is longer than the whole file.
+    void Write(const std::string &text) {
+        if (nullptr == _data || text.empty()) {
+            return;
+        }
+        const char *source = text.data();
+        uint64_t length = text.size();
+        uint64_t head = _head + length;
+        if (length > _capacity) {
+            source += length - _capacity;
+            length = _capacity;
+        }
+        uint64_t position = (head - length) % _capacity;
+        uint64_t first = (std::min)(length, _capacity - position);
+        memcpy(_data + kRingFileHeaderSize + position, source, static_cast<size_t>(first));
+        memcpy(_data + kRingFileHeaderSize, source + first, static_cast<size_t>(length - first));
+        // Only move the head on once the text is in place, so that a reader never sees the head past unwritten text
+        std::atomic_thread_fence(std::memory_order_release);
+        _head = head;
+        Put<uint64_t>(16, _head);
+    }
+
+    void Close() { Unmap(); }
+
+   private:
+    template <typename T>
+    void Put(size_t offset, T value) {
+        memcpy(_data + offset, &value, sizeof(value));
+    }
+
+    bool Map(const std::string &file_name);
+    void Unmap();
+
+    uint64_t _size = 0;
+    uint64_t _capacity = 0;
+    uint64_t _head = 0;
+    uint8_t *_data = nullptr;
+#if defined(_WIN32)
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _file = -1;
+#endif
+};
+
+#if defined(_WIN32)
+bool ApiDumpRingFile::Map(const std::string &file_name) {
+    _file = CreateFileA(file_name.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == _file) {
+        return false;
+    }
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(_size >> 32),
+                                  static_cast<DWORD>(_size & 0xFFFFFFFFUL), nullptr);
+    if (nullptr != _mapping) {
+        _data = static_cast<uint8_t *>(MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(_size)));
+    }
+    if (nullptr == _data) {
+        Unmap();
+        return false;
+    }
+    return true;
+}
+
+void ApiDumpRingFile::Unmap() {
+    if (nullptr != _data) {
+        UnmapViewOfFile(_data);
+        _data = nullptr;
+    }
+    if (nullptr != _mapping) {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+    }
+    if (INVALID_HANDLE_VALUE != _file) {
+        CloseHandle(_file);
+        _file = INVALID_HANDLE_VALUE;
+    }
+}
+#else
+bool ApiDumpRingFile::Map(const std::string &file_name) {
+    _file = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_file < 0) {
+        return false;
+    }
+    if (ftruncate(_file, static_cast<off_t>(_size)) != 0) {
+        Unmap();
+        return false;
+    }
+    void *data = mmap(nullptr, static_cast<size_t>(_size), PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+    if (MAP_FAILED == data) {
+        Unmap();
+        return false;
+    }
+    _data = static_cast<uint8_t *>(data);
+    return true;
+}
+
+void ApiDumpRingFile::Unmap() {
+    if (nullptr != _data) {
+        munmap(_data, static_cast<size_t>(_size));
+        _data = nullptr;
+    }
+    if (_file >= 0) {
+        close(_file);
+        _file = -1;
+    }
+}
+#endif
+
+// Guarded by g_record_mutex.
+static ApiDumpRingFile g_record_ring;
+
+static bool ApiDumpLayerOpenRingFile() {
+    try {
+        uint64_t size_mib = kRingFileDefaultSizeMiB;
+        char *ring_size = PlatformUtilsGetEnv("XR_API_DUMP_RING_SIZE");
+        if (nullptr != ring_size) {
+            uint64_t requested = std::strtoull(ring_size, nullptr, 10);
+            PlatformUtilsFreeEnv(ring_size);
+            if (requested > 0) {
+                size_mib = requested;
+            }
+        }
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        return g_record_ring.Open(g_record_info.file_name, size_mib * 1024 * 1024);
+    } catch (...) {
+        return false;
+    }
+}
+
+static void ApiDumpLayerCloseRingFile() {
+    std::unique_lock<std::mutex> mlock(g_record_mutex);
+    g_record_ring.Close();
+
+    // Closing the file means we're done, as with the HTML footer.
+    if (g_record_info.initialized) {
+        g_record_info.initialized = false;
+        g_record_info.type = RECORD_NONE;
+    }
+}
+
+// The dispatch table created for each instance, which every handle created from that instance then shares.  It keeps
+// the instance it was created for, so that the instance can be found from the table without searching any of the maps.
+struct ApiDumpInstanceDispatchTable : XrGeneratedDispatchTable {
+    XrInstance instance;
+};
+
 // Api Dump Utility function to return an instance based on the generated dispatch table
 // pointer.
 XrInstance FindInstanceFromDispatchTable(XrGeneratedDispatchTable *dispatch_table) {
-    std::unique_lock<std::mutex> mlock(g_instance_dispatch_mutex);
-    XrInstance instance = XR_NULL_HANDLE;
-    for (auto it = g_instance_dispatch_map.begin(); it != g_instance_dispatch_map.end();) {
-        if (it->second == dispatch_table) {
-            instance = it->first;
-            break;
+    if (nullptr == dispatch_table) {
+        return XR_NULL_HANDLE;
+    }
+    // Every dispatch table this layer uses was created by ApiDumpLayerXrCreateApiLayerInstance
+    return static_cast<ApiDumpInstanceDispatchTable *>(dispatch_table)->instance;
+}
+
+// Api Dump Utility function to format an unsigned integer as hex, the same as streaming it with "0x" << std::hex, for
+// the generated code.
+std::string ApiDumpHexString(uint64_t value) {
+    char buffer[kUint64HexStringSize];
+    size_t length = Uint64ToHexString(value, buffer);
+    // Drop the leading zeros, keeping at least one digit, and move the "0x" up to the first digit that's left
+    size_t first_digit = 2;
+    while (first_digit < length - 1 && buffer[first_digit] == '0') {
+        ++first_digit;
+    }
+    buffer[first_digit - 2] = '0';
+    buffer[first_digit - 1] = 'x';
+    return std::string(buffer + first_digit - 2, length - first_digit + 2);
+}
+
+// Api Dump Utility function to format a floating point value, the same as streaming it with the given
+// std::setprecision, for the generated code.
+std::string ApiDumpFloatString(double value, int precision) {
+    char buffer[128];
+    int length = snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    if (length < 0) {
+        return std::string();
+    }
+    return std::string(buffer, (std::min)(static_cast<size_t>(length), sizeof(buffer) - 1));
+}
+
+// The number of structure, pointer and array dereferences in an entry's name, which is how deeply the HTML output
+// nests it.
+static uint32_t ApiDumpNameDerefCount(const std::string &name) {
+    uint32_t deref_count = 0;
+    for (std::string::size_type index = 0; index < name.size(); ++index) {
+        char cur = name[index];
+        if (cur == '.' || cur == '[') {
+            ++deref_count;
+        } else if (cur == '-' && index + 1 < name.size() && name[index + 1] == '>') {
+            ++deref_count;
+            ++index;
         }
     }
-    return instance;
+    return deref_count;
 }
 
-// Function to record all the API dump information
-bool ApiDumpLayerRecordContent(std::vector<std::tuple<std::string, std::string, std::string>> contents) {
+// Add the text output for one command to text.
+static void ApiDumpAppendText(const std::vector<std::tuple<std::string, std::string, std::string>> &contents, std::string &text) {
+    bool first = true;
+    for (const auto &content : contents) {
+        if (!first) {
+            text += "    ";
+        }
+        first = false;
+        text += std::get<0>(content);
+        text += ' ';
+        text += std::get<1>(content);
+        const std::string &content_value = std::get<2>(content);
+        if (!content_value.empty()) {
+            text += " = ";
+            text += content_value;
+        }
+        text += '\n';
+    }
+}
+
+// Write out the API dump information for one command.  Call with g_record_mutex held.
+static bool ApiDumpLayerWriteContent(const std::vector<std::tuple<std::string, std::string, std::string>> &contents) {
     bool success = false;
-    if (g_record_info.initialized) {
-        std::unique_lock<std::mutex> mlock(g_record_mutex);
-        uint32_t count = 0;
-        switch (g_record_info.type) {
-            case RECORD_TEXT_COUT: {
-                for (const auto &content : contents) {
-                    std::string content_type;
-                    std::string content_name;
-                    std::string content_value;
-                    std::tie(content_type, content_name, content_value) = content;
-                    if (count++ != 0) {
-                        std::cout << "    ";
-                    }
-                    if (!content_value.empty()) {
-                        std::cout << content_type << " " << content_name << " = " << content_value << "\n";
-                    } else {
-                        std::cout << content_type << " " << content_name << "\n";
-                    }
-                }
-                success = true;
-                break;
+    switch (g_record_info.type) {
+        case RECORD_TEXT_COUT: {
+            std::string text;
+            ApiDumpAppendText(contents, text);
+            std::cout << text;
+            success = true;
+            break;
+        }
+        case RECORD_TEXT_FILE: {
+            std::string text;
+            ApiDumpAppendText(contents, text);
+            ApiDumpLayerRecordFile() << text;
+            ApiDumpLayerFlushRecordFile(false);
+            success = true;
+            break;
+        }
+        case RECORD_RING_FILE: {
+            std::string text;
+            ApiDumpAppendText(contents, text);
+            g_record_ring.Write(text);
+            success = g_record_ring.IsOpen();
+            break;
+        }
+        case RECORD_HTML_FILE: {
+            std::ofstream &text_file = ApiDumpLayerRecordFile();
+            text_file << "<details class='data'>\n";
+
+            // Each entry's depth is needed twice, once for the entry itself and once to see whether the entry before it
+            // opens a section, so work them all out in a single pass over the names.
+            std::vector<uint32_t> deref_counts(contents.size());
+            for (size_t content_index = 0; content_index < contents.size(); ++content_index) {
+                deref_counts[content_index] = ApiDumpNameDerefCount(std::get<1>(contents[content_index]));
             }
-            case RECORD_TEXT_FILE: {
-                std::ofstream text_file;
-                text_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-                for (const auto &content : contents) {
-                    std::string content_type;
-                    std::string content_name;
-                    std::string content_value;
-                    std::tie(content_type, content_name, content_value) = content;
-                    if (count++ != 0) {
-                        text_file << "    ";
-                    }
-                    if (!content_value.empty()) {
-                        text_file << content_type << " " << content_name << " = " << content_value << "\n";
-                    } else {
-                        text_file << content_type << " " << content_name << "\n";
-                    }
+
+            // The entries whose sections are still open, outermost first
+            std::vector<size_t> open_sections;
+            uint32_t last_deref_count = 0;
+            for (size_t content_index = 0; content_index < contents.size(); ++content_index) {
+                const std::string &content_type = std::get<0>(contents[content_index]);
+                const std::string &content_name = std::get<1>(contents[content_index]);
+                const std::string &content_value = std::get<2>(contents[content_index]);
+                if (content_index == 0) {
+                    text_file << "   <summary>\n"
+                              << "      <div class='headertype'>" << content_type << "</div>\n"
+                              << "      <div class='headervar'>" << content_name << "</div>\n"
+                              << "   </summary>\n";
+                    continue;
                 }
-                text_file.close();
-                success = true;
-                break;
-            }
-            case RECORD_HTML_FILE: {
-                std::ofstream text_file;
-                text_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-                text_file << "<details class='data'>\n";
-                std::vector<std::string> prefixes;
-                uint32_t last_deref_count = 0;
-                for (uint32_t content_index = 0; content_index < contents.size(); ++content_index) {
-                    std::string content_type;
-                    std::string content_name;
-                    std::string content_value;
-                    std::tie(content_type, content_name, content_value) = contents[content_index];
-                    if (content_index == 0) {
-                        text_file << "   <summary>\n"
-                                  << "      <div class='headertype'>" << content_type << "</div>\n"
-                                  << "      <div class='headervar'>" << content_name << "</div>\n"
-                                  << "   </summary>\n";
-                    } else {
-                        uint32_t cur_deref_count = 0;
-                        uint32_t next_deref_count = 0;
-
-                        // Count number of structure and pointer dereferences for the current line
-                        cur_deref_count = static_cast<uint32_t>(std::count(content_name.begin(), content_name.end(), '.'));
-                        std::string::size_type start = 0;
-                        while ((start = content_name.find("->", start)) != std::string::npos) {
-                            ++cur_deref_count;
-                            start += 2;
-                        }
-                        // Now look for array dereferences
-                        start = 0;
-                        while ((start = content_name.find('[', start)) != std::string::npos) {
-                            ++cur_deref_count;
-                            start++;
-                        }
 
-                        // If there's something after this, see if it's a sub-component of this.
-                        if (content_index < contents.size() - 1) {
-                            std::string next_content_type;
-                            std::string next_content_name;
-                            std::string next_content_value;
-                            std::tie(next_content_type, next_content_name, next_content_value) = contents[content_index + 1];
-
-                            // Count number of structure and pointer dereferences for the next line
-                            next_deref_count =
-                                static_cast<uint32_t>(std::count(next_content_name.begin(), next_content_name.end(), '.'));
-                            start = 0;
-                            while ((start = next_content_name.find("->", start)) != std::string::npos) {
-                                ++next_deref_count;
-                                start += 2;
-                            }
-                            // Now look for array dereferences
-                            start = 0;
-                            while ((start = next_content_name.find('[', start)) != std::string::npos) {
-                                ++next_deref_count;
-                                start++;
-                            }
-                        }
+                uint32_t cur_deref_count = deref_counts[content_index];
+                uint32_t next_deref_count = 0;
+                if (content_index < contents.size() - 1) {
+                    next_deref_count = deref_counts[content_index + 1];
+                }
 
-                        // If we've reduced the number of dereferences in the name from last time, we need
-                        // to close up those detail sections.
-                        if (cur_deref_count < last_deref_count) {
-                            uint32_t diff_count = last_deref_count - cur_deref_count;
-                            while ((diff_count--) != 0u) {
-                                text_file << "   </details>\n";
-                                prefixes.pop_back();
-                            }
-                        }
+                // If we've reduced the number of dereferences in the name from last time, we need
+                // to close up those detail sections.
+                for (; last_deref_count > cur_deref_count; --last_deref_count) {
+                    text_file << "   </details>\n";
+                    if (!open_sections.empty()) {
+                        open_sections.pop_back();
+                    }
+                }
 
-                        // Look through any prefixes we've saved (going backwards through the list)
-                        // and find the one that matches our beginning.
-                        std::string short_name = content_name;
-                        if (cur_deref_count > 0) {
-                            for (auto it = prefixes.rbegin(); it != prefixes.rend(); ++it) {
-                                if (content_name.find(*it) == 0) {
-                                    std::string::size_type additional_offset = it->size() + 1;
-                                    if (content_name[additional_offset - 1] == '-') {
-                                        additional_offset++;
-                                    } else if (content_name[additional_offset - 1] == '[') {
-                                        additional_offset--;
-                                    }
-                                    short_name = content_name.substr(additional_offset);
-                                    break;
-                                }
+                // Look through the open sections (going backwards through the list) for the one whose
+                // name this one begins with, and leave that part of the name out.
+                const char *short_name = content_name.c_str();
+                if (cur_deref_count > 0) {
+                    for (auto it = open_sections.rbegin(); it != open_sections.rend(); ++it) {
+                        const std::string &prefix = std::get<1>(contents[*it]);
+                        if (content_name.compare(0, prefix.size(), prefix) == 0) {
+                            std::string::size_type additional_offset = prefix.size() + 1;
+                            if (content_name[additional_offset - 1] == '-') {
+                                additional_offset++;
+                            } else if (content_name[additional_offset - 1] == '[') {
+                                additional_offset--;
                             }
+                            short_name += additional_offset;
+                            break;
                         }
+                    }
+                }
 
-                        bool writing_summary = false;
-
-                        // If the next item contains this item as a prefix, start the summary.  Otherwise,
-                        // start a <div> marker so that each component lands on its own line.
-                        if (cur_deref_count < next_deref_count) {
-                            text_file << "   <details class='data'>\n"
-                                      << "      <summary>\n";
-                            writing_summary = true;
-                            prefixes.push_back(content_name);
-                        } else {
-                            text_file << "      <div class='data'>\n";
-                        }
+                bool writing_summary = false;
 
-                        // Write out the content
-                        text_file << "         <div class='type'>" << content_type << "</div>\n"
-                                  << "         <div class='var'>" << short_name << "</div>\n";
-                        bool value_needs_printing = true;
-                        if (content_type.find("char") != std::string::npos) {
-                            uint64_t star_count = std::count(content_type.begin(), content_type.end(), '*');
-                            uint64_t bracket_count = std::count(content_type.begin(), content_type.end(), '[');
-                            if (star_count + bracket_count < 2) {
-                                text_file << "         <div class='val'>\"" << content_value << "\"</div>";
-                                value_needs_printing = false;
-                            }
-                        }
-                        if (!content_value.empty() && value_needs_printing) {
-                            text_file << "         <div class='val'>" << content_value << "</div>";
-                        }
-                        text_file << "\n";
-
-                        // Wrap up any summary we may have started.  Otherwise, just wrap up the
-                        // <div> marker wrapping this entry.
-                        if (writing_summary) {
-                            text_file << "      </summary>\n";
-                        } else {
-                            text_file << "      </div>\n";
-                        }
+                // If the next item contains this item as a prefix, start the summary.  Otherwise,
+                // start a <div> marker so that each component lands on its own line.
+                if (cur_deref_count < next_deref_count) {
+                    text_file << "   <details class='data'>\n"
+                              << "      <summary>\n";
+                    writing_summary = true;
+                    open_sections.push_back(content_index);
+                } else {
+                    text_file << "      <div class='data'>\n";
+                }
 
-                        last_deref_count = cur_deref_count;
+                // Write out the content
+                text_file << "         <div class='type'>" << content_type << "</div>\n"
+                          << "         <div class='var'>" << short_name << "</div>\n";
+                bool value_needs_printing = true;
+                if (content_type.find("char") != std::string::npos) {
+                    uint64_t star_count = std::count(content_type.begin(), content_type.end(), '*');
+                    uint64_t bracket_count = std::count(content_type.begin(), content_type.end(), '[');
+                    if (star_count + bracket_count < 2) {
+                        text_file << "         <div class='val'>\"" << content_value << "\"</div>";
+                        value_needs_printing = false;
                     }
                 }
+                if (!content_value.empty() && value_needs_printing) {
+                    text_file << "         <div class='val'>" << content_value << "</div>";
+                }
+                text_file << "\n";
 
-                // Wrap up any remaining items
-                if (last_deref_count != 0u) {
-                    while ((last_deref_count--) != 0u) {
-                        text_file << "   </details>\n";
-                        prefixes.pop_back();
-                    }
+                // Wrap up any summary we may have started.  Otherwise, just wrap up the
+                // <div> marker wrapping this entry.
+                if (writing_summary) {
+                    text_file << "      </summary>\n";
+                } else {
+                    text_file << "      </div>\n";
                 }
-                text_file << "</details>\n";
-                break;
+
+                last_deref_count = cur_deref_count;
             }
-            default:
-                break;
+
+            // Wrap up any remaining items
+            for (; last_deref_count > 0; --last_deref_count) {
+                text_file << "   </details>\n";
+            }
+            text_file << "</details>\n";
+            ApiDumpLayerFlushRecordFile(false);
+            break;
         }
+        case RECORD_COMPACT_FILE: {
+            std::ofstream &capture_file = ApiDumpLayerRecordFile();
+            std::string record;
+            ApiDumpAppendRecordHeader(record, kCompactCaptureCommandRecord);
+            ApiDumpAppendUint32(record, static_cast<uint32_t>(contents.size()));
+            for (const auto &content : contents) {
+                ApiDumpAppendUint32(record, ApiDumpCompactStringId(capture_file, std::get<0>(content)));
+                ApiDumpAppendUint32(record, ApiDumpCompactStringId(capture_file, std::get<1>(content)));
+                const std::string &content_value = std::get<2>(content);
+                ApiDumpAppendUint32(record, static_cast<uint32_t>(content_value.size()));
+                record += content_value;
+            }
+            ApiDumpFinishRecord(record);
+            capture_file.write(record.data(), record.size());
+            ApiDumpLayerFlushRecordFile(false);
+            success = true;
+            break;
+        }
+        default:
+            break;
     }
     return success;
 }
 
+// The call timings of a frame, or of the whole run, as taken while holding g_timing_mutex.  The summary is made from
+// them afterwards, on the writer thread when there is one.
+struct ApiDumpTimingSnapshot {
+    struct Command {
+        std::string name;
+        // The durations of the frame's calls, for a frame summary
+        std::vector<double> durations_us;
+        uint64_t calls;
+        double total_us;
+        double max_us;
+    };
+    bool whole_run;
+    // The frame that ended, or for the whole run the number of frames
+    uint64_t frame;
+    std::vector<Command> commands;
+};
+
+// What the writer thread is handed: a command's contents, or the timings for a summary
+struct ApiDumpRecord {
+    std::vector<std::tuple<std::string, std::string, std::string>> contents;
+    std::unique_ptr<ApiDumpTimingSnapshot> timings;
+};
+
+// Call with g_record_mutex held
+static void ApiDumpLayerWriteSummary(ApiDumpTimingSnapshot &timings);
+
+// Writes out the API dump information on a thread of its own, when XR_API_DUMP_ASYNC is set, so that the application's
+// threads only have to queue up each command's contents instead of waiting on each other and on the output.  The
+// contents are still gathered on the calling thread, since the structures they come from are only valid during the call.
+static void ApiDumpLayerWriteBatch(const std::deque<ApiDumpRecord> &batch) {
+    std::unique_lock<std::mutex> record_lock(g_record_mutex);
+    for (const auto &record : batch) {
+        if (record.timings) {
+            ApiDumpLayerWriteSummary(*record.timings);
+        } else {
+            ApiDumpLayerWriteContent(record.contents);
+        }
+    }
+}
+
+static LayerRecordThread<ApiDumpRecord> g_record_thread(ApiDumpLayerWriteBatch);
+
+// Function to record all the API dump information
+bool ApiDumpLayerRecordContent(std::vector<std::tuple<std::string, std::string, std::string>> contents) {
+    if (!g_record_info.initialized) {
+        return false;
+    }
+    if (g_record_info.asynchronous) {
+        ApiDumpRecord record;
+        record.contents = std::move(contents);
+        if (g_record_thread.Enqueue(std::move(record))) {
+            return true;
+        }
+        contents = std::move(record.contents);
+    }
+    std::unique_lock<std::mutex> mlock(g_record_mutex);
+    return ApiDumpLayerWriteContent(contents);
+}
+
+// Command filtering
+//
+// XR_API_DUMP_INCLUDE and XR_API_DUMP_EXCLUDE hold lists of command names, or of extension names (XR_VERSION_1_0 for
+// the core commands), separated by commas, semicolons or spaces.  When an include list is given, only the commands it
+// names, or that belong to an extension it names, are recorded; anything the exclude list names is not recorded
+// either way.  XR_API_DUMP_SAMPLE holds a list of "name:N" entries, again naming a command or an extension, and only
+// the first of every N calls to those commands is recorded.  An entry for the command itself wins over one for its
+// extension.
+struct ApiDumpFilterSettings {
+    std::unordered_set<std::string> include;
+    std::unordered_set<std::string> exclude;
+    std::unordered_map<std::string, uint32_t> sample_rates;
+};
+
+static std::mutex g_filter_mutex;
+static ApiDumpFilterSettings g_filter_settings;
+// Changed whenever the filters are loaded, so that each command decides again what to record.  A command's
+// ApiDumpCommandFilter starts out at 0, and so is always decided the first time through.
+static std::atomic<uint32_t> g_filter_generation(1);
+
+static std::vector<std::string> ApiDumpSplitFilterList(const char *list) {
+    std::vector<std::string> names;
+    std::string name;
+    for (const char *cur = list;; ++cur) {
+        if (*cur == '\0' || *cur == ',' || *cur == ';' || std::isspace(static_cast<unsigned char>(*cur))) {
+            if (!name.empty()) {
+                names.push_back(name);
+                name.clear();
+            }
+            if (*cur == '\0') {
+                break;
+            }
+        } else {
+            name += *cur;
+        }
+    }
+    return names;
+}
+
+static void ApiDumpLayerLoadFilters() {
+    ApiDumpFilterSettings settings;
+    char *include = PlatformUtilsGetEnv("XR_API_DUMP_INCLUDE");
+    if (nullptr != include) {
+        for (const auto &name : ApiDumpSplitFilterList(include)) {
+            settings.include.insert(name);
+        }
+        PlatformUtilsFreeEnv(include);
+    }
+    char *exclude = PlatformUtilsGetEnv("XR_API_DUMP_EXCLUDE");
+    if (nullptr != exclude) {
+        for (const auto &name : ApiDumpSplitFilterList(exclude)) {
+            settings.exclude.insert(name);
+        }
+        PlatformUtilsFreeEnv(exclude);
+    }
+    char *sample = PlatformUtilsGetEnv("XR_API_DUMP_SAMPLE");
+    if (nullptr != sample) {
+        for (const auto &entry : ApiDumpSplitFilterList(sample)) {
+            // Anything that isn't a name followed by a rate of at least one is ignored
+            std::string::size_type colon = entry.rfind(':');
+            if (colon == std::string::npos || colon == 0) {
+                continue;
+            }
+            char *end = nullptr;
+            unsigned long rate = strtoul(entry.c_str() + colon + 1, &end, 10);
+            if (end == entry.c_str() + colon + 1 || *end != '\0' || rate < 1 || rate > UINT32_MAX) {
+                continue;
+            }
+            settings.sample_rates[entry.substr(0, colon)] = static_cast<uint32_t>(rate);
+        }
+        PlatformUtilsFreeEnv(sample);
+    }
+
+    std::unique_lock<std::mutex> lock(g_filter_mutex);
+    g_filter_settings = std::move(settings);
+    g_filter_generation.fetch_add(1, std::memory_order_release);
+}
+
+// Work out how often a command is to be recorded: 0 for never, otherwise once every this many calls.
+static uint32_t ApiDumpLayerFilterSampleRate(const char *command_name, const char *extension_name) {
+    std::unique_lock<std::mutex> lock(g_filter_mutex);
+    std::string command(command_name);
+    std::string extension(extension_name);
+    if (!g_filter_settings.include.empty() && g_filter_settings.include.count(command) == 0 &&
+        g_filter_settings.include.count(extension) == 0) {
+        return 0;
+    }
+    if (g_filter_settings.exclude.count(command) != 0 || g_filter_settings.exclude.count(extension) != 0) {
+        return 0;
+    }
+    auto rate = g_filter_settings.sample_rates.find(command);
+    if (rate == g_filter_settings.sample_rates.end()) {
+        rate = g_filter_settings.sample_rates.find(extension);
+    }
+    return (rate == g_filter_settings.sample_rates.end()) ? 1 : rate->second;
+}
+
+// Called at the top of each intercept, before any of its output is generated, so that calls that are filtered out
+// only cost a couple of atomic operations.
+bool ApiDumpLayerShouldRecord(const char *command_name, const char *extension_name, ApiDumpCommandFilter &filter) {
+    // The summary only needs the timing of each call
+    if (g_record_info.type == RECORD_SUMMARY) {
+        return false;
+    }
+    uint32_t generation = g_filter_generation.load(std::memory_order_acquire);
+    if (filter.generation.load(std::memory_order_acquire) != generation) {
+        filter.sample_rate.store(ApiDumpLayerFilterSampleRate(command_name, extension_name), std::memory_order_relaxed);
+        filter.generation.store(generation, std::memory_order_release);
+    }
+    uint32_t sample_rate = filter.sample_rate.load(std::memory_order_relaxed);
+    if (sample_rate <= 1) {
+        return sample_rate == 1;
+    }
+    return filter.calls.fetch_add(1, std::memory_order_relaxed) % sample_rate == 0;
+}
+
+// Object names
+//
+// The names the application gives objects with xrSetDebugUtilsObjectNameEXT are kept here, so that each handle written
+// out can be followed by its name.  Looking a handle up is one hash lookup, and none at all (not even taking the mutex)
+// while no object has a name, which is the usual case.  A name is dropped when its object is destroyed, and all of them
+// once the last instance is.
+struct ApiDumpObjectNames {
+    InternedStringTable strings;
+    ObjectInfoCollection names{strings};
+};
+
+static std::mutex g_object_names_mutex;
+static std::unique_ptr<ApiDumpObjectNames> g_object_names;
+static std::atomic<bool> g_object_names_empty(true);
+
+// Call with g_object_names_mutex held.
+static void ApiDumpLayerUpdateObjectNamesEmpty() {
+    g_object_names_empty.store(!g_object_names || g_object_names->names.Empty(), std::memory_order_release);
+}
+
+void ApiDumpLayerSetObjectName(const XrDebugUtilsObjectNameInfoEXT &name_info) {
+    std::unique_lock<std::mutex> mlock(g_object_names_mutex);
+    if (!g_object_names) {
+        g_object_names.reset(new ApiDumpObjectNames());
+    }
+    g_object_names->names.AddObjectName(name_info.objectHandle, name_info.objectType,
+                                        nullptr == name_info.objectName ? std::string() : name_info.objectName);
+    ApiDumpLayerUpdateObjectNamesEmpty();
+}
+
+void ApiDumpLayerRemoveObjectName(uint64_t handle, XrObjectType object_type) {
+    if (g_object_names_empty.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::unique_lock<std::mutex> mlock(g_object_names_mutex);
+    if (g_object_names) {
+        g_object_names->names.RemoveObject(handle, object_type);
+    }
+    ApiDumpLayerUpdateObjectNamesEmpty();
+}
+
+static void ApiDumpLayerClearObjectNames() {
+    std::unique_lock<std::mutex> mlock(g_object_names_mutex);
+    g_object_names.reset();
+    ApiDumpLayerUpdateObjectNamesEmpty();
+}
+
+std::string ApiDumpObjectHandleString(uint64_t handle, XrObjectType object_type) {
+    std::string value = Uint64ToHexString(handle);
+    if (!g_object_names_empty.load(std::memory_order_acquire)) {
+        std::unique_lock<std::mutex> mlock(g_object_names_mutex);
+        const char *name = g_object_names ? g_object_names->names.LookUpStoredName(handle, object_type) : nullptr;
+        if (nullptr != name) {
+            value += " (";
+            value += name;
+            value += ")";
+        }
+    }
+    return value;
+}
+
+// Call timing
+//
+// With XR_API_DUMP_TIMING set, or XR_API_DUMP_EXPORT_TYPE set to "summary", each intercept times its call down the
+// chain.  Frames are counted by xrWaitFrame calls, and every call is tagged with the frame it was made in.  Recorded
+// commands then get three more entries: the frame, the time the call started (in microseconds since the layer was
+// loaded) and how long it took.  The summary mode records no parameters at all, and instead writes out each command's
+// call count, total time and percentiles once each frame ends with xrEndFrame, along with the totals for the whole run
+// once the last instance is destroyed.
+struct ApiDumpCommandTimes {
+    // The durations of this frame's calls
+    std::vector<double> frame_durations_us;
+    uint64_t calls;
+    double total_us;
+    double max_us;
+};
+
+// Both guarded by g_timing_mutex, and keyed on the command name string each intercept passes in
+static std::mutex g_timing_mutex;
+static std::unordered_map<const char *, ApiDumpCommandTimes> g_command_times;
+static std::atomic<uint64_t> g_frame_index(0);
+static const std::chrono::steady_clock::time_point g_timing_start = std::chrono::steady_clock::now();
+
+static double ApiDumpMicroseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// The nearest-rank percentile of some sorted durations
+static double ApiDumpPercentile(const std::vector<double> &sorted_durations_us, double percentile) {
+    size_t rank = static_cast<size_t>(std::ceil(percentile * sorted_durations_us.size()));
+    return sorted_durations_us[rank > 0 ? rank - 1 : 0];
+}
+
+// Make the summary for some timings and write it out, to the file if one was given or to stdout otherwise.
+static void ApiDumpLayerWriteSummary(ApiDumpTimingSnapshot &timings) {
+    std::sort(timings.commands.begin(), timings.commands.end(),
+              [](const ApiDumpTimingSnapshot::Command &a, const ApiDumpTimingSnapshot::Command &b) { return a.name < b.name; });
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(3);
+    if (timings.whole_run) {
+        summary << "All " << timings.frame << " frames\n";
+        for (const auto &command : timings.commands) {
+            summary << "    " << std::left << std::setw(40) << command.name << std::right << std::setw(6) << command.calls
+                    << " calls, total " << std::setw(12) << command.total_us << " us, mean " << std::setw(12)
+                    << command.total_us / command.calls << " us, max " << std::setw(12) << command.max_us << " us\n";
+        }
+    } else {
+        summary << "Frame " << timings.frame << "\n";
+        for (auto &command : timings.commands) {
+            std::vector<double> &durations_us = command.durations_us;
+            std::sort(durations_us.begin(), durations_us.end());
+            double total_us = 0.0;
+            for (double duration_us : durations_us) {
+                total_us += duration_us;
+            }
+            summary << "    " << std::left << std::setw(40) << command.name << std::right << std::setw(6) << durations_us.size()
+                    << " calls, total " << std::setw(12) << total_us << " us, p50 " << std::setw(12)
+                    << ApiDumpPercentile(durations_us, 0.5) << " us, p95 " << std::setw(12)
+                    << ApiDumpPercentile(durations_us, 0.95) << " us, max " << std::setw(12) << durations_us.back() << " us\n";
+        }
+    }
+    if (!g_record_info.file_name.empty()) {
+        ApiDumpLayerRecordFile() << summary.str();
+        ApiDumpLayerFlushRecordFile(false);
+    } else {
+        std::cout << summary.str();
+    }
+}
+
+// Hand the timings to the writer thread, or write their summary out here if it is not running.
+static void ApiDumpLayerRecordSummary(std::unique_ptr<ApiDumpTimingSnapshot> timings) {
+    if (g_record_info.asynchronous) {
+        ApiDumpRecord record;
+        record.timings = std::move(timings);
+        if (g_record_thread.Enqueue(std::move(record))) {
+            return;
+        }
+        timings = std::move(record.timings);
+    }
+    std::unique_lock<std::mutex> mlock(g_record_mutex);
+    ApiDumpLayerWriteSummary(*timings);
+}
+
+// Write out the summary for the frame that just ended, and start on the next one.  Only the frame's durations are
+// taken while holding g_timing_mutex; sorting them and writing the summary are left until it is released.
+static void ApiDumpLayerSummarizeFrame(uint64_t frame) {
+    std::unique_ptr<ApiDumpTimingSnapshot> timings(new ApiDumpTimingSnapshot());
+    timings->whole_run = false;
+    timings->frame = frame;
+    {
+        std::unique_lock<std::mutex> lock(g_timing_mutex);
+        for (auto &command_times : g_command_times) {
+            std::vector<double> &durations_us = command_times.second.frame_durations_us;
+            if (!durations_us.empty()) {
+                ApiDumpTimingSnapshot::Command command = {command_times.first, std::move(durations_us), 0, 0.0, 0.0};
+                timings->commands.push_back(std::move(command));
+                durations_us.clear();
+            }
+        }
+    }
+    ApiDumpLayerRecordSummary(std::move(timings));
+}
+
+// Write out the totals for every command called since timing started.
+static void ApiDumpLayerSummarizeRun() {
+    std::unique_ptr<ApiDumpTimingSnapshot> timings(new ApiDumpTimingSnapshot());
+    timings->whole_run = true;
+    timings->frame = g_frame_index.load();
+    {
+        std::unique_lock<std::mutex> lock(g_timing_mutex);
+        for (const auto &command_times : g_command_times) {
+            const ApiDumpCommandTimes &times = command_times.second;
+            ApiDumpTimingSnapshot::Command command = {command_times.first, {}, times.calls, times.total_us, times.max_us};
+            timings->commands.push_back(std::move(command));
+        }
+    }
+    ApiDumpLayerRecordSummary(std::move(timings));
+}
+
+ApiDumpCallTiming ApiDumpLayerStartCall(const char *command_name) {
+    ApiDumpCallTiming timing = {};
+    timing.command_name = command_name;
+    timing.enabled = g_record_info.timing;
+    if (timing.enabled) {
+        // Each xrWaitFrame starts a new frame
+        if (0 == strcmp(command_name, "xrWaitFrame")) {
+            timing.frame = g_frame_index.fetch_add(1) + 1;
+        } else {
+            timing.frame = g_frame_index.load();
+        }
+        timing.start = std::chrono::steady_clock::now();
+    }
+    return timing;
+}
+
+void ApiDumpLayerEndCall(ApiDumpCallTiming &timing) {
+    if (!timing.enabled) {
+        return;
+    }
+    timing.duration = std::chrono::steady_clock::now() - timing.start;
+    if (g_record_info.type != RECORD_SUMMARY) {
+        return;
+    }
+    double duration_us = ApiDumpMicroseconds(timing.duration);
+    {
+        std::unique_lock<std::mutex> lock(g_timing_mutex);
+        ApiDumpCommandTimes &times = g_command_times[timing.command_name];
+        times.frame_durations_us.push_back(duration_us);
+        times.calls++;
+        times.total_us += duration_us;
+        times.max_us = (std::max)(times.max_us, duration_us);
+    }
+    if (0 == strcmp(timing.command_name, "xrEndFrame")) {
+        ApiDumpLayerSummarizeFrame(timing.frame);
+    }
+}
+
+// The command itself is recorded before it is called down the chain, so its timing is recorded as an entry of its own.
+void ApiDumpLayerRecordCallTiming(const ApiDumpCallTiming &timing) {
+    if (!timing.enabled) {
+        return;
+    }
+    std::vector<std::tuple<std::string, std::string, std::string>> contents;
+    contents.emplace_back("timing", timing.command_name, "");
+    std::ostringstream start_us;
+    start_us << std::fixed << std::setprecision(3) << ApiDumpMicroseconds(timing.start - g_timing_start);
+    std::ostringstream duration_us;
+    duration_us << std::fixed << std::setprecision(3) << ApiDumpMicroseconds(timing.duration);
+    contents.emplace_back("uint64_t", "frame", std::to_string(timing.frame));
+    contents.emplace_back("double", "start_us", start_us.str());
+    contents.emplace_back("double", "duration_us", duration_us.str());
+    ApiDumpLayerRecordContent(std::move(contents));
+}
+
 XrResult ApiDumpLayerXrCreateInstance(const XrInstanceCreateInfo * /*info*/, XrInstance * /*instance*/) {
     if (!g_record_info.initialized) {
         g_record_info.initialized = true;
@@ -430,6 +1168,22 @@ XrResult ApiDumpLayerXrCreateApiLayerInstance(const XrInstanceCreateInfo *info,
             PlatformUtilsFreeEnv(file_name);
         }
 
+        char *asynchronous = PlatformUtilsGetEnv("XR_API_DUMP_ASYNC");
+        if (nullptr != asynchronous) {
+            g_record_info.asynchronous = (0 != strcmp(asynchronous, "0"));
+            PlatformUtilsFreeEnv(asynchronous);
+        }
+        if (g_record_info.asynchronous) {
+            g_record_thread.Start();
+        }
+        ApiDumpLayerLoadFilters();
+
+        char *timing = PlatformUtilsGetEnv("XR_API_DUMP_TIMING");
+        if (nullptr != timing) {
+            g_record_info.timing = (0 != strcmp(timing, "0"));
+            PlatformUtilsFreeEnv(timing);
+        }
+
         if (nullptr != export_type) {
             std::string string_export_type = export_type;
             PlatformUtilsFreeEnv(export_type);
@@ -447,6 +1201,19 @@ XrResult ApiDumpLayerXrCreateApiLayerInstance(const XrInstanceCreateInfo *info,
                 if (!ApiDumpLayerWriteHtmlHeader()) {
                     return XR_ERROR_INITIALIZATION_FAILED;
                 }
+            } else if (string_export_type == "compact" && first_time && !g_record_info.file_name.empty()) {
+                g_record_info.type = RECORD_COMPACT_FILE;
+                if (!ApiDumpLayerWriteCompactHeader()) {
+                    return XR_ERROR_INITIALIZATION_FAILED;
+                }
+            } else if (string_export_type == "ring" && first_time && !g_record_info.file_name.empty()) {
+                g_record_info.type = RECORD_RING_FILE;
+                if (!ApiDumpLayerOpenRingFile()) {
+                    return XR_ERROR_INITIALIZATION_FAILED;
+                }
+            } else if (string_export_type == "summary") {
+                g_record_info.type = RECORD_SUMMARY;
+                g_record_info.timing = true;
             } else if (string_export_type == "code") {
                 g_record_info.type = RECORD_CODE_FILE;
             }
@@ -466,72 +1233,76 @@ XrResult ApiDumpLayerXrCreateApiLayerInstance(const XrInstanceCreateInfo *info,
             return XR_ERROR_INITIALIZATION_FAILED;
         }
 
-        // Generate output for this command as if it were the standard xrCreateInstance
-        std::vector<std::tuple<std::string, std::string, std::string>> contents;
-        contents.emplace_back("XrResult", "xrCreateInstance", "");
-        contents.emplace_back("const XrInstanceCreateInfo*", "info", PointerToHexString(info));
-        if (nullptr != info) {
-            std::string prefix = "info->";
-            contents.emplace_back("XrStructureType", "info->type", std::to_string(info->type));
-            std::string next_prefix = prefix;
-            next_prefix += "next";
-            // Decode the next chain if it exists
-            if (!ApiDumpDecodeNextChain(nullptr, info->next, next_prefix, contents)) {
-                throw std::invalid_argument("Invalid Operation");
-            }
-            std::string flags_prefix = prefix;
-            flags_prefix += "createFlags";
-            contents.emplace_back("XrInstanceCreateFlags", flags_prefix, std::to_string(info->createFlags));
-            std::string applicationinfo_prefix = prefix;
-            applicationinfo_prefix += "applicationInfo";
-            if (!ApiDumpOutputXrStruct(nullptr, &info->applicationInfo, applicationinfo_prefix, "XrApplicationInfo", true,
-                                       contents)) {
-                throw std::invalid_argument("Invalid Operation");
-            }
-            std::string enabledapilayercount_prefix = prefix;
-            enabledapilayercount_prefix += "enabledApiLayerCount";
-            std::ostringstream oss_enabledApiLayerCount;
-            oss_enabledApiLayerCount << "0x" << std::hex << (info->enabledApiLayerCount);
-            contents.emplace_back("uint32_t", enabledapilayercount_prefix, oss_enabledApiLayerCount.str());
-            std::string enabledapilayernames_prefix = prefix;
-            enabledapilayernames_prefix += "enabledApiLayerNames";
-            std::ostringstream oss_enabledApiLayerNames_array;
-            oss_enabledApiLayerNames_array << "0x" << std::hex << (info->enabledApiLayerNames);
-            contents.emplace_back("const char* const*", enabledapilayernames_prefix, oss_enabledApiLayerNames_array.str());
-            for (uint32_t info_enabledapilayernames_inc = 0; info_enabledapilayernames_inc < info->enabledApiLayerCount;
-                 ++info_enabledapilayernames_inc) {
-                std::string enabledapilayernames_array_prefix = enabledapilayernames_prefix;
-                enabledapilayernames_array_prefix += "[";
-                enabledapilayernames_array_prefix += std::to_string(info_enabledapilayernames_inc);
-                enabledapilayernames_array_prefix += "]";
-                std::ostringstream oss_enabledApiLayerNames;
-                oss_enabledApiLayerNames << "0x" << std::hex << (*info->enabledApiLayerNames[info_enabledapilayernames_inc]);
-                contents.emplace_back("const char* const*", enabledapilayernames_array_prefix, oss_enabledApiLayerNames.str());
-            }
-            std::string enabledextensioncount_prefix = prefix;
-            enabledextensioncount_prefix += "enabledExtensionCount";
-            std::ostringstream oss_enabledExtensionCount;
-            oss_enabledExtensionCount << "0x" << std::hex << (info->enabledExtensionCount);
-            contents.emplace_back("uint32_t", enabledextensioncount_prefix, oss_enabledExtensionCount.str());
-            std::string enabledextensionnames_prefix = prefix;
-            enabledextensionnames_prefix += "enabledExtensionNames";
-            std::ostringstream oss_enabledExtensionNames_array;
-            oss_enabledExtensionNames_array << "0x" << std::hex << (info->enabledExtensionNames);
-            contents.emplace_back("const char* const*", enabledextensionnames_prefix, oss_enabledExtensionNames_array.str());
-            for (uint32_t info_enabledextensionnames_inc = 0; info_enabledextensionnames_inc < info->enabledExtensionCount;
-                 ++info_enabledextensionnames_inc) {
-                std::string enabledextensionnames_array_prefix = enabledextensionnames_prefix;
-                enabledextensionnames_array_prefix += "[";
-                enabledextensionnames_array_prefix += std::to_string(info_enabledextensionnames_inc);
-                enabledextensionnames_array_prefix += "]";
-                std::ostringstream oss_enabledExtensionNames;
-                oss_enabledExtensionNames << "0x" << std::hex << (*info->enabledExtensionNames[info_enabledextensionnames_inc]);
-                contents.emplace_back("const char* const*", enabledextensionnames_array_prefix, oss_enabledExtensionNames.str());
+        static ApiDumpCommandFilter create_instance_filter;
+        if (ApiDumpLayerShouldRecord("xrCreateInstance", "XR_VERSION_1_0", create_instance_filter)) {
+            // Generate output for this command as if it were the standard xrCreateInstance
+            std::vector<std::tuple<std::string, std::string, std::string>> contents;
+            contents.emplace_back("XrResult", "xrCreateInstance", "");
+            contents.emplace_back("const XrInstanceCreateInfo*", "info", PointerToHexString(info));
+            if (nullptr != info) {
+                std::string prefix = "info->";
+                contents.emplace_back("XrStructureType", "info->type", std::to_string(info->type));
+                std::string next_prefix = prefix;
+                next_prefix += "next";
+                // Decode the next chain if it exists
+                if (!ApiDumpDecodeNextChain(nullptr, info->next, next_prefix, contents)) {
+                    throw std::invalid_argument("Invalid Operation");
+                }
+                std::string flags_prefix = prefix;
+                flags_prefix += "createFlags";
+                contents.emplace_back("XrInstanceCreateFlags", flags_prefix, std::to_string(info->createFlags));
+                std::string applicationinfo_prefix = prefix;
+                applicationinfo_prefix += "applicationInfo";
+                if (!ApiDumpOutputXrStruct(nullptr, &info->applicationInfo, applicationinfo_prefix, "XrApplicationInfo", true,
+                                           contents)) {
+                    throw std::invalid_argument("Invalid Operation");
+                }
+                std::string enabledapilayercount_prefix = prefix;
+                enabledapilayercount_prefix += "enabledApiLayerCount";
+                std::ostringstream oss_enabledApiLayerCount;
+                oss_enabledApiLayerCount << "0x" << std::hex << (info->enabledApiLayerCount);
+                contents.emplace_back("uint32_t", enabledapilayercount_prefix, oss_enabledApiLayerCount.str());
+                std::string enabledapilayernames_prefix = prefix;
+                enabledapilayernames_prefix += "enabledApiLayerNames";
+                std::ostringstream oss_enabledApiLayerNames_array;
+                oss_enabledApiLayerNames_array << "0x" << std::hex << (info->enabledApiLayerNames);
+                contents.emplace_back("const char* const*", enabledapilayernames_prefix, oss_enabledApiLayerNames_array.str());
+                for (uint32_t info_enabledapilayernames_inc = 0; info_enabledapilayernames_inc < info->enabledApiLayerCount;
+                     ++info_enabledapilayernames_inc) {
+                    std::string enabledapilayernames_array_prefix = enabledapilayernames_prefix;
+                    enabledapilayernames_array_prefix += "[";
+                    enabledapilayernames_array_prefix += std::to_string(info_enabledapilayernames_inc);
+                    enabledapilayernames_array_prefix += "]";
+                    std::ostringstream oss_enabledApiLayerNames;
+                    oss_enabledApiLayerNames << "0x" << std::hex << (*info->enabledApiLayerNames[info_enabledapilayernames_inc]);
+                    contents.emplace_back("const char* const*", enabledapilayernames_array_prefix, oss_enabledApiLayerNames.str());
+                }
+                std::string enabledextensioncount_prefix = prefix;
+                enabledextensioncount_prefix += "enabledExtensionCount";
+                std::ostringstream oss_enabledExtensionCount;
+                oss_enabledExtensionCount << "0x" << std::hex << (info->enabledExtensionCount);
+                contents.emplace_back("uint32_t", enabledextensioncount_prefix, oss_enabledExtensionCount.str());
+                std::string enabledextensionnames_prefix = prefix;
+                enabledextensionnames_prefix += "enabledExtensionNames";
+                std::ostringstream oss_enabledExtensionNames_array;
+                oss_enabledExtensionNames_array << "0x" << std::hex << (info->enabledExtensionNames);
+                contents.emplace_back("const char* const*", enabledextensionnames_prefix, oss_enabledExtensionNames_array.str());
+                for (uint32_t info_enabledextensionnames_inc = 0; info_enabledextensionnames_inc < info->enabledExtensionCount;
+                     ++info_enabledextensionnames_inc) {
+                    std::string enabledextensionnames_array_prefix = enabledextensionnames_prefix;
+                    enabledextensionnames_array_prefix += "[";
+                    enabledextensionnames_array_prefix += std::to_string(info_enabledextensionnames_inc);
+                    enabledextensionnames_array_prefix += "]";
+                    std::ostringstream oss_enabledExtensionNames;
+                    oss_enabledExtensionNames << "0x" << std::hex << (*info->enabledExtensionNames[info_enabledextensionnames_inc]);
+                    contents.emplace_back("const char* const*", enabledextensionnames_array_prefix,
+                                          oss_enabledExtensionNames.str());
+                }
             }
-        }
 
-        contents.emplace_back("XrInstance*", "instance", PointerToHexString(instance));
-        ApiDumpLayerRecordContent(contents);
+            contents.emplace_back("XrInstance*", "instance", PointerToHexString(instance));
+            ApiDumpLayerRecordContent(contents);
+        }
 
         // Copy the contents of the layer info struct, but then move the next info up by
         // one slot so that the next layer gets information.
@@ -547,8 +1318,20 @@ XrResult ApiDumpLayerXrCreateApiLayerInstance(const XrInstanceCreateInfo *info,
         XrResult result = next_create_api_layer_instance(info, &new_api_layer_info, &returned_instance);
         *instance = returned_instance;
 
+        if (XR_FAILED(result)) {
+            // If this was going to be the only instance, nothing will destroy one to stop the writer thread.
+            std::unique_lock<std::mutex> mlock(g_instance_dispatch_mutex);
+            const bool no_instances = g_instance_dispatch_map.empty();
+            mlock.unlock();
+            if (no_instances) {
+                g_record_thread.Stop();
+            }
+            return result;
+        }
+
         // Create the dispatch table to the next levels
-        auto *next_dispatch = new XrGeneratedDispatchTable();
+        auto *next_dispatch = new ApiDumpInstanceDispatchTable();
+        next_dispatch->instance = returned_instance;
         GeneratedXrPopulateDispatchTable(next_dispatch, returned_instance, next_get_instance_proc_addr);
 
         std::unique_lock<std::mutex> mlock(g_instance_dispatch_mutex);
@@ -561,11 +1344,14 @@ XrResult ApiDumpLayerXrCreateApiLayerInstance(const XrInstanceCreateInfo *info,
 }
 
 XrResult ApiDumpLayerXrDestroyInstance(XrInstance instance) {
-    // Generate output for this command
-    std::vector<std::tuple<std::string, std::string, std::string>> contents;
-    contents.emplace_back("XrResult", "xrDestroyInstance", "");
-    contents.emplace_back("XrInstance", "instance", HandleToHexString(instance));
-    ApiDumpLayerRecordContent(contents);
+    static ApiDumpCommandFilter filter;
+    if (ApiDumpLayerShouldRecord("xrDestroyInstance", "XR_VERSION_1_0", filter)) {
+        // Generate output for this command
+        std::vector<std::tuple<std::string, std::string, std::string>> contents;
+        contents.emplace_back("XrResult", "xrDestroyInstance", "");
+        contents.emplace_back("XrInstance", "instance", ApiDumpHandleString<XrInstance>(instance, XR_OBJECT_TYPE_INSTANCE));
+        ApiDumpLayerRecordContent(contents);
+    }
 
     std::unique_lock<std::mutex> mlock(g_instance_dispatch_mutex);
     XrGeneratedDispatchTable *next_dispatch = nullptr;
@@ -581,10 +1367,36 @@ XrResult ApiDumpLayerXrDestroyInstance(XrInstance instance) {
 
     next_dispatch->DestroyInstance(instance);
     ApiDumpCleanUpMapsForTable(next_dispatch);
+    mlock.lock();
+    const bool last_instance = g_instance_dispatch_map.empty();
+    mlock.unlock();
+    if (last_instance) {
+        ApiDumpLayerClearObjectNames();
+    } else {
+        ApiDumpLayerRemoveObjectName(MakeHandleGeneric(instance), XR_OBJECT_TYPE_INSTANCE);
+    }
+
+    // The run's totals go out with everything else recorded, if we destroy the last instance
+    if (last_instance && g_record_info.type == RECORD_SUMMARY) {
+        ApiDumpLayerSummarizeRun();
+    }
+
+    // Everything recorded so far has to be written out before the footer, or before returning to the application.  The
+    // writer thread is stopped and joined with the last instance, rather than being left for static destruction.
+    if (last_instance) {
+        g_record_thread.Stop();
+    } else {
+        g_record_thread.Drain();
+    }
 
     // Write out the HTML footer if we destroy the last instance
-    if (g_instance_dispatch_map.empty() && g_record_info.type == RECORD_HTML_FILE) {
+    if (last_instance && g_record_info.type == RECORD_HTML_FILE) {
         ApiDumpLayerWriteHtmlFooter();
+    } else if (last_instance && g_record_info.type == RECORD_RING_FILE) {
+        ApiDumpLayerCloseRingFile();
+    } else {
+        std::unique_lock<std::mutex> record_lock(g_record_mutex);
+        ApiDumpLayerFlushRecordFile(true);
     }
     return XR_SUCCESS;
 }
@@ -616,4 +1428,23 @@ XrResult LAYER_EXPORT XRAPI_CALL xrNegotiateLoaderApiLayerInterface(const XrNego
     return XR_SUCCESS;
 }
 
+// Lists the commands this layer intercepts, so that the loader can send every other command past it.
+XrResult LAYER_EXPORT XRAPI_CALL xrEnumerateApiLayerInterceptedCommands(const char * /*apiLayerName*/,
+                                                                        uint32_t commandCapacityInput,
+                                                                        uint32_t *commandCountOutput, const char **commands) {
+    if (nullptr == commandCountOutput || (commandCapacityInput > 0 && nullptr == commands)) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const std::vector<const char *> &intercepted_commands = ApiDumpLayerInterceptedCommands();
+    *commandCountOutput = static_cast<uint32_t>(intercepted_commands.size());
+    if (0 == commandCapacityInput) {
+        return XR_SUCCESS;
+    }
+    if (commandCapacityInput < intercepted_commands.size()) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    std::copy(intercepted_commands.begin(), intercepted_commands.end(), commands);
+    return XR_SUCCESS;
+}
+
 }  // extern "C"
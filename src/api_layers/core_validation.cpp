@@ -20,6 +20,7 @@
 #include "api_layer_platform_defines.h"
 #include "extra_algorithms.h"
 #include "hex_and_handles.h"
+#include "layer_record_writer.h"
 #include "loader_interfaces.h"
 #include "platform_utils.hpp"
 #include "validation_utils.h"
@@ -29,8 +30,10 @@
 #include <openxr/openxr.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstring>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -64,125 +67,197 @@ struct CoreValidationRecordInfo {
     bool initialized;
     CoreValidationRecordType type;
     std::string file_name;
+    bool asynchronous;
 };
 
 static CoreValidationRecordInfo g_record_info = {};
 static std::mutex g_record_mutex = {};
 
+// The text or HTML file being recorded to, kept open between messages.  Guarded by g_record_mutex.
+static LayerRecordFile g_record_file;
+
+// Write out some already formatted output.  Call with g_record_mutex held.
+static void CoreValidationWriteRecord(const std::string &text) {
+    switch (g_record_info.type) {
+        case RECORD_TEXT_COUT:
+            std::cout << text << std::flush;
+            break;
+        case RECORD_TEXT_FILE:
+        case RECORD_HTML_FILE:
+            g_record_file.Get(g_record_info.file_name) << text;
+            g_record_file.Flush(false);
+            break;
+        default:
+            break;
+    }
+}
+
+// Writes out the validation messages on a thread of its own, when XR_CORE_VALIDATION_ASYNC is set, so that the
+// application's threads only have to queue up each formatted message instead of waiting on each other and on the output.
+static void CoreValidationWriteBatch(const std::deque<std::string> &batch) {
+    std::unique_lock<std::mutex> mlock(g_record_mutex);
+    for (const auto &text : batch) {
+        CoreValidationWriteRecord(text);
+    }
+}
+
+static LayerRecordThread<std::string> g_record_thread(CoreValidationWriteBatch);
+
+// Record some formatted output, on the writer thread if there is one.
+static void CoreValidationRecord(std::string &&text) {
+    if (g_record_info.asynchronous && g_record_thread.Enqueue(std::move(text))) {
+        return;
+    }
+    std::unique_lock<std::mutex> mlock(g_record_mutex);
+    CoreValidationWriteRecord(text);
+}
+
+CoreValidationLevel g_core_validation_level = CORE_VALIDATION_LEVEL_FULL;
+std::atomic<uint64_t> g_handle_removal_epoch(0);
+std::atomic<bool> g_core_validation_counters_enabled(false);
+CoreValidationCheckCounter g_core_validation_check_counters[CORE_VALIDATION_CHECK_COUNT] = {};
+
+static void CoreValidationResetCheckCounters() {
+    for (auto &counter : g_core_validation_check_counters) {
+        counter.count.store(0, std::memory_order_relaxed);
+        counter.nanoseconds.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Write out the checks counted since the first instance was created, once the last one has been destroyed.
+static void CoreValidationWriteCheckCounters() {
+    static const char *const check_names[CORE_VALIDATION_CHECK_COUNT] = {"handle", "parent", "enum", "next chain"};
+    std::ostringstream oss;
+    oss << "Core Validation check counters:\n";
+    for (uint32_t check = 0; check < CORE_VALIDATION_CHECK_COUNT; ++check) {
+        uint64_t count = g_core_validation_check_counters[check].count.load(std::memory_order_relaxed);
+        uint64_t nanoseconds = g_core_validation_check_counters[check].nanoseconds.load(std::memory_order_relaxed);
+        oss << "    " << check_names[check] << ": " << count << " checks, " << nanoseconds << " ns";
+        if (count > 0) {
+            oss << " (" << nanoseconds / count << " ns each)";
+        }
+        oss << "\n";
+    }
+    std::cerr << oss.str() << std::flush;
+}
+
 // HTML utilities
 bool CoreValidationWriteHtmlHeader() {
     try {
-        std::unique_lock<std::mutex> mlock(g_record_mutex);
-        std::ofstream html_file;
-        html_file.open(g_record_info.file_name, std::ios::out);
-        html_file
-            << "<!doctype html>\n"
-               "<html>\n"
-               "    <head>\n"
-               "        <title>OpenXR Core Validation</title>\n"
-               "        <style type='text/css'>\n"
-               "        html {\n"
-               "            background-color: #0b1e48;\n"
-               "            background-image: url('https://vulkan.lunarg.com/img/bg-starfield.jpg');\n"
-               "            background-position: center;\n"
-               "            -webkit-background-size: cover;\n"
-               "            -moz-background-size: cover;\n"
-               "            -o-background-size: cover;\n"
-               "            background-size: cover;\n"
-               "            background-attachment: fixed;\n"
-               "            background-repeat: no-repeat;\n"
-               "            height: 100%;\n"
-               "        }\n"
-               "        #header {\n"
-               "            z-index: -1;\n"
-               "        }\n"
-               "        #header>img {\n"
-               "            position: absolute;\n"
-               "            width: 160px;\n"
-               "            margin-left: -280px;\n"
-               "            top: -10px;\n"
-               "            left: 50%;\n"
-               "        }\n"
-               "        #header>h1 {\n"
-               "            font-family: Arial, 'Helvetica Neue', Helvetica, sans-serif;\n"
-               "            font-size: 48px;\n"
-               "            font-weight: 200;\n"
-               "            text-shadow: 4px 4px 5px #000;\n"
-               "            color: #eee;\n"
-               "            position: absolute;\n"
-               "            width: 600px;\n"
-               "            margin-left: -80px;\n"
-               "            top: 8px;\n"
-               "            left: 50%;\n"
-               "        }\n"
-               "        body {\n"
-               "            font-family: Consolas, monaco, monospace;\n"
-               "            font-size: 14px;\n"
-               "            line-height: 20px;\n"
-               "            color: #eee;\n"
-               "            height: 100%;\n"
-               "            margin: 0;\n"
-               "            overflow: hidden;\n"
-               "        }\n"
-               "        #wrapper {\n"
-               "            background-color: rgba(0, 0, 0, 0.7);\n"
-               "            border: 1px solid #446;\n"
-               "            box-shadow: 0px 0px 10px #000;\n"
-               "            padding: 8px 12px;\n"
-               "            display: inline-block;\n"
-               "            position: absolute;\n"
-               "            top: 80px;\n"
-               "            bottom: 25px;\n"
-               "            left: 50px;\n"
-               "            right: 50px;\n"
-               "            overflow: auto;\n"
-               "        }\n"
-               "        details>*:not(summary) {\n"
-               "            margin-left: 22px;\n"
-               "        }\n"
-               "        summary:only-child {\n"
-               "            display: block;\n"
-               "            padding-left: 15px;\n"
-               "        }\n"
-               "        details>summary:only-child::-webkit-details-marker {\n"
-               "            display: none;\n"
-               "            padding-left: 15px;\n"
-               "        }\n"
-               "        .headervar, .generalheadertype, .warningheadertype, .errorheadertype, .debugheadertype, .headerval {\n"
-               "            display: inline;\n"
-               "            margin: 0 9px;\n"
-               "        }\n"
-               "        .var, .type, .val {\n"
-               "            display: inline;\n"
-               "            margin: 0 6px;\n"
-               "        }\n"
-               "        .warningheadertype, .type {\n"
-               "            color: #dce22f;\n"
-               "        }\n"
-               "        .errorheadertype, .type {\n"
-               "            color: #ff1616;\n"
-               "        }\n"
-               "        .debugheadertype, .type {\n"
-               "            color: #888;\n"
-               "        }\n"
-               "        .generalheadertype, .type {\n"
-               "            color: #acf;\n"
-               "        }\n"
-               "        .headerval, .val {\n"
-               "            color: #afa;\n"
-               "            text-align: right;\n"
-               "        }\n"
-               "        .thd {\n"
-               "            color: #888;\n"
-               "        }\n"
-               "        </style>\n"
-               "    </head>\n"
-               "    <body>\n"
-               "        <div id='header'>\n"
-               "            <img src='https://lunarg.com/wp-content/uploads/2016/02/LunarG-wReg-150.png' />\n"
-               "            <h1>OpenXR Core Validation</h1>\n"
-               "        </div>\n"
-               "        <div id='wrapper'>\n";
+        {
+            // The header starts the file over
+            std::unique_lock<std::mutex> mlock(g_record_mutex);
+            g_record_file.Close();
+            g_record_file.Get(g_record_info.file_name, std::ios::out | std::ios::trunc);
+        }
+        CoreValidationRecord(
+            "<!doctype html>\n"
+            "<html>\n"
+            "    <head>\n"
+            "        <title>OpenXR Core Validation</title>\n"
+            "        <style type='text/css'>\n"
+            "        html {\n"
+            "            background-color: #0b1e48;\n"
+            "            background-image: url('https://vulkan.lunarg.com/img/bg-starfield.jpg');\n"
+            "            background-position: center;\n"
+            "            -webkit-background-size: cover;\n"
+            "            -moz-background-size: cover;\n"
+            "            -o-background-size: cover;\n"
+            "            background-size: cover;\n"
+            "            background-attachment: fixed;\n"
+            "            background-repeat: no-repeat;\n"
+            "            height: 100%;\n"
+            "        }\n"
+            "        #header {\n"
+            "            z-index: -1;\n"
+            "        }\n"
+            "        #header>img {\n"
+            "            position: absolute;\n"
+            "            width: 160px;\n"
+            "            margin-left: -280px;\n"
+            "            top: -10px;\n"
+            "            left: 50%;\n"
+            "        }\n"
+            "        #header>h1 {\n"
+            "            font-family: Arial, 'Helvetica Neue', Helvetica, sans-serif;\n"
+            "            font-size: 48px;\n"
+            "            font-weight: 200;\n"
+            "            text-shadow: 4px 4px 5px #000;\n"
+            "            color: #eee;\n"
+            "            position: absolute;\n"
+            "            width: 600px;\n"
+            "            margin-left: -80px;\n"
+            "            top: 8px;\n"
+            "            left: 50%;\n"
+            "        }\n"
+            "        body {\n"
+            "            font-family: Consolas, monaco, monospace;\n"
+            "            font-size: 14px;\n"
+            "            line-height: 20px;\n"
+            "            color: #eee;\n"
+            "            height: 100%;\n"
+            "            margin: 0;\n"
+            "            overflow: hidden;\n"
+            "        }\n"
+            "        #wrapper {\n"
+            "            background-color: rgba(0, 0, 0, 0.7);\n"
+            "            border: 1px solid #446;\n"
+            "            box-shadow: 0px 0px 10px #000;\n"
+            "            padding: 8px 12px;\n"
+            "            display: inline-block;\n"
+            "            position: absolute;\n"
+            "            top: 80px;\n"
+            "            bottom: 25px;\n"
+            "            left: 50px;\n"
+            "            right: 50px;\n"
+            "            overflow: auto;\n"
+            "        }\n"
+            "        details>*:not(summary) {\n"
+            "            margin-left: 22px;\n"
+            "        }\n"
+            "        summary:only-child {\n"
+            "            display: block;\n"
+            "            padding-left: 15px;\n"
+            "        }\n"
+            "        details>summary:only-child::-webkit-details-marker {\n"
+            "            display: none;\n"
+            "            padding-left: 15px;\n"
+            "        }\n"
+            "        .headervar, .generalheadertype, .warningheadertype, .errorheadertype, .debugheadertype, .headerval {\n"
+            "            display: inline;\n"
+            "            margin: 0 9px;\n"
+            "        }\n"
+            "        .var, .type, .val {\n"
+            "            display: inline;\n"
+            "            margin: 0 6px;\n"
+            "        }\n"
+            "        .warningheadertype, .type {\n"
+            "            color: #dce22f;\n"
+            "        }\n"
+            "        .errorheadertype, .type {\n"
+            "            color: #ff1616;\n"
+            "        }\n"
+            "        .debugheadertype, .type {\n"
+            "            color: #888;\n"
+            "        }\n"
+            "        .generalheadertype, .type {\n"
+            "            color: #acf;\n"
+            "        }\n"
+            "        .headerval, .val {\n"
+            "            color: #afa;\n"
+            "            text-align: right;\n"
+            "        }\n"
+            "        .thd {\n"
+            "            color: #888;\n"
+            "        }\n"
+            "        </style>\n"
+            "    </head>\n"
+            "    <body>\n"
+            "        <div id='header'>\n"
+            "            <img src='https://lunarg.com/wp-content/uploads/2016/02/LunarG-wReg-150.png' />\n"
+            "            <h1>OpenXR Core Validation</h1>\n"
+            "        </div>\n"
+            "        <div id='wrapper'>\n");
         return true;
     } catch (...) {
         return false;
@@ -191,12 +266,15 @@ bool CoreValidationWriteHtmlHeader() {
 
 bool CoreValidationWriteHtmlFooter() {
     try {
+        CoreValidationRecord(
+            "        </div>\n"
+            "    </body>\n"
+            "</html>");
+
+        // Everything queued up has to be written out before the file is closed
+        g_record_thread.Stop();
         std::unique_lock<std::mutex> mlock(g_record_mutex);
-        std::ofstream html_file;
-        html_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-        html_file << "        </div>\n"
-                     "    </body>\n"
-                     "</html>";
+        g_record_file.Close();
 
         // Writing the footer means we're done.
         if (g_record_info.initialized) {
@@ -241,11 +319,14 @@ void CoreValidLogMessage(GenValidUsageXrInstanceInfo *instance_info, const std::
                 severity_string = "VALID_UNKNOWN";
                 break;
         }
+        // Held from when the names and labels are looked up until they are no longer used.
+        std::unique_lock<std::mutex> debug_data_lock;
         NamesAndLabels names_and_labels;
         // If we have instance information, see if we need to log this information out to a debug messenger
         // callback.
-        if (nullptr != instance_info) {
-            if (!instance_info->debug_data.Empty() && !instance_info->debug_messengers.empty()) {
+        if (nullptr != instance_info && !instance_info->debug_messengers.empty()) {
+            debug_data_lock = std::unique_lock<std::mutex>(instance_info->debug_data_mutex);
+            if (!instance_info->debug_data.Empty()) {
                 std::vector<XrSdkLogObjectInfo> objects;
                 objects.reserve(objects_info.size());
                 std::transform(objects_info.begin(), objects_info.end(), std::back_inserter(objects),
@@ -277,61 +358,34 @@ void CoreValidLogMessage(GenValidUsageXrInstanceInfo *instance_info, const std::
             }
         }
 
+        // The messengers have been called, so the output can be formatted without holding the lock
+        mlock.unlock();
+
+        std::ostringstream oss;
         switch (g_record_info.type) {
-            case RECORD_TEXT_COUT: {
-                std::cout << "[" << severity_string << " | " << message_id << " | " << command_name << "]: " << message
-                          << std::endl;
-                if (!objects_info.empty()) {
-                    std::cout << "  Objects:" << std::endl;
-                    uint32_t count = 0;
-                    for (const auto &object_info : objects_info) {
-                        std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
-                        std::ostringstream oss_object_handle;
-                        std::cout << "   [" << std::to_string(count++) << "] - " << object_type << " ("
-                                  << Uint64ToHexString(object_info.handle) << ")";
-                        std::cout << std::endl;
-                    }
-                }
-                if (!names_and_labels.labels.empty()) {
-                    std::cout << "  Session Labels:" << std::endl;
-                    uint32_t count = 0;
-                    for (const auto &session_label : names_and_labels.labels) {
-                        std::cout << "   [" << std::to_string(count++) << "] - " << session_label.labelName << std::endl;
-                    }
-                }
-                std::cout << std::flush;
-                break;
-            }
+            case RECORD_TEXT_COUT:
             case RECORD_TEXT_FILE: {
-                std::ofstream text_file;
-                text_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-                text_file << "[" << severity_string << " | " << message_id << " | " << command_name << "]: " << message
-                          << std::endl;
+                oss << "[" << severity_string << " | " << message_id << " | " << command_name << "]: " << message << "\n";
                 if (!objects_info.empty()) {
-                    text_file << "  Objects:" << std::endl;
+                    oss << "  Objects:\n";
                     uint32_t count = 0;
                     for (const auto &object_info : objects_info) {
                         std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
-                        text_file << "   [" << std::to_string(count++) << "] - " << object_type << " ("
-                                  << Uint64ToHexString(object_info.handle) << ")";
-                        text_file << std::endl;
+                        oss << "   [" << std::to_string(count++) << "] - " << object_type << " ("
+                            << Uint64ToHexString(object_info.handle) << ")\n";
                     }
                 }
                 if (!names_and_labels.labels.empty()) {
-                    text_file << "  Session Labels:" << std::endl;
+                    oss << "  Session Labels:\n";
                     uint32_t count = 0;
                     for (const auto &session_label : names_and_labels.labels) {
-                        text_file << "   [" << std::to_string(count++) << "] - " << session_label.labelName << std::endl;
+                        oss << "   [" << std::to_string(count++) << "] - " << session_label.labelName << "\n";
                     }
                 }
-                text_file << std::flush;
-                text_file.close();
                 break;
             }
             case RECORD_HTML_FILE: {
-                std::ofstream text_file;
-                text_file.open(g_record_info.file_name, std::ios::out | std::ios::app);
-                text_file << "<details class='data'>\n";
+                oss << "<details class='data'>\n";
                 std::string header_type = "generalheadertype";
                 switch (message_severity) {
                     case VALID_USAGE_DEBUG_SEVERITY_DEBUG:
@@ -353,51 +407,51 @@ void CoreValidLogMessage(GenValidUsageXrInstanceInfo *instance_info, const std::
                         severity_string = "Unknown Message";
                         break;
                 }
-                text_file << "   <summary>\n"
-                          << "      <div class='" << header_type << "'>" << severity_string << "</div>\n"
-                          << "      <div class='headerval'>" << command_name << "</div>\n"
-                          << "      <div class='headervar'>" << message_id << "</div>\n"
-                          << "   </summary>\n";
-                text_file << "   <div class='data'>\n";
-                text_file << "      <div class='val'>" << message << "</div>\n";
+                oss << "   <summary>\n"
+                    << "      <div class='" << header_type << "'>" << severity_string << "</div>\n"
+                    << "      <div class='headerval'>" << command_name << "</div>\n"
+                    << "      <div class='headervar'>" << message_id << "</div>\n"
+                    << "   </summary>\n";
+                oss << "   <div class='data'>\n";
+                oss << "      <div class='val'>" << message << "</div>\n";
                 if (!objects_info.empty()) {
-                    text_file << "      <details class='data'>\n";
-                    text_file << "         <summary>\n";
-                    text_file << "            <div class='type'>Relevant OpenXR Objects</div>\n";
-                    text_file << "         </summary>\n";
+                    oss << "      <details class='data'>\n";
+                    oss << "         <summary>\n";
+                    oss << "            <div class='type'>Relevant OpenXR Objects</div>\n";
+                    oss << "         </summary>\n";
                     uint32_t count = 0;
                     for (const auto &object_info : objects_info) {
                         std::string object_type = GenValidUsageXrObjectTypeToString(object_info.type);
-                        text_file << "         <div class='data'>\n";
-                        text_file << "             <div class='var'>[" << count++ << "]</div>\n";
-                        text_file << "             <div class='type'>" << object_type << "</div>\n";
-                        text_file << "             <div class='val'>" << Uint64ToHexString(object_info.handle) << "</div>\n";
-                        text_file << "         </div>\n";
+                        oss << "         <div class='data'>\n";
+                        oss << "             <div class='var'>[" << count++ << "]</div>\n";
+                        oss << "             <div class='type'>" << object_type << "</div>\n";
+                        oss << "             <div class='val'>" << Uint64ToHexString(object_info.handle) << "</div>\n";
+                        oss << "         </div>\n";
                     }
-                    text_file << "      </details>\n";
-                    text_file << std::flush;
+                    oss << "      </details>\n";
                 }
                 if (!names_and_labels.labels.empty()) {
-                    text_file << "      <details class='data'>\n";
-                    text_file << "         <summary>\n";
-                    text_file << "            <div class='type'>Relevant Session Labels</div>\n";
-                    text_file << "         </summary>\n";
+                    oss << "      <details class='data'>\n";
+                    oss << "         <summary>\n";
+                    oss << "            <div class='type'>Relevant Session Labels</div>\n";
+                    oss << "         </summary>\n";
                     uint32_t count = 0;
                     for (const auto &session_label : names_and_labels.labels) {
-                        text_file << "         <div class='data'>\n";
-                        text_file << "             <div class='var'>[" << count++ << "]</div>\n";
-                        text_file << "             <div class='type'>" << session_label.labelName << "</div>\n";
-                        text_file << "         </div>\n";
+                        oss << "         <div class='data'>\n";
+                        oss << "             <div class='var'>[" << count++ << "]</div>\n";
+                        oss << "             <div class='type'>" << session_label.labelName << "</div>\n";
+                        oss << "         </div>\n";
                     }
-                    text_file << "      </details>\n";
+                    oss << "      </details>\n";
                 }
-                text_file << "   </div>\n";
-                text_file << "</details>\n";
+                oss << "   </div>\n";
+                oss << "</details>\n";
                 break;
             }
             default:
-                break;
+                return;
         }
+        CoreValidationRecord(oss.str());
     }
 }
 
@@ -493,6 +547,40 @@ XrResult CoreValidationXrCreateApiLayerInstance(const XrInstanceCreateInfo *info
             }
         }
 
+        char *asynchronous = PlatformUtilsGetEnv("XR_CORE_VALIDATION_ASYNC");
+        if (nullptr != asynchronous) {
+            g_record_info.asynchronous = (0 != strcmp(asynchronous, "0"));
+            PlatformUtilsFreeEnv(asynchronous);
+        }
+        if (g_record_info.asynchronous) {
+            g_record_thread.Start();
+        }
+
+        char *level = PlatformUtilsGetEnv("XR_CORE_VALIDATION_LEVEL");
+        if (nullptr != level) {
+            std::string string_level = level;
+            PlatformUtilsFreeEnv(level);
+            std::transform(string_level.begin(), string_level.end(), string_level.begin(),
+                           [](unsigned char c) { return std::tolower(c); });
+
+            if (string_level == "lifetime") {
+                g_core_validation_level = CORE_VALIDATION_LEVEL_LIFETIME;
+            } else if (string_level == "handles") {
+                g_core_validation_level = CORE_VALIDATION_LEVEL_HANDLES;
+            } else {
+                g_core_validation_level = CORE_VALIDATION_LEVEL_FULL;
+            }
+        }
+
+        char *counters = PlatformUtilsGetEnv("XR_CORE_VALIDATION_COUNTERS");
+        if (nullptr != counters) {
+            g_core_validation_counters_enabled.store(0 != strcmp(counters, "0"), std::memory_order_relaxed);
+            PlatformUtilsFreeEnv(counters);
+        }
+        if (g_instance_info.empty()) {
+            CoreValidationResetCheckCounters();
+        }
+
         // Call the generated pre valid usage check.
         validation_result = GenValidUsageInputsXrCreateInstance(info, instance);
 
@@ -511,15 +599,14 @@ XrResult CoreValidationXrCreateApiLayerInstance(const XrInstanceCreateInfo *info
         *instance = returned_instance;
 
         // Create the instance information
-        std::unique_ptr<GenValidUsageXrInstanceInfo> instance_info(
-            new GenValidUsageXrInstanceInfo(returned_instance, next_get_instance_proc_addr));
+        GenValidUsageXrInstanceInfo *instance_info =
+            g_instance_info.emplace(returned_instance, returned_instance, next_get_instance_proc_addr);
 
-        // Save the enabled extensions.
+        // Save the enabled extensions.  Nothing else can look the instance up until it is returned to the application.
         for (uint32_t extension = 0; extension < info->enabledExtensionCount; ++extension) {
             instance_info->enabled_extensions.emplace_back(info->enabledExtensionNames[extension]);
         }
-
-        g_instance_info.insert(returned_instance, std::move(instance_info));
+        GenValidUsageSetEnabledExtensionBits(instance_info);
 
         // See if a debug utils messenger is supposed to be created as part of the instance
         // NOTE: We have to wait until after the instance info is added to the map for this
@@ -555,11 +642,12 @@ XrResult CoreValidationXrCreateApiLayerInstance(const XrInstanceCreateInfo *info
 }
 
 void EraseAllInstanceTableMapElements(GenValidUsageXrInstanceInfo *search_value) {
-    typedef typename InstanceHandleInfo::value_t value_t;
-    auto map_with_lock = g_instance_info.lockMap();
-    auto &map = map_with_lock.second;
+    g_instance_info.eraseIf([=](GenValidUsageXrInstanceInfo const &info) { return &info == search_value; });
+}
 
-    map_erase_if(map, [=](value_t const &data) { return data.second.get() == search_value; });
+void CoreValidationDeleteSessionLabels(GenValidUsageXrInstanceInfo *instance_info, XrSession session) {
+    std::unique_lock<std::mutex> lock(instance_info->debug_data_mutex);
+    instance_info->debug_data.DeleteSessionLabels(session);
 }
 
 XrResult CoreValidationXrDestroyInstance(XrInstance instance) {
@@ -572,8 +660,21 @@ XrResult CoreValidationXrDestroyInstance(XrInstance instance) {
         }
     }
     XrResult result = GenValidUsageNextXrDestroyInstance(instance);
-    if (!g_instance_info.empty() && g_record_info.type == RECORD_HTML_FILE) {
+    if (g_instance_info.empty() && g_core_validation_counters_enabled.load(std::memory_order_relaxed)) {
+        CoreValidationWriteCheckCounters();
+    }
+    if (g_instance_info.empty() && g_record_info.type == RECORD_HTML_FILE) {
         CoreValidationWriteHtmlFooter();
+    } else {
+        // Everything recorded so far has to be written out before returning to the application.  The writer thread is
+        // stopped and joined with the last instance, rather than being left for static destruction.
+        if (g_instance_info.empty()) {
+            g_record_thread.Stop();
+        } else {
+            g_record_thread.Drain();
+        }
+        std::unique_lock<std::mutex> mlock(g_record_mutex);
+        g_record_file.Flush(true);
     }
     return result;
 }
@@ -628,9 +729,12 @@ XrResult CoreValidationXrCreateSession(XrInstance instance, const XrSessionCreat
             cur_ptr = reinterpret_cast<const XrBaseInStructure *>(cur_ptr->next);
         }
         auto const &enabled_extensions = gen_instance_info->enabled_extensions;
-#ifdef XR_KHR_headless
+#if defined(XR_KHR_headless)
         bool has_headless = (enabled_extensions.end() !=
                              std::find(enabled_extensions.begin(), enabled_extensions.end(), XR_KHR_HEADLESS_EXTENSION_NAME));
+#elif defined(XR_MND_headless)
+        bool has_headless = (enabled_extensions.end() !=
+                             std::find(enabled_extensions.begin(), enabled_extensions.end(), XR_MND_HEADLESS_EXTENSION_NAME));
 #else
         bool has_headless = false;
 #endif  // XR_KHR_headless
@@ -675,9 +779,9 @@ XrResult CoreValidationXrSetDebugUtilsObjectNameEXT(XrInstance instance, const X
         if (!XR_UNQUALIFIED_SUCCESS(result)) {
             return result;
         }
-        auto info_with_lock = g_instance_info.getWithLock(instance);
-        GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second;
-        if (nullptr != gen_instance_info) {
+        GenValidUsageXrInstanceInfo *gen_instance_info = g_instance_info.get(instance);
+        {
+            std::unique_lock<std::mutex> lock(gen_instance_info->debug_data_mutex);
             gen_instance_info->debug_data.AddObjectName(nameInfo->objectHandle, nameInfo->objectType, nameInfo->objectName);
         }
         return result;
@@ -746,12 +850,12 @@ XrResult CoreValidationXrSessionBeginDebugUtilsLabelRegionEXT(XrSession session,
     if (XR_SUCCESS != test_result) {
         return test_result;
     }
-    auto info_with_lock = g_session_info.getWithLock(session);
-    if (info_with_lock.second != nullptr) {
-        GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second->instance_info;
-        if (nullptr != gen_instance_info) {
-            gen_instance_info->debug_data.BeginLabelRegion(session, *labelInfo);
-        }
+    try {
+        GenValidUsageXrInstanceInfo *gen_instance_info = g_session_info.getWithInstanceInfo(session).second;
+        std::unique_lock<std::mutex> lock(gen_instance_info->debug_data_mutex);
+        gen_instance_info->debug_data.BeginLabelRegion(session, *labelInfo);
+    } catch (...) {
+        return XR_ERROR_VALIDATION_FAILURE;
     }
     return GenValidUsageNextXrSessionBeginDebugUtilsLabelRegionEXT(session, labelInfo);
 }
@@ -761,12 +865,12 @@ XrResult CoreValidationXrSessionEndDebugUtilsLabelRegionEXT(XrSession session) {
     if (XR_SUCCESS != test_result) {
         return test_result;
     }
-    auto info_with_lock = g_session_info.getWithLock(session);
-    if (info_with_lock.second != nullptr) {
-        GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second->instance_info;
-        if (nullptr != gen_instance_info) {
-            gen_instance_info->debug_data.EndLabelRegion(session);
-        }
+    try {
+        GenValidUsageXrInstanceInfo *gen_instance_info = g_session_info.getWithInstanceInfo(session).second;
+        std::unique_lock<std::mutex> lock(gen_instance_info->debug_data_mutex);
+        gen_instance_info->debug_data.EndLabelRegion(session);
+    } catch (...) {
+        return XR_ERROR_VALIDATION_FAILURE;
     }
     return GenValidUsageNextXrSessionEndDebugUtilsLabelRegionEXT(session);
 }
@@ -776,12 +880,12 @@ XrResult CoreValidationXrSessionInsertDebugUtilsLabelEXT(XrSession session, cons
     if (XR_SUCCESS != test_result) {
         return test_result;
     }
-    auto info_with_lock = g_session_info.getWithLock(session);
-    if (info_with_lock.second != nullptr) {
-        GenValidUsageXrInstanceInfo *gen_instance_info = info_with_lock.second->instance_info;
-        if (nullptr != gen_instance_info) {
-            gen_instance_info->debug_data.InsertLabel(session, *labelInfo);
-        }
+    try {
+        GenValidUsageXrInstanceInfo *gen_instance_info = g_session_info.getWithInstanceInfo(session).second;
+        std::unique_lock<std::mutex> lock(gen_instance_info->debug_data_mutex);
+        gen_instance_info->debug_data.InsertLabel(session, *labelInfo);
+    } catch (...) {
+        return XR_ERROR_VALIDATION_FAILURE;
     }
     return GenValidUsageNextXrSessionInsertDebugUtilsLabelEXT(session, labelInfo);
 }
@@ -817,4 +921,22 @@ LAYER_EXPORT XrResult xrNegotiateLoaderApiLayerInterface(const XrNegotiateLoader
     return XR_SUCCESS;
 }
 
+// Lists the commands this layer intercepts, so that the loader can send every other command past it.
+LAYER_EXPORT XrResult xrEnumerateApiLayerInterceptedCommands(const char * /*apiLayerName*/, uint32_t commandCapacityInput,
+                                                             uint32_t *commandCountOutput, const char **commands) {
+    if (nullptr == commandCountOutput || (commandCapacityInput > 0 && nullptr == commands)) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const std::vector<const char *> &intercepted_commands = GenValidUsageInterceptedCommands();
+    *commandCountOutput = static_cast<uint32_t>(intercepted_commands.size());
+    if (0 == commandCapacityInput) {
+        return XR_SUCCESS;
+    }
+    if (commandCapacityInput < intercepted_commands.size()) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    std::copy(intercepted_commands.begin(), intercepted_commands.end(), commands);
+    return XR_SUCCESS;
+}
+
 }  // extern "C"
@@ -0,0 +1,191 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Output helpers shared by the API layers that record what they see to standard output or a file.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// LayerRecordFile class -
+// The file an API layer records to.  It is opened the first time it is written to and then kept open with a large
+// buffer, since opening and closing it for every record made the layers far too slow for commands called every frame.
+// What has been written goes out to the file when the buffer fills, when Flush is called at least a second after the
+// last flush (the layers call it after every record, so output can wait in the buffer until the next one), and whenever
+// the layer forces a flush.  Not thread safe: callers guard it with their own record mutex.
+class LayerRecordFile {
+   public:
+    // Get the file, opening it with the given mode if it is not open yet.
+    std::ofstream &Get(const std::string &file_name, std::ios::openmode mode = std::ios::out | std::ios::app) {
+        if (!_file.is_open()) {
+            // The buffer has to be in place before the file is opened for the stream to use it
+            if (!_buffer) {
+                _buffer.reset(new char[kBufferSize]);
+            }
+            _file.rdbuf()->pubsetbuf(_buffer.get(), kBufferSize);
+            _file.open(file_name, mode);
+            _last_flush = std::chrono::steady_clock::now();
+        }
+        return _file;
+    }
+
+    // Write out what the file is holding, if it has been a while, or always when forced.
+    void Flush(bool force) {
+        if (!_file.is_open()) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (force || now - _last_flush >= std::chrono::milliseconds(kFlushIntervalMs)) {
+            _file.flush();
+            _last_flush = now;
+        }
+    }
+
+    void Close() {
+        if (_file.is_open()) {
+            _file.close();
+        }
+    }
+
+   private:
+    enum : size_t { kBufferSize = 1024 * 1024 };
+    enum : int { kFlushIntervalMs = 1000 };
+
+    std::ofstream _file;
+    std::unique_ptr<char[]> _buffer;
+    std::chrono::steady_clock::time_point _last_flush;
+};
+
+// LayerRecordThread class -
+// Writes out an API layer's records on a thread of its own, so that the application's threads only have to queue
+// up each record instead of waiting on each other and on the output.  Records are whatever the layer gathers on the
+// calling thread, and are handed to write_batch on the writer thread, in the order they were queued.  If the writer
+// falls too far behind, callers wait for it to catch up rather than letting the queue grow without bound.
+//
+// The layer stops the thread with Stop when its last instance is destroyed.  One still running when the object itself
+// is destroyed, during static destruction, is abandoned rather than joined: joining a thread there can deadlock, and
+// write_batch may use objects that are already gone.  What it shares with the thread is kept alive until it exits.
+template <typename Record>
+class LayerRecordThread {
+   public:
+    typedef void (*WriteBatchFunction)(const std::deque<Record> &batch);
+
+    explicit LayerRecordThread(WriteBatchFunction write_batch) : _state(std::make_shared<State>(write_batch)) {}
+    ~LayerRecordThread() {
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        if (_thread.joinable()) {
+            _state->abandoned = true;
+            _state->work_available.notify_one();
+            _thread.detach();
+        }
+    }
+
+    // Start the writer thread, if it is not running already.
+    void Start() {
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        if (!_thread.joinable()) {
+            _state->stopping = false;
+            _thread = std::thread(&LayerRecordThread::Run, _state);
+        }
+    }
+
+    // Queue up one record to be written.  Returns false if the writer thread is not running, in which case the caller
+    // should write the record itself.
+    bool Enqueue(Record &&record) {
+        State &state = *_state;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        if (!_thread.joinable() || state.stopping) {
+            return false;
+        }
+        state.space_available.wait(lock, [&state] { return state.pending.size() < kMaxPending; });
+        state.pending.push_back(std::move(record));
+        state.work_available.notify_one();
+        return true;
+    }
+
+    // Wait until everything queued so far has been written.
+    void Drain() {
+        State &state = *_state;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        if (_thread.joinable()) {
+            state.idle.wait(lock, [&state] { return state.pending.empty() && !state.writing; });
+        }
+    }
+
+    // Write out everything still queued, then stop the writer thread and join it.
+    void Stop() {
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        if (!_thread.joinable()) {
+            return;
+        }
+        _state->stopping = true;
+        _state->work_available.notify_one();
+        lock.unlock();
+        _thread.join();
+    }
+
+   private:
+    enum : size_t { kMaxPending = 16384 };
+
+    struct State {
+        explicit State(WriteBatchFunction write_batch_function) : write_batch(write_batch_function) {}
+
+        WriteBatchFunction write_batch;
+        std::mutex mutex;
+        std::condition_variable work_available;
+        std::condition_variable space_available;
+        std::condition_variable idle;
+        std::deque<Record> pending;
+        bool writing = false;
+        bool stopping = false;
+        // Set when the LayerRecordThread went away with the thread still running: exit without writing anything more.
+        bool abandoned = false;
+    };
+
+    static void Run(std::shared_ptr<State> state) {
+        std::deque<Record> batch;
+        std::unique_lock<std::mutex> lock(state->mutex);
+        while (true) {
+            state->work_available.wait(lock, [&state] { return !state->pending.empty() || state->stopping || state->abandoned; });
+            if (state->abandoned || state->pending.empty()) {
+                break;
+            }
+            batch.swap(state->pending);
+            state->writing = true;
+            state->space_available.notify_all();
+            lock.unlock();
+            state->write_batch(batch);
+            batch.clear();
+            lock.lock();
+            state->writing = false;
+            if (state->pending.empty()) {
+                state->idle.notify_all();
+            }
+        }
+    }
+
+    std::shared_ptr<State> _state;
+    std::thread _thread;
+};
@@ -30,11 +30,20 @@
 #include <openxr/openxr.h>
 #include <openxr/openxr_platform.h>
 
+#include <algorithm>
+#include <cassert>
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
 #include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 /// Prints a message to stderr then throws an exception.
 ///
@@ -79,8 +88,14 @@ struct GenValidUsageXrInstanceInfo {
     const XrInstance instance;
     XrGeneratedDispatchTable *dispatch_table;
     std::vector<std::string> enabled_extensions;
+    // Which of the extensions validation checks are enabled, indexed by GenValidUsageExtension.
+    std::vector<bool> enabled_extension_bits;
     std::vector<UniqueCoreValidationMessengerInfo> debug_messengers;
+    // Object names and session labels.  Guarded by debug_data_mutex rather than by the handle info maps, so that
+    // labelling a session every frame does not hold up the handle lookups of every other thread.  Messages reported to
+    // messengers hold it while the callbacks run, since the labels passed to them are referred to in place.
     DebugUtilsData debug_data;
+    std::mutex debug_data_mutex;
 };
 
 // Structure used for storing information for other handles
@@ -90,13 +105,6 @@ struct GenValidUsageXrHandleInfo {
     uint64_t direct_parent_handle;
 };
 
-// Structure used for storing session label information
-struct GenValidUsageXrInternalSessionLabel {
-    XrDebugUtilsLabelEXT debug_utils_label;
-    std::string label_name;
-    bool is_individual_label;
-};
-
 // Enum used for indicating handle validation status.
 enum ValidateXrHandleResult {
     VALIDATE_XR_HANDLE_NULL,
@@ -104,11 +112,37 @@ enum ValidateXrHandleResult {
     VALIDATE_XR_HANDLE_SUCCESS,
 };
 
-// Unordered Map associating pointer to a vector of session label information to a session's handle
-extern std::unordered_map<XrSession, std::vector<GenValidUsageXrInternalSessionLabel *> *> g_xr_session_labels;
+// One valid value of an enum, and the extension (a GenValidUsageExtension) it requires.
+struct GenValidUsageEnumValue {
+    int32_t value;
+    uint32_t extension;
+    const char *name;
+};
 
-// This function is used to delete session labels when a session is destroyed
-extern void CoreValidationDeleteSessionLabels(XrSession session);
+/// The valid values of an enum, sorted by value so they can be searched.
+///
+/// The generated code can only list the values by name, so they are sorted once, when the table is constructed.
+class GenValidUsageEnumTable {
+   public:
+    template <size_t count>
+    explicit GenValidUsageEnumTable(const GenValidUsageEnumValue (&values)[count]) : values_(values, values + count) {
+        std::sort(values_.begin(), values_.end(),
+                  [](const GenValidUsageEnumValue &a, const GenValidUsageEnumValue &b) { return a.value < b.value; });
+    }
+
+    //! Returns the entry for value, or nullptr if value is not valid.
+    const GenValidUsageEnumValue *find(int32_t value) const {
+        auto it = std::lower_bound(values_.begin(), values_.end(), value,
+                                   [](const GenValidUsageEnumValue &entry, int32_t v) { return entry.value < v; });
+        if (it == values_.end() || it->value != value) {
+            return nullptr;
+        }
+        return &(*it);
+    }
+
+   private:
+    std::vector<GenValidUsageEnumValue> values_;
+};
 
 // Object information used for logging.
 struct GenValidUsageXrObjectInfo {
@@ -127,17 +161,413 @@ enum GenValidUsageDebugSeverity {
     VALID_USAGE_DEBUG_SEVERITY_ERROR = 21,
 };
 
+// How much the layer checks, set with XR_CORE_VALIDATION_LEVEL.  Each level checks everything the ones before it do.
+enum CoreValidationLevel {
+    // Only the handles passed to commands that create or destroy handles
+    CORE_VALIDATION_LEVEL_LIFETIME = 0,
+    // The handles passed to every command, and that they belong together
+    CORE_VALIDATION_LEVEL_HANDLES,
+    // Everything: handles, enums, flags, structure types and next chains, and command ordering
+    CORE_VALIDATION_LEVEL_FULL,
+};
+
+// The kinds of check counted when XR_CORE_VALIDATION_COUNTERS is set.
+enum CoreValidationCheck {
+    // Looking a handle up in its info map
+    CORE_VALIDATION_CHECK_HANDLE = 0,
+    // Checking that two handles belong together
+    CORE_VALIDATION_CHECK_PARENT,
+    // Checking the value of an enum
+    CORE_VALIDATION_CHECK_ENUM,
+    // Checking the structures in a next chain, including the checks made on each of them
+    CORE_VALIDATION_CHECK_NEXT_CHAIN,
+    CORE_VALIDATION_CHECK_COUNT,
+};
+
+// How many checks of one kind were made, and how long they took altogether.
+struct CoreValidationCheckCounter {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> nanoseconds;
+};
+
 // in core_validation.cpp
+extern CoreValidationLevel g_core_validation_level;
+extern std::atomic<bool> g_core_validation_counters_enabled;
+extern CoreValidationCheckCounter g_core_validation_check_counters[CORE_VALIDATION_CHECK_COUNT];
+// Bumped, after the maps have changed, whenever a handle is removed from them.
+extern std::atomic<uint64_t> g_handle_removal_epoch;
 void EraseAllInstanceTableMapElements(GenValidUsageXrInstanceInfo *search_value);
+void CoreValidationDeleteSessionLabels(GenValidUsageXrInstanceInfo *instance_info, XrSession session);
+
+/// Counts one check, and the time it takes, for as long as it is in scope.  Does nothing unless counters are enabled,
+/// so that the checks only pay for reading one flag otherwise.
+class CoreValidationCheckTimer {
+   public:
+    explicit CoreValidationCheckTimer(CoreValidationCheck check)
+        : check_(check), enabled_(g_core_validation_counters_enabled.load(std::memory_order_relaxed)) {
+        if (enabled_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+    ~CoreValidationCheckTimer() {
+        if (enabled_) {
+            auto elapsed = std::chrono::steady_clock::now() - start_;
+            CoreValidationCheckCounter &counter = g_core_validation_check_counters[check_];
+            counter.count.fetch_add(1, std::memory_order_relaxed);
+            counter.nanoseconds.fetch_add(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                std::memory_order_relaxed);
+        }
+    }
+    CoreValidationCheckTimer(const CoreValidationCheckTimer &) = delete;
+    CoreValidationCheckTimer &operator=(const CoreValidationCheckTimer &) = delete;
+
+   private:
+    CoreValidationCheck check_;
+    bool enabled_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/// A reader-writer mutex for the handle info maps, since std::shared_mutex needs C++17.
+///
+/// Every call looks handles up, but only create and destroy calls change the maps, so readers only touch an atomic
+/// counter: threads verifying handles at the same time never wait on each other.  A writer first stops new readers
+/// from coming in, then waits for those already in to leave, so a steady stream of lookups cannot starve it.  Waiting
+/// is done by yielding, which is fine for the short time either side holds the mutex.
+///
+/// Not recursive, for readers either: a thread already reading that reads again while a writer waits never gets in,
+/// because the writer is waiting for it to leave.  Debug builds assert that a thread never locks it twice.
+///
+/// Meets the requirements of Lockable for writers, so it can be used with std::unique_lock; use SharedLock for readers.
+class HandleMapMutex {
+   public:
+    HandleMapMutex() = default;
+    HandleMapMutex(const HandleMapMutex &) = delete;
+    HandleMapMutex &operator=(const HandleMapMutex &) = delete;
+
+    void lock() {
+        assert(MarkHeld(true));
+        // One writer at a time, then keep new readers out and wait for the ones already reading
+        writer_mutex_.lock();
+        state_.fetch_or(kWriterBit, std::memory_order_acquire);
+        while ((state_.load(std::memory_order_acquire) & kReaderMask) != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() {
+        if (!writer_mutex_.try_lock()) {
+            return false;
+        }
+        uint32_t expected = 0;
+        if (!state_.compare_exchange_strong(expected, kWriterBit, std::memory_order_acquire)) {
+            writer_mutex_.unlock();
+            return false;
+        }
+        assert(MarkHeld(true));
+        return true;
+    }
+
+    void unlock() {
+        assert(MarkHeld(false));
+        state_.fetch_and(~kWriterBit, std::memory_order_release);
+        writer_mutex_.unlock();
+    }
+
+    void lock_shared() {
+        assert(MarkHeld(true));
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((state & kWriterBit) != 0) {
+                std::this_thread::yield();
+                state = state_.load(std::memory_order_relaxed);
+            } else if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    void unlock_shared() {
+        assert(MarkHeld(false));
+        state_.fetch_sub(1, std::memory_order_release);
+    }
+
+   private:
+#ifndef NDEBUG
+    /// Note that this thread now holds (or no longer holds) this mutex, in either mode.  Returns false if it already
+    /// held it (or did not hold it), or holds more than it can keep track of, so that it can be asserted.
+    bool MarkHeld(bool held) {
+        // A thread holds only a few of these at once, so a short list searched in turn is enough
+        static const size_t kMaxHeld = 16;
+        static thread_local const HandleMapMutex *held_mutexes[kMaxHeld];
+        static thread_local size_t held_count = 0;
+        const HandleMapMutex **end = held_mutexes + held_count;
+        const HandleMapMutex **found = std::find(held_mutexes, end, this);
+        if (held) {
+            if (found != end || held_count == kMaxHeld) {
+                return false;
+            }
+            held_mutexes[held_count++] = this;
+        } else {
+            if (found == end) {
+                return false;
+            }
+            *found = held_mutexes[--held_count];
+        }
+        return true;
+    }
+#endif  // !NDEBUG
+
+    static const uint32_t kWriterBit = 0x80000000U;
+    static const uint32_t kReaderMask = 0x7FFFFFFFU;
+
+    std::atomic<uint32_t> state_{0};
+    std::mutex writer_mutex_;
+};
+
+/// Holds a HandleMapMutex for reading for as long as it is in scope.
+class SharedLock {
+   public:
+    explicit SharedLock(HandleMapMutex &mutex) : mutex_(mutex) { mutex_.lock_shared(); }
+    ~SharedLock() { mutex_.unlock_shared(); }
+    SharedLock(const SharedLock &) = delete;
+    SharedLock &operator=(const SharedLock &) = delete;
+
+   private:
+    HandleMapMutex &mutex_;
+};
+
+/// The last few VerifyXrParent answers found on one thread, each for the g_handle_removal_epoch it was found in.
+/// Handles come and go rarely compared to how often the same ones are checked, so a handful of entries searched in
+/// turn is enough, and staler ones are simply written over.
+struct HandleParentCheckMemo {
+    static const size_t kEntryCount = 8;
+
+    struct Entry {
+        uint64_t epoch;
+        uint64_t handle1;
+        uint64_t handle2;
+        XrObjectType handle1_type;
+        XrObjectType handle2_type;
+        bool check_this;
+        bool result;
+        bool used;
+    };
+
+    bool find(uint64_t epoch, XrObjectType handle1_type, uint64_t handle1, XrObjectType handle2_type, uint64_t handle2,
+              bool check_this, bool &result) const {
+        for (const Entry &entry : entries) {
+            if (entry.used && entry.epoch == epoch && entry.handle1 == handle1 && entry.handle2 == handle2 &&
+                entry.handle1_type == handle1_type && entry.handle2_type == handle2_type && entry.check_this == check_this) {
+                result = entry.result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void store(uint64_t epoch, XrObjectType handle1_type, uint64_t handle1, XrObjectType handle2_type, uint64_t handle2,
+               bool check_this, bool result) {
+        entries[next_entry] = {epoch, handle1, handle2, handle1_type, handle2_type, check_this, result, true};
+        next_entry = (next_entry + 1) % kEntryCount;
+    }
 
-typedef std::unique_lock<std::mutex> UniqueLock;
+    Entry entries[kEntryCount];
+    size_t next_entry;
+};
+
+/// Where a HandleInfoBase keeps its infos: a flat table from handle to slot, and the slots themselves.
+///
+/// Every call looks at least one handle up, so the lookup is a linear probe of one contiguous array of handle and
+/// slot index pairs, instead of a walk through the nodes of an unordered_map.  The infos are built in place in
+/// fixed-size chunks of slots, so creating a handle only allocates when every slot is taken, the infos of handles
+/// created together sit next to each other, and an info never moves while its handle is alive.  The slots of destroyed
+/// handles are reused by the next ones created.
+///
+/// Not thread safe: HandleInfoBase guards it with its HandleMapMutex.
+template <typename HandleType, typename InfoType>
+class HandleInfoStore {
+   public:
+    HandleInfoStore() = default;
+    HandleInfoStore(const HandleInfoStore &) = delete;
+    HandleInfoStore &operator=(const HandleInfoStore &) = delete;
+
+    ~HandleInfoStore() {
+        for (const Entry &entry : entries_) {
+            if (entry.key != 0) {
+                slot(entry.slot)->~InfoType();
+            }
+        }
+    }
+
+    bool empty() const { return count_ == 0; }
+
+    /// Returns the info for the handle, or nullptr if it has none.
+    InfoType *find(HandleType handle) const {
+        if (count_ == 0) {
+            return nullptr;
+        }
+        const uint64_t key = MakeHandleGeneric(handle);
+        for (size_t index = homeIndex(key);; index = (index + 1) & mask_) {
+            const Entry &entry = entries_[index];
+            if (entry.key == key) {
+                return slot(entry.slot);
+            }
+            if (entry.key == 0) {
+                return nullptr;
+            }
+        }
+    }
+
+    /// Builds the info for a handle that has none, from the arguments given, and returns it.
+    template <typename... Args>
+    InfoType *emplace(HandleType handle, Args &&... args) {
+        if ((count_ + 1) * 4 > entries_.size() * 3) {
+            grow();
+        }
+        uint32_t slot_index = allocateSlot();
+        InfoType *info;
+        try {
+            info = new (slot(slot_index)) InfoType{std::forward<Args>(args)...};
+        } catch (...) {
+            free_slots_.push_back(slot_index);
+            throw;
+        }
+        placeKey(MakeHandleGeneric(handle), slot_index);
+        ++count_;
+        return info;
+    }
+
+    /// Destroys the info for the handle.  Returns false if it had none.
+    bool erase(HandleType handle) {
+        if (count_ == 0) {
+            return false;
+        }
+        const uint64_t key = MakeHandleGeneric(handle);
+        for (size_t index = homeIndex(key);; index = (index + 1) & mask_) {
+            if (entries_[index].key == key) {
+                removeAt(index);
+                return true;
+            }
+            if (entries_[index].key == 0) {
+                return false;
+            }
+        }
+    }
+
+    /// Destroys every info the predicate returns true for.
+    template <typename Pred>
+    void eraseIf(Pred &&predicate) {
+        // Removing an entry can move later ones back over it, so find them all before removing any
+        std::vector<uint64_t> keys;
+        for (const Entry &entry : entries_) {
+            if (entry.key != 0 && predicate(*slot(entry.slot))) {
+                keys.push_back(entry.key);
+            }
+        }
+        for (uint64_t key : keys) {
+            for (size_t index = homeIndex(key);; index = (index + 1) & mask_) {
+                if (entries_[index].key == key) {
+                    removeAt(index);
+                    break;
+                }
+            }
+        }
+    }
+
+   private:
+    // A key of 0 marks an unused entry: XR_NULL_HANDLE is never stored.
+    struct Entry {
+        uint64_t key;
+        uint32_t slot;
+    };
+    typedef typename std::aligned_storage<sizeof(InfoType), alignof(InfoType)>::type SlotStorage;
+
+    static const uint32_t kSlotsPerChunk = 64;
+    static const size_t kInitialEntryCount = 16;
+
+    // SplitMix64 finalizer: handle values are often aligned pointers or small counters.
+    static uint64_t hashKey(uint64_t key) {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return key;
+    }
+
+    size_t homeIndex(uint64_t key) const { return static_cast<size_t>(hashKey(key)) & mask_; }
+
+    InfoType *slot(uint32_t slot_index) const {
+        return reinterpret_cast<InfoType *>(&chunks_[slot_index / kSlotsPerChunk][slot_index % kSlotsPerChunk]);
+    }
+
+    uint32_t allocateSlot() {
+        if (!free_slots_.empty()) {
+            uint32_t slot_index = free_slots_.back();
+            free_slots_.pop_back();
+            return slot_index;
+        }
+        if (next_unused_slot_ == chunks_.size() * kSlotsPerChunk) {
+            chunks_.emplace_back(new SlotStorage[kSlotsPerChunk]);
+        }
+        return next_unused_slot_++;
+    }
+
+    void placeKey(uint64_t key, uint32_t slot_index) {
+        size_t index = homeIndex(key);
+        while (entries_[index].key != 0) {
+            index = (index + 1) & mask_;
+        }
+        entries_[index] = {key, slot_index};
+    }
+
+    void grow() {
+        std::vector<Entry> old_entries(entries_.empty() ? kInitialEntryCount : entries_.size() * 2, Entry{0, 0});
+        old_entries.swap(entries_);
+        mask_ = entries_.size() - 1;
+        for (const Entry &entry : old_entries) {
+            if (entry.key != 0) {
+                placeKey(entry.key, entry.slot);
+            }
+        }
+    }
+
+    // Destroy the info of the entry at index, then move back any later entries of the same probe run that would
+    // otherwise no longer be found, so that lookups never need tombstones.
+    void removeAt(size_t index) {
+        uint32_t slot_index = entries_[index].slot;
+        slot(slot_index)->~InfoType();
+        free_slots_.push_back(slot_index);
+        --count_;
+
+        size_t hole = index;
+        for (size_t next = (hole + 1) & mask_; entries_[next].key != 0; next = (next + 1) & mask_) {
+            size_t home = homeIndex(entries_[next].key);
+            // The entry can fill the hole if its home is not in the (cyclic) range just after the hole up to it
+            if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+                entries_[hole] = entries_[next];
+                hole = next;
+            }
+        }
+        entries_[hole] = {0, 0};
+    }
+
+    std::vector<Entry> entries_;
+    size_t mask_ = 0;
+    size_t count_ = 0;
+    std::vector<std::unique_ptr<SlotStorage[]>> chunks_;
+    std::vector<uint32_t> free_slots_;
+    uint32_t next_unused_slot_ = 0;
+};
+
+typedef std::unique_lock<HandleMapMutex> UniqueLock;
 template <typename HandleType, typename InfoType>
 class HandleInfoBase {
    public:
     typedef InfoType info_t;
     typedef HandleType handle_t;
-    typedef std::unordered_map<HandleType, std::unique_ptr<InfoType>> map_t;
-    typedef typename map_t::value_type value_t;
+    typedef HandleInfoStore<HandleType, InfoType> store_t;
 
     /// Validate a handle.
     ///
@@ -149,27 +579,31 @@ class HandleInfoBase {
     InfoType *get(HandleType handle);
 
     /// Lookup a handle, returning a pointer (if found) as well as a lock for this object's dispatch mutex.
+    /// The lock is exclusive, so that the caller may change the info.
     std::pair<UniqueLock, InfoType *> getWithLock(HandleType handle);
 
-    bool empty() const { return info_map_.empty(); }
+    bool empty() const {
+        SharedLock lock(dispatch_mutex_);
+        return info_store_.empty();
+    }
 
-    /// Insert an info for the supplied handle.
+    /// Build an info for the supplied handle, in place, from the arguments given.
     /// Throws if it's already there.
-    void insert(HandleType handle, std::unique_ptr<InfoType> &&info);
+    template <typename... Args>
+    InfoType *emplace(HandleType handle, Args &&... args);
 
     /// Remove the info associated with the supplied handle.
     /// Throws if not found.
     void erase(HandleType handle);
 
-    /// Get a constant reference to the whole map as well as a lock for this object's dispatch mutex.
-    std::pair<UniqueLock, map_t const &> lockMapConst();
-
-    /// Get a  reference to the whole map as well as a lock for this object's dispatch mutex.
-    std::pair<UniqueLock, map_t &> lockMap();
+    /// Remove the infos the predicate returns true for.
+    template <typename Pred>
+    void eraseIf(Pred &&predicate);
 
    protected:
-    map_t info_map_;
-    std::mutex dispatch_mutex_;
+    store_t info_store_;
+    /// Held shared by the lookups, and exclusively by anything that changes the store or an info in it.
+    mutable HandleMapMutex dispatch_mutex_;
 };
 
 /// Subclass used exclusively for instances.
@@ -208,18 +642,9 @@ void InvalidStructureType(GenValidUsageXrInstanceInfo *instance_info, const std:
 
 // -- Only implementations of templates follow --//
 
-template <typename HT, typename IT>
-inline std::pair<UniqueLock, typename HandleInfoBase<HT, IT>::map_t const &> HandleInfoBase<HT, IT>::lockMapConst() {
-    return {UniqueLock(dispatch_mutex_), info_map_};
-}
-
-template <typename HT, typename IT>
-inline std::pair<UniqueLock, typename HandleInfoBase<HT, IT>::map_t &> HandleInfoBase<HT, IT>::lockMap() {
-    return {UniqueLock(dispatch_mutex_), info_map_};
-}
-
 template <typename HandleType, typename InfoType>
 inline ValidateXrHandleResult HandleInfoBase<HandleType, InfoType>::verifyHandle(HandleType const *handle_to_check) {
+    CoreValidationCheckTimer timer(CORE_VALIDATION_CHECK_HANDLE);
     try {
         if (nullptr == handle_to_check) {
             return VALIDATE_XR_HANDLE_INVALID;
@@ -231,10 +656,8 @@ inline ValidateXrHandleResult HandleInfoBase<HandleType, InfoType>::verifyHandle
         }
 
         // Try to find the handle in the appropriate map
-        UniqueLock lock(dispatch_mutex_);
-        auto entry_returned = info_map_.find(*handle_to_check);
-        // If it is not a valid handle, it should return the end of the map.
-        if (info_map_.end() == entry_returned) {
+        SharedLock lock(dispatch_mutex_);
+        if (nullptr == info_store_.find(*handle_to_check)) {
             return VALIDATE_XR_HANDLE_INVALID;
         }
         return VALIDATE_XR_HANDLE_SUCCESS;
@@ -249,12 +672,12 @@ inline InfoType *HandleInfoBase<HandleType, InfoType>::get(HandleType handle) {
         reportInternalError("Null handle passed to HandleInfoBase::get()");
     }
     // Try to find the handle in the appropriate map
-    UniqueLock lock(dispatch_mutex_);
-    auto entry_returned = info_map_.find(handle);
-    if (entry_returned == info_map_.end()) {
+    SharedLock lock(dispatch_mutex_);
+    InfoType *info = info_store_.find(handle);
+    if (nullptr == info) {
         reportInternalError("Handle passed to HandleInfoBase::insert() not inserted");
     }
-    return entry_returned->second.get();
+    return info;
 }
 
 template <typename HandleType, typename InfoType>
@@ -264,25 +687,21 @@ inline std::pair<UniqueLock, InfoType *> HandleInfoBase<HandleType, InfoType>::g
     }
     // Try to find the handle in the appropriate map
     UniqueLock lock(dispatch_mutex_);
-    auto it = info_map_.find(handle);
-    // If it is not a valid handle, it should return the end of the map.
-    if (info_map_.end() == it) {
-        return {std::move(lock), nullptr};
-    }
-    return {std::move(lock), it->second.get()};
+    InfoType *info = info_store_.find(handle);
+    return {std::move(lock), info};
 }
 
 template <typename HandleType, typename InfoType>
-inline void HandleInfoBase<HandleType, InfoType>::insert(HandleType handle, std::unique_ptr<InfoType> &&info) {
+template <typename... Args>
+inline InfoType *HandleInfoBase<HandleType, InfoType>::emplace(HandleType handle, Args &&... args) {
     if (handle == XR_NULL_HANDLE) {
         reportInternalError("Null handle passed to HandleInfoBase::insert()");
     }
     UniqueLock lock(dispatch_mutex_);
-    auto entry_returned = info_map_.find(handle);
-    if (entry_returned != info_map_.end()) {
+    if (nullptr != info_store_.find(handle)) {
         reportInternalError("Handle passed to HandleInfoBase::insert() already inserted");
     }
-    info_map_[handle] = std::move(info);
+    return info_store_.emplace(handle, std::forward<Args>(args)...);
 }
 
 template <typename HandleType, typename InfoType>
@@ -291,11 +710,18 @@ inline void HandleInfoBase<HandleType, InfoType>::erase(HandleType handle) {
         reportInternalError("Null handle passed to HandleInfoBase::erase()");
     }
     UniqueLock lock(dispatch_mutex_);
-    auto entry_returned = info_map_.find(handle);
-    if (entry_returned == info_map_.end()) {
+    if (!info_store_.erase(handle)) {
         reportInternalError("Handle passed to HandleInfoBase::insert() not inserted");
     }
-    info_map_.erase(handle);
+    g_handle_removal_epoch.fetch_add(1, std::memory_order_release);
+}
+
+template <typename HandleType, typename InfoType>
+template <typename Pred>
+inline void HandleInfoBase<HandleType, InfoType>::eraseIf(Pred &&predicate) {
+    UniqueLock lock(dispatch_mutex_);
+    info_store_.eraseIf(std::forward<Pred>(predicate));
+    g_handle_removal_epoch.fetch_add(1, std::memory_order_release);
 }
 
 template <typename HandleType>
@@ -305,21 +731,18 @@ inline std::pair<GenValidUsageXrHandleInfo *, GenValidUsageXrInstanceInfo *> Han
         reportInternalError("Null handle passed to HandleInfoBase::getWithInstanceInfo()");
     }
     // Try to find the handle in the appropriate map
-    UniqueLock lock(this->dispatch_mutex_);
-    auto entry_returned = this->info_map_.find(handle);
-    if (entry_returned == this->info_map_.end()) {
+    SharedLock lock(this->dispatch_mutex_);
+    GenValidUsageXrHandleInfo *info = this->info_store_.find(handle);
+    if (nullptr == info) {
         reportInternalError("Handle passed to HandleInfoBase::getWithInstanceInfo() not inserted");
     }
-    GenValidUsageXrHandleInfo *info = entry_returned->second.get();
     GenValidUsageXrInstanceInfo *instance_info = info->instance_info;
     return {info, instance_info};
 }
 
 template <typename HandleType>
 inline void HandleInfo<HandleType>::removeHandlesForInstance(GenValidUsageXrInstanceInfo *search_value) {
-    typedef typename base_t::value_t value_t;
-    UniqueLock lock(this->dispatch_mutex_);
-    map_erase_if(this->info_map_, [=](value_t const &data) { return data.second && data.second->instance_info == search_value; });
+    this->eraseIf([=](GenValidUsageXrHandleInfo const &info) { return info.instance_info == search_value; });
 }
 
 #endif  // VALIDATION_UTILS_H_
@@ -22,6 +22,7 @@
 
 #include "platform_utils.hpp"
 
+#include <cstdio>
 #include <cstring>
 
 #if defined DISABLE_STD_FILESYSTEM
@@ -84,6 +85,13 @@
 #include <dirent.h>
 #endif
 
+#if !defined(XR_OS_WINDOWS)
+// Directory listing with entry types, whichever implementation is used for the rest
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
 #if defined(XR_USE_PLATFORM_WIN32)
 #define PATH_SEPARATOR ';'
 #define DIRECTORY_SYMBOL '\\'
@@ -150,6 +158,32 @@ bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::strin
     return true;
 }
 
+bool FileSysUtilsGetFileStamp(const std::string& path, FileSysUtilsFileStamp& stamp) {
+    std::error_code error;
+    auto modified_time = FS_PREFIX::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    stamp.modified_time = static_cast<int64_t>(modified_time.time_since_epoch().count());
+    stamp.size = 0;
+    if (FS_PREFIX::is_regular_file(path, error)) {
+        stamp.size = static_cast<uint64_t>(FS_PREFIX::file_size(path, error));
+    }
+    return !error;
+}
+
+bool FileSysUtilsCreateDirectories(const std::string& path) {
+    std::error_code error;
+    FS_PREFIX::create_directories(path, error);
+    return FS_PREFIX::is_directory(path, error);
+}
+
+bool FileSysUtilsRenameFile(const std::string& from_path, const std::string& to_path) {
+    std::error_code error;
+    FS_PREFIX::rename(from_path, to_path, error);
+    return !error;
+}
+
 #elif defined(XR_OS_WINDOWS)
 
 // For pre C++17 compiler that doesn't support experimental filesystem
@@ -236,6 +270,32 @@ bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::strin
     return false;
 }
 
+bool FileSysUtilsGetFileStamp(const std::string& path, FileSysUtilsFileStamp& stamp) {
+    WIN32_FILE_ATTRIBUTE_DATA file_data;
+    if (!GetFileAttributesExW(utf8_to_wide(path).c_str(), GetFileExInfoStandard, &file_data)) {
+        return false;
+    }
+    stamp.modified_time = static_cast<int64_t>((static_cast<uint64_t>(file_data.ftLastWriteTime.dwHighDateTime) << 32) |
+                                               file_data.ftLastWriteTime.dwLowDateTime);
+    stamp.size = (static_cast<uint64_t>(file_data.nFileSizeHigh) << 32) | file_data.nFileSizeLow;
+    return true;
+}
+
+bool FileSysUtilsCreateDirectories(const std::string& path) {
+    std::string::size_type location = path.find_first_of("\\/", 1);
+    while (location != std::string::npos) {
+        // Failures here are for parents that already exist, or that we may not create: only the final result matters.
+        CreateDirectoryW(utf8_to_wide(path.substr(0, location)).c_str(), NULL);
+        location = path.find_first_of("\\/", location + 1);
+    }
+    CreateDirectoryW(utf8_to_wide(path).c_str(), NULL);
+    return FileSysUtilsIsDirectory(path);
+}
+
+bool FileSysUtilsRenameFile(const std::string& from_path, const std::string& to_path) {
+    return (0 != MoveFileExW(utf8_to_wide(from_path).c_str(), utf8_to_wide(to_path).c_str(), MOVEFILE_REPLACE_EXISTING));
+}
+
 #else  // XR_OS_LINUX/XR_OS_APPLE fallback
 
 // simple POSIX-compatible implementation of the <filesystem> pieces used by OpenXR
@@ -323,4 +383,93 @@ bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::strin
     return true;
 }
 
+bool FileSysUtilsGetFileStamp(const std::string& path, FileSysUtilsFileStamp& stamp) {
+    struct stat path_stat;
+    if (0 != stat(path.c_str(), &path_stat)) {
+        return false;
+    }
+#if defined(XR_OS_APPLE)
+    const int64_t nanoseconds = path_stat.st_mtimespec.tv_nsec;
+#else
+    const int64_t nanoseconds = path_stat.st_mtim.tv_nsec;
+#endif
+    stamp.modified_time = static_cast<int64_t>(path_stat.st_mtime) * 1000000000 + nanoseconds;
+    stamp.size = S_ISREG(path_stat.st_mode) ? static_cast<uint64_t>(path_stat.st_size) : 0;
+    return true;
+}
+
+bool FileSysUtilsCreateDirectories(const std::string& path) {
+    std::string::size_type location = path.find(DIRECTORY_SYMBOL, 1);
+    while (location != std::string::npos) {
+        // Failures here are for parents that already exist, or that we may not create: only the final result matters.
+        mkdir(path.substr(0, location).c_str(), 0755);
+        location = path.find(DIRECTORY_SYMBOL, location + 1);
+    }
+    mkdir(path.c_str(), 0755);
+    return FileSysUtilsIsDirectory(path);
+}
+
+bool FileSysUtilsRenameFile(const std::string& from_path, const std::string& to_path) {
+    return (0 == rename(from_path.c_str(), to_path.c_str()));
+}
+
+#endif
+
+#if defined(XR_OS_WINDOWS)
+
+bool FileSysUtilsFindEntriesInPath(const std::string& path, std::vector<FileSysUtilsDirectoryEntry>& entries) {
+    // The basic information level skips the short 8.3 names, and large fetches ask for many entries per call.
+    WIN32_FIND_DATAW file_data;
+    std::string pattern;
+    FileSysUtilsCombinePaths(path, "*", pattern);
+    HANDLE file_handle = FindFirstFileExW(utf8_to_wide(pattern).c_str(), FindExInfoBasic, &file_data, FindExSearchNameMatch,
+                                          NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        if (0 == wcscmp(file_data.cFileName, L".") || 0 == wcscmp(file_data.cFileName, L"..")) {
+            continue;
+        }
+        FileSysUtilsDirectoryEntry entry;
+        entry.name = wide_to_utf8(file_data.cFileName);
+        entry.is_directory = (0 != (file_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY));
+        entry.is_regular_file = !entry.is_directory && (0 == (file_data.dwFileAttributes & FILE_ATTRIBUTE_DEVICE));
+        entries.push_back(entry);
+    } while (FindNextFileW(file_handle, &file_data));
+    FindClose(file_handle);
+    return true;
+}
+
+#else  // XR_OS_LINUX/XR_OS_APPLE
+
+bool FileSysUtilsFindEntriesInPath(const std::string& path, std::vector<FileSysUtilsDirectoryEntry>& entries) {
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    struct dirent* dir_entry;
+    while ((dir_entry = readdir(dir)) != nullptr) {
+        if (0 == strcmp(dir_entry->d_name, ".") || 0 == strcmp(dir_entry->d_name, "..")) {
+            continue;
+        }
+        FileSysUtilsDirectoryEntry entry;
+        entry.name = dir_entry->d_name;
+        unsigned char type = dir_entry->d_type;
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            // Only some file systems fill in the type, and links need following to see what they point at.
+            struct stat entry_stat;
+            type = DT_UNKNOWN;
+            if (0 == fstatat(dirfd(dir), dir_entry->d_name, &entry_stat, 0)) {
+                type = S_ISREG(entry_stat.st_mode) ? DT_REG : (S_ISDIR(entry_stat.st_mode) ? DT_DIR : DT_UNKNOWN);
+            }
+        }
+        entry.is_regular_file = (type == DT_REG);
+        entry.is_directory = (type == DT_DIR);
+        entries.push_back(entry);
+    }
+    closedir(dir);
+    return true;
+}
+
 #endif
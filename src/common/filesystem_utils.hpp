@@ -19,9 +19,25 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+// When a file or directory was last modified, and how big it is, so callers can tell whether it has changed.  Times are
+// only meaningful compared with other times from FileSysUtilsGetFileStamp.
+struct FileSysUtilsFileStamp {
+    int64_t modified_time;
+    uint64_t size;
+};
+
+// One entry in a directory, as listed by FileSysUtilsFindEntriesInPath.  Symbolic links are described by what they point
+// at, and an entry whose type could not be determined is neither a regular file nor a directory.
+struct FileSysUtilsDirectoryEntry {
+    std::string name;
+    bool is_regular_file;
+    bool is_directory;
+};
+
 // Determine if the path indicates a regular file (not a directory or symbolic link)
 bool FileSysUtilsIsRegularFile(const std::string& path);
 
@@ -51,3 +67,17 @@ bool FileSysUtilsParsePathList(std::string& path_list, std::vector<std::string>&
 
 // Record all the filenames for files found in the provided path.
 bool FileSysUtilsFindFilesInPath(const std::string& path, std::vector<std::string>& files);
+
+// Get the entries in a directory along with their types.  Unlike calling FileSysUtilsIsRegularFile on each file from
+// FileSysUtilsFindFilesInPath, this only needs a separate query per entry where the platform does not report the type
+// while listing the directory.
+bool FileSysUtilsFindEntriesInPath(const std::string& path, std::vector<FileSysUtilsDirectoryEntry>& entries);
+
+// Get the modification time and size of a file or directory
+bool FileSysUtilsGetFileStamp(const std::string& path, FileSysUtilsFileStamp& stamp);
+
+// Create a directory, and any missing parent directories
+bool FileSysUtilsCreateDirectories(const std::string& path);
+
+// Rename a file, replacing any existing file at the destination
+bool FileSysUtilsRenameFile(const std::string& from_path, const std::string& to_path);
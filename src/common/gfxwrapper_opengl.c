@@ -145,6 +145,8 @@ A frame log is always opened for a specified number of frames, and will
 automatically close after the specified number of frames have been recorded.
 The CPU and GPU times for the recorded frames will be listed at the end of the log.
 
+Independent of any log, every frame is also kept in the ring of frame records declared in the header.
+
 ksFrameLog
 
 static void ksFrameLog_Open( const char * fileName, const int frameCount );
@@ -156,6 +158,107 @@ gpuTimeFramesDelayed );
 ================================================================================================================================
 */
 
+/*
+The ring of frame records. Frames are numbered from the first one begun; the one at frameRecordsBegun - 1 is still being
+recorded while frameRecordOpen is set. Calls are counted into frameRecordCalls and handed to the frame when it ends.
+*/
+static ksFrameRecord frameRecords[KS_FRAME_RECORD_COUNT];
+static int frameRecordsBegun;
+static bool frameRecordOpen;
+static int frameRecordCalls;
+
+static void ksFrameRecords_Begin() {
+    ksFrameRecord *record = &frameRecords[frameRecordsBegun % KS_FRAME_RECORD_COUNT];
+    memset(record, 0, sizeof(ksFrameRecord));
+    record->frame = frameRecordsBegun++;
+    record->beginTime = GetTimeNanoseconds();
+    frameRecordOpen = true;
+    frameRecordCalls = 0;
+}
+
+static void ksFrameRecords_End(const ksNanoseconds cpuTimeNanoseconds, const ksNanoseconds gpuTimeNanoseconds,
+                               const int gpuTimeFramesDelayed) {
+    if (!frameRecordOpen) {
+        return;
+    }
+    const int frame = frameRecordsBegun - 1;
+    ksFrameRecord *record = &frameRecords[frame % KS_FRAME_RECORD_COUNT];
+    record->cpuTime = cpuTimeNanoseconds;
+    record->callCount = frameRecordCalls;
+    frameRecordOpen = false;
+
+    // The GPU time arrives for an earlier frame, if that is still in the ring.
+    const int gpuFrame = frame - gpuTimeFramesDelayed;
+    if (gpuFrame >= 0 && gpuTimeFramesDelayed < KS_FRAME_RECORD_COUNT) {
+        frameRecords[gpuFrame % KS_FRAME_RECORD_COUNT].gpuTime = gpuTimeNanoseconds;
+    }
+}
+
+static void ksFrameRecords_SwapBuffers() {
+    if (frameRecordsBegun > 0) {
+        frameRecords[(frameRecordsBegun - 1) % KS_FRAME_RECORD_COUNT].swapTime = GetTimeNanoseconds();
+    }
+}
+
+void ksFrameLog_CountCalls(const int callCount) { frameRecordCalls += callCount; }
+
+int ksFrameLog_GetRecords(ksFrameRecord *records, const int maxRecords) {
+    // A frame still being recorded has taken the slot of the oldest one.
+    const int ended = frameRecordOpen ? frameRecordsBegun - 1 : frameRecordsBegun;
+    const int kept = frameRecordOpen ? KS_FRAME_RECORD_COUNT - 1 : KS_FRAME_RECORD_COUNT;
+    int count = ended < kept ? ended : kept;
+    if (count > maxRecords) {
+        count = maxRecords;
+    }
+    for (int i = 0; i < count; i++) {
+        records[i] = frameRecords[(ended - count + i) % KS_FRAME_RECORD_COUNT];
+    }
+    return count;
+}
+
+bool ksFrameLog_ExportRecords(const char *fileName) {
+    FILE *fp = fopen(fileName, "wb");
+    if (fp == NULL) {
+        Print("Failed to open %s\n", fileName);
+        return false;
+    }
+
+    ksFrameRecord *records = (ksFrameRecord *)malloc(KS_FRAME_RECORD_COUNT * sizeof(ksFrameRecord));
+    const int count = ksFrameLog_GetRecords(records, KS_FRAME_RECORD_COUNT);
+
+    const size_t length = strlen(fileName);
+    if (length >= 5 && strcmp(fileName + length - 5, ".json") == 0) {
+        // The CPU time of each frame on one row, with its GPU time and calls as arguments, and its swap as an instant.
+        fprintf(fp, "[\n");
+        for (int i = 0; i < count; i++) {
+            const ksFrameRecord *r = &records[i];
+            fprintf(fp,
+                    "%s{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"frame\":%d,\"gpu_ns\":%llu,\"calls\":%d}}",
+                    i > 0 ? ",\n" : "", r->beginTime * 1e-3, r->cpuTime * 1e-3, r->frame, (unsigned long long)r->gpuTime,
+                    r->callCount);
+            if (r->swapTime != 0) {
+                fprintf(fp, ",\n{\"name\":\"SwapBuffers\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":1,\"ts\":%.3f}",
+                        r->swapTime * 1e-3);
+            }
+        }
+        fprintf(fp, "\n]\n");
+    } else {
+        fprintf(fp, "frame,begin_ns,cpu_ns,gpu_ns,calls,swap_ns\n");
+        for (int i = 0; i < count; i++) {
+            const ksFrameRecord *r = &records[i];
+            fprintf(fp, "%d,%llu,%llu,%llu,%d,%llu\n", r->frame, (unsigned long long)r->beginTime,
+                    (unsigned long long)r->cpuTime, (unsigned long long)r->gpuTime, r->callCount,
+                    (unsigned long long)r->swapTime);
+        }
+    }
+
+    free(records);
+    fclose(fp);
+    Print("Exported %d frame records to %s.\n", count, fileName);
+    return true;
+}
+
 typedef struct {
     FILE *fp;
     ksNanoseconds *frameCpuTimes;
@@ -204,6 +307,8 @@ static void ksFrameLog_Write(const char *fileName, const int lineNumber, const c
 }
 
 static void ksFrameLog_BeginFrame() {
+    ksFrameRecords_Begin();
+
     ksFrameLog *l = ksFrameLog_Get();
     if (l != NULL && l->fp != NULL) {
         if (l->frame < l->frameCount) {
@@ -216,6 +321,8 @@ static void ksFrameLog_BeginFrame() {
 
 static void ksFrameLog_EndFrame(const ksNanoseconds cpuTimeNanoseconds, const ksNanoseconds gpuTimeNanoseconds,
                                 const int gpuTimeFramesDelayed) {
+    ksFrameRecords_End(cpuTimeNanoseconds, gpuTimeNanoseconds, gpuTimeFramesDelayed);
+
     ksFrameLog *l = ksFrameLog_Get();
     if (l != NULL && l->fp != NULL) {
         if (l->frame < l->frameCount) {
@@ -256,10 +363,13 @@ OpenGL error checking.
 #if defined(_DEBUG)
 #define GL(func)                                 \
     func;                                        \
+    frameRecordCalls++;                          \
     ksFrameLog_Write(__FILE__, __LINE__, #func); \
     GlCheckErrors(#func);
 #else
-#define GL(func) func;
+#define GL(func) \
+    func;        \
+    frameRecordCalls++;
 #endif
 
 #if defined(_DEBUG)
@@ -382,18 +492,6 @@ OpenGL extensions.
 ================================================================================================================================
 */
 
-typedef struct {
-    bool timer_query;                       // GL_ARB_timer_query, GL_EXT_disjoint_timer_query
-    bool texture_clamp_to_border;           // GL_EXT_texture_border_clamp, GL_OES_texture_border_clamp
-    bool buffer_storage;                    // GL_ARB_buffer_storage
-    bool multi_sampled_storage;             // GL_ARB_texture_storage_multisample
-    bool multi_view;                        // GL_OVR_multiview, GL_OVR_multiview2
-    bool multi_sampled_resolve;             // GL_EXT_multisampled_render_to_texture
-    bool multi_view_multi_sampled_resolve;  // GL_OVR_multiview_multisampled_render_to_texture
-
-    int texture_clamp_to_border_id;
-} ksOpenGLExtensions;
-
 ksOpenGLExtensions glExtensions;
 
 /*
@@ -4322,7 +4420,36 @@ void ksGpuWindow_SwapInterval(ksGpuWindow *window, const int swapInterval) {
     }
 }
 
+// With adaptive frame pacing, how long a swap is left to block, for the variation in how long frames take to render.
+#define SWAP_DELAY_MARGIN_NANOSECONDS 1000000
+
+// Adapts the delay before the swap to how long the swap that just returned blocked, and whether it missed its refresh.
+static void ksGpuWindow_UpdateFramePacing(ksGpuWindow *window, const ksNanoseconds swapStartTime,
+                                          const ksNanoseconds swapEndTime) {
+    const int64_t frameTime = (int64_t)ksGpuWindow_GetFrameTimeNanoseconds(window);
+    const int64_t swapInterval = (int64_t)(swapEndTime - window->lastSwapTime);
+    window->lastSwapDuration = swapEndTime - swapStartTime;
+
+    int64_t delay = (int64_t)window->adaptiveSwapDelay;
+    if (swapInterval * 2 > frameTime * 3) {
+        // Missed a refresh, so back off quickly.
+        delay += frameTime / 4;
+    } else {
+        // Close in slowly on the delay that leaves the swap blocking for just the margin.
+        delay -= ((int64_t)window->lastSwapDuration - SWAP_DELAY_MARGIN_NANOSECONDS) / 4;
+    }
+    if (delay < SWAP_DELAY_MARGIN_NANOSECONDS) {
+        delay = SWAP_DELAY_MARGIN_NANOSECONDS;
+    }
+    if (delay > frameTime) {
+        delay = frameTime;
+    }
+    window->adaptiveSwapDelay = (ksNanoseconds)delay;
+}
+
 void ksGpuWindow_SwapBuffers(ksGpuWindow *window) {
+    const ksNanoseconds swapStartTime = GetTimeNanoseconds();
+
 #if defined(OS_WINDOWS)
     SwapBuffers(window->context.hDC);
 #elif defined(OS_LINUX_XLIB)
@@ -4338,6 +4465,9 @@ void ksGpuWindow_SwapBuffers(ksGpuWindow *window) {
 #endif
 
     ksNanoseconds newTimeNanoseconds = GetTimeNanoseconds();
+    if (window->adaptiveFramePacing) {
+        ksGpuWindow_UpdateFramePacing(window, swapStartTime, newTimeNanoseconds);
+    }
 
     // Even with smoothing, this is not particularly accurate.
     const float frameTimeNanoseconds = 1000.0f * 1000.0f * 1000.0f / window->windowRefreshRate;
@@ -4349,6 +4479,7 @@ void ksGpuWindow_SwapBuffers(ksGpuWindow *window) {
     // Print( "frame delta = %1.3f (error = %1.3f)\n", smoothDeltaNanoseconds * 1e-6f,
     //					( smoothDeltaNanoseconds - frameTimeNanoseconds ) * 1e-6f );
     window->lastSwapTime = newTimeNanoseconds;
+    ksFrameRecords_SwapBuffers();
 }
 
 ksNanoseconds ksGpuWindow_GetNextSwapTimeNanoseconds(ksGpuWindow *window) {
@@ -4362,23 +4493,35 @@ ksNanoseconds ksGpuWindow_GetFrameTimeNanoseconds(ksGpuWindow *window) {
 }
 
 void ksGpuWindow_DelayBeforeSwap(ksGpuWindow *window, const ksNanoseconds delay) {
-    UNUSED_PARM(window);
-    UNUSED_PARM(delay);
+    // wglDelayBeforeSwapNV and glXDelayBeforeSwapNV appear to not only stall the calling context but also other
+    // contexts, so this sleeps on the CPU instead.
+    ksNanoseconds swapDelay = delay;
+    if (window->adaptiveFramePacing && window->adaptiveSwapDelay > swapDelay) {
+        swapDelay = window->adaptiveSwapDelay;
+    }
+    const ksNanoseconds wakeUpTime = ksGpuWindow_GetNextSwapTimeNanoseconds(window) - swapDelay;
 
-    // FIXME: this appears to not only stall the calling context but also other contexts.
-    /*
-    #if defined( OS_WINDOWS )
-            if ( wglDelayBeforeSwapNV != NULL )
-            {
-                    wglDelayBeforeSwapNV( window->hDC, delay * 1e-6f );
-            }
-    #elif defined( OS_LINUX_XLIB )
-            if ( glXDelayBeforeSwapNV != NULL )
-            {
-                    glXDelayBeforeSwapNV( window->hDC, delay * 1e-6f );
-            }
-    #endif
-    */
+    for (ksNanoseconds time = GetTimeNanoseconds(); time < wakeUpTime; time = GetTimeNanoseconds()) {
+#if defined(OS_WINDOWS)
+        // Sleep() only has millisecond granularity, so yield for the last one.
+        const DWORD milliseconds = (DWORD)((wakeUpTime - time) / 1000000);
+        Sleep(milliseconds > 1 ? milliseconds - 1 : 0);
+#else
+        const ksNanoseconds remaining = wakeUpTime - time;
+        struct timespec duration;
+        duration.tv_sec = (time_t)(remaining / 1000000000);
+        duration.tv_nsec = (long)(remaining % 1000000000);
+        nanosleep(&duration, NULL);
+#endif
+    }
+}
+
+void ksGpuWindow_SetAdaptiveFramePacing(ksGpuWindow *window, const bool enable) {
+    if (enable && !window->adaptiveFramePacing) {
+        // Start from no delay at all and close in on the smallest safe one.
+        window->adaptiveSwapDelay = ksGpuWindow_GetFrameTimeNanoseconds(window);
+    }
+    window->adaptiveFramePacing = enable;
 }
 
 static bool ksGpuWindowInput_ConsumeKeyboardKey(ksGpuWindowInput *input, const ksKeyboardKey key) {
@@ -4404,6 +4547,97 @@ static bool ksGpuWindowInput_CheckKeyboardKey(ksGpuWindowInput *input, const ksK
 /*
 ================================================================================================================================
 
+GPU ring buffer.
+
+================================================================================================================================
+*/
+
+void ksGpuRingBuffer_Create(ksGpuContext *context, ksGpuRingBuffer *buffer, const GLenum target, const size_t segmentSize,
+                            const int segmentCount) {
+    UNUSED_PARM(context);
+
+    memset(buffer, 0, sizeof(ksGpuRingBuffer));
+    buffer->target = target;
+    buffer->segmentSize = segmentSize;
+    buffer->segmentCount = 1;
+
+    GL(glGenBuffers(1, &buffer->buffer));
+    GL(glBindBuffer(target, buffer->buffer));
+    if (glExtensions.buffer_storage) {
+        const int count = segmentCount < KS_GPU_RING_BUFFER_MAX_SEGMENTS ? segmentCount : KS_GPU_RING_BUFFER_MAX_SEGMENTS;
+        const GLsizeiptr size = (GLsizeiptr)(segmentSize * count);
+        // Being coherent, writes through the mapping need no flush before the commands that read them.
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GL(glBufferStorage(target, size, NULL, flags));
+        GL(buffer->mapped = (unsigned char *)glMapBufferRange(target, 0, size, flags));
+        if (buffer->mapped != NULL) {
+            buffer->segmentCount = count;
+        } else {
+            // Immutable storage can't be orphaned, so start over with a buffer that can.
+            GL(glBindBuffer(target, 0));
+            GL(glDeleteBuffers(1, &buffer->buffer));
+            GL(glGenBuffers(1, &buffer->buffer));
+            GL(glBindBuffer(target, buffer->buffer));
+        }
+    }
+    if (buffer->mapped == NULL) {
+        GL(glBufferData(target, (GLsizeiptr)segmentSize, NULL, GL_STREAM_DRAW));
+        buffer->staging = (unsigned char *)malloc(segmentSize);
+    }
+    GL(glBindBuffer(target, 0));
+}
+
+void ksGpuRingBuffer_Destroy(ksGpuContext *context, ksGpuRingBuffer *buffer) {
+    UNUSED_PARM(context);
+
+    for (int i = 0; i < KS_GPU_RING_BUFFER_MAX_SEGMENTS; i++) {
+        if (buffer->fences[i] != 0) {
+            GL(glDeleteSync(buffer->fences[i]));
+        }
+    }
+    if (buffer->buffer != 0) {
+        // Deleting the buffer also unmaps it.
+        GL(glDeleteBuffers(1, &buffer->buffer));
+    }
+    free(buffer->staging);
+    memset(buffer, 0, sizeof(ksGpuRingBuffer));
+}
+
+void *ksGpuRingBuffer_MapSegment(ksGpuRingBuffer *buffer, size_t *offset) {
+    GL(glBindBuffer(buffer->target, buffer->buffer));
+    if (buffer->mapped == NULL) {
+        *offset = 0;
+        return buffer->staging;
+    }
+
+    // The oldest segment was last read segmentCount segments ago.
+    buffer->segment = (buffer->segment + 1) % buffer->segmentCount;
+    GLsync *fence = &buffer->fences[buffer->segment];
+    if (*fence != 0) {
+        GL(glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+        GL(glDeleteSync(*fence));
+        *fence = 0;
+    }
+    *offset = buffer->segment * buffer->segmentSize;
+    return buffer->mapped + *offset;
+}
+
+void ksGpuRingBuffer_UnmapSegment(ksGpuRingBuffer *buffer, const size_t size) {
+    if (buffer->mapped == NULL) {
+        GL(glBufferData(buffer->target, (GLsizeiptr)buffer->segmentSize, NULL, GL_STREAM_DRAW));
+        GL(glBufferSubData(buffer->target, 0, (GLsizeiptr)size, buffer->staging));
+    }
+}
+
+void ksGpuRingBuffer_FenceSegment(ksGpuRingBuffer *buffer) {
+    if (buffer->mapped != NULL) {
+        GL(buffer->fences[buffer->segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+}
+
+/*
+================================================================================================================================
+
 GPU timer.
 
 ================================================================================================================================
@@ -4412,11 +4646,14 @@ GPU timer.
 void ksGpuTimer_Create(ksGpuContext *context, ksGpuTimer *timer) {
     UNUSED_PARM(context);
 
+    timer->queryIndex = 0;
+    timer->resultIndex = 0;
+    timer->gpuTime = 0;
+    timer->gpuTimeFrame = -1;
+    timer->cpuBeginTime = 0;
     if (glExtensions.timer_query) {
-        GL(glGenQueries(KS_GPU_TIMER_FRAMES_DELAYED, timer->beginQueries));
-        GL(glGenQueries(KS_GPU_TIMER_FRAMES_DELAYED, timer->endQueries));
-        timer->queryIndex = 0;
-        timer->gpuTime = 0;
+        GL(glGenQueries(KS_GPU_TIMER_FRAMES_IN_FLIGHT, timer->beginQueries));
+        GL(glGenQueries(KS_GPU_TIMER_FRAMES_IN_FLIGHT, timer->endQueries));
     }
 }
 
@@ -4424,11 +4661,52 @@ void ksGpuTimer_Destroy(ksGpuContext *context, ksGpuTimer *timer) {
     UNUSED_PARM(context);
 
     if (glExtensions.timer_query) {
-        GL(glDeleteQueries(KS_GPU_TIMER_FRAMES_DELAYED, timer->beginQueries));
-        GL(glDeleteQueries(KS_GPU_TIMER_FRAMES_DELAYED, timer->endQueries));
+        GL(glDeleteQueries(KS_GPU_TIMER_FRAMES_IN_FLIGHT, timer->beginQueries));
+        GL(glDeleteQueries(KS_GPU_TIMER_FRAMES_IN_FLIGHT, timer->endQueries));
     }
 }
 
+void ksGpuTimer_Begin(ksGpuTimer *timer) {
+    ksFrameLog_BeginFrame();
+    timer->cpuBeginTime = GetTimeNanoseconds();
+
+    if (glExtensions.timer_query) {
+        // Read back every frame the GPU is done with. The queries complete in order, so the first still outstanding
+        // means the rest are too.
+        while (timer->resultIndex < timer->queryIndex) {
+            const int query = timer->resultIndex % KS_GPU_TIMER_FRAMES_IN_FLIGHT;
+            GLuint available = GL_FALSE;
+            GL(glGetQueryObjectuiv(timer->endQueries[query], GL_QUERY_RESULT_AVAILABLE, &available));
+            if (!available) {
+                break;
+            }
+            GLuint64 beginGpuTime = 0;
+            GL(glGetQueryObjectui64v(timer->beginQueries[query], GL_QUERY_RESULT, &beginGpuTime));
+            GLuint64 endGpuTime = 0;
+            GL(glGetQueryObjectui64v(timer->endQueries[query], GL_QUERY_RESULT, &endGpuTime));
+            timer->gpuTime = (ksNanoseconds)(endGpuTime - beginGpuTime);
+            timer->gpuTimeFrame = timer->resultIndex++;
+        }
+
+        // Rather than wait for the oldest frame to free its queries for this one, leave it unmeasured.
+        if (timer->queryIndex - timer->resultIndex >= KS_GPU_TIMER_FRAMES_IN_FLIGHT) {
+            timer->resultIndex++;
+        }
+
+        GL(glQueryCounter(timer->beginQueries[timer->queryIndex % KS_GPU_TIMER_FRAMES_IN_FLIGHT], GL_TIMESTAMP));
+    }
+}
+
+void ksGpuTimer_End(ksGpuTimer *timer) {
+    if (glExtensions.timer_query) {
+        GL(glQueryCounter(timer->endQueries[timer->queryIndex % KS_GPU_TIMER_FRAMES_IN_FLIGHT], GL_TIMESTAMP));
+        timer->queryIndex++;
+    }
+
+    const int framesDelayed = ksGpuTimer_GetFramesDelayed(timer);
+    ksFrameLog_EndFrame(GetTimeNanoseconds() - timer->cpuBeginTime, timer->gpuTime, framesDelayed >= 0 ? framesDelayed : 0);
+}
+
 ksNanoseconds ksGpuTimer_GetNanoseconds(ksGpuTimer *timer) {
     if (glExtensions.timer_query) {
         return timer->gpuTime;
@@ -4436,3 +4714,11 @@ ksNanoseconds ksGpuTimer_GetNanoseconds(ksGpuTimer *timer) {
         return 0;
     }
 }
+
+int ksGpuTimer_GetFramesDelayed(ksGpuTimer *timer) {
+    if (glExtensions.timer_query && timer->gpuTimeFrame >= 0) {
+        return timer->queryIndex - 1 - timer->gpuTimeFrame;
+    } else {
+        return -1;
+    }
+}
@@ -418,6 +418,21 @@ Common defines
 
 void GlInitExtensions();
 
+// The extensions found by GlInitExtensions, which ksGpuWindow_Create calls once it has a context.
+typedef struct {
+    bool timer_query;                       // GL_ARB_timer_query, GL_EXT_disjoint_timer_query
+    bool texture_clamp_to_border;           // GL_EXT_texture_border_clamp, GL_OES_texture_border_clamp
+    bool buffer_storage;                    // GL_ARB_buffer_storage
+    bool multi_sampled_storage;             // GL_ARB_texture_storage_multisample
+    bool multi_view;                        // GL_OVR_multiview, GL_OVR_multiview2
+    bool multi_sampled_resolve;             // GL_EXT_multisampled_render_to_texture
+    bool multi_view_multi_sampled_resolve;  // GL_OVR_multiview_multisampled_render_to_texture
+
+    int texture_clamp_to_border_id;
+} ksOpenGLExtensions;
+
+extern ksOpenGLExtensions glExtensions;
+
 /*
 ================================================================================================================================
 
@@ -880,6 +895,13 @@ For optimal performance a window should only be created at load time, not at run
 Because on some platforms the OS/drivers use thread local storage, ksGpuWindow *must* be created
 and destroyed on the same thread that will actually render to the window and swap buffers.
 
+ksGpuWindow_DelayBeforeSwap() sleeps until the given time before the next predicted swap, so that the last work of a
+frame, such as a mirror of the latest headset frame, is issued as late as possible and does not queue up GPU work ahead
+of the display. With adaptive frame pacing the window chooses the delay instead, or uses the given one if that is larger:
+every swap measures how long it blocked waiting for the display, the delay shrinks until that wait is down to a small
+margin, and it grows back quickly when a swap misses its refresh. A driver whose swaps never block leaves the delay at a
+whole frame, which is the same as not delaying at all.
+
 ksGpuWindow
 ksGpuWindowEvent
 ksGpuWindowInput
@@ -899,6 +921,8 @@ void ksGpuWindow_SwapInterval( ksGpuWindow * window, const int swapInterval );
 void ksGpuWindow_SwapBuffers( ksGpuWindow * window );
 ksNanoseconds ksGpuWindow_GetNextSwapTimeNanoseconds( ksGpuWindow * window );
 ksNanoseconds ksGpuWindow_GetFrameTimeNanoseconds( ksGpuWindow * window );
+void ksGpuWindow_DelayBeforeSwap( ksGpuWindow * window, const ksNanoseconds delay );
+void ksGpuWindow_SetAdaptiveFramePacing( ksGpuWindow * window, const bool enable );
 
 ================================================================================================================================
 */
@@ -932,6 +956,9 @@ typedef struct {
     bool windowExit;
     ksGpuWindowInput input;
     ksNanoseconds lastSwapTime;
+    ksNanoseconds lastSwapDuration;  // How long the last swap blocked
+    bool adaptiveFramePacing;
+    ksNanoseconds adaptiveSwapDelay;  // How long before the next swap ksGpuWindow_DelayBeforeSwap() returns
 
 #if defined(OS_WINDOWS)
     HINSTANCE hInstance;
@@ -1002,6 +1029,57 @@ void ksGpuWindow_SwapInterval(ksGpuWindow *window, const int swapInterval);
 void ksGpuWindow_SwapBuffers(ksGpuWindow *window);
 ksNanoseconds ksGpuWindow_GetNextSwapTimeNanoseconds(ksGpuWindow *window);
 ksNanoseconds ksGpuWindow_GetFrameTimeNanoseconds(ksGpuWindow *window);
+void ksGpuWindow_DelayBeforeSwap(ksGpuWindow *window, const ksNanoseconds delay);
+void ksGpuWindow_SetAdaptiveFramePacing(ksGpuWindow *window, const bool enable);
+
+/*
+================================================================================================================================
+
+GPU ring buffer.
+
+A ring buffer streams data that is rewritten every frame, or every view, such as per-instance transforms.
+It is split into segments of a fixed size that are handed out in turn. When persistently mapped buffers are available
+(OpenGL 4.4, GL_ARB_buffer_storage or GL_EXT_buffer_storage), the buffer is mapped once, coherently, and written in place.
+Each segment is fenced once the commands reading it have been issued, and handing it out again waits on that fence,
+which with enough segments has normally long been signaled.
+Without persistent mapping, or if mapping fails, there is a single segment that is written to client memory and uploaded
+to freshly orphaned storage, so the driver need not wait for draws still reading the old contents.
+
+ksGpuRingBuffer_MapSegment() returns where to write the next segment and its offset in the buffer, and leaves the buffer
+bound to its target. ksGpuRingBuffer_UnmapSegment() then makes the first size bytes written visible to the GPU, and
+ksGpuRingBuffer_FenceSegment() is called after the last command that reads the segment.
+
+ksGpuRingBuffer
+
+static void ksGpuRingBuffer_Create( ksGpuContext * context, ksGpuRingBuffer * buffer, const GLenum target,
+                                                const size_t segmentSize, const int segmentCount );
+static void ksGpuRingBuffer_Destroy( ksGpuContext * context, ksGpuRingBuffer * buffer );
+static void * ksGpuRingBuffer_MapSegment( ksGpuRingBuffer * buffer, size_t * offset );
+static void ksGpuRingBuffer_UnmapSegment( ksGpuRingBuffer * buffer, const size_t size );
+static void ksGpuRingBuffer_FenceSegment( ksGpuRingBuffer * buffer );
+
+================================================================================================================================
+*/
+
+#define KS_GPU_RING_BUFFER_MAX_SEGMENTS 8
+
+typedef struct {
+    GLenum target;
+    GLuint buffer;
+    size_t segmentSize;
+    int segmentCount;
+    int segment;                                     // The segment last handed out
+    unsigned char *mapped;                           // The persistent mapping, or NULL when orphaning instead
+    unsigned char *staging;                          // Client memory for the single segment when not mapped
+    GLsync fences[KS_GPU_RING_BUFFER_MAX_SEGMENTS];  // Signaled once the GPU is done reading each segment
+} ksGpuRingBuffer;
+
+void ksGpuRingBuffer_Create(ksGpuContext *context, ksGpuRingBuffer *buffer, const GLenum target, const size_t segmentSize,
+                            const int segmentCount);
+void ksGpuRingBuffer_Destroy(ksGpuContext *context, ksGpuRingBuffer *buffer);
+void *ksGpuRingBuffer_MapSegment(ksGpuRingBuffer *buffer, size_t *offset);
+void ksGpuRingBuffer_UnmapSegment(ksGpuRingBuffer *buffer, const size_t size);
+void ksGpuRingBuffer_FenceSegment(ksGpuRingBuffer *buffer);
 
 /*
 ================================================================================================================================
@@ -1010,7 +1088,11 @@ GPU timer.
 
 A timer is used to measure the amount of time it takes to complete GPU commands.
 For optimal performance a timer should only be created at load time, not at runtime.
-To avoid synchronization, ksGpuTimer_GetNanoseconds() reports the time from KS_GPU_TIMER_FRAMES_DELAYED frames ago.
+The queries of the last KS_GPU_TIMER_FRAMES_IN_FLIGHT timed frames are kept in a ring. To avoid synchronization, each
+ksGpuTimer_Begin() polls the outstanding queries, oldest first, and only reads back those the GPU has finished with.
+ksGpuTimer_GetNanoseconds() then reports the most recent frame read back, and ksGpuTimer_GetFramesDelayed() how many
+timed frames ago that was, counting from the last one ended, or -1 before the first result. If the GPU falls a whole ring behind,
+the oldest frame goes unmeasured rather than being waited for.
 Timer queries are allowed to overlap and can be nested.
 Timer queries that are issued inside a render pass may not produce accurate times on tiling GPUs.
 
@@ -1018,23 +1100,71 @@ ksGpuTimer
 
 static void ksGpuTimer_Create( ksGpuContext * context, ksGpuTimer * timer );
 static void ksGpuTimer_Destroy( ksGpuContext * context, ksGpuTimer * timer );
+static void ksGpuTimer_Begin( ksGpuTimer * timer );
+static void ksGpuTimer_End( ksGpuTimer * timer );
 static ksNanoseconds ksGpuTimer_GetNanoseconds( ksGpuTimer * timer );
+static int ksGpuTimer_GetFramesDelayed( ksGpuTimer * timer );
 
 ================================================================================================================================
 */
 
-#define KS_GPU_TIMER_FRAMES_DELAYED 2
+#define KS_GPU_TIMER_FRAMES_IN_FLIGHT 4
 
 typedef struct {
-    GLuint beginQueries[KS_GPU_TIMER_FRAMES_DELAYED];
-    GLuint endQueries[KS_GPU_TIMER_FRAMES_DELAYED];
-    int queryIndex;
+    GLuint beginQueries[KS_GPU_TIMER_FRAMES_IN_FLIGHT];
+    GLuint endQueries[KS_GPU_TIMER_FRAMES_IN_FLIGHT];
+    int queryIndex;   // Frames issued
+    int resultIndex;  // Frames read back or dropped; those from here up to queryIndex are outstanding
     ksNanoseconds gpuTime;
+    int gpuTimeFrame;  // The frame gpuTime was measured for, or -1 before the first result
+    ksNanoseconds cpuBeginTime;
 } ksGpuTimer;
 
 void ksGpuTimer_Create(ksGpuContext *context, ksGpuTimer *timer);
 void ksGpuTimer_Destroy(ksGpuContext *context, ksGpuTimer *timer);
+void ksGpuTimer_Begin(ksGpuTimer *timer);
+void ksGpuTimer_End(ksGpuTimer *timer);
 ksNanoseconds ksGpuTimer_GetNanoseconds(ksGpuTimer *timer);
+int ksGpuTimer_GetFramesDelayed(ksGpuTimer *timer);
+
+/*
+================================================================================================================================
+
+Frame records.
+
+Every frame timed with a ksGpuTimer is recorded in a ring of the last KS_FRAME_RECORD_COUNT frames: when it began, its CPU
+time, its GPU time once that has been read back, the GL calls counted while it was the current frame, and when the window
+buffers were swapped. Recording is a handful of stores per frame and is always on, so the recent frames can be exported at
+any point without a log having been opened beforehand. Frames are expected to be timed on one thread at a time.
+
+The calls counted are those gfxwrapper makes itself plus any the application reports with ksFrameLog_CountCalls().
+
+ksFrameLog_ExportRecords() writes the frames recorded so far, oldest first, as a Chrome trace (chrome://tracing) when the
+file name ends in ".json" and as CSV otherwise.
+
+ksFrameRecord
+
+static void ksFrameLog_CountCalls( const int callCount );
+static int ksFrameLog_GetRecords( ksFrameRecord * records, const int maxRecords );
+static bool ksFrameLog_ExportRecords( const char * fileName );
+
+================================================================================================================================
+*/
+
+#define KS_FRAME_RECORD_COUNT 1024
+
+typedef struct {
+    int frame;                 // Counted from the first frame recorded
+    ksNanoseconds beginTime;   // When the frame began
+    ksNanoseconds cpuTime;     // From the frame's begin to its end
+    ksNanoseconds gpuTime;     // Zero until read back, and without timer queries
+    ksNanoseconds swapTime;    // The last ksGpuWindow_SwapBuffers() since the frame began, or zero
+    int callCount;
+} ksFrameRecord;
+
+void ksFrameLog_CountCalls(const int callCount);
+int ksFrameLog_GetRecords(ksFrameRecord *records, const int maxRecords);
+bool ksFrameLog_ExportRecords(const char *fileName);
 
 #ifdef __cplusplus
 }
@@ -29,11 +29,22 @@
 #include <sstream>
 #include <iomanip>
 
+size_t Uint64ToHexString(uint64_t val, char (&buffer)[kUint64HexStringSize]) {
+    static const char digits[] = "0123456789abcdef";
+    buffer[0] = '0';
+    buffer[1] = 'x';
+    for (size_t digit = kUint64HexStringSize - 2; digit >= 2; --digit) {
+        buffer[digit] = digits[val & 0xf];
+        val >>= 4;
+    }
+    buffer[kUint64HexStringSize - 1] = '\0';
+    return kUint64HexStringSize - 1;
+}
+
 std::string Uint64ToHexString(uint64_t val) {
-    std::ostringstream oss;
-    oss << "0x";
-    oss << std::hex << std::setw(16) << std::setfill('0') << val;
-    return oss.str();
+    char buffer[kUint64HexStringSize];
+    size_t length = Uint64ToHexString(val, buffer);
+    return std::string(buffer, length);
 }
 
 std::string Uint32ToHexString(uint32_t val) {
@@ -33,6 +33,7 @@
 #include <openxr/openxr.h>
 
 #include <string>
+#include <stddef.h>
 #include <stdint.h>
 
 #if XR_PTR_SIZE == 8
@@ -79,6 +80,14 @@ static inline bool IsIntegerNullHandle(uint64_t handle) { return XR_NULL_HANDLE
 
 #endif
 
+/// The size of the buffer the non-allocating Uint64ToHexString fills in: "0x", 16 digits and the terminating null.
+static const size_t kUint64HexStringSize = 19;
+
+/// Writes a uint64_t formatted as hex, the same way as the std::string version, into a buffer without allocating.
+///
+/// Returns the number of characters written, not counting the terminating null.
+size_t Uint64ToHexString(uint64_t val, char (&buffer)[kUint64HexStringSize]);
+
 /// Turns a uint64_t into a string formatted as hex.
 ///
 /// The core of the HandleToHexString implementation is in here.
@@ -0,0 +1,69 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+// Copyright (c) 2019 Collabora, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*!
+ * @file
+ *
+ * Implementation of the interned string table.
+ */
+
+#include "interned_strings.h"
+
+#include <string>
+#include <utility>
+
+const InternedStringTable::Id InternedStringTable::kEmptyId;
+
+InternedStringTable::InternedStringTable() {
+    auto inserted = ids_.emplace(std::string(), kEmptyId);
+    entries_.push_back(Entry{&inserted.first->first, 0});
+}
+
+InternedStringTable::Id InternedStringTable::Acquire(const std::string& text) {
+    auto found = ids_.find(text);
+    if (found != ids_.end()) {
+        if (found->second != kEmptyId) {
+            ++entries_[found->second].references;
+        }
+        return found->second;
+    }
+
+    Id id;
+    if (!free_ids_.empty()) {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+    } else {
+        id = static_cast<Id>(entries_.size());
+        entries_.push_back(Entry{nullptr, 0});
+    }
+    auto inserted = ids_.emplace(text, id);
+    entries_[id] = Entry{&inserted.first->first, 1};
+    return id;
+}
+
+void InternedStringTable::Release(Id id) {
+    if (id == kEmptyId || id >= entries_.size() || entries_[id].text == nullptr) {
+        return;
+    }
+    Entry& entry = entries_[id];
+    if (--entry.references == 0) {
+        ids_.erase(ids_.find(*entry.text));
+        entry.text = nullptr;
+        free_ids_.push_back(id);
+    }
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+// Copyright (c) 2019 Collabora, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*!
+ * @file
+ *
+ * A table of interned strings, used for the object names and session labels of XR_EXT_debug_utils.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Holds one copy of each distinct string it is given, reference counted, and identifies each by a small integer id.
+///
+/// Two strings in the same table are equal exactly when their ids are, and the text of a string stays at the same address
+/// until its last reference is released, so callers can keep and hand out the c string instead of a copy.  Not
+/// thread-safe: lock around it as you would around whatever owns it.
+class InternedStringTable {
+   public:
+    using Id = uint32_t;
+
+    //! The id of the empty string, which is always present and needs no references.
+    static const Id kEmptyId = 0;
+
+    InternedStringTable();
+
+    InternedStringTable(const InternedStringTable&) = delete;
+    InternedStringTable& operator=(const InternedStringTable&) = delete;
+
+    //! Add a reference to the given string, storing it if it is not already held, and return its id.
+    Id Acquire(const std::string& text);
+
+    //! @overload
+    //! A null pointer is treated as the empty string.
+    Id Acquire(const char* text) { return text == nullptr || *text == '\0' ? kEmptyId : Acquire(std::string(text)); }
+
+    //! Drop a reference taken with Acquire, freeing the string once the last one is gone.
+    void Release(Id id);
+
+    //! The text of a string that is held.
+    const std::string& Get(Id id) const { return *entries_[id].text; }
+
+    //! The text of a string that is held, as a c string that stays valid until the string is freed.
+    const char* CStr(Id id) const { return entries_[id].text->c_str(); }
+
+    //! How many distinct strings are held, not counting the empty string.
+    size_t Size() const { return ids_.size() - 1; }
+
+   private:
+    struct Entry {
+        //! Points at the key in ids_, whose address does not change; nullptr if this id is free
+        const std::string* text;
+        uint32_t references;
+    };
+
+    std::unordered_map<std::string, Id> ids_;
+    std::vector<Entry> entries_;
+    std::vector<Id> free_ids_;
+};
@@ -89,6 +89,14 @@ typedef XrResult(XRAPI_PTR *PFN_xrNegotiateLoaderApiLayerInterface)(const XrNego
                                                                     const char *apiLayerName,
                                                                     XrNegotiateApiLayerRequest *apiLayerRequest);
 
+// Optional function an API layer can export next to its negotiation function (under this name, or a renamed one given in
+// the manifest file), listing the commands its getInstanceProcAddr returns its own functions for.  The loader asks for it
+// right after negotiation, using the usual two-call idiom; the strings must stay valid for as long as the library is
+// loaded.  A layer that lists its commands only ever sees the commands it listed, plus xrGetInstanceProcAddr,
+// xrCreateApiLayerInstance and xrDestroyInstance, since the loader sends everything else straight past it.
+typedef XrResult(XRAPI_PTR *PFN_xrEnumerateApiLayerInterceptedCommands)(const char *apiLayerName, uint32_t commandCapacityInput,
+                                                                       uint32_t *commandCountOutput, const char **commands);
+
 // Function used to negotiate an interface betewen the loader and a runtime.  Each runtime should expose
 // at least this function.
 typedef XrResult(XRAPI_PTR *PFN_xrNegotiateLoaderRuntimeInterface)(const XrNegotiateLoaderInfo *loaderInfo,
@@ -0,0 +1,80 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+// Copyright (c) 2019 Collabora, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+/*!
+ * @file
+ *
+ * Layout of the shared-memory ring the loader publishes its messages to when XR_LOADER_SHARED_LOG is set, shared by
+ * the loader and by readers such as src/tests/list/loader_log_viewer.cpp.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_WIN32)
+#define XR_LOADER_SHARED_LOG_NAME_PREFIX "Local\\"
+#else
+#define XR_LOADER_SHARED_LOG_NAME_PREFIX "/"
+#endif
+
+/// The loader is the only writer and a single viewer the only reader.  Positions count bytes ever written and read, so
+/// the ring is empty when they are equal and the writer has capacity - (write_position - read_position) bytes free.
+/// Records start on 8 byte boundaries; one that would not fit before the end of the ring is preceded by a record of
+/// size 0, meaning "continue at the start".  The writer publishes records by storing write_position with release
+/// ordering, and the reader frees them the same way through read_position.  Messages that do not fit are dropped and
+/// counted, so the writer never waits for the reader.
+struct XrLoaderSharedLogHeader {
+    static const uint32_t kMagic = 0x534c5258;  // "XRLS"
+    static const uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    //! Bytes of record space after the header, a power of two
+    uint32_t capacity;
+    uint32_t process_id;
+    //! Set once the writer has gone away and will write no more
+    std::atomic<uint32_t> closed;
+
+    alignas(64) std::atomic<uint64_t> write_position;
+    alignas(64) std::atomic<uint64_t> read_position;
+    alignas(64) std::atomic<uint64_t> dropped;
+};
+
+struct XrLoaderSharedLogRecord {
+    //! Size of the record including this header and padding, or 0 to skip to the start of the ring
+    uint32_t size;
+    uint32_t text_length;
+    //! System clock time the message was logged, in nanoseconds since the epoch
+    int64_t timestamp;
+    //! 0 verbose, 1 info, 2 warning, 3 error
+    uint8_t severity;
+    uint8_t type;
+    uint8_t reserved[6];
+    // Followed by text_length bytes of text, formatted as the standard output logger prints it
+};
+
+static inline size_t XrLoaderSharedLogRecordSize(size_t text_length) {
+    return (sizeof(XrLoaderSharedLogRecord) + text_length + 7) & ~static_cast<size_t>(7);
+}
+
+//! The name the shared memory is created under for the given XR_LOADER_SHARED_LOG value.
+static inline std::string XrLoaderSharedLogObjectName(const std::string& name) { return XR_LOADER_SHARED_LOG_NAME_PREFIX + name; }
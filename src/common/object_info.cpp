@@ -20,7 +20,6 @@
 
 #include "object_info.h"
 
-#include "extra_algorithms.h"
 #include "hex_and_handles.h"
 
 #include <openxr/openxr.h>
@@ -41,6 +40,12 @@ std::string XrSdkLogObjectInfo::ToString() const {
     return oss.str();
 }
 
+ObjectInfoCollection::~ObjectInfoCollection() {
+    for (auto const& object_name : object_names_) {
+        strings_.Release(object_name.second);
+    }
+}
+
 void ObjectInfoCollection::AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name) {
     // If name is empty, we should erase it
     if (object_name.empty()) {
@@ -48,57 +53,44 @@ void ObjectInfoCollection::AddObjectName(uint64_t object_handle, XrObjectType ob
         return;
     }
 
-    // Otherwise, add it or update the name
-    XrSdkLogObjectInfo new_obj = {object_handle, object_type};
-
-    // If it already exists, update the name
-    auto lookup_info = LookUpStoredObjectInfo(new_obj);
-    if (lookup_info != nullptr) {
-        lookup_info->name = object_name;
-        return;
+    // Otherwise, add it or update the name.  Take the new name before letting go of the old one, in case they are the same.
+    const InternedStringTable::Id name_id = strings_.Acquire(object_name);
+    auto inserted = object_names_.emplace(ObjectKey{object_handle, object_type}, name_id);
+    if (!inserted.second) {
+        strings_.Release(inserted.first->second);
+        inserted.first->second = name_id;
     }
-
-    // It doesn't exist, so add a new info block
-    new_obj.name = object_name;
-    object_info_.push_back(new_obj);
 }
 
 void ObjectInfoCollection::RemoveObject(uint64_t object_handle, XrObjectType object_type) {
-    vector_remove_if_and_erase(
-        object_info_, [=](XrSdkLogObjectInfo const& info) { return info.handle == object_handle && info.type == object_type; });
-}
-
-XrSdkLogObjectInfo const* ObjectInfoCollection::LookUpStoredObjectInfo(XrSdkLogObjectInfo const& info) const {
-    auto e = object_info_.end();
-    auto it = std::find_if(object_info_.begin(), e, [&](XrSdkLogObjectInfo const& stored) { return Equivalent(stored, info); });
-    if (it != e) {
-        return &(*it);
+    auto it = object_names_.find(ObjectKey{object_handle, object_type});
+    if (it != object_names_.end()) {
+        strings_.Release(it->second);
+        object_names_.erase(it);
     }
-    return nullptr;
 }
 
-XrSdkLogObjectInfo* ObjectInfoCollection::LookUpStoredObjectInfo(XrSdkLogObjectInfo const& info) {
-    auto e = object_info_.end();
-    auto it = std::find_if(object_info_.begin(), e, [&](XrSdkLogObjectInfo const& stored) { return Equivalent(stored, info); });
-    if (it != e) {
-        return &(*it);
+const char* ObjectInfoCollection::LookUpStoredName(uint64_t handle, XrObjectType type) const {
+    auto it = object_names_.find(ObjectKey{handle, type});
+    if (it != object_names_.end()) {
+        return strings_.CStr(it->second);
     }
     return nullptr;
 }
 
 bool ObjectInfoCollection::LookUpObjectName(XrDebugUtilsObjectNameInfoEXT& info) const {
-    auto info_lookup = LookUpStoredObjectInfo(info.objectHandle, info.objectType);
-    if (info_lookup != nullptr) {
-        info.objectName = info_lookup->name.c_str();
+    const char* name = LookUpStoredName(info.objectHandle, info.objectType);
+    if (name != nullptr) {
+        info.objectName = name;
         return true;
     }
     return false;
 }
 
 bool ObjectInfoCollection::LookUpObjectName(XrSdkLogObjectInfo& info) const {
-    auto info_lookup = LookUpStoredObjectInfo(info);
-    if (info_lookup != nullptr) {
-        info.name = info_lookup->name;
+    auto it = object_names_.find(ObjectKey{info.handle, info.type});
+    if (it != object_names_.end()) {
+        info.name = strings_.Get(it->second);
         return true;
     }
     return false;
@@ -120,110 +112,154 @@ NamesAndLabels::NamesAndLabels(std::vector<XrSdkLogObjectInfo> obj, std::vector<
 void NamesAndLabels::PopulateCallbackData(XrDebugUtilsMessengerCallbackDataEXT& callback_data) const {
     callback_data.objects = objects.empty() ? nullptr : const_cast<XrDebugUtilsObjectNameInfoEXT*>(objects.data());
     callback_data.objectCount = static_cast<uint32_t>(objects.size());
-    callback_data.sessionLabels = labels.empty() ? nullptr : const_cast<XrDebugUtilsLabelEXT*>(labels.data());
-    callback_data.sessionLabelCount = static_cast<uint32_t>(labels.size());
+    callback_data.sessionLabels = LabelCount() == 0 ? nullptr : const_cast<XrDebugUtilsLabelEXT*>(Labels());
+    callback_data.sessionLabelCount = LabelCount();
 }
 
-void DebugUtilsData::LookUpSessionLabels(XrSession session, std::vector<XrDebugUtilsLabelEXT>& labels) const {
-    auto session_label_iterator = session_labels_.find(session);
-    if (session_label_iterator != session_labels_.end()) {
-        auto& XrSdkSessionLabels = *session_label_iterator->second;
-        // Copy the debug utils labels in reverse order in the the labels vector.
-        std::transform(XrSdkSessionLabels.rbegin(), XrSdkSessionLabels.rend(), std::back_inserter(labels),
-                       [](XrSdkSessionLabelPtr const& label) { return label->debug_utils_label; });
+void XrSdkSessionLabelStack::Push(InternedStringTable& strings, const XrDebugUtilsLabelEXT& label_info, bool individual) {
+    const InternedStringTable::Id name_id = strings.Acquire(label_info.labelName);
+    XrDebugUtilsLabelEXT label = label_info;
+    // Point the c string at the one we hold.
+    label.labelName = strings.CStr(name_id);
+    labels.insert(labels.begin(), label);
+    label_ids.insert(label_ids.begin(), name_id);
+    has_individual_label = individual;
+}
+
+void XrSdkSessionLabelStack::PopFront(InternedStringTable& strings) {
+    strings.Release(label_ids.front());
+    label_ids.erase(label_ids.begin());
+    labels.erase(labels.begin());
+}
+
+// We always want to remove the old individual label before we do anything else.
+// So, do that in it's own method
+void XrSdkSessionLabelStack::RemoveIndividualLabel(InternedStringTable& strings) {
+    if (has_individual_label && !labels.empty()) {
+        PopFront(strings);
     }
+    has_individual_label = false;
 }
 
-XrSdkSessionLabel::XrSdkSessionLabel(const XrDebugUtilsLabelEXT& label_info, bool individual)
-    : label_name(label_info.labelName), debug_utils_label(label_info), is_individual_label(individual) {
-    // Update the c string pointer to the one we hold.
-    debug_utils_label.labelName = label_name.c_str();
+void XrSdkSessionLabelStack::PopRegion(InternedStringTable& strings) {
+    // Individual labels do not stay around in the transition out of label region
+    RemoveIndividualLabel(strings);
+
+    // Remove the last label region
+    if (!labels.empty()) {
+        PopFront(strings);
+    }
 }
 
-XrSdkSessionLabelPtr XrSdkSessionLabel::make(const XrDebugUtilsLabelEXT& label_info, bool individual) {
-    XrSdkSessionLabelPtr ret(new XrSdkSessionLabel(label_info, individual));
-    return ret;
+void XrSdkSessionLabelStack::Clear(InternedStringTable& strings) {
+    for (InternedStringTable::Id name_id : label_ids) {
+        strings.Release(name_id);
+    }
+    label_ids.clear();
+    labels.clear();
+    has_individual_label = false;
 }
-void DebugUtilsData::AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name) {
-    object_info_.AddObjectName(object_handle, object_type, object_name);
+
+DebugUtilsData::~DebugUtilsData() {
+    for (auto& session_label_stack : session_labels_) {
+        session_label_stack.second.Clear(strings_);
+    }
 }
 
-// We always want to remove the old individual label before we do anything else.
-// So, do that in it's own method
-void DebugUtilsData::RemoveIndividualLabel(XrSdkSessionLabelList& label_vec) {
-    if (!label_vec.empty() && label_vec.back()->is_individual_label) {
-        label_vec.pop_back();
+void DebugUtilsData::LookUpSessionLabels(XrSession session, std::vector<XrDebugUtilsLabelEXT>& labels) const {
+    XrSdkSessionLabelStack const* stack = GetSessionLabelStack(session);
+    if (stack != nullptr) {
+        // The stack is already in reverse order
+        labels.insert(labels.end(), stack->labels.begin(), stack->labels.end());
+    }
+}
+
+void DebugUtilsData::CollectSessionLabels(XrSession session, const XrDebugUtilsLabelEXT*& view, uint32_t& view_count,
+                                          std::vector<XrDebugUtilsLabelEXT>& labels) const {
+    XrSdkSessionLabelStack const* stack = GetSessionLabelStack(session);
+    if (stack == nullptr || stack->labels.empty()) {
+        return;
+    }
+    if (view == nullptr && labels.empty()) {
+        view = stack->labels.data();
+        view_count = static_cast<uint32_t>(stack->labels.size());
+        return;
+    }
+    if (view != nullptr) {
+        labels.assign(view, view + view_count);
+        view = nullptr;
+        view_count = 0;
     }
+    labels.insert(labels.end(), stack->labels.begin(), stack->labels.end());
+}
+
+void DebugUtilsData::AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name) {
+    object_info_.AddObjectName(object_handle, object_type, object_name);
 }
 
-XrSdkSessionLabelList* DebugUtilsData::GetSessionLabelList(XrSession session) {
+XrSdkSessionLabelStack* DebugUtilsData::GetSessionLabelStack(XrSession session) {
     auto session_label_iterator = session_labels_.find(session);
     if (session_label_iterator == session_labels_.end()) {
         return nullptr;
     }
-    return session_label_iterator->second.get();
+    return &session_label_iterator->second;
 }
 
-XrSdkSessionLabelList& DebugUtilsData::GetOrCreateSessionLabelList(XrSession session) {
-    XrSdkSessionLabelList* vec_ptr = GetSessionLabelList(session);
-    if (vec_ptr == nullptr) {
-        std::unique_ptr<XrSdkSessionLabelList> vec(new XrSdkSessionLabelList);
-        vec_ptr = vec.get();
-        session_labels_[session] = std::move(vec);
+XrSdkSessionLabelStack const* DebugUtilsData::GetSessionLabelStack(XrSession session) const {
+    auto session_label_iterator = session_labels_.find(session);
+    if (session_label_iterator == session_labels_.end()) {
+        return nullptr;
     }
-    return *vec_ptr;
+    return &session_label_iterator->second;
 }
 
 void DebugUtilsData::BeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT& label_info) {
-    auto& vec = GetOrCreateSessionLabelList(session);
+    auto& stack = session_labels_[session];
 
     // Individual labels do not stay around in the transition into a new label region
-    RemoveIndividualLabel(vec);
+    stack.RemoveIndividualLabel(strings_);
 
     // Start the new label region
-    vec.emplace_back(XrSdkSessionLabel::make(label_info, false));
+    stack.Push(strings_, label_info, false);
 }
 
 void DebugUtilsData::EndLabelRegion(XrSession session) {
-    XrSdkSessionLabelList* vec_ptr = GetSessionLabelList(session);
-    if (vec_ptr == nullptr) {
+    XrSdkSessionLabelStack* stack = GetSessionLabelStack(session);
+    if (stack == nullptr) {
         return;
     }
-
-    // Individual labels do not stay around in the transition out of label region
-    RemoveIndividualLabel(*vec_ptr);
-
-    // Remove the last label region
-    if (!vec_ptr->empty()) {
-        vec_ptr->pop_back();
-    }
+    stack->PopRegion(strings_);
 }
 
 void DebugUtilsData::InsertLabel(XrSession session, const XrDebugUtilsLabelEXT& label_info) {
-    auto& vec = GetOrCreateSessionLabelList(session);
+    auto& stack = session_labels_[session];
 
     // Remove any individual layer that might already be there
-    RemoveIndividualLabel(vec);
+    stack.RemoveIndividualLabel(strings_);
 
     // Insert a new individual label
-    vec.emplace_back(XrSdkSessionLabel::make(label_info, true));
+    stack.Push(strings_, label_info, true);
 }
 
 void DebugUtilsData::DeleteObject(uint64_t object_handle, XrObjectType object_type) {
     object_info_.RemoveObject(object_handle, object_type);
 
     if (object_type == XR_OBJECT_TYPE_SESSION) {
-        auto session = TreatIntegerAsHandle<XrSession>(object_handle);
-        XrSdkSessionLabelList* vec_ptr = GetSessionLabelList(session);
-        if (vec_ptr != nullptr) {
-            session_labels_.erase(session);
-        }
+        DeleteSessionLabels(TreatIntegerAsHandle<XrSession>(object_handle));
     }
 }
 
-void DebugUtilsData::DeleteSessionLabels(XrSession session) { session_labels_.erase(session); }
+void DebugUtilsData::DeleteSessionLabels(XrSession session) {
+    auto session_label_iterator = session_labels_.find(session);
+    if (session_label_iterator != session_labels_.end()) {
+        session_label_iterator->second.Clear(strings_);
+        session_labels_.erase(session_label_iterator);
+    }
+}
 
 NamesAndLabels DebugUtilsData::PopulateNamesAndLabels(std::vector<XrSdkLogObjectInfo> objects) const {
+    const XrDebugUtilsLabelEXT* label_view = nullptr;
+    uint32_t label_view_count = 0;
     std::vector<XrDebugUtilsLabelEXT> labels;
     for (auto& obj : objects) {
         // Check for any names that have been associated with the objects and set them up here
@@ -231,51 +267,63 @@ NamesAndLabels DebugUtilsData::PopulateNamesAndLabels(std::vector<XrSdkLogObject
         // If this is a session, see if there are any labels associated with it for us to add
         // to the callback content.
         if (XR_OBJECT_TYPE_SESSION == obj.type) {
-            LookUpSessionLabels(obj.GetTypedHandle<XrSession>(), labels);
+            CollectSessionLabels(obj.GetTypedHandle<XrSession>(), label_view, label_view_count, labels);
         }
     }
 
-    return {objects, labels};
+    NamesAndLabels ret{std::move(objects), std::move(labels)};
+    ret.label_view = label_view;
+    ret.label_view_count = label_view_count;
+    return ret;
 }
 
-AugmentedCallbackData DebugUtilsData::AugmentCallbackData(
-    const XrDebugUtilsMessengerCallbackDataEXT& provided_callback_data) const {
-    AugmentedCallbackData ret{provided_callback_data};
+const uint32_t AugmentedCallbackData::kInlineObjectCount;
+
+void DebugUtilsData::AugmentCallbackData(AugmentedCallbackData& augmented) const {
+    const XrDebugUtilsMessengerCallbackDataEXT& provided_callback_data = *augmented.callback_data_to_use;
     if (object_info_.Empty() || provided_callback_data.objectCount == 0) {
-        return ret;
+        return;
     }
+    const XrDebugUtilsLabelEXT* label_view = nullptr;
+    uint32_t label_view_count = 0;
     bool obj_name_found = false;
     for (uint32_t obj = 0; obj < provided_callback_data.objectCount; ++obj) {
         auto& current_obj = provided_callback_data.objects[obj];
-        if (!obj_name_found) {
-            auto lookup = object_info_.LookUpStoredObjectInfo(current_obj.objectHandle, current_obj.objectType);
-            if (lookup != nullptr) {
-                obj_name_found = true;
-            }
+        if (!obj_name_found && object_info_.LookUpStoredName(current_obj.objectHandle, current_obj.objectType) != nullptr) {
+            obj_name_found = true;
         }
 
         // If this is a session, see if there are any labels associated with it for us to add
         // to the callback content.
         if (XR_OBJECT_TYPE_SESSION == current_obj.objectType) {
             XrSession session = TreatIntegerAsHandle<XrSession>(current_obj.objectHandle);
-            LookUpSessionLabels(session, ret.labels);
+            CollectSessionLabels(session, label_view, label_view_count, augmented.labels);
         }
     }
 
-    if (!obj_name_found && ret.labels.empty()) {
+    if (!obj_name_found && label_view == nullptr && augmented.labels.empty()) {
         // nothing to add to the data
-        return ret;
+        return;
     }
 
     // If a name or a label has been found, we should update it in a new version of the callback data
-    ret.new_objects.assign(provided_callback_data.objects, provided_callback_data.objects + provided_callback_data.objectCount);
+    XrDebugUtilsObjectNameInfoEXT* new_objects = augmented.inline_objects;
+    if (provided_callback_data.objectCount > AugmentedCallbackData::kInlineObjectCount) {
+        augmented.new_objects.resize(provided_callback_data.objectCount);
+        new_objects = augmented.new_objects.data();
+    }
+    std::copy(provided_callback_data.objects, provided_callback_data.objects + provided_callback_data.objectCount, new_objects);
+    for (uint32_t obj = 0; obj < provided_callback_data.objectCount; ++obj) {
+        object_info_.LookUpObjectName(new_objects[obj]);
+    }
 
-    for (auto& obj : ret.new_objects) {
-        object_info_.LookUpObjectName(obj);
+    augmented.temporary_callback_data.objects = new_objects;
+    if (label_view != nullptr) {
+        augmented.temporary_callback_data.sessionLabelCount = label_view_count;
+        augmented.temporary_callback_data.sessionLabels = const_cast<XrDebugUtilsLabelEXT*>(label_view);
+    } else {
+        augmented.temporary_callback_data.sessionLabelCount = static_cast<uint32_t>(augmented.labels.size());
+        augmented.temporary_callback_data.sessionLabels = augmented.labels.empty() ? nullptr : augmented.labels.data();
     }
-    ret.temporary_callback_data.objects = ret.new_objects.data();
-    ret.temporary_callback_data.sessionLabelCount = static_cast<uint32_t>(ret.labels.size());
-    ret.temporary_callback_data.sessionLabels = ret.labels.empty() ? nullptr : ret.labels.data();
-    ret.callback_data_to_use = &ret.temporary_callback_data;
-    return ret;
+    augmented.callback_data_to_use = &augmented.temporary_callback_data;
 }
@@ -26,9 +26,13 @@
 #pragma once
 
 #include "hex_and_handles.h"
+#include "interned_strings.h"
 
 #include <openxr/openxr.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -114,25 +118,24 @@ static inline bool Equivalent(XrDebugUtilsObjectNameInfoEXT const& a, XrSdkLogOb
 static inline bool Equivalent(XrSdkLogObjectInfo const& a, XrDebugUtilsObjectNameInfoEXT const& b) { return Equivalent(b, a); }
 
 /// Object info registered with calls to xrSetDebugUtilsObjectNameEXT
+///
+/// Names are held in an InternedStringTable, which may be shared with other users such as session labels, so each distinct
+/// name is stored once.  A name handed out by LookUpObjectName stays valid until its object is renamed or removed.
 class ObjectInfoCollection {
    public:
-    void AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name);
+    explicit ObjectInfoCollection(InternedStringTable& strings) : strings_(strings) {}
+    ~ObjectInfoCollection();
 
-    void RemoveObject(uint64_t object_handle, XrObjectType object_type);
+    ObjectInfoCollection(const ObjectInfoCollection&) = delete;
+    ObjectInfoCollection& operator=(const ObjectInfoCollection&) = delete;
 
-    //! Find the stored object info, if any, matching handle and type.
-    //! Return nullptr if not found.
-    XrSdkLogObjectInfo const* LookUpStoredObjectInfo(XrSdkLogObjectInfo const& info) const;
+    void AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name);
 
-    //! Find the stored object info, if any, matching handle and type.
-    //! Return nullptr if not found.
-    XrSdkLogObjectInfo* LookUpStoredObjectInfo(XrSdkLogObjectInfo const& info);
+    void RemoveObject(uint64_t object_handle, XrObjectType object_type);
 
-    //! Find the stored object info, if any.
-    //! Return nullptr if not found.
-    XrSdkLogObjectInfo const* LookUpStoredObjectInfo(uint64_t handle, XrObjectType type) const {
-        return LookUpStoredObjectInfo({handle, type});
-    }
+    //! Find the name stored for the object matching handle and type.
+    //! Return nullptr if it has none.
+    const char* LookUpStoredName(uint64_t handle, XrObjectType type) const;
 
     //! Find the object name, if any, and update debug utils info accordingly.
     //! Return true if found and updated.
@@ -143,26 +146,55 @@ class ObjectInfoCollection {
     bool LookUpObjectName(XrSdkLogObjectInfo& info) const;
 
     //! Is the collection empty?
-    bool Empty() const { return object_info_.empty(); }
+    bool Empty() const { return object_names_.empty(); }
 
    private:
-    // Object names that have been set for given objects
-    std::vector<XrSdkLogObjectInfo> object_info_;
+    struct ObjectKey {
+        uint64_t handle;
+        XrObjectType type;
+        bool operator==(ObjectKey const& other) const { return handle == other.handle && type == other.type; }
+    };
+    struct ObjectKeyHash {
+        size_t operator()(ObjectKey const& key) const {
+            return std::hash<uint64_t>()(key.handle) ^ (std::hash<uint32_t>()(static_cast<uint32_t>(key.type)) << 1);
+        }
+    };
+
+    InternedStringTable& strings_;
+
+    // Ids of the names that have been set for given objects
+    std::unordered_map<ObjectKey, InternedStringTable::Id, ObjectKeyHash> object_names_;
 };
 
-struct XrSdkSessionLabel;
-using XrSdkSessionLabelPtr = std::unique_ptr<XrSdkSessionLabel>;
-using XrSdkSessionLabelList = std::vector<XrSdkSessionLabelPtr>;
+/// The debug utils labels of one session, most recent first, the order in which they are reported to messengers.
+///
+/// Label names are held in an InternedStringTable, so that beginning and ending the same label regions over and over
+/// (every frame, say) reuses the names already held instead of allocating new ones, and the label vector keeps its
+/// capacity.  The stack does not own the table: release the stack's names with Clear before dropping it.
+struct XrSdkSessionLabelStack {
+    /// Push a label region, or an individual label that lasts until the next label call.
+    void Push(InternedStringTable& strings, const XrDebugUtilsLabelEXT& label_info, bool individual);
+
+    /// Remove the individual label on top of the stack, if there is one.
+    void RemoveIndividualLabel(InternedStringTable& strings);
+
+    /// Remove the most recent label region, and any individual label above it.
+    void PopRegion(InternedStringTable& strings);
+
+    /// Remove every label.
+    void Clear(InternedStringTable& strings);
+
+    /// Labels, most recent first.  Names point into the string table.
+    std::vector<XrDebugUtilsLabelEXT> labels;
 
-struct XrSdkSessionLabel {
-    static XrSdkSessionLabelPtr make(const XrDebugUtilsLabelEXT& label_info, bool individual);
+    /// Ids of the label names, in the same order as labels.
+    std::vector<InternedStringTable::Id> label_ids;
 
-    std::string label_name;
-    XrDebugUtilsLabelEXT debug_utils_label;
-    bool is_individual_label;
+    /// True if labels.front() is an individual label rather than a label region.
+    bool has_individual_label = false;
 
    private:
-    XrSdkSessionLabel(const XrDebugUtilsLabelEXT& label_info, bool individual);
+    void PopFront(InternedStringTable& strings);
 };
 
 /// The metadata for a collection of objects. Must persist unmodified during the entire debug messenger call!
@@ -173,18 +205,42 @@ struct NamesAndLabels {
     std::vector<XrSdkLogObjectInfo> sdk_objects;
 
     std::vector<XrDebugUtilsObjectNameInfoEXT> objects;
+
+    /// Labels copied from more than one session.  Unused when label_view is set.
     std::vector<XrDebugUtilsLabelEXT> labels;
 
+    /// When the labels all come from one session: a view of that session's label stack, so nothing is copied.
+    const XrDebugUtilsLabelEXT* label_view = nullptr;
+    uint32_t label_view_count = 0;
+
+    /// The labels to report, wherever they are held.
+    const XrDebugUtilsLabelEXT* Labels() const { return label_view != nullptr ? label_view : labels.data(); }
+    uint32_t LabelCount() const { return label_view != nullptr ? label_view_count : static_cast<uint32_t>(labels.size()); }
+
     /// Populate the debug utils callback data structure.
     void PopulateCallbackData(XrDebugUtilsMessengerCallbackDataEXT& data) const;
     // XrDebugUtilsMessengerCallbackDataEXT MakeCallbackData() const;
 };
 
+/// Callback data with names and labels filled in by DebugUtilsData::AugmentCallbackData.
+///
+/// Meant to live on the stack for the duration of one message: it has room for the objects of a typical message, and
+/// refers to the session labels in place when they all come from one session, so augmenting a message normally needs no
+/// heap allocation.  Not copyable, since temporary_callback_data may point into it.
 struct AugmentedCallbackData {
     explicit AugmentedCallbackData(const XrDebugUtilsMessengerCallbackDataEXT& data_to_use)
         : temporary_callback_data(data_to_use), callback_data_to_use(&data_to_use) {}
+
+    AugmentedCallbackData(const AugmentedCallbackData&) = delete;
+    AugmentedCallbackData& operator=(const AugmentedCallbackData&) = delete;
+
+    //! Messages with up to this many objects use inline_objects rather than new_objects.
+    static const uint32_t kInlineObjectCount = 8;
+
+    //! Labels copied from more than one session; unused otherwise.
     std::vector<XrDebugUtilsLabelEXT> labels;
     XrDebugUtilsMessengerCallbackDataEXT temporary_callback_data;
+    XrDebugUtilsObjectNameInfoEXT inline_objects[kInlineObjectCount];
     std::vector<XrDebugUtilsObjectNameInfoEXT> new_objects;
 
     const XrDebugUtilsMessengerCallbackDataEXT* callback_data_to_use;
@@ -193,6 +249,7 @@ struct AugmentedCallbackData {
 class DebugUtilsData {
    public:
     DebugUtilsData() = default;
+    ~DebugUtilsData();
 
     DebugUtilsData(const DebugUtilsData&) = delete;
     DebugUtilsData& operator=(const DebugUtilsData&) = delete;
@@ -225,16 +282,25 @@ class DebugUtilsData {
     /// Given the collection of objects, populate their names and list of labels
     NamesAndLabels PopulateNamesAndLabels(std::vector<XrSdkLogObjectInfo> objects) const;
 
-    AugmentedCallbackData AugmentCallbackData(const XrDebugUtilsMessengerCallbackDataEXT& provided_callback_data) const;
+    /// Fill in the names and labels for the callback data the given augmented data was created with.  Afterwards,
+    /// augmented.callback_data_to_use is the data to pass on: the original if there was nothing to add.
+    void AugmentCallbackData(AugmentedCallbackData& augmented) const;
 
    private:
-    void RemoveIndividualLabel(XrSdkSessionLabelList& label_vec);
-    XrSdkSessionLabelList* GetSessionLabelList(XrSession session);
-    XrSdkSessionLabelList& GetOrCreateSessionLabelList(XrSession session);
+    XrSdkSessionLabelStack* GetSessionLabelStack(XrSession session);
+    XrSdkSessionLabelStack const* GetSessionLabelStack(XrSession session) const;
+
+    /// Add the labels of the given session, if any, to those being reported.  The first session's labels are referred to
+    /// in place through view; if a second session also has labels, they are all copied into labels and view is cleared.
+    void CollectSessionLabels(XrSession session, const XrDebugUtilsLabelEXT*& view, uint32_t& view_count,
+                              std::vector<XrDebugUtilsLabelEXT>& labels) const;
+
+    // Object names and label names, each stored once.  Declared first, since the members below refer to it.
+    InternedStringTable strings_;
 
-    // Session labels: one vector of them per session.
-    std::unordered_map<XrSession, std::unique_ptr<XrSdkSessionLabelList>> session_labels_;
+    // Session labels: a stack of them per session.
+    std::unordered_map<XrSession, XrSdkSessionLabelStack> session_labels_;
 
     // Names for objects.
-    ObjectInfoCollection object_info_;
+    ObjectInfoCollection object_info_{strings_};
 };
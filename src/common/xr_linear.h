@@ -42,6 +42,16 @@ DESCRIPTION
 
 All matrices are column-major.
 
+When compiling for x86 with SSE or for ARM with NEON, XrMatrix4x4f_Multiply, XrMatrix4x4f_Invert,
+XrMatrix4x4f_TransformVector3f and XrMatrix4x4f_TransformVector4f work on a column of four floats at a time.
+Define XR_LINEAR_NO_SIMD before including this header to always use the plain C versions.  Multiply and the
+transforms add up the same products in the same order as the plain C versions, so they give bit-identical results,
+unless the compiler fuses the multiplies and adds of the plain C versions (as GCC does by default for AArch64),
+in which case the two can differ in the last bit of each element.  Invert works on 2x2 blocks instead of 3x3 minors,
+and for well-conditioned matrices agrees with the plain C version to within a relative error of about 1e-6.
+The array functions build or multiply four matrices, or cull four bounds, at a time the same way.
+AVX is not used: each column fills a single 128-bit register, and AVX builds get the SSE code in VEX encoding.
+
 INTERFACE
 =========
 
@@ -50,6 +60,9 @@ XrVector3f
 XrVector4f
 XrQuaternionf
 XrMatrix4x4f
+XrMatrix3x4f
+XrPoseScaleArraysf
+XrBoundsArraysf
 
 inline static void XrVector3f_Set(XrVector3f* v, const float value);
 inline static void XrVector3f_Add(XrVector3f* result, const XrVector3f* a, const XrVector3f* b);
@@ -62,6 +75,17 @@ inline static void XrVector3f_Normalize(XrVector3f* v);
 inline static float XrVector3f_Length(const XrVector3f* v);
 
 inline static void XrQuaternionf_Lerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b, const float fraction);
+inline static void XrQuaternionf_Slerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b, const float fraction);
+inline static void XrQuaternionf_FastSlerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b,
+                                           const float fraction);
+inline static void XrQuaternionf_Multiply(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b);
+inline static void XrQuaternionf_Invert(XrQuaternionf* result, const XrQuaternionf* q);
+inline static void XrQuaternionf_RotateVector3f(XrVector3f* result, const XrQuaternionf* q, const XrVector3f* v);
+
+inline static void XrPosef_CreateIdentity(XrPosef* result);
+inline static void XrPosef_Multiply(XrPosef* result, const XrPosef* a, const XrPosef* b);
+inline static void XrPosef_Invert(XrPosef* result, const XrPosef* pose);
+inline static void XrPosef_TransformVector3f(XrVector3f* result, const XrPosef* pose, const XrVector3f* v);
 
 inline static void XrMatrix4x4f_CreateIdentity(XrMatrix4x4f* result);
 inline static void XrMatrix4x4f_CreateTranslation(XrMatrix4x4f* result, const float x, const float y, const float z);
@@ -70,6 +94,12 @@ inline static void XrMatrix4x4f_CreateRotation(XrMatrix4x4f* result, const float
 inline static void XrMatrix4x4f_CreateScale(XrMatrix4x4f* result, const float x, const float y, const float z);
 inline static void XrMatrix4x4f_CreateTranslationRotationScale(XrMatrix4x4f* result, const XrVector3f* translation,
                                                                const XrQuaternionf* rotation, const XrVector3f* scale);
+inline static void XrMatrix4x4f_CreateTranslationRotationScaleArray(XrMatrix4x4f* results, const XrPosef* poses,
+                                                                    const size_t poseStride, const XrVector3f* scales,
+                                                                    const size_t scaleStride, const int count);
+inline static void XrMatrix4x4f_CreateTranslationRotationScaleArraySoA(XrMatrix4x4f* results, const XrPoseScaleArraysf* arrays,
+                                                                       const int count);
+inline static void XrMatrix4x4f_CreateViewFromPose(XrMatrix4x4f* result, const XrPosef* pose);
 inline static void XrMatrix4x4f_CreateProjection(XrMatrix4x4f* result, const float tanAngleLeft, const float tanAngleRight,
                                                  const float tanAngleUp, float const tanAngleDown, const float nearZ,
                                                  const float farZ);
@@ -90,6 +120,7 @@ inline static void XrMatrix4x4f_GetRotation(XrQuaternionf* result, const XrMatri
 inline static void XrMatrix4x4f_GetScale(XrVector3f* result, const XrMatrix4x4f* src);
 
 inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b);
+inline static void XrMatrix4x4f_MultiplyArray(XrMatrix4x4f* results, const XrMatrix4x4f* a, const XrMatrix4x4f* b, const int count);
 inline static void XrMatrix4x4f_Transpose(XrMatrix4x4f* result, const XrMatrix4x4f* src);
 inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f* src);
 inline static void XrMatrix4x4f_InvertRigidBody(XrMatrix4x4f* result, const XrMatrix4x4f* src);
@@ -99,7 +130,20 @@ inline static void XrMatrix4x4f_TransformVector4f(XrVector4f* result, const XrMa
 
 inline static void XrMatrix4x4f_TransformBounds(XrVector3f* resultMins, XrVector3f* resultMaxs, const XrMatrix4x4f* matrix,
                                                 const XrVector3f* mins, const XrVector3f* maxs);
+
+inline static void XrMatrix3x4f_CreateFromPose(XrMatrix3x4f* result, const XrPosef* pose);
+inline static void XrMatrix3x4f_CreateViewFromPose(XrMatrix3x4f* result, const XrPosef* pose);
+inline static void XrMatrix3x4f_Multiply(XrMatrix3x4f* result, const XrMatrix3x4f* a, const XrMatrix3x4f* b);
+inline static void XrMatrix3x4f_InvertRigidBody(XrMatrix3x4f* result, const XrMatrix3x4f* src);
+inline static void XrMatrix3x4f_TransformVector3f(XrVector3f* result, const XrMatrix3x4f* m, const XrVector3f* v);
+inline static void XrMatrix4x4f_CreateFromMatrix3x4f(XrMatrix4x4f* result, const XrMatrix3x4f* src);
+inline static void XrMatrix4x4f_MultiplyMatrix3x4f(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix3x4f* b);
+
 inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVector3f* mins, const XrVector3f* maxs);
+inline static int XrMatrix4x4f_CullBoundsArray(uint32_t* visibleBits, const XrMatrix4x4f* mvp, const XrBoundsArraysf* bounds,
+                                               const int count);
+inline static int XrMatrix4x4f_CullBoundsCenterExtentArray(uint32_t* visibleBits, const XrMatrix4x4f* mvp,
+                                                           const XrVector3f* centers, const XrVector3f* extents, const int count);
 
 ================================================================================================
 */
@@ -107,6 +151,20 @@ inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVect
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(XR_LINEAR_NO_SIMD)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define XR_LINEAR_SIMD
+#define XR_LINEAR_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define XR_LINEAR_SIMD
+#define XR_LINEAR_NEON
+#include <arm_neon.h>
+#endif
+#endif
 
 #define MATH_PI 3.14159265358979323846f
 
@@ -129,12 +187,142 @@ struct XrMatrix4x4f {
     float m[16];
 };
 
+// Affine transform, column-major and pre-multiplied like XrMatrix4x4f, without the bottom row, which is always
+// (0, 0, 0, 1). Holds poses and the other transforms between spaces in three quarters of the space, and saves the
+// arithmetic on the constant row. This type does not exist in the OpenXR API and is provided for convenience.
+struct XrMatrix3x4f {
+    float m[12];
+};
+
+// Poses and scales as separate arrays of each component, one element per matrix, for
+// XrMatrix4x4f_CreateTranslationRotationScaleArraySoA. This type does not exist in the OpenXR API and is provided for
+// convenience.
+struct XrPoseScaleArraysf {
+    const float* positionX;
+    const float* positionY;
+    const float* positionZ;
+    const float* orientationX;
+    const float* orientationY;
+    const float* orientationZ;
+    const float* orientationW;
+    const float* scaleX;
+    const float* scaleY;
+    const float* scaleZ;
+};
+
+// Bounds as separate arrays of each component, one element per bounds, for XrMatrix4x4f_CullBoundsArray. This type
+// does not exist in the OpenXR API and is provided for convenience.
+struct XrBoundsArraysf {
+    const float* minX;
+    const float* minY;
+    const float* minZ;
+    const float* maxX;
+    const float* maxY;
+    const float* maxZ;
+};
+
 inline static float XrRcpSqrt(const float x) {
     const float SMALLEST_NON_DENORMAL = 1.1754943508222875e-038f;  // ( 1U << 23 )
     const float rcp = (x >= SMALLEST_NON_DENORMAL) ? 1.0f / sqrtf(x) : 1.0f;
     return rcp;
 }
 
+#if defined(XR_LINEAR_SIMD)
+// Four floats in a SIMD register, used for a matrix column.
+#if defined(XR_LINEAR_SSE)
+typedef __m128 XrLinearFloat4;
+
+inline static XrLinearFloat4 XrLinearFloat4_Load(const float* p) { return _mm_loadu_ps(p); }
+inline static void XrLinearFloat4_Store(float* p, const XrLinearFloat4 v) { _mm_storeu_ps(p, v); }
+inline static XrLinearFloat4 XrLinearFloat4_Splat(const float value) { return _mm_set1_ps(value); }
+inline static XrLinearFloat4 XrLinearFloat4_Set(const float x, const float y, const float z, const float w) {
+    return _mm_setr_ps(x, y, z, w);
+}
+inline static XrLinearFloat4 XrLinearFloat4_Add(const XrLinearFloat4 a, const XrLinearFloat4 b) { return _mm_add_ps(a, b); }
+inline static XrLinearFloat4 XrLinearFloat4_Sub(const XrLinearFloat4 a, const XrLinearFloat4 b) { return _mm_sub_ps(a, b); }
+inline static XrLinearFloat4 XrLinearFloat4_Mul(const XrLinearFloat4 a, const XrLinearFloat4 b) { return _mm_mul_ps(a, b); }
+inline static XrLinearFloat4 XrLinearFloat4_Div(const XrLinearFloat4 a, const XrLinearFloat4 b) { return _mm_div_ps(a, b); }
+
+// Returns (a[x], a[y], b[z], b[w]); the lanes have to be constants.
+#define XR_LINEAR_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps((a), (b), _MM_SHUFFLE((w), (z), (y), (x)))
+#else
+typedef float32x4_t XrLinearFloat4;
+
+inline static XrLinearFloat4 XrLinearFloat4_Load(const float* p) { return vld1q_f32(p); }
+inline static void XrLinearFloat4_Store(float* p, const XrLinearFloat4 v) { vst1q_f32(p, v); }
+inline static XrLinearFloat4 XrLinearFloat4_Splat(const float value) { return vdupq_n_f32(value); }
+inline static XrLinearFloat4 XrLinearFloat4_Set(const float x, const float y, const float z, const float w) {
+    const float v[4] = {x, y, z, w};
+    return vld1q_f32(v);
+}
+inline static XrLinearFloat4 XrLinearFloat4_Add(const XrLinearFloat4 a, const XrLinearFloat4 b) { return vaddq_f32(a, b); }
+inline static XrLinearFloat4 XrLinearFloat4_Sub(const XrLinearFloat4 a, const XrLinearFloat4 b) { return vsubq_f32(a, b); }
+inline static XrLinearFloat4 XrLinearFloat4_Mul(const XrLinearFloat4 a, const XrLinearFloat4 b) { return vmulq_f32(a, b); }
+inline static XrLinearFloat4 XrLinearFloat4_Div(const XrLinearFloat4 a, const XrLinearFloat4 b) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return vdivq_f32(a, b);
+#else
+    // ARMv7 has no vector divide.
+    float av[4], bv[4];
+    vst1q_f32(av, a);
+    vst1q_f32(bv, b);
+    return XrLinearFloat4_Set(av[0] / bv[0], av[1] / bv[1], av[2] / bv[2], av[3] / bv[3]);
+#endif
+}
+
+// Returns (a[x], a[y], b[z], b[w]); the lanes have to be constants.
+#define XR_LINEAR_SHUFFLE(a, b, x, y, z, w)                                                                            \
+    vsetq_lane_f32(vgetq_lane_f32((b), (w)),                                                                           \
+                   vsetq_lane_f32(vgetq_lane_f32((b), (z)),                                                            \
+                                  vsetq_lane_f32(vgetq_lane_f32((a), (y)), vdupq_n_f32(vgetq_lane_f32((a), (x))), 1), \
+                                  2),                                                                                  \
+                   3)
+#endif
+
+// Returns a bit for each lane, set where a <= b.
+inline static int XrLinearFloat4_LessEqualBits(const XrLinearFloat4 a, const XrLinearFloat4 b) {
+#if defined(XR_LINEAR_SSE)
+    return _mm_movemask_ps(_mm_cmple_ps(a, b));
+#else
+    const uint32x4_t mask = vcleq_f32(a, b);
+    return (int)((vgetq_lane_u32(mask, 0) & 1) | (vgetq_lane_u32(mask, 1) & 2) | (vgetq_lane_u32(mask, 2) & 4) |
+                 (vgetq_lane_u32(mask, 3) & 8));
+#endif
+}
+
+// 2x2 matrices are kept as (m00, m01, m10, m11).
+
+// Returns a * b.
+inline static XrLinearFloat4 XrLinearFloat4_Mat2Mul(const XrLinearFloat4 a, const XrLinearFloat4 b) {
+    return XrLinearFloat4_Add(XrLinearFloat4_Mul(a, XR_LINEAR_SHUFFLE(b, b, 0, 3, 0, 3)),
+                              XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(a, a, 1, 0, 3, 2), XR_LINEAR_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+
+// Returns adjugate(a) * b.
+inline static XrLinearFloat4 XrLinearFloat4_Mat2AdjMul(const XrLinearFloat4 a, const XrLinearFloat4 b) {
+    return XrLinearFloat4_Sub(XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(a, a, 3, 3, 0, 0), b),
+                              XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(a, a, 1, 1, 2, 2), XR_LINEAR_SHUFFLE(b, b, 2, 3, 0, 1)));
+}
+
+// Transposes four columns in place.
+inline static void XrLinearFloat4_Transpose(XrLinearFloat4 v[4]) {
+    const XrLinearFloat4 t0 = XR_LINEAR_SHUFFLE(v[0], v[1], 0, 1, 0, 1);
+    const XrLinearFloat4 t1 = XR_LINEAR_SHUFFLE(v[0], v[1], 2, 3, 2, 3);
+    const XrLinearFloat4 t2 = XR_LINEAR_SHUFFLE(v[2], v[3], 0, 1, 0, 1);
+    const XrLinearFloat4 t3 = XR_LINEAR_SHUFFLE(v[2], v[3], 2, 3, 2, 3);
+    v[0] = XR_LINEAR_SHUFFLE(t0, t2, 0, 2, 0, 2);
+    v[1] = XR_LINEAR_SHUFFLE(t0, t2, 1, 3, 1, 3);
+    v[2] = XR_LINEAR_SHUFFLE(t1, t3, 0, 2, 0, 2);
+    v[3] = XR_LINEAR_SHUFFLE(t1, t3, 1, 3, 1, 3);
+}
+
+// Returns a * adjugate(b).
+inline static XrLinearFloat4 XrLinearFloat4_Mat2MulAdj(const XrLinearFloat4 a, const XrLinearFloat4 b) {
+    return XrLinearFloat4_Sub(XrLinearFloat4_Mul(a, XR_LINEAR_SHUFFLE(b, b, 3, 0, 3, 0)),
+                              XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(a, a, 1, 0, 3, 2), XR_LINEAR_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+#endif
+
 inline static void XrVector3f_Set(XrVector3f* v, const float value) {
     v->x = value;
     v->y = value;
@@ -221,8 +409,157 @@ inline static void XrQuaternionf_Lerp(XrQuaternionf* result, const XrQuaternionf
     result->w = w * lengthRcp;
 }
 
+// Spherical linear interpolation along the shortest arc, with a constant angular velocity as 'fraction' goes from 0 to
+// 1.  Falls back to XrQuaternionf_Lerp when the two are so close that the two give the same result.
+inline static void XrQuaternionf_Slerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b,
+                                       const float fraction) {
+    const float s = a->x * b->x + a->y * b->y + a->z * b->z + a->w * b->w;
+    const float cosAngle = fabsf(s);
+    if (cosAngle > 0.9995f) {
+        XrQuaternionf_Lerp(result, a, b, fraction);
+        return;
+    }
+    const float angle = acosf(cosAngle);
+    const float rcpSinAngle = 1.0f / sinf(angle);
+    const float fa = sinf((1.0f - fraction) * angle) * rcpSinAngle;
+    const float fb = ((s < 0.0f) ? -sinf(fraction * angle) : sinf(fraction * angle)) * rcpSinAngle;
+    result->x = a->x * fa + b->x * fb;
+    result->y = a->y * fa + b->y * fb;
+    result->z = a->z * fa + b->z * fb;
+    result->w = a->w * fa + b->w * fb;
+}
+
+// Approximates XrQuaternionf_Slerp without any trigonometry or branches: the fraction is corrected for the angle
+// between the two with a polynomial fit before a normalized lerp.  The result is within 1e-3 radians of
+// XrQuaternionf_Slerp, where XrQuaternionf_Lerp can be off by more than 0.1 radians.
+inline static void XrQuaternionf_FastSlerp(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b,
+                                           const float fraction) {
+    const float s = a->x * b->x + a->y * b->y + a->z * b->z + a->w * b->w;
+    const float d = fabsf(s);
+    const float k0 = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+    const float k1 = 0.848013f + d * (-1.06021f + d * 0.215638f);
+    const float centered = fraction - 0.5f;
+    const float k = k0 * centered * centered + k1;
+    const float corrected = fraction + fraction * centered * (fraction - 1.0f) * k;
+    XrQuaternionf_Lerp(result, a, b, corrected);
+}
+
+// Use left-multiplication to accumulate rotations, as with XrMatrix4x4f_Multiply: rotating by the result rotates by
+// 'b' and then by 'a'.
+inline static void XrQuaternionf_Multiply(XrQuaternionf* result, const XrQuaternionf* a, const XrQuaternionf* b) {
+#if defined(XR_LINEAR_SIMD)
+    const XrLinearFloat4 bv = XrLinearFloat4_Set(b->x, b->y, b->z, b->w);
+    XrLinearFloat4 sum = XrLinearFloat4_Mul(XrLinearFloat4_Splat(a->w), bv);
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Mul(XrLinearFloat4_Splat(a->x),
+                                                     XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(bv, bv, 3, 2, 1, 0),
+                                                                        XrLinearFloat4_Set(1.0f, -1.0f, 1.0f, -1.0f))));
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Mul(XrLinearFloat4_Splat(a->y),
+                                                     XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(bv, bv, 2, 3, 0, 1),
+                                                                        XrLinearFloat4_Set(1.0f, 1.0f, -1.0f, -1.0f))));
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Mul(XrLinearFloat4_Splat(a->z),
+                                                     XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(bv, bv, 1, 0, 3, 2),
+                                                                        XrLinearFloat4_Set(-1.0f, 1.0f, 1.0f, -1.0f))));
+    float xyzw[4];
+    XrLinearFloat4_Store(xyzw, sum);
+    result->x = xyzw[0];
+    result->y = xyzw[1];
+    result->z = xyzw[2];
+    result->w = xyzw[3];
+#else
+    const float x = a->w * b->x + a->x * b->w + a->y * b->z - a->z * b->y;
+    const float y = a->w * b->y - a->x * b->z + a->y * b->w + a->z * b->x;
+    const float z = a->w * b->z + a->x * b->y - a->y * b->x + a->z * b->w;
+    const float w = a->w * b->w - a->x * b->x - a->y * b->y - a->z * b->z;
+    result->x = x;
+    result->y = y;
+    result->z = z;
+    result->w = w;
+#endif
+}
+
+// Calculates the inverse of a unit quaternion, its conjugate.
+inline static void XrQuaternionf_Invert(XrQuaternionf* result, const XrQuaternionf* q) {
+    result->x = -q->x;
+    result->y = -q->y;
+    result->z = -q->z;
+    result->w = q->w;
+}
+
+// Rotates a vector by a unit quaternion, without building the rotation matrix.
+inline static void XrQuaternionf_RotateVector3f(XrVector3f* result, const XrQuaternionf* q, const XrVector3f* v) {
+    // v + 2w (q x v) + 2 q x (q x v), with q the vector part of the quaternion.
+    const XrVector3f t = {2.0f * (q->y * v->z - q->z * v->y), 2.0f * (q->z * v->x - q->x * v->z),
+                          2.0f * (q->x * v->y - q->y * v->x)};
+    const float x = v->x + q->w * t.x + (q->y * t.z - q->z * t.y);
+    const float y = v->y + q->w * t.y + (q->z * t.x - q->x * t.z);
+    const float z = v->z + q->w * t.z + (q->x * t.y - q->y * t.x);
+    result->x = x;
+    result->y = y;
+    result->z = z;
+}
+
+inline static void XrPosef_CreateIdentity(XrPosef* result) {
+    result->orientation.x = 0.0f;
+    result->orientation.y = 0.0f;
+    result->orientation.z = 0.0f;
+    result->orientation.w = 1.0f;
+    result->position.x = 0.0f;
+    result->position.y = 0.0f;
+    result->position.z = 0.0f;
+}
+
+// Use left-multiplication to accumulate poses, as with the matrices for them: with 'b' relative to the space of 'a' and
+// 'a' relative to some base space, the result is 'b' relative to the base space.  'result' may be 'a' or 'b'.
+inline static void XrPosef_Multiply(XrPosef* result, const XrPosef* a, const XrPosef* b) {
+    XrVector3f position;
+    XrQuaternionf_RotateVector3f(&position, &a->orientation, &b->position);
+    XrVector3f_Add(&position, &position, &a->position);
+    XrQuaternionf_Multiply(&result->orientation, &a->orientation, &b->orientation);
+    result->position = position;
+}
+
+// Calculates the inverse of a pose with a unit orientation.  'result' may be 'pose'.
+inline static void XrPosef_Invert(XrPosef* result, const XrPosef* pose) {
+    XrQuaternionf orientation;
+    XrQuaternionf_Invert(&orientation, &pose->orientation);
+    XrVector3f position;
+    XrQuaternionf_RotateVector3f(&position, &orientation, &pose->position);
+    result->orientation = orientation;
+    result->position.x = -position.x;
+    result->position.y = -position.y;
+    result->position.z = -position.z;
+}
+
+// Transforms a point from the space of the pose to the space the pose is relative to.
+inline static void XrPosef_TransformVector3f(XrVector3f* result, const XrPosef* pose, const XrVector3f* v) {
+    XrVector3f rotated;
+    XrQuaternionf_RotateVector3f(&rotated, &pose->orientation, v);
+    XrVector3f_Add(result, &rotated, &pose->position);
+}
+
+#if defined(XR_LINEAR_SIMD)
+// Multiplies the matrix with the columns 'a' by 'b'.  Each column of 'b' is read before that column of the result is
+// written, so 'result' may be 'b'.
+inline static void XrMatrix4x4f_MultiplyColumns(XrMatrix4x4f* result, const XrLinearFloat4 a[4], const XrMatrix4x4f* b) {
+    for (int c = 0; c < 4; c++) {
+        XrLinearFloat4 column = XrLinearFloat4_Mul(a[0], XrLinearFloat4_Splat(b->m[c * 4 + 0]));
+        column = XrLinearFloat4_Add(column, XrLinearFloat4_Mul(a[1], XrLinearFloat4_Splat(b->m[c * 4 + 1])));
+        column = XrLinearFloat4_Add(column, XrLinearFloat4_Mul(a[2], XrLinearFloat4_Splat(b->m[c * 4 + 2])));
+        column = XrLinearFloat4_Add(column, XrLinearFloat4_Mul(a[3], XrLinearFloat4_Splat(b->m[c * 4 + 3])));
+        XrLinearFloat4_Store(&result->m[c * 4], column);
+    }
+}
+#endif
+
 // Use left-multiplication to accumulate transformations.
 inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix4x4f* b) {
+#if defined(XR_LINEAR_SIMD)
+    XrLinearFloat4 columns[4];
+    for (int c = 0; c < 4; c++) {
+        columns[c] = XrLinearFloat4_Load(&a->m[c * 4]);
+    }
+    XrMatrix4x4f_MultiplyColumns(result, columns, b);
+#else
     result->m[0] = a->m[0] * b->m[0] + a->m[4] * b->m[1] + a->m[8] * b->m[2] + a->m[12] * b->m[3];
     result->m[1] = a->m[1] * b->m[0] + a->m[5] * b->m[1] + a->m[9] * b->m[2] + a->m[13] * b->m[3];
     result->m[2] = a->m[2] * b->m[0] + a->m[6] * b->m[1] + a->m[10] * b->m[2] + a->m[14] * b->m[3];
@@ -242,6 +579,27 @@ inline static void XrMatrix4x4f_Multiply(XrMatrix4x4f* result, const XrMatrix4x4
     result->m[13] = a->m[1] * b->m[12] + a->m[5] * b->m[13] + a->m[9] * b->m[14] + a->m[13] * b->m[15];
     result->m[14] = a->m[2] * b->m[12] + a->m[6] * b->m[13] + a->m[10] * b->m[14] + a->m[14] * b->m[15];
     result->m[15] = a->m[3] * b->m[12] + a->m[7] * b->m[13] + a->m[11] * b->m[14] + a->m[15] * b->m[15];
+#endif
+}
+
+// Multiplies 'a' by each of the 'count' matrices in 'b', for instance a view-projection matrix by the model matrices
+// of many objects.  Each result is the one XrMatrix4x4f_Multiply gives.  'results' may be 'b', but must not overlap 'a'.
+inline static void XrMatrix4x4f_MultiplyArray(XrMatrix4x4f* results, const XrMatrix4x4f* a, const XrMatrix4x4f* b,
+                                              const int count) {
+#if defined(XR_LINEAR_SIMD)
+    XrLinearFloat4 columns[4];
+    for (int c = 0; c < 4; c++) {
+        columns[c] = XrLinearFloat4_Load(&a->m[c * 4]);
+    }
+    for (int i = 0; i < count; i++) {
+        XrMatrix4x4f_MultiplyColumns(&results[i], columns, &b[i]);
+    }
+#else
+    for (int i = 0; i < count; i++) {
+        const XrMatrix4x4f model = b[i];
+        XrMatrix4x4f_Multiply(&results[i], a, &model);
+    }
+#endif
 }
 
 // Creates the transpose of the given matrix.
@@ -279,6 +637,59 @@ inline static float XrMatrix4x4f_Minor(const XrMatrix4x4f* matrix, int r0, int r
 
 // Calculates the inverse of a 4x4 matrix.
 inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f* src) {
+#if defined(XR_LINEAR_SIMD)
+    // Each column is loaded as a row, so the 2x2 block formulas give the rows of the inverse of the transpose, which
+    // are the columns of the inverse.
+    const XrLinearFloat4 c0 = XrLinearFloat4_Load(&src->m[0]);
+    const XrLinearFloat4 c1 = XrLinearFloat4_Load(&src->m[4]);
+    const XrLinearFloat4 c2 = XrLinearFloat4_Load(&src->m[8]);
+    const XrLinearFloat4 c3 = XrLinearFloat4_Load(&src->m[12]);
+
+    //     | A  B |
+    // M = |      |
+    //     | C  D |
+    const XrLinearFloat4 A = XR_LINEAR_SHUFFLE(c0, c1, 0, 1, 0, 1);
+    const XrLinearFloat4 B = XR_LINEAR_SHUFFLE(c0, c1, 2, 3, 2, 3);
+    const XrLinearFloat4 C = XR_LINEAR_SHUFFLE(c2, c3, 0, 1, 0, 1);
+    const XrLinearFloat4 D = XR_LINEAR_SHUFFLE(c2, c3, 2, 3, 2, 3);
+
+    // (|A|, |B|, |C|, |D|)
+    const XrLinearFloat4 detSub =
+        XrLinearFloat4_Sub(XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(c0, c2, 0, 2, 0, 2), XR_LINEAR_SHUFFLE(c1, c3, 1, 3, 1, 3)),
+                           XrLinearFloat4_Mul(XR_LINEAR_SHUFFLE(c0, c2, 1, 3, 1, 3), XR_LINEAR_SHUFFLE(c1, c3, 0, 2, 0, 2)));
+    const XrLinearFloat4 detA = XR_LINEAR_SHUFFLE(detSub, detSub, 0, 0, 0, 0);
+    const XrLinearFloat4 detB = XR_LINEAR_SHUFFLE(detSub, detSub, 1, 1, 1, 1);
+    const XrLinearFloat4 detC = XR_LINEAR_SHUFFLE(detSub, detSub, 2, 2, 2, 2);
+    const XrLinearFloat4 detD = XR_LINEAR_SHUFFLE(detSub, detSub, 3, 3, 3, 3);
+
+    // With A# the adjugate of A, the inverse is 1/|M| times the block matrix with the adjugates of
+    // X = |D|A - B(D#C), Y = |B|C - D(A#B)#, Z = |C|B - A(D#C)# and W = |A|D - C(A#B).
+    const XrLinearFloat4 DadjC = XrLinearFloat4_Mat2AdjMul(D, C);
+    const XrLinearFloat4 AadjB = XrLinearFloat4_Mat2AdjMul(A, B);
+    XrLinearFloat4 X = XrLinearFloat4_Sub(XrLinearFloat4_Mul(detD, A), XrLinearFloat4_Mat2Mul(B, DadjC));
+    XrLinearFloat4 W = XrLinearFloat4_Sub(XrLinearFloat4_Mul(detA, D), XrLinearFloat4_Mat2Mul(C, AadjB));
+    XrLinearFloat4 Y = XrLinearFloat4_Sub(XrLinearFloat4_Mul(detB, C), XrLinearFloat4_Mat2MulAdj(D, AadjB));
+    XrLinearFloat4 Z = XrLinearFloat4_Sub(XrLinearFloat4_Mul(detC, B), XrLinearFloat4_Mat2MulAdj(A, DadjC));
+
+    // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    XrLinearFloat4 trace = XrLinearFloat4_Mul(AadjB, XR_LINEAR_SHUFFLE(DadjC, DadjC, 0, 2, 1, 3));
+    trace = XrLinearFloat4_Add(trace, XR_LINEAR_SHUFFLE(trace, trace, 1, 0, 3, 2));
+    trace = XrLinearFloat4_Add(trace, XR_LINEAR_SHUFFLE(trace, trace, 2, 3, 0, 1));
+    const XrLinearFloat4 det =
+        XrLinearFloat4_Sub(XrLinearFloat4_Add(XrLinearFloat4_Mul(detA, detD), XrLinearFloat4_Mul(detB, detC)), trace);
+
+    // The signs of the adjugate are folded into the reciprocal of the determinant, and its shuffle into the stores.
+    const XrLinearFloat4 rcpDet = XrLinearFloat4_Div(XrLinearFloat4_Set(1.0f, -1.0f, -1.0f, 1.0f), det);
+    X = XrLinearFloat4_Mul(X, rcpDet);
+    Y = XrLinearFloat4_Mul(Y, rcpDet);
+    Z = XrLinearFloat4_Mul(Z, rcpDet);
+    W = XrLinearFloat4_Mul(W, rcpDet);
+
+    XrLinearFloat4_Store(&result->m[0], XR_LINEAR_SHUFFLE(X, Y, 3, 1, 3, 1));
+    XrLinearFloat4_Store(&result->m[4], XR_LINEAR_SHUFFLE(X, Y, 2, 0, 2, 0));
+    XrLinearFloat4_Store(&result->m[8], XR_LINEAR_SHUFFLE(Z, W, 3, 1, 3, 1));
+    XrLinearFloat4_Store(&result->m[12], XR_LINEAR_SHUFFLE(Z, W, 2, 0, 2, 0));
+#else
     const float rcpDet =
         1.0f / (src->m[0] * XrMatrix4x4f_Minor(src, 1, 2, 3, 1, 2, 3) - src->m[1] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 2, 3) +
                 src->m[2] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 3) - src->m[3] * XrMatrix4x4f_Minor(src, 1, 2, 3, 0, 1, 2));
@@ -299,6 +710,7 @@ inline static void XrMatrix4x4f_Invert(XrMatrix4x4f* result, const XrMatrix4x4f*
     result->m[13] = XrMatrix4x4f_Minor(src, 0, 2, 3, 0, 1, 2) * rcpDet;
     result->m[14] = -XrMatrix4x4f_Minor(src, 0, 1, 3, 0, 1, 2) * rcpDet;
     result->m[15] = XrMatrix4x4f_Minor(src, 0, 1, 2, 0, 1, 2) * rcpDet;
+#endif
 }
 
 // Calculates the inverse of a rigid body transform.
@@ -454,6 +866,279 @@ inline static void XrMatrix4x4f_CreateTranslationRotationScale(XrMatrix4x4f* res
     XrMatrix4x4f_Multiply(result, &translationMatrix, &combinedMatrix);
 }
 
+// Creates one matrix for the array versions of XrMatrix4x4f_CreateTranslationRotationScale, straight from the
+// rotation and scale instead of multiplying their matrices.
+inline static void XrMatrix4x4f_CreateTranslationRotationScaleElement(XrMatrix4x4f* result, const float tx, const float ty,
+                                                                      const float tz, const float qx, const float qy,
+                                                                      const float qz, const float qw, const float sx,
+                                                                      const float sy, const float sz) {
+    const float x2 = qx + qx;
+    const float y2 = qy + qy;
+    const float z2 = qz + qz;
+
+    const float xx2 = qx * x2;
+    const float yy2 = qy * y2;
+    const float zz2 = qz * z2;
+
+    const float yz2 = qy * z2;
+    const float wx2 = qw * x2;
+    const float xy2 = qx * y2;
+    const float wz2 = qw * z2;
+    const float xz2 = qx * z2;
+    const float wy2 = qw * y2;
+
+    result->m[0] = (1.0f - yy2 - zz2) * sx;
+    result->m[1] = (xy2 + wz2) * sx;
+    result->m[2] = (xz2 - wy2) * sx;
+    result->m[3] = 0.0f;
+
+    result->m[4] = (xy2 - wz2) * sy;
+    result->m[5] = (1.0f - xx2 - zz2) * sy;
+    result->m[6] = (yz2 + wx2) * sy;
+    result->m[7] = 0.0f;
+
+    result->m[8] = (xz2 + wy2) * sz;
+    result->m[9] = (yz2 - wx2) * sz;
+    result->m[10] = (1.0f - xx2 - yy2) * sz;
+    result->m[11] = 0.0f;
+
+    result->m[12] = tx;
+    result->m[13] = ty;
+    result->m[14] = tz;
+    result->m[15] = 1.0f;
+}
+
+#if defined(XR_LINEAR_SIMD)
+// The translations, rotations and scales of four matrices, one matrix per lane.
+struct XrLinearPoseScale4 {
+    XrLinearFloat4 tx, ty, tz;
+    XrLinearFloat4 qx, qy, qz, qw;
+    XrLinearFloat4 sx, sy, sz;
+};
+
+// Creates four consecutive matrices with the same operations as XrMatrix4x4f_CreateTranslationRotationScaleElement.
+inline static void XrMatrix4x4f_CreateTranslationRotationScale4(XrMatrix4x4f* results, const XrLinearPoseScale4* in) {
+    const XrLinearFloat4 x2 = XrLinearFloat4_Add(in->qx, in->qx);
+    const XrLinearFloat4 y2 = XrLinearFloat4_Add(in->qy, in->qy);
+    const XrLinearFloat4 z2 = XrLinearFloat4_Add(in->qz, in->qz);
+
+    const XrLinearFloat4 xx2 = XrLinearFloat4_Mul(in->qx, x2);
+    const XrLinearFloat4 yy2 = XrLinearFloat4_Mul(in->qy, y2);
+    const XrLinearFloat4 zz2 = XrLinearFloat4_Mul(in->qz, z2);
+
+    const XrLinearFloat4 yz2 = XrLinearFloat4_Mul(in->qy, z2);
+    const XrLinearFloat4 wx2 = XrLinearFloat4_Mul(in->qw, x2);
+    const XrLinearFloat4 xy2 = XrLinearFloat4_Mul(in->qx, y2);
+    const XrLinearFloat4 wz2 = XrLinearFloat4_Mul(in->qw, z2);
+    const XrLinearFloat4 xz2 = XrLinearFloat4_Mul(in->qx, z2);
+    const XrLinearFloat4 wy2 = XrLinearFloat4_Mul(in->qw, y2);
+
+    const XrLinearFloat4 one = XrLinearFloat4_Splat(1.0f);
+    const XrLinearFloat4 zero = XrLinearFloat4_Splat(0.0f);
+
+    // Element k of column c of all four matrices, transposed into column c of each matrix.
+    XrLinearFloat4 column[4];
+    column[0] = XrLinearFloat4_Mul(XrLinearFloat4_Sub(XrLinearFloat4_Sub(one, yy2), zz2), in->sx);
+    column[1] = XrLinearFloat4_Mul(XrLinearFloat4_Add(xy2, wz2), in->sx);
+    column[2] = XrLinearFloat4_Mul(XrLinearFloat4_Sub(xz2, wy2), in->sx);
+    column[3] = zero;
+    XrLinearFloat4_Transpose(column);
+    for (int i = 0; i < 4; i++) {
+        XrLinearFloat4_Store(&results[i].m[0], column[i]);
+    }
+
+    column[0] = XrLinearFloat4_Mul(XrLinearFloat4_Sub(xy2, wz2), in->sy);
+    column[1] = XrLinearFloat4_Mul(XrLinearFloat4_Sub(XrLinearFloat4_Sub(one, xx2), zz2), in->sy);
+    column[2] = XrLinearFloat4_Mul(XrLinearFloat4_Add(yz2, wx2), in->sy);
+    column[3] = zero;
+    XrLinearFloat4_Transpose(column);
+    for (int i = 0; i < 4; i++) {
+        XrLinearFloat4_Store(&results[i].m[4], column[i]);
+    }
+
+    column[0] = XrLinearFloat4_Mul(XrLinearFloat4_Add(xz2, wy2), in->sz);
+    column[1] = XrLinearFloat4_Mul(XrLinearFloat4_Sub(yz2, wx2), in->sz);
+    column[2] = XrLinearFloat4_Mul(XrLinearFloat4_Sub(XrLinearFloat4_Sub(one, xx2), yy2), in->sz);
+    column[3] = zero;
+    XrLinearFloat4_Transpose(column);
+    for (int i = 0; i < 4; i++) {
+        XrLinearFloat4_Store(&results[i].m[8], column[i]);
+    }
+
+    column[0] = in->tx;
+    column[1] = in->ty;
+    column[2] = in->tz;
+    column[3] = one;
+    XrLinearFloat4_Transpose(column);
+    for (int i = 0; i < 4; i++) {
+        XrLinearFloat4_Store(&results[i].m[12], column[i]);
+    }
+}
+#endif
+
+// Creates a translation, rotation and scale matrix for each of 'count' poses and scales.  Consecutive poses are
+// 'poseStride' bytes apart and consecutive scales 'scaleStride' bytes apart, so both can be members of an array of
+// structures.  For finite inputs, each matrix has the values XrMatrix4x4f_CreateTranslationRotationScale gives, apart
+// from the sign of elements that are zero.
+inline static void XrMatrix4x4f_CreateTranslationRotationScaleArray(XrMatrix4x4f* results, const XrPosef* poses,
+                                                                    const size_t poseStride, const XrVector3f* scales,
+                                                                    const size_t scaleStride, const int count) {
+    int i = 0;
+#if defined(XR_LINEAR_SIMD)
+    for (; i + 4 <= count; i += 4) {
+        const XrPosef* p[4];
+        const XrVector3f* s[4];
+        for (int j = 0; j < 4; j++) {
+            p[j] = (const XrPosef*)((const char*)poses + (size_t)(i + j) * poseStride);
+            s[j] = (const XrVector3f*)((const char*)scales + (size_t)(i + j) * scaleStride);
+        }
+        XrLinearPoseScale4 in;
+        in.tx = XrLinearFloat4_Set(p[0]->position.x, p[1]->position.x, p[2]->position.x, p[3]->position.x);
+        in.ty = XrLinearFloat4_Set(p[0]->position.y, p[1]->position.y, p[2]->position.y, p[3]->position.y);
+        in.tz = XrLinearFloat4_Set(p[0]->position.z, p[1]->position.z, p[2]->position.z, p[3]->position.z);
+        in.qx = XrLinearFloat4_Set(p[0]->orientation.x, p[1]->orientation.x, p[2]->orientation.x, p[3]->orientation.x);
+        in.qy = XrLinearFloat4_Set(p[0]->orientation.y, p[1]->orientation.y, p[2]->orientation.y, p[3]->orientation.y);
+        in.qz = XrLinearFloat4_Set(p[0]->orientation.z, p[1]->orientation.z, p[2]->orientation.z, p[3]->orientation.z);
+        in.qw = XrLinearFloat4_Set(p[0]->orientation.w, p[1]->orientation.w, p[2]->orientation.w, p[3]->orientation.w);
+        in.sx = XrLinearFloat4_Set(s[0]->x, s[1]->x, s[2]->x, s[3]->x);
+        in.sy = XrLinearFloat4_Set(s[0]->y, s[1]->y, s[2]->y, s[3]->y);
+        in.sz = XrLinearFloat4_Set(s[0]->z, s[1]->z, s[2]->z, s[3]->z);
+        XrMatrix4x4f_CreateTranslationRotationScale4(&results[i], &in);
+    }
+#endif
+    for (; i < count; i++) {
+        const XrPosef* p = (const XrPosef*)((const char*)poses + (size_t)i * poseStride);
+        const XrVector3f* s = (const XrVector3f*)((const char*)scales + (size_t)i * scaleStride);
+        XrMatrix4x4f_CreateTranslationRotationScaleElement(&results[i], p->position.x, p->position.y, p->position.z,
+                                                           p->orientation.x, p->orientation.y, p->orientation.z,
+                                                           p->orientation.w, s->x, s->y, s->z);
+    }
+}
+
+// Same as XrMatrix4x4f_CreateTranslationRotationScaleArray, with each component of the poses and scales in an array
+// of its own.
+inline static void XrMatrix4x4f_CreateTranslationRotationScaleArraySoA(XrMatrix4x4f* results, const XrPoseScaleArraysf* arrays,
+                                                                       const int count) {
+    int i = 0;
+#if defined(XR_LINEAR_SIMD)
+    for (; i + 4 <= count; i += 4) {
+        XrLinearPoseScale4 in;
+        in.tx = XrLinearFloat4_Load(&arrays->positionX[i]);
+        in.ty = XrLinearFloat4_Load(&arrays->positionY[i]);
+        in.tz = XrLinearFloat4_Load(&arrays->positionZ[i]);
+        in.qx = XrLinearFloat4_Load(&arrays->orientationX[i]);
+        in.qy = XrLinearFloat4_Load(&arrays->orientationY[i]);
+        in.qz = XrLinearFloat4_Load(&arrays->orientationZ[i]);
+        in.qw = XrLinearFloat4_Load(&arrays->orientationW[i]);
+        in.sx = XrLinearFloat4_Load(&arrays->scaleX[i]);
+        in.sy = XrLinearFloat4_Load(&arrays->scaleY[i]);
+        in.sz = XrLinearFloat4_Load(&arrays->scaleZ[i]);
+        XrMatrix4x4f_CreateTranslationRotationScale4(&results[i], &in);
+    }
+#endif
+    for (; i < count; i++) {
+        XrMatrix4x4f_CreateTranslationRotationScaleElement(&results[i], arrays->positionX[i], arrays->positionY[i],
+                                                           arrays->positionZ[i], arrays->orientationX[i],
+                                                           arrays->orientationY[i], arrays->orientationZ[i],
+                                                           arrays->orientationW[i], arrays->scaleX[i], arrays->scaleY[i],
+                                                           arrays->scaleZ[i]);
+    }
+}
+
+// Creates the rotation and translation of an affine transform from a pose.  The rotation is written a column of
+// 'stride' floats at a time.
+inline static void XrMatrix_CreateRotationTranslation(float* result, const int stride, const XrQuaternionf* orientation,
+                                                      const XrVector3f* position) {
+    const float x2 = orientation->x + orientation->x;
+    const float y2 = orientation->y + orientation->y;
+    const float z2 = orientation->z + orientation->z;
+
+    const float xx2 = orientation->x * x2;
+    const float yy2 = orientation->y * y2;
+    const float zz2 = orientation->z * z2;
+
+    const float yz2 = orientation->y * z2;
+    const float wx2 = orientation->w * x2;
+    const float xy2 = orientation->x * y2;
+    const float wz2 = orientation->w * z2;
+    const float xz2 = orientation->x * z2;
+    const float wy2 = orientation->w * y2;
+
+    result[0] = 1.0f - yy2 - zz2;
+    result[1] = xy2 + wz2;
+    result[2] = xz2 - wy2;
+
+    result[stride + 0] = xy2 - wz2;
+    result[stride + 1] = 1.0f - xx2 - zz2;
+    result[stride + 2] = yz2 + wx2;
+
+    result[2 * stride + 0] = xz2 + wy2;
+    result[2 * stride + 1] = yz2 - wx2;
+    result[2 * stride + 2] = 1.0f - xx2 - yy2;
+
+    result[3 * stride + 0] = position->x;
+    result[3 * stride + 1] = position->y;
+    result[3 * stride + 2] = position->z;
+}
+
+// Creates the rotation and translation of the inverse of a pose, the transform from the space the pose is relative
+// to into the space of the pose.  The rotation is the transpose of the one for the pose, and the translation is the
+// position rotated by it, negated.
+inline static void XrMatrix_CreateInverseRotationTranslation(float* result, const int stride, const XrQuaternionf* orientation,
+                                                             const XrVector3f* position) {
+    const float x2 = orientation->x + orientation->x;
+    const float y2 = orientation->y + orientation->y;
+    const float z2 = orientation->z + orientation->z;
+
+    const float xx2 = orientation->x * x2;
+    const float yy2 = orientation->y * y2;
+    const float zz2 = orientation->z * z2;
+
+    const float yz2 = orientation->y * z2;
+    const float wx2 = orientation->w * x2;
+    const float xy2 = orientation->x * y2;
+    const float wz2 = orientation->w * z2;
+    const float xz2 = orientation->x * z2;
+    const float wy2 = orientation->w * y2;
+
+    const float r0 = 1.0f - yy2 - zz2;
+    const float r1 = xy2 + wz2;
+    const float r2 = xz2 - wy2;
+    const float r4 = xy2 - wz2;
+    const float r5 = 1.0f - xx2 - zz2;
+    const float r6 = yz2 + wx2;
+    const float r8 = xz2 + wy2;
+    const float r9 = yz2 - wx2;
+    const float r10 = 1.0f - xx2 - yy2;
+
+    result[0] = r0;
+    result[1] = r4;
+    result[2] = r8;
+
+    result[stride + 0] = r1;
+    result[stride + 1] = r5;
+    result[stride + 2] = r9;
+
+    result[2 * stride + 0] = r2;
+    result[2 * stride + 1] = r6;
+    result[2 * stride + 2] = r10;
+
+    result[3 * stride + 0] = -(r0 * position->x + r1 * position->y + r2 * position->z);
+    result[3 * stride + 1] = -(r4 * position->x + r5 * position->y + r6 * position->z);
+    result[3 * stride + 2] = -(r8 * position->x + r9 * position->y + r10 * position->z);
+}
+
+// Creates a view matrix, the inverse of the matrix for the given pose, without creating that matrix or inverting it.
+// Gives the same values as XrMatrix4x4f_InvertRigidBody of the XrMatrix4x4f_CreateTranslationRotationScale matrix for
+// the pose with a unit scale, apart from the sign of elements that are zero.
+inline static void XrMatrix4x4f_CreateViewFromPose(XrMatrix4x4f* result, const XrPosef* pose) {
+    XrMatrix_CreateInverseRotationTranslation(result->m, 4, &pose->orientation, &pose->position);
+    result->m[3] = 0.0f;
+    result->m[7] = 0.0f;
+    result->m[11] = 0.0f;
+    result->m[15] = 1.0f;
+}
+
 // Creates a projection matrix based on the specified dimensions.
 // The projection matrix transforms -Z=forward, +Y=up, +X=right to the appropriate clip space for the graphics API.
 // The far plane is placed at infinity if farZ <= nearZ.
@@ -671,19 +1356,46 @@ inline static void XrMatrix4x4f_GetScale(XrVector3f* result, const XrMatrix4x4f*
 
 // Transforms a 3D vector.
 inline static void XrMatrix4x4f_TransformVector3f(XrVector3f* result, const XrMatrix4x4f* m, const XrVector3f* v) {
+#if defined(XR_LINEAR_SIMD)
+    XrLinearFloat4 sum = XrLinearFloat4_Mul(XrLinearFloat4_Load(&m->m[0]), XrLinearFloat4_Splat(v->x));
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Mul(XrLinearFloat4_Load(&m->m[4]), XrLinearFloat4_Splat(v->y)));
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Mul(XrLinearFloat4_Load(&m->m[8]), XrLinearFloat4_Splat(v->z)));
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Load(&m->m[12]));
+    float xyzw[4];
+    XrLinearFloat4_Store(xyzw, sum);
+    const float rcpW = 1.0f / xyzw[3];
+    XrLinearFloat4_Store(xyzw, XrLinearFloat4_Mul(sum, XrLinearFloat4_Splat(rcpW)));
+    result->x = xyzw[0];
+    result->y = xyzw[1];
+    result->z = xyzw[2];
+#else
     const float w = m->m[3] * v->x + m->m[7] * v->y + m->m[11] * v->z + m->m[15];
     const float rcpW = 1.0f / w;
     result->x = (m->m[0] * v->x + m->m[4] * v->y + m->m[8] * v->z + m->m[12]) * rcpW;
     result->y = (m->m[1] * v->x + m->m[5] * v->y + m->m[9] * v->z + m->m[13]) * rcpW;
     result->z = (m->m[2] * v->x + m->m[6] * v->y + m->m[10] * v->z + m->m[14]) * rcpW;
+#endif
 }
 
 // Transforms a 4D vector.
 inline static void XrMatrix4x4f_TransformVector4f(XrVector4f* result, const XrMatrix4x4f* m, const XrVector4f* v) {
+#if defined(XR_LINEAR_SIMD)
+    XrLinearFloat4 sum = XrLinearFloat4_Mul(XrLinearFloat4_Load(&m->m[0]), XrLinearFloat4_Splat(v->x));
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Mul(XrLinearFloat4_Load(&m->m[4]), XrLinearFloat4_Splat(v->y)));
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Mul(XrLinearFloat4_Load(&m->m[8]), XrLinearFloat4_Splat(v->z)));
+    sum = XrLinearFloat4_Add(sum, XrLinearFloat4_Mul(XrLinearFloat4_Load(&m->m[12]), XrLinearFloat4_Splat(v->w)));
+    float xyzw[4];
+    XrLinearFloat4_Store(xyzw, sum);
+    result->x = xyzw[0];
+    result->y = xyzw[1];
+    result->z = xyzw[2];
+    result->w = xyzw[3];
+#else
     result->x = m->m[0] * v->x + m->m[4] * v->y + m->m[8] * v->z + m->m[12] * v->w;
     result->y = m->m[1] * v->x + m->m[5] * v->y + m->m[9] * v->z + m->m[13] * v->w;
     result->z = m->m[2] * v->x + m->m[6] * v->y + m->m[10] * v->z + m->m[14] * v->w;
     result->w = m->m[3] * v->x + m->m[7] * v->y + m->m[11] * v->z + m->m[15] * v->w;
+#endif
 }
 
 // Transforms the 'mins' and 'maxs' bounds with the given 'matrix'.
@@ -704,6 +1416,99 @@ inline static void XrMatrix4x4f_TransformBounds(XrVector3f* resultMins, XrVector
     XrVector3f_Add(resultMaxs, &newCenter, &newExtents);
 }
 
+// Creates the affine transform for a pose.
+inline static void XrMatrix3x4f_CreateFromPose(XrMatrix3x4f* result, const XrPosef* pose) {
+    XrMatrix_CreateRotationTranslation(result->m, 3, &pose->orientation, &pose->position);
+}
+
+// Creates the affine view transform for a pose, the inverse of its transform.
+inline static void XrMatrix3x4f_CreateViewFromPose(XrMatrix3x4f* result, const XrPosef* pose) {
+    XrMatrix_CreateInverseRotationTranslation(result->m, 3, &pose->orientation, &pose->position);
+}
+
+// Use left-multiplication to accumulate transformations, as with XrMatrix4x4f_Multiply.
+inline static void XrMatrix3x4f_Multiply(XrMatrix3x4f* result, const XrMatrix3x4f* a, const XrMatrix3x4f* b) {
+    XrMatrix3x4f m;
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 3; r++) {
+            m.m[c * 3 + r] = a->m[r] * b->m[c * 3 + 0] + a->m[3 + r] * b->m[c * 3 + 1] + a->m[6 + r] * b->m[c * 3 + 2];
+        }
+    }
+    m.m[9] += a->m[9];
+    m.m[10] += a->m[10];
+    m.m[11] += a->m[11];
+    *result = m;
+}
+
+// Calculates the inverse of a rigid body transform.
+inline static void XrMatrix3x4f_InvertRigidBody(XrMatrix3x4f* result, const XrMatrix3x4f* src) {
+    XrMatrix3x4f m;
+    m.m[0] = src->m[0];
+    m.m[1] = src->m[3];
+    m.m[2] = src->m[6];
+    m.m[3] = src->m[1];
+    m.m[4] = src->m[4];
+    m.m[5] = src->m[7];
+    m.m[6] = src->m[2];
+    m.m[7] = src->m[5];
+    m.m[8] = src->m[8];
+    m.m[9] = -(src->m[0] * src->m[9] + src->m[1] * src->m[10] + src->m[2] * src->m[11]);
+    m.m[10] = -(src->m[3] * src->m[9] + src->m[4] * src->m[10] + src->m[5] * src->m[11]);
+    m.m[11] = -(src->m[6] * src->m[9] + src->m[7] * src->m[10] + src->m[8] * src->m[11]);
+    *result = m;
+}
+
+// Transforms a point.
+inline static void XrMatrix3x4f_TransformVector3f(XrVector3f* result, const XrMatrix3x4f* m, const XrVector3f* v) {
+    const float x = m->m[0] * v->x + m->m[3] * v->y + m->m[6] * v->z + m->m[9];
+    const float y = m->m[1] * v->x + m->m[4] * v->y + m->m[7] * v->z + m->m[10];
+    const float z = m->m[2] * v->x + m->m[5] * v->y + m->m[8] * v->z + m->m[11];
+    result->x = x;
+    result->y = y;
+    result->z = z;
+}
+
+// Expands an affine transform to a 4x4 matrix.
+inline static void XrMatrix4x4f_CreateFromMatrix3x4f(XrMatrix4x4f* result, const XrMatrix3x4f* src) {
+    for (int c = 0; c < 4; c++) {
+        result->m[c * 4 + 0] = src->m[c * 3 + 0];
+        result->m[c * 4 + 1] = src->m[c * 3 + 1];
+        result->m[c * 4 + 2] = src->m[c * 3 + 2];
+        result->m[c * 4 + 3] = (c == 3) ? 1.0f : 0.0f;
+    }
+}
+
+// Multiplies a 4x4 matrix, such as a projection or view-projection, by an affine transform, such as a model or view
+// transform, leaving out the products with the constant bottom row of 'b'.
+inline static void XrMatrix4x4f_MultiplyMatrix3x4f(XrMatrix4x4f* result, const XrMatrix4x4f* a, const XrMatrix3x4f* b) {
+#if defined(XR_LINEAR_SIMD)
+    const XrLinearFloat4 a0 = XrLinearFloat4_Load(&a->m[0]);
+    const XrLinearFloat4 a1 = XrLinearFloat4_Load(&a->m[4]);
+    const XrLinearFloat4 a2 = XrLinearFloat4_Load(&a->m[8]);
+    const XrLinearFloat4 a3 = XrLinearFloat4_Load(&a->m[12]);
+    for (int c = 0; c < 4; c++) {
+        XrLinearFloat4 column = XrLinearFloat4_Mul(a0, XrLinearFloat4_Splat(b->m[c * 3 + 0]));
+        column = XrLinearFloat4_Add(column, XrLinearFloat4_Mul(a1, XrLinearFloat4_Splat(b->m[c * 3 + 1])));
+        column = XrLinearFloat4_Add(column, XrLinearFloat4_Mul(a2, XrLinearFloat4_Splat(b->m[c * 3 + 2])));
+        if (c == 3) {
+            column = XrLinearFloat4_Add(column, a3);
+        }
+        XrLinearFloat4_Store(&result->m[c * 4], column);
+    }
+#else
+    XrMatrix4x4f m;
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            m.m[c * 4 + r] = a->m[r] * b->m[c * 3 + 0] + a->m[4 + r] * b->m[c * 3 + 1] + a->m[8 + r] * b->m[c * 3 + 2];
+        }
+    }
+    for (int r = 0; r < 4; r++) {
+        m.m[12 + r] += a->m[12 + r];
+    }
+    *result = m;
+#endif
+}
+
 // Returns true if the 'mins' and 'maxs' bounds is completely off to one side of the projection matrix.
 inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVector3f* mins, const XrVector3f* maxs) {
     if (maxs->x <= mins->x && maxs->y <= mins->y && maxs->z <= mins->z) {
@@ -770,4 +1575,187 @@ inline static bool XrMatrix4x4f_CullBounds(const XrMatrix4x4f* mvp, const XrVect
     return false;
 }
 
+// The planes XrMatrix4x4f_CullBounds tests against, as (x, y, z, w) with the normal in xyz, and the absolute values of
+// the normals, for the array versions of it.
+struct XrFrustumPlanesf {
+    float plane[6][4];
+    float absNormal[6][3];
+};
+
+// Extracts the planes of the clip volume from the rows of the model-view-projection matrix.  A point is on the inside
+// of a plane where the dot product with it is positive, like the clip space corners XrMatrix4x4f_CullBounds tests.
+inline static void XrFrustumPlanesf_Create(XrFrustumPlanesf* result, const XrMatrix4x4f* mvp) {
+    for (int i = 0; i < 6; i++) {
+        // Left and right planes from the x row, bottom and top from the y row, near and far from the z row.
+        const int row = i / 2;
+        const float sign = (i & 1) ? -1.0f : 1.0f;
+        for (int c = 0; c < 4; c++) {
+            result->plane[i][c] = mvp->m[c * 4 + 3] + sign * mvp->m[c * 4 + row];
+        }
+        for (int c = 0; c < 3; c++) {
+            result->absNormal[i][c] = fabsf(result->plane[i][c]);
+        }
+    }
+}
+
+// Returns true if the bounds with the given center and extents are completely outside one of the planes: even the
+// corner furthest along the plane normal is on the outside of it.
+inline static bool XrFrustumPlanesf_CullCenterExtent(const XrFrustumPlanesf* planes, const float cx, const float cy, const float cz,
+                                                     const float ex, const float ey, const float ez) {
+    for (int i = 0; i < 6; i++) {
+        const float* p = planes->plane[i];
+        const float* a = planes->absNormal[i];
+        const float distance = p[0] * cx + p[1] * cy + p[2] * cz + p[3] + a[0] * ex + a[1] * ey + a[2] * ez;
+        if (distance <= 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if defined(XR_LINEAR_SIMD)
+// The same planes with each component in every lane, splatted once instead of for every four bounds.
+struct XrLinearFrustumPlanes4 {
+    XrLinearFloat4 plane[6][4];
+    XrLinearFloat4 absNormal[6][3];
+};
+
+inline static void XrLinearFrustumPlanes4_Create(XrLinearFrustumPlanes4* result, const XrFrustumPlanesf* planes) {
+    for (int i = 0; i < 6; i++) {
+        for (int c = 0; c < 4; c++) {
+            result->plane[i][c] = XrLinearFloat4_Splat(planes->plane[i][c]);
+        }
+        for (int c = 0; c < 3; c++) {
+            result->absNormal[i][c] = XrLinearFloat4_Splat(planes->absNormal[i][c]);
+        }
+    }
+}
+
+// Returns a bit set for each of four bounds, one per lane, that XrFrustumPlanesf_CullCenterExtent would cull.
+inline static int XrLinearFrustumPlanes4_CullCenterExtent(const XrLinearFrustumPlanes4* planes, const XrLinearFloat4 center[3],
+                                                          const XrLinearFloat4 extent[3]) {
+    const XrLinearFloat4 zero = XrLinearFloat4_Splat(0.0f);
+    int culled = 0;
+    for (int i = 0; i < 6; i++) {
+        const XrLinearFloat4* p = planes->plane[i];
+        const XrLinearFloat4* a = planes->absNormal[i];
+        XrLinearFloat4 distance = XrLinearFloat4_Mul(p[0], center[0]);
+        distance = XrLinearFloat4_Add(distance, XrLinearFloat4_Mul(p[1], center[1]));
+        distance = XrLinearFloat4_Add(distance, XrLinearFloat4_Mul(p[2], center[2]));
+        distance = XrLinearFloat4_Add(distance, p[3]);
+        distance = XrLinearFloat4_Add(distance, XrLinearFloat4_Mul(a[0], extent[0]));
+        distance = XrLinearFloat4_Add(distance, XrLinearFloat4_Mul(a[1], extent[1]));
+        distance = XrLinearFloat4_Add(distance, XrLinearFloat4_Mul(a[2], extent[2]));
+        culled |= XrLinearFloat4_LessEqualBits(distance, zero);
+    }
+    return culled;
+}
+#endif
+
+// Culls 'count' bounds against the projection matrix, like XrMatrix4x4f_CullBounds does for one, and sets bit (i % 32)
+// of visibleBits[i / 32] for each bounds i that is not culled, clearing the bits of the others.  'visibleBits' must hold
+// (count + 31) / 32 words.  Returns the number of bounds that are visible.  The planes of the projection are tested
+// instead of the eight transformed corners, so bounds that only just touch one of the planes may come out differently
+// from XrMatrix4x4f_CullBounds because of rounding.  As with XrMatrix4x4f_CullBounds, empty bounds are never culled.
+inline static int XrMatrix4x4f_CullBoundsArray(uint32_t* visibleBits, const XrMatrix4x4f* mvp, const XrBoundsArraysf* bounds,
+                                               const int count) {
+    XrFrustumPlanesf planes;
+    XrFrustumPlanesf_Create(&planes, mvp);
+
+    for (int w = 0; w < (count + 31) / 32; w++) {
+        visibleBits[w] = 0;
+    }
+
+    int visible = 0;
+    int i = 0;
+#if defined(XR_LINEAR_SIMD)
+    XrLinearFrustumPlanes4 planes4;
+    XrLinearFrustumPlanes4_Create(&planes4, &planes);
+    const XrLinearFloat4 half = XrLinearFloat4_Splat(0.5f);
+    for (; i + 4 <= count; i += 4) {
+        const XrLinearFloat4 minX = XrLinearFloat4_Load(&bounds->minX[i]);
+        const XrLinearFloat4 minY = XrLinearFloat4_Load(&bounds->minY[i]);
+        const XrLinearFloat4 minZ = XrLinearFloat4_Load(&bounds->minZ[i]);
+        const XrLinearFloat4 maxX = XrLinearFloat4_Load(&bounds->maxX[i]);
+        const XrLinearFloat4 maxY = XrLinearFloat4_Load(&bounds->maxY[i]);
+        const XrLinearFloat4 maxZ = XrLinearFloat4_Load(&bounds->maxZ[i]);
+        XrLinearFloat4 center[3];
+        center[0] = XrLinearFloat4_Mul(XrLinearFloat4_Add(minX, maxX), half);
+        center[1] = XrLinearFloat4_Mul(XrLinearFloat4_Add(minY, maxY), half);
+        center[2] = XrLinearFloat4_Mul(XrLinearFloat4_Add(minZ, maxZ), half);
+        XrLinearFloat4 extent[3];
+        extent[0] = XrLinearFloat4_Sub(maxX, center[0]);
+        extent[1] = XrLinearFloat4_Sub(maxY, center[1]);
+        extent[2] = XrLinearFloat4_Sub(maxZ, center[2]);
+        const int empty = XrLinearFloat4_LessEqualBits(maxX, minX) & XrLinearFloat4_LessEqualBits(maxY, minY) &
+                          XrLinearFloat4_LessEqualBits(maxZ, minZ);
+        const int visible4 = ~XrLinearFrustumPlanes4_CullCenterExtent(&planes4, center, extent) | empty;
+        // 'i' is a multiple of four, so the four bits are in the same word.
+        visibleBits[i / 32] |= (uint32_t)(visible4 & 0xF) << (i % 32);
+        visible += (visible4 & 1) + ((visible4 >> 1) & 1) + ((visible4 >> 2) & 1) + ((visible4 >> 3) & 1);
+    }
+#endif
+    for (; i < count; i++) {
+        const float cx = (bounds->minX[i] + bounds->maxX[i]) * 0.5f;
+        const float cy = (bounds->minY[i] + bounds->maxY[i]) * 0.5f;
+        const float cz = (bounds->minZ[i] + bounds->maxZ[i]) * 0.5f;
+        const bool empty = bounds->maxX[i] <= bounds->minX[i] && bounds->maxY[i] <= bounds->minY[i] &&
+                           bounds->maxZ[i] <= bounds->minZ[i];
+        if (empty || !XrFrustumPlanesf_CullCenterExtent(&planes, cx, cy, cz, bounds->maxX[i] - cx, bounds->maxY[i] - cy,
+                                                        bounds->maxZ[i] - cz)) {
+            visibleBits[i / 32] |= 1u << (i % 32);
+            visible++;
+        }
+    }
+    return visible;
+}
+
+// Same as XrMatrix4x4f_CullBoundsArray, with each bounds given by its center and its extents, half its size, along each
+// axis.  Bounds with no positive extent are never culled.
+inline static int XrMatrix4x4f_CullBoundsCenterExtentArray(uint32_t* visibleBits, const XrMatrix4x4f* mvp,
+                                                           const XrVector3f* centers, const XrVector3f* extents, const int count) {
+    XrFrustumPlanesf planes;
+    XrFrustumPlanesf_Create(&planes, mvp);
+
+    for (int w = 0; w < (count + 31) / 32; w++) {
+        visibleBits[w] = 0;
+    }
+
+    int visible = 0;
+    int i = 0;
+#if defined(XR_LINEAR_SIMD)
+    XrLinearFrustumPlanes4 planes4;
+    XrLinearFrustumPlanes4_Create(&planes4, &planes);
+    const XrLinearFloat4 zero = XrLinearFloat4_Splat(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        const XrVector3f* c = &centers[i];
+        const XrVector3f* e = &extents[i];
+        XrLinearFloat4 center[3];
+        center[0] = XrLinearFloat4_Set(c[0].x, c[1].x, c[2].x, c[3].x);
+        center[1] = XrLinearFloat4_Set(c[0].y, c[1].y, c[2].y, c[3].y);
+        center[2] = XrLinearFloat4_Set(c[0].z, c[1].z, c[2].z, c[3].z);
+        XrLinearFloat4 extent[3];
+        extent[0] = XrLinearFloat4_Set(e[0].x, e[1].x, e[2].x, e[3].x);
+        extent[1] = XrLinearFloat4_Set(e[0].y, e[1].y, e[2].y, e[3].y);
+        extent[2] = XrLinearFloat4_Set(e[0].z, e[1].z, e[2].z, e[3].z);
+        const int empty = XrLinearFloat4_LessEqualBits(extent[0], zero) & XrLinearFloat4_LessEqualBits(extent[1], zero) &
+                          XrLinearFloat4_LessEqualBits(extent[2], zero);
+        const int visible4 = ~XrLinearFrustumPlanes4_CullCenterExtent(&planes4, center, extent) | empty;
+        // 'i' is a multiple of four, so the four bits are in the same word.
+        visibleBits[i / 32] |= (uint32_t)(visible4 & 0xF) << (i % 32);
+        visible += (visible4 & 1) + ((visible4 >> 1) & 1) + ((visible4 >> 2) & 1) + ((visible4 >> 3) & 1);
+    }
+#endif
+    for (; i < count; i++) {
+        const XrVector3f* c = &centers[i];
+        const XrVector3f* e = &extents[i];
+        const bool empty = e->x <= 0.0f && e->y <= 0.0f && e->z <= 0.0f;
+        if (empty || !XrFrustumPlanesf_CullCenterExtent(&planes, c->x, c->y, c->z, e->x, e->y, e->z)) {
+            visibleBits[i / 32] |= 1u << (i % 32);
+            visible++;
+        }
+    }
+    return visible;
+}
+
 #endif  // XR_LINEAR_H_
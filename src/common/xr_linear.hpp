@@ -0,0 +1,236 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// C++ value types over the math in xr_linear.h.
+//
+// The functions of xr_linear.h take their arguments and results through pointers, so the compiler has to assume they
+// may alias and can fold none of it at compile time.  The types here are passed and returned by value, which gives
+// the same freedom restrict-qualified pointers would, and everything that needs no square root or trigonometry is
+// constexpr: a projection matrix for a known field of view, for instance, can be a compile-time constant.  Each
+// operation does the same arithmetic, in the same order, as the xr_linear.h function it mirrors, and the types convert
+// implicitly to and from the OpenXR structures and XrMatrix4x4f.
+
+#pragma once
+
+#include "xr_linear.h"
+
+#include <cmath>
+
+namespace XrLinear {
+
+struct Vector3f {
+    float x, y, z;
+
+    constexpr Vector3f() : x(0.0f), y(0.0f), z(0.0f) {}
+    constexpr Vector3f(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+    constexpr Vector3f(const XrVector3f& v) : x(v.x), y(v.y), z(v.z) {}
+
+    constexpr operator XrVector3f() const { return XrVector3f{x, y, z}; }
+};
+
+constexpr Vector3f operator+(const Vector3f a, const Vector3f b) { return Vector3f(a.x + b.x, a.y + b.y, a.z + b.z); }
+constexpr Vector3f operator-(const Vector3f a, const Vector3f b) { return Vector3f(a.x - b.x, a.y - b.y, a.z - b.z); }
+constexpr Vector3f operator-(const Vector3f v) { return Vector3f(-v.x, -v.y, -v.z); }
+constexpr Vector3f operator*(const Vector3f v, const float s) { return Vector3f(v.x * s, v.y * s, v.z * s); }
+constexpr Vector3f operator*(const float s, const Vector3f v) { return Vector3f(v.x * s, v.y * s, v.z * s); }
+
+constexpr float Dot(const Vector3f a, const Vector3f b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+constexpr Vector3f Cross(const Vector3f a, const Vector3f b) {
+    return Vector3f(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+inline float Length(const Vector3f v) { return std::sqrt(Dot(v, v)); }
+inline Vector3f Normalize(const Vector3f v) { return v * XrRcpSqrt(Dot(v, v)); }
+
+struct Quaternionf {
+    float x, y, z, w;
+
+    constexpr Quaternionf() : x(0.0f), y(0.0f), z(0.0f), w(1.0f) {}
+    constexpr Quaternionf(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+    constexpr Quaternionf(const XrQuaternionf& q) : x(q.x), y(q.y), z(q.z), w(q.w) {}
+
+    constexpr operator XrQuaternionf() const { return XrQuaternionf{x, y, z, w}; }
+};
+
+// Rotating by a * b rotates by b and then by a, as with XrQuaternionf_Multiply.
+constexpr Quaternionf operator*(const Quaternionf a, const Quaternionf b) {
+    return Quaternionf(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y, a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                       a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w, a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+}
+
+// The inverse of a unit quaternion.
+constexpr Quaternionf Invert(const Quaternionf q) { return Quaternionf(-q.x, -q.y, -q.z, q.w); }
+
+namespace Detail {
+constexpr Vector3f Rotate(const Quaternionf q, const Vector3f v, const Vector3f t) {
+    return Vector3f(v.x + q.w * t.x + (q.y * t.z - q.z * t.y), v.y + q.w * t.y + (q.z * t.x - q.x * t.z),
+                    v.z + q.w * t.z + (q.x * t.y - q.y * t.x));
+}
+}  // namespace Detail
+
+// Rotates a vector by a unit quaternion, as XrQuaternionf_RotateVector3f does.
+constexpr Vector3f Rotate(const Quaternionf q, const Vector3f v) {
+    return Detail::Rotate(q, v, Vector3f(2.0f * (q.y * v.z - q.z * v.y), 2.0f * (q.z * v.x - q.x * v.z),
+                                         2.0f * (q.x * v.y - q.y * v.x)));
+}
+
+inline Quaternionf Normalize(const Quaternionf q) {
+    const float lengthRcp = XrRcpSqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return Quaternionf(q.x * lengthRcp, q.y * lengthRcp, q.z * lengthRcp, q.w * lengthRcp);
+}
+
+struct Posef {
+    Quaternionf orientation;
+    Vector3f position;
+
+    constexpr Posef() {}
+    constexpr Posef(const Quaternionf orientation_, const Vector3f position_) : orientation(orientation_), position(position_) {}
+    constexpr Posef(const XrPosef& pose) : orientation(pose.orientation), position(pose.position) {}
+
+    constexpr operator XrPosef() const { return XrPosef{orientation, position}; }
+};
+
+// With b relative to the space of a, a * b is b relative to the space a is relative to, as with XrPosef_Multiply.
+constexpr Posef operator*(const Posef a, const Posef b) {
+    return Posef(a.orientation * b.orientation, Rotate(a.orientation, b.position) + a.position);
+}
+
+// Transforms a point from the space of the pose to the space the pose is relative to.
+constexpr Vector3f operator*(const Posef pose, const Vector3f v) { return Rotate(pose.orientation, v) + pose.position; }
+
+// The inverse of a pose with a unit orientation.
+constexpr Posef Invert(const Posef pose) {
+    return Posef(Invert(pose.orientation), -Rotate(Invert(pose.orientation), pose.position));
+}
+
+// Column-major, pre-multiplied, like XrMatrix4x4f.
+struct Matrix4x4f {
+    float m[16];
+
+    constexpr Matrix4x4f() : m{1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f} {}
+    // The elements in memory order, a column at a time.
+    constexpr Matrix4x4f(float m0, float m1, float m2, float m3, float m4, float m5, float m6, float m7, float m8, float m9,
+                         float m10, float m11, float m12, float m13, float m14, float m15)
+        : m{m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15} {}
+    constexpr Matrix4x4f(const XrMatrix4x4f& matrix)
+        : m{matrix.m[0],  matrix.m[1],  matrix.m[2],  matrix.m[3],  matrix.m[4],  matrix.m[5],  matrix.m[6],  matrix.m[7],
+            matrix.m[8],  matrix.m[9],  matrix.m[10], matrix.m[11], matrix.m[12], matrix.m[13], matrix.m[14], matrix.m[15]} {}
+
+    constexpr operator XrMatrix4x4f() const {
+        return XrMatrix4x4f{{m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11], m[12], m[13], m[14], m[15]}};
+    }
+
+    // The element in row r of column c.
+    constexpr float operator()(int r, int c) const { return m[c * 4 + r]; }
+};
+
+namespace Detail {
+constexpr float Multiply(const Matrix4x4f& a, const Matrix4x4f& b, int r, int c) {
+    return a.m[r] * b.m[c * 4 + 0] + a.m[4 + r] * b.m[c * 4 + 1] + a.m[8 + r] * b.m[c * 4 + 2] + a.m[12 + r] * b.m[c * 4 + 3];
+}
+}  // namespace Detail
+
+// Use left-multiplication to accumulate transformations, as with XrMatrix4x4f_Multiply.
+constexpr Matrix4x4f operator*(const Matrix4x4f& a, const Matrix4x4f& b) {
+    return Matrix4x4f(Detail::Multiply(a, b, 0, 0), Detail::Multiply(a, b, 1, 0), Detail::Multiply(a, b, 2, 0),
+                      Detail::Multiply(a, b, 3, 0), Detail::Multiply(a, b, 0, 1), Detail::Multiply(a, b, 1, 1),
+                      Detail::Multiply(a, b, 2, 1), Detail::Multiply(a, b, 3, 1), Detail::Multiply(a, b, 0, 2),
+                      Detail::Multiply(a, b, 1, 2), Detail::Multiply(a, b, 2, 2), Detail::Multiply(a, b, 3, 2),
+                      Detail::Multiply(a, b, 0, 3), Detail::Multiply(a, b, 1, 3), Detail::Multiply(a, b, 2, 3),
+                      Detail::Multiply(a, b, 3, 3));
+}
+
+constexpr Matrix4x4f Transpose(const Matrix4x4f& a) {
+    return Matrix4x4f(a.m[0], a.m[4], a.m[8], a.m[12], a.m[1], a.m[5], a.m[9], a.m[13], a.m[2], a.m[6], a.m[10], a.m[14], a.m[3],
+                      a.m[7], a.m[11], a.m[15]);
+}
+
+// The inverse of a rigid body transform, as XrMatrix4x4f_InvertRigidBody calculates it.
+constexpr Matrix4x4f InvertRigidBody(const Matrix4x4f& a) {
+    return Matrix4x4f(a.m[0], a.m[4], a.m[8], 0.0f, a.m[1], a.m[5], a.m[9], 0.0f, a.m[2], a.m[6], a.m[10], 0.0f,
+                      -(a.m[0] * a.m[12] + a.m[1] * a.m[13] + a.m[2] * a.m[14]),
+                      -(a.m[4] * a.m[12] + a.m[5] * a.m[13] + a.m[6] * a.m[14]),
+                      -(a.m[8] * a.m[12] + a.m[9] * a.m[13] + a.m[10] * a.m[14]), 1.0f);
+}
+
+constexpr Matrix4x4f CreateTranslation(const Vector3f t) {
+    return Matrix4x4f(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, t.x, t.y, t.z, 1.0f);
+}
+
+constexpr Matrix4x4f CreateScale(const Vector3f s) {
+    return Matrix4x4f(s.x, 0.0f, 0.0f, 0.0f, 0.0f, s.y, 0.0f, 0.0f, 0.0f, 0.0f, s.z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+namespace Detail {
+constexpr Matrix4x4f TranslationRotationScale(const Vector3f t, const Vector3f s, float xx2, float yy2, float zz2, float yz2,
+                                              float wx2, float xy2, float wz2, float xz2, float wy2) {
+    return Matrix4x4f((1.0f - yy2 - zz2) * s.x, (xy2 + wz2) * s.x, (xz2 - wy2) * s.x, 0.0f, (xy2 - wz2) * s.y,
+                      (1.0f - xx2 - zz2) * s.y, (yz2 + wx2) * s.y, 0.0f, (xz2 + wy2) * s.z, (yz2 - wx2) * s.z,
+                      (1.0f - xx2 - yy2) * s.z, 0.0f, t.x, t.y, t.z, 1.0f);
+}
+}  // namespace Detail
+
+// Builds the matrix straight from the rotation and scale, as XrMatrix4x4f_CreateTranslationRotationScaleArray does.
+constexpr Matrix4x4f CreateTranslationRotationScale(const Vector3f t, const Quaternionf q, const Vector3f s) {
+    return Detail::TranslationRotationScale(t, s, q.x * (q.x + q.x), q.y * (q.y + q.y), q.z * (q.z + q.z), q.y * (q.z + q.z),
+                                            q.w * (q.x + q.x), q.x * (q.y + q.y), q.w * (q.z + q.z), q.x * (q.z + q.z),
+                                            q.w * (q.y + q.y));
+}
+
+constexpr Matrix4x4f CreateFromPose(const Posef pose) {
+    return CreateTranslationRotationScale(pose.position, pose.orientation, Vector3f(1.0f, 1.0f, 1.0f));
+}
+
+namespace Detail {
+constexpr Matrix4x4f Projection(float tanAngleLeft, float tanAngleRight, float tanAngleUp, float tanAngleDown, float tanAngleWidth,
+                                float tanAngleHeight, float offsetZ, float nearZ, float farZ) {
+    return Matrix4x4f(2 / tanAngleWidth, 0, 0, 0, 0, 2 / tanAngleHeight, 0, 0, (tanAngleRight + tanAngleLeft) / tanAngleWidth,
+                      (tanAngleUp + tanAngleDown) / tanAngleHeight, farZ <= nearZ ? -1 : -(farZ + offsetZ) / (farZ - nearZ), -1, 0,
+                      0, farZ <= nearZ ? -(nearZ + offsetZ) : -(farZ * (nearZ + offsetZ)) / (farZ - nearZ), 0);
+}
+}  // namespace Detail
+
+// The projection XrMatrix4x4f_CreateProjection creates, with the graphics API fixed at compile time.  A farZ that is not
+// beyond nearZ places the far plane at infinity.
+template <GraphicsAPI graphicsApi>
+constexpr Matrix4x4f CreateProjection(float tanAngleLeft, float tanAngleRight, float tanAngleUp, float tanAngleDown, float nearZ,
+                                      float farZ) {
+    return Detail::Projection(tanAngleLeft, tanAngleRight, tanAngleUp, tanAngleDown, tanAngleRight - tanAngleLeft,
+                              graphicsApi == GRAPHICS_VULKAN ? (tanAngleDown - tanAngleUp) : (tanAngleUp - tanAngleDown),
+                              (graphicsApi == GRAPHICS_OPENGL || graphicsApi == GRAPHICS_OPENGL_ES) ? nearZ : 0, nearZ, farZ);
+}
+
+// The projection XrMatrix4x4f_CreateProjectionFov creates, with the graphics API fixed at compile time.  The tangents
+// of the angles are not constant expressions, so this is only constexpr through CreateProjection.
+template <GraphicsAPI graphicsApi>
+inline Matrix4x4f CreateProjectionFov(const XrFovf fov, float nearZ, float farZ) {
+    return CreateProjection<graphicsApi>(std::tan(fov.angleLeft), std::tan(fov.angleRight), std::tan(fov.angleUp),
+                                         std::tan(fov.angleDown), nearZ, farZ);
+}
+
+// Transforms a direction, ignoring the translation.
+constexpr Vector3f TransformDirection(const Matrix4x4f& m, const Vector3f v) {
+    return Vector3f(m.m[0] * v.x + m.m[4] * v.y + m.m[8] * v.z, m.m[1] * v.x + m.m[5] * v.y + m.m[9] * v.z,
+                    m.m[2] * v.x + m.m[6] * v.y + m.m[10] * v.z);
+}
+
+// Transforms a 4D vector, as XrMatrix4x4f_TransformVector4f does.
+constexpr XrVector4f operator*(const Matrix4x4f& m, const XrVector4f v) {
+    return XrVector4f{m.m[0] * v.x + m.m[4] * v.y + m.m[8] * v.z + m.m[12] * v.w,
+                      m.m[1] * v.x + m.m[5] * v.y + m.m[9] * v.z + m.m[13] * v.w,
+                      m.m[2] * v.x + m.m[6] * v.y + m.m[10] * v.z + m.m[14] * v.w,
+                      m.m[3] * v.x + m.m[7] * v.y + m.m[11] * v.z + m.m[15] * v.w};
+}
+
+}  // namespace XrLinear
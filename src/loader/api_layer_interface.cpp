@@ -19,9 +19,11 @@
 
 #include "api_layer_interface.hpp"
 
+#include "loader_environment.hpp"
 #include "loader_interfaces.h"
 #include "loader_logger.hpp"
 #include "loader_platform.hpp"
+#include "loader_trace.hpp"
 #include "manifest_file.hpp"
 #include "platform_utils.hpp"
 
@@ -38,10 +40,8 @@
 
 // Add any layers defined in the loader layer environment variable.
 static void AddEnvironmentApiLayers(const std::string& openxr_command, std::vector<std::string>& enabled_layers) {
-    char* layer_environment_variable = PlatformUtilsGetEnv(OPENXR_ENABLE_LAYERS_ENV_VAR);
-    if (nullptr != layer_environment_variable) {
-        std::string layers = layer_environment_variable;
-        PlatformUtilsFreeEnv(layer_environment_variable);
+    std::string layers;
+    if (LoaderGetEnv(OPENXR_ENABLE_LAYERS_ENV_VAR, layers)) {
 
         std::size_t last_found = 0;
         std::size_t found = layers.find_first_of(PATH_SEPARATOR);
@@ -49,7 +49,7 @@ static void AddEnvironmentApiLayers(const std::string& openxr_command, std::vect
 
         // Handle any path listings in the string (separated by the appropriate path separator)
         while (found != std::string::npos) {
-            cur_search = layers.substr(last_found, found);
+            cur_search = layers.substr(last_found, found - last_found);
             enabled_layers.push_back(cur_search);
             last_found = found + 1;
             found = layers.find_first_of(PATH_SEPARATOR, last_found);
@@ -196,6 +196,7 @@ XrResult ApiLayerInterface::GetInstanceExtensionProperties(const std::string& op
 XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uint32_t enabled_api_layer_count,
                                           const char* const* enabled_api_layer_names,
                                           std::vector<std::unique_ptr<ApiLayerInterface>>& api_layer_interfaces) {
+    LoaderTraceScope trace("ApiLayerInterface::LoadApiLayers");
     XrResult last_error = XR_SUCCESS;
     bool any_loaded = false;
     std::vector<bool> layer_found;
@@ -234,6 +235,9 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
         layer = false;
     }
 
+    // Decide which layers are enabled before loading any of them, so that a missing layer fails the call without
+    // opening (and running the initialization code of) every other layer's library first.
+    std::vector<ApiLayerManifestFile*> enabled_manifest_files;
     for (std::unique_ptr<ApiLayerManifestFile>& manifest_file : layer_manifest_files) {
         bool enabled = false;
 
@@ -252,12 +256,28 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
             }
         }
 
-        // If this layer isn't enabled, skip it.
-        if (!enabled) {
-            continue;
+        if (enabled) {
+            enabled_manifest_files.push_back(manifest_file.get());
+        }
+    }
+
+    // If even one of the layers wasn't found, we want to return an error
+    for (uint32_t layer = 0; layer < layer_found.size(); ++layer) {
+        if (!layer_found[layer]) {
+            std::string error_message = "ApiLayerInterface::LoadApiLayers - failed to find layer ";
+            error_message += enabled_api_layers[layer];
+            LoaderLogger::LogErrorMessage(openxr_command, error_message);
+            last_error = XR_ERROR_API_LAYER_NOT_PRESENT;
         }
+    }
+    if (XR_SUCCESS != last_error) {
+        return last_error;
+    }
 
+    for (ApiLayerManifestFile* manifest_file : enabled_manifest_files) {
+        LoaderTraceScope open_trace("Open API layer library", manifest_file->LibraryPath());
         LoaderPlatformLibraryHandle layer_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+        open_trace.End();
         if (nullptr == layer_library) {
             if (!any_loaded) {
                 last_error = XR_ERROR_FILE_ACCESS_ERROR;
@@ -303,7 +323,9 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
         api_layer_info.structVersion = XR_API_LAYER_INFO_STRUCT_VERSION;
         api_layer_info.structSize = sizeof(XrNegotiateApiLayerRequest);
 
+        LoaderTraceScope negotiate_trace("Negotiate API layer interface", manifest_file->LayerName());
         XrResult res = negotiate(&loader_info, manifest_file->LayerName().c_str(), &api_layer_info);
+        negotiate_trace.End();
         // If we supposedly succeeded, but got a nullptr for getInstanceProcAddr
         // then something still went wrong, so return with an error.
         if (XR_SUCCESS == res && nullptr == api_layer_info.getInstanceProcAddr) {
@@ -325,7 +347,7 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
             continue;
         }
 
-        {
+        if (LoaderLogger::IsInfoEnabled()) {
             std::ostringstream oss;
             oss << "ApiLayerInterface::LoadApiLayers succeeded loading layer " << manifest_file->LayerName()
                 << " using interface version " << api_layer_info.layerInterfaceVersion << " and OpenXR API version "
@@ -348,21 +370,47 @@ XrResult ApiLayerInterface::LoadApiLayers(const std::string& openxr_command, uin
                                                                 api_layer_info.getInstanceProcAddr,
                                                                 api_layer_info.createApiLayerInstance));
 
+        // Layers can say which commands they intercept, so that the loader can send the rest past them (optional).
+        function_name = manifest_file->GetFunctionName("xrEnumerateApiLayerInterceptedCommands");
+        auto enumerate_intercepted_commands = reinterpret_cast<PFN_xrEnumerateApiLayerInterceptedCommands>(
+            LoaderPlatformLibraryGetProcAddr(layer_library, function_name));
+        if (nullptr != enumerate_intercepted_commands) {
+            uint32_t command_count = 0;
+            std::vector<const char*> command_names;
+            res = enumerate_intercepted_commands(manifest_file->LayerName().c_str(), 0, &command_count, nullptr);
+            if (XR_SUCCESS == res) {
+                command_names.resize(command_count);
+                res = enumerate_intercepted_commands(manifest_file->LayerName().c_str(), command_count, &command_count,
+                                                     command_names.data());
+            }
+            if (XR_SUCCESS == res) {
+                std::vector<std::string> intercepted_commands;
+                intercepted_commands.reserve(command_count);
+                for (uint32_t command = 0; command < command_count && command < command_names.size(); ++command) {
+                    if (nullptr != command_names[command]) {
+                        intercepted_commands.emplace_back(command_names[command]);
+                    }
+                }
+                api_layer_interfaces.back()->SetInterceptedCommands(intercepted_commands);
+                if (LoaderLogger::IsInfoEnabled()) {
+                    std::ostringstream oss;
+                    oss << "ApiLayerInterface::LoadApiLayers layer " << manifest_file->LayerName() << " intercepts "
+                        << intercepted_commands.size() << " commands";
+                    LoaderLogger::LogInfoMessage(openxr_command, oss.str());
+                }
+            } else {
+                std::ostringstream oss;
+                oss << "ApiLayerInterface::LoadApiLayers layer " << manifest_file->LayerName() << " failed to list its "
+                    << "intercepted commands with error " << res << ", so every command will be sent through it";
+                LoaderLogger::LogWarningMessage(openxr_command, oss.str());
+            }
+        }
+
         // If we load one, clear all errors.
         any_loaded = true;
         last_error = XR_SUCCESS;
     }
 
-    // If even one of the layers wasn't found, we want to return an error
-    for (uint32_t layer = 0; layer < layer_found.size(); ++layer) {
-        if (!layer_found[layer]) {
-            std::string error_message = "ApiLayerInterface::LoadApiLayers - failed to find layer ";
-            error_message += enabled_api_layers[layer];
-            LoaderLogger::LogErrorMessage(openxr_command, error_message);
-            last_error = XR_ERROR_API_LAYER_NOT_PRESENT;
-        }
-    }
-
     // Always clear the manifest file list.  Either we use them or we don't.
     layer_manifest_files.clear();
 
@@ -381,13 +429,17 @@ ApiLayerInterface::ApiLayerInterface(const std::string& layer_name, LoaderPlatfo
     : _layer_name(layer_name),
       _layer_library(layer_library),
       _get_instant_proc_addr(get_instant_proc_addr),
+      _dispatch_get_instance_proc_addr(get_instant_proc_addr),
       _create_api_layer_instance(create_api_layer_instance),
-      _supported_extensions(supported_extensions) {}
+      _supported_extensions(supported_extensions),
+      _reports_intercepted_commands(false) {}
 
 ApiLayerInterface::~ApiLayerInterface() {
-    std::string info_message = "ApiLayerInterface being destroyed for layer ";
-    info_message += _layer_name;
-    LoaderLogger::LogInfoMessage("", info_message);
+    if (LoaderLogger::IsInfoEnabled()) {
+        std::string info_message = "ApiLayerInterface being destroyed for layer ";
+        info_message += _layer_name;
+        LoaderLogger::LogInfoMessage("", info_message);
+    }
     LoaderPlatformLibraryClose(_layer_library);
 }
 
@@ -401,3 +453,22 @@ bool ApiLayerInterface::SupportsExtension(const std::string& extension_name) {
     }
     return found_prop;
 }
+
+void ApiLayerInterface::SetInterceptedCommands(std::vector<std::string>& intercepted_commands) {
+    _intercepted_commands.clear();
+    _intercepted_commands.insert(intercepted_commands.begin(), intercepted_commands.end());
+    _reports_intercepted_commands = true;
+}
+
+bool ApiLayerInterface::InterceptsCommand(const char* command_name) const {
+    if (!_reports_intercepted_commands) {
+        return true;
+    }
+    // A layer always has to see its instance come and go, and its own xrGetInstanceProcAddr is what it hands out for
+    // everything else.
+    if (0 == strcmp(command_name, "xrGetInstanceProcAddr") || 0 == strcmp(command_name, "xrCreateApiLayerInstance") ||
+        0 == strcmp(command_name, "xrDestroyInstance")) {
+        return true;
+    }
+    return _intercepted_commands.find(command_name) != _intercepted_commands.end();
+}
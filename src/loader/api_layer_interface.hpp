@@ -20,6 +20,7 @@
 #pragma once
 
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include <memory>
 
@@ -52,14 +53,30 @@ class ApiLayerInterface {
 
     std::string LayerName() { return _layer_name; }
 
+    // The commands the layer reported through xrEnumerateApiLayerInterceptedCommands.  Layers that did not report any
+    // are taken to intercept everything.
+    void SetInterceptedCommands(std::vector<std::string>& intercepted_commands);
+    bool ReportsInterceptedCommands() const { return _reports_intercepted_commands; }
+    bool InterceptsCommand(const char* command_name) const;
+
+    // The xrGetInstanceProcAddr GenUpdateInstanceDispatchTable looks commands up with: the layer's own, unless the loader
+    // replaced it with one that skips the layers that only forward a command.
+    void SetDispatchGetInstanceProcAddr(PFN_xrGetInstanceProcAddr get_instance_proc_addr) {
+        _dispatch_get_instance_proc_addr = get_instance_proc_addr;
+    }
+    PFN_xrGetInstanceProcAddr DispatchGetInstanceProcAddr() const { return _dispatch_get_instance_proc_addr; }
+
     // Generated methods
-    void GenUpdateInstanceDispatchTable(XrInstance instance, std::unique_ptr<XrGeneratedDispatchTable>& table);
+    void GenUpdateInstanceDispatchTable(XrInstance instance, std::unique_ptr<XrGeneratedDispatchTable>& table, bool lazy);
     bool SupportsExtension(const std::string& extension_name);
 
    private:
     std::string _layer_name;
     LoaderPlatformLibraryHandle _layer_library;
     PFN_xrGetInstanceProcAddr _get_instant_proc_addr;
+    PFN_xrGetInstanceProcAddr _dispatch_get_instance_proc_addr;
     PFN_xrCreateApiLayerInstance _create_api_layer_instance;
     std::vector<std::string> _supported_extensions;
+    bool _reports_intercepted_commands;
+    std::unordered_set<std::string> _intercepted_commands;
 };
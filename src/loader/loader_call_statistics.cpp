@@ -0,0 +1,155 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "loader_call_statistics.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+const size_t kCacheLineSize = 64;
+
+struct CommandCounters {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> latency_histogram[LoaderCallStatistics::kLatencyBucketCount];
+};
+static_assert(std::is_trivially_destructible<CommandCounters>::value, "CommandCounters are never destroyed individually");
+
+// Which counters the current thread last recorded into, so the common case needs no lock.
+struct ThreadCountersCache {
+    uint64_t statistics_id;
+    CommandCounters* commands;
+};
+thread_local ThreadCountersCache t_counters_cache = {0, nullptr};
+
+// Ids are never reused, so a cache entry left behind by a destroyed instance can never match a new one.
+std::atomic<uint64_t> g_next_statistics_id{1};
+
+// Only the owning thread ever writes a counter, so a plain load and store is enough.
+inline void AddToCounter(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline uint32_t LatencyBucket(uint64_t nanoseconds) {
+    uint32_t bucket = 0;
+    while (nanoseconds > 1 && bucket < LoaderCallStatistics::kLatencyBucketCount - 1) {
+        nanoseconds >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+}  // namespace
+
+struct LoaderCallStatistics::ThreadCounters {
+    explicit ThreadCounters(uint32_t command_count) {
+        // Start the counters on a cache line boundary and round them up to whole lines, so that nothing else shares a
+        // line with them.
+        size_t bytes = command_count * sizeof(CommandCounters);
+        bytes = (bytes + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+        storage.reset(new unsigned char[bytes + kCacheLineSize]);
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+        address = (address + kCacheLineSize - 1) & ~static_cast<uintptr_t>(kCacheLineSize - 1);
+        commands = reinterpret_cast<CommandCounters*>(address);
+        for (uint32_t command = 0; command < command_count; ++command) {
+            CommandCounters* counters = new (&commands[command]) CommandCounters;
+            counters->calls.store(0, std::memory_order_relaxed);
+            counters->total_ns.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint64_t>& bucket : counters->latency_histogram) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::unique_ptr<unsigned char[]> storage;
+    CommandCounters* commands;
+};
+
+LoaderCallStatistics::LoaderCallStatistics(uint32_t command_count)
+    : _id(g_next_statistics_id.fetch_add(1)), _command_count(command_count) {}
+
+LoaderCallStatistics::~LoaderCallStatistics() = default;
+
+LoaderCallStatistics::ThreadCounters* LoaderCallStatistics::CountersForCurrentThread() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::unique_ptr<ThreadCounters>& counters = _thread_counters[std::this_thread::get_id()];
+    if (!counters) {
+        counters.reset(new ThreadCounters(_command_count));
+    }
+    t_counters_cache.statistics_id = _id;
+    t_counters_cache.commands = counters->commands;
+    return counters.get();
+}
+
+void LoaderCallStatistics::Record(uint32_t command, uint64_t nanoseconds) {
+    if (command >= _command_count) {
+        return;
+    }
+    CommandCounters* commands =
+        (t_counters_cache.statistics_id == _id) ? t_counters_cache.commands : CountersForCurrentThread()->commands;
+    CommandCounters& counters = commands[command];
+    AddToCounter(counters.calls, 1);
+    AddToCounter(counters.total_ns, nanoseconds);
+    AddToCounter(counters.latency_histogram[LatencyBucket(nanoseconds)], 1);
+}
+
+// Must be called with _mutex held.
+void LoaderCallStatistics::SumThreadCounters(std::vector<CommandTotals>& totals) {
+    totals.assign(_command_count, CommandTotals{});
+    for (auto& thread_counters : _thread_counters) {
+        const CommandCounters* commands = thread_counters.second->commands;
+        for (uint32_t command = 0; command < _command_count; ++command) {
+            CommandTotals& total = totals[command];
+            total.calls += commands[command].calls.load(std::memory_order_relaxed);
+            total.total_ns += commands[command].total_ns.load(std::memory_order_relaxed);
+            for (uint32_t bucket = 0; bucket < kLatencyBucketCount; ++bucket) {
+                total.latency_histogram[bucket] += commands[command].latency_histogram[bucket].load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void LoaderCallStatistics::GetTotals(std::vector<CommandTotals>& totals) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    SumThreadCounters(totals);
+    if (_reset_totals.empty()) {
+        return;
+    }
+    for (uint32_t command = 0; command < _command_count; ++command) {
+        CommandTotals& total = totals[command];
+        const CommandTotals& reset_total = _reset_totals[command];
+        total.calls -= reset_total.calls;
+        total.total_ns -= reset_total.total_ns;
+        for (uint32_t bucket = 0; bucket < kLatencyBucketCount; ++bucket) {
+            total.latency_histogram[bucket] -= reset_total.latency_histogram[bucket];
+        }
+    }
+}
+
+void LoaderCallStatistics::Reset() {
+    // The counters belong to the threads writing them, so rather than clearing them remember where they were.
+    std::unique_lock<std::mutex> lock(_mutex);
+    SumThreadCounters(_reset_totals);
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_loader_statistics.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// Call counters and latency histograms for the trampolines of one LoaderInstance (XR_EXTX_loader_call_statistics).
+///
+/// Every thread that records a call gets its own block of counters, aligned to and padded out to whole cache lines, which
+/// only that thread ever writes; it does so with relaxed loads and stores rather than read-modify-write instructions.  A
+/// thread finds its block through a one-entry thread-local cache, so the mutex is only taken the first time a thread records
+/// into this object, or after it has recorded into another instance's statistics in between.  Readers sum the blocks of all
+/// threads under the mutex.  Blocks are kept until the object is destroyed, so calls made by threads that have since exited
+/// are still counted.
+class LoaderCallStatistics {
+   public:
+    static const uint32_t kLatencyBucketCount = XR_LOADER_CALL_LATENCY_BUCKET_COUNT_EXTX;
+
+    /// Totals for one command, summed over all threads.
+    struct CommandTotals {
+        uint64_t calls;
+        uint64_t total_ns;
+        std::array<uint64_t, kLatencyBucketCount> latency_histogram;
+    };
+
+    explicit LoaderCallStatistics(uint32_t command_count);
+    ~LoaderCallStatistics();
+
+    uint32_t CommandCount() const { return _command_count; }
+
+    /// Record one call of the given command that took the given number of nanoseconds.
+    void Record(uint32_t command, uint64_t nanoseconds);
+
+    /// Fill in the totals for every command since creation or the last Reset, indexed by command.
+    void GetTotals(std::vector<CommandTotals>& totals);
+
+    /// Make GetTotals start again from zero.
+    void Reset();
+
+   private:
+    struct ThreadCounters;
+
+    ThreadCounters* CountersForCurrentThread();
+    void SumThreadCounters(std::vector<CommandTotals>& totals);
+
+    const uint64_t _id;
+    const uint32_t _command_count;
+    std::mutex _mutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<ThreadCounters>> _thread_counters;
+    // Totals at the time of the last Reset, subtracted from what the threads have counted.
+    std::vector<CommandTotals> _reset_totals;
+};
+
+/// Times a trampoline call for the instance's statistics, if it has them.
+/// With statistics disabled this costs a null check on construction and on destruction.
+class LoaderCallTimer {
+   public:
+    LoaderCallTimer(LoaderCallStatistics* statistics, uint32_t command) : _statistics(statistics), _command(command) {
+        if (nullptr != _statistics) {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+    ~LoaderCallTimer() {
+        if (nullptr != _statistics) {
+            auto elapsed = std::chrono::steady_clock::now() - _start;
+            _statistics->Record(_command,
+                                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    }
+
+    LoaderCallTimer(const LoaderCallTimer&) = delete;
+    LoaderCallTimer& operator=(const LoaderCallTimer&) = delete;
+
+   private:
+    LoaderCallStatistics* _statistics;
+    uint32_t _command;
+    std::chrono::steady_clock::time_point _start;
+};
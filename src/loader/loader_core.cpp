@@ -24,33 +24,32 @@
 #include "api_layer_interface.hpp"
 #include "exception_handling.hpp"
 #include "hex_and_handles.h"
+#include "loader_call_statistics.hpp"
+#include "loader_environment.hpp"
 #include "loader_instance.hpp"
 #include "loader_logger_recorders.hpp"
 #include "loader_logger.hpp"
 #include "loader_platform.hpp"
+#include "loader_trace.hpp"
 #include "runtime_interface.hpp"
 #include "xr_generated_dispatch_table.h"
 #include "xr_generated_loader.hpp"
 
 #include <openxr/openxr.h>
+#include <openxr/openxr_loader_statistics.h>
 
 #include <cstring>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 // Flag to cause the one time to init to only occur one time.
 std::once_flag g_one_time_init_flag;
 
-// Global lock to prevent reading JSON manifest files at the same time.
-static std::mutex g_loader_json_mutex;
-
-// Global lock to prevent simultaneous instance creation/destruction
-static std::mutex g_loader_instance_mutex;
-
 // Utility template function meant to validate if a fixed size string contains
 // a null-terminator.
 template <size_t max_length>
@@ -70,11 +69,10 @@ extern "C" {
 LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrEnumerateApiLayerProperties(uint32_t propertyCapacityInput,
                                                                            uint32_t *propertyCountOutput,
                                                                            XrApiLayerProperties *properties) XRLOADER_ABI_TRY {
+    LoaderTraceCommand trace("xrEnumerateApiLayerProperties");
+    LoaderEnvironmentSnapshot environment;
     LoaderLogger::LogVerboseMessage("xrEnumerateApiLayerProperties", "Entering loader trampoline");
 
-    // Make sure only one thread is attempting to read the JSON files at a time.
-    std::unique_lock<std::mutex> json_lock(g_loader_json_mutex);
-
     XrResult result = ApiLayerInterface::GetApiLayerProperties("xrEnumerateApiLayerProperties", propertyCapacityInput,
                                                                propertyCountOutput, properties);
     if (XR_SUCCESS != result) {
@@ -88,6 +86,8 @@ XRLOADER_ABI_CATCH_FALLBACK
 LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL
 xrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t propertyCapacityInput, uint32_t *propertyCountOutput,
                                        XrExtensionProperties *properties) XRLOADER_ABI_TRY {
+    LoaderTraceCommand trace("xrEnumerateInstanceExtensionProperties");
+    LoaderEnvironmentSnapshot environment;
     bool just_layer_properties = false;
     LoaderLogger::LogVerboseMessage("xrEnumerateInstanceExtensionProperties", "Entering loader trampoline");
 
@@ -99,23 +99,15 @@ xrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t propertyC
     std::vector<XrExtensionProperties> extension_properties = {};
     XrResult result;
 
-    {
-        // Make sure only one thread is attempting to read the JSON files at a time.
-        std::unique_lock<std::mutex> json_lock(g_loader_json_mutex);
-
-        // Get the layer extension properties
-        result = ApiLayerInterface::GetInstanceExtensionProperties("xrEnumerateInstanceExtensionProperties", layerName,
-                                                                   extension_properties);
-        if (XR_SUCCESS == result && !just_layer_properties) {
-            // If not specific to a layer, get the runtime extension properties
-            result = RuntimeInterface::LoadRuntime("xrEnumerateInstanceExtensionProperties");
-            if (XR_SUCCESS == result) {
-                RuntimeInterface::GetRuntime().GetInstanceExtensionProperties(extension_properties);
-                RuntimeInterface::UnloadRuntime("xrEnumerateInstanceExtensionProperties");
-            } else {
-                LoaderLogger::LogErrorMessage("xrEnumerateInstanceExtensionProperties",
-                                              "Failed to find default runtime with RuntimeInterface::LoadRuntime()");
-            }
+    // Get the layer extension properties
+    result = ApiLayerInterface::GetInstanceExtensionProperties("xrEnumerateInstanceExtensionProperties", layerName,
+                                                               extension_properties);
+    if (XR_SUCCESS == result && !just_layer_properties) {
+        // If not specific to a layer, get the runtime extension properties
+        result = RuntimeInterface::GetRuntimeExtensionProperties("xrEnumerateInstanceExtensionProperties", extension_properties);
+        if (XR_SUCCESS != result) {
+            LoaderLogger::LogErrorMessage("xrEnumerateInstanceExtensionProperties",
+                                          "Failed to find default runtime with RuntimeInterface::LoadRuntime()");
         }
     }
 
@@ -127,20 +119,21 @@ xrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t propertyC
     // If this is not in reference to a specific layer, then add the loader-specific extension properties as well.
     // These are extensions that the loader directly supports.
     if (!just_layer_properties) {
+        std::unordered_map<std::string, size_t> existing_index;
+        existing_index.reserve(extension_properties.size());
+        for (size_t prop = 0; prop < extension_properties.size(); ++prop) {
+            existing_index.emplace(extension_properties[prop].extensionName, prop);
+        }
         for (const XrExtensionProperties &loader_prop : LoaderInstance::LoaderSpecificExtensions()) {
-            bool found_prop = false;
-            for (XrExtensionProperties &existing_prop : extension_properties) {
-                if (0 == strcmp(existing_prop.extensionName, loader_prop.extensionName)) {
-                    found_prop = true;
-                    // Use the loader version if it is newer
-                    if (existing_prop.extensionVersion < loader_prop.extensionVersion) {
-                        existing_prop.extensionVersion = loader_prop.extensionVersion;
-                    }
-                    break;
+            auto it = existing_index.find(loader_prop.extensionName);
+            if (it != existing_index.end()) {
+                // Use the loader version if it is newer
+                XrExtensionProperties &existing_prop = extension_properties[it->second];
+                if (existing_prop.extensionVersion < loader_prop.extensionVersion) {
+                    existing_prop.extensionVersion = loader_prop.extensionVersion;
                 }
-            }
-            // Only add extensions not supported by the loader
-            if (!found_prop) {
+            } else {
+                // Only add extensions not supported by the loader
                 extension_properties.push_back(loader_prop);
             }
         }
@@ -197,6 +190,9 @@ XRLOADER_ABI_CATCH_FALLBACK
 
 LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCreateInfo *info,
                                                               XrInstance *instance) XRLOADER_ABI_TRY {
+    LoaderTraceCommand trace("xrCreateInstance");
+    // Read each environment variable once for the whole of instance creation
+    LoaderEnvironmentSnapshot environment;
     bool runtime_loaded = false;
 
     LoaderLogger::LogVerboseMessage("xrCreateInstance", "Entering loader trampoline");
@@ -225,22 +221,19 @@ LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCr
 
     std::vector<std::unique_ptr<ApiLayerInterface>> api_layer_interfaces;
 
-    // Make sure only one thread is attempting to read the JSON files and use the instance.
-    XrResult result;
-    {
-        std::unique_lock<std::mutex> json_lock(g_loader_json_mutex);
-        // Load the available runtime
-        result = RuntimeInterface::LoadRuntime("xrCreateInstance");
+    // Nothing here is serialized across threads: manifest parsing and the runtime reference count guard themselves, and
+    // everything else belongs to the instance being created.
+    // Load the available runtime
+    XrResult result = RuntimeInterface::LoadRuntime("xrCreateInstance");
+    if (XR_SUCCESS != result) {
+        LoaderLogger::LogErrorMessage("xrCreateInstance", "Failed loading runtime information");
+    } else {
+        runtime_loaded = true;
+        // Load the appropriate layers
+        result = ApiLayerInterface::LoadApiLayers("xrCreateInstance", info->enabledApiLayerCount, info->enabledApiLayerNames,
+                                                  api_layer_interfaces);
         if (XR_SUCCESS != result) {
-            LoaderLogger::LogErrorMessage("xrCreateInstance", "Failed loading runtime information");
-        } else {
-            runtime_loaded = true;
-            // Load the appropriate layers
-            result = ApiLayerInterface::LoadApiLayers("xrCreateInstance", info->enabledApiLayerCount, info->enabledApiLayerNames,
-                                                      api_layer_interfaces);
-            if (XR_SUCCESS != result) {
-                LoaderLogger::LogErrorMessage("xrCreateInstance", "Failed loading layer information");
-            }
+            LoaderLogger::LogErrorMessage("xrCreateInstance", "Failed loading layer information");
         }
     }
 
@@ -251,8 +244,6 @@ LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCr
         return result;
     }
 
-    std::unique_lock<std::mutex> instance_lock(g_loader_instance_mutex);
-
     // Create the loader instance (only send down first runtime interface)
     XrInstance created_instance = XR_NULL_HANDLE;
     result = LoaderInstance::CreateInstance(std::move(api_layer_interfaces), info, &created_instance);
@@ -287,6 +278,7 @@ LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCr
 XRLOADER_ABI_CATCH_FALLBACK
 
 LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrDestroyInstance(XrInstance instance) XRLOADER_ABI_TRY {
+    LoaderTraceCommand trace("xrDestroyInstance");
     LoaderLogger::LogVerboseMessage("xrDestroyInstance", "Entering loader trampoline");
     // Runtimes may detect XR_NULL_HANDLE provided as a required handle parameter and return XR_ERROR_HANDLE_INVALID. - 2.9
     if (XR_NULL_HANDLE == instance) {
@@ -313,17 +305,19 @@ LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrDestroyInstance(XrInstance instan
         LoaderLogger::LogErrorMessage("xrDestroyInstance", "Unknown error occurred calling down chain");
     }
 
-    // Cleanup any map entries that may still be using this instance
+    // Cleanup any map entries that may still be using this instance.  This also moves every map on to a new epoch, so no
+    // thread's cached lookup can hand out loader_instance once it is deleted below.
     LoaderCleanUpMapsForInstance(loader_instance);
 
-    // Lock the instance create/destroy mutex
-    std::unique_lock<std::mutex> loader_instance_lock(g_loader_instance_mutex);
     delete loader_instance;
     LoaderLogger::LogVerboseMessage("xrDestroyInstance", "Completed loader trampoline");
 
     // Finally, unload the runtime if necessary
     RuntimeInterface::UnloadRuntime("xrDestroyInstance");
 
+    // Don't leave this instance's last messages sitting in a buffer
+    LoaderLogger::Flush();
+
     return XR_SUCCESS;
 }
 XRLOADER_ABI_CATCH_FALLBACK
@@ -389,8 +383,31 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermCreateInstance(const XrInstanceCreate
                                                 "something wrong with XrInstanceCreateInfo contents");
         return result;
     }
-    result = RuntimeInterface::GetRuntime().CreateInstance(info, instance);
-    loader_instance->SetRuntimeInstance(*instance);
+
+    // Don't ask the runtime for extensions that the loader implements on its behalf.
+    XrInstanceCreateInfo runtime_info = *info;
+    std::vector<const char *> runtime_extension_names;
+    runtime_extension_names.reserve(info->enabledExtensionCount);
+    for (uint32_t ext = 0; ext < info->enabledExtensionCount; ++ext) {
+        const char *extension_name = info->enabledExtensionNames[ext];
+        bool loader_only = false;
+        if (!RuntimeInterface::GetRuntime().SupportsExtension(extension_name)) {
+            for (const XrExtensionProperties &loader_extension : LoaderInstance::LoaderSpecificExtensions()) {
+                if (0 == strcmp(loader_extension.extensionName, extension_name)) {
+                    loader_only = true;
+                    break;
+                }
+            }
+        }
+        if (!loader_only) {
+            runtime_extension_names.push_back(extension_name);
+        }
+    }
+    runtime_info.enabledExtensionCount = static_cast<uint32_t>(runtime_extension_names.size());
+    runtime_info.enabledExtensionNames = runtime_extension_names.empty() ? nullptr : runtime_extension_names.data();
+
+    result = RuntimeInterface::GetRuntime().CreateInstance(&runtime_info, instance);
+    loader_instance->SetRuntimeInstance(*instance, XR_SUCCEEDED(result) ? RuntimeInterface::GetDispatchTable(*instance) : nullptr);
     LoaderLogger::LogVerboseMessage("xrCreateInstance", "Completed loader terminator");
     return result;
 }
@@ -425,7 +442,7 @@ XRAPI_ATTR XrResult XRAPI_CALL xrCreateDebugUtilsMessengerEXT(XrInstance instanc
         return XR_ERROR_HANDLE_INVALID;
     }
 
-    if (!loader_instance->ExtensionIsEnabled(XR_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+    if (!loader_instance->ExtensionIsEnabled(LOADER_EXTENSION_XR_EXT_DEBUG_UTILS)) {
         std::string error_str = "The ";
         error_str += XR_EXT_DEBUG_UTILS_EXTENSION_NAME;
         error_str += " extension has not been enabled prior to calling xrCreateDebugUtilsMessengerEXT";
@@ -468,7 +485,7 @@ XRLOADER_ABI_CATCH_BAD_ALLOC_OOM XRLOADER_ABI_CATCH_FALLBACK
         return XR_ERROR_HANDLE_INVALID;
     }
 
-    if (!loader_instance->ExtensionIsEnabled(XR_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+    if (!loader_instance->ExtensionIsEnabled(LOADER_EXTENSION_XR_EXT_DEBUG_UTILS)) {
         std::string error_str = "The ";
         error_str += XR_EXT_DEBUG_UTILS_EXTENSION_NAME;
         error_str += " extension has not been enabled prior to calling xrDestroyDebugUtilsMessengerEXT";
@@ -484,8 +501,117 @@ XRLOADER_ABI_CATCH_BAD_ALLOC_OOM XRLOADER_ABI_CATCH_FALLBACK
 }
 XRLOADER_ABI_CATCH_FALLBACK
 
+// ---- XR_EXTX_loader_call_statistics loader-only functions
+
+XRAPI_ATTR XrResult XRAPI_CALL xrGetLoaderCallStatisticsEXTX(XrInstance instance, uint32_t statisticCapacityInput,
+                                                             uint32_t *statisticCountOutput,
+                                                             XrLoaderCallStatisticsEXTX *statistics) XRLOADER_ABI_TRY {
+    LoaderInstance *loader_instance = g_instance_map.Get(instance);
+    if (loader_instance == nullptr) {
+        LoaderLogger::LogValidationErrorMessage("VUID-xrGetLoaderCallStatisticsEXTX-instance-parameter",
+                                                "xrGetLoaderCallStatisticsEXTX", "invalid instance");
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    LoaderCallStatistics *call_statistics = loader_instance->CallStatistics();
+    if (nullptr == call_statistics) {
+        std::string error_str = "The ";
+        error_str += XR_EXTX_LOADER_CALL_STATISTICS_EXTENSION_NAME;
+        error_str += " extension has not been enabled prior to calling xrGetLoaderCallStatisticsEXTX";
+        LoaderLogger::LogValidationErrorMessage("VUID-xrGetLoaderCallStatisticsEXTX-extension-notenabled",
+                                                "xrGetLoaderCallStatisticsEXTX", error_str);
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+    if (nullptr == statisticCountOutput) {
+        LoaderLogger::LogValidationErrorMessage("VUID-xrGetLoaderCallStatisticsEXTX-statisticCountOutput-parameter",
+                                                "xrGetLoaderCallStatisticsEXTX", "statisticCountOutput must be non-NULL");
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    if (0 != statisticCapacityInput && nullptr == statistics) {
+        LoaderLogger::LogValidationErrorMessage("VUID-xrGetLoaderCallStatisticsEXTX-statistics-parameter",
+                                                "xrGetLoaderCallStatisticsEXTX",
+                                                "statistics must be non-NULL when statisticCapacityInput is not 0");
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+
+    std::vector<LoaderCallStatistics::CommandTotals> totals;
+    call_statistics->GetTotals(totals);
+    uint32_t called_commands = 0;
+    for (const LoaderCallStatistics::CommandTotals &total : totals) {
+        if (0 != total.calls) {
+            ++called_commands;
+        }
+    }
+    *statisticCountOutput = called_commands;
+    if (0 == statisticCapacityInput) {
+        return XR_SUCCESS;
+    }
+    if (statisticCapacityInput < called_commands) {
+        LoaderLogger::LogValidationErrorMessage("VUID-xrGetLoaderCallStatisticsEXTX-statisticCountOutput-parameter",
+                                                "xrGetLoaderCallStatisticsEXTX", "insufficient space in array");
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+
+    uint32_t statistic = 0;
+    for (uint32_t command = 0; command < static_cast<uint32_t>(totals.size()); ++command) {
+        const LoaderCallStatistics::CommandTotals &total = totals[command];
+        if (0 == total.calls) {
+            continue;
+        }
+        XrLoaderCallStatisticsEXTX &command_statistics = statistics[statistic++];
+        strncpy(command_statistics.commandName, LoaderGenCommandName(command), XR_MAX_LOADER_COMMAND_NAME_SIZE_EXTX - 1);
+        command_statistics.commandName[XR_MAX_LOADER_COMMAND_NAME_SIZE_EXTX - 1] = '\0';
+        command_statistics.callCount = total.calls;
+        command_statistics.totalDurationNs = total.total_ns;
+        for (uint32_t bucket = 0; bucket < XR_LOADER_CALL_LATENCY_BUCKET_COUNT_EXTX; ++bucket) {
+            command_statistics.latencyHistogram[bucket] = total.latency_histogram[bucket];
+        }
+    }
+    return XR_SUCCESS;
+}
+XRLOADER_ABI_CATCH_BAD_ALLOC_OOM XRLOADER_ABI_CATCH_FALLBACK
+
+XRAPI_ATTR XrResult XRAPI_CALL xrResetLoaderCallStatisticsEXTX(XrInstance instance) XRLOADER_ABI_TRY {
+    LoaderInstance *loader_instance = g_instance_map.Get(instance);
+    if (loader_instance == nullptr) {
+        LoaderLogger::LogValidationErrorMessage("VUID-xrResetLoaderCallStatisticsEXTX-instance-parameter",
+                                                "xrResetLoaderCallStatisticsEXTX", "invalid instance");
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    LoaderCallStatistics *call_statistics = loader_instance->CallStatistics();
+    if (nullptr == call_statistics) {
+        std::string error_str = "The ";
+        error_str += XR_EXTX_LOADER_CALL_STATISTICS_EXTENSION_NAME;
+        error_str += " extension has not been enabled prior to calling xrResetLoaderCallStatisticsEXTX";
+        LoaderLogger::LogValidationErrorMessage("VUID-xrResetLoaderCallStatisticsEXTX-extension-notenabled",
+                                                "xrResetLoaderCallStatisticsEXTX", error_str);
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+    call_statistics->Reset();
+    return XR_SUCCESS;
+}
+XRLOADER_ABI_CATCH_BAD_ALLOC_OOM XRLOADER_ABI_CATCH_FALLBACK
+
 // ---- Extension manual loader terminator functions
 
+// The runtime's dispatch table for the runtime instance a terminator was called with.  When no layer wraps the instance
+// handle, it is also the loader's, and its LoaderInstance holds the table; only otherwise is RuntimeInterface asked.
+static const XrGeneratedDispatchTable *RuntimeInstanceDispatchTable(XrInstance instance) {
+    LoaderInstance *loader_instance = g_instance_map.Get(instance);
+    if (nullptr != loader_instance && loader_instance->RuntimeInstance() == instance) {
+        return loader_instance->RuntimeDispatchTable();
+    }
+    return RuntimeInterface::GetDispatchTable(instance);
+}
+
+// Likewise for the runtime's handle of a debug messenger
+static const XrGeneratedDispatchTable *RuntimeMessengerDispatchTable(XrDebugUtilsMessengerEXT messenger) {
+    LoaderInstance *loader_instance = g_debugutilsmessengerext_map.Get(messenger);
+    if (nullptr != loader_instance && nullptr != loader_instance->RuntimeDispatchTable()) {
+        return loader_instance->RuntimeDispatchTable();
+    }
+    return RuntimeInterface::GetDebugUtilsMessengerDispatchTable(messenger);
+}
+
 XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermCreateDebugUtilsMessengerEXT(XrInstance instance,
                                                                         const XrDebugUtilsMessengerCreateInfoEXT *createInfo,
                                                                         XrDebugUtilsMessengerEXT *messenger) XRLOADER_ABI_TRY {
@@ -495,7 +621,7 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermCreateDebugUtilsMessengerEXT(XrInstan
                                                 "xrCreateDebugUtilsMessengerEXT", "invalid messenger pointer");
         return XR_ERROR_VALIDATION_FAILURE;
     }
-    const XrGeneratedDispatchTable *dispatch_table = RuntimeInterface::GetDispatchTable(instance);
+    const XrGeneratedDispatchTable *dispatch_table = RuntimeInstanceDispatchTable(instance);
     XrResult result = XR_SUCCESS;
     // This extension is supported entirely by the loader which means the runtime may or may not support it.
     if (nullptr != dispatch_table->CreateDebugUtilsMessengerEXT) {
@@ -516,7 +642,7 @@ XRLOADER_ABI_CATCH_FALLBACK
 
 XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermDestroyDebugUtilsMessengerEXT(XrDebugUtilsMessengerEXT messenger) XRLOADER_ABI_TRY {
     LoaderLogger::LogVerboseMessage("xrDestroyDebugUtilsMessengerEXT", "Entering loader terminator");
-    const XrGeneratedDispatchTable *dispatch_table = RuntimeInterface::GetDebugUtilsMessengerDispatchTable(messenger);
+    const XrGeneratedDispatchTable *dispatch_table = RuntimeMessengerDispatchTable(messenger);
     XrResult result = XR_SUCCESS;
     LoaderLogger::GetInstance().RemoveLogRecorder(MakeHandleGeneric(messenger));
     RuntimeInterface::GetRuntime().ForgetDebugMessenger(messenger);
@@ -536,7 +662,7 @@ XRAPI_ATTR XrResult XRAPI_CALL LoaderXrTermSubmitDebugUtilsMessageEXT(
     XrInstance instance, XrDebugUtilsMessageSeverityFlagsEXT messageSeverity, XrDebugUtilsMessageTypeFlagsEXT messageTypes,
     const XrDebugUtilsMessengerCallbackDataEXT *callbackData) XRLOADER_ABI_TRY {
     LoaderLogger::LogVerboseMessage("xrSubmitDebugUtilsMessageEXT", "Entering loader terminator");
-    const XrGeneratedDispatchTable *dispatch_table = RuntimeInterface::GetDispatchTable(instance);
+    const XrGeneratedDispatchTable *dispatch_table = RuntimeInstanceDispatchTable(instance);
     XrResult result = XR_SUCCESS;
     if (nullptr != dispatch_table->SubmitDebugUtilsMessageEXT) {
         result = dispatch_table->SubmitDebugUtilsMessageEXT(instance, messageSeverity, messageTypes, callbackData);
@@ -553,7 +679,7 @@ XRLOADER_ABI_CATCH_FALLBACK
 XRAPI_ATTR XrResult XRAPI_CALL
 LoaderXrTermSetDebugUtilsObjectNameEXT(XrInstance instance, const XrDebugUtilsObjectNameInfoEXT *nameInfo) XRLOADER_ABI_TRY {
     LoaderLogger::LogVerboseMessage("xrSetDebugUtilsObjectNameEXT", "Entering loader terminator");
-    const XrGeneratedDispatchTable *dispatch_table = RuntimeInterface::GetDispatchTable(instance);
+    const XrGeneratedDispatchTable *dispatch_table = RuntimeInstanceDispatchTable(instance);
     XrResult result = XR_SUCCESS;
     if (nullptr != dispatch_table->SetDebugUtilsObjectNameEXT) {
         result = dispatch_table->SetDebugUtilsObjectNameEXT(instance, nameInfo);
@@ -573,7 +699,7 @@ XRAPI_ATTR XrResult XRAPI_CALL xrSessionBeginDebugUtilsLabelRegionEXT(XrSession
                                                     {XrSdkLogObjectInfo{session, XR_OBJECT_TYPE_SESSION}});
         return XR_ERROR_HANDLE_INVALID;
     }
-    if (!loader_instance->ExtensionIsEnabled(XR_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+    if (!loader_instance->ExtensionIsEnabled(LOADER_EXTENSION_XR_EXT_DEBUG_UTILS)) {
         LoaderLogger::LogValidationErrorMessage("TBD", "xrSessionBeginDebugUtilsLabelRegionEXT",
                                                 "Extension entrypoint called without enabling appropriate extension",
                                                     {XrSdkLogObjectInfo{session, XR_OBJECT_TYPE_SESSION}});
@@ -603,7 +729,7 @@ XRAPI_ATTR XrResult XRAPI_CALL xrSessionEndDebugUtilsLabelRegionEXT(XrSession se
                                                     {XrSdkLogObjectInfo{session, XR_OBJECT_TYPE_SESSION}});
         return XR_ERROR_HANDLE_INVALID;
     }
-    if (!loader_instance->ExtensionIsEnabled(XR_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+    if (!loader_instance->ExtensionIsEnabled(LOADER_EXTENSION_XR_EXT_DEBUG_UTILS)) {
         return XR_ERROR_FUNCTION_UNSUPPORTED;
     }
     LoaderLogger::GetInstance().EndLabelRegion(session);
@@ -624,7 +750,7 @@ XRAPI_ATTR XrResult XRAPI_CALL xrSessionInsertDebugUtilsLabelEXT(XrSession sessi
                                                     {XrSdkLogObjectInfo{session, XR_OBJECT_TYPE_SESSION}});
         return XR_ERROR_HANDLE_INVALID;
     }
-    if (!loader_instance->ExtensionIsEnabled(XR_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+    if (!loader_instance->ExtensionIsEnabled(LOADER_EXTENSION_XR_EXT_DEBUG_UTILS)) {
         LoaderLogger::LogValidationErrorMessage("TBD", "xrSessionInsertDebugUtilsLabelEXT",
                                                 "Extension entrypoint called without enabling appropriate extension",
                                                     {XrSdkLogObjectInfo{session, XR_OBJECT_TYPE_SESSION}});
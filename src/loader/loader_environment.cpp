@@ -0,0 +1,73 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "loader_environment.hpp"
+
+#include "platform_utils.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+thread_local LoaderEnvironmentSnapshot* t_current_snapshot = nullptr;
+
+bool ReadEnvironment(const char* name, bool secure, std::string& value) {
+    char* env_value = secure ? PlatformUtilsGetSecureEnv(name) : PlatformUtilsGetEnv(name);
+    if (nullptr == env_value) {
+        value.clear();
+        return false;
+    }
+    value = env_value;
+    PlatformUtilsFreeEnv(env_value);
+    return true;
+}
+
+}  // namespace
+
+LoaderEnvironmentSnapshot::LoaderEnvironmentSnapshot() : _installed(nullptr == t_current_snapshot) {
+    if (_installed) {
+        t_current_snapshot = this;
+    }
+}
+
+LoaderEnvironmentSnapshot::~LoaderEnvironmentSnapshot() {
+    if (_installed) {
+        t_current_snapshot = nullptr;
+    }
+}
+
+bool LoaderEnvironmentSnapshot::Get(const char* name, bool secure, std::string& value) {
+    LoaderEnvironmentSnapshot* snapshot = t_current_snapshot;
+    if (nullptr == snapshot) {
+        return ReadEnvironment(name, secure, value);
+    }
+    std::unordered_map<std::string, Variable>& variables = secure ? snapshot->_secure_variables : snapshot->_variables;
+    auto it = variables.find(name);
+    if (it == variables.end()) {
+        Variable variable;
+        variable.is_set = ReadEnvironment(name, secure, variable.value);
+        it = variables.emplace(name, std::move(variable)).first;
+    }
+    value = it->second.value;
+    return it->second.is_set;
+}
+
+bool LoaderGetEnv(const char* name, std::string& value) { return LoaderEnvironmentSnapshot::Get(name, false, value); }
+
+bool LoaderGetSecureEnv(const char* name, std::string& value) { return LoaderEnvironmentSnapshot::Get(name, true, value); }
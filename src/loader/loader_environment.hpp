@@ -0,0 +1,60 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+/// One consistent view of the environment for the length of a loader trampoline.
+///
+/// While a snapshot exists, LoaderGetEnv and LoaderGetSecureEnv on the thread that created it read each variable from
+/// the process environment only the first time it is asked for, and return that same value for the rest of the call.
+/// Discovery asks for the same handful of variables (XR_RUNTIME_JSON, XR_API_LAYER_PATH, XR_ENABLE_API_LAYERS, the XDG
+/// directories and each implicit layer's enable and disable variables) again and again, and on Windows every lookup also
+/// converts the value from UTF-16.  Snapshots do not nest: one created while another is active on the same thread does
+/// nothing, so the outermost call decides what the environment looks like.  Other threads, and threads with no snapshot,
+/// read the environment directly.
+class LoaderEnvironmentSnapshot {
+   public:
+    LoaderEnvironmentSnapshot();
+    ~LoaderEnvironmentSnapshot();
+
+    LoaderEnvironmentSnapshot(const LoaderEnvironmentSnapshot&) = delete;
+    LoaderEnvironmentSnapshot& operator=(const LoaderEnvironmentSnapshot&) = delete;
+
+   private:
+    friend bool LoaderGetEnv(const char* name, std::string& value);
+    friend bool LoaderGetSecureEnv(const char* name, std::string& value);
+
+    struct Variable {
+        bool is_set;
+        std::string value;
+    };
+
+    static bool Get(const char* name, bool secure, std::string& value);
+
+    bool _installed;
+    std::unordered_map<std::string, Variable> _variables;
+    std::unordered_map<std::string, Variable> _secure_variables;
+};
+
+/// Get an environment variable, through the current thread's snapshot if it has one.  Returns false if it is not set.
+bool LoaderGetEnv(const char* name, std::string& value);
+
+/// As LoaderGetEnv, but with PlatformUtilsGetSecureEnv, so that nothing is returned to a setuid process.
+bool LoaderGetSecureEnv(const char* name, std::string& value);
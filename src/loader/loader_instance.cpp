@@ -24,15 +24,19 @@
 #include "loader_instance.hpp"
 
 #include "api_layer_interface.hpp"
+#include "exception_handling.hpp"
 #include "hex_and_handles.h"
+#include "loader_environment.hpp"
 #include "loader_interfaces.h"
 #include "loader_logger.hpp"
+#include "loader_trace.hpp"
 #include "runtime_interface.hpp"
 #include "xr_generated_dispatch_table.h"
 #include "xr_generated_loader.hpp"
 
 #include <openxr/openxr.h>
 
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <sstream>
@@ -40,17 +44,79 @@
 #include <utility>
 #include <vector>
 
+namespace {
+
+// Chains with more layers than this always go through every layer for every command.
+const uint32_t kMaxSkippingLayerChainLength = 16;
+
+// The loader instance whose layer chain this thread is creating.  The layers look their next commands up through
+// LoaderXrChainGetInstanceProcAddr before the instance is in g_instance_map.
+thread_local LoaderInstance* t_chain_instance = nullptr;
+
+class ChainInstanceScope {
+   public:
+    explicit ChainInstanceScope(LoaderInstance* loader_instance) : _previous(t_chain_instance) {
+        t_chain_instance = loader_instance;
+    }
+    ~ChainInstanceScope() { t_chain_instance = _previous; }
+
+    ChainInstanceScope(const ChainInstanceScope&) = delete;
+    ChainInstanceScope& operator=(const ChainInstanceScope&) = delete;
+
+   private:
+    LoaderInstance* _previous;
+};
+
+// The xrGetInstanceProcAddr for looking commands up from layer FirstLayer of an instance's chain down, skipping the
+// layers that only forward them.  Layer N - 1 is handed the one for N as its next xrGetInstanceProcAddr, and the top-level
+// dispatch table is filled from the one for 0.
+template <uint32_t FirstLayer>
+XRAPI_ATTR XrResult XRAPI_CALL LoaderXrChainGetInstanceProcAddr(XrInstance instance, const char* name,
+                                                                PFN_xrVoidFunction* function) XRLOADER_ABI_TRY {
+    LoaderInstance* loader_instance = t_chain_instance;
+    if (nullptr == loader_instance) {
+        loader_instance = g_instance_map.Get(instance);
+    }
+    if (nullptr == loader_instance) {
+        LoaderLogger::LogErrorMessage("xrGetInstanceProcAddr",
+                                      "LoaderXrChainGetInstanceProcAddr called with an instance the loader does not know");
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    return loader_instance->ChainGetInstanceProcAddr(FirstLayer, instance, name, function);
+}
+XRLOADER_ABI_CATCH_FALLBACK
+
+const PFN_xrGetInstanceProcAddr kChainGetInstanceProcAddr[kMaxSkippingLayerChainLength + 1] = {
+    LoaderXrChainGetInstanceProcAddr<0>,  LoaderXrChainGetInstanceProcAddr<1>,  LoaderXrChainGetInstanceProcAddr<2>,
+    LoaderXrChainGetInstanceProcAddr<3>,  LoaderXrChainGetInstanceProcAddr<4>,  LoaderXrChainGetInstanceProcAddr<5>,
+    LoaderXrChainGetInstanceProcAddr<6>,  LoaderXrChainGetInstanceProcAddr<7>,  LoaderXrChainGetInstanceProcAddr<8>,
+    LoaderXrChainGetInstanceProcAddr<9>,  LoaderXrChainGetInstanceProcAddr<10>, LoaderXrChainGetInstanceProcAddr<11>,
+    LoaderXrChainGetInstanceProcAddr<12>, LoaderXrChainGetInstanceProcAddr<13>, LoaderXrChainGetInstanceProcAddr<14>,
+    LoaderXrChainGetInstanceProcAddr<15>, LoaderXrChainGetInstanceProcAddr<16>};
+
+// True if the variable is set to anything but "0", for the loader's opt-in switches.
+bool LoaderEnvironmentFlagSet(const char* name) {
+    std::string value;
+    return LoaderGetSecureEnv(name, value) && value != "0";
+}
+
+}  // namespace
+
 // Extensions that are supported by the loader, but may not be supported
 // the the runtime.
-const std::array<XrExtensionProperties, 1>& LoaderInstance::LoaderSpecificExtensions() {
-    static const std::array<XrExtensionProperties, 1> extensions = {XrExtensionProperties{
-        XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_EXT_DEBUG_UTILS_EXTENSION_NAME, XR_EXT_debug_utils_SPEC_VERSION}};
+const std::array<XrExtensionProperties, 2>& LoaderInstance::LoaderSpecificExtensions() {
+    static const std::array<XrExtensionProperties, 2> extensions = {
+        {XrExtensionProperties{XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_EXT_DEBUG_UTILS_EXTENSION_NAME,
+                               XR_EXT_debug_utils_SPEC_VERSION},
+         XrExtensionProperties{XR_TYPE_EXTENSION_PROPERTIES, nullptr, XR_EXTX_LOADER_CALL_STATISTICS_EXTENSION_NAME,
+                               XR_EXTX_loader_call_statistics_SPEC_VERSION}}};
     return extensions;
 }
 
 // Factory method
 XrResult LoaderInstance::CreateInstance(std::vector<std::unique_ptr<ApiLayerInterface>>&& api_layer_interfaces,
                                         const XrInstanceCreateInfo* info, XrInstance* instance) {
+    LoaderTraceScope trace("LoaderInstance::CreateInstance");
     XrResult last_error = XR_SUCCESS;
     LoaderLogger::LogVerboseMessage("xrCreateInstance", "Entering LoaderInstance::CreateInstance");
 
@@ -64,6 +130,26 @@ XrResult LoaderInstance::CreateInstance(std::vector<std::unique_ptr<ApiLayerInte
 
     // Only start the xrCreateApiLayerInstance stack if we have layers.
     std::vector<std::unique_ptr<ApiLayerInterface>>& layer_interfaces = loader_instance->LayerInterfaces();
+
+    // Once any layer has said which commands it intercepts, every layer looks up its next commands through the loader,
+    // which hands each one the first layer below it that intercepts the command (or the runtime's), rather than the
+    // next layer's whether or not that only forwards it.  Per-frame calls then skip the layers with nothing to do.
+    bool skip_pass_through_layers = false;
+    if (layer_interfaces.size() <= kMaxSkippingLayerChainLength) {
+        for (auto& layer_interface : layer_interfaces) {
+            if (layer_interface->ReportsInterceptedCommands()) {
+                skip_pass_through_layers = true;
+                break;
+            }
+        }
+    }
+    ChainInstanceScope chain_scope(skip_pass_through_layers ? loader_instance.get() : nullptr);
+    if (skip_pass_through_layers) {
+        layer_interfaces.front()->SetDispatchGetInstanceProcAddr(kChainGetInstanceProcAddr[0]);
+        LoaderLogger::LogInfoMessage("xrCreateInstance",
+                                     "LoaderInstance::CreateInstance skipping API layers for the commands they do not intercept");
+    }
+
     if (!layer_interfaces.empty()) {
         // Initialize an array of ApiLayerNextInfo structs
         auto* next_info_list = new XrApiLayerNextInfo[layer_interfaces.size()];
@@ -92,7 +178,8 @@ XrResult LoaderInstance::CreateInstance(std::vector<std::unique_ptr<ApiLayerInte
             strncpy(next_info_list[ni_index].layerName, (*layer_interface)->LayerName().c_str(), XR_MAX_API_LAYER_NAME_SIZE - 1);
             next_info_list[ni_index].layerName[XR_MAX_API_LAYER_NAME_SIZE - 1] = '\0';
             next_info_list[ni_index].next = prev_nextinfo;
-            next_info_list[ni_index].nextGetInstanceProcAddr = prev_gipa_fp;
+            next_info_list[ni_index].nextGetInstanceProcAddr =
+                skip_pass_through_layers ? kChainGetInstanceProcAddr[ni_index + 1] : prev_gipa_fp;
             next_info_list[ni_index].nextCreateApiLayerInstance = prev_cali_fp;
 
             // Update saved pointers for next iteration
@@ -158,6 +245,16 @@ XrResult LoaderInstance::CreateInstance(std::vector<std::unique_ptr<ApiLayerInte
     }
 
     if (XR_SUCCEEDED(last_error)) {
+        // Opt-in: leave most of the dispatch table to be looked up a command at a time as the application first
+        // calls them, rather than asking the whole layer chain about every command now.  Direct dispatch hands
+        // the table entries out, so it keeps the table fully populated.
+        loader_instance->_lazy_dispatch =
+            LoaderEnvironmentFlagSet("XR_LOADER_LAZY_DISPATCH") && !LoaderEnvironmentFlagSet("XR_LOADER_DIRECT_DISPATCH");
+        if (loader_instance->_lazy_dispatch) {
+            LoaderLogger::LogInfoMessage("xrCreateInstance",
+                                         "LoaderInstance::CreateInstance enabling lazy dispatch (XR_LOADER_LAZY_DISPATCH)");
+        }
+
         // Create the top-level dispatch table for the instance.  This will contain the function pointers to the
         // first instantiation of every command, whether that is in a layer, or a runtime.
         last_error = loader_instance->CreateDispatchTable(*instance);
@@ -174,13 +271,34 @@ XrResult LoaderInstance::CreateInstance(std::vector<std::unique_ptr<ApiLayerInte
         }
     }
 
+    if (XR_SUCCEEDED(last_error) && loader_instance->ExtensionIsEnabled(LOADER_EXTENSION_XR_EXTX_LOADER_CALL_STATISTICS)) {
+        loader_instance->_call_statistics.reset(new LoaderCallStatistics(LOADER_COMMAND_COUNT));
+    }
+
     if (XR_SUCCEEDED(last_error)) {
-        std::ostringstream oss;
-        oss << "LoaderInstance::CreateInstance succeeded with ";
-        oss << loader_instance->LayerInterfaces().size();
-        oss << " layers enabled and runtime interface - created instance = ";
-        oss << HandleToHexString(*instance);
-        LoaderLogger::LogInfoMessage("xrCreateInstance", oss.str());
+        // Opt-in: let xrGetInstanceProcAddr return the top-level dispatch table entries for the instance's commands,
+        // so the application calls the first layer (or the runtime) without going through a loader trampoline.
+        loader_instance->_direct_dispatch = LoaderEnvironmentFlagSet("XR_LOADER_DIRECT_DISPATCH");
+        if (loader_instance->_direct_dispatch && loader_instance->_call_statistics) {
+            // Calls that skip the trampolines could not be counted.
+            loader_instance->_direct_dispatch = false;
+            LoaderLogger::LogWarningMessage("xrCreateInstance",
+                                            "LoaderInstance::CreateInstance ignoring XR_LOADER_DIRECT_DISPATCH because " +
+                                                std::string(XR_EXTX_LOADER_CALL_STATISTICS_EXTENSION_NAME) + " is enabled");
+        }
+        if (loader_instance->_direct_dispatch) {
+            LoaderLogger::LogInfoMessage("xrCreateInstance",
+                                         "LoaderInstance::CreateInstance enabling direct dispatch (XR_LOADER_DIRECT_DISPATCH)");
+        }
+
+        if (LoaderLogger::IsInfoEnabled()) {
+            std::ostringstream oss;
+            oss << "LoaderInstance::CreateInstance succeeded with ";
+            oss << loader_instance->LayerInterfaces().size();
+            oss << " layers enabled and runtime interface - created instance = ";
+            oss << HandleToHexString(*instance);
+            LoaderLogger::LogInfoMessage("xrCreateInstance", oss.str());
+        }
         // Make the unique_ptr no longer delete this.
         // Don't need to save the return value because we already set *instance
         (void)loader_instance.release();
@@ -196,30 +314,46 @@ LoaderInstance::LoaderInstance(std::vector<std::unique_ptr<ApiLayerInterface>>&&
     : _unique_id(0xDECAFBAD),
       _api_version(XR_CURRENT_API_VERSION),
       _api_layer_interfaces(std::move(api_layer_interfaces)),
+      _runtime_instance(XR_NULL_HANDLE),
+      _runtime_dispatch_table(nullptr),
       _dispatch_valid(false),
-      _messenger(XR_NULL_HANDLE) {}
+      _direct_dispatch(false),
+      _lazy_dispatch(false),
+      _dispatch_instance(XR_NULL_HANDLE),
+      _enabled_extension_bits(LOADER_EXTENSION_COUNT, false),
+      _proc_addr_cache_size(LOADER_GIPA_COMMAND_COUNT),
+      _proc_addr_cache(new std::atomic<PFN_xrVoidFunction>[LOADER_GIPA_COMMAND_COUNT]),
+      _messenger(XR_NULL_HANDLE) {
+    for (uint32_t command = 0; command < _proc_addr_cache_size; ++command) {
+        _proc_addr_cache[command].store(nullptr, std::memory_order_relaxed);
+    }
+}
 
 LoaderInstance::~LoaderInstance() {
-    std::ostringstream oss;
-    oss << "Destroying LoaderInstance = ";
-    oss << PointerToHexString(this);
-    LoaderLogger::LogInfoMessage("xrDestroyInstance", oss.str());
+    if (LoaderLogger::IsInfoEnabled()) {
+        std::ostringstream oss;
+        oss << "Destroying LoaderInstance = ";
+        oss << PointerToHexString(this);
+        LoaderLogger::LogInfoMessage("xrDestroyInstance", oss.str());
+    }
 }
 
 XrResult LoaderInstance::CreateDispatchTable(XrInstance instance) {
+    LoaderTraceScope trace("LoaderInstance::CreateDispatchTable");
     XrResult res = XR_SUCCESS;
     // Create the top-level dispatch table.  First, we want to start with a dispatch table generated
     // using the commands from the runtime, with the exception of commands that we need a terminator
     // for.  The loaderGenInitInstanceDispatchTable utility function handles that automatically for us.
     std::unique_ptr<XrGeneratedDispatchTable> new_instance_dispatch_table(new XrGeneratedDispatchTable());
-    LoaderGenInitInstanceDispatchTable(_runtime_instance, new_instance_dispatch_table);
+    LoaderGenInitInstanceDispatchTable(_runtime_instance, new_instance_dispatch_table, _lazy_dispatch);
 
     // Go through all layers, and override the instance pointers with the layer version.  However,
     // go backwards through the layer list so we replace in reverse order so the layers can call their next function
     // appropriately.
     if (!_api_layer_interfaces.empty()) {
-        (*_api_layer_interfaces.begin())->GenUpdateInstanceDispatchTable(instance, new_instance_dispatch_table);
+        (*_api_layer_interfaces.begin())->GenUpdateInstanceDispatchTable(instance, new_instance_dispatch_table, _lazy_dispatch);
     }
+    _dispatch_instance = instance;
 
     // Set the top-level instance dispatch table to the top-most commands now that we've figured them out.
     _dispatch_table = std::move(new_instance_dispatch_table);
@@ -227,7 +361,64 @@ XrResult LoaderInstance::CreateDispatchTable(XrInstance instance) {
     return res;
 }
 
+PFN_xrVoidFunction LoaderInstance::ResolveLazyDispatchEntry(const char* name, PFN_xrVoidFunction* entry, PFN_xrVoidFunction thunk) {
+    // The trampolines read the entries without synchronizing, which is fine for an aligned pointer that only ever
+    // goes from the thunk to the command: both are safe to call.  The entries are written atomically all the same.
+    static_assert(sizeof(std::atomic<PFN_xrVoidFunction>) == sizeof(PFN_xrVoidFunction),
+                  "a dispatch table entry must be patchable in place");
+    std::atomic<PFN_xrVoidFunction>* atomic_entry = reinterpret_cast<std::atomic<PFN_xrVoidFunction>*>(entry);
+    PFN_xrVoidFunction function = atomic_entry->load(std::memory_order_acquire);
+    if (function != thunk) {
+        // Already looked up, by a call that came in through the thunk at the same time as this one, or when the
+        // application kept hold of the thunk from before
+        return function;
+    }
+
+    // The same lookups CreateDispatchTable makes, for the one command: the runtime's (or the loader's terminator),
+    // overridden by the first layer's if it has one.
+    function = nullptr;
+    LoaderXrTermGetInstanceProcAddr(_runtime_instance, name, &function);
+    if (!_api_layer_interfaces.empty()) {
+        PFN_xrVoidFunction layer_function = nullptr;
+        _api_layer_interfaces.front()->DispatchGetInstanceProcAddr()(_dispatch_instance, name, &layer_function);
+        if (nullptr != layer_function) {
+            function = layer_function;
+        }
+    }
+    if (nullptr != function) {
+        atomic_entry->store(function, std::memory_order_release);
+    }
+    return function;
+}
+
+XrResult LoaderInstance::ChainGetInstanceProcAddr(uint32_t first_layer, XrInstance instance, const char* name,
+                                                  PFN_xrVoidFunction* function) {
+    // Asked for itself, so that whatever the layer looks up later skips the same layers
+    if (0 == strcmp(name, "xrGetInstanceProcAddr") && first_layer <= kMaxSkippingLayerChainLength) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(kChainGetInstanceProcAddr[first_layer]);
+        return XR_SUCCESS;
+    }
+    for (size_t layer = first_layer; layer < _api_layer_interfaces.size(); ++layer) {
+        if (_api_layer_interfaces[layer]->InterceptsCommand(name)) {
+            return _api_layer_interfaces[layer]->GetInstanceProcAddrFuncPointer()(instance, name, function);
+        }
+    }
+    return LoaderXrTermGetInstanceProcAddr(instance, name, function);
+}
+
+void LoaderInstance::AddEnabledExtension(const std::string& extension) {
+    _enabled_extensions.push_back(extension);
+    uint32_t index;
+    if (LoaderGenFindExtension(extension.c_str(), index)) {
+        _enabled_extension_bits[index] = true;
+    }
+}
+
 bool LoaderInstance::ExtensionIsEnabled(const std::string& extension) {
+    uint32_t index;
+    if (LoaderGenFindExtension(extension.c_str(), index)) {
+        return ExtensionIsEnabled(index);
+    }
     for (std::string& cur_enabled : _enabled_extensions) {
         if (cur_enabled == extension) {
             return true;
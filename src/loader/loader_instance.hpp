@@ -20,15 +20,20 @@
 #pragma once
 
 #include "extra_algorithms.h"
+#include "hex_and_handles.h"
+#include "loader_call_statistics.hpp"
 
 #include <openxr/openxr.h>
 
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class LoaderInstance;
@@ -36,12 +41,29 @@ class ApiLayerInterface;
 struct XrGeneratedDispatchTable;
 
 typedef std::unique_lock<std::mutex> UniqueLock;
+/// Maps handles of one type to the LoaderInstance that owns them.
+///
+/// Every trampoline performs a Get, so lookups are lock-free: the entries live in open-addressing tables of atomic
+/// slots that readers probe without taking a mutex.  The handles are spread by hash over a fixed set of shards, each
+/// with its own table and mutex, so Insert, Erase and Take on unrelated handles rarely contend.  Erased entries keep
+/// their key with a null instance (a tombstone) so that concurrent probes stay valid, and a tombstone is reused by the
+/// next insert that probes past it.  When more than half of a shard's table is in use, it is replaced by a larger one
+/// holding only the live entries; the replaced tables are kept alive until the map is destroyed, since a reader may
+/// still be probing them.  If tombstones are most of what fills it, as when handles are created and destroyed over and
+/// over, it is rehashed in place instead: the shard's version is odd while that happens, and a reader that found nothing
+/// while it was odd or changed probes again.
+///
+/// Each shard also records which handles each instance owns, so RemoveHandlesForLoader only visits those handles.
+///
+/// On top of that, each thread remembers the last handle it found and its instance, together with the map's epoch at the
+/// time.  The epoch is bumped after every change that could make a remembered answer wrong (a handle removed, or moved to
+/// another instance), including the clean-up xrDestroyInstance does before the instance is deleted.  So a trampoline called
+/// again with the same handle gets its instance from the thread-local entry without probing the shared tables, and never
+/// gets an instance that has since been destroyed.
 template <typename HandleType>
 class HandleLoaderMap {
    public:
     using handle_t = HandleType;
-    using map_t = std::unordered_map<HandleType, LoaderInstance*>;
-    using value_t = typename map_t::value_type;
 
     /// Lookup a handle.
     /// Returns nullptr if not found.
@@ -56,14 +78,105 @@ class HandleLoaderMap {
     /// Returns XR_ERROR_RUNTIME_FAILURE if it's null or not there.
     XrResult Erase(HandleType handle);
 
+    /// Remove the info associated with the supplied handle, returning the instance it belonged to.
+    /// Used by destroy commands so they only look the handle up once.
+    /// Returns nullptr if it's null or not there.
+    LoaderInstance* Take(HandleType handle);
+
     /// Removes handles associated with a loader instance.
     void RemoveHandlesForLoader(LoaderInstance& loader);
 
    protected:
-    map_t instance_map_;
-    std::mutex mutex_;
+    // The last successful Get on this thread.
+    struct LookupCache {
+        const HandleLoaderMap* map;
+        uint64_t epoch;
+        uint64_t key;
+        LoaderInstance* instance;
+    };
+    static thread_local LookupCache thread_lookup_cache_;
+
+    struct Slot {
+        // A key of 0 marks a slot that has never been used.  Keys are never cleared once written.
+        std::atomic<uint64_t> key;
+        // nullptr marks a tombstone (or an insert that has not been published yet).
+        std::atomic<LoaderInstance*> instance;
+    };
+
+    struct Table {
+        explicit Table(size_t slot_count) : mask(slot_count - 1), max_probe(0), slots(new Slot[slot_count]) {
+            for (size_t i = 0; i < slot_count; ++i) {
+                slots[i].key.store(0, std::memory_order_relaxed);
+                slots[i].instance.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        const size_t mask;
+        // Longest distance from its home slot at which any key was placed: bounds every probe sequence.
+        std::atomic<size_t> max_probe;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    // Padded to a cache line so that writers on neighbouring shards don't false-share.
+    struct alignas(64) Shard {
+        std::atomic<Table*> table{nullptr};
+        // Owns the published table and every table it replaced.
+        std::vector<std::unique_ptr<Table>> tables;
+        // Odd while the published table is being rehashed in place.  A reader that finds nothing checks that it was even
+        // and unchanged around the probe.
+        std::atomic<uint64_t> version{0};
+        // Number of keys with a non-null instance in the published table.
+        size_t live_count = 0;
+        // Number of slots in the published table holding a key, live or tombstone.
+        size_t used_count = 0;
+        // Keys of the live entries, by owning instance.
+        std::unordered_map<LoaderInstance*, std::unordered_set<uint64_t>> owned_keys;
+        std::mutex mutex;
+    };
+
+    static const size_t kShardCount = 16;
+    static const size_t kInitialSlotCount = 16;
+
+    static uint64_t KeyFor(HandleType handle) { return MakeHandleGeneric(handle); }
+
+    // SplitMix64 finalizer: handle values are often aligned pointers or small counters.
+    // The top bits pick the shard, the low bits the home slot within the shard's table.
+    static uint64_t HashKey(uint64_t key) {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        key ^= key >> 31;
+        return key;
+    }
+
+    Shard& ShardFor(uint64_t hash) { return shards_[static_cast<size_t>(hash >> 60) % kShardCount]; }
+
+    /// Find the slot holding key, or nullptr.  Safe to call without the shard mutex.
+    static Slot* FindSlot(Table& table, uint64_t key, uint64_t hash);
+
+    /// Place key in table, reusing the first tombstone on its probe path.  Call with the shard mutex held.
+    /// Returns true if it took a slot that had never been used.
+    static bool PlaceKey(Table& table, uint64_t key, uint64_t hash, LoaderInstance* loader);
+
+    /// Replace the shard's published table by a larger one holding only the live entries.  Call with the shard mutex held.
+    static void Grow(Shard& shard);
+
+    /// Drop the tombstones from the shard's published table, placing its live entries again.  Call with the shard mutex
+    /// held.
+    static void Rehash(Shard& shard);
+
+    /// Turn the slot into a tombstone and forget its owner.  Call with the shard mutex held.
+    static void RemoveSlot(Shard& shard, Slot& slot, LoaderInstance* loader, uint64_t key);
+
+    std::array<Shard, kShardCount> shards_;
+    // Bumped, after the change is visible in the tables, whenever a handle is removed or changes instance.
+    std::atomic<uint64_t> epoch_{0};
 };
 
+template <typename HandleType>
+thread_local typename HandleLoaderMap<HandleType>::LookupCache HandleLoaderMap<HandleType>::thread_lookup_cache_ = {nullptr, 0, 0,
+                                                                                                                    nullptr};
+
 class LoaderInstance {
    public:
     // Factory method
@@ -76,12 +189,44 @@ class LoaderInstance {
     bool IsValid() { return _unique_id == 0xDECAFBAD; }
     XrVersion ApiVersion() { return _api_version; }
     XrResult CreateDispatchTable(XrInstance instance);
-    void SetRuntimeInstance(XrInstance instance) { _runtime_instance = instance; }
+    void SetRuntimeInstance(XrInstance instance, const XrGeneratedDispatchTable* runtime_dispatch_table) {
+        _runtime_instance = instance;
+        _runtime_dispatch_table = runtime_dispatch_table;
+    }
+    XrInstance RuntimeInstance() const { return _runtime_instance; }
+    //! The runtime's dispatch table for RuntimeInstance(), which the terminators call through
+    const XrGeneratedDispatchTable* RuntimeDispatchTable() const { return _runtime_dispatch_table; }
     const std::unique_ptr<XrGeneratedDispatchTable>& DispatchTable() { return _dispatch_table; }
     std::vector<std::unique_ptr<ApiLayerInterface>>& LayerInterfaces() { return _api_layer_interfaces; }
-    void AddEnabledExtension(const std::string& extension) { return _enabled_extensions.push_back(extension); }
+    void AddEnabledExtension(const std::string& extension);
     bool ExtensionIsEnabled(const std::string& extension);
-    static const std::array<XrExtensionProperties, 1>& LoaderSpecificExtensions();
+    //! True if the extension with the given LoaderExtensionIndex is enabled
+    bool ExtensionIsEnabled(uint32_t extension) const {
+        return extension < _enabled_extension_bits.size() && _enabled_extension_bits[extension];
+    }
+    static const std::array<XrExtensionProperties, 2>& LoaderSpecificExtensions();
+    //! True if xrGetInstanceProcAddr should hand out dispatch table entries instead of trampolines (XR_LOADER_DIRECT_DISPATCH)
+    bool DirectDispatchEnabled() const { return _direct_dispatch; }
+    //! True if the dispatch table looks most commands up on their first call instead of up front (XR_LOADER_LAZY_DISPATCH)
+    bool LazyDispatchEnabled() const { return _lazy_dispatch; }
+    //! Look up the named command for a dispatch table entry still holding its lazy thunk, and put it in the entry.
+    //! Returns what the entry holds now, or nullptr if neither the layers nor the runtime have the command.
+    PFN_xrVoidFunction ResolveLazyDispatchEntry(const char* name, PFN_xrVoidFunction* entry, PFN_xrVoidFunction thunk);
+    //! Look up the named command for the layer chain from first_layer down, skipping the layers that said, through
+    //! xrEnumerateApiLayerInterceptedCommands, that they only forward it.  What the layers get as their next
+    //! xrGetInstanceProcAddr, and what the dispatch table is filled from, when the chain skips pass-through layers.
+    XrResult ChainGetInstanceProcAddr(uint32_t first_layer, XrInstance instance, const char* name, PFN_xrVoidFunction* function);
+    //! The trampoline call statistics, or nullptr unless XR_EXTX_loader_call_statistics is enabled
+    LoaderCallStatistics* CallStatistics() const { return _call_statistics.get(); }
+    //! What xrGetInstanceProcAddr last returned for a LoaderGipaCommandIndex, or nullptr if it has not been asked yet
+    PFN_xrVoidFunction CachedProcAddr(uint32_t command) const {
+        return command < _proc_addr_cache_size ? _proc_addr_cache[command].load(std::memory_order_acquire) : nullptr;
+    }
+    void CacheProcAddr(uint32_t command, PFN_xrVoidFunction function) {
+        if (command < _proc_addr_cache_size) {
+            _proc_addr_cache[command].store(function, std::memory_order_release);
+        }
+    }
     XrDebugUtilsMessengerEXT DefaultDebugUtilsMessenger() { return _messenger; }
     void SetDefaultDebugUtilsMessenger(XrDebugUtilsMessengerEXT messenger) { _messenger = messenger; }
 
@@ -90,25 +235,174 @@ class LoaderInstance {
     XrVersion _api_version;
     std::vector<std::unique_ptr<ApiLayerInterface>> _api_layer_interfaces;
     XrInstance _runtime_instance;
+    // Owned by RuntimeInterface, and fixed from the runtime's xrCreateInstance until its xrDestroyInstance
+    const XrGeneratedDispatchTable* _runtime_dispatch_table;
     bool _dispatch_valid;
+    bool _direct_dispatch;
+    bool _lazy_dispatch;
+    // The instance the dispatch table was created for, which lazy entries are looked up with
+    XrInstance _dispatch_instance;
     std::unique_ptr<XrGeneratedDispatchTable> _dispatch_table;
     std::vector<std::string> _enabled_extensions;
+    // Which of the extensions the loader knows are enabled, indexed by LoaderExtensionIndex
+    std::vector<bool> _enabled_extension_bits;
+    std::unique_ptr<LoaderCallStatistics> _call_statistics;
+    // xrGetInstanceProcAddr results, indexed by LoaderGipaCommandIndex
+    uint32_t _proc_addr_cache_size;
+    std::unique_ptr<std::atomic<PFN_xrVoidFunction>[]> _proc_addr_cache;
     // Internal debug messenger created during xrCreateInstance
     XrDebugUtilsMessengerEXT _messenger;
 };
 
+template <typename HandleType>
+inline typename HandleLoaderMap<HandleType>::Slot* HandleLoaderMap<HandleType>::FindSlot(Table& table, uint64_t key,
+                                                                                         uint64_t hash) {
+    const size_t max_probe = table.max_probe.load(std::memory_order_acquire);
+    size_t index = static_cast<size_t>(hash) & table.mask;
+    for (size_t distance = 0; distance <= max_probe; ++distance, index = (index + 1) & table.mask) {
+        const uint64_t slot_key = table.slots[index].key.load(std::memory_order_acquire);
+        if (slot_key == key) {
+            return &table.slots[index];
+        }
+        if (slot_key == 0) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+template <typename HandleType>
+inline bool HandleLoaderMap<HandleType>::PlaceKey(Table& table, uint64_t key, uint64_t hash, LoaderInstance* loader) {
+    size_t index = static_cast<size_t>(hash) & table.mask;
+    size_t distance = 0;
+    while (true) {
+        Slot& slot = table.slots[index];
+        const uint64_t slot_key = slot.key.load(std::memory_order_relaxed);
+        if (slot_key == 0 || slot.instance.load(std::memory_order_relaxed) == nullptr) {
+            break;
+        }
+        index = (index + 1) & table.mask;
+        ++distance;
+    }
+    if (distance > table.max_probe.load(std::memory_order_relaxed)) {
+        table.max_probe.store(distance, std::memory_order_release);
+    }
+    // Publish the key before the instance: a reader that matches the key early sees a null instance and reports the
+    // handle as not (yet) present, and a reader still looking for the tombstone's old key sees the new key when it checks
+    // the slot again.
+    Slot& slot = table.slots[index];
+    const bool unused = slot.key.load(std::memory_order_relaxed) == 0;
+    slot.key.store(key, std::memory_order_release);
+    slot.instance.store(loader, std::memory_order_release);
+    return unused;
+}
+
+template <typename HandleType>
+inline void HandleLoaderMap<HandleType>::Grow(Shard& shard) {
+    Table* old_table = shard.table.load(std::memory_order_relaxed);
+    size_t slot_count = kInitialSlotCount;
+    while (slot_count < (shard.live_count + 1) * 4) {
+        slot_count *= 2;
+    }
+    std::unique_ptr<Table> new_table(new Table(slot_count));
+    if (old_table != nullptr) {
+        for (size_t i = 0; i <= old_table->mask; ++i) {
+            LoaderInstance* loader = old_table->slots[i].instance.load(std::memory_order_relaxed);
+            if (loader != nullptr) {
+                const uint64_t key = old_table->slots[i].key.load(std::memory_order_relaxed);
+                PlaceKey(*new_table, key, HashKey(key), loader);
+            }
+        }
+    }
+    shard.table.store(new_table.get(), std::memory_order_release);
+    shard.tables.push_back(std::move(new_table));
+    shard.used_count = shard.live_count;
+}
+
+template <typename HandleType>
+inline void HandleLoaderMap<HandleType>::Rehash(Shard& shard) {
+    Table& table = *shard.table.load(std::memory_order_relaxed);
+    std::vector<std::pair<uint64_t, LoaderInstance*>> live_entries;
+    live_entries.reserve(shard.live_count);
+    for (size_t i = 0; i <= table.mask; ++i) {
+        LoaderInstance* loader = table.slots[i].instance.load(std::memory_order_relaxed);
+        if (loader != nullptr) {
+            live_entries.emplace_back(table.slots[i].key.load(std::memory_order_relaxed), loader);
+        }
+    }
+    // Readers may see the table half rewritten, but they also see the version change and probe again.
+    const uint64_t version = shard.version.load(std::memory_order_relaxed);
+    shard.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i <= table.mask; ++i) {
+        table.slots[i].key.store(0, std::memory_order_relaxed);
+        table.slots[i].instance.store(nullptr, std::memory_order_relaxed);
+    }
+    table.max_probe.store(0, std::memory_order_relaxed);
+    for (const auto& entry : live_entries) {
+        PlaceKey(table, entry.first, HashKey(entry.first), entry.second);
+    }
+    shard.version.store(version + 2, std::memory_order_release);
+    shard.used_count = shard.live_count;
+}
+
+template <typename HandleType>
+inline void HandleLoaderMap<HandleType>::RemoveSlot(Shard& shard, Slot& slot, LoaderInstance* loader, uint64_t key) {
+    slot.instance.store(nullptr, std::memory_order_release);
+    --shard.live_count;
+    auto owned = shard.owned_keys.find(loader);
+    if (owned != shard.owned_keys.end()) {
+        owned->second.erase(key);
+        if (owned->second.empty()) {
+            shard.owned_keys.erase(owned);
+        }
+    }
+}
+
 template <typename HandleType>
 inline LoaderInstance* HandleLoaderMap<HandleType>::Get(HandleType handle) {
     if (handle == XR_NULL_HANDLE) {
         return nullptr;
     }
+    const uint64_t key = KeyFor(handle);
+    // Read the epoch before the tables: an answer found after a removal is then remembered with an epoch that is
+    // already out of date, never with the new one.
+    const uint64_t epoch = epoch_.load(std::memory_order_acquire);
+    LookupCache& cache = thread_lookup_cache_;
+    if (cache.key == key && cache.map == this && cache.epoch == epoch) {
+        return cache.instance;
+    }
     // Try to find the handle in the appropriate map
-    UniqueLock lock(mutex_);
-    auto entry_returned = instance_map_.find(handle);
-    if (entry_returned == instance_map_.end()) {
-        return nullptr;
+    const uint64_t hash = HashKey(key);
+    Shard& shard = ShardFor(hash);
+    LoaderInstance* loader;
+    while (true) {
+        const uint64_t version = shard.version.load(std::memory_order_acquire);
+        Table* table = shard.table.load(std::memory_order_acquire);
+        Slot* slot = (table == nullptr) ? nullptr : FindSlot(*table, key, hash);
+        if (slot != nullptr) {
+            loader = slot->instance.load(std::memory_order_acquire);
+            // The slot may have been given to another key since it matched, by an insert reusing the tombstone or by a
+            // rehash in place.  The instance is this key's only if the slot still holds this key.
+            if (loader != nullptr && slot->key.load(std::memory_order_acquire) == key) {
+                break;
+            }
+        }
+        // Not found, which is only the answer if no rehash in place could have hidden the key while probing.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((version & 1) == 0 && shard.version.load(std::memory_order_relaxed) == version) {
+            loader = nullptr;
+            break;
+        }
+        std::this_thread::yield();
     }
-    return entry_returned->second;
+    if (loader != nullptr) {
+        cache.map = this;
+        cache.epoch = epoch;
+        cache.key = key;
+        cache.instance = loader;
+    }
+    return loader;
 }
 
 template <typename HandleType>
@@ -117,17 +411,52 @@ inline XrResult HandleLoaderMap<HandleType>::Insert(HandleType handle, LoaderIns
         // Internal error in loader or runtime.
         return XR_ERROR_RUNTIME_FAILURE;
     }
-    UniqueLock lock(mutex_);
-    //! @todo This check is currently disabled, because the loader is not good at cleaning up handles when their parent handles are
-    //! destroyed.
-#if 0
-    auto entry_returned = instance_map_.find(handle);
-    if (entry_returned != instance_map_.end()) {
-        // Internal error in loader or runtime.
-        return XR_ERROR_RUNTIME_FAILURE;
+    const uint64_t key = KeyFor(handle);
+    const uint64_t hash = HashKey(key);
+    Shard& shard = ShardFor(hash);
+    UniqueLock lock(shard.mutex);
+    Table* table = shard.table.load(std::memory_order_relaxed);
+    Slot* slot = (table == nullptr) ? nullptr : FindSlot(*table, key, hash);
+    //! @todo Finding a live entry here is not treated as an error, because the loader is not good at cleaning up handles when
+    //! their parent handles are destroyed.
+    if (slot != nullptr) {
+        LoaderInstance* previous = slot->instance.load(std::memory_order_relaxed);
+        if (previous == nullptr) {
+            ++shard.live_count;
+        } else if (previous != &loader) {
+            auto owned = shard.owned_keys.find(previous);
+            if (owned != shard.owned_keys.end()) {
+                owned->second.erase(key);
+                if (owned->second.empty()) {
+                    shard.owned_keys.erase(owned);
+                }
+            }
+        }
+        slot->instance.store(&loader, std::memory_order_release);
+        if (previous != nullptr && previous != &loader) {
+            epoch_.fetch_add(1, std::memory_order_release);
+        }
+    } else {
+        // Keep the table at most half used, counting tombstones, so probe sequences stay short.  When tombstones are
+        // most of what fills it, it is rehashed in place; otherwise it grows, so a table only ever grows with more than a
+        // quarter of it live.
+        const size_t slot_count = (table == nullptr) ? 0 : table->mask + 1;
+        if (table == nullptr || (shard.live_count + 1) * 2 > slot_count) {
+            Grow(shard);
+        } else if ((shard.used_count + 1) * 2 > slot_count) {
+            if (shard.used_count - shard.live_count >= shard.live_count) {
+                Rehash(shard);
+            } else {
+                Grow(shard);
+            }
+        }
+        table = shard.table.load(std::memory_order_relaxed);
+        if (PlaceKey(*table, key, hash, &loader)) {
+            ++shard.used_count;
+        }
+        ++shard.live_count;
     }
-#endif
-    instance_map_[handle] = &loader;
+    shard.owned_keys[&loader].insert(key);
     return XR_SUCCESS;
 }
 
@@ -137,19 +466,53 @@ inline XrResult HandleLoaderMap<HandleType>::Erase(HandleType handle) {
         // Internal error in loader or runtime.
         return XR_ERROR_RUNTIME_FAILURE;
     }
-    UniqueLock lock(mutex_);
-    auto entry_returned = instance_map_.find(handle);
-    if (entry_returned == instance_map_.end()) {
+    if (Take(handle) == nullptr) {
         // Internal error in loader or runtime.
         return XR_ERROR_RUNTIME_FAILURE;
     }
-    instance_map_.erase(handle);
     return XR_SUCCESS;
 }
 
+template <typename HandleType>
+inline LoaderInstance* HandleLoaderMap<HandleType>::Take(HandleType handle) {
+    if (handle == XR_NULL_HANDLE) {
+        return nullptr;
+    }
+    const uint64_t key = KeyFor(handle);
+    const uint64_t hash = HashKey(key);
+    Shard& shard = ShardFor(hash);
+    UniqueLock lock(shard.mutex);
+    Table* table = shard.table.load(std::memory_order_relaxed);
+    Slot* slot = (table == nullptr) ? nullptr : FindSlot(*table, key, hash);
+    if (slot == nullptr) {
+        return nullptr;
+    }
+    LoaderInstance* loader = slot->instance.load(std::memory_order_relaxed);
+    if (loader != nullptr) {
+        RemoveSlot(shard, *slot, loader, key);
+        epoch_.fetch_add(1, std::memory_order_release);
+    }
+    return loader;
+}
+
 template <typename HandleType>
 inline void HandleLoaderMap<HandleType>::RemoveHandlesForLoader(LoaderInstance& loader) {
-    UniqueLock lock(mutex_);
-    auto search_value = &loader;
-    map_erase_if(instance_map_, [=](value_t const& data) { return data.second && data.second == search_value; });
+    for (Shard& shard : shards_) {
+        UniqueLock lock(shard.mutex);
+        auto owned = shard.owned_keys.find(&loader);
+        if (owned == shard.owned_keys.end()) {
+            continue;
+        }
+        Table* table = shard.table.load(std::memory_order_relaxed);
+        for (uint64_t key : owned->second) {
+            Slot* slot = FindSlot(*table, key, HashKey(key));
+            if (slot != nullptr) {
+                slot->instance.store(nullptr, std::memory_order_release);
+                --shard.live_count;
+            }
+        }
+        shard.owned_keys.erase(owned);
+    }
+    // Always, even if nothing was found: the instance is about to be deleted, so nothing may still be handed out for it.
+    epoch_.fetch_add(1, std::memory_order_release);
 }
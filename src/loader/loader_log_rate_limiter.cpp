@@ -0,0 +1,110 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "loader_log_rate_limiter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+
+// 64-bit FNV-1a
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t byte = 0; byte < size; ++byte) {
+        hash ^= bytes[byte];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+uint64_t HashString(uint64_t hash, const char* text) {
+    if (nullptr != text) {
+        for (; *text != '\0'; ++text) {
+            hash ^= static_cast<unsigned char>(*text);
+            hash *= kFnvPrime;
+        }
+    }
+    // Include the terminator, so that moving characters from one string to the next changes the key
+    return HashBytes(hash, "", 1);
+}
+
+}  // namespace
+
+const size_t LoaderLogRateLimiter::kMaxBuckets;
+const std::chrono::seconds LoaderLogRateLimiter::kSummaryInterval(1);
+
+LoaderLogRateLimiter::LoaderLogRateLimiter(double messages_per_second)
+    : _messages_per_second(messages_per_second), _burst(std::max(1.0, messages_per_second)) {}
+
+uint64_t LoaderLogRateLimiter::Key(const char* message_id, const char* command_name, const char* message) {
+    uint64_t key = HashString(kFnvOffsetBasis, message_id);
+    key = HashString(key, command_name);
+    return HashString(key, message);
+}
+
+uint64_t LoaderLogRateLimiter::AddObjectToKey(uint64_t key, uint64_t object_handle, uint32_t object_type) {
+    key = HashBytes(key, &object_handle, sizeof(object_handle));
+    return HashBytes(key, &object_type, sizeof(object_type));
+}
+
+bool LoaderLogRateLimiter::Admit(uint64_t key, uint64_t& suppressed) {
+    const auto now = std::chrono::steady_clock::now();
+    suppressed = 0;
+
+    auto found = _buckets.find(key);
+    if (found == _buckets.end()) {
+        if (_buckets.size() >= kMaxBuckets) {
+            // Keep the buckets that are holding messages back, so that their counts still get reported
+            for (auto it = _buckets.begin(); it != _buckets.end();) {
+                if (it->second.suppressed == 0) {
+                    it = _buckets.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (_buckets.size() >= kMaxBuckets) {
+                _buckets.clear();
+            }
+        }
+        found = _buckets.emplace(key, Bucket{_burst, now, now, 0}).first;
+    }
+
+    Bucket& bucket = found->second;
+    const double elapsed = std::chrono::duration<double>(now - bucket.last_refill).count();
+    bucket.tokens = std::min(_burst, bucket.tokens + elapsed * _messages_per_second);
+    bucket.last_refill = now;
+    if (bucket.tokens < 1.0) {
+        ++bucket.suppressed;
+        if (now - bucket.last_summary >= kSummaryInterval) {
+            suppressed = bucket.suppressed;
+            bucket.suppressed = 0;
+            bucket.last_summary = now;
+        }
+        return false;
+    }
+    bucket.tokens -= 1.0;
+    suppressed = bucket.suppressed;
+    bucket.suppressed = 0;
+    bucket.last_summary = now;
+    return true;
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+/// Token-bucket limits on how often the same message is delivered, used by LoaderLogger when XR_LOADER_LOG_RATE_LIMIT
+/// is set.
+///
+/// Each distinct message, as identified by a key from the Key functions, gets a bucket holding up to one second's worth
+/// of messages at the configured rate, refilled at that rate.  A message is delivered while its bucket has a token left
+/// and suppressed otherwise.  Admit also says when to report how many copies were suppressed: when the message gets
+/// through again, or, while it is still being held back, once per kSummaryInterval.  Not thread-safe: LoaderLogger calls
+/// it with its mutex held.
+class LoaderLogRateLimiter {
+   public:
+    //! messages_per_second must be positive.
+    explicit LoaderLogRateLimiter(double messages_per_second);
+
+    //! Decide whether to deliver a message with this key now, returning true if it should be.  Either way, suppressed is
+    //! set to a number of held back copies to report now, or to 0 if there is nothing to report yet.
+    bool Admit(uint64_t key, uint64_t& suppressed);
+
+    //! How often to report copies of a message that is still being held back
+    static const std::chrono::seconds kSummaryInterval;
+
+    //! Start a key from a message's strings.  Any of them may be nullptr.
+    static uint64_t Key(const char* message_id, const char* command_name, const char* message);
+
+    //! Add an object the message is about to a key.
+    static uint64_t AddObjectToKey(uint64_t key, uint64_t object_handle, uint32_t object_type);
+
+   private:
+    struct Bucket {
+        double tokens;
+        std::chrono::steady_clock::time_point last_refill;
+        std::chrono::steady_clock::time_point last_summary;
+        uint64_t suppressed;
+    };
+
+    // Forget buckets once there are this many, so that a stream of ever different messages cannot grow the map forever
+    static const size_t kMaxBuckets = 4096;
+
+    double _messages_per_second;
+    double _burst;
+    std::unordered_map<uint64_t, Bucket> _buckets;
+};
@@ -27,11 +27,14 @@
 #include <openxr/openxr.h>
 
 #include <algorithm>
+#include <cstdlib>
+#include <deque>
 #include <iterator>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -112,8 +115,13 @@ XrDebugUtilsMessageTypeFlagsEXT LoaderLogMessageTypesToDebugUtilsMessageTypes(Xr
 }
 
 LoaderLogger::LoaderLogger() {
+    // With XR_LOADER_ASYNC_LOG set, the standard output and error loggers write on a background thread instead
+    char* async_log = PlatformUtilsGetSecureEnv("XR_LOADER_ASYNC_LOG");
+    bool asynchronous = (nullptr != async_log && std::string(async_log) != "0");
+    PlatformUtilsFreeEnv(async_log);
+
     // Add an error logger by default so that we at least get errors out to std::cerr.
-    AddLogRecorder(MakeStdErrLoaderLogRecorder(nullptr));
+    AddLogRecorder(MakeStdErrLoaderLogRecorder(nullptr, asynchronous));
 
     // If the environment variable to enable loader debugging is set, then enable the
     // appropriate logging out to std::cout.
@@ -133,54 +141,313 @@ LoaderLogger::LoaderLogger() {
             debug_flags = XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT |
                           XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT;
         }
-        AddLogRecorder(MakeStdOutLoaderLogRecorder(nullptr, debug_flags));
+        AddLogRecorder(MakeStdOutLoaderLogRecorder(nullptr, debug_flags, asynchronous));
+    }
+
+    // With XR_LOADER_LOG_RATE_LIMIT set to a number of messages per second, copies of the same message beyond that rate
+    // are held back and counted instead of delivered.
+    char* rate_limit = PlatformUtilsGetSecureEnv("XR_LOADER_LOG_RATE_LIMIT");
+    if (nullptr != rate_limit) {
+        const double messages_per_second = std::strtod(rate_limit, nullptr);
+        PlatformUtilsFreeEnv(rate_limit);
+        if (messages_per_second > 0.0) {
+            _rate_limiter.reset(new LoaderLogRateLimiter(messages_per_second));
+        }
+    }
+
+    // If the environment variable naming a shared-memory log is set, publish every message there for a viewer to read.
+    char* shared_log = PlatformUtilsGetSecureEnv("XR_LOADER_SHARED_LOG");
+    if (nullptr != shared_log) {
+        std::string shared_log_name = shared_log;
+        PlatformUtilsFreeEnv(shared_log);
+        if (!shared_log_name.empty()) {
+            std::unique_ptr<LoaderLogRecorder> shared_recorder = MakeSharedMemoryLoaderLogRecorder(shared_log_name);
+            if (shared_recorder) {
+                AddLogRecorder(std::move(shared_recorder));
+            }
+        }
+    }
+
+    // If the environment variable naming a binary log file is set, record every message there as well.
+    char* binary_log = PlatformUtilsGetSecureEnv("XR_LOADER_BINARY_LOG");
+    if (nullptr != binary_log) {
+        std::string binary_log_filename = binary_log;
+        PlatformUtilsFreeEnv(binary_log);
+        if (!binary_log_filename.empty()) {
+            std::unique_ptr<LoaderLogRecorder> binary_recorder = MakeBinaryFileLoaderLogRecorder(binary_log_filename);
+            if (binary_recorder) {
+                AddLogRecorder(std::move(binary_recorder));
+            }
+        }
+    }
+}
+
+namespace {
+
+// The debug utils recorders this thread is calling, or about to call, outside the logger's mutex.  A recorder removed
+// from one of its own callbacks is still held by them, so its removal does not wait for them.
+thread_local std::vector<const LoaderLogRecorder*> t_calling_recorders;
+
+// Copies of the object names and session labels a message refers to, which live in the logger's DebugUtilsData and may
+// change once its mutex is released, for the callbacks called after that.
+struct DetachedNamesAndLabels {
+    std::deque<std::string> strings;
+    std::vector<XrDebugUtilsLabelEXT> labels;
+    std::vector<XrDebugUtilsObjectNameInfoEXT> objects;
+
+    const char* Copy(const char* string) {
+        if (nullptr == string) {
+            return nullptr;
+        }
+        strings.emplace_back(string);
+        return strings.back().c_str();
+    }
+
+    XrDebugUtilsLabelEXT* CopyLabels(const XrDebugUtilsLabelEXT* source, uint32_t count) {
+        if (0 == count) {
+            return nullptr;
+        }
+        labels.assign(source, source + count);
+        for (XrDebugUtilsLabelEXT& label : labels) {
+            label.labelName = Copy(label.labelName);
+        }
+        return labels.data();
+    }
+
+    XrDebugUtilsObjectNameInfoEXT* CopyObjects(const XrDebugUtilsObjectNameInfoEXT* source, uint32_t count) {
+        if (0 == count) {
+            return nullptr;
+        }
+        objects.assign(source, source + count);
+        for (XrDebugUtilsObjectNameInfoEXT& object : objects) {
+            object.objectName = Copy(object.objectName);
+        }
+        return objects.data();
+    }
+};
+
+}  // namespace
+
+void LoaderLogger::Flush() {
+    LoaderLogger& logger = GetInstance();
+    std::lock_guard<std::recursive_mutex> lock(logger._mutex);
+    for (std::shared_ptr<LoaderLogRecorder>& recorder : logger._recorders) {
+        recorder->Flush();
     }
 }
 
-void LoaderLogger::AddLogRecorder(std::unique_ptr<LoaderLogRecorder>&& recorder) { _recorders.push_back(std::move(recorder)); }
+void LoaderLogger::AddLogRecorder(std::unique_ptr<LoaderLogRecorder>&& recorder) {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    _recorders.push_back(std::move(recorder));
+    UpdateMessageMasks();
+}
 
 void LoaderLogger::RemoveLogRecorder(uint64_t unique_id) {
-    vector_remove_if_and_erase(
-        _recorders, [=](std::unique_ptr<LoaderLogRecorder> const& recorder) { return recorder->UniqueId() == unique_id; });
+    std::vector<std::shared_ptr<LoaderLogRecorder>> removed;
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        for (std::shared_ptr<LoaderLogRecorder>& recorder : _recorders) {
+            if (recorder->UniqueId() == unique_id) {
+                removed.push_back(recorder);
+            }
+        }
+        vector_remove_if_and_erase(
+            _recorders, [=](std::shared_ptr<LoaderLogRecorder> const& recorder) { return recorder->UniqueId() == unique_id; });
+        UpdateMessageMasks();
+    }
+
+    // Once the messenger is destroyed its callback must not be called again, so wait for the other threads still calling
+    // it.  New deliveries no longer see it.
+    for (std::shared_ptr<LoaderLogRecorder>& recorder : removed) {
+        const long held_here = static_cast<long>(
+            std::count(t_calling_recorders.begin(), t_calling_recorders.end(), static_cast<const LoaderLogRecorder*>(recorder.get())));
+        while (recorder.use_count() > 1 + held_here) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Must be called with _mutex held.
+void LoaderLogger::UpdateMessageMasks() {
+    XrLoaderLogMessageSeverityFlags severities = 0;
+    XrLoaderLogMessageTypeFlags types = 0;
+    for (std::shared_ptr<LoaderLogRecorder>& recorder : _recorders) {
+        severities |= recorder->MessageSeverities();
+        types |= recorder->MessageTypes();
+    }
+    _message_severities.store(severities, std::memory_order_relaxed);
+    _message_types.store(types, std::memory_order_relaxed);
 }
 
 bool LoaderLogger::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
                               const std::string& message_id, const std::string& command_name, const std::string& message,
                               const std::vector<XrSdkLogObjectInfo>& objects) {
+    // Nothing would record it, so skip looking up object names and labels as well
+    if ((_message_severities.load(std::memory_order_relaxed) & message_severity) != message_severity ||
+        (_message_types.load(std::memory_order_relaxed) & message_type) != message_type) {
+        return false;
+    }
+
     XrLoaderLogMessengerCallbackData callback_data = {};
     callback_data.message_id = message_id.c_str();
     callback_data.command_name = command_name.c_str();
     callback_data.message = message.c_str();
 
+    std::unique_lock<std::recursive_mutex> lock(_mutex);
+
+    // Loader messages all share a message id, so their text is part of what makes them the same message
+    bool deliver = true;
+    uint64_t suppressed = 0;
+    if (_rate_limiter) {
+        uint64_t key = LoaderLogRateLimiter::Key(callback_data.message_id, callback_data.command_name, callback_data.message);
+        for (const XrSdkLogObjectInfo& object : objects) {
+            key = LoaderLogRateLimiter::AddObjectToKey(key, object.handle, static_cast<uint32_t>(object.type));
+        }
+        deliver = _rate_limiter->Admit(key, suppressed);
+        if (!deliver && suppressed == 0) {
+            return false;
+        }
+    }
+
     auto names_and_labels = data_.PopulateNamesAndLabels(objects);
     callback_data.objects = names_and_labels.sdk_objects.empty() ? nullptr : names_and_labels.sdk_objects.data();
     callback_data.object_count = static_cast<uint8_t>(names_and_labels.objects.size());
 
-    callback_data.session_labels = names_and_labels.labels.empty() ? nullptr : names_and_labels.labels.data();
-    callback_data.session_labels_count = static_cast<uint8_t>(names_and_labels.labels.size());
+    callback_data.session_labels =
+        names_and_labels.LabelCount() == 0 ? nullptr : const_cast<XrDebugUtilsLabelEXT*>(names_and_labels.Labels());
+    callback_data.session_labels_count = static_cast<uint8_t>(names_and_labels.LabelCount());
+
+    bool exit_app = false;
+    std::vector<std::shared_ptr<LoaderLogRecorder>> callbacks;
+    std::string summary;
+    XrLoaderLogMessengerCallbackData summary_data = callback_data;
+    if (suppressed > 0) {
+        summary = SuppressedMessagesSummary(suppressed, callback_data.message);
+        summary_data.message = summary.c_str();
+        exit_app |= DeliverMessage(message_severity, message_type, &summary_data, callbacks);
+    }
+    if (deliver) {
+        exit_app |= DeliverMessage(message_severity, message_type, &callback_data, callbacks);
+    }
+    if (!callbacks.empty()) {
+        DetachedNamesAndLabels detached;
+        callback_data.session_labels = detached.CopyLabels(callback_data.session_labels, callback_data.session_labels_count);
+        summary_data.session_labels = callback_data.session_labels;
+        exit_app |= CallDebugUtilsRecorders(lock, callbacks, [&](LoaderLogRecorder& recorder) {
+            bool exit_app_here = false;
+            if (suppressed > 0) {
+                exit_app_here |= recorder.LogMessage(message_severity, message_type, &summary_data);
+            }
+            if (deliver) {
+                exit_app_here |= recorder.LogMessage(message_severity, message_type, &callback_data);
+            }
+            return exit_app_here;
+        });
+    }
+    return exit_app;
+}
 
+bool LoaderLogger::DeliverMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                                  const XrLoaderLogMessengerCallbackData* callback_data,
+                                  std::vector<std::shared_ptr<LoaderLogRecorder>>& callbacks) {
     bool exit_app = false;
-    for (std::unique_ptr<LoaderLogRecorder>& recorder : _recorders) {
+    for (std::shared_ptr<LoaderLogRecorder>& recorder : _recorders) {
         if ((recorder->MessageSeverities() & message_severity) == message_severity &&
             (recorder->MessageTypes() & message_type) == message_type) {
-            exit_app |= recorder->LogMessage(message_severity, message_type, &callback_data);
+            if (recorder->Type() == XR_LOADER_LOG_DEBUG_UTILS) {
+                if (std::find(callbacks.begin(), callbacks.end(), recorder) == callbacks.end()) {
+                    callbacks.push_back(recorder);
+                }
+            } else {
+                exit_app |= recorder->LogMessage(message_severity, message_type, callback_data);
+            }
         }
     }
     return exit_app;
 }
 
+template <typename Deliver>
+bool LoaderLogger::CallDebugUtilsRecorders(std::unique_lock<std::recursive_mutex>& lock,
+                                           const std::vector<std::shared_ptr<LoaderLogRecorder>>& callbacks, Deliver deliver) {
+    const size_t calling_base = t_calling_recorders.size();
+    for (const std::shared_ptr<LoaderLogRecorder>& recorder : callbacks) {
+        t_calling_recorders.push_back(recorder.get());
+    }
+    lock.unlock();
+
+    bool exit_app = false;
+    for (const std::shared_ptr<LoaderLogRecorder>& recorder : callbacks) {
+        exit_app |= deliver(*recorder);
+    }
+
+    t_calling_recorders.resize(calling_base);
+    return exit_app;
+}
+
+std::string LoaderLogger::SuppressedMessagesSummary(uint64_t suppressed, const char* message) {
+    return "Suppressed " + std::to_string(suppressed) + " duplicate" + (suppressed == 1 ? "" : "s") +
+           " since last reported (XR_LOADER_LOG_RATE_LIMIT): " + (message == nullptr ? "" : message);
+}
+
 // Extension-specific logging functions
 bool LoaderLogger::LogDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT message_severity,
                                         XrDebugUtilsMessageTypeFlagsEXT message_type,
                                         const XrDebugUtilsMessengerCallbackDataEXT* callback_data) {
-    bool exit_app = false;
+    std::unique_lock<std::recursive_mutex> lock(_mutex);
+
+    bool deliver = true;
+    uint64_t suppressed = 0;
+    if (_rate_limiter) {
+        uint64_t key = LoaderLogRateLimiter::Key(callback_data->messageId, callback_data->functionName, nullptr);
+        for (uint32_t obj = 0; obj < callback_data->objectCount; ++obj) {
+            key = LoaderLogRateLimiter::AddObjectToKey(key, callback_data->objects[obj].objectHandle,
+                                                       static_cast<uint32_t>(callback_data->objects[obj].objectType));
+        }
+        deliver = _rate_limiter->Admit(key, suppressed);
+        if (!deliver && suppressed == 0) {
+            return false;
+        }
+    }
+
+    AugmentedCallbackData augmented(*callback_data);
+    data_.AugmentCallbackData(augmented);
+
+    std::vector<std::shared_ptr<LoaderLogRecorder>> callbacks;
+    DeliverDebugUtilsMessage(message_severity, message_type, callbacks);
+    if (callbacks.empty()) {
+        return false;
+    }
+
+    XrDebugUtilsMessengerCallbackDataEXT detached_data = *augmented.callback_data_to_use;
+    DetachedNamesAndLabels detached;
+    detached_data.objects = detached.CopyObjects(detached_data.objects, detached_data.objectCount);
+    detached_data.sessionLabels = detached.CopyLabels(detached_data.sessionLabels, detached_data.sessionLabelCount);
+    XrDebugUtilsMessengerCallbackDataEXT summary_data = detached_data;
+    std::string summary;
+    if (suppressed > 0) {
+        summary = SuppressedMessagesSummary(suppressed, summary_data.message);
+        summary_data.message = summary.c_str();
+    }
+    return CallDebugUtilsRecorders(lock, callbacks, [&](LoaderLogRecorder& recorder) {
+        bool exit_app = false;
+        if (suppressed > 0) {
+            exit_app |= recorder.LogDebugUtilsMessage(message_severity, message_type, &summary_data);
+        }
+        if (deliver) {
+            exit_app |= recorder.LogDebugUtilsMessage(message_severity, message_type, &detached_data);
+        }
+        return exit_app;
+    });
+}
+
+void LoaderLogger::DeliverDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT message_severity,
+                                            XrDebugUtilsMessageTypeFlagsEXT message_type,
+                                            std::vector<std::shared_ptr<LoaderLogRecorder>>& callbacks) {
     XrLoaderLogMessageSeverityFlags log_message_severity = DebugUtilsSeveritiesToLoaderLogMessageSeverities(message_severity);
     XrLoaderLogMessageTypeFlags log_message_type = DebugUtilsMessageTypesToLoaderLogMessageTypes(message_type);
 
-    auto augmented = data_.AugmentCallbackData(*callback_data);
-
     // Loop through the recorders
-    for (std::unique_ptr<LoaderLogRecorder>& recorder : _recorders) {
+    for (std::shared_ptr<LoaderLogRecorder>& recorder : _recorders) {
         // Only send the message if it's a debug utils recorder and of the type the recorder cares about.
         if (recorder->Type() != XR_LOADER_LOG_DEBUG_UTILS ||
             (recorder->MessageSeverities() & log_message_severity) != log_message_severity ||
@@ -188,23 +455,31 @@ bool LoaderLogger::LogDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT mess
             continue;
         }
 
-        exit_app |= recorder->LogDebugUtilsMessage(message_severity, message_type, augmented.callback_data_to_use);
+        callbacks.push_back(recorder);
     }
-    return exit_app;
 }
 
 void LoaderLogger::AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name) {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     data_.AddObjectName(object_handle, object_type, object_name);
 }
 
 void LoaderLogger::BeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT* label_info) {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     data_.BeginLabelRegion(session, *label_info);
 }
 
-void LoaderLogger::EndLabelRegion(XrSession session) { data_.EndLabelRegion(session); }
+void LoaderLogger::EndLabelRegion(XrSession session) {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    data_.EndLabelRegion(session);
+}
 
 void LoaderLogger::InsertLabel(XrSession session, const XrDebugUtilsLabelEXT* label_info) {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
     data_.InsertLabel(session, *label_info);
 }
 
-void LoaderLogger::DeleteSessionLabels(XrSession session) { data_.DeleteSessionLabels(session); }
+void LoaderLogger::DeleteSessionLabels(XrSession session) {
+    std::lock_guard<std::recursive_mutex> lock(_mutex);
+    data_.DeleteSessionLabels(session);
+}
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -28,6 +29,7 @@
 #include <openxr/openxr.h>
 
 #include "hex_and_handles.h"
+#include "loader_log_rate_limiter.hpp"
 #include "object_info.h"
 
 // Use internal versions of flags similar to XR_EXT_debug_utils so that
@@ -63,6 +65,8 @@ enum XrLoaderLogType {
     XR_LOADER_LOG_STDERR,
     XR_LOADER_LOG_STDOUT,
     XR_LOADER_LOG_DEBUG_UTILS,
+    XR_LOADER_LOG_BINARY_FILE,
+    XR_LOADER_LOG_SHARED_MEMORY,
 };
 
 class LoaderLogRecorder {
@@ -96,6 +100,9 @@ class LoaderLogRecorder {
 
     virtual void Stop() { _active = false; }
 
+    // Write out anything the recorder is holding on to - defaults to do nothing.
+    virtual void Flush() {}
+
     virtual bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
                             const XrLoaderLogMessengerCallbackData* callback_data) = 0;
 
@@ -123,6 +130,20 @@ class LoaderLogger {
     void AddLogRecorder(std::unique_ptr<LoaderLogRecorder>&& recorder);
     void RemoveLogRecorder(uint64_t unique_id);
 
+    //! Have every recorder write out any messages it is still buffering
+    static void Flush();
+
+    //! Whether any recorder would take a message of this severity and type.  Check this before building a message
+    //! that is expensive to put together, so that logging which is turned off costs nothing.
+    static bool IsEnabled(XrLoaderLogMessageSeverityFlagBits message_severity,
+                          XrLoaderLogMessageTypeFlags message_type = XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT) {
+        const LoaderLogger& logger = GetInstance();
+        return (logger._message_severities.load(std::memory_order_relaxed) & message_severity) == message_severity &&
+               (logger._message_types.load(std::memory_order_relaxed) & message_type) == message_type;
+    }
+    static bool IsInfoEnabled() { return IsEnabled(XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT); }
+    static bool IsVerboseEnabled() { return IsEnabled(XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT); }
+
     //! Called from LoaderXrTermSetDebugUtilsObjectNameEXT - an empty name means remove
     void AddObjectName(uint64_t object_handle, XrObjectType object_type, const std::string& object_name);
     void BeginLabelRegion(XrSession session, const XrDebugUtilsLabelEXT* label_info);
@@ -153,6 +174,13 @@ class LoaderLogger {
         return GetInstance().LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT, XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT,
                                         "OpenXR-Loader", command_name, message, objects);
     }
+    // Overloads for string literals, so that an info or verbose message that nothing records does not build strings
+    static bool LogInfoMessage(const char* command_name, const char* message) {
+        return IsInfoEnabled() && LogInfoMessage(std::string(command_name), std::string(message));
+    }
+    static bool LogVerboseMessage(const char* command_name, const char* message) {
+        return IsVerboseEnabled() && LogVerboseMessage(std::string(command_name), std::string(message));
+    }
     static bool LogValidationErrorMessage(const std::string& vuid, const std::string& command_name, const std::string& message,
                                           const std::vector<XrSdkLogObjectInfo>& objects = {}) {
         return GetInstance().LogMessage(XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT, XR_LOADER_LOG_MESSAGE_TYPE_SPECIFICATION_BIT,
@@ -176,8 +204,35 @@ class LoaderLogger {
     static std::unique_ptr<LoaderLogger> _instance;
     static std::once_flag _once_flag;
 
-    // List of available recorder objects
-    std::vector<std::unique_ptr<LoaderLogRecorder>> _recorders;
+    // Guards the recorders and the debug utils data.  Recursive because a recorder may log in turn.  The application's
+    // debug utils callbacks are called with it released, so that one waiting on another thread which logs cannot deadlock.
+    std::recursive_mutex _mutex;
+
+    // List of available recorder objects, shared with the deliveries still calling them outside _mutex
+    std::vector<std::shared_ptr<LoaderLogRecorder>> _recorders;
+
+    // Union of the severities and types of every recorder, updated whenever one is added or removed
+    std::atomic<XrLoaderLogMessageSeverityFlags> _message_severities{0};
+    std::atomic<XrLoaderLogMessageTypeFlags> _message_types{0};
+    void UpdateMessageMasks();
+
+    // Send a message to every recorder that takes it, or a debug utils message to every debug utils recorder that does.
+    // Called with _mutex held, they only collect the debug utils recorders in callbacks, for CallDebugUtilsRecorders.
+    bool DeliverMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                        const XrLoaderLogMessengerCallbackData* callback_data,
+                        std::vector<std::shared_ptr<LoaderLogRecorder>>& callbacks);
+    void DeliverDebugUtilsMessage(XrDebugUtilsMessageSeverityFlagsEXT message_severity,
+                                  XrDebugUtilsMessageTypeFlagsEXT message_type,
+                                  std::vector<std::shared_ptr<LoaderLogRecorder>>& callbacks);
+
+    // Releases lock and calls deliver(recorder) for each of callbacks, returning whether any asked to exit the app
+    template <typename Deliver>
+    static bool CallDebugUtilsRecorders(std::unique_lock<std::recursive_mutex>& lock,
+                                        const std::vector<std::shared_ptr<LoaderLogRecorder>>& callbacks, Deliver deliver);
+    static std::string SuppressedMessagesSummary(uint64_t suppressed, const char* message);
+
+    // Set when XR_LOADER_LOG_RATE_LIMIT is, to hold back copies of the same message beyond that rate
+    std::unique_ptr<LoaderLogRateLimiter> _rate_limiter;
 
     DebugUtilsData data_;
 };
@@ -21,27 +21,449 @@
 
 #include "hex_and_handles.h"
 #include "loader_logger.hpp"
+#include "loader_shared_log.h"
 
 #include <openxr/openxr.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
-#include <iostream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 // Anonymous namespace to keep these types private
 namespace {
+
+// Write a loader message the way the standard output and error loggers show it.  Out is a StringLogText or a
+// FixedLogText, so that every logger that prints text prints exactly the same thing.
+template <typename Out>
+void WriteLoaderLogMessage(Out& out, XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                           const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT > message_severity) {
+        out << "Verbose [";
+    } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT > message_severity) {
+        out << "Info [";
+    } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT > message_severity) {
+        out << "Warning [";
+    } else {
+        out << "Error [";
+    }
+    switch (message_type) {
+        case XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT:
+            out << "GENERAL";
+            break;
+        case XR_LOADER_LOG_MESSAGE_TYPE_SPECIFICATION_BIT:
+            out << "SPEC";
+            break;
+        case XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT:
+            out << "PERF";
+            break;
+        default:
+            out << "UNKNOWN";
+            break;
+    }
+    out << " | " << callback_data->command_name << " | " << callback_data->message_id << "] : " << callback_data->message << "\n";
+
+    for (uint32_t obj = 0; obj < callback_data->object_count; ++obj) {
+        out << "    Object[" << std::to_string(obj) << "] = " << callback_data->objects[obj].ToString() << "\n";
+    }
+    for (uint32_t label = 0; label < callback_data->session_labels_count; ++label) {
+        out << "    SessionLabel[" << std::to_string(label) << "] = " << callback_data->session_labels[label].labelName << "\n";
+    }
+}
+
+// Appends formatted text to a string.
+class StringLogText {
+   public:
+    explicit StringLogText(std::string& text) : _text(text) {}
+
+    StringLogText& operator<<(const char* text) {
+        _text.append(text);
+        return *this;
+    }
+    StringLogText& operator<<(const std::string& text) {
+        _text.append(text);
+        return *this;
+    }
+
+   private:
+    std::string& _text;
+};
+
 // With std::cerr: Standard Error logger, always on for now
 // With std::cout: Standard Output logger used with XR_LOADER_DEBUG
+//
+// Messages are collected in a buffer and written out together, with one write and one flush, when the buffer grows past
+// kFlushSize, when a warning or an error comes in, once the oldest message in it is kFlushInterval old, on Flush (which
+// xrDestroyInstance calls) and when the recorder goes away.  That saves a system call per line (more for std::cerr, which
+// flushes after every insertion), and since LoaderLogger calls recorders one at a time, whole messages reach the stream
+// in the order they were logged.  The interval is kept by a thread started with the first message buffered, so a
+// verbose or info message waits at most kFlushInterval even if nothing is logged after it.  Flush stops the thread again,
+// so it is not left for static destruction to clean up.  Warnings and errors are never held back, so a process that
+// aborts loses at most the last kFlushInterval of verbose and info messages.
 class OstreamLoaderLogRecorder : public LoaderLogRecorder {
    public:
     OstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags);
+    ~OstreamLoaderLogRecorder() override;
+
+    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+
+    void Flush() override;
+
+   private:
+    static const size_t kFlushSize = 4096;
+    static const std::chrono::milliseconds kFlushInterval;
+
+    // Call with _buffer_mutex held
+    void WriteBuffer();
+    void RunFlushThread();
+
+    std::ostream& os_;
+    // Guards the buffer and the flush thread's state
+    std::mutex _buffer_mutex;
+    std::string _buffer;
+    std::chrono::steady_clock::time_point _buffer_started;
+    std::condition_variable _flush_wake;
+    std::thread _flush_thread;
+    bool _flush_thread_running = false;
+    bool _stop_flush_thread = false;
+};
+
+// A formatted message of bounded size.  Anything past the end is cut off, and the text then ends in "...".
+class FixedLogText {
+   public:
+    static const size_t kCapacity = 1024;
+
+    FixedLogText& operator<<(const char* text) {
+        Append(text, strlen(text));
+        return *this;
+    }
+    FixedLogText& operator<<(const std::string& text) {
+        Append(text.data(), text.size());
+        return *this;
+    }
+
+    const char* Data() const { return _data; }
+    size_t Size() const { return _size; }
+
+   private:
+    void Append(const char* text, size_t length) {
+        if (_truncated) {
+            return;
+        }
+        // Keep room for the "...\n" written when the text does not fit
+        const size_t room = kCapacity - 4 - _size;
+        if (length > room) {
+            memcpy(_data + _size, text, room);
+            _size += room;
+            memcpy(_data + _size, "...\n", 4);
+            _size += 4;
+            _truncated = true;
+            return;
+        }
+        memcpy(_data + _size, text, length);
+        _size += length;
+    }
+
+    char _data[kCapacity];
+    size_t _size = 0;
+    bool _truncated = false;
+};
+
+// Writes formatted messages to their streams on a background thread, so that logging threads never wait on the console.
+//
+// Messages go through a bounded multi-producer, single-consumer ring of fixed-size slots, each with a sequence number
+// that tells producers when it is free and the consumer when it is full, so pushing a message takes no lock.  When the
+// ring is full the message is dropped and counted, and the writer reports how many were dropped once there is room again.
+// The writer is shared by every asynchronous logger.  Its thread is started by the first message pushed, and stopped
+// again by Stop(), which xrDestroyInstance reaches through LoaderLogger::Flush: stopping writes out every message pushed
+// before it and joins the thread, so the thread is not left for static destruction to clean up.  A message pushed while
+// it stops, too late for its last drain, is written out by the Push itself.
+class AsyncLogWriter {
+   public:
+    static std::shared_ptr<AsyncLogWriter> Get() {
+        static std::mutex writer_mutex;
+        static std::weak_ptr<AsyncLogWriter> current_writer;
+        std::lock_guard<std::mutex> lock(writer_mutex);
+        std::shared_ptr<AsyncLogWriter> writer = current_writer.lock();
+        if (!writer) {
+            writer.reset(new AsyncLogWriter);
+            current_writer = writer;
+        }
+        return writer;
+    }
+
+    ~AsyncLogWriter() { Stop(); }
+
+    // Write out everything pushed so far and join the thread.  The next message pushed starts it again.
+    void Stop() {
+        std::lock_guard<std::mutex> lock(_thread_mutex);
+        if (!_running.load(std::memory_order_relaxed)) {
+            return;
+        }
+        _stop.store(true, std::memory_order_release);
+        _wake.notify_one();
+        _thread.join();
+        _stop.store(false, std::memory_order_relaxed);
+        _running.store(false, std::memory_order_release);
+        // Pairs with the fence in Push: either this drain sees a message pushed meanwhile, or its Push sees the writer
+        // stopped and writes it out itself.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // Anything pushed while the thread was on its way out is written here, now that nothing else is reading the ring.
+        WriteRemaining();
+    }
+
+    void Push(std::ostream* stream, const FixedLogText& text) {
+        if (!_running.load(std::memory_order_acquire)) {
+            Start();
+        }
+        size_t position = _enqueue_position.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &_slots[position % kSlotCount];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0) {
+                if (_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                position = _enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        slot->stream = stream;
+        slot->size = text.Size();
+        memcpy(slot->text, text.Data(), text.Size());
+        slot->sequence.store(position + 1, std::memory_order_release);
+        _wake.notify_one();
+
+        // A Stop that finished after the check above has already done its last drain, and no thread is left to write
+        // the message: write it out here, as Stop would have.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!_running.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(_thread_mutex);
+            if (!_running.load(std::memory_order_relaxed)) {
+                WriteRemaining();
+            }
+        }
+    }
+
+    AsyncLogWriter(const AsyncLogWriter&) = delete;
+    AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+   private:
+    static const size_t kSlotCount = 512;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        std::ostream* stream;
+        size_t size;
+        char text[FixedLogText::kCapacity];
+    };
+
+    AsyncLogWriter() : _slots(new Slot[kSlotCount]) {
+        for (size_t slot = 0; slot < kSlotCount; ++slot) {
+            _slots[slot].sequence.store(slot, std::memory_order_relaxed);
+        }
+    }
+
+    void Start() {
+        std::lock_guard<std::mutex> lock(_thread_mutex);
+        if (!_running.load(std::memory_order_relaxed)) {
+            _thread = std::thread(&AsyncLogWriter::Run, this);
+            _running.store(true, std::memory_order_release);
+        }
+    }
+
+    // Write out and flush every message in the ring.  Call with _thread_mutex held while the thread is not running.
+    void WriteRemaining() {
+        std::vector<std::ostream*> written_streams;
+        while (WriteNext(written_streams)) {
+        }
+        for (std::ostream* stream : written_streams) {
+            stream->flush();
+        }
+    }
+
+    // Write out one message, if there is one.
+    bool WriteNext(std::vector<std::ostream*>& written_streams) {
+        Slot& slot = _slots[_dequeue_position % kSlotCount];
+        if (slot.sequence.load(std::memory_order_acquire) != _dequeue_position + 1) {
+            return false;
+        }
+        slot.stream->write(slot.text, static_cast<std::streamsize>(slot.size));
+        if (std::find(written_streams.begin(), written_streams.end(), slot.stream) == written_streams.end()) {
+            written_streams.push_back(slot.stream);
+        }
+        slot.sequence.store(_dequeue_position + kSlotCount, std::memory_order_release);
+        ++_dequeue_position;
+        return true;
+    }
+
+    void Run() {
+        std::vector<std::ostream*> written_streams;
+        for (;;) {
+            // Read the stop flag before draining, so that everything pushed before Stop() was called is written.
+            bool stopping = _stop.load(std::memory_order_acquire);
+            while (WriteNext(written_streams)) {
+            }
+            uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped != 0) {
+                std::cerr << "Warning [GENERAL | AsyncLogWriter | OpenXR-Loader] : " << dropped
+                          << " loader log messages dropped, the log writer could not keep up\n";
+                written_streams.push_back(&std::cerr);
+            }
+            // Flush once for everything written, rather than once a line.
+            for (std::ostream* stream : written_streams) {
+                stream->flush();
+            }
+            written_streams.clear();
+            if (stopping) {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(_wake_mutex);
+            // Producers do not take the mutex to notify, so a wakeup can be missed: the timeout bounds the delay.
+            _wake.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<size_t> _enqueue_position{0};
+    size_t _dequeue_position = 0;
+    std::atomic<uint64_t> _dropped{0};
+    std::atomic<bool> _stop{false};
+    // Whether _thread is running; only changed with _thread_mutex held.
+    std::atomic<bool> _running{false};
+    std::mutex _thread_mutex;
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    std::thread _thread;
+};
+
+// Standard output and error loggers used with XR_LOADER_ASYNC_LOG: messages are formatted on the calling thread, and
+// written out by the AsyncLogWriter.
+class AsyncOstreamLoaderLogRecorder : public LoaderLogRecorder {
+   public:
+    AsyncOstreamLoaderLogRecorder(std::ostream& os, void* user_data, XrLoaderLogMessageSeverityFlags flags);
 
     bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
                     const XrLoaderLogMessengerCallbackData* callback_data) override;
 
+    // Writes out what is queued and stops the writer thread until the next message.
+    void Flush() override;
+
    private:
     std::ostream& os_;
+    std::shared_ptr<AsyncLogWriter> _writer;
+};
+
+// Binary log used with XR_LOADER_BINARY_LOG: records the fields of every message, uninterpreted, in a memory-mapped file,
+// for src/scripts/decode_loader_binary_log.py to turn into text later.
+//
+// The file starts with a 64 byte header, followed by records that each start on an 8 byte boundary with their size (u32)
+// and kind (u16, then 2 reserved bytes).  Strings that repeat - command names, message ids, object and label names - are
+// written once, in a string record, and messages refer to them by id.  All values are in the byte order of the machine
+// that wrote the file, which the decoder works out from the magic number.
+//
+//   header:  u32 magic "XRLB", u32 version, u64 capacity, u64 bytes used, u64 messages dropped,
+//            i64 system clock at start (ns since the epoch), u32 process id, then reserved bytes
+//   string:  u32 id, u32 length, bytes
+//   message: u64 ns since start, u32 thread, u8 severity (0 verbose to 3 error), u8 type bits, u8 object count,
+//            u8 label count, u32 command name id, u32 message id id, u32 message length,
+//            then per object u64 handle, u32 object type, u32 name id, then a u32 id per label, then the message bytes
+//
+// Messages that no longer fit are counted in the header rather than written.  LoaderLogger calls recorders with its mutex
+// held, so records are written by one thread at a time.
+class BinaryFileLoaderLogRecorder : public LoaderLogRecorder {
+   public:
+    static const uint32_t kMagic = 0x424c5258;  // "XRLB"
+    static const uint32_t kVersion = 1;
+    static const size_t kHeaderSize = 64;
+    static const size_t kCapacity = 16 * 1024 * 1024;
+    static const uint16_t kStringRecord = 1;
+    static const uint16_t kMessageRecord = 2;
+
+    static std::unique_ptr<LoaderLogRecorder> Create(const std::string& filename);
+    ~BinaryFileLoaderLogRecorder() override;
+
+    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+
+   private:
+    BinaryFileLoaderLogRecorder();
+    bool Map(const std::string& filename);
+    void Unmap();
+
+    template <typename T>
+    void Put(size_t offset, T value) {
+        memcpy(_data + offset, &value, sizeof(value));
+    }
+    static size_t Align(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+    // Begin a record of the given payload size and kind, returning the offset of its payload, or 0 if it does not fit.
+    size_t BeginRecord(size_t payload_size, uint16_t kind);
+    void EndRecord(size_t record_offset);
+    uint32_t Intern(const char* text);
+    uint32_t ThreadNumber();
+
+    uint8_t* _data = nullptr;
+    size_t _used = kHeaderSize;
+    uint64_t _dropped = 0;
+    std::chrono::steady_clock::time_point _start;
+    std::unordered_map<std::string, uint32_t> _string_ids;
+    std::unordered_map<std::thread::id, uint32_t> _thread_numbers;
+#if defined(_WIN32)
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _file = -1;
+#endif
+};
+
+// Shared-memory log used with XR_LOADER_SHARED_LOG: publishes every message, formatted as the standard output logger
+// shows it, into a ring in named shared memory for a viewer in another process to read (see loader_shared_log.h and
+// src/tests/list/loader_log_viewer.cpp).  Logging a message costs formatting it and copying it into the ring, with no
+// system calls; if no viewer keeps up, messages are dropped and counted rather than waited on.
+class SharedMemoryLoaderLogRecorder : public LoaderLogRecorder {
+   public:
+    static const size_t kCapacity = 1024 * 1024;
+
+    static std::unique_ptr<LoaderLogRecorder> Create(const std::string& name);
+    ~SharedMemoryLoaderLogRecorder() override;
+
+    bool LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity, XrLoaderLogMessageTypeFlags message_type,
+                    const XrLoaderLogMessengerCallbackData* callback_data) override;
+
+   private:
+    SharedMemoryLoaderLogRecorder();
+    bool Map(const std::string& name);
+    void Unmap();
+    uint8_t* Records() { return reinterpret_cast<uint8_t*>(_header) + sizeof(XrLoaderSharedLogHeader); }
+
+    XrLoaderSharedLogHeader* _header = nullptr;
+    std::string _object_name;
+#if defined(_WIN32)
+    HANDLE _mapping = nullptr;
+#endif
 };
 
 // Debug Utils logger used with XR_EXT_debug_utils
@@ -67,48 +489,464 @@ OstreamLoaderLogRecorder::OstreamLoaderLogRecorder(std::ostream& os, void* user_
     Start();
 }
 
+const size_t OstreamLoaderLogRecorder::kFlushSize;
+const std::chrono::milliseconds OstreamLoaderLogRecorder::kFlushInterval(50);
+
+OstreamLoaderLogRecorder::~OstreamLoaderLogRecorder() { Flush(); }
+
+void OstreamLoaderLogRecorder::WriteBuffer() {
+    if (!_buffer.empty()) {
+        os_.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+        os_.flush();
+        _buffer.clear();
+    }
+}
+
+void OstreamLoaderLogRecorder::RunFlushThread() {
+    std::unique_lock<std::mutex> lock(_buffer_mutex);
+    while (!_stop_flush_thread) {
+        if (_buffer.empty()) {
+            _flush_wake.wait(lock);
+        } else if (std::chrono::steady_clock::now() - _buffer_started >= kFlushInterval) {
+            WriteBuffer();
+        } else {
+            _flush_wake.wait_until(lock, _buffer_started + kFlushInterval);
+        }
+    }
+}
+
+void OstreamLoaderLogRecorder::Flush() {
+    std::thread flush_thread;
+    {
+        std::lock_guard<std::mutex> lock(_buffer_mutex);
+        if (_flush_thread_running) {
+            _stop_flush_thread = true;
+            _flush_wake.notify_one();
+            flush_thread = std::move(_flush_thread);
+        }
+    }
+    if (flush_thread.joinable()) {
+        flush_thread.join();
+    }
+    std::lock_guard<std::mutex> lock(_buffer_mutex);
+    _stop_flush_thread = false;
+    _flush_thread_running = false;
+    // Including anything logged while the thread was stopping
+    WriteBuffer();
+}
+
 bool OstreamLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
                                           XrLoaderLogMessageTypeFlags message_type,
                                           const XrLoaderLogMessengerCallbackData* callback_data) {
     if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
-        if (XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT > message_severity) {
-            os_ << "Verbose [";
-        } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT > message_severity) {
-            os_ << "Info [";
-        } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT > message_severity) {
-            os_ << "Warning [";
-        } else {
-            os_ << "Error [";
+        std::lock_guard<std::mutex> lock(_buffer_mutex);
+        const auto now = std::chrono::steady_clock::now();
+        const bool was_empty = _buffer.empty();
+        if (was_empty) {
+            _buffer_started = now;
         }
-        switch (message_type) {
-            case XR_LOADER_LOG_MESSAGE_TYPE_GENERAL_BIT:
-                os_ << "GENERAL";
-                break;
-            case XR_LOADER_LOG_MESSAGE_TYPE_SPECIFICATION_BIT:
-                os_ << "SPEC";
-                break;
-            case XR_LOADER_LOG_MESSAGE_TYPE_PERFORMANCE_BIT:
-                os_ << "PERF";
-                break;
-            default:
-                os_ << "UNKNOWN";
-                break;
+        StringLogText text(_buffer);
+        WriteLoaderLogMessage(text, message_severity, message_type, callback_data);
+        if (XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT <= message_severity || _buffer.size() >= kFlushSize ||
+            now - _buffer_started >= kFlushInterval) {
+            WriteBuffer();
+        } else if (!_flush_thread_running) {
+            _flush_thread = std::thread(&OstreamLoaderLogRecorder::RunFlushThread, this);
+            _flush_thread_running = true;
+        } else if (was_empty) {
+            // Start the thread's wait for this message's interval
+            _flush_wake.notify_one();
         }
-        os_ << " | " << callback_data->command_name << " | " << callback_data->message_id << "] : " << callback_data->message
-            << std::endl;
+    }
+
+    // Return of "true" means that we should exit the application after the logged message.  We
+    // don't want to do that for our internal logging.  Only let a user return true.
+    return false;
+}
+
+AsyncOstreamLoaderLogRecorder::AsyncOstreamLoaderLogRecorder(std::ostream& os, void* user_data,
+                                                             XrLoaderLogMessageSeverityFlags flags)
+    : LoaderLogRecorder(XR_LOADER_LOG_STDOUT, user_data, flags, 0xFFFFFFFFUL), os_(os), _writer(AsyncLogWriter::Get()) {
+    // Automatically start
+    Start();
+}
+
+bool AsyncOstreamLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
+                                               XrLoaderLogMessageTypeFlags message_type,
+                                               const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (_active && 0 != (_message_severities & message_severity) && 0 != (_message_types & message_type)) {
+        FixedLogText text;
+        WriteLoaderLogMessage(text, message_severity, message_type, callback_data);
+        _writer->Push(&os_, text);
+    }
+    return false;
+}
 
-        for (uint32_t obj = 0; obj < callback_data->object_count; ++obj) {
-            os_ << "    Object[" << obj << "] = " << callback_data->objects[obj].ToString();
-            os_ << std::endl;
+void AsyncOstreamLoaderLogRecorder::Flush() { _writer->Stop(); }
+
+BinaryFileLoaderLogRecorder::BinaryFileLoaderLogRecorder()
+    : LoaderLogRecorder(XR_LOADER_LOG_BINARY_FILE, nullptr,
+                        XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT |
+                            XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT,
+                        0xFFFFFFFFUL),
+      _start(std::chrono::steady_clock::now()) {}
+
+std::unique_ptr<LoaderLogRecorder> BinaryFileLoaderLogRecorder::Create(const std::string& filename) {
+    std::unique_ptr<BinaryFileLoaderLogRecorder> recorder(new BinaryFileLoaderLogRecorder());
+    if (!recorder->Map(filename)) {
+        return nullptr;
+    }
+    memset(recorder->_data, 0, kHeaderSize);
+    recorder->Put<uint32_t>(0, kMagic);
+    recorder->Put<uint32_t>(4, kVersion);
+    recorder->Put<uint64_t>(8, kCapacity);
+    recorder->Put<uint64_t>(16, recorder->_used);
+    recorder->Put<uint64_t>(24, 0);
+    auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+    recorder->Put<int64_t>(32, static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count()));
+#if defined(_WIN32)
+    recorder->Put<uint32_t>(40, static_cast<uint32_t>(GetCurrentProcessId()));
+#else
+    recorder->Put<uint32_t>(40, static_cast<uint32_t>(getpid()));
+#endif
+    // Id 0 is the empty string, so it never needs a record
+    recorder->_string_ids.emplace(std::string(), 0);
+    recorder->Start();
+    return std::unique_ptr<LoaderLogRecorder>(recorder.release());
+}
+
+BinaryFileLoaderLogRecorder::~BinaryFileLoaderLogRecorder() { Unmap(); }
+
+#if defined(_WIN32)
+bool BinaryFileLoaderLogRecorder::Map(const std::string& filename) {
+    _file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == _file) {
+        return false;
+    }
+    const uint64_t capacity = kCapacity;
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(capacity >> 32),
+                                  static_cast<DWORD>(capacity & 0xFFFFFFFFUL), nullptr);
+    if (nullptr != _mapping) {
+        _data = static_cast<uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, kCapacity));
+    }
+    if (nullptr == _data) {
+        Unmap();
+        return false;
+    }
+    return true;
+}
+
+void BinaryFileLoaderLogRecorder::Unmap() {
+    if (nullptr != _data) {
+        UnmapViewOfFile(_data);
+        _data = nullptr;
+    }
+    if (nullptr != _mapping) {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+    }
+    if (INVALID_HANDLE_VALUE != _file) {
+        // Drop the unused end of the file
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(_used);
+        if (SetFilePointerEx(_file, end, nullptr, FILE_BEGIN)) {
+            SetEndOfFile(_file);
         }
-        for (uint32_t label = 0; label < callback_data->session_labels_count; ++label) {
-            os_ << "    SessionLabel[" << std::to_string(label) << "] = " << callback_data->session_labels[label].labelName;
-            os_ << std::endl;
+        CloseHandle(_file);
+        _file = INVALID_HANDLE_VALUE;
+    }
+}
+#else
+bool BinaryFileLoaderLogRecorder::Map(const std::string& filename) {
+    _file = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_file < 0) {
+        return false;
+    }
+    if (ftruncate(_file, static_cast<off_t>(kCapacity)) != 0) {
+        Unmap();
+        return false;
+    }
+    void* data = mmap(nullptr, kCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+    if (MAP_FAILED == data) {
+        Unmap();
+        return false;
+    }
+    _data = static_cast<uint8_t*>(data);
+    return true;
+}
+
+void BinaryFileLoaderLogRecorder::Unmap() {
+    if (nullptr != _data) {
+        munmap(_data, kCapacity);
+        _data = nullptr;
+    }
+    if (_file >= 0) {
+        // Drop the unused end of the file
+        if (ftruncate(_file, static_cast<off_t>(_used)) != 0) {
+            // Leave it full size: the header still says how much of it is used
         }
+        close(_file);
+        _file = -1;
     }
+}
+#endif
 
-    // Return of "true" means that we should exit the application after the logged message.  We
-    // don't want to do that for our internal logging.  Only let a user return true.
+size_t BinaryFileLoaderLogRecorder::BeginRecord(size_t payload_size, uint16_t kind) {
+    const size_t record_size = Align(8 + payload_size);
+    if (record_size > kCapacity - _used) {
+        return 0;
+    }
+    memset(_data + _used, 0, record_size);
+    Put<uint32_t>(_used, static_cast<uint32_t>(record_size));
+    Put<uint16_t>(_used + 4, kind);
+    return _used + 8;
+}
+
+void BinaryFileLoaderLogRecorder::EndRecord(size_t record_offset) {
+    uint32_t record_size;
+    memcpy(&record_size, _data + record_offset - 8, sizeof(record_size));
+    _used += record_size;
+    Put<uint64_t>(16, _used);
+}
+
+uint32_t BinaryFileLoaderLogRecorder::Intern(const char* text) {
+    if (nullptr == text) {
+        return 0;
+    }
+    auto found = _string_ids.find(text);
+    if (found != _string_ids.end()) {
+        return found->second;
+    }
+    const size_t length = strlen(text);
+    const size_t offset = BeginRecord(8 + length, kStringRecord);
+    if (0 == offset) {
+        return 0;
+    }
+    const auto id = static_cast<uint32_t>(_string_ids.size());
+    Put<uint32_t>(offset, id);
+    Put<uint32_t>(offset + 4, static_cast<uint32_t>(length));
+    memcpy(_data + offset + 8, text, length);
+    EndRecord(offset);
+    _string_ids.emplace(text, id);
+    return id;
+}
+
+uint32_t BinaryFileLoaderLogRecorder::ThreadNumber() {
+    // Number threads in the order they first log something, which reads better than hashed ids
+    auto thread = _thread_numbers.emplace(std::this_thread::get_id(), static_cast<uint32_t>(_thread_numbers.size() + 1));
+    return thread.first->second;
+}
+
+bool BinaryFileLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
+                                             XrLoaderLogMessageTypeFlags message_type,
+                                             const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (!_active || nullptr == _data) {
+        return false;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - _start;
+    uint8_t severity = 3;
+    if (XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT > message_severity) {
+        severity = 0;
+    } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT > message_severity) {
+        severity = 1;
+    } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT > message_severity) {
+        severity = 2;
+    }
+
+    // Strings first, so that their records come before the message that uses them.
+    const uint32_t command_id = Intern(callback_data->command_name);
+    const uint32_t message_id_id = Intern(callback_data->message_id);
+    std::vector<uint32_t> object_name_ids(callback_data->object_count);
+    for (uint8_t obj = 0; obj < callback_data->object_count; ++obj) {
+        object_name_ids[obj] = Intern(callback_data->objects[obj].name.c_str());
+    }
+    std::vector<uint32_t> label_ids(callback_data->session_labels_count);
+    for (uint8_t label = 0; label < callback_data->session_labels_count; ++label) {
+        label_ids[label] = Intern(callback_data->session_labels[label].labelName);
+    }
+
+    const size_t message_length = (nullptr == callback_data->message) ? 0 : strlen(callback_data->message);
+    const size_t payload_size = 28 + 16 * static_cast<size_t>(callback_data->object_count) +
+                                4 * static_cast<size_t>(callback_data->session_labels_count) + message_length;
+    const size_t offset = BeginRecord(payload_size, kMessageRecord);
+    if (0 == offset) {
+        ++_dropped;
+        Put<uint64_t>(24, _dropped);
+        return false;
+    }
+    size_t position = offset;
+    Put<uint64_t>(position, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    Put<uint32_t>(position + 8, ThreadNumber());
+    Put<uint8_t>(position + 12, severity);
+    Put<uint8_t>(position + 13, static_cast<uint8_t>(message_type));
+    Put<uint8_t>(position + 14, callback_data->object_count);
+    Put<uint8_t>(position + 15, callback_data->session_labels_count);
+    Put<uint32_t>(position + 16, command_id);
+    Put<uint32_t>(position + 20, message_id_id);
+    Put<uint32_t>(position + 24, static_cast<uint32_t>(message_length));
+    position += 28;
+    for (uint8_t obj = 0; obj < callback_data->object_count; ++obj) {
+        Put<uint64_t>(position, callback_data->objects[obj].handle);
+        Put<uint32_t>(position + 8, static_cast<uint32_t>(callback_data->objects[obj].type));
+        Put<uint32_t>(position + 12, object_name_ids[obj]);
+        position += 16;
+    }
+    for (uint32_t label_id : label_ids) {
+        Put<uint32_t>(position, label_id);
+        position += 4;
+    }
+    if (message_length > 0) {
+        memcpy(_data + position, callback_data->message, message_length);
+    }
+    EndRecord(offset);
+    return false;
+}
+
+const size_t SharedMemoryLoaderLogRecorder::kCapacity;
+
+SharedMemoryLoaderLogRecorder::SharedMemoryLoaderLogRecorder()
+    : LoaderLogRecorder(XR_LOADER_LOG_SHARED_MEMORY, nullptr,
+                        XR_LOADER_LOG_MESSAGE_SEVERITY_VERBOSE_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT |
+                            XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT | XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT,
+                        0xFFFFFFFFUL) {}
+
+std::unique_ptr<LoaderLogRecorder> SharedMemoryLoaderLogRecorder::Create(const std::string& name) {
+    std::unique_ptr<SharedMemoryLoaderLogRecorder> recorder(new SharedMemoryLoaderLogRecorder());
+    if (!recorder->Map(name)) {
+        return nullptr;
+    }
+    XrLoaderSharedLogHeader* header = recorder->_header;
+    header->magic = 0;
+    header->version = XrLoaderSharedLogHeader::kVersion;
+    header->capacity = static_cast<uint32_t>(kCapacity);
+#if defined(_WIN32)
+    header->process_id = static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    header->process_id = static_cast<uint32_t>(getpid());
+#endif
+    header->closed.store(0, std::memory_order_relaxed);
+    header->write_position.store(0, std::memory_order_relaxed);
+    header->read_position.store(0, std::memory_order_relaxed);
+    header->dropped.store(0, std::memory_order_relaxed);
+    // Readers check the magic number last, so only let them see it once everything else is in place
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = XrLoaderSharedLogHeader::kMagic;
+    recorder->Start();
+    return std::unique_ptr<LoaderLogRecorder>(recorder.release());
+}
+
+SharedMemoryLoaderLogRecorder::~SharedMemoryLoaderLogRecorder() {
+    if (nullptr != _header) {
+        _header->closed.store(1, std::memory_order_release);
+    }
+    Unmap();
+}
+
+#if defined(_WIN32)
+bool SharedMemoryLoaderLogRecorder::Map(const std::string& name) {
+    _object_name = XrLoaderSharedLogObjectName(name);
+    const uint64_t size = sizeof(XrLoaderSharedLogHeader) + kCapacity;
+    _mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                  static_cast<DWORD>(size & 0xFFFFFFFFUL), _object_name.c_str());
+    if (nullptr == _mapping) {
+        return false;
+    }
+    _header = static_cast<XrLoaderSharedLogHeader*>(MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size)));
+    if (nullptr == _header) {
+        Unmap();
+        return false;
+    }
+    return true;
+}
+
+void SharedMemoryLoaderLogRecorder::Unmap() {
+    if (nullptr != _header) {
+        UnmapViewOfFile(_header);
+        _header = nullptr;
+    }
+    if (nullptr != _mapping) {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+    }
+}
+#else
+bool SharedMemoryLoaderLogRecorder::Map(const std::string& name) {
+    _object_name = XrLoaderSharedLogObjectName(name);
+    const size_t size = sizeof(XrLoaderSharedLogHeader) + kCapacity;
+    int fd = shm_open(_object_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    void* data = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    // The mapping keeps the memory alive on its own
+    close(fd);
+    if (MAP_FAILED == data) {
+        shm_unlink(_object_name.c_str());
+        return false;
+    }
+    _header = static_cast<XrLoaderSharedLogHeader*>(data);
+    return true;
+}
+
+void SharedMemoryLoaderLogRecorder::Unmap() {
+    if (nullptr != _header) {
+        munmap(_header, sizeof(XrLoaderSharedLogHeader) + kCapacity);
+        _header = nullptr;
+        // A viewer that has it mapped keeps reading; this just stops the name from outliving the process
+        shm_unlink(_object_name.c_str());
+    }
+}
+#endif
+
+bool SharedMemoryLoaderLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits message_severity,
+                                               XrLoaderLogMessageTypeFlags message_type,
+                                               const XrLoaderLogMessengerCallbackData* callback_data) {
+    if (!_active || nullptr == _header) {
+        return false;
+    }
+    FixedLogText text;
+    WriteLoaderLogMessage(text, message_severity, message_type, callback_data);
+
+    // LoaderLogger calls recorders one at a time, so this is the ring's only writer
+    const uint64_t write_position = _header->write_position.load(std::memory_order_relaxed);
+    const uint64_t read_position = _header->read_position.load(std::memory_order_acquire);
+    const size_t offset = static_cast<size_t>(write_position & (kCapacity - 1));
+    const size_t record_size = XrLoaderSharedLogRecordSize(text.Size());
+    // A record that would run past the end of the ring starts over at the beginning instead
+    const size_t skip = (kCapacity - offset < record_size) ? kCapacity - offset : 0;
+    if (write_position - read_position + skip + record_size > kCapacity) {
+        _header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    uint8_t* records = Records();
+    if (skip != 0) {
+        const uint32_t wrap = 0;
+        memcpy(records + offset, &wrap, sizeof(wrap));
+    }
+
+    XrLoaderSharedLogRecord record = {};
+    record.size = static_cast<uint32_t>(record_size);
+    record.text_length = static_cast<uint32_t>(text.Size());
+    record.timestamp = static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    record.severity = 3;
+    if (XR_LOADER_LOG_MESSAGE_SEVERITY_INFO_BIT > message_severity) {
+        record.severity = 0;
+    } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_WARNING_BIT > message_severity) {
+        record.severity = 1;
+    } else if (XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT > message_severity) {
+        record.severity = 2;
+    }
+    record.type = static_cast<uint8_t>(message_type);
+    uint8_t* destination = records + ((offset + skip) & (kCapacity - 1));
+    memcpy(destination, &record, sizeof(record));
+    memcpy(destination + sizeof(record), text.Data(), text.Size());
+
+    _header->write_position.store(write_position + skip + record_size, std::memory_order_release);
     return false;
 }
 
@@ -140,8 +978,14 @@ bool DebugUtilsLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits messag
         utils_callback_data.messageId = callback_data->message_id;
         utils_callback_data.functionName = callback_data->command_name;
         utils_callback_data.message = callback_data->message;
-        std::vector<XrDebugUtilsObjectNameInfoEXT> utils_objects;
-        utils_objects.resize(callback_data->object_count);
+        // Messages rarely name more than a few objects, so only go to the heap for ones that name many.
+        XrDebugUtilsObjectNameInfoEXT inline_objects[AugmentedCallbackData::kInlineObjectCount];
+        std::vector<XrDebugUtilsObjectNameInfoEXT> heap_objects;
+        XrDebugUtilsObjectNameInfoEXT* utils_objects = inline_objects;
+        if (callback_data->object_count > AugmentedCallbackData::kInlineObjectCount) {
+            heap_objects.resize(callback_data->object_count);
+            utils_objects = heap_objects.data();
+        }
         for (uint8_t object = 0; object < callback_data->object_count; ++object) {
             utils_objects[object].type = XR_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
             utils_objects[object].next = nullptr;
@@ -150,7 +994,7 @@ bool DebugUtilsLogRecorder::LogMessage(XrLoaderLogMessageSeverityFlagBits messag
             utils_objects[object].objectName = callback_data->objects[object].name.c_str();
         }
         utils_callback_data.objectCount = callback_data->object_count;
-        utils_callback_data.objects = utils_objects.data();
+        utils_callback_data.objects = callback_data->object_count == 0 ? nullptr : utils_objects;
         utils_callback_data.sessionLabelCount = callback_data->session_labels_count;
         utils_callback_data.sessionLabels = callback_data->session_labels;
 
@@ -172,15 +1016,31 @@ bool DebugUtilsLogRecorder::LogDebugUtilsMessage(XrDebugUtilsMessageSeverityFlag
 
 }  // namespace
 
-std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags) {
-    std::unique_ptr<LoaderLogRecorder> recorder(new OstreamLoaderLogRecorder(std::cout, user_data, flags));
+std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags,
+                                                               bool asynchronous) {
+    std::unique_ptr<LoaderLogRecorder> recorder;
+    if (asynchronous) {
+        recorder.reset(new AsyncOstreamLoaderLogRecorder(std::cout, user_data, flags));
+    } else {
+        recorder.reset(new OstreamLoaderLogRecorder(std::cout, user_data, flags));
+    }
     return recorder;
 }
-std::unique_ptr<LoaderLogRecorder> MakeStdErrLoaderLogRecorder(void* user_data) {
-    std::unique_ptr<LoaderLogRecorder> recorder(
-        new OstreamLoaderLogRecorder(std::cerr, user_data, XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT));
+std::unique_ptr<LoaderLogRecorder> MakeStdErrLoaderLogRecorder(void* user_data, bool asynchronous) {
+    std::unique_ptr<LoaderLogRecorder> recorder;
+    if (asynchronous) {
+        recorder.reset(new AsyncOstreamLoaderLogRecorder(std::cerr, user_data, XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT));
+    } else {
+        recorder.reset(new OstreamLoaderLogRecorder(std::cerr, user_data, XR_LOADER_LOG_MESSAGE_SEVERITY_ERROR_BIT));
+    }
     return recorder;
 }
+std::unique_ptr<LoaderLogRecorder> MakeBinaryFileLoaderLogRecorder(const std::string& filename) {
+    return BinaryFileLoaderLogRecorder::Create(filename);
+}
+std::unique_ptr<LoaderLogRecorder> MakeSharedMemoryLoaderLogRecorder(const std::string& name) {
+    return SharedMemoryLoaderLogRecorder::Create(name);
+}
 std::unique_ptr<LoaderLogRecorder> MakeDebugUtilsLoaderLogRecorder(const XrDebugUtilsMessengerCreateInfoEXT* create_info,
                                                                    XrDebugUtilsMessengerEXT debug_messenger) {
     std::unique_ptr<LoaderLogRecorder> recorder(new DebugUtilsLogRecorder(create_info, debug_messenger));
@@ -24,12 +24,22 @@
 #include <openxr/openxr.h>
 
 #include <memory>
+#include <string>
 
-//! Standard Error logger, always on for now
-std::unique_ptr<LoaderLogRecorder> MakeStdErrLoaderLogRecorder(void* user_data);
+//! Standard Error logger, always on for now.  Asynchronous loggers write on a background thread (XR_LOADER_ASYNC_LOG).
+std::unique_ptr<LoaderLogRecorder> MakeStdErrLoaderLogRecorder(void* user_data, bool asynchronous = false);
 
 //! Standard Output logger used with XR_LOADER_DEBUG
-std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags);
+std::unique_ptr<LoaderLogRecorder> MakeStdOutLoaderLogRecorder(void* user_data, XrLoaderLogMessageSeverityFlags flags,
+                                                               bool asynchronous = false);
+
+//! Binary log file used with XR_LOADER_BINARY_LOG, decoded by src/scripts/decode_loader_binary_log.py.  Returns nullptr if
+//! the file could not be created.
+std::unique_ptr<LoaderLogRecorder> MakeBinaryFileLoaderLogRecorder(const std::string& filename);
+
+//! Shared-memory ring used with XR_LOADER_SHARED_LOG, for a viewer in another process such as loader_log_viewer.
+//! Returns nullptr if the shared memory could not be created.
+std::unique_ptr<LoaderLogRecorder> MakeSharedMemoryLoaderLogRecorder(const std::string& name);
 
 // Debug Utils logger used with XR_EXT_debug_utils
 std::unique_ptr<LoaderLogRecorder> MakeDebugUtilsLoaderLogRecorder(const XrDebugUtilsMessengerCreateInfoEXT* create_info,
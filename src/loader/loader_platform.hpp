@@ -35,6 +35,16 @@
 #define LOADER_EXPORT
 #endif
 
+// Marks functions that only run when something has gone wrong, so the compiler keeps them out of line and away from
+// the code that runs on every call.
+#if defined(__GNUC__) || defined(__clang__)
+#define LOADER_COLD __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+#define LOADER_COLD __declspec(noinline)
+#else
+#define LOADER_COLD
+#endif
+
 // Environment variables
 #if defined(XR_OS_LINUX) || defined(XR_OS_APPLE)
 
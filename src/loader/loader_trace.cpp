@@ -0,0 +1,166 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "loader_trace.hpp"
+
+#include "platform_utils.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define OPENXR_TRACE_FILE_ENV_VAR "XR_LOADER_TRACE_FILE"
+
+namespace {
+
+// Enough for many instance creations with dozens of layers; events past this are dropped rather than growing without end.
+const size_t kMaxTraceEvents = 100000;
+
+struct TraceEvent {
+    const char* name;
+    std::string detail;
+    uint32_t thread;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+};
+
+std::mutex g_trace_mutex;
+std::vector<TraceEvent> g_trace_events;
+std::unordered_map<std::thread::id, uint32_t> g_trace_threads;
+size_t g_dropped_trace_events = 0;
+
+const std::string& TraceFilename() {
+    static const std::string filename = []() {
+        std::string value;
+        char* env_value = PlatformUtilsGetSecureEnv(OPENXR_TRACE_FILE_ENV_VAR);
+        if (nullptr != env_value) {
+            value = env_value;
+            PlatformUtilsFreeEnv(env_value);
+        }
+        return value;
+    }();
+    return filename;
+}
+
+// Times in the trace are microseconds since the first time tracing was checked.
+std::chrono::steady_clock::time_point TraceOrigin() {
+    static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    return origin;
+}
+
+uint32_t ProcessId() {
+#if defined(_WIN32)
+    return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    return static_cast<uint32_t>(getpid());
+#endif
+}
+
+void WriteJsonString(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (char c : value) {
+        switch (c) {
+            case '"':
+                out << "\\\"";
+                break;
+            case '\\':
+                out << "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                    out << escaped;
+                } else {
+                    out << c;
+                }
+                break;
+        }
+    }
+    out << '"';
+}
+
+double MicrosecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+}  // namespace
+
+bool LoaderTrace::IsEnabled() {
+    static const bool enabled = [] {
+        TraceOrigin();
+        return !TraceFilename().empty();
+    }();
+    return enabled;
+}
+
+void LoaderTrace::Record(const char* name, const std::string& detail, std::chrono::steady_clock::time_point start,
+                         std::chrono::steady_clock::time_point end) {
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    if (g_trace_events.size() >= kMaxTraceEvents) {
+        ++g_dropped_trace_events;
+        return;
+    }
+    // Number threads in the order they first record something, which reads better in a trace viewer than hashed ids.
+    auto thread = g_trace_threads.emplace(std::this_thread::get_id(), static_cast<uint32_t>(g_trace_threads.size() + 1));
+    g_trace_events.push_back({name, detail, thread.first->second, start, end});
+}
+
+void LoaderTrace::Flush() {
+    if (!IsEnabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    std::ofstream out(TraceFilename(), std::ios::out | std::ios::trunc);
+    if (!out) {
+        return;
+    }
+    const uint32_t process_id = ProcessId();
+    const std::chrono::steady_clock::time_point origin = TraceOrigin();
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << process_id
+        << ",\"tid\":0,\"args\":{\"name\":\"OpenXR loader\"}}";
+    char number[32];
+    for (const TraceEvent& event : g_trace_events) {
+        out << ",\n{\"name\":";
+        WriteJsonString(out, event.name);
+        out << ",\"cat\":\"loader\",\"ph\":\"X\",\"pid\":" << process_id << ",\"tid\":" << event.thread;
+        snprintf(number, sizeof(number), "%.3f", MicrosecondsBetween(origin, event.start));
+        out << ",\"ts\":" << number;
+        snprintf(number, sizeof(number), "%.3f", MicrosecondsBetween(event.start, event.end));
+        out << ",\"dur\":" << number;
+        if (!event.detail.empty()) {
+            out << ",\"args\":{\"detail\":";
+            WriteJsonString(out, event.detail);
+            out << "}";
+        }
+        out << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << g_dropped_trace_events << "}}\n";
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+/// Startup tracing of the loader's phases (XR_LOADER_TRACE_FILE).
+///
+/// When XR_LOADER_TRACE_FILE names a file, every LoaderTraceScope records one complete event with its start time,
+/// duration and thread, and every LoaderTraceCommand rewrites the file with all events recorded so far once its command
+/// returns, in the Chrome trace event JSON format read by chrome://tracing and the Perfetto UI.  The variable is read once,
+/// the first time anything is traced; with it unset a scope costs one check of a static flag on construction and on
+/// destruction.
+class LoaderTrace {
+   public:
+    /// Whether XR_LOADER_TRACE_FILE was set when tracing was first checked.
+    static bool IsEnabled();
+
+    /// Record one event that ran on the current thread from start to end.  name must be a string literal.
+    static void Record(const char* name, const std::string& detail, std::chrono::steady_clock::time_point start,
+                       std::chrono::steady_clock::time_point end);
+
+    /// Write every event recorded so far to the trace file, replacing what it held.
+    static void Flush();
+};
+
+/// Traces the enclosing block as one event, named by a string literal and optionally described by a detail string such as
+/// the manifest file or library it deals with.
+class LoaderTraceScope {
+   public:
+    explicit LoaderTraceScope(const char* name) : _name(name), _active(LoaderTrace::IsEnabled()) {
+        if (_active) {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+    LoaderTraceScope(const char* name, const std::string& detail) : _name(name), _active(LoaderTrace::IsEnabled()) {
+        if (_active) {
+            _detail = detail;
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+    ~LoaderTraceScope() { End(); }
+
+    /// Record the event now rather than at the end of the block.  Does nothing if it was already recorded.
+    void End() {
+        if (_active) {
+            _active = false;
+            LoaderTrace::Record(_name, _detail, _start, std::chrono::steady_clock::now());
+        }
+    }
+
+    LoaderTraceScope(const LoaderTraceScope&) = delete;
+    LoaderTraceScope& operator=(const LoaderTraceScope&) = delete;
+
+   private:
+    const char* _name;
+    bool _active;
+    std::string _detail;
+    std::chrono::steady_clock::time_point _start;
+};
+
+/// Traces a loader trampoline, writing out the trace file once it returns.
+class LoaderTraceCommand {
+   public:
+    explicit LoaderTraceCommand(const char* name) : _scope(name) {}
+    ~LoaderTraceCommand() {
+        if (LoaderTrace::IsEnabled()) {
+            _scope.End();
+            LoaderTrace::Flush();
+        }
+    }
+
+    LoaderTraceCommand(const LoaderTraceCommand&) = delete;
+    LoaderTraceCommand& operator=(const LoaderTraceCommand&) = delete;
+
+   private:
+    LoaderTraceScope _scope;
+};
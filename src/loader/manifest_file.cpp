@@ -22,28 +22,35 @@
 #endif  // defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
 
 #include "manifest_file.hpp"
+#include "manifest_file_cache.hpp"
+#include "manifest_json_reader.hpp"
 
 #ifdef OPENXR_HAVE_COMMON_CONFIG
 #include "common_config.h"
 #endif  // OPENXR_HAVE_COMMON_CONFIG
 
 #include "filesystem_utils.hpp"
+#include "loader_environment.hpp"
 #include "loader_platform.hpp"
 #include "platform_utils.hpp"
 #include "loader_logger.hpp"
+#include "loader_trace.hpp"
 
 #include <json/json.h>
 #include <openxr/openxr.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <fstream>
+#include <iterator>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -100,17 +107,32 @@ static void CheckAllFilesInThePath(const std::string &search_path, bool is_direc
                 AddIfJson(absolute_path, manifest_files);
             }
         } else {
-            std::vector<std::string> files;
-            if (FileSysUtilsFindFilesInPath(search_path, files)) {
-                for (std::string &cur_file : files) {
-                    std::string relative_path;
-                    FileSysUtilsCombinePaths(search_path, cur_file, relative_path);
-                    if (!FileSysUtilsGetAbsolutePath(relative_path, absolute_path)) {
-                        continue;
+            // Only list the directory again if something has been added to, removed from or renamed in it since the
+            // last time.
+            FileSysUtilsFileStamp stamp = {};
+            bool have_stamp = FileSysUtilsGetFileStamp(search_path, stamp);
+            std::vector<std::string> directory_manifest_files;
+            if (!have_stamp || !ManifestFileCache::FindDirectory(search_path, stamp, directory_manifest_files)) {
+                std::vector<FileSysUtilsDirectoryEntry> entries;
+                if (FileSysUtilsFindEntriesInPath(search_path, entries)) {
+                    for (FileSysUtilsDirectoryEntry &entry : entries) {
+                        // Only the names, and the types the listing came with, are needed to rule most entries out.
+                        if (!entry.is_regular_file || !StringEndsWith(entry.name, ".json")) {
+                            continue;
+                        }
+                        std::string relative_path;
+                        FileSysUtilsCombinePaths(search_path, entry.name, relative_path);
+                        if (!FileSysUtilsGetAbsolutePath(relative_path, absolute_path)) {
+                            continue;
+                        }
+                        AddIfJson(absolute_path, directory_manifest_files);
+                    }
+                    if (have_stamp) {
+                        ManifestFileCache::AddDirectory(search_path, stamp, directory_manifest_files);
                     }
-                    AddIfJson(absolute_path, manifest_files);
                 }
             }
+            manifest_files.insert(manifest_files.end(), directory_manifest_files.begin(), directory_manifest_files.end());
         }
     }
 }
@@ -185,7 +207,7 @@ static void ReadDataFilesInSearchPaths(ManifestFileType type, const std::string
                                        bool &override_active, std::vector<std::string> &manifest_files) {
     bool is_directory_list = true;
     bool is_runtime = (type == MANIFEST_TYPE_RUNTIME);
-    char *override_env = nullptr;
+    bool have_override = false;
     std::string override_path;
     std::string search_path;
 
@@ -193,47 +215,40 @@ static void ReadDataFilesInSearchPaths(ManifestFileType type, const std::string
 #ifndef XR_OS_WINDOWS
         if (geteuid() != getuid() || getegid() != getgid()) {
             // Don't allow setuid apps to use the env var:
-            override_env = nullptr;
+            have_override = false;
         } else
 #endif
         {
-            override_env = PlatformUtilsGetSecureEnv(override_env_var.c_str());
-            if (nullptr != override_env) {
+            have_override = LoaderGetSecureEnv(override_env_var.c_str(), override_path);
+            if (have_override) {
                 // The runtime override is actually a specific list of filenames, not directories
                 if (is_runtime) {
                     is_directory_list = false;
                 }
-                override_path = override_env;
             }
         }
     }
 
-    if (nullptr != override_env && !override_path.empty()) {
+    if (have_override && !override_path.empty()) {
         CopyIncludedPaths(is_directory_list, override_path, "", search_path);
-        PlatformUtilsFreeEnv(override_env);
         override_active = true;
     } else {
         override_active = false;
 #ifndef XR_OS_WINDOWS
-        bool xdg_conf_dirs_alloc = true;
-        bool xdg_data_dirs_alloc = true;
         const char home_additional[] = ".local/share/";
 
         // Determine how much space is needed to generate the full search path
         // for the current manifest files.
-        char *xdg_conf_dirs = PlatformUtilsGetSecureEnv("XDG_CONFIG_DIRS");
-        char *xdg_data_dirs = PlatformUtilsGetSecureEnv("XDG_DATA_DIRS");
-        char *xdg_data_home = PlatformUtilsGetSecureEnv("XDG_DATA_HOME");
-        char *home = PlatformUtilsGetSecureEnv("HOME");
-
-        if (nullptr == xdg_conf_dirs) {
-            xdg_conf_dirs_alloc = false;
-        }
-        if (nullptr == xdg_data_dirs) {
-            xdg_data_dirs_alloc = false;
-        }
-
-        if (nullptr == xdg_conf_dirs || xdg_conf_dirs[0] == '\0') {
+        std::string xdg_conf_dirs;
+        std::string xdg_data_dirs;
+        std::string xdg_data_home;
+        std::string home;
+        LoaderGetSecureEnv("XDG_CONFIG_DIRS", xdg_conf_dirs);
+        LoaderGetSecureEnv("XDG_DATA_DIRS", xdg_data_dirs);
+        bool have_xdg_data_home = LoaderGetSecureEnv("XDG_DATA_HOME", xdg_data_home);
+        bool have_home = LoaderGetSecureEnv("HOME", home);
+
+        if (xdg_conf_dirs.empty()) {
             CopyIncludedPaths(true, FALLBACK_CONFIG_DIRS, relative_path, search_path);
         } else {
             CopyIncludedPaths(true, xdg_conf_dirs, relative_path, search_path);
@@ -244,32 +259,19 @@ static void ReadDataFilesInSearchPaths(ManifestFileType type, const std::string
         CopyIncludedPaths(true, EXTRASYSCONFDIR, relative_path, search_path);
 #endif
 
-        if (xdg_data_dirs == nullptr || xdg_data_dirs[0] == '\0') {
+        if (xdg_data_dirs.empty()) {
             CopyIncludedPaths(true, FALLBACK_DATA_DIRS, relative_path, search_path);
         } else {
             CopyIncludedPaths(true, xdg_data_dirs, relative_path, search_path);
         }
 
-        if (nullptr != xdg_data_home) {
+        if (have_xdg_data_home) {
             CopyIncludedPaths(true, xdg_data_home, relative_path, search_path);
-        } else if (nullptr != home) {
+        } else if (have_home) {
             std::string relative_home_path = home_additional;
             relative_home_path += relative_path;
             CopyIncludedPaths(true, home, relative_home_path, search_path);
         }
-
-        if (xdg_conf_dirs_alloc) {
-            PlatformUtilsFreeEnv(xdg_conf_dirs);
-        }
-        if (xdg_data_dirs_alloc) {
-            PlatformUtilsFreeEnv(xdg_data_dirs);
-        }
-        if (nullptr != xdg_data_home) {
-            PlatformUtilsFreeEnv(xdg_data_home);
-        }
-        if (nullptr != home) {
-            PlatformUtilsFreeEnv(home);
-        }
 #endif
     }
 
@@ -284,21 +286,12 @@ static void ReadDataFilesInSearchPaths(ManifestFileType type, const std::string
 // is supplied. If ${fallback_env} or ${fallback_env}/... would be returned but that environment
 // variable is unset or empty, return the empty string.
 static std::string GetXDGEnv(const char *name, const char *fallback_env, const char *fallback_path) {
-    char *path = PlatformUtilsGetSecureEnv(name);
     std::string result;
-    if (path != nullptr) {
-        result = path;
-        PlatformUtilsFreeEnv(path);
-        if (!result.empty()) {
-            return result;
-        }
+    if (LoaderGetSecureEnv(name, result) && !result.empty()) {
+        return result;
     }
     if (fallback_env != nullptr) {
-        char *path = PlatformUtilsGetSecureEnv(fallback_env);
-        if (path != nullptr) {
-            result = path;
-            PlatformUtilsFreeEnv(path);
-        }
+        LoaderGetSecureEnv(fallback_env, result);
         if (result.empty()) {
             return "";
         }
@@ -446,6 +439,27 @@ static void ReadLayerDataFilesInRegistry(ManifestFileType type, const std::strin
 
 #endif  // XR_OS_WINDOWS
 
+// Read the whole of a manifest file.  Returns false if the file could not be opened.
+static bool ReadManifestContents(const std::string &filename, std::string &contents) {
+    std::ifstream json_stream(filename, std::ifstream::in | std::ifstream::binary);
+    if (!json_stream.is_open()) {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(json_stream), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Parse a manifest file's contents as JSON.  Returns false, with the reason in parse_errors, if they are not valid JSON.
+static bool ParseManifestJson(const std::string &contents, Json::Value &root, std::string &parse_errors) {
+    Json::Reader reader;
+    if (!reader.parse(contents, root, false) || root.isNull()) {
+        root = Json::Value(Json::nullValue);
+        parse_errors = reader.getFormattedErrorMessages();
+        return false;
+    }
+    return true;
+}
+
 ManifestFile::ManifestFile(ManifestFileType type, const std::string &filename, const std::string &library_path)
     : _filename(filename), _type(type), _library_path(library_path) {}
 
@@ -477,11 +491,16 @@ bool ManifestFile::IsValidJson(const Json::Value &root_node, JsonVersion &versio
 }
 
 static void GetExtensionProperties(const std::vector<ExtensionListing> &extensions, std::vector<XrExtensionProperties> &props) {
+    std::unordered_map<std::string, size_t> prop_index;
+    prop_index.reserve(props.size() + extensions.size());
+    for (size_t prop = 0; prop < props.size(); ++prop) {
+        prop_index.emplace(props[prop].extensionName, prop);
+    }
     for (const auto &ext : extensions) {
-        auto it =
-            std::find_if(props.begin(), props.end(), [&](XrExtensionProperties &prop) { return prop.extensionName == ext.name; });
-        if (it != props.end()) {
-            it->extensionVersion = std::max(it->extensionVersion, ext.extension_version);
+        auto inserted = prop_index.emplace(ext.name, props.size());
+        if (!inserted.second) {
+            XrExtensionProperties &prop = props[inserted.first->second];
+            prop.extensionVersion = std::max(prop.extensionVersion, ext.extension_version);
         } else {
             XrExtensionProperties prop = {};
             prop.type = XR_TYPE_EXTENSION_PROPERTIES;
@@ -506,6 +525,12 @@ void ManifestFile::GetDeviceExtensionProperties(std::vector<XrExtensionPropertie
     GetExtensionProperties(_device_extensions, props);
 }
 
+void ManifestFile::AddRecordContents(const ManifestRecord &record) {
+    _instance_extensions = record.instance_extensions;
+    _device_extensions = record.device_extensions;
+    _functions_renamed.insert(record.functions_renamed.begin(), record.functions_renamed.end());
+}
+
 const std::string &ManifestFile::GetFunctionName(const std::string &func_name) {
     if (!_functions_renamed.empty()) {
         auto found = _functions_renamed.find(func_name);
@@ -521,36 +546,41 @@ RuntimeManifestFile::RuntimeManifestFile(const std::string &filename, const std:
 
 RuntimeManifestFile::~RuntimeManifestFile() = default;
 
-void RuntimeManifestFile::CreateIfValid(const std::string &filename,
-                                        std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
-    std::ifstream json_stream(filename, std::ifstream::in);
-    if (!json_stream.is_open()) {
+// Read and validate a runtime manifest file, keeping what the loader needs from it in record.
+static bool ParseRuntimeManifest(const std::string &filename, ManifestRecord &record) {
+    LoaderTraceScope trace("Parse runtime manifest", filename);
+    std::string contents;
+    if (!ReadManifestContents(filename, contents)) {
         std::string error_message = "RuntimeManifestFile::createIfValid failed to open ";
         error_message += filename;
         error_message += ".  Does it exist?";
         LoaderLogger::LogErrorMessage("", error_message);
-        return;
+        return false;
     }
-    Json::Reader reader;
-    Json::Value root_node = Json::nullValue;
-    Json::Value runtime_root_node = Json::nullValue;
-    JsonVersion file_version = {};
-    if (!reader.parse(json_stream, root_node, false) || root_node.isNull()) {
+    // Well-formed manifests can be read without building a Json::Value tree.  jsoncpp handles the rest, and reports
+    // what is wrong with them.
+    if (ReadRuntimeManifestRecord(contents, record)) {
+        return true;
+    }
+    Json::Value root_node;
+    std::string parse_errors;
+    if (!ParseManifestJson(contents, root_node, parse_errors)) {
         std::string error_message = "RuntimeManifestFile::CreateIfValid failed to parse ";
         error_message += filename;
         error_message += ".  Is it a valid runtime manifest file? Error was:\n ";
-        error_message += reader.getFormattedErrorMessages();
+        error_message += parse_errors;
         LoaderLogger::LogErrorMessage("", error_message);
-        return;
+        return false;
     }
+    JsonVersion file_version = {};
     if (!ManifestFile::IsValidJson(root_node, file_version)) {
         std::string error_message = "RuntimeManifestFile::CreateIfValid isValidJson indicates ";
         error_message += filename;
         error_message += " is not a valid manifest file.";
         LoaderLogger::LogErrorMessage("", error_message);
-        return;
+        return false;
     }
-    runtime_root_node = root_node["runtime"];
+    const Json::Value &runtime_root_node = root_node["runtime"];
     // The Runtime manifest file needs the "runtime" root as well as sub-nodes for "api_version" and
     // "library_path".  If any of those aren't there, fail.
     if (runtime_root_node.isNull() || runtime_root_node["library_path"].isNull() || !runtime_root_node["library_path"].isString()) {
@@ -558,88 +588,52 @@ void RuntimeManifestFile::CreateIfValid(const std::string &filename,
         error_message += filename;
         error_message += " is missing required fields.  Verify all proper fields exist.";
         LoaderLogger::LogErrorMessage("", error_message);
-        return;
-    }
-
-    std::string lib_path = runtime_root_node["library_path"].asString();
-
-    // If the library_path variable has no directory symbol, it's just a file name and should be accessible on the
-    // global library path.
-    if (lib_path.find('\\') != std::string::npos || lib_path.find('/') != std::string::npos) {
-        // If the library_path is an absolute path, just use that if it exists
-        if (FileSysUtilsIsAbsolutePath(lib_path)) {
-            if (!FileSysUtilsPathExists(lib_path)) {
-                std::string error_message = "RuntimeManifestFile::CreateIfValid ";
-                error_message += filename;
-                error_message += " library ";
-                error_message += lib_path;
-                error_message += " does not appear to exist";
-                LoaderLogger::LogErrorMessage("", error_message);
-                return;
-            }
-        } else {
-            // Otherwise, treat the library path as a relative path based on the JSON file.
-            std::string combined_path;
-            std::string file_parent;
-            if (!FileSysUtilsGetParentPath(filename, file_parent) ||
-                !FileSysUtilsCombinePaths(file_parent, lib_path, combined_path) || !FileSysUtilsPathExists(combined_path)) {
-                std::string error_message = "RuntimeManifestFile::CreateIfValid ";
-                error_message += filename;
-                error_message += " library ";
-                error_message += combined_path;
-                error_message += " does not appear to exist";
-                LoaderLogger::LogErrorMessage("", error_message);
-                return;
-            }
-            lib_path = combined_path;
-        }
+        return false;
     }
 
-    // Add this runtime manifest file
-    manifest_files.emplace_back(new RuntimeManifestFile(filename, lib_path));
+    record.library_path = runtime_root_node["library_path"].asString();
 
-    // Add any extensions to it after the fact.
-    Json::Value dev_exts = runtime_root_node["device_extensions"];
+    const Json::Value &dev_exts = runtime_root_node["device_extensions"];
     if (!dev_exts.isNull() && dev_exts.isArray()) {
-        for (Json::ValueIterator dev_ext_it = dev_exts.begin(); dev_ext_it != dev_exts.end(); ++dev_ext_it) {
-            Json::Value dev_ext = (*dev_ext_it);
-            Json::Value dev_ext_name = dev_ext["name"];
-            Json::Value dev_ext_version = dev_ext["extension_version"];
-            Json::Value dev_ext_entries = dev_ext["entrypoints"];
+        for (Json::ValueConstIterator dev_ext_it = dev_exts.begin(); dev_ext_it != dev_exts.end(); ++dev_ext_it) {
+            const Json::Value &dev_ext = *dev_ext_it;
+            const Json::Value &dev_ext_name = dev_ext["name"];
+            const Json::Value &dev_ext_version = dev_ext["extension_version"];
+            const Json::Value &dev_ext_entries = dev_ext["entrypoints"];
             if (!dev_ext_name.isNull() && dev_ext_name.isString() && !dev_ext_version.isNull() && dev_ext_version.isUInt() &&
                 !dev_ext_entries.isNull() && dev_ext_entries.isArray()) {
                 ExtensionListing ext = {};
                 ext.name = dev_ext_name.asString();
                 ext.extension_version = dev_ext_version.asUInt();
-                for (Json::ValueIterator entry_it = dev_ext_entries.begin(); entry_it != dev_ext_entries.end(); ++entry_it) {
-                    Json::Value entry = (*entry_it);
+                for (Json::ValueConstIterator entry_it = dev_ext_entries.begin(); entry_it != dev_ext_entries.end(); ++entry_it) {
+                    const Json::Value &entry = *entry_it;
                     if (!entry.isNull() && entry.isString()) {
                         ext.entrypoints.push_back(entry.asString());
                     }
                 }
-                manifest_files.back()->_device_extensions.push_back(ext);
+                record.device_extensions.push_back(ext);
             }
         }
     }
 
-    Json::Value inst_exts = runtime_root_node["instance_extensions"];
+    const Json::Value &inst_exts = runtime_root_node["instance_extensions"];
     if (!inst_exts.isNull() && inst_exts.isArray()) {
-        for (Json::ValueIterator inst_ext_it = inst_exts.begin(); inst_ext_it != inst_exts.end(); ++inst_ext_it) {
-            Json::Value inst_ext = (*inst_ext_it);
-            Json::Value inst_ext_name = inst_ext["name"];
-            Json::Value inst_ext_version = inst_ext["extension_version"];
+        for (Json::ValueConstIterator inst_ext_it = inst_exts.begin(); inst_ext_it != inst_exts.end(); ++inst_ext_it) {
+            const Json::Value &inst_ext = *inst_ext_it;
+            const Json::Value &inst_ext_name = inst_ext["name"];
+            const Json::Value &inst_ext_version = inst_ext["extension_version"];
             if (!inst_ext_name.isNull() && inst_ext_name.isString() && !inst_ext_version.isNull() && inst_ext_version.isUInt()) {
                 ExtensionListing ext = {};
                 ext.name = inst_ext_name.asString();
                 ext.extension_version = inst_ext_version.asUInt();
-                manifest_files.back()->_instance_extensions.push_back(ext);
+                record.instance_extensions.push_back(ext);
             }
         }
     }
 
-    Json::Value funcs_renamed = runtime_root_node["functions"];
+    const Json::Value &funcs_renamed = runtime_root_node["functions"];
     if (!funcs_renamed.isNull() && !funcs_renamed.empty()) {
-        for (Json::ValueIterator func_it = funcs_renamed.begin(); func_it != funcs_renamed.end(); ++func_it) {
+        for (Json::ValueConstIterator func_it = funcs_renamed.begin(); func_it != funcs_renamed.end(); ++func_it) {
             if (!(*func_it).isString()) {
                 std::string warning_message = "RuntimeManifestFile::CreateIfValid ";
                 warning_message += filename;
@@ -649,29 +643,83 @@ void RuntimeManifestFile::CreateIfValid(const std::string &filename,
             }
             std::string original_name = func_it.key().asString();
             std::string new_name = (*func_it).asString();
-            manifest_files.back()->_functions_renamed.insert(std::make_pair(original_name, new_name));
+            record.functions_renamed.push_back(std::make_pair(original_name, new_name));
         }
     }
+    return true;
+}
+
+void RuntimeManifestFile::CreateIfValid(const std::string &filename,
+                                        std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
+    // Only parse the file if it has changed since it was last cached.
+    FileSysUtilsFileStamp stamp = {};
+    bool have_stamp = FileSysUtilsGetFileStamp(filename, stamp);
+    ManifestRecord record = {};
+    if (!have_stamp || !ManifestFileCache::Find(filename, MANIFEST_TYPE_RUNTIME, stamp, record)) {
+        if (!ParseRuntimeManifest(filename, record)) {
+            return;
+        }
+        if (have_stamp) {
+            ManifestFileCache::Add(filename, MANIFEST_TYPE_RUNTIME, stamp, record);
+        }
+    }
+
+    std::string lib_path = record.library_path;
+
+    // If the library_path variable has no directory symbol, it's just a file name and should be accessible on the
+    // global library path.
+    if (lib_path.find('\\') != std::string::npos || lib_path.find('/') != std::string::npos) {
+        // If the library_path is an absolute path, just use that if it exists
+        if (FileSysUtilsIsAbsolutePath(lib_path)) {
+            if (!FileSysUtilsPathExists(lib_path)) {
+                std::string error_message = "RuntimeManifestFile::CreateIfValid ";
+                error_message += filename;
+                error_message += " library ";
+                error_message += lib_path;
+                error_message += " does not appear to exist";
+                LoaderLogger::LogErrorMessage("", error_message);
+                return;
+            }
+        } else {
+            // Otherwise, treat the library path as a relative path based on the JSON file.
+            std::string combined_path;
+            std::string file_parent;
+            if (!FileSysUtilsGetParentPath(filename, file_parent) ||
+                !FileSysUtilsCombinePaths(file_parent, lib_path, combined_path) || !FileSysUtilsPathExists(combined_path)) {
+                std::string error_message = "RuntimeManifestFile::CreateIfValid ";
+                error_message += filename;
+                error_message += " library ";
+                error_message += combined_path;
+                error_message += " does not appear to exist";
+                LoaderLogger::LogErrorMessage("", error_message);
+                return;
+            }
+            lib_path = combined_path;
+        }
+    }
+
+    // Add this runtime manifest file
+    manifest_files.emplace_back(new RuntimeManifestFile(filename, lib_path));
+    manifest_files.back()->AddRecordContents(record);
 }
 
 // Find all manifest files in the appropriate search paths/registries for the given type.
 XrResult RuntimeManifestFile::FindManifestFiles(ManifestFileType type,
                                                 std::vector<std::unique_ptr<RuntimeManifestFile>> &manifest_files) {
+    LoaderTraceScope trace("RuntimeManifestFile::FindManifestFiles");
     XrResult result = XR_SUCCESS;
     if (MANIFEST_TYPE_RUNTIME != type) {
         LoaderLogger::LogErrorMessage("", "RuntimeManifestFile::FindManifestFiles - unknown manifest file requested");
         return XR_ERROR_FILE_ACCESS_ERROR;
     }
     std::string filename;
-    char *override_path = PlatformUtilsGetSecureEnv(OPENXR_RUNTIME_JSON_ENV_VAR);
-    if (override_path != nullptr && *override_path != '\0') {
-        filename = override_path;
-        PlatformUtilsFreeEnv(override_path);
-        std::string info_message = "RuntimeManifestFile::FindManifestFiles - using environment variable override runtime file ";
-        info_message += filename;
-        LoaderLogger::LogInfoMessage("", info_message);
+    if (LoaderGetSecureEnv(OPENXR_RUNTIME_JSON_ENV_VAR, filename) && !filename.empty()) {
+        if (LoaderLogger::IsInfoEnabled()) {
+            std::string info_message = "RuntimeManifestFile::FindManifestFiles - using environment variable override runtime file ";
+            info_message += filename;
+            LoaderLogger::LogInfoMessage("", info_message);
+        }
     } else {
-        PlatformUtilsFreeEnv(override_path);
 #ifdef XR_OS_WINDOWS
         std::vector<std::string> filenames;
         ReadRuntimeDataFilesInRegistry(type, "", "ActiveRuntime", filenames);
@@ -700,11 +748,14 @@ XrResult RuntimeManifestFile::FindManifestFiles(ManifestFileType type,
             return XR_ERROR_FILE_ACCESS_ERROR;
         }
 #endif
-        std::string info_message = "RuntimeManifestFile::FindManifestFiles - using global runtime file ";
-        info_message += filename;
-        LoaderLogger::LogInfoMessage("", info_message);
+        if (LoaderLogger::IsInfoEnabled()) {
+            std::string info_message = "RuntimeManifestFile::FindManifestFiles - using global runtime file ";
+            info_message += filename;
+            LoaderLogger::LogInfoMessage("", info_message);
+        }
     }
     RuntimeManifestFile::CreateIfValid(filename, manifest_files);
+    ManifestFileCache::Save();
     return result;
 }
 
@@ -719,18 +770,25 @@ ApiLayerManifestFile::ApiLayerManifestFile(ManifestFileType type, const std::str
 
 ApiLayerManifestFile::~ApiLayerManifestFile() = default;
 
-void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::string &filename,
-                                         std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
-    std::ifstream json_stream(filename, std::ifstream::in);
-    Json::Reader reader;
-    Json::Value root_node = Json::nullValue;
-    if (!reader.parse(json_stream, root_node, false) || root_node.isNull()) {
+// Read and validate an API layer manifest file, keeping what the loader needs from it in record.
+static bool ParseApiLayerManifest(ManifestFileType type, const std::string &filename, ManifestRecord &record) {
+    LoaderTraceScope trace("Parse API layer manifest", filename);
+    std::string contents;
+    bool have_contents = ReadManifestContents(filename, contents);
+    // Well-formed manifests can be read without building a Json::Value tree.  jsoncpp handles the rest, and reports
+    // what is wrong with them.
+    if (have_contents && ReadApiLayerManifestRecord(type, contents, record)) {
+        return true;
+    }
+    Json::Value root_node;
+    std::string parse_errors;
+    if (!have_contents || !ParseManifestJson(contents, root_node, parse_errors)) {
         std::string error_message = "ApiLayerManifestFile::CreateIfValid failed to parse ";
         error_message += filename;
         error_message += ".  Is it a valid layer manifest file? Error was:\n";
-        error_message += reader.getFormattedErrorMessages();
+        error_message += parse_errors;
         LoaderLogger::LogErrorMessage("", error_message);
-        return;
+        return false;
     }
     JsonVersion file_version = {};
     if (!ManifestFile::IsValidJson(root_node, file_version)) {
@@ -738,10 +796,10 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
         error_message += filename;
         error_message += " is not a valid manifest file.";
         LoaderLogger::LogErrorMessage("", error_message);
-        return;
+        return false;
     }
 
-    Json::Value layer_root_node = root_node["api_layer"];
+    const Json::Value &layer_root_node = root_node["api_layer"];
 
     // The API Layer manifest file needs the "api_layer" root as well as other sub-nodes.
     // If any of those aren't there, fail.
@@ -753,50 +811,200 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
         error_message += filename;
         error_message += " is missing required fields.  Verify all proper fields exist.";
         LoaderLogger::LogErrorMessage("", error_message);
+        return false;
+    }
+    // Implicit layers require the disable environment variable.
+    if (MANIFEST_TYPE_IMPLICIT_API_LAYER == type &&
+        (layer_root_node["disable_environment"].isNull() || !layer_root_node["disable_environment"].isString())) {
+        std::string error_message = "ApiLayerManifestFile::CreateIfValid Implicit layer ";
+        error_message += filename;
+        error_message += " is missing \"disable_environment\"";
+        LoaderLogger::LogErrorMessage("", error_message);
+        return false;
+    }
+    record.has_enable_environment =
+        !layer_root_node["enable_environment"].isNull() && layer_root_node["enable_environment"].isString();
+    if (record.has_enable_environment) {
+        record.enable_environment = layer_root_node["enable_environment"].asString();
+    }
+    record.has_disable_environment =
+        !layer_root_node["disable_environment"].isNull() && layer_root_node["disable_environment"].isString();
+    if (record.has_disable_environment) {
+        record.disable_environment = layer_root_node["disable_environment"].asString();
+    }
+
+    record.layer_name = layer_root_node["name"].asString();
+    std::string api_version_string = layer_root_node["api_version"].asString();
+    sscanf(api_version_string.c_str(), "%d.%d", &record.api_version.major, &record.api_version.minor);
+    record.api_version.patch = 0;
+    record.implementation_version = atoi(layer_root_node["implementation_version"].asString().c_str());
+    record.library_path = layer_root_node["library_path"].asString();
+    if (!layer_root_node["description"].isNull() && layer_root_node["description"].isString()) {
+        record.description = layer_root_node["description"].asString();
+    }
+
+    const Json::Value &dev_exts = layer_root_node["device_extensions"];
+    if (!dev_exts.isNull() && dev_exts.isArray()) {
+        for (Json::ValueConstIterator dev_ext_it = dev_exts.begin(); dev_ext_it != dev_exts.end(); ++dev_ext_it) {
+            const Json::Value &dev_ext = *dev_ext_it;
+            const Json::Value &dev_ext_name = dev_ext["name"];
+            const Json::Value &dev_ext_version = dev_ext["extension_version"];
+            const Json::Value &dev_ext_entries = dev_ext["entrypoints"];
+            if (!dev_ext_name.isNull() && dev_ext_name.isString() && !dev_ext_version.isNull() && dev_ext_version.isString() &&
+                !dev_ext_entries.isNull() && dev_ext_entries.isArray()) {
+                ExtensionListing ext = {};
+                ext.name = dev_ext_name.asString();
+                ext.extension_version = atoi(dev_ext_version.asString().c_str());
+                for (Json::ValueConstIterator entry_it = dev_ext_entries.begin(); entry_it != dev_ext_entries.end(); ++entry_it) {
+                    const Json::Value &entry = *entry_it;
+                    if (!entry.isNull() && entry.isString()) {
+                        ext.entrypoints.push_back(entry.asString());
+                    }
+                }
+                record.device_extensions.push_back(ext);
+            }
+        }
+    }
+
+    const Json::Value &inst_exts = layer_root_node["instance_extensions"];
+    if (!inst_exts.isNull() && inst_exts.isArray()) {
+        for (Json::ValueConstIterator inst_ext_it = inst_exts.begin(); inst_ext_it != inst_exts.end(); ++inst_ext_it) {
+            const Json::Value &inst_ext = *inst_ext_it;
+            const Json::Value &inst_ext_name = inst_ext["name"];
+            const Json::Value &inst_ext_version = inst_ext["extension_version"];
+            if (!inst_ext_name.isNull() && inst_ext_name.isString() && !inst_ext_version.isNull() && inst_ext_version.isString()) {
+                ExtensionListing ext = {};
+                ext.name = inst_ext_name.asString();
+                ext.extension_version = atoi(inst_ext_version.asString().c_str());
+                record.instance_extensions.push_back(ext);
+            }
+        }
+    }
+
+    const Json::Value &funcs_renamed = layer_root_node["functions"];
+    if (!funcs_renamed.isNull() && !funcs_renamed.empty()) {
+        for (Json::ValueConstIterator func_it = funcs_renamed.begin(); func_it != funcs_renamed.end(); ++func_it) {
+            if (!(*func_it).isString()) {
+                std::string warning_message = "ApiLayerManifestFile::CreateIfValid ";
+                warning_message += filename;
+                warning_message += " \"functions\" section contains non-string values.";
+                LoaderLogger::LogWarningMessage("", warning_message);
+                continue;
+            }
+            std::string original_name = func_it.key().asString();
+            std::string new_name = (*func_it).asString();
+            record.functions_renamed.push_back(std::make_pair(original_name, new_name));
+        }
+    }
+    return true;
+}
+
+// An API layer manifest file on its way from a file name to an ApiLayerManifestFile.
+struct PendingApiLayerManifest {
+    std::string filename;
+    bool have_stamp;
+    FileSysUtilsFileStamp stamp;
+    bool have_record;
+    ManifestRecord record;
+};
+
+// Fill in the record from the cache, if the file has not changed since it was cached.
+static void FindCachedApiLayerManifest(ManifestFileType type, PendingApiLayerManifest &pending) {
+    pending.have_stamp = FileSysUtilsGetFileStamp(pending.filename, pending.stamp);
+    pending.have_record = pending.have_stamp && ManifestFileCache::Find(pending.filename, type, pending.stamp, pending.record);
+}
+
+// Parse the file into the record, and cache it for next time.
+static void ParsePendingApiLayerManifest(ManifestFileType type, PendingApiLayerManifest &pending) {
+    pending.have_record = ParseApiLayerManifest(type, pending.filename, pending.record);
+    if (pending.have_record && pending.have_stamp) {
+        ManifestFileCache::Add(pending.filename, type, pending.stamp, pending.record);
+    }
+}
+
+// The most threads used to parse API layer manifest files at once, counting the calling thread.  Parsing a manifest is
+// quick; what takes the time when there are many of them, particularly on network file systems, is waiting for each
+// file to be opened and read, so a few threads are enough.
+static const size_t kMaxManifestParseThreads = 4;
+
+// Parse every manifest that was not found in the cache.  When there is more than one, they are parsed on several
+// threads at once, each taking the next unparsed file in turn.  Each result stays in its own PendingApiLayerManifest,
+// so the order the files are used in does not depend on which thread finished first.
+static void ParsePendingApiLayerManifests(ManifestFileType type, std::vector<PendingApiLayerManifest> &pending) {
+    std::vector<PendingApiLayerManifest *> unparsed;
+    for (PendingApiLayerManifest &manifest : pending) {
+        if (!manifest.have_record) {
+            unparsed.push_back(&manifest);
+        }
+    }
+    if (unparsed.size() < 2) {
+        for (PendingApiLayerManifest *manifest : unparsed) {
+            ParsePendingApiLayerManifest(type, *manifest);
+        }
         return;
     }
+
+    std::atomic<size_t> next_manifest{0};
+    auto parse_manifests = [&]() {
+        for (size_t index = next_manifest++; index < unparsed.size(); index = next_manifest++) {
+            ParsePendingApiLayerManifest(type, *unparsed[index]);
+        }
+    };
+    std::vector<std::thread> threads;
+    const size_t thread_count = std::min(unparsed.size(), kMaxManifestParseThreads);
+    for (size_t thread = 1; thread < thread_count; ++thread) {
+        threads.emplace_back(parse_manifests);
+    }
+    parse_manifests();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::string &filename,
+                                         std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
+    // Only parse the file if it has changed since it was last cached.
+    PendingApiLayerManifest pending = {};
+    pending.filename = filename;
+    FindCachedApiLayerManifest(type, pending);
+    if (!pending.have_record) {
+        ParsePendingApiLayerManifest(type, pending);
+    }
+    if (pending.have_record) {
+        CreateFromRecord(type, filename, pending.record, manifest_files);
+    }
+}
+
+void ApiLayerManifestFile::CreateFromRecord(ManifestFileType type, const std::string &filename, const ManifestRecord &record,
+                                            std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
     if (MANIFEST_TYPE_IMPLICIT_API_LAYER == type) {
         bool enabled = true;
-        // Implicit layers require the disable environment variable.
-        if (layer_root_node["disable_environment"].isNull() || !layer_root_node["disable_environment"].isString()) {
-            std::string error_message = "ApiLayerManifestFile::CreateIfValid Implicit layer ";
-            error_message += filename;
-            error_message += " is missing \"disable_environment\"";
-            LoaderLogger::LogErrorMessage("", error_message);
-            return;
-        }
         // Check if there's an enable environment variable provided
-        if (!layer_root_node["enable_environment"].isNull() && layer_root_node["enable_environment"].isString()) {
-            char *enable_val = PlatformUtilsGetEnv(layer_root_node["enable_environment"].asString().c_str());
+        std::string env_value;
+        if (record.has_enable_environment) {
             // If it's not set in the environment, disable the layer
-            if (nullptr == enable_val) {
+            if (!LoaderGetEnv(record.enable_environment.c_str(), env_value)) {
                 enabled = false;
             }
-            PlatformUtilsFreeEnv(enable_val);
         }
         // Check for the disable environment variable, which must be provided in the JSON
-        char *disable_val = PlatformUtilsGetEnv(layer_root_node["disable_environment"].asString().c_str());
         // If the envar is set, disable the layer. Disable envar overrides enable above
-        if (nullptr != disable_val) {
+        if (LoaderGetEnv(record.disable_environment.c_str(), env_value)) {
             enabled = false;
         }
-        PlatformUtilsFreeEnv(disable_val);
 
         // Not enabled, so pretend like it isn't even there.
         if (!enabled) {
-            std::string info_message = "ApiLayerManifestFile::CreateIfValid Implicit layer ";
-            info_message += filename;
-            info_message += " is disabled";
-            LoaderLogger::LogInfoMessage("", info_message);
+            if (LoaderLogger::IsInfoEnabled()) {
+                std::string info_message = "ApiLayerManifestFile::CreateIfValid Implicit layer ";
+                info_message += filename;
+                info_message += " is disabled";
+                LoaderLogger::LogInfoMessage("", info_message);
+            }
             return;
         }
     }
-    std::string layer_name = layer_root_node["name"].asString();
-    std::string api_version_string = layer_root_node["api_version"].asString();
-    JsonVersion api_version = {};
-    sscanf(api_version_string.c_str(), "%d.%d", &api_version.major, &api_version.minor);
-    api_version.patch = 0;
-
+    const JsonVersion &api_version = record.api_version;
     if ((api_version.major == 0 && api_version.minor == 0) || api_version.major > XR_VERSION_MAJOR(XR_CURRENT_API_VERSION)) {
         std::string warning_message = "ApiLayerManifestFile::CreateIfValid layer ";
         warning_message += filename;
@@ -805,8 +1013,7 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
         return;
     }
 
-    uint32_t implementation_version = atoi(layer_root_node["implementation_version"].asString().c_str());
-    std::string library_path = layer_root_node["library_path"].asString();
+    std::string library_path = record.library_path;
 
     // If the library_path variable has no directory symbol, it's just a file name and should be accessible on the
     // global library path.
@@ -840,69 +1047,10 @@ void ApiLayerManifestFile::CreateIfValid(ManifestFileType type, const std::strin
         }
     }
 
-    std::string description;
-    if (!layer_root_node["description"].isNull() && layer_root_node["description"].isString()) {
-        description = layer_root_node["description"].asString();
-    }
-
     // Add this layer manifest file
-    manifest_files.emplace_back(
-        new ApiLayerManifestFile(type, filename, layer_name, description, api_version, implementation_version, library_path));
-
-    // Add any extensions to it after the fact.
-    Json::Value dev_exts = layer_root_node["device_extensions"];
-    if (!dev_exts.isNull() && dev_exts.isArray()) {
-        for (Json::ValueIterator dev_ext_it = dev_exts.begin(); dev_ext_it != dev_exts.end(); ++dev_ext_it) {
-            Json::Value dev_ext = (*dev_ext_it);
-            Json::Value dev_ext_name = dev_ext["name"];
-            Json::Value dev_ext_version = dev_ext["extension_version"];
-            Json::Value dev_ext_entries = dev_ext["entrypoints"];
-            if (!dev_ext_name.isNull() && dev_ext_name.isString() && !dev_ext_version.isNull() && dev_ext_version.isString() &&
-                !dev_ext_entries.isNull() && dev_ext_entries.isArray()) {
-                ExtensionListing ext = {};
-                ext.name = dev_ext_name.asString();
-                ext.extension_version = atoi(dev_ext_version.asString().c_str());
-                for (Json::ValueIterator entry_it = dev_ext_entries.begin(); entry_it != dev_ext_entries.end(); ++entry_it) {
-                    Json::Value entry = (*entry_it);
-                    if (!entry.isNull() && entry.isString()) {
-                        ext.entrypoints.push_back(entry.asString());
-                    }
-                }
-                manifest_files.back()->_device_extensions.push_back(ext);
-            }
-        }
-    }
-
-    Json::Value inst_exts = layer_root_node["instance_extensions"];
-    if (!inst_exts.isNull() && inst_exts.isArray()) {
-        for (Json::ValueIterator inst_ext_it = inst_exts.begin(); inst_ext_it != inst_exts.end(); ++inst_ext_it) {
-            Json::Value inst_ext = (*inst_ext_it);
-            Json::Value inst_ext_name = inst_ext["name"];
-            Json::Value inst_ext_version = inst_ext["extension_version"];
-            if (!inst_ext_name.isNull() && inst_ext_name.isString() && !inst_ext_version.isNull() && inst_ext_version.isString()) {
-                ExtensionListing ext = {};
-                ext.name = inst_ext_name.asString();
-                ext.extension_version = atoi(inst_ext_version.asString().c_str());
-                manifest_files.back()->_instance_extensions.push_back(ext);
-            }
-        }
-    }
-
-    Json::Value funcs_renamed = layer_root_node["functions"];
-    if (!funcs_renamed.isNull() && !funcs_renamed.empty()) {
-        for (Json::ValueIterator func_it = funcs_renamed.begin(); func_it != funcs_renamed.end(); ++func_it) {
-            if (!(*func_it).isString()) {
-                std::string warning_message = "ApiLayerManifestFile::CreateIfValid ";
-                warning_message += filename;
-                warning_message += " \"functions\" section contains non-string values.";
-                LoaderLogger::LogWarningMessage("", warning_message);
-                continue;
-            }
-            std::string original_name = func_it.key().asString();
-            std::string new_name = (*func_it).asString();
-            manifest_files.back()->_functions_renamed.insert(std::make_pair(original_name, new_name));
-        }
-    }
+    manifest_files.emplace_back(new ApiLayerManifestFile(type, filename, record.layer_name, record.description, api_version,
+                                                         record.implementation_version, library_path));
+    manifest_files.back()->AddRecordContents(record);
 }
 
 XrApiLayerProperties ApiLayerManifestFile::GetApiLayerProperties() {
@@ -925,6 +1073,7 @@ XrApiLayerProperties ApiLayerManifestFile::GetApiLayerProperties() {
 // Find all layer manifest files in the appropriate search paths/registries for the given type.
 XrResult ApiLayerManifestFile::FindManifestFiles(ManifestFileType type,
                                                  std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files) {
+    LoaderTraceScope trace("ApiLayerManifestFile::FindManifestFiles");
     std::string relative_path;
     std::string override_env_var;
     std::string registry_location;
@@ -967,11 +1116,21 @@ XrResult ApiLayerManifestFile::FindManifestFiles(ManifestFileType type,
 
     switch (type) {
         case MANIFEST_TYPE_IMPLICIT_API_LAYER:
-        case MANIFEST_TYPE_EXPLICIT_API_LAYER:
-            for (std::string &cur_file : filenames) {
-                ApiLayerManifestFile::CreateIfValid(type, cur_file, manifest_files);
+        case MANIFEST_TYPE_EXPLICIT_API_LAYER: {
+            std::vector<PendingApiLayerManifest> pending(filenames.size());
+            for (size_t index = 0; index < filenames.size(); ++index) {
+                pending[index].filename = filenames[index];
+                FindCachedApiLayerManifest(type, pending[index]);
+            }
+            ParsePendingApiLayerManifests(type, pending);
+            for (PendingApiLayerManifest &manifest : pending) {
+                if (manifest.have_record) {
+                    ApiLayerManifestFile::CreateFromRecord(type, manifest.filename, manifest.record, manifest_files);
+                }
             }
+            ManifestFileCache::Save();
             break;
+        }
         default:
             break;
     }
@@ -30,6 +30,8 @@ namespace Json {
 class Value;
 }
 
+struct ManifestRecord;
+
 enum ManifestFileType {
     MANIFEST_TYPE_UNDEFINED = 0,
     MANIFEST_TYPE_RUNTIME,
@@ -68,6 +70,9 @@ class ManifestFile {
     const std::string &GetFunctionName(const std::string &func_name);
 
    protected:
+    // Fill in the extensions and renamed functions a manifest file lists.
+    void AddRecordContents(const ManifestRecord &record);
+
     std::string _filename;
     ManifestFileType _type;
     std::string _library_path;
@@ -114,6 +119,9 @@ class ApiLayerManifestFile : public ManifestFile {
     ApiLayerManifestFile &operator=(const ApiLayerManifestFile &) = delete;
 
    private:
+    static void CreateFromRecord(ManifestFileType type, const std::string &filename, const ManifestRecord &record,
+                                 std::vector<std::unique_ptr<ApiLayerManifestFile>> &manifest_files);
+
     JsonVersion _api_version;
     std::string _layer_name;
     std::string _description;
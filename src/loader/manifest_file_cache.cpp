@@ -0,0 +1,459 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "manifest_file_cache.hpp"
+
+#include "filesystem_utils.hpp"
+#include "loader_logger.hpp"
+#include "platform_utils.hpp"
+
+#include <openxr/openxr.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef XR_OS_LINUX
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define OPENXR_DISABLE_MANIFEST_CACHE_ENV_VAR "XR_LOADER_DISABLE_MANIFEST_CACHE"
+
+namespace {
+
+// Bump whenever the layout below changes: a file with any other version is ignored and rewritten.
+const uint32_t kCacheFileMagic = 0x43464d58;  // "XMFC"
+const uint32_t kCacheFileVersion = 1;
+
+struct CacheEntry {
+    FileSysUtilsFileStamp stamp;
+    ManifestRecord record;
+};
+
+typedef std::map<std::pair<uint32_t, std::string>, CacheEntry> CacheEntryMap;
+
+struct DirectoryEntry {
+    FileSysUtilsFileStamp stamp;
+    std::vector<std::string> manifest_files;
+};
+
+std::mutex g_cache_mutex;
+// Held while writing the cache file, so that two threads saving at once do not share a temporary file.
+std::mutex g_save_mutex;
+CacheEntryMap g_cache_entries;
+bool g_cache_loaded = false;
+bool g_cache_dirty = false;
+// Never written to disk: listing a directory is cheap next to starting a process.
+std::unordered_map<std::string, DirectoryEntry> g_directory_entries;
+
+bool CacheIsDisabled() {
+    char *disable = PlatformUtilsGetSecureEnv(OPENXR_DISABLE_MANIFEST_CACHE_ENV_VAR);
+    bool disabled = (nullptr != disable && std::string(disable) != "0");
+    PlatformUtilsFreeEnv(disable);
+    return disabled;
+}
+
+bool StampsMatch(const FileSysUtilsFileStamp &lhs, const FileSysUtilsFileStamp &rhs) {
+    return lhs.modified_time == rhs.modified_time && lhs.size == rhs.size;
+}
+
+// All values are written little-endian, one byte at a time, so the file does not depend on the layout of any structure.
+class CacheWriter {
+   public:
+    void U32(uint32_t value) {
+        for (int byte = 0; byte < 4; ++byte) {
+            _data.push_back(static_cast<char>((value >> (byte * 8)) & 0xff));
+        }
+    }
+    void U64(uint64_t value) {
+        U32(static_cast<uint32_t>(value & 0xffffffff));
+        U32(static_cast<uint32_t>(value >> 32));
+    }
+    void Flag(bool value) { U32(value ? 1 : 0); }
+    void String(const std::string &value) {
+        U32(static_cast<uint32_t>(value.size()));
+        _data += value;
+    }
+    void Extensions(const std::vector<ExtensionListing> &extensions) {
+        U32(static_cast<uint32_t>(extensions.size()));
+        for (const ExtensionListing &extension : extensions) {
+            String(extension.name);
+            U32(extension.extension_version);
+            U32(static_cast<uint32_t>(extension.entrypoints.size()));
+            for (const std::string &entrypoint : extension.entrypoints) {
+                String(entrypoint);
+            }
+        }
+    }
+    const std::string &Data() const { return _data; }
+
+   private:
+    std::string _data;
+};
+
+// Reads what CacheWriter wrote.  Any read past the end of the data, or of a count that could not possibly fit in what is
+// left, fails this read and every one after it, so a truncated or corrupt file can not cause a huge allocation.
+class CacheReader {
+   public:
+    explicit CacheReader(const std::string &data) : _data(data), _offset(0), _ok(true) {}
+
+    bool Ok() const { return _ok; }
+    bool AtEnd() const { return _offset == _data.size(); }
+
+    uint32_t U32() {
+        if (!Require(4)) {
+            return 0;
+        }
+        uint32_t value = 0;
+        for (int byte = 0; byte < 4; ++byte) {
+            value |= static_cast<uint32_t>(static_cast<unsigned char>(_data[_offset++])) << (byte * 8);
+        }
+        return value;
+    }
+    uint64_t U64() {
+        uint64_t low = U32();
+        uint64_t high = U32();
+        return low | (high << 32);
+    }
+    bool Flag() { return U32() != 0; }
+    std::string String() {
+        uint32_t size = U32();
+        if (!Require(size)) {
+            return std::string();
+        }
+        std::string value = _data.substr(_offset, size);
+        _offset += size;
+        return value;
+    }
+    // Read an element count, each element taking at least 4 bytes.
+    uint32_t Count() {
+        uint32_t count = U32();
+        if (_ok && count > (_data.size() - _offset) / 4) {
+            _ok = false;
+        }
+        return _ok ? count : 0;
+    }
+    std::vector<ExtensionListing> Extensions() {
+        std::vector<ExtensionListing> extensions(Count());
+        for (ExtensionListing &extension : extensions) {
+            extension.name = String();
+            extension.extension_version = U32();
+            extension.entrypoints.resize(Count());
+            for (std::string &entrypoint : extension.entrypoints) {
+                entrypoint = String();
+            }
+        }
+        return extensions;
+    }
+
+   private:
+    bool Require(uint64_t size) {
+        if (_ok && size > _data.size() - _offset) {
+            _ok = false;
+        }
+        return _ok;
+    }
+
+    const std::string &_data;
+    size_t _offset;
+    bool _ok;
+};
+
+void WriteEntry(CacheWriter &writer, const std::pair<uint32_t, std::string> &key, const CacheEntry &entry) {
+    writer.U32(key.first);
+    writer.String(key.second);
+    writer.U64(static_cast<uint64_t>(entry.stamp.modified_time));
+    writer.U64(entry.stamp.size);
+
+    const ManifestRecord &record = entry.record;
+    writer.String(record.library_path);
+    writer.Extensions(record.instance_extensions);
+    writer.Extensions(record.device_extensions);
+    writer.U32(static_cast<uint32_t>(record.functions_renamed.size()));
+    for (const auto &function : record.functions_renamed) {
+        writer.String(function.first);
+        writer.String(function.second);
+    }
+    writer.String(record.layer_name);
+    writer.String(record.description);
+    writer.U32(record.api_version.major);
+    writer.U32(record.api_version.minor);
+    writer.U32(record.api_version.patch);
+    writer.U32(record.implementation_version);
+    writer.Flag(record.has_enable_environment);
+    writer.String(record.enable_environment);
+    writer.Flag(record.has_disable_environment);
+    writer.String(record.disable_environment);
+}
+
+bool ReadEntry(CacheReader &reader, CacheEntryMap &entries) {
+    std::pair<uint32_t, std::string> key;
+    key.first = reader.U32();
+    key.second = reader.String();
+
+    CacheEntry entry = {};
+    entry.stamp.modified_time = static_cast<int64_t>(reader.U64());
+    entry.stamp.size = reader.U64();
+
+    ManifestRecord &record = entry.record;
+    record.library_path = reader.String();
+    record.instance_extensions = reader.Extensions();
+    record.device_extensions = reader.Extensions();
+    record.functions_renamed.resize(reader.Count());
+    for (auto &function : record.functions_renamed) {
+        function.first = reader.String();
+        function.second = reader.String();
+    }
+    record.layer_name = reader.String();
+    record.description = reader.String();
+    record.api_version.major = reader.U32();
+    record.api_version.minor = reader.U32();
+    record.api_version.patch = reader.U32();
+    record.implementation_version = reader.U32();
+    record.has_enable_environment = reader.Flag();
+    record.enable_environment = reader.String();
+    record.has_disable_environment = reader.Flag();
+    record.disable_environment = reader.String();
+
+    if (!reader.Ok()) {
+        return false;
+    }
+    entries[key] = std::move(entry);
+    return true;
+}
+
+#ifdef XR_OS_LINUX
+
+// The cache file is only as trustworthy as the user who can write it.  A setuid or setgid process never reads or writes
+// it, and only manifest files owned by the user are kept in it: a record for a system manifest could otherwise be edited
+// to load a different library than the one the manifest names.  System manifests are still cached within the process.
+bool DiskCacheIsAllowed() { return geteuid() == getuid() && getegid() == getgid(); }
+
+bool OwnedByUser(const std::string &path, bool allow_other_writers) {
+    struct stat path_stat;
+    if (0 != stat(path.c_str(), &path_stat) || path_stat.st_uid != geteuid()) {
+        return false;
+    }
+    return allow_other_writers || 0 == (path_stat.st_mode & (S_IWGRP | S_IWOTH));
+}
+
+// The cache file lives at ${XDG_CACHE_HOME:-$HOME/.cache}/openxr/<major version>/manifest_cache.bin
+bool GetCacheDirectory(std::string &directory) {
+    char *cache_home = PlatformUtilsGetSecureEnv("XDG_CACHE_HOME");
+    if (nullptr != cache_home && cache_home[0] != '\0') {
+        directory = cache_home;
+    } else {
+        char *home = PlatformUtilsGetSecureEnv("HOME");
+        if (nullptr != home && home[0] != '\0') {
+            directory = home;
+            directory += "/.cache";
+        }
+        PlatformUtilsFreeEnv(home);
+    }
+    PlatformUtilsFreeEnv(cache_home);
+    if (directory.empty()) {
+        return false;
+    }
+    directory += "/openxr/";
+    directory += std::to_string(XR_VERSION_MAJOR(XR_CURRENT_API_VERSION));
+    return true;
+}
+
+void LoadCacheFile(CacheEntryMap &entries) {
+    std::string directory;
+    if (!DiskCacheIsAllowed() || !GetCacheDirectory(directory)) {
+        return;
+    }
+    const std::string cache_filename = directory + "/manifest_cache.bin";
+    if (!OwnedByUser(cache_filename, false)) {
+        return;
+    }
+    std::ifstream cache_stream(cache_filename, std::ifstream::in | std::ifstream::binary);
+    if (!cache_stream.is_open()) {
+        return;
+    }
+    std::string contents((std::istreambuf_iterator<char>(cache_stream)), std::istreambuf_iterator<char>());
+
+    CacheReader reader(contents);
+    if (reader.U32() != kCacheFileMagic || reader.U32() != kCacheFileVersion || !reader.Ok()) {
+        return;
+    }
+    CacheEntryMap file_entries;
+    uint32_t entry_count = reader.Count();
+    for (uint32_t entry = 0; entry < entry_count; ++entry) {
+        if (!ReadEntry(reader, file_entries)) {
+            break;
+        }
+    }
+    if (!reader.Ok() || !reader.AtEnd()) {
+        LoaderLogger::LogInfoMessage("", "ManifestFileCache - ignoring corrupt cache file in " + directory);
+        return;
+    }
+    for (auto entry = file_entries.begin(); entry != file_entries.end();) {
+        if (!OwnedByUser(entry->first.second, true)) {
+            entry = file_entries.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+    entries = std::move(file_entries);
+}
+
+void SaveCacheFile(CacheEntryMap &entries) {
+    std::string directory;
+    if (!DiskCacheIsAllowed() || !GetCacheDirectory(directory) || !FileSysUtilsCreateDirectories(directory)) {
+        return;
+    }
+    for (auto entry = entries.begin(); entry != entries.end();) {
+        if (!OwnedByUser(entry->first.second, true)) {
+            entry = entries.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+    CacheWriter writer;
+    writer.U32(kCacheFileMagic);
+    writer.U32(kCacheFileVersion);
+    writer.U32(static_cast<uint32_t>(entries.size()));
+    for (const auto &entry : entries) {
+        WriteEntry(writer, entry.first, entry.second);
+    }
+
+    // Write a file of our own and move it into place, so that other processes only ever see a complete cache file.
+    const std::string cache_filename = directory + "/manifest_cache.bin";
+    const std::string temp_filename = cache_filename + "." + std::to_string(getpid()) + ".tmp";
+    bool written = false;
+    {
+        std::ofstream cache_stream(temp_filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+        if (cache_stream.is_open()) {
+            cache_stream.write(writer.Data().data(), static_cast<std::streamsize>(writer.Data().size()));
+            cache_stream.close();
+            written = !cache_stream.fail();
+        }
+    }
+    if (!written || !FileSysUtilsRenameFile(temp_filename, cache_filename)) {
+        std::remove(temp_filename.c_str());
+        LoaderLogger::LogInfoMessage("", "ManifestFileCache - failed to write cache file in " + directory);
+    }
+}
+
+#else
+
+// Only Linux has a standard per-user cache location, so elsewhere the cache lasts as long as the process.
+void LoadCacheFile(CacheEntryMap & /*entries*/) {}
+void SaveCacheFile(CacheEntryMap & /*entries*/) {}
+
+#endif  // XR_OS_LINUX
+
+// Must be called with g_cache_mutex held.
+void EnsureCacheLoaded() {
+    if (!g_cache_loaded) {
+        g_cache_loaded = true;
+        LoadCacheFile(g_cache_entries);
+    }
+}
+
+}  // namespace
+
+bool ManifestFileCache::Find(const std::string &filename, ManifestFileType type, const FileSysUtilsFileStamp &stamp,
+                             ManifestRecord &record) {
+    if (CacheIsDisabled()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(g_cache_mutex);
+    EnsureCacheLoaded();
+    auto found = g_cache_entries.find(std::make_pair(static_cast<uint32_t>(type), filename));
+    if (found == g_cache_entries.end() || !StampsMatch(found->second.stamp, stamp)) {
+        return false;
+    }
+    record = found->second.record;
+    return true;
+}
+
+void ManifestFileCache::Add(const std::string &filename, ManifestFileType type, const FileSysUtilsFileStamp &stamp,
+                            const ManifestRecord &record) {
+    if (CacheIsDisabled()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(g_cache_mutex);
+    EnsureCacheLoaded();
+    CacheEntry &entry = g_cache_entries[std::make_pair(static_cast<uint32_t>(type), filename)];
+    entry.stamp = stamp;
+    entry.record = record;
+    g_cache_dirty = true;
+}
+
+void ManifestFileCache::Save() {
+    if (CacheIsDisabled()) {
+        return;
+    }
+    // Take a copy to write, so that lookups from other threads do not wait on the file system.
+    CacheEntryMap entries;
+    {
+        std::unique_lock<std::mutex> lock(g_cache_mutex);
+        if (!g_cache_dirty) {
+            return;
+        }
+        g_cache_dirty = false;
+        entries = g_cache_entries;
+    }
+
+    // Drop the entries for files that have since changed or gone away, so the cache does not grow without bound.
+    for (auto entry = entries.begin(); entry != entries.end();) {
+        FileSysUtilsFileStamp stamp;
+        if (!FileSysUtilsGetFileStamp(entry->first.second, stamp) || !StampsMatch(stamp, entry->second.stamp)) {
+            entry = entries.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+    std::unique_lock<std::mutex> save_lock(g_save_mutex);
+    SaveCacheFile(entries);
+}
+
+bool ManifestFileCache::FindDirectory(const std::string &directory, const FileSysUtilsFileStamp &stamp,
+                                      std::vector<std::string> &manifest_files) {
+    if (CacheIsDisabled()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(g_cache_mutex);
+    auto found = g_directory_entries.find(directory);
+    if (found == g_directory_entries.end() || !StampsMatch(found->second.stamp, stamp)) {
+        return false;
+    }
+    manifest_files = found->second.manifest_files;
+    return true;
+}
+
+void ManifestFileCache::AddDirectory(const std::string &directory, const FileSysUtilsFileStamp &stamp,
+                                     const std::vector<std::string> &manifest_files) {
+    if (CacheIsDisabled()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(g_cache_mutex);
+    DirectoryEntry &entry = g_directory_entries[directory];
+    entry.stamp = stamp;
+    entry.manifest_files = manifest_files;
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include "filesystem_utils.hpp"
+#include "manifest_file.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// What the loader takes from a manifest file that parsed and passed validation.  Everything in here comes from the
+// file's contents alone: anything that depends on the environment (enable and disable variables) or on other files
+// (whether the library exists) is still checked every time the record is used.
+struct ManifestRecord {
+    // As written in the file, before being resolved against the manifest's directory
+    std::string library_path;
+    std::vector<ExtensionListing> instance_extensions;
+    std::vector<ExtensionListing> device_extensions;
+    std::vector<std::pair<std::string, std::string>> functions_renamed;
+
+    // API layers only
+    std::string layer_name;
+    std::string description;
+    JsonVersion api_version;
+    uint32_t implementation_version;
+    bool has_enable_environment;
+    std::string enable_environment;
+    bool has_disable_environment;
+    std::string disable_environment;
+};
+
+// ManifestFileCache class -
+// Remembers parsed manifest files by filename, along with the modification time and size the file had when it was
+// parsed, so that a file is only read and parsed again once it changes.  On Linux the records are also kept in a
+// binary file under $XDG_CACHE_HOME (or $HOME/.cache), so that a new process can skip parsing as well, though only for
+// manifest files owned by the user running it.  It also remembers, for the life of the process, which manifest files each
+// searched directory held, so that a directory is only listed again once its modification time changes.  Setting XR_LOADER_DISABLE_MANIFEST_CACHE to anything other than "0"
+// turns both off, so that every search lists every directory and parses every file.
+class ManifestFileCache {
+   public:
+    // Look up the record for a manifest file that currently has the given stamp.  Returns false if the file is not
+    // cached, or has changed since it was.
+    static bool Find(const std::string &filename, ManifestFileType type, const FileSysUtilsFileStamp &stamp,
+                     ManifestRecord &record);
+
+    // Remember the record for a manifest file, parsed when the file had the given stamp.
+    static void Add(const std::string &filename, ManifestFileType type, const FileSysUtilsFileStamp &stamp,
+                    const ManifestRecord &record);
+
+    // Write the cache back to disk, if anything was added since it was loaded.
+    static void Save();
+
+    // Look up the manifest files found in a directory that currently has the given stamp.  Returns false if the directory
+    // has not been listed yet, or has changed since it was.
+    static bool FindDirectory(const std::string &directory, const FileSysUtilsFileStamp &stamp,
+                              std::vector<std::string> &manifest_files);
+
+    // Remember the manifest files found in a directory, listed when the directory had the given stamp.
+    static void AddDirectory(const std::string &directory, const FileSysUtilsFileStamp &stamp,
+                             const std::vector<std::string> &manifest_files);
+};
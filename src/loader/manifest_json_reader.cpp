@@ -0,0 +1,493 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif  // defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+
+#include "manifest_json_reader.hpp"
+
+#include "manifest_file_cache.hpp"
+
+#include <openxr/openxr.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Deeper than any manifest needs; skipping anything deeper is left to jsoncpp.
+const int kMaxSkipDepth = 32;
+
+// A string in the file contents that had no escapes in it, so it can be compared in place.
+struct JsonKey {
+    const char *data;
+    size_t size;
+
+    bool Is(const char *name) const { return size == strlen(name) && 0 == memcmp(data, name, size); }
+};
+
+// Steps through a JSON document.  Every function returns false if the document is not what was asked for, or is anything
+// this scanner does not handle, at which point the whole read is abandoned.
+class JsonScanner {
+   public:
+    explicit JsonScanner(const std::string &contents) : _next(contents.data()), _end(contents.data() + contents.size()) {}
+
+    // True if the next token is the given character, which is consumed.
+    bool Consume(char c) {
+        SkipWhitespace();
+        if (_next != _end && *_next == c) {
+            ++_next;
+            return true;
+        }
+        return false;
+    }
+
+    // True if the next token starts with the given character, which is left in place.
+    bool Peek(char c) {
+        SkipWhitespace();
+        return _next != _end && *_next == c;
+    }
+
+    bool AtEnd() {
+        SkipWhitespace();
+        return _next == _end;
+    }
+
+    // A string without escapes, left in place.  Used for object keys.
+    bool Key(JsonKey &key) {
+        if (!Consume('"')) {
+            return false;
+        }
+        key.data = _next;
+        while (_next != _end && *_next != '"') {
+            if (*_next == '\\' || static_cast<unsigned char>(*_next) < 0x20) {
+                return false;
+            }
+            ++_next;
+        }
+        if (_next == _end) {
+            return false;
+        }
+        key.size = static_cast<size_t>(_next - key.data);
+        ++_next;
+        return true;
+    }
+
+    // A string, with any simple escapes replaced.
+    bool String(std::string &value) {
+        if (!Consume('"')) {
+            return false;
+        }
+        value.clear();
+        const char *run = _next;
+        while (_next != _end && *_next != '"') {
+            if (static_cast<unsigned char>(*_next) < 0x20) {
+                return false;
+            }
+            if (*_next != '\\') {
+                ++_next;
+                continue;
+            }
+            value.append(run, _next);
+            if (++_next == _end) {
+                return false;
+            }
+            switch (*_next) {
+                case '"':
+                case '\\':
+                case '/':
+                    value += *_next;
+                    break;
+                case 'b':
+                    value += '\b';
+                    break;
+                case 'f':
+                    value += '\f';
+                    break;
+                case 'n':
+                    value += '\n';
+                    break;
+                case 'r':
+                    value += '\r';
+                    break;
+                case 't':
+                    value += '\t';
+                    break;
+                default:
+                    // Including \u, which jsoncpp converts to UTF-8: leave that to it.
+                    return false;
+            }
+            run = ++_next;
+        }
+        if (_next == _end) {
+            return false;
+        }
+        value.append(run, _next);
+        ++_next;
+        return true;
+    }
+
+    // An unsigned integer written as plain digits, that fits in 32 bits.
+    bool UInt32(uint32_t &value) {
+        SkipWhitespace();
+        const char *start = _next;
+        uint64_t result = 0;
+        while (_next != _end && *_next >= '0' && *_next <= '9') {
+            result = result * 10 + static_cast<uint64_t>(*_next - '0');
+            if (result > UINT32_MAX) {
+                return false;
+            }
+            ++_next;
+        }
+        if (_next == start || (*start == '0' && _next - start > 1)) {
+            return false;
+        }
+        // A fraction or exponent makes this something other than an integer literal.
+        if (_next != _end && (*_next == '.' || *_next == 'e' || *_next == 'E')) {
+            return false;
+        }
+        value = static_cast<uint32_t>(result);
+        return true;
+    }
+
+    // Any value, which is checked but not kept.
+    bool Skip(int depth = 0) {
+        if (depth > kMaxSkipDepth) {
+            return false;
+        }
+        if (Peek('"')) {
+            std::string ignored;
+            return String(ignored);
+        }
+        if (Peek('{')) {
+            return Object([&](const JsonKey &) { return Skip(depth + 1); });
+        }
+        if (Peek('[')) {
+            return Array([&]() { return Skip(depth + 1); });
+        }
+        if (Literal("true") || Literal("false") || Literal("null")) {
+            return true;
+        }
+        return Number();
+    }
+
+    // An object, calling member(key) to consume the value of each member in turn.
+    template <typename MemberFunction>
+    bool Object(MemberFunction member) {
+        if (!Consume('{')) {
+            return false;
+        }
+        if (Consume('}')) {
+            return true;
+        }
+        do {
+            JsonKey key;
+            if (!Key(key) || !Consume(':') || !member(key)) {
+                return false;
+            }
+        } while (Consume(','));
+        return Consume('}');
+    }
+
+    // An array, calling element() to consume each element in turn.
+    template <typename ElementFunction>
+    bool Array(ElementFunction element) {
+        if (!Consume('[')) {
+            return false;
+        }
+        if (Consume(']')) {
+            return true;
+        }
+        do {
+            if (!element()) {
+                return false;
+            }
+        } while (Consume(','));
+        return Consume(']');
+    }
+
+   private:
+    void SkipWhitespace() {
+        while (_next != _end && (*_next == ' ' || *_next == '\t' || *_next == '\n' || *_next == '\r')) {
+            ++_next;
+        }
+    }
+
+    bool Literal(const char *literal) {
+        SkipWhitespace();
+        size_t size = strlen(literal);
+        if (static_cast<size_t>(_end - _next) < size || 0 != memcmp(_next, literal, size)) {
+            return false;
+        }
+        _next += size;
+        return true;
+    }
+
+    bool Digits() {
+        const char *start = _next;
+        while (_next != _end && *_next >= '0' && *_next <= '9') {
+            ++_next;
+        }
+        return _next != start;
+    }
+
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool Number() {
+        SkipWhitespace();
+        if (_next != _end && *_next == '-') {
+            ++_next;
+        }
+        const char *start = _next;
+        if (!Digits() || (*start == '0' && _next - start > 1)) {
+            return false;
+        }
+        if (_next != _end && *_next == '.') {
+            ++_next;
+            if (!Digits()) {
+                return false;
+            }
+        }
+        if (_next != _end && (*_next == 'e' || *_next == 'E')) {
+            ++_next;
+            if (_next != _end && (*_next == '+' || *_next == '-')) {
+                ++_next;
+            }
+            if (!Digits()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char *_next;
+    const char *_end;
+};
+
+// Tracks which of an object's members have been seen, so that a duplicated one (where jsoncpp would keep the last) is
+// rejected.
+class SeenMembers {
+   public:
+    SeenMembers() : _seen(0) {}
+
+    // Returns false if this member was already seen.
+    bool See(uint32_t member) {
+        uint32_t bit = 1u << member;
+        if (0 != (_seen & bit)) {
+            return false;
+        }
+        _seen |= bit;
+        return true;
+    }
+    bool Saw(uint32_t member) const { return 0 != (_seen & (1u << member)); }
+
+   private:
+    uint32_t _seen;
+};
+
+// Runtime manifests give extension versions as numbers, API layer manifests as strings.
+bool ExtensionVersion(JsonScanner &scanner, bool version_is_string, uint32_t &version) {
+    if (!version_is_string) {
+        return scanner.UInt32(version);
+    }
+    std::string version_string;
+    if (!scanner.String(version_string)) {
+        return false;
+    }
+    version = static_cast<uint32_t>(atoi(version_string.c_str()));
+    return true;
+}
+
+// One element of "instance_extensions" (with_entrypoints false) or "device_extensions" (with_entrypoints true).  The
+// jsoncpp path skips elements without the required members, so those are left to it too.
+bool Extension(JsonScanner &scanner, bool version_is_string, bool with_entrypoints, ExtensionListing &extension) {
+    enum { NAME, VERSION, ENTRYPOINTS, OTHER };
+    SeenMembers seen;
+    bool read = scanner.Object([&](const JsonKey &key) {
+        if (key.Is("name")) {
+            return seen.See(NAME) && scanner.String(extension.name);
+        }
+        if (key.Is("extension_version")) {
+            return seen.See(VERSION) && ExtensionVersion(scanner, version_is_string, extension.extension_version);
+        }
+        if (with_entrypoints && key.Is("entrypoints")) {
+            return seen.See(ENTRYPOINTS) && scanner.Array([&]() {
+                extension.entrypoints.emplace_back();
+                return scanner.String(extension.entrypoints.back());
+            });
+        }
+        return scanner.Skip();
+    });
+    return read && seen.Saw(NAME) && seen.Saw(VERSION) && (!with_entrypoints || seen.Saw(ENTRYPOINTS));
+}
+
+bool Extensions(JsonScanner &scanner, bool version_is_string, bool with_entrypoints, std::vector<ExtensionListing> &extensions) {
+    return scanner.Array([&]() {
+        extensions.emplace_back();
+        extensions.back().extension_version = 0;
+        return Extension(scanner, version_is_string, with_entrypoints, extensions.back());
+    });
+}
+
+bool FunctionsRenamed(JsonScanner &scanner, std::vector<std::pair<std::string, std::string>> &functions_renamed) {
+    return scanner.Object([&](const JsonKey &key) {
+        // jsoncpp keeps the last of duplicated names.
+        for (const auto &function : functions_renamed) {
+            if (key.Is(function.first.c_str())) {
+                return false;
+            }
+        }
+        functions_renamed.emplace_back(std::string(key.data, key.size), std::string());
+        return scanner.String(functions_renamed.back().second);
+    });
+}
+
+// The same check as ManifestFile::IsValidJson, which has the error messages for anything else.
+bool FileFormatVersion(JsonScanner &scanner) {
+    std::string file_format;
+    if (!scanner.String(file_format)) {
+        return false;
+    }
+    JsonVersion version = {};
+    sscanf(file_format.c_str(), "%d.%d.%d", &version.major, &version.minor, &version.patch);
+    return version.major == 1 && version.minor == 0 && version.patch == 0;
+}
+
+// The members shared by the "runtime" and "api_layer" objects.
+enum {
+    LIBRARY_PATH,
+    INSTANCE_EXTENSIONS,
+    DEVICE_EXTENSIONS,
+    FUNCTIONS,
+    LAYER_NAME,
+    API_VERSION,
+    IMPLEMENTATION_VERSION,
+    DESCRIPTION,
+    ENABLE_ENVIRONMENT,
+    DISABLE_ENVIRONMENT,
+};
+
+// Returns true if key is one of the members both kinds of manifest have, in which case handled is set to whether its
+// value could be read.
+bool CommonMember(JsonScanner &scanner, const JsonKey &key, bool version_is_string, SeenMembers &seen, ManifestRecord &record,
+                  bool &handled) {
+    if (key.Is("library_path")) {
+        handled = seen.See(LIBRARY_PATH) && scanner.String(record.library_path);
+    } else if (key.Is("instance_extensions")) {
+        handled = seen.See(INSTANCE_EXTENSIONS) && Extensions(scanner, version_is_string, false, record.instance_extensions);
+    } else if (key.Is("device_extensions")) {
+        handled = seen.See(DEVICE_EXTENSIONS) && Extensions(scanner, version_is_string, true, record.device_extensions);
+    } else if (key.Is("functions")) {
+        handled = seen.See(FUNCTIONS) && FunctionsRenamed(scanner, record.functions_renamed);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The top level of either kind of manifest: "file_format_version" and the object named body_name, read by body.
+template <typename BodyFunction>
+bool Manifest(const std::string &contents, const char *body_name, BodyFunction body) {
+    JsonScanner scanner(contents);
+    enum { FILE_FORMAT_VERSION, BODY };
+    SeenMembers seen;
+    bool read = scanner.Object([&](const JsonKey &key) {
+        if (key.Is("file_format_version")) {
+            return seen.See(FILE_FORMAT_VERSION) && FileFormatVersion(scanner);
+        }
+        if (key.Is(body_name)) {
+            return seen.See(BODY) && body(scanner);
+        }
+        return scanner.Skip();
+    });
+    return read && scanner.AtEnd() && seen.Saw(FILE_FORMAT_VERSION) && seen.Saw(BODY);
+}
+
+}  // namespace
+
+bool ReadRuntimeManifestRecord(const std::string &contents, ManifestRecord &record) {
+    ManifestRecord read_record = {};
+    SeenMembers seen;
+    bool read = Manifest(contents, "runtime", [&](JsonScanner &scanner) {
+        return scanner.Object([&](const JsonKey &key) {
+            bool handled = false;
+            if (CommonMember(scanner, key, false, seen, read_record, handled)) {
+                return handled;
+            }
+            return scanner.Skip();
+        });
+    });
+    if (!read || !seen.Saw(LIBRARY_PATH)) {
+        return false;
+    }
+    record = std::move(read_record);
+    return true;
+}
+
+bool ReadApiLayerManifestRecord(ManifestFileType type, const std::string &contents, ManifestRecord &record) {
+    ManifestRecord read_record = {};
+    std::string api_version_string;
+    std::string implementation_version_string;
+    SeenMembers seen;
+    bool read = Manifest(contents, "api_layer", [&](JsonScanner &scanner) {
+        return scanner.Object([&](const JsonKey &key) {
+            bool handled = false;
+            if (CommonMember(scanner, key, true, seen, read_record, handled)) {
+                return handled;
+            }
+            if (key.Is("name")) {
+                return seen.See(LAYER_NAME) && scanner.String(read_record.layer_name);
+            }
+            if (key.Is("api_version")) {
+                return seen.See(API_VERSION) && scanner.String(api_version_string);
+            }
+            if (key.Is("implementation_version")) {
+                return seen.See(IMPLEMENTATION_VERSION) && scanner.String(implementation_version_string);
+            }
+            if (key.Is("description")) {
+                return seen.See(DESCRIPTION) && scanner.String(read_record.description);
+            }
+            if (key.Is("enable_environment")) {
+                return seen.See(ENABLE_ENVIRONMENT) && scanner.String(read_record.enable_environment);
+            }
+            if (key.Is("disable_environment")) {
+                return seen.See(DISABLE_ENVIRONMENT) && scanner.String(read_record.disable_environment);
+            }
+            return scanner.Skip();
+        });
+    });
+    if (!read || !seen.Saw(LIBRARY_PATH) || !seen.Saw(LAYER_NAME) || !seen.Saw(API_VERSION) ||
+        !seen.Saw(IMPLEMENTATION_VERSION)) {
+        return false;
+    }
+    // Implicit layers require the disable environment variable.
+    if (MANIFEST_TYPE_IMPLICIT_API_LAYER == type && !seen.Saw(DISABLE_ENVIRONMENT)) {
+        return false;
+    }
+    read_record.has_enable_environment = seen.Saw(ENABLE_ENVIRONMENT);
+    read_record.has_disable_environment = seen.Saw(DISABLE_ENVIRONMENT);
+    sscanf(api_version_string.c_str(), "%d.%d", &read_record.api_version.major, &read_record.api_version.minor);
+    read_record.api_version.patch = 0;
+    read_record.implementation_version = static_cast<uint32_t>(atoi(implementation_version_string.c_str()));
+    record = std::move(read_record);
+    return true;
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include "manifest_file.hpp"
+
+#include <string>
+
+struct ManifestRecord;
+
+// Quick readers for well-formed manifest files.
+//
+// These pull the fields the loader uses straight out of the file contents in one pass, without building a Json::Value
+// tree, copying only the strings that end up in the record.  They only handle manifests that are valid and that
+// jsoncpp would read the same way: anything unusual (a missing or mistyped field, a duplicated key, comments, \u
+// escapes, numbers that are not plain unsigned integers, ...) makes them return false, and the caller then parses the
+// file with jsoncpp, which also reports what is wrong with it.  When they return true, record holds exactly what the
+// jsoncpp path would have produced.
+
+// Read a runtime manifest file's contents.
+bool ReadRuntimeManifestRecord(const std::string &contents, ManifestRecord &record);
+
+// Read an API layer manifest file's contents, of the given implicit or explicit type.
+bool ReadApiLayerManifestRecord(ManifestFileType type, const std::string &contents, ManifestRecord &record);
@@ -19,14 +19,18 @@
 
 #include "runtime_interface.hpp"
 
+#include "filesystem_utils.hpp"
 #include "manifest_file.hpp"
 #include "loader_interfaces.h"
 #include "loader_logger.hpp"
 #include "loader_platform.hpp"
+#include "loader_trace.hpp"
+#include "platform_utils.hpp"
 #include "xr_generated_dispatch_table.h"
 
 #include <openxr/openxr.h>
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <mutex>
@@ -37,11 +41,28 @@
 
 std::unique_ptr<RuntimeInterface> RuntimeInterface::_single_runtime_interface;
 uint32_t RuntimeInterface::_single_runtime_count = 0;
+std::mutex RuntimeInterface::_single_runtime_mutex;
+RuntimeInterface* RuntimeInterface::_resident_runtime_interface = nullptr;
+bool RuntimeInterface::_have_remembered_extension_properties = false;
+RuntimeInterface::LibraryIdentity RuntimeInterface::_remembered_extension_identity;
+std::vector<XrExtensionProperties> RuntimeInterface::_remembered_extension_properties;
+
+#define OPENXR_KEEP_RUNTIME_LOADED_ENV_VAR "XR_LOADER_KEEP_RUNTIME_LOADED"
+
+bool RuntimeInterface::KeepRuntimeLoaded() {
+    char* keep = PlatformUtilsGetSecureEnv(OPENXR_KEEP_RUNTIME_LOADED_ENV_VAR);
+    bool keep_loaded = (nullptr != keep && std::string(keep) != "0");
+    PlatformUtilsFreeEnv(keep);
+    return keep_loaded;
+}
 
 XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
+    LoaderTraceScope trace("RuntimeInterface::LoadRuntime");
     XrResult last_error = XR_SUCCESS;
     bool any_loaded = false;
 
+    std::lock_guard<std::mutex> mlock(_single_runtime_mutex);
+
     // If something's already loaded, we're done here.
     if (_single_runtime_interface != nullptr) {
         _single_runtime_count++;
@@ -56,8 +77,30 @@ XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
         LoaderLogger::LogErrorMessage(openxr_command, "RuntimeInterface::LoadRuntimes - unknown error");
         last_error = XR_ERROR_FILE_ACCESS_ERROR;
     } else {
+        // Reuse a runtime kept loaded since its last user, as long as it is still the active runtime and its library has
+        // not changed.  Its negotiated xrGetInstanceProcAddr and supported extensions are still valid.
+        if (nullptr != _resident_runtime_interface) {
+            if (!runtime_manifest_files.empty() && _resident_runtime_interface->_identity.Matches(*runtime_manifest_files[0])) {
+                _single_runtime_interface.reset(_resident_runtime_interface);
+                _resident_runtime_interface = nullptr;
+                _single_runtime_count++;
+                std::string info_message = "RuntimeInterface::LoadRuntime reusing runtime kept loaded from manifest file ";
+                info_message += _single_runtime_interface->_identity.manifest_filename;
+                LoaderLogger::LogInfoMessage(openxr_command, info_message);
+                return XR_SUCCESS;
+            }
+            std::string info_message = "RuntimeInterface::LoadRuntime unloading runtime kept loaded from manifest file ";
+            info_message += _resident_runtime_interface->_identity.manifest_filename;
+            info_message += ", the active runtime has changed";
+            LoaderLogger::LogInfoMessage(openxr_command, info_message);
+            delete _resident_runtime_interface;
+            _resident_runtime_interface = nullptr;
+        }
+
         for (std::unique_ptr<RuntimeManifestFile>& manifest_file : runtime_manifest_files) {
+            LoaderTraceScope open_trace("Open runtime library", manifest_file->LibraryPath());
             LoaderPlatformLibraryHandle runtime_library = LoaderPlatformLibraryOpen(manifest_file->LibraryPath());
+            open_trace.End();
             if (nullptr == runtime_library) {
                 if (!any_loaded) {
                     last_error = XR_ERROR_INSTANCE_LOST;
@@ -97,6 +140,7 @@ XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
             // could not get loaded
             XrResult res = XR_ERROR_RUNTIME_FAILURE;
             if (nullptr != negotiate) {
+                LoaderTraceScope negotiate_trace("Negotiate runtime interface", manifest_file->Filename());
                 res = negotiate(&loader_info, &runtime_info);
             }
             // If we supposedly succeeded, but got a nullptr for GetInstanceProcAddr
@@ -139,30 +183,35 @@ XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
                 continue;
             }
 
-            std::string info_message = "RuntimeInterface::LoadRuntime succeeded loading runtime defined in manifest file ";
-            info_message += manifest_file->Filename();
-            info_message += " using interface version ";
-            info_message += std::to_string(runtime_info.runtimeInterfaceVersion);
-            info_message += " and OpenXR API version ";
-            info_message += std::to_string(XR_VERSION_MAJOR(runtime_info.runtimeApiVersion));
-            info_message += ".";
-            info_message += std::to_string(XR_VERSION_MINOR(runtime_info.runtimeApiVersion));
-            LoaderLogger::LogInfoMessage(openxr_command, info_message);
+            if (LoaderLogger::IsInfoEnabled()) {
+                std::string info_message = "RuntimeInterface::LoadRuntime succeeded loading runtime defined in manifest file ";
+                info_message += manifest_file->Filename();
+                info_message += " using interface version ";
+                info_message += std::to_string(runtime_info.runtimeInterfaceVersion);
+                info_message += " and OpenXR API version ";
+                info_message += std::to_string(XR_VERSION_MAJOR(runtime_info.runtimeApiVersion));
+                info_message += ".";
+                info_message += std::to_string(XR_VERSION_MINOR(runtime_info.runtimeApiVersion));
+                LoaderLogger::LogInfoMessage(openxr_command, info_message);
+            }
 
             // Use this runtime
             _single_runtime_interface.reset(new RuntimeInterface(runtime_library, runtime_info.getInstanceProcAddr));
+            _single_runtime_interface->_identity = LibraryIdentity::Of(*manifest_file);
             _single_runtime_count++;
 
             // Grab the list of extensions this runtime supports for easy filtering after the
-            // xrCreateInstance call
+            // xrCreateInstance call, and remember it for xrEnumerateInstanceExtensionProperties
+            _single_runtime_interface->QueryRuntimeExtensionProperties();
             std::vector<std::string> supported_extensions;
-            std::vector<XrExtensionProperties> extension_properties;
-            _single_runtime_interface->GetInstanceExtensionProperties(extension_properties);
-            supported_extensions.reserve(extension_properties.size());
-            for (XrExtensionProperties ext_prop : extension_properties) {
+            supported_extensions.reserve(_single_runtime_interface->_runtime_extension_properties.size());
+            for (const XrExtensionProperties& ext_prop : _single_runtime_interface->_runtime_extension_properties) {
                 supported_extensions.emplace_back(ext_prop.extensionName);
             }
             _single_runtime_interface->SetSupportedExtensions(supported_extensions);
+            _remembered_extension_identity = _single_runtime_interface->_identity;
+            _remembered_extension_properties = _single_runtime_interface->_runtime_extension_properties;
+            _have_remembered_extension_properties = true;
 
             // If we load one, clear all errors.
             any_loaded = true;
@@ -184,8 +233,16 @@ XrResult RuntimeInterface::LoadRuntime(const std::string& openxr_command) {
 }
 
 void RuntimeInterface::UnloadRuntime(const std::string& openxr_command) {
+    std::lock_guard<std::mutex> mlock(_single_runtime_mutex);
     if (_single_runtime_count == 1) {
         _single_runtime_count = 0;
+        if (KeepRuntimeLoaded()) {
+            // Leave the library loaded for the next instance.  Every instance is gone, so nothing refers to its dispatch
+            // tables any more.
+            _resident_runtime_interface = _single_runtime_interface.release();
+            LoaderLogger::LogInfoMessage(openxr_command, "RuntimeInterface kept loaded with no users.");
+            return;
+        }
         _single_runtime_interface.reset();
     } else if (_single_runtime_count > 0) {
         --_single_runtime_count;
@@ -208,32 +265,79 @@ const XrGeneratedDispatchTable* RuntimeInterface::GetDispatchTable(XrInstance in
 }
 
 const XrGeneratedDispatchTable* RuntimeInterface::GetDebugUtilsMessengerDispatchTable(XrDebugUtilsMessengerEXT messenger) {
-    XrInstance runtime_instance = XR_NULL_HANDLE;
-    {
-        std::lock_guard<std::mutex> mlock(_single_runtime_interface->_messenger_to_instance_mutex);
-        auto it = _single_runtime_interface->_messenger_to_instance_map.find(messenger);
-        if (it != _single_runtime_interface->_messenger_to_instance_map.end()) {
-            runtime_instance = it->second;
-        }
+    const XrGeneratedDispatchTable* table = nullptr;
+    std::lock_guard<std::mutex> mlock(_single_runtime_interface->_dispatch_table_mutex);
+    auto it = _single_runtime_interface->_messenger_dispatch_table_map.find(messenger);
+    if (it != _single_runtime_interface->_messenger_dispatch_table_map.end()) {
+        table = it->second;
     }
-    return GetDispatchTable(runtime_instance);
+    return table;
 }
 
 RuntimeInterface::RuntimeInterface(LoaderPlatformLibraryHandle runtime_library, PFN_xrGetInstanceProcAddr get_instant_proc_addr)
     : _runtime_library(runtime_library), _get_instant_proc_addr(get_instant_proc_addr) {}
 
+RuntimeInterface::LibraryIdentity RuntimeInterface::LibraryIdentity::Of(RuntimeManifestFile& manifest_file) {
+    LibraryIdentity identity;
+    identity.manifest_filename = manifest_file.Filename();
+    identity.library_path = manifest_file.LibraryPath();
+    identity.have_library_stamp = FileSysUtilsGetFileStamp(identity.library_path, identity.library_stamp);
+    return identity;
+}
+
+bool RuntimeInterface::LibraryIdentity::Matches(RuntimeManifestFile& manifest_file) const {
+    if (manifest_file.Filename() != manifest_filename || manifest_file.LibraryPath() != library_path) {
+        return false;
+    }
+    FileSysUtilsFileStamp current_stamp = {};
+    bool have_current_stamp = FileSysUtilsGetFileStamp(library_path, current_stamp);
+    return have_current_stamp == have_library_stamp &&
+           (!have_current_stamp ||
+            (current_stamp.modified_time == library_stamp.modified_time && current_stamp.size == library_stamp.size));
+}
+
+XrResult RuntimeInterface::GetRuntimeExtensionProperties(const std::string& openxr_command,
+                                                         std::vector<XrExtensionProperties>& extension_properties) {
+    bool have_remembered;
+    {
+        std::lock_guard<std::mutex> mlock(_single_runtime_mutex);
+        have_remembered = _have_remembered_extension_properties;
+    }
+    // Only look for the active runtime here if there is something to check it against: otherwise LoadRuntime does the
+    // search, and reports any problem with it, once.
+    if (have_remembered) {
+        std::vector<std::unique_ptr<RuntimeManifestFile>> runtime_manifest_files;
+        if (XR_SUCCESS == RuntimeManifestFile::FindManifestFiles(MANIFEST_TYPE_RUNTIME, runtime_manifest_files) &&
+            !runtime_manifest_files.empty()) {
+            std::lock_guard<std::mutex> mlock(_single_runtime_mutex);
+            if (_have_remembered_extension_properties && _remembered_extension_identity.Matches(*runtime_manifest_files[0])) {
+                MergeRuntimeExtensionProperties(_remembered_extension_properties, extension_properties);
+                return XR_SUCCESS;
+            }
+        }
+    }
+
+    XrResult result = LoadRuntime(openxr_command);
+    if (XR_SUCCESS != result) {
+        return result;
+    }
+    GetRuntime().GetInstanceExtensionProperties(extension_properties);
+    UnloadRuntime(openxr_command);
+    return XR_SUCCESS;
+}
+
 RuntimeInterface::~RuntimeInterface() {
-    std::string info_message = "RuntimeInterface being destroyed.";
-    LoaderLogger::LogInfoMessage("", info_message);
+    LoaderLogger::LogInfoMessage("", "RuntimeInterface being destroyed.");
     {
         std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
+        _messenger_dispatch_table_map.clear();
         _dispatch_table_map.clear();
     }
     LoaderPlatformLibraryClose(_runtime_library);
 }
 
-void RuntimeInterface::GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties) {
-    std::vector<XrExtensionProperties> runtime_extension_properties;
+void RuntimeInterface::QueryRuntimeExtensionProperties() {
+    _runtime_extension_properties.clear();
     PFN_xrEnumerateInstanceExtensionProperties rt_xrEnumerateInstanceExtensionProperties;
     _get_instant_proc_addr(XR_NULL_HANDLE, "xrEnumerateInstanceExtensionProperties",
                            reinterpret_cast<PFN_xrVoidFunction*>(&rt_xrEnumerateInstanceExtensionProperties));
@@ -242,42 +346,51 @@ void RuntimeInterface::GetInstanceExtensionProperties(std::vector<XrExtensionPro
     // Get the count from the runtime
     rt_xrEnumerateInstanceExtensionProperties(nullptr, count, &count_output, nullptr);
     if (count_output > 0) {
-        runtime_extension_properties.resize(count_output);
+        _runtime_extension_properties.resize(count_output);
         count = count_output;
-        for (XrExtensionProperties& ext_prop : runtime_extension_properties) {
+        for (XrExtensionProperties& ext_prop : _runtime_extension_properties) {
             ext_prop.type = XR_TYPE_EXTENSION_PROPERTIES;
             ext_prop.next = nullptr;
         }
-        rt_xrEnumerateInstanceExtensionProperties(nullptr, count, &count_output, runtime_extension_properties.data());
+        rt_xrEnumerateInstanceExtensionProperties(nullptr, count, &count_output, _runtime_extension_properties.data());
+        _runtime_extension_properties.resize(std::min(count, count_output));
     }
-    size_t ext_count = runtime_extension_properties.size();
-    size_t props_count = extension_properties.size();
-    for (size_t ext = 0; ext < ext_count; ++ext) {
-        bool found = false;
-        for (size_t prop = 0; prop < props_count; ++prop) {
-            // If we find it, then make sure the spec version matches that of the runtime instead of the
-            // layer.
-            if (strcmp(extension_properties[prop].extensionName, runtime_extension_properties[ext].extensionName) == 0) {
-                // Make sure the spec version used is the runtime's
-                extension_properties[prop].extensionVersion = runtime_extension_properties[ext].extensionVersion;
-                found = true;
-                break;
-            }
-        }
-        if (!found) {
-            extension_properties.push_back(runtime_extension_properties[ext]);
+}
+
+void RuntimeInterface::MergeRuntimeExtensionProperties(const std::vector<XrExtensionProperties>& runtime_extension_properties,
+                                                       std::vector<XrExtensionProperties>& extension_properties) {
+    std::unordered_map<std::string, size_t> property_index;
+    property_index.reserve(extension_properties.size() + runtime_extension_properties.size());
+    for (size_t prop = 0; prop < extension_properties.size(); ++prop) {
+        property_index.emplace(extension_properties[prop].extensionName, prop);
+    }
+    for (const XrExtensionProperties& runtime_prop : runtime_extension_properties) {
+        auto inserted = property_index.emplace(runtime_prop.extensionName, extension_properties.size());
+        if (inserted.second) {
+            extension_properties.push_back(runtime_prop);
+        } else {
+            // Make sure the spec version used is the runtime's instead of the layer's
+            extension_properties[inserted.first->second].extensionVersion = runtime_prop.extensionVersion;
         }
     }
 }
 
+void RuntimeInterface::GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties) {
+    MergeRuntimeExtensionProperties(_runtime_extension_properties, extension_properties);
+}
+
 XrResult RuntimeInterface::CreateInstance(const XrInstanceCreateInfo* info, XrInstance* instance) {
     XrResult res = XR_SUCCESS;
     bool create_succeeded = false;
     PFN_xrCreateInstance rt_xrCreateInstance;
     _get_instant_proc_addr(XR_NULL_HANDLE, "xrCreateInstance", reinterpret_cast<PFN_xrVoidFunction*>(&rt_xrCreateInstance));
-    res = rt_xrCreateInstance(info, instance);
+    {
+        LoaderTraceScope create_trace("Runtime xrCreateInstance");
+        res = rt_xrCreateInstance(info, instance);
+    }
     if (XR_SUCCESS == res) {
         create_succeeded = true;
+        LoaderTraceScope populate_trace("Populate runtime dispatch table");
         std::unique_ptr<XrGeneratedDispatchTable> dispatch_table(new XrGeneratedDispatchTable());
         GeneratedXrPopulateDispatchTable(dispatch_table.get(), *instance, _get_instant_proc_addr);
         std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
@@ -297,11 +410,20 @@ XrResult RuntimeInterface::CreateInstance(const XrInstanceCreateInfo* info, XrIn
 
 XrResult RuntimeInterface::DestroyInstance(XrInstance instance) {
     if (XR_NULL_HANDLE != instance) {
-        // Destroy the dispatch table for this instance first
+        // Destroy the dispatch table for this instance first, along with its messengers' entries
         {
             std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
             auto map_iter = _dispatch_table_map.find(instance);
             if (map_iter != _dispatch_table_map.end()) {
+                const XrGeneratedDispatchTable* table = map_iter->second.get();
+                for (auto messenger_iter = _messenger_dispatch_table_map.begin();
+                     messenger_iter != _messenger_dispatch_table_map.end();) {
+                    if (messenger_iter->second == table) {
+                        messenger_iter = _messenger_dispatch_table_map.erase(messenger_iter);
+                    } else {
+                        ++messenger_iter;
+                    }
+                }
                 _dispatch_table_map.erase(map_iter);
             }
         }
@@ -314,15 +436,19 @@ XrResult RuntimeInterface::DestroyInstance(XrInstance instance) {
 }
 
 bool RuntimeInterface::TrackDebugMessenger(XrInstance instance, XrDebugUtilsMessengerEXT messenger) {
-    std::lock_guard<std::mutex> mlock(_messenger_to_instance_mutex);
-    _messenger_to_instance_map[messenger] = instance;
+    std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
+    auto map_iter = _dispatch_table_map.find(instance);
+    if (map_iter == _dispatch_table_map.end()) {
+        return false;
+    }
+    _messenger_dispatch_table_map[messenger] = map_iter->second.get();
     return true;
 }
 
 void RuntimeInterface::ForgetDebugMessenger(XrDebugUtilsMessengerEXT messenger) {
     if (XR_NULL_HANDLE != messenger) {
-        std::lock_guard<std::mutex> mlock(_messenger_to_instance_mutex);
-        _messenger_to_instance_map.erase(messenger);
+        std::lock_guard<std::mutex> mlock(_dispatch_table_mutex);
+        _messenger_dispatch_table_map.erase(messenger);
     }
 }
 
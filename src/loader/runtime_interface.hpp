@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "filesystem_utils.hpp"
 #include "loader_platform.hpp"
 
 #include <openxr/openxr.h>
@@ -30,6 +31,7 @@
 #include <memory>
 
 struct XrGeneratedDispatchTable;
+class RuntimeManifestFile;
 
 class RuntimeInterface {
    public:
@@ -42,6 +44,10 @@ class RuntimeInterface {
     static XrResult GetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
     static const XrGeneratedDispatchTable* GetDispatchTable(XrInstance instance);
     static const XrGeneratedDispatchTable* GetDebugUtilsMessengerDispatchTable(XrDebugUtilsMessengerEXT messenger);
+    // Add the instance extensions of the active runtime to extension_properties.  The runtime's list is remembered from
+    // the last time it was loaded, so it is only loaded again once the active runtime or its library changes.
+    static XrResult GetRuntimeExtensionProperties(const std::string& openxr_command,
+                                                  std::vector<XrExtensionProperties>& extension_properties);
 
     void GetInstanceExtensionProperties(std::vector<XrExtensionProperties>& extension_properties);
     bool SupportsExtension(const std::string& extension_name);
@@ -58,16 +64,46 @@ class RuntimeInterface {
     RuntimeInterface& operator=(const RuntimeInterface&) = delete;
 
    private:
+    // Where a runtime was loaded from.  Anything kept from a loaded runtime is only used again while the active runtime
+    // manifest still names the same library and the library file is unchanged.
+    struct LibraryIdentity {
+        std::string manifest_filename;
+        std::string library_path;
+        bool have_library_stamp = false;
+        FileSysUtilsFileStamp library_stamp = {};
+
+        static LibraryIdentity Of(RuntimeManifestFile& manifest_file);
+        bool Matches(RuntimeManifestFile& manifest_file) const;
+    };
+
     RuntimeInterface(LoaderPlatformLibraryHandle runtime_library, PFN_xrGetInstanceProcAddr get_instant_proc_addr);
     void SetSupportedExtensions(std::vector<std::string>& supported_extensions);
+    void QueryRuntimeExtensionProperties();
+    static void MergeRuntimeExtensionProperties(const std::vector<XrExtensionProperties>& runtime_extension_properties,
+                                                std::vector<XrExtensionProperties>& extension_properties);
+    static bool KeepRuntimeLoaded();
 
     static std::unique_ptr<RuntimeInterface> _single_runtime_interface;
     static uint32_t _single_runtime_count;
+    // The runtime kept loaded after its last user unloaded it, when XR_LOADER_KEEP_RUNTIME_LOADED is set.  It is never
+    // destroyed at exit, so that the runtime library is not closed during static destruction.
+    static RuntimeInterface* _resident_runtime_interface;
+    // Guards loading, unloading and counting users of the single runtime, so instances can be created in parallel
+    static std::mutex _single_runtime_mutex;
+    // The extensions reported by the runtime loaded last, guarded by _single_runtime_mutex
+    static bool _have_remembered_extension_properties;
+    static LibraryIdentity _remembered_extension_identity;
+    static std::vector<XrExtensionProperties> _remembered_extension_properties;
     LoaderPlatformLibraryHandle _runtime_library;
     PFN_xrGetInstanceProcAddr _get_instant_proc_addr;
+    LibraryIdentity _identity;
+    // The runtime's own xrEnumerateInstanceExtensionProperties results, queried once when it is loaded
+    std::vector<XrExtensionProperties> _runtime_extension_properties;
+    // Owns the dispatch tables.  The terminators find an instance's table through its LoaderInstance, without locking,
+    // and only look here for handles they can't match to one.
     std::unordered_map<XrInstance, std::unique_ptr<XrGeneratedDispatchTable>> _dispatch_table_map;
+    // Each debug messenger's instance's table.  Guarded, like _dispatch_table_map, by _dispatch_table_mutex.
+    std::unordered_map<XrDebugUtilsMessengerEXT, const XrGeneratedDispatchTable*> _messenger_dispatch_table_map;
     std::mutex _dispatch_table_mutex;
-    std::unordered_map<XrDebugUtilsMessengerEXT, XrInstance> _messenger_to_instance_map;
-    std::mutex _messenger_to_instance_mutex;
     std::vector<std::string> _supported_extensions;
 };
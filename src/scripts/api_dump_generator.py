@@ -57,11 +57,16 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
         if self.genOpts.filename == 'xr_generated_api_dump.hpp':
             preamble += '#pragma once\n\n'
             preamble += '#include "api_layer_platform_defines.h"\n'
+            preamble += '#include "hex_and_handles.h"\n'
             preamble += '#include <openxr/openxr.h>\n'
             preamble += '#include <openxr/openxr_platform.h>\n\n'
+            preamble += '#include <atomic>\n'
+            preamble += '#include <chrono>\n'
+            preamble += '#include <cstdint>\n'
             preamble += '#include <mutex>\n'
             preamble += '#include <string>\n'
             preamble += '#include <tuple>\n'
+            preamble += '#include <type_traits>\n'
             preamble += '#include <unordered_map>\n'
             preamble += '#include <vector>\n\n'
             preamble += 'struct XrGeneratedDispatchTable;\n\n'
@@ -119,14 +124,66 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
         generated_prototypes = '// Layer\'s xrGetInstanceProcAddr\n'
         generated_prototypes += 'XrResult ApiDumpLayerXrGetInstanceProcAddr(XrInstance instance,\n'
         generated_prototypes += '                                          const char* name, PFN_xrVoidFunction* function);\n\n'
+        generated_prototypes += '// The commands ApiDumpLayerXrGetInstanceProcAddr returns the layer\'s own functions for\n'
+        generated_prototypes += 'const std::vector<const char*>& ApiDumpLayerInterceptedCommands();\n\n'
         generated_prototypes += '// Api Dump Log Command\n'
         generated_prototypes += 'bool ApiDumpLayerRecordContent(std::vector<std::tuple<std::string, std::string, std::string>> contents);\n\n'
+        generated_prototypes += '// Api Dump Command Filtering\n'
+        generated_prototypes += '// What was last decided about recording a command.  Each command keeps one of these, so that the decision is only\n'
+        generated_prototypes += '// made again once the filters change.\n'
+        generated_prototypes += 'struct ApiDumpCommandFilter {\n'
+        generated_prototypes += '    std::atomic<uint32_t> generation;\n'
+        generated_prototypes += '    // 0 to record no calls, otherwise one call in this many is recorded\n'
+        generated_prototypes += '    std::atomic<uint32_t> sample_rate;\n'
+        generated_prototypes += '    std::atomic<uint64_t> calls;\n'
+        generated_prototypes += '};\n'
+        generated_prototypes += 'bool ApiDumpLayerShouldRecord(const char* command_name, const char* extension_name, ApiDumpCommandFilter& filter);\n\n'
+        generated_prototypes += '// Api Dump Call Timing\n'
+        generated_prototypes += 'struct ApiDumpCallTiming {\n'
+        generated_prototypes += '    const char* command_name;\n'
+        generated_prototypes += '    bool enabled;\n'
+        generated_prototypes += '    uint64_t frame;\n'
+        generated_prototypes += '    std::chrono::steady_clock::time_point start;\n'
+        generated_prototypes += '    std::chrono::steady_clock::duration duration;\n'
+        generated_prototypes += '};\n'
+        generated_prototypes += 'ApiDumpCallTiming ApiDumpLayerStartCall(const char* command_name);\n'
+        generated_prototypes += 'void ApiDumpLayerEndCall(ApiDumpCallTiming& timing);\n'
+        generated_prototypes += 'void ApiDumpLayerRecordCallTiming(const ApiDumpCallTiming& timing);\n\n'
         generated_prototypes += '// Api Dump Manual Functions\n'
         generated_prototypes += 'XrInstance FindInstanceFromDispatchTable(XrGeneratedDispatchTable* dispatch_table);\n'
         generated_prototypes += 'XrResult ApiDumpLayerXrCreateInstance(const XrInstanceCreateInfo *info,\n'
         generated_prototypes += '                                      XrInstance *instance);\n'
         generated_prototypes += 'XrResult ApiDumpLayerXrDestroyInstance(XrInstance instance);\n'
         generated_prototypes += '\n//Dump utility functions\n'
+        generated_prototypes += 'std::string ApiDumpHexString(uint64_t value);\n'
+        generated_prototypes += '// Narrower and signed integers go through the unsigned type of the same width, so that a negative value is written\n'
+        generated_prototypes += '// out as its own bits, as streaming it with std::hex does, rather than sign extended to 64 bits.\n'
+        generated_prototypes += 'template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>\n'
+        generated_prototypes += 'static inline std::string ApiDumpHexString(T value) {\n'
+        generated_prototypes += '    return ApiDumpHexString(static_cast<uint64_t>(static_cast<typename std::make_unsigned<T>::type>(value)));\n'
+        generated_prototypes += '}\n'
+        generated_prototypes += 'template <typename T>\n'
+        generated_prototypes += 'static inline std::string ApiDumpHexString(const T* value) {\n'
+        generated_prototypes += '    return PointerToHexString(value);\n'
+        generated_prototypes += '}\n'
+        generated_prototypes += 'std::string ApiDumpFloatString(double value, int precision);\n'
+        generated_prototypes += 'template <typename T>\n'
+        generated_prototypes += 'static inline std::string ApiDumpFloatString(const T* value, int /*precision*/) {\n'
+        generated_prototypes += '    return PointerToHexString(value);\n'
+        generated_prototypes += '}\n'
+        generated_prototypes += '// Handles are written out with the name given to them with xrSetDebugUtilsObjectNameEXT, if any.  Where the value is\n'
+        generated_prototypes += '// still a pointer to handles, its address is written out instead.\n'
+        generated_prototypes += 'std::string ApiDumpObjectHandleString(uint64_t handle, XrObjectType object_type);\n'
+        generated_prototypes += 'template <typename HandleType>\n'
+        generated_prototypes += 'static inline std::string ApiDumpHandleString(HandleType handle, XrObjectType object_type) {\n'
+        generated_prototypes += '    return ApiDumpObjectHandleString(MakeHandleGeneric(handle), object_type);\n'
+        generated_prototypes += '}\n'
+        generated_prototypes += 'template <typename HandleType>\n'
+        generated_prototypes += 'static inline std::string ApiDumpHandleString(const HandleType* handles, XrObjectType /*object_type*/) {\n'
+        generated_prototypes += '    return PointerToHexString(handles);\n'
+        generated_prototypes += '}\n'
+        generated_prototypes += 'void ApiDumpLayerSetObjectName(const XrDebugUtilsObjectNameInfoEXT& name_info);\n'
+        generated_prototypes += 'void ApiDumpLayerRemoveObjectName(uint64_t handle, XrObjectType object_type);\n'
         generated_prototypes += 'bool ApiDumpDecodeNextChain(XrGeneratedDispatchTable* gen_dispatch_table, const void* value, std::string prefix,\n'
         generated_prototypes += '                            std::vector<std::tuple<std::string, std::string, std::string>> &contents);\n'
         generated_prototypes += '\n// Union/Structure Output Helper function prototypes\n'
@@ -459,14 +516,17 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                 write_string += '} else {\n'
                 write_string += self.writeIndent(indent)
 
-            # If we're outputting using a string stream, determine the type of information
-            # we're generating and format it appropriately.
+            # If we're outputting a number, handle or pointer, determine the type of information
+            # we're generating and format it appropriately without going through a string stream.
             if use_stream:
+                value = full_name
+                if can_dereference and pointer_count > 0:
+                    value = '*' * pointer_count + full_name
                 write_string += self.writeIndent(indent)
-                write_string += 'std::ostringstream oss_%s;\n' % int_short_param_name
-                write_string += self.writeIndent(indent)
+                write_string += 'contents.emplace_back("%s", %s, ' % (full_type, description)
                 # Output the standard type information if we can, except for characters because the
-                # hex converter will try to use the string value in the char.
+                # hex converter will try to use the string value in the char.  Where the value is
+                # still a pointer or an array, the overloads write out its address instead.
                 if is_standard_type and not is_char:
                     if 'float' in base_type:
                         precision = '32'
@@ -474,23 +534,16 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                             precision = '64'
                         elif '16' in base_type:
                             precision = '16'
-                        write_string += 'oss_%s << std::setprecision(%s) << (' % (int_short_param_name, precision)
+                        write_string += 'ApiDumpFloatString(%s, %s)' % (value, precision)
                     elif 'double' in base_type:
-                        write_string += 'oss_%s << std::setprecision(64) << (' % int_short_param_name
+                        write_string += 'ApiDumpFloatString(%s, 64)' % value
                     else:
-                        write_string += 'oss_%s << ' % int_short_param_name
-                        if member_param.pointer_count == 0:
-                            write_string += '"0x" << '
-                        write_string += 'std::hex << ('
+                        write_string += 'ApiDumpHexString(%s)' % value
+                elif self.isHandle(base_type):
+                    write_string += 'ApiDumpHandleString<%s>(%s, %s)' % (base_type, value, self.genXrObjectType(base_type))
                 else:
-                    write_string += 'oss_%s << ' % int_short_param_name
-                    write_string += 'std::hex << reinterpret_cast<const void*>('
-                if can_dereference and pointer_count > 0:
-                    write_string += '*' * pointer_count
-                write_string += '%s);\n' % full_name
-                write_string += self.writeIndent(indent)
-                write_string += 'contents.emplace_back("%s", %s' % (full_type, description)
-                write_string += ', oss_%s.str());\n' % int_short_param_name
+                    write_string += 'PointerToHexString(reinterpret_cast<const void*>(%s))' % value
+                write_string += ');\n'
 
             else:
                 write_string += self.writeIndent(indent)
@@ -1083,8 +1136,6 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                     generated_commands += return_prefix
 
                 generated_commands += '    try {\n'
-                generated_commands += '        // Generate output for this command\n'
-                generated_commands += '        std::vector<std::tuple<std::string, std::string, std::string>> contents;\n'
 
                 # Next, we have to call down to the next implementation of this command in the call chain.
                 # Before we can do that, we have to figure out what the dispatch table is
@@ -1101,12 +1152,19 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                     generated_commands += self.printCodeGenErrorMessage(
                         'Command %s does not have an OpenXR Object handle as the first parameter.' % cur_cmd.name)
 
+                # Only generate the output if the filters let this call through
+                generated_commands += '        static ApiDumpCommandFilter filter;\n'
+                generated_commands += '        bool record = ApiDumpLayerShouldRecord("%s", "%s", filter);\n' % (cur_cmd.name, cur_cmd.ext_name)
+                generated_commands += '        if (record) {\n'
+                generated_commands += '            // Generate output for this command\n'
+                generated_commands += '            std::vector<std::tuple<std::string, std::string, std::string>> contents;\n'
+
                 # Print out a tuple for the header
                 if has_return:
-                    generated_commands += '        contents.emplace_back("%s", "%s", "");\n' % (
+                    generated_commands += '            contents.emplace_back("%s", "%s", "");\n' % (
                         cur_cmd.return_type.text, cur_cmd.name)
                 else:
-                    generated_commands += '        contents.emplace_back("void", "%s", "");\n' % cur_cmd.name
+                    generated_commands += '            contents.emplace_back("void", "%s", "");\n' % cur_cmd.name
                 # Print out information for each parameter
                 for param in cur_cmd.params:
                     can_expand = False
@@ -1115,12 +1173,14 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                             (param.is_const or param.pointer_count == 0)):
                         can_expand = True
                     generated_commands += self.writeParamMember(
-                        param, False, can_expand, 2)
+                        param, False, can_expand, 3)
 
-                # Now record the information
-                generated_commands += '        ApiDumpLayerRecordContent(contents);\n\n'
+                # Record the command before calling down, so that it is in the output even if the call never returns.
+                generated_commands += '            ApiDumpLayerRecordContent(std::move(contents));\n'
+                generated_commands += '        }\n\n'
 
-                # Call down, looking for the returned result if required.
+                # Call down, looking for the returned result if required, and time the call.
+                generated_commands += '        ApiDumpCallTiming timing = ApiDumpLayerStartCall("%s");\n' % cur_cmd.name
                 generated_commands += '        '
                 if has_return:
                     generated_commands += 'result = '
@@ -1133,6 +1193,18 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                     generated_commands += param.name
                     count = count + 1
                 generated_commands += ');\n'
+                generated_commands += '        ApiDumpLayerEndCall(timing);\n'
+
+                # With timing on, how long the call took follows the command in the output
+                generated_commands += '        if (record) {\n'
+                generated_commands += '            ApiDumpLayerRecordCallTiming(timing);\n'
+                generated_commands += '        }\n'
+
+                # Names given to objects are kept, so that later calls can write them out with the handles
+                if cur_cmd.name == 'xrSetDebugUtilsObjectNameEXT':
+                    generated_commands += '        if (XR_SUCCESS == result && nullptr != %s) {\n' % cur_cmd.params[-1].name
+                    generated_commands += '            ApiDumpLayerSetObjectName(*%s);\n' % cur_cmd.params[-1].name
+                    generated_commands += '        }\n'
 
                 # If this is a create command, we have to create an entry in the appropriate
                 # unordered_map pointing to the correct dispatch table for the newly created
@@ -1159,6 +1231,8 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                         generated_commands += '            g_%s_dispatch_map.erase(%s);\n' % (
                             second_base_handle_name, cur_cmd.params[-1].name)
                         generated_commands += '        }\n'
+                        generated_commands += '        ApiDumpLayerRemoveObjectName(MakeHandleGeneric(%s), %s);\n' % (
+                            cur_cmd.params[-1].name, self.genXrObjectType(cur_cmd.params[-1].type))
 
                 # Catch any exceptions that may have occurred.  If any occurred between any of the
                 # valid mutex lock/unlock statements, perform the unlock now.
@@ -1182,18 +1256,22 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
         generated_commands += '    PFN_xrVoidFunction*                         function) {\n'
         generated_commands += '    try {\n'
         generated_commands += '        std::string func_name = name;\n\n'
-        generated_commands += '        // Generate output for this command\n'
-        generated_commands += '        std::vector<std::tuple<std::string, std::string, std::string>> contents;\n'
-        generated_commands += '        contents.emplace_back("XrResult", "xrGetInstanceProcAddr", "");\n'
-        generated_commands += '        contents.emplace_back("XrInstance", "instance", HandleToHexString(instance));\n'
-        generated_commands += '        contents.emplace_back("const char*", "name", name);\n'
-        generated_commands += '        contents.emplace_back("PFN_xrVoidFunction*", "function", PointerToHexString(reinterpret_cast<const void*>(function)));\n'
-        generated_commands += '        ApiDumpLayerRecordContent(contents);\n'
+        generated_commands += '        static ApiDumpCommandFilter filter;\n'
+        generated_commands += '        if (ApiDumpLayerShouldRecord("xrGetInstanceProcAddr", "XR_VERSION_1_0", filter)) {\n'
+        generated_commands += '            // Generate output for this command\n'
+        generated_commands += '            std::vector<std::tuple<std::string, std::string, std::string>> contents;\n'
+        generated_commands += '            contents.emplace_back("XrResult", "xrGetInstanceProcAddr", "");\n'
+        generated_commands += '            contents.emplace_back("XrInstance", "instance", ApiDumpHandleString<XrInstance>(instance, XR_OBJECT_TYPE_INSTANCE));\n'
+        generated_commands += '            contents.emplace_back("const char*", "name", name);\n'
+        generated_commands += '            contents.emplace_back("PFN_xrVoidFunction*", "function", PointerToHexString(reinterpret_cast<const void*>(function)));\n'
+        generated_commands += '            ApiDumpLayerRecordContent(contents);\n'
+        generated_commands += '        }\n'
         
         generated_commands += '        // Set the function pointer to NULL so that the fall-through below actually works:\n'
         generated_commands += '        *function = nullptr;\n\n'
 
         count = 0
+        intercepted_commands = []
         for x in range(0, 2):
             if x == 0:
                 commands = self.core_commands
@@ -1232,6 +1310,7 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
                 generated_commands += '            *function = reinterpret_cast<PFN_xrVoidFunction>(%s);\n' % layer_command_name
                 if cur_cmd.protect_value:
                     generated_commands += '#endif // %s\n' % cur_cmd.protect_string
+                intercepted_commands.append(cur_cmd)
 
         generated_commands += '        }\n'
         generated_commands += '        // If we setup the function, just return\n'
@@ -1254,4 +1333,18 @@ class ApiDumpOutputGenerator(AutomaticSourceOutputGenerator):
         generated_commands += '        return XR_ERROR_VALIDATION_FAILURE;\n'
         generated_commands += '    }\n'
         generated_commands += '}\n'
+
+        # Output the list of the commands returned above, which the layer reports to the loader.
+        generated_commands += '\n// The commands ApiDumpLayerXrGetInstanceProcAddr returns the layer\'s own functions for\n'
+        generated_commands += 'const std::vector<const char*>& ApiDumpLayerInterceptedCommands() {\n'
+        generated_commands += '    static const std::vector<const char*> intercepted_commands = {\n'
+        for cur_cmd in intercepted_commands:
+            if cur_cmd.protect_value:
+                generated_commands += '#if %s\n' % cur_cmd.protect_string
+            generated_commands += '        "%s",\n' % cur_cmd.name
+            if cur_cmd.protect_value:
+                generated_commands += '#endif // %s\n' % cur_cmd.protect_string
+        generated_commands += '    };\n'
+        generated_commands += '    return intercepted_commands;\n'
+        generated_commands += '}\n'
         return generated_commands
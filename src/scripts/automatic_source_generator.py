@@ -22,6 +22,8 @@
 #               registry and forming the information in an easy to use
 #               way for the rest of the automatic source generation scripts.
 
+import io
+import os
 import re
 from collections import namedtuple
 from inspect import currentframe, getframeinfo
@@ -448,7 +450,19 @@ class AutomaticSourceOutputGenerator(OutputGenerator):
     #   self            the AutomaticSourceOutputGenerator object
     #   gen_opts        the AutomaticSourceGeneratorOptions object
     def beginFile(self, genOpts):
-        OutputGenerator.beginFile(self, genOpts)
+        # Generate into memory rather than straight into the output file, so that endFile
+        # can leave the file alone when nothing in it changed.  Its timestamp then stays put
+        # and the build doesn't recompile everything that includes it.
+        # This does what OutputGenerator.beginFile does, apart from opening the file.
+        self.output_path = None
+        if genOpts.filename is not None:
+            self.output_path = os.path.join(genOpts.directory, genOpts.filename)
+            self.genOpts = genOpts
+            self.should_insert_may_alias_macro = self.genOpts.conventions.should_insert_may_alias_macro(self.genOpts)
+            self.conventions = genOpts.conventions
+            self.outFile = io.StringIO()
+        else:
+            OutputGenerator.beginFile(self, genOpts)
 
         # Iterate over all 'tag' Elements and add the names of all the valid vendor
         # tags to the list
@@ -469,12 +483,32 @@ class AutomaticSourceOutputGenerator(OutputGenerator):
     #   self            the AutomaticSourceOutputGenerator object
     def endFile(self):
         self.outputErrorIfNeeded()
+        contents = None
+        if self.output_path is not None:
+            contents = self.outFile.getvalue()
         # Finish processing in superclass
         OutputGenerator.endFile(self)
+        if contents is not None:
+            self.writeFileIfChanged(self.output_path, contents)
 
         if self.encountered_error:
             exit(-1)
 
+    # Write the generated contents out, unless the file already holds exactly that.
+    #   self            the AutomaticSourceOutputGenerator object
+    #   path            the output file
+    #   contents        the generated text
+    def writeFileIfChanged(self, path, contents):
+        if os.path.isfile(path):
+            with io.open(path, 'r', encoding='utf-8') as existing:
+                if existing.read() == contents:
+                    return
+        directory = os.path.dirname(path)
+        if directory and not os.path.isdir(directory):
+            os.makedirs(directory)
+        with io.open(path, 'w', encoding='utf-8') as output:
+            output.write(contents)
+
     # This is called for the beginning of each API feature.  Each feature includes a set of
     # API types, commands, etc.  Each feature is identified by a name, this includes the API
     # core items (as <API>_VERSION_...) or extension items (by the extension name define
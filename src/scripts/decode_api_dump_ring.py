@@ -0,0 +1,99 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2017-2019 The Khronos Group Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Decodes a ring file written by the API dump layer when XR_API_DUMP_EXPORT_TYPE is "ring", printing the calls it still
+# holds, oldest first, the way the layer's text output would.  The file can be read while the application is running or
+# after it has crashed.  The file layout is described with ApiDumpRingFile in src/api_layers/api_dump.cpp.
+
+import getopt
+import struct
+import sys
+
+MAGIC = 0x52415258
+VERSION = 1
+HEADER_SIZE = 64
+
+def decode(data, out):
+    if len(data) < HEADER_SIZE:
+        raise ValueError('file is too short to be an API dump ring file')
+    # The file is in the byte order of the machine that wrote it
+    for order in ['<', '>']:
+        if struct.unpack_from(order + 'I', data, 0)[0] == MAGIC:
+            break
+    else:
+        raise ValueError('file is not an API dump ring file')
+    version, capacity, head, pid = struct.unpack_from(order + 'IQQI', data, 4)
+    if version != VERSION:
+        raise ValueError('unsupported API dump ring file version %d' % version)
+    if capacity == 0 or len(data) < HEADER_SIZE + capacity:
+        raise ValueError('file is shorter than its header says')
+
+    ring = data[HEADER_SIZE:HEADER_SIZE + capacity]
+    position = head % capacity
+    if head <= capacity:
+        text = ring[:head]
+    else:
+        # The oldest call was written over part way through, so start at the first call that is still whole: each call
+        # starts on a line of its own, while the lines that follow it in the same call are indented.
+        text = ring[position:] + ring[:position]
+        start = 0
+        while True:
+            start = text.find(b'\n', start)
+            if start < 0 or not text.startswith(b'    ', start + 1):
+                break
+            start += 1
+        text = text[start + 1:] if start >= 0 else b''
+
+    out.write('API dump ring file of process %d, %d bytes of calls written, %d kept\n' % (pid, head, len(text)))
+    out.write(text.decode('utf-8', 'replace'))
+
+def main(argv):
+    output_file = ''
+
+    usage =  '\ndecode_api_dump_ring.py <ARGS> <ring file>\n'
+    usage += '    -o/--output <filename>\n'
+
+    try:
+        opts, args = getopt.getopt(argv,"ho:",["output="])
+    except getopt.GetoptError:
+        print(usage)
+        sys.exit(2)
+    for opt, arg in opts:
+        if opt == '-h':
+            print(usage)
+            sys.exit()
+        elif opt in ("-o", "--output"):
+            output_file = arg
+
+    if len(args) != 1:
+        print(usage)
+        sys.exit(2)
+
+    with open(args[0], 'rb') as ring_file:
+        data = ring_file.read()
+
+    try:
+        if output_file:
+            with open(output_file, 'w') as out:
+                decode(data, out)
+        else:
+            decode(data, sys.stdout)
+    except ValueError as error:
+        print('%s: %s' % (args[0], error))
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
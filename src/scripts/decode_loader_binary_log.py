@@ -0,0 +1,127 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2017-2019 The Khronos Group Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Decodes a binary log written by the loader when XR_LOADER_BINARY_LOG is set, printing each message the way the
+# loader's standard output logger would, prefixed with the time since logging started and the thread that logged it.
+# The file layout is described with BinaryFileLoaderLogRecorder in src/loader/loader_logger_recorders.cpp.
+
+import datetime
+import getopt
+import struct
+import sys
+
+MAGIC = 0x424c5258
+VERSION = 1
+HEADER_SIZE = 64
+STRING_RECORD = 1
+MESSAGE_RECORD = 2
+
+SEVERITIES = ['Verbose', 'Info', 'Warning', 'Error']
+TYPES = {1: 'GENERAL', 2: 'SPEC', 4: 'PERF'}
+
+def decode(data, out):
+    if len(data) < HEADER_SIZE:
+        raise ValueError('file is too short to be a loader binary log')
+    # The file is in the byte order of the machine that wrote it
+    for order in ['<', '>']:
+        if struct.unpack_from(order + 'I', data, 0)[0] == MAGIC:
+            break
+    else:
+        raise ValueError('file is not a loader binary log')
+    version, capacity, used, dropped, start_ns, pid = struct.unpack_from(order + 'IQQQqI', data, 4)
+    if version != VERSION:
+        raise ValueError('unsupported loader binary log version %d' % version)
+
+    start = datetime.datetime.fromtimestamp(start_ns / 1e9)
+    out.write('Loader binary log of process %d, started %s\n' % (pid, start.isoformat(' ')))
+
+    strings = {0: ''}
+    offset = HEADER_SIZE
+    end = min(used, len(data))
+    while offset + 8 <= end:
+        size, kind = struct.unpack_from(order + 'IH', data, offset)
+        if size == 0 or offset + size > end:
+            break
+        payload = offset + 8
+        if kind == STRING_RECORD:
+            string_id, length = struct.unpack_from(order + 'II', data, payload)
+            strings[string_id] = data[payload + 8:payload + 8 + length].decode('utf-8', 'replace')
+        elif kind == MESSAGE_RECORD:
+            (timestamp, thread, severity, message_type, object_count, label_count, command_id, message_id_id,
+             message_length) = struct.unpack_from(order + 'QIBBBBIII', data, payload)
+            position = payload + 28
+            objects = []
+            for _ in range(object_count):
+                objects.append(struct.unpack_from(order + 'QII', data, position))
+                position += 16
+            labels = []
+            for _ in range(label_count):
+                labels.append(struct.unpack_from(order + 'I', data, position)[0])
+                position += 4
+            message = data[position:position + message_length].decode('utf-8', 'replace')
+
+            out.write('%12.6f [%u] %s [%s | %s | %s] : %s\n' % (
+                timestamp / 1e9, thread,
+                SEVERITIES[severity] if severity < len(SEVERITIES) else 'Error',
+                TYPES.get(message_type, 'UNKNOWN'),
+                strings.get(command_id, ''), strings.get(message_id_id, ''), message))
+            for index, (handle, _, name_id) in enumerate(objects):
+                name = strings.get(name_id, '')
+                out.write('    Object[%d] = 0x%016x%s\n' % (index, handle, ' (%s)' % name if name else ''))
+            for index, label_id in enumerate(labels):
+                out.write('    SessionLabel[%d] = %s\n' % (index, strings.get(label_id, '')))
+        offset += size
+
+    if dropped:
+        out.write('%d messages were dropped because the log was full\n' % dropped)
+
+def main(argv):
+    output_file = ''
+
+    usage =  '\ndecode_loader_binary_log.py <ARGS> <binary log file>\n'
+    usage += '    -o/--output <filename>\n'
+
+    try:
+        opts, args = getopt.getopt(argv,"ho:",["output="])
+    except getopt.GetoptError:
+        print(usage)
+        sys.exit(2)
+    for opt, arg in opts:
+        if opt == '-h':
+            print(usage)
+            sys.exit()
+        elif opt in ("-o", "--output"):
+            output_file = arg
+
+    if len(args) != 1:
+        print(usage)
+        sys.exit(2)
+
+    with open(args[0], 'rb') as log_file:
+        data = log_file.read()
+
+    try:
+        if output_file:
+            with open(output_file, 'w') as out:
+                decode(data, out)
+        else:
+            decode(data, sys.stdout)
+    except ValueError as error:
+        print('%s: %s' % (args[0], error))
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
@@ -73,21 +73,37 @@ EXTENSIONS_LOADER_IMPLEMENTS = [
     'XR_EXT_debug_utils'
 ]
 
+# Commands of the extensions that only exist in the loader, so are not in the
+# registry, with the extension that has to be enabled to use each of them.
+# They are implemented manually in the loader.
+LOADER_ONLY_EXTENSION_COMMANDS = (
+    ('XR_EXTX_loader_call_statistics', 'xrGetLoaderCallStatisticsEXTX'),
+    ('XR_EXTX_loader_call_statistics', 'xrResetLoaderCallStatisticsEXTX'),
+)
+
 
 def generateErrorMessage(indent_level, vuid, cur_cmd, message, object_info):
     lines = []
-    lines.append('LoaderLogger::LogValidationErrorMessage(')
-    lines.append('    "VUID-{}",'.format('-'.join(vuid)))
-    lines.append('    "{}",'.format(cur_cmd.name))
-    lines.append('    {},'.format(message))
-
-    object_info_constructors = ['XrSdkLogObjectInfo{%s, %s}' % p for p in object_info]
-    if len(object_info_constructors) <= 1:
-        lines.append('    {%s});' % (', '.join(object_info_constructors)))
+    if len(object_info) == 1:
+        # The common case goes through an out-of-line helper, so nothing is formatted or allocated in the trampoline.
+        lines.append('LoaderGenLogObjectValidationError(')
+        lines.append('    "VUID-{}",'.format('-'.join(vuid)))
+        lines.append('    "{}",'.format(cur_cmd.name))
+        lines.append('    {},'.format(message))
+        lines.append('    MakeHandleGeneric(%s), %s);' % object_info[0])
     else:
-        lines.append('    {')
-        lines.append(',\n'.join('    %s' % x for x in object_info_constructors))
-        lines.append('    });')
+        lines.append('LoaderLogger::LogValidationErrorMessage(')
+        lines.append('    "VUID-{}",'.format('-'.join(vuid)))
+        lines.append('    "{}",'.format(cur_cmd.name))
+        lines.append('    {},'.format(message))
+
+        object_info_constructors = ['XrSdkLogObjectInfo{%s, %s}' % p for p in object_info]
+        if len(object_info_constructors) <= 1:
+            lines.append('    {%s});' % (', '.join(object_info_constructors)))
+        else:
+            lines.append('    {')
+            lines.append(',\n'.join('    %s' % x for x in object_info_constructors))
+            lines.append('    });')
     if isinstance(indent_level, str):
         base_indent = indent_level
     else:
@@ -126,12 +142,14 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
             preamble += '#include "openxr/openxr_platform.h"\n\n'
             preamble += '#include "loader_interfaces.h"\n\n'
             preamble += '#include "loader_instance.hpp"\n\n'
+            preamble += '#include <cstdint>\n\n'
 
         elif self.genOpts.filename == 'xr_generated_loader.cpp':
             preamble += '#include "xr_generated_loader.hpp"\n\n'
             preamble += '#include "api_layer_interface.hpp"\n'
             preamble += '#include "exception_handling.hpp"\n'
             preamble += '#include "hex_and_handles.h"\n'
+            preamble += '#include "loader_call_statistics.hpp"\n'
             preamble += '#include "loader_instance.hpp"\n'
             preamble += '#include "loader_logger.hpp"\n'
             preamble += '#include "loader_platform.hpp"\n'
@@ -140,7 +158,8 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
             preamble += '#include "xr_dependencies.h"\n'
             preamble += '#include <openxr/openxr.h>\n'
-            preamble += '#include <openxr/openxr_platform.h>\n\n'
+            preamble += '#include <openxr/openxr_platform.h>\n'
+            preamble += '#include <openxr/openxr_loader_statistics.h>\n\n'
 
             preamble += '#include <cstring>\n'
             preamble += '#include <memory>\n'
@@ -166,9 +185,15 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
             file_data += '} // extern "C"\n'
             file_data += '#endif\n'
             file_data += self.outputLoaderMapExterns()
+            file_data += self.outputLoaderCommandIndices()
+            file_data += self.outputLoaderGipaCommandIndices()
+            file_data += self.outputLoaderExtensionIndices()
 
         elif self.genOpts.filename == 'xr_generated_loader.cpp':
             file_data += self.outputLoaderMapDefines()
+            file_data += self.outputLoaderCommandNames()
+            file_data += self.outputLoaderExtensionLookup()
+            file_data += self.outputLoaderDiagnosticFuncs()
             file_data += '#ifdef __cplusplus\n'
             file_data += 'extern "C" { \n'
             file_data += '#endif\n'
@@ -261,7 +286,7 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
         generated_protos += '// Instance Init Dispatch Table (put all terminators in first)\n'
         generated_protos += 'void LoaderGenInitInstanceDispatchTable(XrInstance runtime_instance,\n'
-        generated_protos += '                                        std::unique_ptr<XrGeneratedDispatchTable>& table);\n\n'
+        generated_protos += '                                        std::unique_ptr<XrGeneratedDispatchTable>& table, bool lazy);\n\n'
         return generated_protos
 
     # Output global externs of unordered_maps and mutexes for each handle type.
@@ -312,6 +337,141 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
         return map_defines
 
+    # Return the commands that get a generated trampoline, in the order of their call statistics index.
+    #   self            the LoaderSourceOutputGenerator object
+    def trampolineCommands(self):
+        return [cur_cmd for cur_cmd in self.core_commands + self.ext_commands
+                if cur_cmd.name not in MANUAL_LOADER_FUNCS]
+
+    # Output the indices the generated trampolines record their call statistics under.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderCommandIndices(self):
+        indices = '// Index of each generated trampoline in its instance\'s LoaderCallStatistics\n'
+        indices += 'enum LoaderCommandIndex : uint32_t {\n'
+        for cur_cmd in self.trampolineCommands():
+            indices += '    LOADER_COMMAND_%s,\n' % cur_cmd.name
+        indices += '    LOADER_COMMAND_COUNT\n'
+        indices += '};\n\n'
+        indices += '// Name of the command with the given LoaderCommandIndex.\n'
+        indices += 'const char* LoaderGenCommandName(uint32_t command);\n\n'
+        return indices
+
+    # Output the names of the commands for each LoaderCommandIndex.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderCommandNames(self):
+        names = 'const char* LoaderGenCommandName(uint32_t command) {\n'
+        names += '    static const char* const command_names[LOADER_COMMAND_COUNT] = {\n'
+        for cur_cmd in self.trampolineCommands():
+            names += '        "%s",\n' % cur_cmd.name
+        names += '    };\n'
+        names += '    return (command < LOADER_COMMAND_COUNT) ? command_names[command] : "";\n'
+        names += '}\n\n'
+        return names
+
+    # Return the name of every extension the loader may check is enabled, sorted by name, which is the order of
+    # the LoaderExtensionIndex values.
+    #   self            the LoaderSourceOutputGenerator object
+    def loaderExtensionNames(self):
+        extensions = set(extension.name for extension in self.extensions)
+        extensions.update(cur_cmd.ext_name for cur_cmd in self.ext_commands)
+        extensions.update(ext_name for ext_name, _ in LOADER_ONLY_EXTENSION_COMMANDS)
+        extensions.update(EXTENSIONS_LOADER_IMPLEMENTS)
+        return sorted(extensions)
+
+    # Name of the LoaderExtensionIndex value for an extension
+    #   self            the LoaderSourceOutputGenerator object
+    #   ext_name        the name of the extension
+    def makeExtensionIndexName(self, ext_name):
+        return 'LOADER_EXTENSION_%s' % ext_name.upper()
+
+    # Output the indices of the bits each instance keeps for its enabled extensions.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderExtensionIndices(self):
+        indices = '// Index of each extension the loader checks, in order of name, into its instance\'s enabled extension bits\n'
+        indices += 'enum LoaderExtensionIndex : uint32_t {\n'
+        for ext_name in self.loaderExtensionNames():
+            indices += '    %s,\n' % self.makeExtensionIndexName(ext_name)
+        indices += '    LOADER_EXTENSION_COUNT\n'
+        indices += '};\n\n'
+        indices += '// Find the LoaderExtensionIndex for an extension name.  Returns false for extensions the loader does not know.\n'
+        indices += 'bool LoaderGenFindExtension(const char* name, uint32_t& extension);\n\n'
+        return indices
+
+    # Output the sorted table of extension names and the binary search over it.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderExtensionLookup(self):
+        lookup = '// Names of every extension the loader checks, sorted so they can be binary searched\n'
+        lookup += 'static const char* const g_extension_names[LOADER_EXTENSION_COUNT] = {\n'
+        for ext_name in self.loaderExtensionNames():
+            lookup += '    "%s",\n' % ext_name
+        lookup += '};\n\n'
+        lookup += 'bool LoaderGenFindExtension(const char* name, uint32_t& extension) {\n'
+        lookup += '    uint32_t low = 0;\n'
+        lookup += '    uint32_t high = LOADER_EXTENSION_COUNT;\n'
+        lookup += '    while (low < high) {\n'
+        lookup += '        uint32_t middle = low + (high - low) / 2;\n'
+        lookup += '        int compare = strcmp(name, g_extension_names[middle]);\n'
+        lookup += '        if (compare == 0) {\n'
+        lookup += '            extension = middle;\n'
+        lookup += '            return true;\n'
+        lookup += '        }\n'
+        lookup += '        if (compare < 0) {\n'
+        lookup += '            high = middle;\n'
+        lookup += '        } else {\n'
+        lookup += '            low = middle + 1;\n'
+        lookup += '        }\n'
+        lookup += '    }\n'
+        lookup += '    return false;\n'
+        lookup += '}\n\n'
+        return lookup
+
+    # Output the functions the trampolines report failures through.  All of the formatting, and every std::string,
+    # lives in these out-of-line cold functions, so the trampolines only pass along pointers to string literals and
+    # handle values, and the code on the path that succeeds stays small.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderDiagnosticFuncs(self):
+        diag_funcs = '// Out-of-line diagnostics for the trampolines, only reached when a call fails\n'
+        diag_funcs += 'LOADER_COLD static void LoaderGenLogValidationError(const char* vuid, const char* command_name,\n'
+        diag_funcs += '                                                   const char* message) {\n'
+        diag_funcs += '    LoaderLogger::LogValidationErrorMessage(vuid, command_name, message);\n'
+        diag_funcs += '}\n\n'
+        diag_funcs += 'LOADER_COLD static void LoaderGenLogObjectValidationError(const char* vuid, const char* command_name,\n'
+        diag_funcs += '                                                         const char* message, uint64_t handle,\n'
+        diag_funcs += '                                                         XrObjectType object_type) {\n'
+        diag_funcs += '    LoaderLogger::LogValidationErrorMessage(vuid, command_name, message, {XrSdkLogObjectInfo{handle, object_type}});\n'
+        diag_funcs += '}\n\n'
+        # Only commands taking an array of handles as their first parameter check every element.
+        has_handle_array = False
+        for cur_cmd in self.core_commands + self.ext_commands:
+            if cur_cmd.name in MANUAL_LOADER_FUNCS or not cur_cmd.params:
+                continue
+            first_param = cur_cmd.params[0]
+            if first_param.is_handle and self.paramPointerCount(first_param.cdecl, first_param.type, first_param.name) == 1:
+                has_handle_array = True
+        if has_handle_array:
+            diag_funcs += '// Report element index of a handle array that is invalid, or that belongs to another instance than element 0\n'
+            diag_funcs += 'LOADER_COLD static void LoaderGenLogArrayElementValidationError(const char* vuid, const char* command_name,\n'
+            diag_funcs += '                                                               const char* array_name, uint32_t index,\n'
+            diag_funcs += '                                                               bool other_instance, uint64_t handle,\n'
+            diag_funcs += '                                                               XrObjectType object_type) {\n'
+            diag_funcs += '    std::string message = array_name;\n'
+            diag_funcs += '    message += "[" + std::to_string(index) + "]";\n'
+            diag_funcs += '    if (other_instance) {\n'
+            diag_funcs += '        message += " belongs to a different instance than ";\n'
+            diag_funcs += '        message += array_name;\n'
+            diag_funcs += '        message += "[0]";\n'
+            diag_funcs += '    } else {\n'
+            diag_funcs += '        message += " is not a valid ";\n'
+            diag_funcs += '        message += array_name;\n'
+            diag_funcs += '    }\n'
+            diag_funcs += '    LoaderLogger::LogValidationErrorMessage(vuid, command_name, message, {XrSdkLogObjectInfo{handle, object_type}});\n'
+            diag_funcs += '}\n\n'
+
+        diag_funcs += 'LOADER_COLD static void LoaderGenLogError(const char* command_name, const char* message) {\n'
+        diag_funcs += '    LoaderLogger::LogErrorMessage(command_name, message);\n'
+        diag_funcs += '}\n\n'
+        return diag_funcs
+
     # Output loader generated functions.  This has special cases for create and destroy commands
     # since we have to associate the created objects with the original instance during the create,
     # and then remove that association in the delete.
@@ -388,14 +548,13 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                                         [(first_handle_name, self.genXrObjectType(param.type))]
                                     )
                                     tramp_variable_defines += '    }\n'
-                            tramp_variable_defines += '    LoaderInstance *loader_instance = g_%s_map.Get(%s);\n' % (
-                                base_handle_name, first_handle_name)
                             if cur_cmd.is_destroy_disconnect:
                                 tramp_variable_defines += '    // Destroy the mapping entry for this item if it was valid.\n'
-                                tramp_variable_defines += '    if (nullptr != loader_instance) {\n'
-                                tramp_variable_defines += '            g_%s_map.Erase(%s);\n' % (
+                                tramp_variable_defines += '    LoaderInstance *loader_instance = g_%s_map.Take(%s);\n' % (
+                                    base_handle_name, first_handle_name)
+                            else:
+                                tramp_variable_defines += '    LoaderInstance *loader_instance = g_%s_map.Get(%s);\n' % (
                                     base_handle_name, first_handle_name)
-                                tramp_variable_defines += '    }\n'
                             # These should be mutually exclusive - verify it.
                             assert((not cur_cmd.is_destroy_disconnect) or
                                    (pointer_count == 0))
@@ -406,24 +565,11 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                                 tramp_variable_defines += '        LoaderInstance *elt_loader_instance = g_%s_map.Get(%s[i]);\n' % (
                                     base_handle_name, param.name)
                                 tramp_variable_defines += '        if (elt_loader_instance == nullptr || elt_loader_instance != loader_instance) {\n'
-                                tramp_variable_defines += '            auto elt_name = "%s[" + std::to_string(i) + "]";\n' % param.name
-                                tramp_variable_defines += '            if (elt_loader_instance == nullptr) {\n'
-                                tramp_variable_defines += generateErrorMessage(
-                                    '                    ',
-                                    [cur_cmd.name, param.name, 'parameter'],
-                                    cur_cmd,
-                                    'elt_name + " is not a valid %s"' % (param.name),
-                                    [(first_handle_name + '[i]', self.genXrObjectType(param.type))]
-                                )
-                                tramp_variable_defines += '            } else {\n'
-                                tramp_variable_defines += generateErrorMessage(
-                                    '                    ',
-                                    [cur_cmd.name, param.name, 'parameter'],
-                                    cur_cmd,
-                                    '"%s[" + std::to_string(i) + "] belongs to a different instance than %s[0]"' % (param.name, param.name),
-                                    [(first_handle_name + '[i]', self.genXrObjectType(param.type))]
-                                )
-                                tramp_variable_defines += '            }\n'
+                                tramp_variable_defines += '            LoaderGenLogArrayElementValidationError(\n'
+                                tramp_variable_defines += '                "VUID-%s-%s-parameter", "%s", "%s", i,\n' % (
+                                    cur_cmd.name, param.name, cur_cmd.name, param.name)
+                                tramp_variable_defines += '                elt_loader_instance != nullptr, MakeHandleGeneric(%s[i]), %s);\n' % (
+                                    first_handle_name, self.genXrObjectType(param.type))
                                 if has_return:
                                     tramp_variable_defines += '            return XR_ERROR_HANDLE_INVALID;\n'
                                 tramp_variable_defines += '        }\n'
@@ -474,7 +620,7 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                                 func_follow_up += '            XrResult insert_result = g_%s_map.Insert(*%s, *loader_instance);\n' % (
                                     base_handle_name, param.name)
                                 func_follow_up += '            if (XR_FAILED(insert_result)) {\n'
-                                func_follow_up += '                LoaderLogger::LogErrorMessage(\n'
+                                func_follow_up += '                LoaderGenLogError(\n'
                                 func_follow_up += '                    "%s",\n' % cur_cmd.name
                                 func_follow_up += '                    "Failed inserting new %s into map: may be null or not unique");\n' % base_handle_name
                                 func_follow_up += '            }\n'
@@ -499,11 +645,11 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
                 # If this is not core, but an extension, check to make sure the extension is enabled.
                 if x == 1:
-                    generated_funcs += '    if (!loader_instance->ExtensionIsEnabled("%s")) {\n' % (
-                        cur_cmd.ext_name)
-                    generated_funcs += '        LoaderLogger::LogValidationErrorMessage("VUID-%s-extension-notenabled",\n' % cur_cmd.name
-                    generated_funcs += '                                                "%s",\n' % cur_cmd.name
-                    generated_funcs += '                                                "The %s extension has not been enabled prior to calling %s");\n' % (
+                    generated_funcs += '    if (!loader_instance->ExtensionIsEnabled(%s)) {\n' % (
+                        self.makeExtensionIndexName(cur_cmd.ext_name))
+                    generated_funcs += '        LoaderGenLogValidationError("VUID-%s-extension-notenabled",\n' % cur_cmd.name
+                    generated_funcs += '                                    "%s",\n' % cur_cmd.name
+                    generated_funcs += '                                    "The %s extension has not been enabled prior to calling %s");\n' % (
                         cur_cmd.ext_name, cur_cmd.name)
                     if has_return:
                         generated_funcs += '        return XR_ERROR_FUNCTION_UNSUPPORTED;\n'
@@ -511,6 +657,8 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                         generated_funcs += '        return;\n'
                     generated_funcs += '    }\n\n'
 
+                generated_funcs += '    LoaderCallTimer call_timer(loader_instance->CallStatistics(), LOADER_COMMAND_%s);\n' % cur_cmd.name
+
                 if has_return:
                     if just_return_call:
                         generated_funcs += '    return '
@@ -577,11 +725,145 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                     if has_return and not just_return_call:
                         generated_funcs += '    return result;\n'
                     generated_funcs += '}\n'
+                if self.isLazyDispatchCommand(cur_cmd):
+                    generated_funcs += self.outputLazyDispatchThunk(cur_cmd)
                 if cur_cmd.protect_value:
                     generated_funcs += '#endif // %s\n' % cur_cmd.protect_string
                 generated_funcs += '\n'
         return generated_funcs
 
+    # Return true if the command's dispatch table entry can be left for its first call to look up
+    # when lazy dispatch is enabled.  That takes a generated trampoline, which has already found the
+    # command's instance by the time it calls through the table, and a first parameter the thunk can
+    # find the same instance from.  Destroy commands' trampolines take the handle out of its map before
+    # the call, so those are not lazy either.  Everything else is still looked up when the table is created.
+    #   self            the LoaderSourceOutputGenerator object
+    #   cur_cmd         the command to check
+    def isLazyDispatchCommand(self, cur_cmd):
+        if cur_cmd.name in MANUAL_LOADER_FUNCS or cur_cmd.name in self.no_trampoline_or_terminator:
+            return False
+        if cur_cmd.is_destroy_disconnect:
+            return False
+        if cur_cmd.return_type is None or cur_cmd.return_type.text != 'XrResult':
+            return False
+        first_param = cur_cmd.params[0]
+        return first_param.is_handle and first_param.pointer_count == 0
+
+    # Write the thunk a lazily populated dispatch table starts out with for a command: the first call
+    # looks the command up, puts it in the table in place of the thunk, and calls it.
+    #   self            the LoaderSourceOutputGenerator object
+    #   cur_cmd         the command to write the thunk for
+    def outputLazyDispatchThunk(self, cur_cmd):
+        base_name = cur_cmd.name[2:]
+        first_param = cur_cmd.params[0]
+        thunk_name = 'LoaderGenLazy%s' % base_name
+        param_names = ', '.join(param.name for param in cur_cmd.params)
+
+        thunk = '\n// Lazy dispatch table entry: looks %s up on its first call\n' % cur_cmd.name
+        thunk += cur_cmd.cdecl.replace('XRAPI_CALL %s(' % cur_cmd.name, 'XRAPI_CALL %s(' % thunk_name).replace(
+            ';', ' XRLOADER_ABI_TRY {\n')
+        thunk += '    LoaderInstance *loader_instance = g_%s_map.Get(%s);\n' % (
+            undecorate(first_param.type), first_param.name)
+        thunk += '    if (nullptr == loader_instance) {\n'
+        thunk += '        return XR_ERROR_HANDLE_INVALID;\n'
+        thunk += '    }\n'
+        thunk += '    PFN_%s function = reinterpret_cast<PFN_%s>(loader_instance->ResolveLazyDispatchEntry(\n' % (
+            cur_cmd.name, cur_cmd.name)
+        thunk += '        "%s", reinterpret_cast<PFN_xrVoidFunction*>(&loader_instance->DispatchTable()->%s),\n' % (
+            cur_cmd.name, base_name)
+        thunk += '        reinterpret_cast<PFN_xrVoidFunction>(%s)));\n' % thunk_name
+        thunk += '    if (nullptr == function) {\n'
+        thunk += '        return XR_ERROR_FUNCTION_UNSUPPORTED;\n'
+        thunk += '    }\n'
+        thunk += '    return function(%s);\n' % param_names
+        thunk += '}\nXRLOADER_ABI_CATCH_FALLBACK\n'
+        return thunk
+
+    # Write the assignment of the function pointer xrGetInstanceProcAddr hands back for a command.
+    #   self            the LoaderSourceOutputGenerator object
+    #   indent          the number of "tabs" to indent the assignment by
+    #   cur_cmd         the command being looked up
+    def outputGipaFunctionAssignment(self, indent, cur_cmd):
+        base_name = cur_cmd.name[2:]
+        trampoline = '*function = reinterpret_cast<PFN_xrVoidFunction>(%s);\n' % cur_cmd.name
+        dispatch = '*function = reinterpret_cast<PFN_xrVoidFunction>(loader_instance->DispatchTable()->%s);\n' % base_name
+        if cur_cmd.name in MANUAL_LOADER_FUNCS:
+            return self.writeIndent(indent) + trampoline
+        if not cur_cmd.has_instance:
+            # Only the trampoline can count the call for the instance's call statistics.
+            assignment = self.writeIndent(indent)
+            assignment += 'if (nullptr != loader_instance->CallStatistics()) {\n'
+            assignment += self.writeIndent(indent + 1) + trampoline
+            assignment += self.writeIndent(indent)
+            assignment += '} else {\n'
+            assignment += self.writeIndent(indent + 1) + dispatch
+            assignment += self.writeIndent(indent)
+            assignment += '}\n'
+            return assignment
+        if cur_cmd.is_create_connect or cur_cmd.is_destroy_disconnect:
+            # These keep the loader's handle maps up to date, which the loader-implemented commands rely on,
+            # so they stay behind the trampoline even in direct dispatch mode.
+            return self.writeIndent(indent) + trampoline
+        # With direct dispatch enabled, skip the trampoline and go straight to the top of the call chain.
+        assignment = self.writeIndent(indent)
+        assignment += 'if (loader_instance->DirectDispatchEnabled()) {\n'
+        assignment += self.writeIndent(indent + 1) + dispatch
+        assignment += self.writeIndent(indent)
+        assignment += '} else {\n'
+        assignment += self.writeIndent(indent + 1) + trampoline
+        assignment += self.writeIndent(indent)
+        assignment += '}\n'
+        return assignment
+
+    # Return the name, extension and protect string of every command xrGetInstanceProcAddr can return, sorted
+    # by name, which is the order of the LoaderGipaCommandIndex values.
+    #   self            the LoaderSourceOutputGenerator object
+    def gipaCommands(self):
+        gipa_commands = [(cur_cmd.name, cur_cmd.ext_name, cur_cmd.protect_string if cur_cmd.protect_value else None)
+                         for cur_cmd in self.core_commands + self.ext_commands]
+        gipa_commands += [(cmd_name, ext_name, None) for ext_name, cmd_name in LOADER_ONLY_EXTENSION_COMMANDS]
+        return sorted(gipa_commands)
+
+    # Output the indices xrGetInstanceProcAddr resolves command names to.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderGipaCommandIndices(self):
+        indices = '// Index of each command xrGetInstanceProcAddr knows, in order of name\n'
+        indices += 'enum LoaderGipaCommandIndex : uint32_t {\n'
+        for cmd_name, _, _ in self.gipaCommands():
+            indices += '    LOADER_GIPA_COMMAND_%s,\n' % cmd_name
+        indices += '    LOADER_GIPA_COMMAND_COUNT\n'
+        indices += '};\n\n'
+        return indices
+
+    # Output the sorted table of command names and the binary search over it.
+    #   self            the LoaderSourceOutputGenerator object
+    def outputLoaderGipaCommandLookup(self):
+        lookup = '// Names of every command xrGetInstanceProcAddr knows, sorted so they can be binary searched\n'
+        lookup += 'static const char* const g_gipa_command_names[LOADER_GIPA_COMMAND_COUNT] = {\n'
+        for cmd_name, _, _ in self.gipaCommands():
+            lookup += '    "%s",\n' % cmd_name
+        lookup += '};\n\n'
+        lookup += '// Find the LoaderGipaCommandIndex for a command name.  Returns false for names the loader does not know.\n'
+        lookup += 'static bool LoaderGenFindGipaCommand(const char* name, uint32_t& command) {\n'
+        lookup += '    uint32_t low = 0;\n'
+        lookup += '    uint32_t high = LOADER_GIPA_COMMAND_COUNT;\n'
+        lookup += '    while (low < high) {\n'
+        lookup += '        uint32_t middle = low + (high - low) / 2;\n'
+        lookup += '        int compare = strcmp(name, g_gipa_command_names[middle]);\n'
+        lookup += '        if (compare == 0) {\n'
+        lookup += '            command = middle;\n'
+        lookup += '            return true;\n'
+        lookup += '        }\n'
+        lookup += '        if (compare < 0) {\n'
+        lookup += '            high = middle;\n'
+        lookup += '        } else {\n'
+        lookup += '            low = middle + 1;\n'
+        lookup += '        }\n'
+        lookup += '    }\n'
+        lookup += '    return false;\n'
+        lookup += '}\n\n'
+        return lookup
+
     # Output the source of all the loader export functions.  This includes:
     #  - The Loader's xrGetInstanceProcAddr trampoline
     #  - The Loader's xrGetInstanceProcAddr terminator
@@ -592,6 +874,7 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
         cur_extension_name = ''
 
         export_funcs = '\n'
+        export_funcs += self.outputLoaderGipaCommandLookup()
         export_funcs += 'LOADER_EXPORT XRAPI_ATTR XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instance, const char* name,\n'
         export_funcs += '                                                                   PFN_xrVoidFunction* function) XRLOADER_ABI_TRY {\n'
         indent = 1
@@ -623,7 +906,9 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
         export_funcs += 'if (name[0] == \'x\' && name[1] == \'r\') {\n'
         indent = indent + 1
         export_funcs += self.writeIndent(indent)
-        export_funcs += 'std::string func_name = &name[2];\n'
+        export_funcs += 'uint32_t command = LOADER_GIPA_COMMAND_COUNT;\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += 'const bool known_command = LoaderGenFindGipaCommand(name, command);\n'
         export_funcs += self.writeIndent(indent)
         export_funcs += 'LoaderInstance * const loader_instance = g_instance_map.Get(instance);\n'
         export_funcs += self.writeIndent(indent)
@@ -632,11 +917,11 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
         export_funcs += self.writeIndent(indent)
         export_funcs += '// Null instance is allowed for 3 specific API entry points, otherwise return error\n'
         export_funcs += self.writeIndent(indent)
-        export_funcs += 'if (!((func_name == "CreateInstance") ||\n'
+        export_funcs += 'if (!((command == LOADER_GIPA_COMMAND_xrCreateInstance) ||\n'
         export_funcs += self.writeIndent(indent)
-        export_funcs += '      (func_name == "EnumerateApiLayerProperties") ||\n'
+        export_funcs += '      (command == LOADER_GIPA_COMMAND_xrEnumerateApiLayerProperties) ||\n'
         export_funcs += self.writeIndent(indent)
-        export_funcs += '      (func_name == "EnumerateInstanceExtensionProperties"))) {\n'
+        export_funcs += '      (command == LOADER_GIPA_COMMAND_xrEnumerateInstanceExtensionProperties))) {\n'
         indent = indent + 1
         export_funcs += self.writeIndent(indent)
         export_funcs += 'std::string error_str = "XR_NULL_HANDLE for instance but query for ";\n'
@@ -674,8 +959,29 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
         indent = indent - 1
         export_funcs += self.writeIndent(indent)
         export_funcs += '}\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += 'if (!known_command) {\n'
+        export_funcs += self.writeIndent(indent + 1)
+        export_funcs += 'return XR_ERROR_FUNCTION_UNSUPPORTED;\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += '}\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += '// The answer for a command never changes over the life of an instance, so only work it out once.\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += 'if (loader_instance != nullptr) {\n'
+        export_funcs += self.writeIndent(indent + 1)
+        export_funcs += '*function = loader_instance->CachedProcAddr(command);\n'
+        export_funcs += self.writeIndent(indent + 1)
+        export_funcs += 'if (*function != nullptr) {\n'
+        export_funcs += self.writeIndent(indent + 2)
+        export_funcs += 'return XR_SUCCESS;\n'
+        export_funcs += self.writeIndent(indent + 1)
+        export_funcs += '}\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += '}\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += 'switch (command) {\n'
 
-        count = 0
         for x in range(0, 2):
             if x == 0:
                 commands = self.core_commands
@@ -695,50 +1001,60 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                         export_funcs += '// ---- %s extension commands\n\n' % cur_cmd.ext_name
                     cur_extension_name = cur_cmd.ext_name
 
-                # Remove 'xr' from proto name
-                base_name = cur_cmd.name[2:]
-
                 if cur_cmd.protect_value:
                     export_funcs += '#if %s\n' % cur_cmd.protect_string
 
-                if count == 0:
-                    export_funcs += self.writeIndent(indent)
-                    export_funcs += 'if (func_name == "%s") {\n' % (base_name)
-                else:
-                    export_funcs += self.writeIndent(indent)
-                    export_funcs += '} else if (func_name == "%s") {\n' % (
-                        base_name)
+                export_funcs += self.writeIndent(indent)
+                export_funcs += 'case LOADER_GIPA_COMMAND_%s:\n' % cur_cmd.name
                 indent = indent + 1
-                count = count + 1
 
                 # Instance commands always need to start with trampoline to properly de-reference instance
                 if self.isCoreExtensionName(cur_cmd.ext_name):
-                    if cur_cmd.has_instance or cur_cmd.name in MANUAL_LOADER_FUNCS:
-                        export_funcs += self.writeIndent(indent)
-                        export_funcs += '*function = reinterpret_cast<PFN_xrVoidFunction>(%s);\n' % (
-                            cur_cmd.name)
-                    else:
-                        export_funcs += self.writeIndent(indent)
-                        export_funcs += '*function = reinterpret_cast<PFN_xrVoidFunction>(loader_instance->DispatchTable()->%s);\n' % (
-                            base_name)
+                    export_funcs += self.outputGipaFunctionAssignment(indent, cur_cmd)
                 else:
                     export_funcs += self.writeIndent(indent)
-                    export_funcs += 'if (loader_instance->ExtensionIsEnabled("%s")) {\n' % (
-                        cur_cmd.ext_name)
-                    export_funcs += self.writeIndent(indent + 1)
-                    if cur_cmd.has_instance or cur_cmd.name in MANUAL_LOADER_FUNCS:
-                        export_funcs += '*function = reinterpret_cast<PFN_xrVoidFunction>(%s);\n' % (
-                            cur_cmd.name)
-                    else:
-                        export_funcs += '*function = reinterpret_cast<PFN_xrVoidFunction>(loader_instance->DispatchTable()->%s);\n' % (
-                            base_name)
+                    export_funcs += 'if (loader_instance->ExtensionIsEnabled(%s)) {\n' % (
+                        self.makeExtensionIndexName(cur_cmd.ext_name))
+                    export_funcs += self.outputGipaFunctionAssignment(indent + 1, cur_cmd)
                     export_funcs += self.writeIndent(indent)
                     export_funcs += '}\n'
+                export_funcs += self.writeIndent(indent)
+                export_funcs += 'break;\n'
 
                 if cur_cmd.protect_value:
                     export_funcs += '#endif // %s\n' % cur_cmd.protect_string
 
                 indent = indent - 1
+
+        # Extensions the loader implements that are not in the registry.
+        cur_extension_name = ''
+        for ext_name, cmd_name in LOADER_ONLY_EXTENSION_COMMANDS:
+            if ext_name != cur_extension_name:
+                export_funcs += '\n'
+                export_funcs += self.writeIndent(indent)
+                export_funcs += '// ---- %s loader-only extension commands\n\n' % ext_name
+                cur_extension_name = ext_name
+            export_funcs += self.writeIndent(indent)
+            export_funcs += 'case LOADER_GIPA_COMMAND_%s:\n' % cmd_name
+            export_funcs += self.writeIndent(indent + 1)
+            export_funcs += 'if (loader_instance->ExtensionIsEnabled(%s)) {\n' % self.makeExtensionIndexName(ext_name)
+            export_funcs += self.writeIndent(indent + 2)
+            export_funcs += '*function = reinterpret_cast<PFN_xrVoidFunction>(%s);\n' % cmd_name
+            export_funcs += self.writeIndent(indent + 1)
+            export_funcs += '}\n'
+            export_funcs += self.writeIndent(indent + 1)
+            export_funcs += 'break;\n'
+        export_funcs += '\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += 'default:\n'
+        export_funcs += self.writeIndent(indent + 1)
+        export_funcs += 'break;\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += '}\n'
+        export_funcs += self.writeIndent(indent)
+        export_funcs += 'if (loader_instance != nullptr && *function != nullptr) {\n'
+        export_funcs += self.writeIndent(indent + 1)
+        export_funcs += 'loader_instance->CacheProcAddr(command, *function);\n'
         export_funcs += self.writeIndent(indent)
         export_funcs += '}\n'
         indent = indent - 1
@@ -811,8 +1127,10 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
         export_funcs += '}\n'
         export_funcs += 'XRLOADER_ABI_CATCH_FALLBACK\n\n'
 
-        export_funcs += '// Instance Init Dispatch Table (put all terminators in first)\n'
-        export_funcs += 'void LoaderGenInitInstanceDispatchTable(XrInstance instance, std::unique_ptr<XrGeneratedDispatchTable>& table) {\n'
+        export_funcs += '// Instance Init Dispatch Table (put all terminators in first).  With lazy set, the commands\n'
+        export_funcs += '// that can be are left to their LoaderGenLazy thunks to look up when first called.\n'
+        export_funcs += 'void LoaderGenInitInstanceDispatchTable(XrInstance instance, std::unique_ptr<XrGeneratedDispatchTable>& table,\n'
+        export_funcs += '                                        bool lazy) {\n'
 
         count = 0
         for x in range(0, 2):
@@ -837,6 +1155,13 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
                 if cur_cmd.name in self.no_trampoline_or_terminator:
                     export_funcs += '    table->%s = nullptr;\n' % base_name
+                elif self.isLazyDispatchCommand(cur_cmd):
+                    export_funcs += '    if (lazy) {\n'
+                    export_funcs += '        table->%s = LoaderGenLazy%s;\n' % (base_name, base_name)
+                    export_funcs += '    } else {\n'
+                    export_funcs += '        LoaderXrTermGetInstanceProcAddr(instance, "%s", reinterpret_cast<PFN_xrVoidFunction*>(&table->%s));\n' % (
+                        cur_cmd.name, base_name)
+                    export_funcs += '    }\n'
                 else:
                     export_funcs += '    LoaderXrTermGetInstanceProcAddr(instance, "%s", reinterpret_cast<PFN_xrVoidFunction*>(&table->%s));\n' % (
                         cur_cmd.name, base_name)
@@ -844,8 +1169,10 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 if cur_cmd.protect_value:
                     export_funcs += '#endif // %s\n' % cur_cmd.protect_string
         export_funcs += '}\n\n'
-        export_funcs += '// Instance Update Dispatch Table with an API Layer Interface\n'
-        export_funcs += 'void ApiLayerInterface::GenUpdateInstanceDispatchTable(XrInstance instance, std::unique_ptr<XrGeneratedDispatchTable>& table) {\n'
+        export_funcs += '// Instance Update Dispatch Table with an API Layer Interface, through DispatchGetInstanceProcAddr.\n'
+        export_funcs += '// With lazy set, the entries left to LoaderGenLazy thunks are skipped: the thunks ask the layers themselves.\n'
+        export_funcs += 'void ApiLayerInterface::GenUpdateInstanceDispatchTable(XrInstance instance, std::unique_ptr<XrGeneratedDispatchTable>& table,\n'
+        export_funcs += '                                                       bool lazy) {\n'
         export_funcs += '    PFN_xrVoidFunction cur_func_ptr;\n'
         count = 0
         for x in range(0, 2):
@@ -870,9 +1197,17 @@ class LoaderSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
                 if cur_cmd.name not in self.no_trampoline_or_terminator:
                     if cur_cmd.name == 'xrGetInstanceProcAddr':
-                        export_funcs += '    table->GetInstanceProcAddr = _get_instant_proc_addr;\n'
+                        export_funcs += '    table->GetInstanceProcAddr = _dispatch_get_instance_proc_addr;\n'
+                    elif self.isLazyDispatchCommand(cur_cmd):
+                        export_funcs += '    if (!lazy) {\n'
+                        export_funcs += '        _dispatch_get_instance_proc_addr(instance, "%s", &cur_func_ptr);\n' % cur_cmd.name
+                        export_funcs += '        if (nullptr != cur_func_ptr) {\n'
+                        export_funcs += '            table->%s = reinterpret_cast<PFN_%s>(cur_func_ptr);\n' % (
+                            base_name, cur_cmd.name)
+                        export_funcs += '        }\n'
+                        export_funcs += '    }\n'
                     else:
-                        export_funcs += '    _get_instant_proc_addr(instance, "%s", &cur_func_ptr);\n' % cur_cmd.name
+                        export_funcs += '    _dispatch_get_instance_proc_addr(instance, "%s", &cur_func_ptr);\n' % cur_cmd.name
                         export_funcs += '    if (nullptr != cur_func_ptr) {\n'
                         export_funcs += '        table->%s = reinterpret_cast<PFN_%s>(cur_func_ptr);\n' % (
                             base_name, cur_cmd.name)
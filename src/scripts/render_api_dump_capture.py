@@ -0,0 +1,300 @@
+#!/usr/bin/python3
+#
+# Copyright (c) 2017-2019 The Khronos Group Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Renders a capture written by the API dump layer when XR_API_DUMP_EXPORT_TYPE is "compact", producing the same text or
+# HTML output the layer would have written itself.  The file layout is described with the compact capture utilities in
+# src/api_layers/api_dump.cpp.
+
+import getopt
+import struct
+import sys
+
+MAGIC = 0x44415258
+VERSION = 1
+HEADER_SIZE = 8
+STRING_RECORD = 1
+COMMAND_RECORD = 2
+
+HTML_HEADER = """<!doctype html>
+<html>
+    <head>
+        <title>OpenXR API Dump</title>
+        <style type='text/css'>
+        html {
+            background-color: #0b1e48;
+            background-image: url('https://vulkan.lunarg.com/img/bg-starfield.jpg');
+            background-position: center;
+            -webkit-background-size: cover;
+            -moz-background-size: cover;
+            -o-background-size: cover;
+            background-size: cover;
+            background-attachment: fixed;
+            background-repeat: no-repeat;
+            height: 100%;
+        }
+        #header {
+            z-index: -1;
+        }
+        #header>img {
+            position: absolute;
+            width: 160px;
+            margin-left: -280px;
+            top: -10px;
+            left: 50%;
+        }
+        #header>h1 {
+            font-family: Arial, 'Helvetica Neue', Helvetica, sans-serif;
+            font-size: 44px;
+            font-weight: 200;
+            text-shadow: 4px 4px 5px #000;
+            color: #eee;
+            position: absolute;
+            width: 400px;
+            margin-left: -80px;
+            top: 8px;
+            left: 50%;
+        }
+        body {
+            font-family: Consolas, monaco, monospace;
+            font-size: 14px;
+            line-height: 20px;
+            color: #eee;
+            height: 100%;
+            margin: 0;
+            overflow: hidden;
+        }
+        #wrapper {
+            background-color: rgba(0, 0, 0, 0.7);
+            border: 1px solid #446;
+            box-shadow: 0px 0px 10px #000;
+            padding: 8px 12px;
+            display: inline-block;
+            position: absolute;
+            top: 80px;
+            bottom: 25px;
+            left: 50px;
+            right: 50px;
+            overflow: auto;
+        }
+        details>*:not(summary) {
+            margin-left: 22px;
+        }
+        summary:only-child {
+            display: block;
+            padding-left: 15px;
+        }
+        details>summary:only-child::-webkit-details-marker {
+            display: none;
+            padding-left: 15px;
+        }
+        .headervar, .headertype, .headerval {
+            display: inline;
+            margin: 0 9px;
+        }
+        .var, .type, .val {
+            display: inline;
+            margin: 0 6px;
+        }
+        .headertype, .type {
+            color: #acf;
+        }
+        .headerval, .val {
+            color: #afa;
+            text-align: right;
+        }
+        .thd {
+            color: #888;
+        }
+        </style>
+    </head>
+    <body>
+        <div id='header'>
+            <img src='https://lunarg.com/wp-content/uploads/2016/02/LunarG-wReg-150.png' />
+            <h1>OpenXR API Dump</h1>
+        </div>
+        <div id='wrapper'>
+"""
+
+HTML_FOOTER = ("        </div>\n"
+               "    </body>\n"
+               "</html>")
+
+def read_commands(data):
+    if len(data) < HEADER_SIZE:
+        raise ValueError('file is too short to be an API dump capture')
+    # The file is in the byte order of the machine that wrote it
+    for order in ['<', '>']:
+        if struct.unpack_from(order + 'I', data, 0)[0] == MAGIC:
+            break
+    else:
+        raise ValueError('file is not an API dump capture')
+    version = struct.unpack_from(order + 'I', data, 4)[0]
+    if version != VERSION:
+        raise ValueError('unsupported API dump capture version %d' % version)
+
+    strings = {}
+    offset = HEADER_SIZE
+    # Stop at the first incomplete record, which is where the application stopped if it did not shut down cleanly
+    while offset + 8 <= len(data):
+        size, kind = struct.unpack_from(order + 'II', data, offset)
+        if size < 8 or offset + size > len(data):
+            break
+        payload = offset + 8
+        if kind == STRING_RECORD:
+            string_id, length = struct.unpack_from(order + 'II', data, payload)
+            strings[string_id] = data[payload + 8:payload + 8 + length].decode('utf-8', 'replace')
+        elif kind == COMMAND_RECORD:
+            entry_count = struct.unpack_from(order + 'I', data, payload)[0]
+            position = payload + 4
+            contents = []
+            for _ in range(entry_count):
+                type_id, name_id, length = struct.unpack_from(order + 'III', data, position)
+                position += 12
+                value = data[position:position + length].decode('utf-8', 'replace')
+                position += length
+                contents.append((strings.get(type_id, ''), strings.get(name_id, ''), value))
+            yield contents
+        offset += size
+
+def write_text(contents, out):
+    for index, (content_type, content_name, content_value) in enumerate(contents):
+        if index != 0:
+            out.write('    ')
+        if content_value:
+            out.write('%s %s = %s\n' % (content_type, content_name, content_value))
+        else:
+            out.write('%s %s\n' % (content_type, content_name))
+
+def deref_count(content_name):
+    return content_name.count('.') + content_name.count('->') + content_name.count('[')
+
+def write_html(contents, out):
+    out.write("<details class='data'>\n")
+    prefixes = []
+    last_deref_count = 0
+    for index, (content_type, content_name, content_value) in enumerate(contents):
+        if index == 0:
+            out.write("   <summary>\n"
+                      "      <div class='headertype'>%s</div>\n"
+                      "      <div class='headervar'>%s</div>\n"
+                      "   </summary>\n" % (content_type, content_name))
+            continue
+
+        cur_deref_count = deref_count(content_name)
+        next_deref_count = 0
+        if index < len(contents) - 1:
+            next_deref_count = deref_count(contents[index + 1][1])
+
+        # Close up the detail sections of anything this is no longer a part of
+        while last_deref_count > cur_deref_count:
+            out.write('   </details>\n')
+            prefixes.pop()
+            last_deref_count -= 1
+
+        # Drop the part of the name that the enclosing section already shows
+        short_name = content_name
+        if cur_deref_count > 0:
+            for prefix in reversed(prefixes):
+                if content_name.startswith(prefix):
+                    additional_offset = len(prefix) + 1
+                    if content_name[additional_offset - 1] == '-':
+                        additional_offset += 1
+                    elif content_name[additional_offset - 1] == '[':
+                        additional_offset -= 1
+                    short_name = content_name[additional_offset:]
+                    break
+
+        writing_summary = cur_deref_count < next_deref_count
+        if writing_summary:
+            out.write("   <details class='data'>\n"
+                      "      <summary>\n")
+            prefixes.append(content_name)
+        else:
+            out.write("      <div class='data'>\n")
+
+        out.write("         <div class='type'>%s</div>\n"
+                  "         <div class='var'>%s</div>\n" % (content_type, short_name))
+        value_needs_printing = True
+        if 'char' in content_type and content_type.count('*') + content_type.count('[') < 2:
+            out.write("         <div class='val'>\"%s\"</div>" % content_value)
+            value_needs_printing = False
+        if content_value and value_needs_printing:
+            out.write("         <div class='val'>%s</div>" % content_value)
+        out.write('\n')
+
+        if writing_summary:
+            out.write('      </summary>\n')
+        else:
+            out.write('      </div>\n')
+        last_deref_count = cur_deref_count
+
+    while last_deref_count > 0:
+        out.write('   </details>\n')
+        prefixes.pop()
+        last_deref_count -= 1
+    out.write('</details>\n')
+
+def render(data, output_format, out):
+    if output_format == 'html':
+        out.write(HTML_HEADER)
+        for contents in read_commands(data):
+            write_html(contents, out)
+        out.write(HTML_FOOTER)
+    else:
+        for contents in read_commands(data):
+            write_text(contents, out)
+
+def main(argv):
+    output_file = ''
+    output_format = 'text'
+
+    usage =  '\nrender_api_dump_capture.py <ARGS> <capture file>\n'
+    usage += '    -f/--format <text|html>\n'
+    usage += '    -o/--output <filename>\n'
+
+    try:
+        opts, args = getopt.getopt(argv,"hf:o:",["format=","output="])
+    except getopt.GetoptError:
+        print(usage)
+        sys.exit(2)
+    for opt, arg in opts:
+        if opt == '-h':
+            print(usage)
+            sys.exit()
+        elif opt in ("-f", "--format"):
+            output_format = arg.lower()
+        elif opt in ("-o", "--output"):
+            output_file = arg
+
+    if len(args) != 1 or output_format not in ['text', 'html']:
+        print(usage)
+        sys.exit(2)
+
+    with open(args[0], 'rb') as capture_file:
+        data = capture_file.read()
+
+    try:
+        if output_file:
+            with open(output_file, 'w', newline='') as out:
+                render(data, output_format, out)
+        else:
+            render(data, output_format, sys.stdout)
+    except ValueError as error:
+        print('%s: %s' % (args[0], error))
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
@@ -29,6 +29,30 @@ from generator import write
 # UtilitySourceOutputGenerator - subclass of AutomaticSourceOutputGenerator.
 
 
+# The commands an application calls every frame.  The dispatch table puts these first, in
+# this order, so that all of them share the same couple of cache lines (sixteen pointers fill
+# two 64-byte lines on a 64-bit target) instead of being spread across the whole table.  The
+# rest of the table is only touched during setup, teardown or when an extension is used.
+FRAME_LOOP_COMMANDS = (
+    'xrWaitFrame',
+    'xrBeginFrame',
+    'xrEndFrame',
+    'xrLocateViews',
+    'xrLocateSpace',
+    'xrAcquireSwapchainImage',
+    'xrWaitSwapchainImage',
+    'xrReleaseSwapchainImage',
+    'xrSyncActions',
+    'xrGetActionStateBoolean',
+    'xrGetActionStateFloat',
+    'xrGetActionStateVector2f',
+    'xrGetActionStatePose',
+    'xrApplyHapticFeedback',
+    'xrStopHapticFeedback',
+    'xrPollEvent',
+)
+
+
 class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
     """Generate loader source using XML element attributes from registry"""
 
@@ -105,6 +129,17 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
         table += '// Generated dispatch table\n'
         table += 'struct XrGeneratedDispatchTable {\n'
 
+        # The per-frame commands come first, kept together regardless of which feature
+        # they belong to.
+        frame_commands = {}
+        for cur_cmd in self.core_commands + self.ext_commands:
+            if cur_cmd.name in FRAME_LOOP_COMMANDS:
+                frame_commands[cur_cmd.name] = cur_cmd
+        table += '    // ---- Per-frame commands, kept together at the start of the table\n'
+        for name in FRAME_LOOP_COMMANDS:
+            if name in frame_commands:
+                table += self.outputDispatchTableMember(frame_commands[name])
+
         # Loop through both core commands, and extension commands
         # Outputting the core commands first, and then the extension commands.
         for x in range(0, 2):
@@ -114,6 +149,9 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
                 commands = self.ext_commands
 
             for cur_cmd in commands:
+                if cur_cmd.name in frame_commands:
+                    continue
+
                 # If we've switched to a new "feature" print out a comment on what it is.  Usually,
                 # this is a group of core commands or a group of commands in an extension.
                 if cur_cmd.ext_name != cur_extension_name:
@@ -124,21 +162,30 @@ class UtilitySourceOutputGenerator(AutomaticSourceOutputGenerator):
                         table += '\n    // ---- %s extension commands\n' % cur_cmd.ext_name
                     cur_extension_name = cur_cmd.ext_name
 
-                # Remove 'xr' from proto name
-                base_name = cur_cmd.name[2:]
+                table += self.outputDispatchTableMember(cur_cmd)
+        table += '};\n\n'
+        return table
 
-                # If a protect statement exists, use it.
-                if cur_cmd.protect_value:
-                    table += '#if %s\n' % cur_cmd.protect_string
+    # Write out the function pointer member for one command in the Dispatch table
+    #   self            the UtilitySourceOutputGenerator object
+    #   cur_cmd         the command to write the member for
+    def outputDispatchTableMember(self, cur_cmd):
+        member = ''
 
-                # Write out each command using it's function pointer for each command
-                table += '    PFN_%s %s;\n' % (cur_cmd.name, base_name)
+        # Remove 'xr' from proto name
+        base_name = cur_cmd.name[2:]
 
-                # If a protect statement exists, wrap it up.
-                if cur_cmd.protect_value:
-                    table += '#endif // %s\n' % cur_cmd.protect_string
-        table += '};\n\n'
-        return table
+        # If a protect statement exists, use it.
+        if cur_cmd.protect_value:
+            member += '#if %s\n' % cur_cmd.protect_string
+
+        # Write out each command using it's function pointer for each command
+        member += '    PFN_%s %s;\n' % (cur_cmd.name, base_name)
+
+        # If a protect statement exists, wrap it up.
+        if cur_cmd.protect_value:
+            member += '#endif // %s\n' % cur_cmd.protect_string
+        return member
 
     # Write out the helper function that will populate a dispatch table using
     # an instance handle and a corresponding xrGetInstanceProcAddr command.
@@ -190,17 +190,19 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         next_chain_info += '    NEXT_CHAIN_RESULT_DUPLICATE_STRUCT = -2,\n'
         next_chain_info += '};\n\n'
         next_chain_info += '// Prototype for validateNextChain command (it uses the validate structure commands so add it after\n'
+        next_chain_info += '// Each bit of duplicate_ext_structs set on return is the index in valid_ext_structs of a type that\n'
+        next_chain_info += '// appears more than once in the chain.\n'
         next_chain_info += 'NextChainResult ValidateNextChain(GenValidUsageXrInstanceInfo *instance_info,\n'
         next_chain_info += '                                  const std::string &command_name,\n'
         next_chain_info += '                                  std::vector<GenValidUsageXrObjectInfo>& objects_info,\n'
         next_chain_info += '                                  const void* next,\n'
-        next_chain_info += '                                  std::vector<XrStructureType>& valid_ext_structs,\n'
-        next_chain_info += '                                  std::vector<XrStructureType>& encountered_structs,\n'
-        next_chain_info += '                                  std::vector<XrStructureType>& duplicate_structs);\n\n'
+        next_chain_info += '                                  const XrStructureType* valid_ext_structs,\n'
+        next_chain_info += '                                  uint32_t valid_ext_struct_count,\n'
+        next_chain_info += '                                  uint64_t& duplicate_ext_structs);\n\n'
         return next_chain_info
 
-    # Generate C++ enum and utility function prototypes for validating
-    # the flags in structures.
+    # Generate C++ functions for validating flags.  Every valid bit of a flag is known when
+    # the code is generated, so a value is checked against one mask instead of bit by bit.
     #   self            the ValidationSourceOutputGenerator object
     def outputValidationSourceFlagBitValues(self):
         flag_value_validate = ''
@@ -221,22 +223,19 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             if flag_tuple.valid_flags is None:
                 flag_value_validate += '    return VALIDATE_XR_FLAGS_INVALID;\n'
             else:
-                # This flag has values set.  So, check (and remove) each valid value.  Once that's done
-                # anything left over would be invalid.
-                flag_value_validate += '    %s int_value = value;\n' % flag_tuple.type
+                # This flag has values set.  So, anything outside of the mask of all of them is invalid.
+                flag_value_validate += '    const %s valid_bits = 0\n' % flag_tuple.type
                 for mask_tuple in self.api_bitmasks:
                     if mask_tuple.name == flag_tuple.valid_flags:
                         for cur_value in mask_tuple.values:
                             if cur_value.protect_value and flag_tuple.protect_value != cur_value.protect_value:
                                 flag_value_validate += '#if %s\n' % cur_value.protect_string
-                            flag_value_validate += '    if ((int_value & %s) != 0) {\n' % cur_value.name
-                            flag_value_validate += '        // Clear the value %s since it is valid\n' % cur_value.name
-                            flag_value_validate += '        int_value &= ~%s;\n' % cur_value.name
-                            flag_value_validate += '    }\n'
+                            flag_value_validate += '        | %s\n' % cur_value.name
                             if cur_value.protect_value and flag_tuple.protect_value != cur_value.protect_value:
                                 flag_value_validate += '#endif // %s\n' % cur_value.protect_string
                         break
-                flag_value_validate += '    if (int_value != 0) {\n'
+                flag_value_validate += '        ;\n'
+                flag_value_validate += '    if ((value & ~valid_bits) != 0) {\n'
                 flag_value_validate += '        // Something is left, it must be invalid\n'
                 flag_value_validate += '        return VALIDATE_XR_FLAGS_INVALID;\n'
                 flag_value_validate += '    }\n'
@@ -246,7 +245,98 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 flag_value_validate += '#endif // %s\n' % flag_tuple.protect_string
         return flag_value_validate
 
-    # Generate C++ functions for validating enums.
+    # Determine every extension the generated code may check is enabled: those in the registry, plus any
+    # that only an enum, enum value or structure refers to.  Sorted, they give the GenValidUsageExtension values.
+    #   self            the ValidationSourceOutputGenerator object
+    def validationExtensionNames(self):
+        extensions = set(extension.name for extension in self.extensions)
+        for enum_tuple in self.api_enums:
+            extensions.add(enum_tuple.ext_name)
+            for cur_value in enum_tuple.values:
+                extensions.add(cur_value.ext_name)
+        for xr_struct in self.api_structures:
+            extensions.add(xr_struct.ext_name)
+        for cur_cmd in self.ext_commands:
+            extensions.update(cur_cmd.required_exts)
+        return sorted(ext_name for ext_name in extensions if ext_name and not self.isCoreExtensionName(ext_name))
+
+    # Name of the GenValidUsageExtension value for an extension
+    #   self            the ValidationSourceOutputGenerator object
+    #   ext_name        the name of the extension
+    def makeExtensionBitName(self, ext_name):
+        return 'GEN_VALID_USAGE_EXTENSION_%s' % ext_name.upper()
+
+    # Generate the table of extensions that validation checks, and the function that turns an instance's
+    # enabled extension names into bits, so that checking an extension never compares strings.
+    #   self            the ValidationSourceOutputGenerator object
+    def outputValidationSourceExtensionBits(self):
+        extensions = self.validationExtensionNames()
+        extension_bits = '// Every extension validation checks, in order of name, each one a bit in\n'
+        extension_bits += '// GenValidUsageXrInstanceInfo::enabled_extension_bits\n'
+        extension_bits += 'enum GenValidUsageExtension {\n'
+        for ext_name in extensions:
+            extension_bits += '    %s,\n' % self.makeExtensionBitName(ext_name)
+        extension_bits += '    GEN_VALID_USAGE_EXTENSION_COUNT,\n'
+        extension_bits += '    // Used for enum values that do not require an extension\n'
+        extension_bits += '    GEN_VALID_USAGE_EXTENSION_NONE = GEN_VALID_USAGE_EXTENSION_COUNT,\n'
+        extension_bits += '};\n\n'
+        extension_bits += 'static const char* const kGenValidUsageExtensionNames[GEN_VALID_USAGE_EXTENSION_COUNT] = {\n'
+        for ext_name in extensions:
+            extension_bits += '    "%s",\n' % ext_name
+        extension_bits += '};\n\n'
+        extension_bits += 'void GenValidUsageSetEnabledExtensionBits(GenValidUsageXrInstanceInfo *instance_info) {\n'
+        extension_bits += '    instance_info->enabled_extension_bits.assign(GEN_VALID_USAGE_EXTENSION_COUNT, false);\n'
+        extension_bits += '    for (const auto &enabled_extension : instance_info->enabled_extensions) {\n'
+        extension_bits += '        for (uint32_t extension = 0; extension < GEN_VALID_USAGE_EXTENSION_COUNT; ++extension) {\n'
+        extension_bits += '            if (enabled_extension == kGenValidUsageExtensionNames[extension]) {\n'
+        extension_bits += '                instance_info->enabled_extension_bits[extension] = true;\n'
+        extension_bits += '            }\n'
+        extension_bits += '        }\n'
+        extension_bits += '    }\n'
+        extension_bits += '}\n\n'
+        extension_bits += 'static inline bool GenValidUsageExtensionBitEnabled(const GenValidUsageXrInstanceInfo *instance_info,\n'
+        extension_bits += '                                                    uint32_t extension) {\n'
+        extension_bits += '    return extension < instance_info->enabled_extension_bits.size() &&\n'
+        extension_bits += '           instance_info->enabled_extension_bits[extension];\n'
+        extension_bits += '}\n\n'
+        return extension_bits
+
+    # Generate the lines logging an enum, or enum value, that requires an extension which is not enabled.
+    #   self            the ValidationSourceOutputGenerator object
+    #   indent          the number of "tabs" to space in for the resulting C+ code.
+    #   error_str       the C++ code building the start of the error string
+    #   ext_name_str    the C++ expression for the extension name
+    def writeEnumExtensionNotEnabled(self, indent, error_str, ext_name_str):
+        enum_value_validate = self.writeIndent(indent)
+        enum_value_validate += 'std::string vuid = "VUID-";\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'vuid += validation_name;\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'vuid += "-";\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'vuid += item_name;\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'vuid += "-parameter";\n'
+        enum_value_validate += error_str
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'error_str += " \\"";\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'error_str += %s;\n' % ext_name_str
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'error_str += "\\" to be enabled, but it is not enabled";\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'CoreValidLogMessage(instance_info, vuid,\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += '                    VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name,\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += '                    objects_info, error_str);\n'
+        enum_value_validate += self.writeIndent(indent)
+        enum_value_validate += 'return false;\n'
+        return enum_value_validate
+
+    # Generate C++ functions for validating enums.  Each enum gets a table of its valid values,
+    # sorted by value, along with the extension each value requires, so that validating a value
+    # is a binary search followed by a check of one bit.
     #   self            the ValidationSourceOutputGenerator object
     def outputValidationSourceEnumValues(self):
         enum_value_validate = ''
@@ -260,6 +350,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             enum_value_validate += '                    const std::string &item_name,\n'
             enum_value_validate += '                    std::vector<GenValidUsageXrObjectInfo>& objects_info,\n'
             enum_value_validate += '                    const %s value) {\n' % enum_tuple.name
+            enum_value_validate += '    CoreValidationCheckTimer timer(CORE_VALIDATION_CHECK_ENUM);\n'
             indent = 1
             checked_extension = ''
             if enum_tuple.ext_name and not self.isCoreExtensionName(enum_tuple.ext_name):
@@ -267,95 +358,60 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 enum_value_validate += self.writeIndent(indent)
                 enum_value_validate += '// Enum requires extension %s, so check that it is enabled\n' % enum_tuple.ext_name
                 enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'if (nullptr != instance_info && !ExtensionEnabled(instance_info->enabled_extensions, "%s")) {\n' % enum_tuple.ext_name
-                indent += 1
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'std::string vuid = "VUID-";\n'
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'vuid += validation_name;\n'
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'vuid += "-";\n'
+                enum_value_validate += 'if (nullptr != instance_info &&\n'
                 enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'vuid += item_name;\n'
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'vuid += "-parameter";\n'
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'std::string error_str = "%s requires extension ";\n' % enum_tuple.name
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'error_str += " \\"%s\\" to be enabled, but it is not enabled";\n' % enum_tuple.ext_name
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'CoreValidLogMessage(instance_info, vuid,\n'
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += '                    VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name,\n'
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += '                    objects_info, error_str);\n'
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'return false;\n'
-                indent -= 1
+                enum_value_validate += '    !GenValidUsageExtensionBitEnabled(instance_info, %s)) {\n' % self.makeExtensionBitName(
+                    enum_tuple.ext_name)
+                error_str = self.writeIndent(indent + 1)
+                error_str += 'std::string error_str = "%s requires extension ";\n' % enum_tuple.name
+                enum_value_validate += self.writeEnumExtensionNotEnabled(indent + 1, error_str, '"%s"' % enum_tuple.ext_name)
                 enum_value_validate += self.writeIndent(indent)
                 enum_value_validate += '}\n'
             enum_value_validate += self.writeIndent(indent)
-            enum_value_validate += 'switch (value) {\n'
-            indent += 1
+            enum_value_validate += 'static const GenValidUsageEnumValue values[] = {\n'
             for cur_value in enum_tuple.values:
+                # XR_TYPE_UNKNOWN is never a valid XrStructureType, so leave it out of the table
+                if cur_value.name == 'XR_TYPE_UNKNOWN':
+                    continue
                 if cur_value.protect_value and enum_tuple.protect_value != cur_value.protect_value:
                     enum_value_validate += '#if %s\n' % cur_value.protect_string
-                enum_value_validate += self.writeIndent(indent)
-                enum_value_validate += 'case %s:\n' % cur_value.name
+                extension = 'GEN_VALID_USAGE_EXTENSION_NONE'
+                if cur_value.ext_name and cur_value.ext_name != checked_extension and not self.isCoreExtensionName(cur_value.ext_name):
+                    extension = self.makeExtensionBitName(cur_value.ext_name)
+                enum_value_validate += self.writeIndent(indent + 1)
+                enum_value_validate += '{%s, %s, "%s"},\n' % (cur_value.name, extension, cur_value.name)
                 if cur_value.protect_value and enum_tuple.protect_value != cur_value.protect_value:
                     enum_value_validate += '#endif // %s\n' % cur_value.protect_string
-                if cur_value.ext_name and cur_value.ext_name != checked_extension and not self.isCoreExtensionName(cur_value.ext_name):
-                    indent += 1
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += '// Enum value %s requires extension %s, so check that it is enabled\n' % (
-                        cur_value.name, cur_value.ext_name)
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'if (nullptr != instance_info && !ExtensionEnabled(instance_info->enabled_extensions, "%s")) {\n' % cur_value.ext_name
-                    indent += 1
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'std::string vuid = "VUID-";\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'vuid += validation_name;\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'vuid += "-";\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'vuid += item_name;\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'vuid += "-parameter";\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'std::string error_str = "%s value \\"%s\\"";\n' % (
-                        enum_tuple.name, cur_value.name)
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'error_str += " being used, which requires extension ";\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'error_str += " \\"%s\\" to be enabled, but it is not enabled";\n' % cur_value.ext_name
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'CoreValidLogMessage(instance_info, vuid,\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += '                    VALID_USAGE_DEBUG_SEVERITY_ERROR, command_name,\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += '                    objects_info, error_str);\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'return false;\n'
-                    indent -= 1
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += '}\n'
-                    enum_value_validate += self.writeIndent(indent)
-                    enum_value_validate += 'return true;\n'
-                    indent -= 1
-                elif cur_value.name == 'XR_TYPE_UNKNOWN':
-                    enum_value_validate += self.writeIndent(indent + 1)
-                    enum_value_validate += 'return false; // Invalid XrStructureType \n'
-                else:
-                    enum_value_validate += self.writeIndent(indent + 1)
-                    enum_value_validate += 'return true;\n'
-            indent -= 1
             enum_value_validate += self.writeIndent(indent)
-            enum_value_validate += 'default:\n'
+            enum_value_validate += '};\n'
+            enum_value_validate += self.writeIndent(indent)
+            enum_value_validate += 'static const GenValidUsageEnumTable table(values);\n'
+            enum_value_validate += self.writeIndent(indent)
+            enum_value_validate += 'const GenValidUsageEnumValue *found_value = table.find(static_cast<int32_t>(value));\n'
+            enum_value_validate += self.writeIndent(indent)
+            enum_value_validate += 'if (nullptr == found_value) {\n'
             enum_value_validate += self.writeIndent(indent + 1)
             enum_value_validate += 'return false;\n'
-            indent -= 1
+            enum_value_validate += self.writeIndent(indent)
             enum_value_validate += '}\n'
+            enum_value_validate += self.writeIndent(indent)
+            enum_value_validate += '// Some enum values require an extension, so check that it is enabled\n'
+            enum_value_validate += self.writeIndent(indent)
+            enum_value_validate += 'if (GEN_VALID_USAGE_EXTENSION_NONE != found_value->extension && nullptr != instance_info &&\n'
+            enum_value_validate += self.writeIndent(indent)
+            enum_value_validate += '    !GenValidUsageExtensionBitEnabled(instance_info, found_value->extension)) {\n'
+            error_str = self.writeIndent(indent + 1)
+            error_str += 'std::string error_str = "%s value \\"";\n' % enum_tuple.name
+            error_str += self.writeIndent(indent + 1)
+            error_str += 'error_str += found_value->name;\n'
+            error_str += self.writeIndent(indent + 1)
+            error_str += 'error_str += "\\" being used, which requires extension ";\n'
+            enum_value_validate += self.writeEnumExtensionNotEnabled(
+                indent + 1, error_str, 'kGenValidUsageExtensionNames[found_value->extension]')
+            enum_value_validate += self.writeIndent(indent)
+            enum_value_validate += '}\n'
+            enum_value_validate += self.writeIndent(indent)
+            enum_value_validate += 'return true;\n'
             enum_value_validate += '}\n\n'
             if enum_tuple.protect_value:
                 enum_value_validate += '#endif // %s\n' % enum_tuple.protect_string
@@ -397,63 +453,55 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         next_chain_info += '                                  const std::string &command_name,\n'
         next_chain_info += '                                  std::vector<GenValidUsageXrObjectInfo>& objects_info,\n'
         next_chain_info += '                                  const void* next,\n'
-        next_chain_info += '                                  std::vector<XrStructureType>& valid_ext_structs,\n'
-        next_chain_info += '                                  std::vector<XrStructureType>& encountered_structs,\n'
-        next_chain_info += '                                  std::vector<XrStructureType>& duplicate_structs) {\n'
+        next_chain_info += '                                  const XrStructureType* valid_ext_structs,\n'
+        next_chain_info += '                                  uint32_t valid_ext_struct_count,\n'
+        next_chain_info += '                                  uint64_t& duplicate_ext_structs) {\n'
+        next_chain_info += self.writeIndent(1)
+        next_chain_info += 'CoreValidationCheckTimer timer(CORE_VALIDATION_CHECK_NEXT_CHAIN);\n'
         next_chain_info += self.writeIndent(1)
         next_chain_info += 'NextChainResult return_result = NEXT_CHAIN_RESULT_VALID;\n'
         next_chain_info += self.writeIndent(1)
-        next_chain_info += '// NULL is valid\n'
+        next_chain_info += '// One bit for each of the valid extension structs, set once it has been seen in the chain\n'
         next_chain_info += self.writeIndent(1)
-        next_chain_info += 'if (nullptr == next) {\n'
-        next_chain_info += self.writeIndent(2)
-        next_chain_info += 'return return_result;\n'
+        next_chain_info += 'uint64_t encountered_structs = 0;\n'
         next_chain_info += self.writeIndent(1)
-        next_chain_info += '}\n'
+        next_chain_info += '// NULL is valid, and so is the end of the chain.  Non-NULL is not valid if there is no valid extension structs\n'
         next_chain_info += self.writeIndent(1)
-        next_chain_info += '// Non-NULL is not valid if there is no valid extension structs\n'
+        next_chain_info += 'for (const XrBaseInStructure* next_header = reinterpret_cast<const XrBaseInStructure*>(next);\n'
         next_chain_info += self.writeIndent(1)
-        next_chain_info += 'if (nullptr != next && 0 == valid_ext_structs.size()) {\n'
+        next_chain_info += '     nullptr != next_header; next_header = next_header->next) {\n'
+        next_chain_info += self.writeIndent(2)
+        next_chain_info += 'uint32_t valid_ext = 0;\n'
+        next_chain_info += self.writeIndent(2)
+        next_chain_info += 'while (valid_ext < valid_ext_struct_count && valid_ext_structs[valid_ext] != next_header->type) {\n'
+        next_chain_info += self.writeIndent(3)
+        next_chain_info += '++valid_ext;\n'
         next_chain_info += self.writeIndent(2)
-        next_chain_info += 'return NEXT_CHAIN_RESULT_ERROR;\n'
-        next_chain_info += self.writeIndent(1)
         next_chain_info += '}\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += 'const XrBaseInStructure* next_header = reinterpret_cast<const XrBaseInStructure*>(next);\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += 'auto valid_ext = std::find(valid_ext_structs.begin(), valid_ext_structs.end(), next_header->type);\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += 'if (valid_ext == valid_ext_structs.end()) {\n'
         next_chain_info += self.writeIndent(2)
+        next_chain_info += 'if (valid_ext == valid_ext_struct_count) {\n'
+        next_chain_info += self.writeIndent(3)
         next_chain_info += '// Not a valid extension structure type for this next chain.\n'
-        next_chain_info += self.writeIndent(2)
+        next_chain_info += self.writeIndent(3)
         next_chain_info += 'return NEXT_CHAIN_RESULT_ERROR;\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += '} else {\n'
+        next_chain_info += self.writeIndent(2)
+        next_chain_info += '}\n'
         next_chain_info += self.writeIndent(2)
         next_chain_info += '// Check to see if we\'ve already encountered this structure.\n'
         next_chain_info += self.writeIndent(2)
-        next_chain_info += 'auto already_encountered_ext = std::find(encountered_structs.begin(), encountered_structs.end(), next_header->type);\n'
+        next_chain_info += 'const uint64_t struct_bit = static_cast<uint64_t>(1) << valid_ext;\n'
         next_chain_info += self.writeIndent(2)
-        next_chain_info += 'if (already_encountered_ext != encountered_structs.end()) {\n'
+        next_chain_info += 'if (0 != (encountered_structs & struct_bit)) {\n'
         next_chain_info += self.writeIndent(3)
-        next_chain_info += '// Make sure we only put in unique types into our duplicate list.\n'
-        next_chain_info += self.writeIndent(3)
-        next_chain_info += 'auto already_duplicate = std::find(duplicate_structs.begin(), duplicate_structs.end(), next_header->type);\n'
-        next_chain_info += self.writeIndent(3)
-        next_chain_info += 'if (already_duplicate == duplicate_structs.end()) {\n'
-        next_chain_info += self.writeIndent(4)
-        next_chain_info += 'duplicate_structs.push_back(next_header->type);\n'
-        next_chain_info += self.writeIndent(3)
-        next_chain_info += '}\n'
+        next_chain_info += 'duplicate_ext_structs |= struct_bit;\n'
         next_chain_info += self.writeIndent(3)
         next_chain_info += 'return_result = NEXT_CHAIN_RESULT_DUPLICATE_STRUCT;\n'
         next_chain_info += self.writeIndent(2)
         next_chain_info += '}\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += '}\n'
+        next_chain_info += self.writeIndent(2)
+        next_chain_info += 'encountered_structs |= struct_bit;\n'
         # Validate the rest of this struct
-        next_chain_info += self.writeIndent(1)
+        next_chain_info += self.writeIndent(2)
         next_chain_info += 'switch (next_header->type) {\n'
         for enum_tuple in self.api_enums:
             if enum_tuple.name == 'XrStructureType':
@@ -466,50 +514,33 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                         struct_tuple = self.getStruct(struct_define_name)
                         if struct_tuple.protect_value:
                             next_chain_info += '#if %s\n' % struct_tuple.protect_string
-                        next_chain_info += self.writeIndent(2)
-                        next_chain_info += 'case %s:\n' % cur_value.name
                         next_chain_info += self.writeIndent(3)
+                        next_chain_info += 'case %s:\n' % cur_value.name
+                        next_chain_info += self.writeIndent(4)
                         next_chain_info += 'if (XR_SUCCESS != ValidateXrStruct(instance_info, command_name, objects_info, false,\n'
-                        next_chain_info += self.writeIndent(3)
-                        next_chain_info += '                                   reinterpret_cast<const %s*>(next))) {\n' % struct_define_name
                         next_chain_info += self.writeIndent(4)
+                        next_chain_info += '                                   reinterpret_cast<const %s*>(next_header))) {\n' % struct_define_name
+                        next_chain_info += self.writeIndent(5)
                         next_chain_info += 'return NEXT_CHAIN_RESULT_ERROR;\n'
-                        next_chain_info += self.writeIndent(3)
+                        next_chain_info += self.writeIndent(4)
                         next_chain_info += '}\n'
-                        next_chain_info += self.writeIndent(3)
+                        next_chain_info += self.writeIndent(4)
                         next_chain_info += 'break;\n'
                         if struct_tuple.protect_value:
                             next_chain_info += '#endif // %s\n' % struct_tuple.protect_string
                 if enum_tuple.protect_value:
                     next_chain_info += '#endif //%s\n' % enum_tuple.protect_string
                 break
-        next_chain_info += self.writeIndent(2)
-        next_chain_info += 'default:\n'
         next_chain_info += self.writeIndent(3)
+        next_chain_info += 'default:\n'
+        next_chain_info += self.writeIndent(4)
         next_chain_info += 'return NEXT_CHAIN_RESULT_ERROR;\n'
-        next_chain_info += self.writeIndent(1)
+        next_chain_info += self.writeIndent(2)
         next_chain_info += '}\n'
-        # Validate any chained structs
         next_chain_info += self.writeIndent(1)
-        next_chain_info += 'NextChainResult next_result = ValidateNextChain(instance_info, command_name,\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += '                                                objects_info, next_header->next,\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += '                                                valid_ext_structs,\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += '                                                encountered_structs,\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += '                                                duplicate_structs);\n'
+        next_chain_info += '}\n'
         next_chain_info += self.writeIndent(1)
-        next_chain_info += 'if (NEXT_CHAIN_RESULT_VALID == next_result && NEXT_CHAIN_RESULT_VALID != return_result) {\n'
-        next_chain_info += self.writeIndent(2)
         next_chain_info += 'return return_result;\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += '} else {\n'
-        next_chain_info += self.writeIndent(2)
-        next_chain_info += 'return next_result;\n'
-        next_chain_info += self.writeIndent(1)
-        next_chain_info += '}\n'
         next_chain_info += '}\n\n'
         return next_chain_info
 
@@ -523,9 +554,6 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validation_header_info = ''
         cur_extension_name = ''
 
-        validation_header_info += '// Unordered Map associating pointer to a vector of session label information to a session\'s handle\n'
-        validation_header_info += 'extern std::unordered_map<XrSession, std::vector<GenValidUsageXrInternalSessionLabel*>*> g_xr_session_labels;\n\n'
-
         for x in range(0, 2):
             if x == 0:
                 commands = self.core_commands
@@ -581,6 +609,11 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validation_header_info += '\n// Externs for Core Validation\n'
         validation_header_info += self.outputInfoMapDeclarations(extern=True)
         validation_header_info += 'void GenValidUsageCleanUpMaps(GenValidUsageXrInstanceInfo *instance_info);\n\n'
+        validation_header_info += '\n// Function to record which of the extensions checked by validation are enabled\n'
+        validation_header_info += 'void GenValidUsageSetEnabledExtensionBits(GenValidUsageXrInstanceInfo *instance_info);\n'
+
+        validation_header_info += '\n// The commands GenValidUsageXrGetInstanceProcAddr returns the layer\'s own functions for\n'
+        validation_header_info += 'const std::vector<const char*>& GenValidUsageInterceptedCommands();\n'
 
         validation_header_info += '\n// Function to convert XrObjectType to string\n'
         validation_header_info += 'std::string GenValidUsageXrObjectTypeToString(const XrObjectType& type);\n\n'
@@ -850,10 +883,10 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 verify_parent += '}\n'
         verify_parent += '    return false;\n'
         verify_parent += '}\n\n'
-        verify_parent += '// Implementation of VerifyXrParent function\n'
-        verify_parent += 'bool VerifyXrParent(XrObjectType handle1_type, const uint64_t handle1,\n'
-        verify_parent += '                    XrObjectType handle2_type, const uint64_t handle2,\n'
-        verify_parent += '                    bool check_this) {\n'
+        verify_parent += '// Walk up the parents of both handles to see whether they share one\n'
+        verify_parent += 'static bool VerifyXrParentChain(XrObjectType handle1_type, const uint64_t handle1,\n'
+        verify_parent += '                                XrObjectType handle2_type, const uint64_t handle2,\n'
+        verify_parent += '                                bool check_this) {\n'
         indent = 1
         verify_parent += self.writeIndent(indent)
         verify_parent += 'if (IsIntegerNullHandle(handle1) || IsIntegerNullHandle(handle2)) {\n'
@@ -879,7 +912,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         verify_parent += self.writeIndent(indent)
         verify_parent += '}\n'
         verify_parent += self.writeIndent(indent)
-        verify_parent += 'return VerifyXrParent(handle1_type, handle1, parent_type, parent_handle, true);\n'
+        verify_parent += 'return VerifyXrParentChain(handle1_type, handle1, parent_type, parent_handle, true);\n'
         indent -= 1
         verify_parent += self.writeIndent(indent)
         verify_parent += '} else if (handle2_type == XR_OBJECT_TYPE_INSTANCE && handle1_type != XR_OBJECT_TYPE_INSTANCE) {\n'
@@ -895,7 +928,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         verify_parent += self.writeIndent(indent)
         verify_parent += '}\n'
         verify_parent += self.writeIndent(indent)
-        verify_parent += 'return VerifyXrParent(parent_type, parent_handle, handle2_type, handle2, true);\n'
+        verify_parent += 'return VerifyXrParentChain(parent_type, parent_handle, handle2_type, handle2, true);\n'
         indent -= 1
         verify_parent += self.writeIndent(indent)
         verify_parent += '} else {\n'
@@ -932,7 +965,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         verify_parent += self.writeIndent(indent)
         verify_parent += '} else {\n'
         verify_parent += self.writeIndent(indent + 1)
-        verify_parent += 'return VerifyXrParent(parent1_type, parent1_handle, parent2_type, parent2_handle, true);\n'
+        verify_parent += 'return VerifyXrParentChain(parent1_type, parent1_handle, parent2_type, parent2_handle, true);\n'
         verify_parent += self.writeIndent(indent)
         verify_parent += '}\n'
         indent -= 1
@@ -942,6 +975,24 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         verify_parent += 'return false;\n'
         indent -= 1
         verify_parent += '}\n\n'
+        verify_parent += '// Implementation of VerifyXrParent function\n'
+        verify_parent += '// A handle\'s parents never change, so the answer for a pair of handles only changes once a handle is removed.\n'
+        verify_parent += '// Commands called every frame check the same pairs over and over, so each thread remembers its recent answers.\n'
+        verify_parent += 'static thread_local HandleParentCheckMemo t_parent_check_memo = {};\n\n'
+        verify_parent += 'bool VerifyXrParent(XrObjectType handle1_type, const uint64_t handle1,\n'
+        verify_parent += '                    XrObjectType handle2_type, const uint64_t handle2,\n'
+        verify_parent += '                    bool check_this) {\n'
+        verify_parent += '    CoreValidationCheckTimer timer(CORE_VALIDATION_CHECK_PARENT);\n'
+        verify_parent += '    // Read before walking the parents, so that an answer found while a handle is removed is not kept\n'
+        verify_parent += '    const uint64_t epoch = g_handle_removal_epoch.load(std::memory_order_acquire);\n'
+        verify_parent += '    bool result = false;\n'
+        verify_parent += '    if (t_parent_check_memo.find(epoch, handle1_type, handle1, handle2_type, handle2, check_this, result)) {\n'
+        verify_parent += '        return result;\n'
+        verify_parent += '    }\n'
+        verify_parent += '    result = VerifyXrParentChain(handle1_type, handle1, handle2_type, handle2, check_this);\n'
+        verify_parent += '    t_parent_check_memo.store(epoch, handle1_type, handle1, handle2_type, handle2, check_this, result);\n'
+        verify_parent += '    return result;\n'
+        verify_parent += '}\n\n'
         return verify_parent
 
     # Generate inline C++ code to check if a 'next' chain is valid for the current structure.
@@ -950,24 +1001,33 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
     #   member          the member generated in automatic_source_generator.py to validate
     #   indent          the number of "tabs" to space in for the resulting C+ code.
     def writeValidateStructNextCheck(self, struct_type, struct_name, member, indent):
-        validate_struct_next = self.writeIndent(indent)
-        validate_struct_next += 'std::vector<XrStructureType> valid_ext_structs;\n'
+        validate_struct_next = ''
+        valid_structs = member.valid_extension_structs if member.valid_extension_structs else []
+        if len(valid_structs) > 64:
+            self.printCodeGenErrorMessage('%s allows %d structures in its "next" chain, but only 64 can be checked' % (
+                struct_type, len(valid_structs)))
+        if valid_structs:
+            validate_struct_next += self.writeIndent(indent)
+            validate_struct_next += 'static const XrStructureType valid_ext_structs[] = {\n'
+            for valid_struct in valid_structs:
+                validate_struct_next += self.writeIndent(indent + 1)
+                validate_struct_next += '%s,\n' % self.genXrStructureType(valid_struct)
+            validate_struct_next += self.writeIndent(indent)
+            validate_struct_next += '};\n'
+        else:
+            validate_struct_next += self.writeIndent(indent)
+            validate_struct_next += 'const XrStructureType* valid_ext_structs = nullptr;\n'
         validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += 'std::vector<XrStructureType> duplicate_ext_structs;\n'
+        validate_struct_next += 'const uint32_t valid_ext_struct_count = %d;\n' % len(valid_structs)
         validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += 'std::vector<XrStructureType> encountered_structs;\n'
-        if member.valid_extension_structs:
-            for valid_struct in member.valid_extension_structs:
-                validate_struct_next += self.writeIndent(indent)
-                validate_struct_next += 'valid_ext_structs.push_back(%s);\n' % self.genXrStructureType(
-                    valid_struct)
+        validate_struct_next += 'uint64_t duplicate_ext_structs = 0;\n'
         validate_struct_next += self.writeIndent(indent)
         validate_struct_next += 'NextChainResult next_result = ValidateNextChain(instance_info, command_name, objects_info,\n'
         validate_struct_next += self.writeIndent(indent)
         validate_struct_next += '                                                 %s->%s, valid_ext_structs,\n' % (
             struct_name, member.name)
         validate_struct_next += self.writeIndent(indent)
-        validate_struct_next += '                                                 encountered_structs,\n'
+        validate_struct_next += '                                                 valid_ext_struct_count,\n'
         validate_struct_next += self.writeIndent(indent)
         validate_struct_next += '                                                 duplicate_ext_structs);\n'
         validate_struct_next += self.writeIndent(indent)
@@ -999,11 +1059,13 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validate_struct_next += self.writeIndent(indent + 2)
         validate_struct_next += 'bool wrote_struct = false;\n'
         validate_struct_next += self.writeIndent(indent + 2)
-        validate_struct_next += 'for (uint32_t dup = 0; dup < duplicate_ext_structs.size(); ++dup) {\n'
+        validate_struct_next += 'for (uint32_t dup = 0; dup < valid_ext_struct_count; ++dup) {\n'
         validate_struct_next += self.writeIndent(indent + 3)
-        validate_struct_next += 'if (XR_SUCCESS == instance_info->dispatch_table->StructureTypeToString(instance_info->instance,\n'
+        validate_struct_next += 'if (0 != (duplicate_ext_structs & (static_cast<uint64_t>(1) << dup)) &&\n'
         validate_struct_next += self.writeIndent(indent + 3)
-        validate_struct_next += '                                                                       duplicate_ext_structs[dup],\n'
+        validate_struct_next += '    XR_SUCCESS == instance_info->dispatch_table->StructureTypeToString(instance_info->instance,\n'
+        validate_struct_next += self.writeIndent(indent + 3)
+        validate_struct_next += '                                                                       valid_ext_structs[dup],\n'
         validate_struct_next += self.writeIndent(indent + 3)
         validate_struct_next += '                                                                       struct_type_buffer)) {\n'
         validate_struct_next += self.writeIndent(indent + 4)
@@ -1875,7 +1937,10 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                         child, child)
                     if child_struct.ext_name and not self.isCoreExtensionName(child_struct.ext_name):
                         struct_check += self.writeIndent(indent)
-                        struct_check += 'if (nullptr != instance_info && !ExtensionEnabled(instance_info->enabled_extensions, "%s")) {\n' % child_struct.ext_name
+                        struct_check += 'if (nullptr != instance_info &&\n'
+                        struct_check += self.writeIndent(indent)
+                        struct_check += '    !GenValidUsageExtensionBitEnabled(instance_info, %s)) {\n' % self.makeExtensionBitName(
+                            child_struct.ext_name)
                         indent += 1
                         struct_check += self.writeIndent(indent)
                         struct_check += 'std::string error_str = "%s being used with child struct type ";\n' % xr_struct.name
@@ -2176,7 +2241,8 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 pre_validate_func += self.writeIndent(indent)
                 pre_validate_func += '// Check to make sure that the extension this command is in has been enabled\n'
                 pre_validate_func += self.writeIndent(indent)
-                pre_validate_func += 'if (!ExtensionEnabled(gen_instance_info->enabled_extensions, "%s")) {\n' % additional_ext
+                pre_validate_func += 'if (!GenValidUsageExtensionBitEnabled(gen_instance_info, %s)) {\n' % self.makeExtensionBitName(
+                    additional_ext)
                 pre_validate_func += self.writeIndent(indent + 1)
                 pre_validate_func += 'return XR_ERROR_VALIDATION_FAILURE;\n'
                 pre_validate_func += self.writeIndent(indent)
@@ -2195,15 +2261,25 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 pre_validate_func += 'objects_info.emplace_back(%s, %s);\n' % (param.name, self.genXrObjectType(
                     param.type))
             if not param.no_auto_validity:
-                pre_validate_func += self.outputParamMemberContents(True, cur_command.name, param, '',
-                                                                    instance_info_variable,
-                                                                    command_name_string,
-                                                                    is_first,
-                                                                    first_param,
-                                                                    first_param.name,
-                                                                    first_param_tuple,
-                                                                    wrote_handle_check_proto,
-                                                                    indent)
+                # Handles (and their parents) are checked at every validation level, everything else only at the full level
+                param_indent = indent if param.is_handle else indent + 1
+                param_contents = self.outputParamMemberContents(True, cur_command.name, param, '',
+                                                                instance_info_variable,
+                                                                command_name_string,
+                                                                is_first,
+                                                                first_param,
+                                                                first_param.name,
+                                                                first_param_tuple,
+                                                                wrote_handle_check_proto,
+                                                                param_indent)
+                if param.is_handle or not param_contents:
+                    pre_validate_func += param_contents
+                else:
+                    pre_validate_func += self.writeIndent(indent)
+                    pre_validate_func += 'if (CORE_VALIDATION_LEVEL_FULL == g_core_validation_level) {\n'
+                    pre_validate_func += param_contents
+                    pre_validate_func += self.writeIndent(indent)
+                    pre_validate_func += '}\n'
                 wrote_handle_check_proto = True
             count = count + 1
 
@@ -2427,12 +2503,8 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 assert(last_handle_tuple.name != 'XrInstance')
 
                 next_validate_func += '        if (XR_SUCCESS == result && nullptr != %s) {\n' % last_handle_name
-                next_validate_func += '            std::unique_ptr<GenValidUsageXrHandleInfo> handle_info(new GenValidUsageXrHandleInfo());\n'
-                next_validate_func += '            handle_info->instance_info = gen_instance_info;\n'
-                next_validate_func += '            handle_info->direct_parent_type = %s;\n' % self.genXrObjectType(
-                    first_param.type)
-                next_validate_func += '            handle_info->direct_parent_handle = MakeHandleGeneric(%s);\n' % first_param.name
-                next_validate_func += '            %s.insert(*%s, std::move(handle_info));\n' % (self.makeInfoName(last_handle_tuple), last_handle_name)
+                next_validate_func += '            %s.emplace(*%s, gen_instance_info, %s, MakeHandleGeneric(%s));\n' % (
+                    self.makeInfoName(last_handle_tuple), last_handle_name, self.genXrObjectType(first_param.type), first_param.name)
 
                 # If this object contains a state that needs tracking, allocate it
                 valid_type_list = []
@@ -2454,11 +2526,11 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
 
                 next_validate_func += '        }\n'
             elif is_destroy:
-                if last_param.type == 'XrSession':
-                    next_validate_func += '\n        // Clean up any labels associated with this session\n'
-                    # next_validate_func += '        CoreValidationDeleteSessionLabels(session);\n\n'
                 # Only remove the handle from our map if the runtime returned success
                 next_validate_func += '        if (XR_SUCCEEDED(result)) {\n'
+                if last_param.type == 'XrSession':
+                    next_validate_func += '            // Clean up any labels associated with this session\n'
+                    next_validate_func += '            CoreValidationDeleteSessionLabels(gen_instance_info, session);\n'
 
                 # If this object contains a state that needs tracking, free it
                 valid_type_list = []
@@ -2509,12 +2581,19 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
     #   self            the ValidationSourceOutputGenerator object
     #   cur_command     the command generated in automatic_source_generator.py to validate
     #   has_return      Boolean indicating that the command must return a value (usually XrResult)
-    def genAutoValidateFunc(self, cur_command, has_return):
+    #   is_lifetime     Boolean indicating that the command creates or destroys a handle
+    def genAutoValidateFunc(self, cur_command, has_return, is_lifetime):
         auto_validate_func = ''
         prototype = self.replace_ATTR_CALL(cur_command.cdecl.replace(" xr", " GenValidUsageXr"))
         prototype = prototype.replace(";", " {")
         auto_validate_func += '%s\n' % (prototype)
-        auto_validate_func += self.writeIndent(1)
+        indent = 1
+        # Only commands that create or destroy handles are checked at the lifetime validation level
+        if not is_lifetime:
+            auto_validate_func += self.writeIndent(indent)
+            auto_validate_func += 'if (CORE_VALIDATION_LEVEL_LIFETIME != g_core_validation_level) {\n'
+            indent = indent + 1
+        auto_validate_func += self.writeIndent(indent)
         if has_return:
             auto_validate_func += '%s test_result = ' % cur_command.return_type.text
         # Define the pre-validate call
@@ -2528,10 +2607,13 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
             auto_validate_func += param.name
         auto_validate_func += ');\n'
         if has_return and cur_command.return_type.text == 'XrResult':
-            auto_validate_func += self.writeIndent(1)
+            auto_validate_func += self.writeIndent(indent)
             auto_validate_func += 'if (XR_SUCCESS != test_result) {\n'
-            auto_validate_func += self.writeIndent(2)
+            auto_validate_func += self.writeIndent(indent + 1)
             auto_validate_func += 'return test_result;\n'
+            auto_validate_func += self.writeIndent(indent)
+            auto_validate_func += '}\n'
+        if not is_lifetime:
             auto_validate_func += self.writeIndent(1)
             auto_validate_func += '}\n'
         # Make the calldown to the next layer
@@ -2558,8 +2640,6 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         cur_extension_name = ''
 
         # First, output the mapping and mutex items
-        validation_source_funcs += '// Unordered Map associating pointer to a vector of session label information to a session\'s handle\n'
-        validation_source_funcs += 'std::unordered_map<XrSession, std::vector<GenValidUsageXrInternalSessionLabel*>*> g_xr_session_labels;\n\n'
         validation_source_funcs += self.outputInfoMapDeclarations(extern=False)
         validation_source_funcs += '\n'
         validation_source_funcs += self.outputValidationInternalProtos()
@@ -2612,6 +2692,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validation_source_funcs += self.outputValidationStateCheckStructs()
         validation_source_funcs += self.outputValidationSourceNextChainProtos()
         validation_source_funcs += self.outputValidationSourceFlagBitValues()
+        validation_source_funcs += self.outputValidationSourceExtensionBits()
         validation_source_funcs += self.outputValidationSourceEnumValues()
         validation_source_funcs += self.writeVerifyExtensions()
         validation_source_funcs += self.writeValidateHandleChecks()
@@ -2664,7 +2745,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                     cur_cmd, has_return, is_create, is_destroy, is_sempath_query)
                 if cur_cmd.name not in VALID_USAGE_MANUALLY_DEFINED:
                     validation_source_funcs += self.genAutoValidateFunc(
-                        cur_cmd, has_return)
+                        cur_cmd, has_return, is_create or is_destroy)
 
                 if cur_cmd.protect_value:
                     validation_source_funcs += '#endif // %s\n' % cur_cmd.protect_string
@@ -2698,6 +2779,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validation_source_funcs += '        }\n'
 
         count = 0
+        intercepted_commands = []
         for x in range(0, 2):
             if x == 0:
                 commands = self.core_commands
@@ -2741,6 +2823,7 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
                 validation_source_funcs += '            *function = reinterpret_cast<PFN_xrVoidFunction>(%s);\n' % layer_command_name
                 if cur_cmd.protect_value:
                     validation_source_funcs += '#endif // %s\n' % cur_cmd.protect_string
+                intercepted_commands.append(cur_cmd)
 
         validation_source_funcs += '        }\n'
         validation_source_funcs += '        // If we setup the function, just return\n'
@@ -2757,4 +2840,18 @@ class ValidationSourceOutputGenerator(AutomaticSourceOutputGenerator):
         validation_source_funcs += '        return XR_ERROR_VALIDATION_FAILURE;\n'
         validation_source_funcs += '    }\n'
         validation_source_funcs += '}\n'
+
+        # Output the list of the commands returned above, which the layer reports to the loader.
+        validation_source_funcs += '\n// The commands GenValidUsageXrGetInstanceProcAddr returns the layer\'s own functions for\n'
+        validation_source_funcs += 'const std::vector<const char*>& GenValidUsageInterceptedCommands() {\n'
+        validation_source_funcs += '    static const std::vector<const char*> intercepted_commands = {\n'
+        for cur_cmd in intercepted_commands:
+            if cur_cmd.protect_value:
+                validation_source_funcs += '#if %s\n' % cur_cmd.protect_string
+            validation_source_funcs += '        "%s",\n' % cur_cmd.name
+            if cur_cmd.protect_value:
+                validation_source_funcs += '#endif // %s\n' % cur_cmd.protect_string
+        validation_source_funcs += '    };\n'
+        validation_source_funcs += '    return intercepted_commands;\n'
+        validation_source_funcs += '}\n'
         return validation_source_funcs
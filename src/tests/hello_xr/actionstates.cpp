@@ -0,0 +1,49 @@
+#include "pch.h"
+#include "common.h"
+#include "actionstates.h"
+
+uint32_t ActionStates::Add(XrAction action, XrActionType type, XrPath subactionPath) {
+    if (type != XR_ACTION_TYPE_BOOLEAN_INPUT && type != XR_ACTION_TYPE_FLOAT_INPUT && type != XR_ACTION_TYPE_POSE_INPUT) {
+        THROW(Fmt("Action type %d has no state to fetch", type));
+    }
+    m_actions.push_back(action);
+    m_types.push_back(type);
+    m_subactionPaths.push_back(subactionPath);
+    m_isActive.push_back(XR_FALSE);
+    m_changed.push_back(XR_FALSE);
+    m_values.push_back(0.0f);
+    return Count() - 1;
+}
+
+void ActionStates::Fetch(XrSession session) {
+    XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
+    for (size_t i = 0; i < m_actions.size(); i++) {
+        getInfo.action = m_actions[i];
+        getInfo.subactionPath = m_subactionPaths[i];
+        switch (m_types[i]) {
+            case XR_ACTION_TYPE_BOOLEAN_INPUT: {
+                XrActionStateBoolean state{XR_TYPE_ACTION_STATE_BOOLEAN};
+                CHECK_XRCMD(xrGetActionStateBoolean(session, &getInfo, &state));
+                m_changed[i] = (state.changedSinceLastSync || state.isActive != m_isActive[i]) ? XR_TRUE : XR_FALSE;
+                m_isActive[i] = state.isActive;
+                m_values[i] = state.currentState ? 1.0f : 0.0f;
+                break;
+            }
+            case XR_ACTION_TYPE_FLOAT_INPUT: {
+                XrActionStateFloat state{XR_TYPE_ACTION_STATE_FLOAT};
+                CHECK_XRCMD(xrGetActionStateFloat(session, &getInfo, &state));
+                m_changed[i] = (state.changedSinceLastSync || state.isActive != m_isActive[i]) ? XR_TRUE : XR_FALSE;
+                m_isActive[i] = state.isActive;
+                m_values[i] = state.currentState;
+                break;
+            }
+            default: {
+                XrActionStatePose state{XR_TYPE_ACTION_STATE_POSE};
+                CHECK_XRCMD(xrGetActionStatePose(session, &getInfo, &state));
+                m_changed[i] = state.isActive != m_isActive[i] ? XR_TRUE : XR_FALSE;
+                m_isActive[i] = state.isActive;
+                break;
+            }
+        }
+    }
+}
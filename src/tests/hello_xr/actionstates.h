@@ -0,0 +1,32 @@
+#pragma once
+
+// The state of a set of input actions, each for one subaction path, fetched in a single pass after xrSyncActions.  The
+// states are kept as a structure of arrays indexed by the number Add returned, so that code reacting to input can
+// walk the changed flags and skip everything that is idle; that is what makes it cheap to bind hundreds of actions.
+// A state counts as changed when the runtime reports changedSinceLastSync, and also when the action has become active
+// or inactive since the previous fetch, which the runtime does not report as a change.  Boolean inputs are kept as 0 or
+// 1 in the value array, and pose inputs only have whether they are active.
+struct ActionStates {
+    // Registers an action of type XR_ACTION_TYPE_BOOLEAN_INPUT, XR_ACTION_TYPE_FLOAT_INPUT or XR_ACTION_TYPE_POSE_INPUT
+    // to fetch for subactionPath, and returns the index of its state.
+    uint32_t Add(XrAction action, XrActionType type, XrPath subactionPath);
+
+    // Fetches the state of every action added, to be called once after each xrSyncActions.
+    void Fetch(XrSession session);
+
+    uint32_t Count() const { return static_cast<uint32_t>(m_actions.size()); }
+    bool IsActive(uint32_t index) const { return m_isActive[index] != XR_FALSE; }
+    bool Changed(uint32_t index) const { return m_changed[index] != XR_FALSE; }
+    float Value(uint32_t index) const { return m_values[index]; }
+
+   private:
+    // What to fetch
+    std::vector<XrAction> m_actions;
+    std::vector<XrActionType> m_types;
+    std::vector<XrPath> m_subactionPaths;
+
+    // What was fetched
+    std::vector<XrBool32> m_isActive;
+    std::vector<XrBool32> m_changed;
+    std::vector<float> m_values;
+};
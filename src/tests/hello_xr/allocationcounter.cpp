@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "allocationcounter.h"
+
+#include <cstdlib>
+#include <new>
+
+// When built with HELLO_XR_COUNT_ALLOCATIONS, replaces the global allocation functions with ones that count, for each
+// thread, how often they are called, so that OpenXrProgram can show its steady-state frames don't touch the heap.  The
+// memory itself still comes from malloc, or from the platform's aligned allocator for over-aligned types.  Without the
+// option the count stays zero and no replacement is linked in.
+
+#ifdef HELLO_XR_COUNT_ALLOCATIONS
+namespace {
+thread_local uint64_t allocationCount = 0;
+
+void* CountedAllocate(std::size_t size) {
+    ++allocationCount;
+    // Even a zero-sized allocation has to return a unique pointer.
+    void* p = std::malloc(size != 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+#ifdef __cpp_aligned_new
+void* CountedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    ++allocationCount;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+#ifdef _WIN32
+    void* p = _aligned_malloc(size != 0 ? size : 1, align);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, align, size != 0 ? size : 1) != 0) {
+        p = nullptr;
+    }
+#endif
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void FreeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+#endif  // __cpp_aligned_new
+}  // namespace
+
+namespace AllocationCounter {
+uint64_t ThreadCount() { return allocationCount; }
+}  // namespace AllocationCounter
+
+void* operator new(std::size_t size) { return CountedAllocate(size); }
+
+void* operator new[](std::size_t size) { return CountedAllocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return CountedAllocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return CountedAllocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete[](void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, alignment); }
+
+void* operator new[](std::size_t size, std::align_val_t alignment) { return CountedAllocateAligned(size, alignment); }
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return CountedAllocateAligned(size, alignment);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return CountedAllocateAligned(size, alignment);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { FreeAligned(p); }
+
+void operator delete[](void* p, std::align_val_t) noexcept { FreeAligned(p); }
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { FreeAligned(p); }
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { FreeAligned(p); }
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(p); }
+#endif  // __cpp_aligned_new
+
+#else  // HELLO_XR_COUNT_ALLOCATIONS
+
+namespace AllocationCounter {
+uint64_t ThreadCount() { return 0; }
+}  // namespace AllocationCounter
+
+#endif  // HELLO_XR_COUNT_ALLOCATIONS
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace AllocationCounter {
+// The number of times the calling thread has allocated from the heap with operator new.  Always zero unless hello_xr
+// is built with HELLO_XR_COUNT_ALLOCATIONS.
+uint64_t ThreadCount();
+}  // namespace AllocationCounter
@@ -0,0 +1,19 @@
+# Copyright (c) 2017 The Khronos Group Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# Wraps the hex-word list glslangValidator -x writes in braces, in place, to match the -mfmt=c output of glslc.
+# Usage: cmake -DSPIRV_FILE=<file> -P brace_spirv.cmake
+
+file(READ ${SPIRV_FILE} spirv_words)
+file(WRITE ${SPIRV_FILE} "{${spirv_words}}\n")
@@ -0,0 +1,115 @@
+#include "pch.h"
+#include "common.h"
+#include "frametimes.h"
+
+namespace {
+constexpr int64_t NanosecondsPerSecond = 1000000000;
+
+bool EndsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+double Microseconds(int64_t nanoseconds) { return nanoseconds / 1000.0; }
+
+double Milliseconds(int64_t nanoseconds) { return nanoseconds / 1000000.0; }
+}  // namespace
+
+FrameTimesRecorder::FrameTimesRecorder(const std::string& fileName) : m_start(std::chrono::steady_clock::now()) {
+    m_file = fopen(fileName.c_str(), "w");
+    if (m_file == nullptr) {
+        THROW(Fmt("Unable to open %s for the frame times", fileName.c_str()));
+    }
+
+    m_chromeTrace = EndsWith(fileName, ".json");
+    if (m_chromeTrace) {
+        fprintf(m_file, "[\n");
+    } else {
+        fprintf(m_file,
+                "frame,wait_start_ns,wait_ns,submit_start_ns,submit_ns,gpu_ns,predicted_display_time_ns,"
+                "predicted_display_period_ns,display_time_delta_ns,should_render,layer_count\n");
+    }
+}
+
+FrameTimesRecorder::~FrameTimesRecorder() {
+    if (m_chromeTrace) {
+        // The trace viewer also reads a trace whose array is never closed, as when the program doesn't exit cleanly.
+        fprintf(m_file, "\n]\n");
+    }
+    fclose(m_file);
+}
+
+int64_t FrameTimesRecorder::Now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+void FrameTimesRecorder::Record(const FrameTimes& frame) {
+    const XrDuration displayTimeDelta =
+        m_lastPredictedDisplayTime != 0 ? frame.PredictedDisplayTime - m_lastPredictedDisplayTime : 0;
+    m_lastPredictedDisplayTime = frame.PredictedDisplayTime;
+    uint32_t missedFrames = 0;
+    if (frame.PredictedDisplayPeriod > 0 && displayTimeDelta * 2 > frame.PredictedDisplayPeriod * 3) {
+        // The display periods between the two frames that had no frame of their own
+        missedFrames = (uint32_t)((displayTimeDelta + frame.PredictedDisplayPeriod / 2) / frame.PredictedDisplayPeriod - 1);
+    }
+
+    if (m_chromeTrace) {
+        // Complete events on two rows, one for waiting and one for submitting, which overlap when rendering is pipelined.
+        fprintf(m_file,
+                "%s{\"name\":\"xrWaitFrame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"frame\":%llu}}",
+                m_traceStarted ? ",\n" : "", Microseconds(frame.WaitStart), Microseconds(frame.WaitDuration),
+                (unsigned long long)frame.FrameIndex);
+        m_traceStarted = true;
+        fprintf(m_file,
+                ",\n{\"name\":\"xrBeginFrame to xrEndFrame\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"frame\":%llu,\"gpu_ns\":%lld,\"display_time_delta_ns\":%lld,\"layers\":%u}}",
+                Microseconds(frame.SubmitStart), Microseconds(frame.SubmitDuration), (unsigned long long)frame.FrameIndex,
+                (long long)frame.GpuDuration, (long long)displayTimeDelta, frame.LayerCount);
+        if (missedFrames != 0) {
+            fprintf(m_file,
+                    ",\n{\"name\":\"Missed frame\",\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":2,\"ts\":%.3f,"
+                    "\"args\":{\"frame\":%llu,\"missed\":%u}}",
+                    Microseconds(frame.SubmitStart), (unsigned long long)frame.FrameIndex, missedFrames);
+        }
+    } else {
+        fprintf(m_file, "%llu,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%d,%u\n", (unsigned long long)frame.FrameIndex,
+                (long long)frame.WaitStart, (long long)frame.WaitDuration, (long long)frame.SubmitStart,
+                (long long)frame.SubmitDuration, (long long)frame.GpuDuration, (long long)frame.PredictedDisplayTime,
+                (long long)frame.PredictedDisplayPeriod, (long long)displayTimeDelta, frame.ShouldRender ? 1 : 0,
+                frame.LayerCount);
+    }
+
+    m_summaryFrames++;
+    m_summaryMissedFrames += missedFrames;
+    m_summaryLayers += frame.LayerCount;
+    m_summaryWait += frame.WaitDuration;
+    m_summarySubmit += frame.SubmitDuration;
+    if (frame.GpuDuration >= 0) {
+        m_summaryGpuFrames++;
+        m_summaryGpu += frame.GpuDuration;
+    }
+
+    const int64_t now = frame.SubmitStart + frame.SubmitDuration;
+    if (now - m_summaryStart >= NanosecondsPerSecond) {
+        LogSummary();
+        m_summaryStart = now;
+    }
+}
+
+void FrameTimesRecorder::LogSummary() {
+    const std::string gpu =
+        m_summaryGpuFrames != 0 ? Fmt("%.2f ms", Milliseconds(m_summaryGpu / m_summaryGpuFrames)) : std::string("unmeasured");
+    Log::Write(Log::Level::Info, Fmt("Frame times over %u frames: xrWaitFrame %.2f ms, xrBeginFrame to xrEndFrame %.2f ms, "
+                                     "GPU %s, %u missed, %.1f layers",
+                                     m_summaryFrames, Milliseconds(m_summaryWait / m_summaryFrames),
+                                     Milliseconds(m_summarySubmit / m_summaryFrames), gpu.c_str(), m_summaryMissedFrames,
+                                     (double)m_summaryLayers / m_summaryFrames));
+
+    m_summaryFrames = 0;
+    m_summaryGpuFrames = 0;
+    m_summaryMissedFrames = 0;
+    m_summaryLayers = 0;
+    m_summaryWait = 0;
+    m_summarySubmit = 0;
+    m_summaryGpu = 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// How one frame went, in nanoseconds.  The CPU times are on the steady clock, relative to the creation of the
+// FrameTimesRecorder.
+struct FrameTimes {
+    uint64_t FrameIndex{0};
+    int64_t WaitStart{0};       // When xrWaitFrame was called
+    int64_t WaitDuration{0};    // How long xrWaitFrame blocked
+    int64_t SubmitStart{0};     // When xrBeginFrame was called
+    int64_t SubmitDuration{0};  // From the call of xrBeginFrame to the return of xrEndFrame
+    int64_t GpuDuration{-1};    // GPU time of a recent frame's views, from IGraphicsPlugin::GetGpuFrameTime
+    XrTime PredictedDisplayTime{0};
+    XrDuration PredictedDisplayPeriod{0};
+    bool ShouldRender{false};
+    uint32_t LayerCount{0};  // Composition layers submitted with xrEndFrame
+};
+
+// Writes the times of every frame to a file, as CSV or, for a file name ending in .json, as a trace for chrome://tracing,
+// and logs a summary of them about once a second.  A frame counts as missed when its predicted display time comes more
+// than one and a half display periods after the previous frame's.
+struct FrameTimesRecorder {
+    explicit FrameTimesRecorder(const std::string& fileName);
+    ~FrameTimesRecorder();
+
+    FrameTimesRecorder(const FrameTimesRecorder&) = delete;
+    FrameTimesRecorder& operator=(const FrameTimesRecorder&) = delete;
+
+    // Nanoseconds since the recorder was created.
+    int64_t Now() const;
+
+    // Called for each frame, in order, once xrEndFrame has returned.
+    void Record(const FrameTimes& frame);
+
+   private:
+    void LogSummary();
+
+    const std::chrono::steady_clock::time_point m_start;
+    FILE* m_file{nullptr};
+    bool m_chromeTrace{false};
+    bool m_traceStarted{false};  // Whether an event has been written, so the next needs a separator
+    XrTime m_lastPredictedDisplayTime{0};
+
+    // Totals since the last summary
+    int64_t m_summaryStart{0};
+    uint32_t m_summaryFrames{0};
+    uint32_t m_summaryGpuFrames{0};
+    uint32_t m_summaryMissedFrames{0};
+    uint32_t m_summaryLayers{0};
+    int64_t m_summaryWait{0};
+    int64_t m_summarySubmit{0};
+    int64_t m_summaryGpu{0};
+};
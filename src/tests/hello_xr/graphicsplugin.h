@@ -26,9 +26,49 @@ struct IGraphicsPlugin {
     virtual std::vector<XrSwapchainImageBaseHeader*> AllocateSwapchainImageStructs(
         uint32_t capacity, const XrSwapchainCreateInfo& swapchainCreateInfo) = 0;
 
+    // Called once a frame, after xrWaitFrame and before the frame's views are rendered, for plugins that keep
+    // resources the GPU may still be using from earlier frames.
+    virtual void BeginFrame() {}
+
+    // Called after BeginFrame and before xrEndFrame, around the rendering of a frame's views, when the frame times are
+    // recorded.  GetGpuFrameTime then reports how long the GPU took over one of the last few bracketed frames, in
+    // nanoseconds, so as never to wait for the GPU; -1 until there is a result, or if the plugin can't tell.
+    virtual void BeginGpuTimer() {}
+    virtual void EndGpuTimer() {}
+    virtual int64_t GetGpuFrameTime() const { return -1; }
+
+    // Called when rendering moves to another thread: UnbindFromCurrentThread on the thread that rendered until now, then
+    // BindToCurrentThread on the one that renders from now on.  Only needed by APIs whose contexts are per-thread.
+    virtual void BindToCurrentThread() {}
+    virtual void UnbindFromCurrentThread() {}
+
     // Render to a swapchain image for a projection view.
     virtual void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                             int64_t swapchainFormat, const std::vector<Cube>& cubes) = 0;
+
+    // Render each projection view to its own swapchain image, view i to swapchainImages[i]. The images have been acquired
+    // but not waited for: waitForImage(i) must return before the GPU is given work on swapchainImages[i], so that waiting
+    // for one image can overlap the rendering of the others. Plugins that can record the views concurrently override
+    // this; by default they are waited for and rendered one after another.
+    virtual void RenderViews(const std::vector<XrCompositionLayerProjectionView>& layerViews,
+                             const std::vector<const XrSwapchainImageBaseHeader*>& swapchainImages, int64_t swapchainFormat,
+                             const std::vector<Cube>& cubes, const std::function<void(size_t)>& waitForImage) {
+        for (size_t i = 0; i < layerViews.size(); i++) {
+            waitForImage(i);
+            RenderView(layerViews[i], swapchainImages[i], swapchainFormat, cubes);
+        }
+    }
+
+    // Whether RenderMultiView can render this many views in a single pass, each to its own layer of an array swapchain.
+    virtual bool SupportsMultiView(uint32_t /*viewCount*/) const { return false; }
+
+    // Render every projection view in a single pass, view i to layer layerViews[i].subImage.imageArrayIndex of the
+    // swapchain image. The views all use the same image rect.
+    virtual void RenderMultiView(const std::vector<XrCompositionLayerProjectionView>& /*layerViews*/,
+                                 const XrSwapchainImageBaseHeader* /*swapchainImage*/, int64_t /*swapchainFormat*/,
+                                 const std::vector<Cube>& /*cubes*/) {
+        THROW("Multiview rendering is not supported by this graphics plugin");
+    }
 };
 
 // Create a graphics plugin for the graphics API specified in the options.
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "common.h"
 #include "geometry.h"
+#include "options.h"
 #include "graphicsplugin.h"
 
 #ifdef XR_USE_GRAPHICS_API_D3D11
@@ -13,9 +14,6 @@ using namespace Microsoft::WRL;
 using namespace DirectX;
 
 namespace {
-struct ModelConstantBuffer {
-    XMFLOAT4X4 Model;
-};
 struct ViewProjectionConstantBuffer {
     XMFLOAT4X4 ViewProjection;
 };
@@ -29,16 +27,19 @@ constexpr char ShaderHlsl[] = R"_(
     struct Vertex {
         float3 Pos : POSITION;
         float3 Color : COLOR0;
+        // The rows of the cube's model transform, from the per-instance vertex buffer
+        float4 Model0 : MODEL0;
+        float4 Model1 : MODEL1;
+        float4 Model2 : MODEL2;
+        float4 Model3 : MODEL3;
     };
-    cbuffer ModelConstantBuffer : register(b0) {
-        float4x4 Model;
-    };
-    cbuffer ViewProjectionConstantBuffer : register(b1) {
+    cbuffer ViewProjectionConstantBuffer : register(b0) {
         float4x4 ViewProjection;
     };
 
     PSVertex MainVS(Vertex input) {
        PSVertex output;
+       const float4x4 Model = float4x4(input.Model0, input.Model1, input.Model2, input.Model3);
        output.Pos = mul(mul(float4(input.Pos, 1), Model), ViewProjection);
        output.Color = input.Color;
        return output;
@@ -49,12 +50,6 @@ constexpr char ShaderHlsl[] = R"_(
     }
     )_";
 
-XMMATRIX XM_CALLCONV LoadXrPose(const XrPosef& pose) {
-    return XMMatrixAffineTransformation(DirectX::g_XMOne, DirectX::g_XMZero,
-                                        XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&pose.orientation)),
-                                        XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&pose.position)));
-}
-
 XMMATRIX XM_CALLCONV LoadXrMatrix(const XrMatrix4x4f& matrix) {
     // XrMatrix4x4f has same memory layout as DirectX Math (Row-major,post-multiplied = column-major,pre-multiplied)
     return XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(&matrix));
@@ -122,7 +117,21 @@ void InitializeD3D11DeviceForAdapter(IDXGIAdapter1* adapter, const std::vector<D
 }
 
 struct D3D11GraphicsPlugin : public IGraphicsPlugin {
-    D3D11GraphicsPlugin(const std::shared_ptr<Options>&, std::shared_ptr<IPlatformPlugin>){};
+    D3D11GraphicsPlugin(const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin>)
+        : m_parallelViews(options->ParallelViews){};
+
+    ~D3D11GraphicsPlugin() override {
+        {
+            std::lock_guard<std::mutex> lock(m_recordMutex);
+            m_recordStop = true;
+        }
+        m_recordCondition.notify_all();
+        for (const std::unique_ptr<ViewRecorder>& recorder : m_viewRecorders) {
+            if (recorder->thread.joinable()) {
+                recorder->thread.join();
+            }
+        }
+    }
 
     std::vector<std::string> GetInstanceExtensions() const override { return {XR_KHR_D3D11_ENABLE_EXTENSION_NAME}; }
 
@@ -160,17 +169,17 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
         const D3D11_INPUT_ELEMENT_DESC vertexDesc[] = {
             {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
             {"COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+            // XrMatrix4x4f has the memory layout of a row-major DirectX Math matrix, so each element is a row.
+            {"MODEL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"MODEL", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"MODEL", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+            {"MODEL", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1},
         };
 
         CHECK_HRCMD(m_device->CreateInputLayout(vertexDesc, (UINT)ArraySize(vertexDesc), vertexShaderBytes->GetBufferPointer(),
                                                 vertexShaderBytes->GetBufferSize(), &m_inputLayout));
 
-        const CD3D11_BUFFER_DESC modelConstantBufferDesc(sizeof(ModelConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
-        CHECK_HRCMD(m_device->CreateBuffer(&modelConstantBufferDesc, nullptr, m_modelCBuffer.ReleaseAndGetAddressOf()));
-
-        const CD3D11_BUFFER_DESC viewProjectionConstantBufferDesc(sizeof(ViewProjectionConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
-        CHECK_HRCMD(
-            m_device->CreateBuffer(&viewProjectionConstantBufferDesc, nullptr, m_viewProjectionCBuffer.ReleaseAndGetAddressOf()));
+        CreateViewBuffers(m_viewBuffers);
 
         const D3D11_SUBRESOURCE_DATA vertexBufferData{Geometry::c_cubeVertices};
         const CD3D11_BUFFER_DESC vertexBufferDesc(sizeof(Geometry::c_cubeVertices), D3D11_BIND_VERTEX_BUFFER);
@@ -179,6 +188,22 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
         const D3D11_SUBRESOURCE_DATA indexBufferData{Geometry::c_cubeIndices};
         const CD3D11_BUFFER_DESC indexBufferDesc(sizeof(Geometry::c_cubeIndices), D3D11_BIND_INDEX_BUFFER);
         CHECK_HRCMD(m_device->CreateBuffer(&indexBufferDesc, &indexBufferData, m_cubeIndexBuffer.ReleaseAndGetAddressOf()));
+
+        const CD3D11_QUERY_DESC disjointQueryDesc(D3D11_QUERY_TIMESTAMP_DISJOINT);
+        const CD3D11_QUERY_DESC timestampQueryDesc(D3D11_QUERY_TIMESTAMP);
+        for (GpuTimerQueries& queries : m_gpuTimerQueries) {
+            CHECK_HRCMD(m_device->CreateQuery(&disjointQueryDesc, queries.disjoint.ReleaseAndGetAddressOf()));
+            CHECK_HRCMD(m_device->CreateQuery(&timestampQueryDesc, queries.begin.ReleaseAndGetAddressOf()));
+            CHECK_HRCMD(m_device->CreateQuery(&timestampQueryDesc, queries.end.ReleaseAndGetAddressOf()));
+        }
+
+        if (m_parallelViews) {
+            // Without driver command lists the D3D11 runtime emulates them, which may not scale across cores.
+            D3D11_FEATURE_DATA_THREADING threading{};
+            CHECK_HRCMD(m_device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading)));
+            Log::Write(Log::Level::Verbose, Fmt("Recording views on deferred contexts, driver command lists: %s",
+                                                threading.DriverCommandLists ? "yes" : "no"));
+        }
     }
 
     int64_t SelectColorSwapchainFormat(const std::vector<int64_t>& runtimeFormats) const override {
@@ -205,131 +230,347 @@ struct D3D11GraphicsPlugin : public IGraphicsPlugin {
     }
 
     std::vector<XrSwapchainImageBaseHeader*> AllocateSwapchainImageStructs(
-        uint32_t capacity, const XrSwapchainCreateInfo& /*swapchainCreateInfo*/) override {
+        uint32_t capacity, const XrSwapchainCreateInfo& swapchainCreateInfo) override {
         // Allocate and initialize the buffer of image structs (must be sequential in memory for xrEnumerateSwapchainImages).
         // Return back an array of pointers to each swapchain image struct so the consumer doesn't need to know the type/size.
-        std::vector<XrSwapchainImageD3D11KHR> swapchainImageBuffer(capacity);
+        // Keep the buffer alive by adding it into the list of contexts.
+        m_swapchainImageContexts.push_back({});
+        SwapchainImageContext& context = m_swapchainImageContexts.back();
+        context.images.resize(capacity);
         std::vector<XrSwapchainImageBaseHeader*> swapchainImageBase;
-        for (XrSwapchainImageD3D11KHR& image : swapchainImageBuffer) {
+        for (XrSwapchainImageD3D11KHR& image : context.images) {
             image.type = XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR;
             swapchainImageBase.push_back(reinterpret_cast<XrSwapchainImageBaseHeader*>(&image));
         }
+        context.renderTargetViews.resize(capacity);
 
-        // Keep the buffer alive by moving it into the list of buffers.
-        m_swapchainImageBuffers.push_back(std::move(swapchainImageBuffer));
-
-        return swapchainImageBase;
-    }
-
-    ComPtr<ID3D11DepthStencilView> GetDepthStencilView(ID3D11Texture2D* colorTexture) {
-        // If a depth-stencil view has already been created for this back-buffer, use it.
-        auto depthBufferIt = m_colorToDepthMap.find(colorTexture);
-        if (depthBufferIt != m_colorToDepthMap.end()) {
-            return depthBufferIt->second;
-        }
-
-        // This back-buffer has no cooresponding depth-stencil texture, so create one with matching dimensions.
-        D3D11_TEXTURE2D_DESC colorDesc;
-        colorTexture->GetDesc(&colorDesc);
-
+        // A depth-stencil texture for each image, with matching dimensions, and its view.
         D3D11_TEXTURE2D_DESC depthDesc{};
-        depthDesc.Width = colorDesc.Width;
-        depthDesc.Height = colorDesc.Height;
-        depthDesc.ArraySize = colorDesc.ArraySize;
+        depthDesc.Width = swapchainCreateInfo.width;
+        depthDesc.Height = swapchainCreateInfo.height;
+        depthDesc.ArraySize = swapchainCreateInfo.arraySize;
         depthDesc.MipLevels = 1;
         depthDesc.Format = DXGI_FORMAT_R32_TYPELESS;
         depthDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_DEPTH_STENCIL;
         depthDesc.SampleDesc.Count = 1;
-        ComPtr<ID3D11Texture2D> depthTexture;
-        CHECK_HRCMD(m_device->CreateTexture2D(&depthDesc, nullptr, depthTexture.ReleaseAndGetAddressOf()));
+        const CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(D3D11_DSV_DIMENSION_TEXTURE2D, DXGI_FORMAT_D32_FLOAT);
+        context.depthStencilViews.resize(capacity);
+        for (ComPtr<ID3D11DepthStencilView>& depthStencilView : context.depthStencilViews) {
+            ComPtr<ID3D11Texture2D> depthTexture;
+            CHECK_HRCMD(m_device->CreateTexture2D(&depthDesc, nullptr, depthTexture.ReleaseAndGetAddressOf()));
+            CHECK_HRCMD(m_device->CreateDepthStencilView(depthTexture.Get(), &depthStencilViewDesc,
+                                                         depthStencilView.ReleaseAndGetAddressOf()));
+        }
+
+        return swapchainImageBase;
+    }
 
-        // Create and cache the depth stencil view.
-        ComPtr<ID3D11DepthStencilView> depthStencilView;
-        CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(D3D11_DSV_DIMENSION_TEXTURE2D, DXGI_FORMAT_D32_FLOAT);
-        CHECK_HRCMD(m_device->CreateDepthStencilView(depthTexture.Get(), &depthStencilViewDesc, depthStencilView.GetAddressOf()));
-        depthBufferIt = m_colorToDepthMap.insert(std::make_pair(colorTexture, depthStencilView)).first;
+    void BeginGpuTimer() override {
+        GpuTimerQueries& queries = m_gpuTimerQueries[m_gpuTimerIndex];
+        if (queries.issued) {
+            ReadGpuTimer(queries);
+        }
+        m_deviceContext->Begin(queries.disjoint.Get());
+        m_deviceContext->End(queries.begin.Get());
+    }
 
-        return depthStencilView;
+    void EndGpuTimer() override {
+        GpuTimerQueries& queries = m_gpuTimerQueries[m_gpuTimerIndex];
+        m_deviceContext->End(queries.end.Get());
+        m_deviceContext->End(queries.disjoint.Get());
+        queries.issued = true;
+        m_gpuTimerIndex = (m_gpuTimerIndex + 1) % GpuTimerFrames;
     }
 
+    int64_t GetGpuFrameTime() const override { return m_gpuFrameTime; }
+
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t swapchainFormat, const std::vector<Cube>& cubes) override {
+        RecordView(m_deviceContext.Get(), m_viewBuffers, layerView, swapchainImage, swapchainFormat, cubes);
+    }
+
+    void RenderViews(const std::vector<XrCompositionLayerProjectionView>& layerViews,
+                     const std::vector<const XrSwapchainImageBaseHeader*>& swapchainImages, int64_t swapchainFormat,
+                     const std::vector<Cube>& cubes, const std::function<void(size_t)>& waitForImage) override {
+        if (!m_parallelViews || layerViews.size() < 2) {
+            IGraphicsPlugin::RenderViews(layerViews, swapchainImages, swapchainFormat, cubes, waitForImage);
+            return;
+        }
+
+        // A recorder for each view.  This thread records the first view itself, so it needs no thread of its own.
+        while (m_viewRecorders.size() < layerViews.size()) {
+            std::unique_ptr<ViewRecorder> recorder(new ViewRecorder());
+            CHECK_HRCMD(m_device->CreateDeferredContext(0, recorder->context.ReleaseAndGetAddressOf()));
+            CreateViewBuffers(recorder->buffers);
+            const size_t view = m_viewRecorders.size();
+            if (view > 0) {
+                ViewRecorder* const recorderPointer = recorder.get();
+                recorder->thread = std::thread([this, recorderPointer, view] { ViewRecorderThread(*recorderPointer, view); });
+            }
+            m_viewRecorders.push_back(std::move(recorder));
+        }
+
+        m_recordLayerViews = &layerViews;
+        m_recordSwapchainImages = &swapchainImages;
+        m_recordSwapchainFormat = swapchainFormat;
+        m_recordCubes = &cubes;
+        {
+            std::lock_guard<std::mutex> lock(m_recordMutex);
+            m_recordViewCount = layerViews.size();
+            m_recordPending = m_recordViewCount - 1;
+            m_recordBatch++;
+        }
+        m_recordCondition.notify_all();
+
+        RecordDeferredView(*m_viewRecorders[0], 0);
+        {
+            std::unique_lock<std::mutex> lock(m_recordMutex);
+            m_recordDoneCondition.wait(lock, [this] { return m_recordPending == 0; });
+        }
+
+        for (size_t view = 0; view < layerViews.size(); view++) {
+            ViewRecorder& recorder = *m_viewRecorders[view];
+            if (recorder.error) {
+                const std::exception_ptr error = recorder.error;
+                recorder.error = nullptr;
+                std::rethrow_exception(error);
+            }
+        }
+
+        // Executed in view order, so the GPU gets the same work as if the views had been recorded on this context.  Only
+        // the execution touches the images, so they are waited for here rather than before recording.
+        for (size_t view = 0; view < layerViews.size(); view++) {
+            ViewRecorder& recorder = *m_viewRecorders[view];
+            waitForImage(view);
+            m_deviceContext->ExecuteCommandList(recorder.commandList.Get(), FALSE);
+            recorder.commandList.Reset();
+        }
+    }
+
+   private:
+    // The buffers rewritten for every view, one set for each context views are recorded on.
+    struct ViewBuffers {
+        ComPtr<ID3D11Buffer> viewProjectionCBuffer;
+        ComPtr<ID3D11Buffer> instanceBuffer;  // Model transform of each cube
+        UINT instanceCapacity{0};
+    };
+
+    // Records one view for RenderViews into a deferred context, on a thread of its own but for the first view.
+    struct ViewRecorder {
+        ComPtr<ID3D11DeviceContext> context;
+        ViewBuffers buffers;
+        ComPtr<ID3D11CommandList> commandList;  // Recorded, waiting to be executed
+        std::exception_ptr error;               // Thrown while recording, rethrown by RenderViews
+        std::thread thread;
+    };
+
+    void CreateViewBuffers(ViewBuffers& buffers) {
+        const CD3D11_BUFFER_DESC viewProjectionConstantBufferDesc(sizeof(ViewProjectionConstantBuffer), D3D11_BIND_CONSTANT_BUFFER,
+                                                                  D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+        CHECK_HRCMD(m_device->CreateBuffer(&viewProjectionConstantBufferDesc, nullptr,
+                                           buffers.viewProjectionCBuffer.ReleaseAndGetAddressOf()));
+    }
+
+    // Writes the model transform of every cube to the instance buffer, growing it first if it is too small.
+    void UploadCubeTransforms(ID3D11DeviceContext* deviceContext, ViewBuffers& buffers, const std::vector<Cube>& cubes) {
+        const UINT cubeCount = (UINT)cubes.size();
+        if (cubeCount > buffers.instanceCapacity) {
+            const CD3D11_BUFFER_DESC instanceBufferDesc(sizeof(XrMatrix4x4f) * cubeCount, D3D11_BIND_VERTEX_BUFFER,
+                                                        D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+            CHECK_HRCMD(m_device->CreateBuffer(&instanceBufferDesc, nullptr, buffers.instanceBuffer.ReleaseAndGetAddressOf()));
+            buffers.instanceCapacity = cubeCount;
+        }
+
+        // Discarding gives fresh memory to write to while earlier views may still be drawing from the old contents.
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        CHECK_HRCMD(deviceContext->Map(buffers.instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+        XrMatrix4x4f_CreateTranslationRotationScaleArray(static_cast<XrMatrix4x4f*>(mapped.pData), &cubes[0].Pose, sizeof(Cube),
+                                                         &cubes[0].Scale, sizeof(Cube), (int)cubeCount);
+        deviceContext->Unmap(buffers.instanceBuffer.Get(), 0);
+    }
+
+    // Records a view on deviceContext, the immediate context or a deferred one, rewriting the buffers that go with it.
+    void RecordView(ID3D11DeviceContext* deviceContext, ViewBuffers& buffers, const XrCompositionLayerProjectionView& layerView,
+                    const XrSwapchainImageBaseHeader* swapchainImage, int64_t swapchainFormat, const std::vector<Cube>& cubes) {
         CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
 
-        ID3D11Texture2D* const colorTexture = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(swapchainImage)->texture;
+        uint32_t imageIndex;
+        SwapchainImageContext& context = FindSwapchainImageContext(swapchainImage, &imageIndex);
 
         CD3D11_VIEWPORT viewport((float)layerView.subImage.imageRect.offset.x, (float)layerView.subImage.imageRect.offset.y,
                                  (float)layerView.subImage.imageRect.extent.width,
                                  (float)layerView.subImage.imageRect.extent.height);
-        m_deviceContext->RSSetViewports(1, &viewport);
-
-        // Create RenderTargetView with original swapchain format (swapchain is typeless).
-        ComPtr<ID3D11RenderTargetView> renderTargetView;
-        const CD3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc(D3D11_RTV_DIMENSION_TEXTURE2D, (DXGI_FORMAT)swapchainFormat);
-        CHECK_HRCMD(
-            m_device->CreateRenderTargetView(colorTexture, &renderTargetViewDesc, renderTargetView.ReleaseAndGetAddressOf()));
+        deviceContext->RSSetViewports(1, &viewport);
+
+        // Create the RenderTargetView on the image's first use, as its texture is only known once the swapchain images have
+        // been enumerated. It has the original swapchain format (swapchain is typeless).
+        ComPtr<ID3D11RenderTargetView>& renderTargetView = context.renderTargetViews[imageIndex];
+        if (!renderTargetView) {
+            ID3D11Texture2D* const colorTexture = context.images[imageIndex].texture;
+            const CD3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc(D3D11_RTV_DIMENSION_TEXTURE2D, (DXGI_FORMAT)swapchainFormat);
+            CHECK_HRCMD(
+                m_device->CreateRenderTargetView(colorTexture, &renderTargetViewDesc, renderTargetView.ReleaseAndGetAddressOf()));
+        }
 
-        const ComPtr<ID3D11DepthStencilView> depthStencilView = GetDepthStencilView(colorTexture);
+        const ComPtr<ID3D11DepthStencilView>& depthStencilView = context.depthStencilViews[imageIndex];
 
         // Clear swapchain and depth buffer. NOTE: This will clear the entire render target view, not just the specified view.
         // TODO: Do not clear to a color when using a pass-through view configuration.
-        m_deviceContext->ClearRenderTargetView(renderTargetView.Get(), DirectX::Colors::DarkSlateGray);
-        m_deviceContext->ClearDepthStencilView(depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+        deviceContext->ClearRenderTargetView(renderTargetView.Get(), DirectX::Colors::DarkSlateGray);
+        deviceContext->ClearDepthStencilView(depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
         ID3D11RenderTargetView* renderTargets[] = {renderTargetView.Get()};
-        m_deviceContext->OMSetRenderTargets((UINT)ArraySize(renderTargets), renderTargets, depthStencilView.Get());
+        deviceContext->OMSetRenderTargets((UINT)ArraySize(renderTargets), renderTargets, depthStencilView.Get());
 
-        const XMMATRIX spaceToView = XMMatrixInverse(nullptr, LoadXrPose(layerView.pose));
+        XrMatrix4x4f view;
+        XrMatrix4x4f_CreateViewFromPose(&view, &layerView.pose);
+        const XMMATRIX spaceToView = LoadXrMatrix(view);
         XrMatrix4x4f projectionMatrix;
         XrMatrix4x4f_CreateProjectionFov(&projectionMatrix, GRAPHICS_D3D, layerView.fov, 0.05f, 100.0f);
 
         // Set shaders and constant buffers.
-        ViewProjectionConstantBuffer viewProjection;
-        XMStoreFloat4x4(&viewProjection.ViewProjection, XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
-        m_deviceContext->UpdateSubresource(m_viewProjectionCBuffer.Get(), 0, nullptr, &viewProjection, 0, 0);
-
-        ID3D11Buffer* const constantBuffers[] = {m_modelCBuffer.Get(), m_viewProjectionCBuffer.Get()};
-        m_deviceContext->VSSetConstantBuffers(0, (UINT)ArraySize(constantBuffers), constantBuffers);
-        m_deviceContext->VSSetShader(m_vertexShader.Get(), nullptr, 0);
-        m_deviceContext->PSSetShader(m_pixelShader.Get(), nullptr, 0);
-
-        // Set cube primitive data.
-        const UINT strides[] = {sizeof(Geometry::Vertex)};
-        const UINT offsets[] = {0};
-        ID3D11Buffer* vertexBuffers[] = {m_cubeVertexBuffer.Get()};
-        m_deviceContext->IASetVertexBuffers(0, (UINT)ArraySize(vertexBuffers), vertexBuffers, strides, offsets);
-        m_deviceContext->IASetIndexBuffer(m_cubeIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
-        m_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        m_deviceContext->IASetInputLayout(m_inputLayout.Get());
-
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute and update the model transform.
-            ModelConstantBuffer model;
-            XMStoreFloat4x4(&model.Model,
-                            XMMatrixTranspose(XMMatrixScaling(cube.Scale.x, cube.Scale.y, cube.Scale.z) * LoadXrPose(cube.Pose)));
-            m_deviceContext->UpdateSubresource(m_modelCBuffer.Get(), 0, nullptr, &model, 0, 0);
-
-            // Draw the cube.
-            m_deviceContext->DrawIndexed((UINT)ArraySize(Geometry::c_cubeIndices), 0, 0);
+        // Mapped with discard, which deferred contexts support and which gives every view fresh memory to write to.
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        CHECK_HRCMD(deviceContext->Map(buffers.viewProjectionCBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+        ViewProjectionConstantBuffer* const viewProjection = static_cast<ViewProjectionConstantBuffer*>(mapped.pData);
+        XMStoreFloat4x4(&viewProjection->ViewProjection, XMMatrixTranspose(spaceToView * LoadXrMatrix(projectionMatrix)));
+        deviceContext->Unmap(buffers.viewProjectionCBuffer.Get(), 0);
+
+        ID3D11Buffer* const constantBuffers[] = {buffers.viewProjectionCBuffer.Get()};
+        deviceContext->VSSetConstantBuffers(0, (UINT)ArraySize(constantBuffers), constantBuffers);
+        deviceContext->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+        deviceContext->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+
+        if (cubes.empty()) {
+            return;
         }
+        UploadCubeTransforms(deviceContext, buffers, cubes);
+
+        // Set cube primitive data, per vertex and per instance.
+        const UINT strides[] = {sizeof(Geometry::Vertex), sizeof(XrMatrix4x4f)};
+        const UINT offsets[] = {0, 0};
+        ID3D11Buffer* vertexBuffers[] = {m_cubeVertexBuffer.Get(), buffers.instanceBuffer.Get()};
+        deviceContext->IASetVertexBuffers(0, (UINT)ArraySize(vertexBuffers), vertexBuffers, strides, offsets);
+        deviceContext->IASetIndexBuffer(m_cubeIndexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+        deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        deviceContext->IASetInputLayout(m_inputLayout.Get());
+
+        // Render all the cubes with one instanced draw
+        deviceContext->DrawIndexedInstanced((UINT)ArraySize(Geometry::c_cubeIndices), (UINT)cubes.size(), 0, 0, 0);
+    }
+
+    void RecordDeferredView(ViewRecorder& recorder, size_t view) {
+        try {
+            RecordView(recorder.context.Get(), recorder.buffers, (*m_recordLayerViews)[view], (*m_recordSwapchainImages)[view],
+                       m_recordSwapchainFormat, *m_recordCubes);
+            CHECK_HRCMD(recorder.context->FinishCommandList(FALSE, recorder.commandList.ReleaseAndGetAddressOf()));
+        } catch (...) {
+            recorder.error = std::current_exception();
+        }
+    }
+
+    // Records the view of the given index of every RenderViews call with that many views or more.
+    void ViewRecorderThread(ViewRecorder& recorder, size_t view) {
+        uint64_t batch = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_recordMutex);
+                m_recordCondition.wait(lock, [this, batch] { return m_recordStop || m_recordBatch != batch; });
+                if (m_recordStop) {
+                    return;
+                }
+                batch = m_recordBatch;
+                if (view >= m_recordViewCount) {
+                    continue;
+                }
+            }
+
+            RecordDeferredView(recorder, view);
+
+            std::lock_guard<std::mutex> lock(m_recordMutex);
+            if (--m_recordPending == 0) {
+                m_recordDoneCondition.notify_one();
+            }
+        }
+    }
+
+    // A swapchain's image structs, packed for xrEnumerateSwapchainImages, and the views each is rendered through.
+    struct SwapchainImageContext {
+        std::vector<XrSwapchainImageD3D11KHR> images;
+        std::vector<ComPtr<ID3D11RenderTargetView>> renderTargetViews;
+        std::vector<ComPtr<ID3D11DepthStencilView>> depthStencilViews;
+    };
+
+    // The context of the swapchain that swapchainImage belongs to, and the image's index in it.  There are only as many
+    // contexts as swapchains, one or two.
+    SwapchainImageContext& FindSwapchainImageContext(const XrSwapchainImageBaseHeader* swapchainImage, uint32_t* imageIndex) {
+        const auto image = reinterpret_cast<const XrSwapchainImageD3D11KHR*>(swapchainImage);
+        const std::less<const XrSwapchainImageD3D11KHR*> before;
+        for (SwapchainImageContext& context : m_swapchainImageContexts) {
+            const XrSwapchainImageD3D11KHR* const images = context.images.data();
+            if (!before(image, images) && before(image, images + context.images.size())) {
+                *imageIndex = (uint32_t)(image - images);
+                return context;
+            }
+        }
+        THROW("Swapchain image was not allocated by this graphics plugin");
+    }
+
+    // The queries timing one frame, read back GpuTimerFrames frames later so as not to wait for the GPU.
+    struct GpuTimerQueries {
+        ComPtr<ID3D11Query> disjoint;
+        ComPtr<ID3D11Query> begin;
+        ComPtr<ID3D11Query> end;
+        bool issued{false};
+    };
+
+    static constexpr uint32_t GpuTimerFrames = 3;
+
+    // Leaves the last result in place if the queries aren't done yet, or the timestamps are unreliable.
+    void ReadGpuTimer(GpuTimerQueries& queries) {
+        queries.issued = false;
+
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+        UINT64 begin;
+        UINT64 end;
+        if (m_deviceContext->GetData(queries.disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            m_deviceContext->GetData(queries.begin.Get(), &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            m_deviceContext->GetData(queries.end.Get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            disjoint.Disjoint) {
+            return;
+        }
+        m_gpuFrameTime = (int64_t)((double)(end - begin) * 1e9 / (double)disjoint.Frequency);
     }
 
-   private:
     ComPtr<ID3D11Device> m_device;
     ComPtr<ID3D11DeviceContext> m_deviceContext;
     XrGraphicsBindingD3D11KHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_D3D11_KHR};
-    std::list<std::vector<XrSwapchainImageD3D11KHR>> m_swapchainImageBuffers;
+    std::list<SwapchainImageContext> m_swapchainImageContexts;
     ComPtr<ID3D11VertexShader> m_vertexShader;
     ComPtr<ID3D11PixelShader> m_pixelShader;
     ComPtr<ID3D11InputLayout> m_inputLayout;
-    ComPtr<ID3D11Buffer> m_modelCBuffer;
-    ComPtr<ID3D11Buffer> m_viewProjectionCBuffer;
     ComPtr<ID3D11Buffer> m_cubeVertexBuffer;
     ComPtr<ID3D11Buffer> m_cubeIndexBuffer;
-
-    // Map color buffer to associated depth buffer. This map is populated on demand.
-    std::map<ID3D11Texture2D*, ComPtr<ID3D11DepthStencilView>> m_colorToDepthMap;
+    ViewBuffers m_viewBuffers;  // Those of the immediate context
+    GpuTimerQueries m_gpuTimerQueries[GpuTimerFrames];
+    uint32_t m_gpuTimerIndex{0};
+    int64_t m_gpuFrameTime{-1};
+
+    // With Options::ParallelViews, RenderViews hands each view to its recorder; m_recordBatch is incremented to start
+    // the recorder threads on the views published in the m_record members.
+    const bool m_parallelViews;
+    std::vector<std::unique_ptr<ViewRecorder>> m_viewRecorders;
+    std::mutex m_recordMutex;
+    std::condition_variable m_recordCondition;
+    std::condition_variable m_recordDoneCondition;
+    uint64_t m_recordBatch{0};
+    size_t m_recordViewCount{0};
+    size_t m_recordPending{0};  // Recorder threads still recording
+    bool m_recordStop{false};
+    const std::vector<XrCompositionLayerProjectionView>* m_recordLayerViews{nullptr};
+    const std::vector<const XrSwapchainImageBaseHeader*>* m_recordSwapchainImages{nullptr};
+    int64_t m_recordSwapchainFormat{0};
+    const std::vector<Cube>* m_recordCubes{nullptr};
 };
 }  // namespace
 
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "common.h"
 #include "geometry.h"
+#include "options.h"
 #include "graphicsplugin.h"
 
 #ifdef XR_USE_GRAPHICS_API_OPENGL
@@ -16,17 +17,45 @@ static const char* VertexShaderGlsl = R"_(
 
     in vec3 VertexPos;
     in vec3 VertexColor;
+    in mat4 Model;
 
     out vec3 PSVertexColor;
 
-    uniform mat4 ModelViewProjection;
+    uniform mat4 ViewProjection;
 
     void main() {
-       gl_Position = ModelViewProjection * vec4(VertexPos, 1.0);
+       gl_Position = ViewProjection * (Model * vec4(VertexPos, 1.0));
        PSVertexColor = VertexColor;
     }
     )_";
 
+// Used by RenderMultiView, which draws both views of a stereo pair at once, each to its own layer of the swapchain image.
+constexpr uint32_t MultiViewCount = 2;
+
+static const char* MultiViewVertexShaderGlsl = R"_(
+    #version 410
+    #extension GL_OVR_multiview2 : require
+
+    layout(num_views = 2) in;
+
+    in vec3 VertexPos;
+    in vec3 VertexColor;
+    in mat4 Model;
+
+    out vec3 PSVertexColor;
+
+    uniform mat4 ViewProjection[2];
+
+    void main() {
+       gl_Position = ViewProjection[gl_ViewID_OVR] * (Model * vec4(VertexPos, 1.0));
+       PSVertexColor = VertexColor;
+    }
+    )_";
+
+// The cube transforms are written to a persistently mapped buffer split into this many segments, one per view drawn,
+// so that the transforms of a view are not overwritten while the GPU may still be drawing the views before it.
+constexpr uint32_t InstanceSegmentCount = 4;
+
 static const char* FragmentShaderGlsl = R"_(
     #version 410
 
@@ -39,15 +68,34 @@ static const char* FragmentShaderGlsl = R"_(
     )_";
 
 struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
-    OpenGLGraphicsPlugin(const std::shared_ptr<Options>&, std::shared_ptr<IPlatformPlugin>){};
+    OpenGLGraphicsPlugin(const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin>) {
+        // gfxwrapper's frame records go next to the frame times, as frames.csv -> frames_gl.csv.
+        if (!options->FrameTimesFile.empty()) {
+            const std::string& fileName = options->FrameTimesFile;
+            const size_t extension = fileName.find_last_of('.');
+            const size_t directory = fileName.find_last_of("/\\");
+            if (extension == std::string::npos || (directory != std::string::npos && extension < directory)) {
+                m_frameRecordsFile = fileName + "_gl";
+            } else {
+                m_frameRecordsFile = fileName.substr(0, extension) + "_gl" + fileName.substr(extension);
+            }
+        }
+    }
 
     ~OpenGLGraphicsPlugin() override {
+        if (!m_frameRecordsFile.empty()) {
+            ksFrameLog_ExportRecords(m_frameRecordsFile.c_str());
+        }
+
         if (m_swapchainFramebuffer != 0) {
             glDeleteFramebuffers(1, &m_swapchainFramebuffer);
         }
         if (m_program != 0) {
             glDeleteProgram(m_program);
         }
+        if (m_multiViewProgram != 0) {
+            glDeleteProgram(m_multiViewProgram);
+        }
         if (m_vao != 0) {
             glDeleteVertexArrays(1, &m_vao);
         }
@@ -57,11 +105,13 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         if (m_cubeIndexBuffer != 0) {
             glDeleteBuffers(1, &m_cubeIndexBuffer);
         }
+        ReleaseInstanceBuffer();
+        if (m_gpuTimerCreated) {
+            ksGpuTimer_Destroy(&window.context, &m_gpuTimer);
+        }
 
-        for (auto& colorToDepth : m_colorToDepthMap) {
-            if (colorToDepth.second != 0) {
-                glDeleteTextures(1, &colorToDepth.second);
-            }
+        for (SwapchainImageContext& context : m_swapchainImageContexts) {
+            glDeleteTextures(static_cast<GLsizei>(context.depthTextures.size()), context.depthTextures.data());
         }
     }
 
@@ -150,10 +200,38 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
 
-        m_modelViewProjectionUniformLocation = glGetUniformLocation(m_program, "ModelViewProjection");
+        m_viewProjectionUniformLocation = glGetUniformLocation(m_program, "ViewProjection");
 
         m_vertexAttribCoords = glGetAttribLocation(m_program, "VertexPos");
         m_vertexAttribColor = glGetAttribLocation(m_program, "VertexColor");
+        m_vertexAttribModel = glGetAttribLocation(m_program, "Model");
+
+        if (glExtensions.multi_view) {
+            GLuint multiViewVertexShader = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(multiViewVertexShader, 1, &MultiViewVertexShaderGlsl, nullptr);
+            glCompileShader(multiViewVertexShader);
+            CheckShader(multiViewVertexShader);
+
+            GLuint multiViewFragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(multiViewFragmentShader, 1, &FragmentShaderGlsl, nullptr);
+            glCompileShader(multiViewFragmentShader);
+            CheckShader(multiViewFragmentShader);
+
+            m_multiViewProgram = glCreateProgram();
+            glAttachShader(m_multiViewProgram, multiViewVertexShader);
+            glAttachShader(m_multiViewProgram, multiViewFragmentShader);
+            // Drawn with the same vertex array as m_program, so the vertex attributes have to be in the same places.
+            glBindAttribLocation(m_multiViewProgram, m_vertexAttribCoords, "VertexPos");
+            glBindAttribLocation(m_multiViewProgram, m_vertexAttribColor, "VertexColor");
+            glBindAttribLocation(m_multiViewProgram, m_vertexAttribModel, "Model");
+            glLinkProgram(m_multiViewProgram);
+            CheckProgram(m_multiViewProgram);
+
+            glDeleteShader(multiViewVertexShader);
+            glDeleteShader(multiViewFragmentShader);
+
+            m_multiViewViewProjectionUniformLocation = glGetUniformLocation(m_multiViewProgram, "ViewProjection");
+        }
 
         glGenBuffers(1, &m_cubeVertexBuffer);
         glBindBuffer(GL_ARRAY_BUFFER, m_cubeVertexBuffer);
@@ -172,8 +250,59 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         glVertexAttribPointer(m_vertexAttribCoords, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex), 0);
         glVertexAttribPointer(m_vertexAttribColor, 3, GL_FLOAT, GL_FALSE, sizeof(Geometry::Vertex),
                               reinterpret_cast<const void*>(sizeof(XrVector3f)));
+
+        // The model transform is a per-instance attribute, a location for each column.  UploadCubeTransforms points
+        // the columns into the instance buffer.
+        for (GLuint column = 0; column < 4; column++) {
+            glEnableVertexAttribArray(m_vertexAttribModel + column);
+            glVertexAttribDivisor(m_vertexAttribModel + column, 1);
+        }
+        glBindVertexArray(0);
+
+        ksGpuTimer_Create(&window.context, &m_gpuTimer);
+        m_gpuTimerCreated = true;
+    }
+
+    // Makes room for count cube transforms in each segment of the instance buffer.
+    void CreateInstanceBuffer(GLsizei count) {
+        ReleaseInstanceBuffer();
+
+        m_instanceCapacity = count;
+        ksGpuRingBuffer_Create(&window.context, &m_instanceBuffer, GL_ARRAY_BUFFER,
+                               sizeof(XrMatrix4x4f) * static_cast<size_t>(count), InstanceSegmentCount);
+    }
+
+    void ReleaseInstanceBuffer() {
+        if (m_instanceCapacity != 0) {
+            ksGpuRingBuffer_Destroy(&window.context, &m_instanceBuffer);
+            m_instanceCapacity = 0;
+        }
     }
 
+    // Writes the model transform of every cube to the instance buffer and points the Model attribute of the bound
+    // vertex array at them.  Call FenceCubeTransforms once the cubes have been drawn.
+    void UploadCubeTransforms(const std::vector<Cube>& cubes) {
+        const GLsizei cubeCount = static_cast<GLsizei>(cubes.size());
+        if (cubeCount > m_instanceCapacity) {
+            CreateInstanceBuffer(cubeCount);
+        }
+
+        // Leaves the instance buffer bound
+        size_t offset = 0;
+        XrMatrix4x4f* transforms = static_cast<XrMatrix4x4f*>(ksGpuRingBuffer_MapSegment(&m_instanceBuffer, &offset));
+        XrMatrix4x4f_CreateTranslationRotationScaleArray(transforms, &cubes[0].Pose, sizeof(Cube), &cubes[0].Scale,
+                                                         sizeof(Cube), cubeCount);
+        ksGpuRingBuffer_UnmapSegment(&m_instanceBuffer, sizeof(XrMatrix4x4f) * cubes.size());
+
+        for (GLuint column = 0; column < 4; column++) {
+            glVertexAttribPointer(m_vertexAttribModel + column, 4, GL_FLOAT, GL_FALSE, sizeof(XrMatrix4x4f),
+                                  reinterpret_cast<const void*>(offset + column * 4 * sizeof(float)));
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void FenceCubeTransforms() { ksGpuRingBuffer_FenceSegment(&m_instanceBuffer); }
+
     void CheckShader(GLuint shader) {
         GLint r = 0;
         glGetShaderiv(shader, GL_COMPILE_STATUS, &r);
@@ -218,48 +347,55 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
     }
 
     std::vector<XrSwapchainImageBaseHeader*> AllocateSwapchainImageStructs(
-        uint32_t capacity, const XrSwapchainCreateInfo& /*swapchainCreateInfo*/) override {
+        uint32_t capacity, const XrSwapchainCreateInfo& swapchainCreateInfo) override {
         // Allocate and initialize the buffer of image structs (must be sequential in memory for xrEnumerateSwapchainImages).
         // Return back an array of pointers to each swapchain image struct so the consumer doesn't need to know the type/size.
-        std::vector<XrSwapchainImageOpenGLKHR> swapchainImageBuffer(capacity);
+        // Keep the buffer alive by adding it into the list of contexts.
+        m_swapchainImageContexts.push_back({});
+        SwapchainImageContext& context = m_swapchainImageContexts.back();
+        context.images.resize(capacity);
         std::vector<XrSwapchainImageBaseHeader*> swapchainImageBase;
-        for (XrSwapchainImageOpenGLKHR& image : swapchainImageBuffer) {
+        for (XrSwapchainImageOpenGLKHR& image : context.images) {
             image.type = XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR;
             swapchainImageBase.push_back(reinterpret_cast<XrSwapchainImageBaseHeader*>(&image));
         }
 
-        // Keep the buffer alive by moving it into the list of buffers.
-        m_swapchainImageBuffers.push_back(std::move(swapchainImageBuffer));
+        // A depth texture for each image, with the same dimensions and layers.
+        const GLsizei width = static_cast<GLsizei>(swapchainCreateInfo.width);
+        const GLsizei height = static_cast<GLsizei>(swapchainCreateInfo.height);
+        const GLenum target = swapchainCreateInfo.arraySize > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+        context.depthTextures.resize(capacity);
+        glGenTextures(static_cast<GLsizei>(capacity), context.depthTextures.data());
+        for (GLuint depthTexture : context.depthTextures) {
+            glBindTexture(target, depthTexture);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            if (target == GL_TEXTURE_2D_ARRAY) {
+                glTexStorage3D(target, 1, GL_DEPTH_COMPONENT32, width, height,
+                               static_cast<GLsizei>(swapchainCreateInfo.arraySize));
+            } else {
+                glTexImage2D(target, 0, GL_DEPTH_COMPONENT32, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+            }
+        }
+        glBindTexture(target, 0);
 
         return swapchainImageBase;
     }
 
-    uint32_t GetDepthTexture(uint32_t colorTexture) {
-        // If a depth-stencil view has already been created for this back-buffer, use it.
-        auto depthBufferIt = m_colorToDepthMap.find(colorTexture);
-        if (depthBufferIt != m_colorToDepthMap.end()) {
-            return depthBufferIt->second;
+    // The depth texture made for a swapchain image, found by the image's index in its swapchain's context.  There are
+    // only as many contexts as swapchains, one or two.
+    GLuint GetDepthTexture(const XrSwapchainImageBaseHeader* swapchainImage) const {
+        const auto image = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage);
+        const std::less<const XrSwapchainImageOpenGLKHR*> before;
+        for (const SwapchainImageContext& context : m_swapchainImageContexts) {
+            const XrSwapchainImageOpenGLKHR* const images = context.images.data();
+            if (!before(image, images) && before(image, images + context.images.size())) {
+                return context.depthTextures[image - images];
+            }
         }
-
-        // This back-buffer has no cooresponding depth-stencil texture, so create one with matching dimensions.
-
-        GLint width, height;
-        glBindTexture(GL_TEXTURE_2D, colorTexture);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
-
-        uint32_t depthTexture;
-        glGenTextures(1, &depthTexture);
-        glBindTexture(GL_TEXTURE_2D, depthTexture);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
-
-        m_colorToDepthMap.insert(std::make_pair(colorTexture, depthTexture));
-
-        return depthTexture;
+        THROW("Swapchain image was not allocated by this graphics plugin");
     }
 
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
@@ -281,7 +417,7 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         glEnable(GL_CULL_FACE);
         glEnable(GL_DEPTH_TEST);
 
-        const uint32_t depthTexture = GetDepthTexture(colorTexture);
+        const uint32_t depthTexture = GetDepthTexture(swapchainImage);
 
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
@@ -297,28 +433,23 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         const auto& pose = layerView.pose;
         XrMatrix4x4f proj;
         XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_OPENGL, layerView.fov, 0.05f, 100.0f);
-        XrMatrix4x4f toView;
-        XrVector3f scale{1.f, 1.f, 1.f};
-        XrMatrix4x4f_CreateTranslationRotationScale(&toView, &pose.position, &pose.orientation, &scale);
         XrMatrix4x4f view;
-        XrMatrix4x4f_InvertRigidBody(&view, &toView);
+        XrMatrix4x4f_CreateViewFromPose(&view, &pose);
         XrMatrix4x4f vp;
         XrMatrix4x4f_Multiply(&vp, &proj, &view);
 
+        glUniformMatrix4fv(m_viewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&vp));
+
         // Set cube primitive data.
         glBindVertexArray(m_vao);
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and set it..
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            glUniformMatrix4fv(m_modelViewProjectionUniformLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&mvp));
-
-            // Draw the cube.
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT, 0);
+        // Render all the cubes with one instanced draw
+        if (!cubes.empty()) {
+            UploadCubeTransforms(cubes);
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT,
+                                    nullptr, static_cast<GLsizei>(cubes.size()));
+            ksFrameLog_CountCalls(1);
+            FenceCubeTransforms();
         }
 
         glBindVertexArray(0);
@@ -330,6 +461,91 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
         if (everyOther++ & 1) ksGpuWindow_SwapBuffers(&window);
     }
 
+    void BindToCurrentThread() override { ksGpuContext_SetCurrent(&window.context); }
+
+    void UnbindFromCurrentThread() override { ksGpuContext_UnsetCurrent(&window.context); }
+
+    void BeginGpuTimer() override { ksGpuTimer_Begin(&m_gpuTimer); }
+
+    void EndGpuTimer() override { ksGpuTimer_End(&m_gpuTimer); }
+
+    int64_t GetGpuFrameTime() const override {
+        // The timer has a result once a frame's queries have been read back, at the start of a later frame.
+        if (!glExtensions.timer_query || m_gpuTimer.gpuTimeFrame < 0) {
+            return -1;
+        }
+        return m_gpuTimer.gpuTime;
+    }
+
+    bool SupportsMultiView(uint32_t viewCount) const override { return m_multiViewProgram != 0 && viewCount == MultiViewCount; }
+
+    void RenderMultiView(const std::vector<XrCompositionLayerProjectionView>& layerViews,
+                         const XrSwapchainImageBaseHeader* swapchainImage, int64_t swapchainFormat,
+                         const std::vector<Cube>& cubes) override {
+        CHECK(layerViews.size() == MultiViewCount);
+        for (uint32_t i = 0; i < MultiViewCount; i++) {
+            CHECK(layerViews[i].subImage.imageArrayIndex == i);  // Views are rendered to the layer of the same index.
+        }
+        UNUSED_PARM(swapchainFormat);  // Not used in this function for now.
+
+        glBindFramebuffer(GL_FRAMEBUFFER, m_swapchainFramebuffer);
+
+        const uint32_t colorTexture = reinterpret_cast<const XrSwapchainImageOpenGLKHR*>(swapchainImage)->image;
+
+        const XrRect2Di& imageRect = layerViews[0].subImage.imageRect;
+        glViewport(static_cast<GLint>(imageRect.offset.x), static_cast<GLint>(imageRect.offset.y),
+                   static_cast<GLsizei>(imageRect.extent.width), static_cast<GLsizei>(imageRect.extent.height));
+
+        glFrontFace(GL_CW);
+        glCullFace(GL_BACK);
+        glEnable(GL_CULL_FACE);
+        glEnable(GL_DEPTH_TEST);
+
+        const uint32_t depthTexture = GetDepthTexture(swapchainImage);
+
+        glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, 0, MultiViewCount);
+        glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0, MultiViewCount);
+
+        // Clear every layer of the swapchain and depth buffer.
+        glClearColor(DarkSlateGray[0], DarkSlateGray[1], DarkSlateGray[2], DarkSlateGray[3]);
+        glClearDepth(1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+        // Set shaders and uniform variables.
+        glUseProgram(m_multiViewProgram);
+
+        // Set the view-projection transform of each view.
+        XrMatrix4x4f vps[MultiViewCount];
+        for (uint32_t i = 0; i < MultiViewCount; i++) {
+            XrMatrix4x4f proj;
+            XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_OPENGL, layerViews[i].fov, 0.05f, 100.0f);
+            XrMatrix4x4f view;
+            XrMatrix4x4f_CreateViewFromPose(&view, &layerViews[i].pose);
+            XrMatrix4x4f_Multiply(&vps[i], &proj, &view);
+        }
+        glUniformMatrix4fv(m_multiViewViewProjectionUniformLocation, MultiViewCount, GL_FALSE,
+                           reinterpret_cast<const GLfloat*>(vps));
+
+        // Set cube primitive data.
+        glBindVertexArray(m_vao);
+
+        // Render all the cubes with one instanced draw, to every view
+        if (!cubes.empty()) {
+            UploadCubeTransforms(cubes);
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(ArraySize(Geometry::c_cubeIndices)), GL_UNSIGNED_SHORT,
+                                    nullptr, static_cast<GLsizei>(cubes.size()));
+            ksFrameLog_CountCalls(1);
+            FenceCubeTransforms();
+        }
+
+        glBindVertexArray(0);
+        glUseProgram(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // Swap our window every frame for RenderDoc
+        ksGpuWindow_SwapBuffers(&window);
+    }
+
    private:
 #ifdef XR_USE_PLATFORM_WIN32
     XrGraphicsBindingOpenGLWin32KHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_OPENGL_WIN32_KHR};
@@ -341,18 +557,31 @@ struct OpenGLGraphicsPlugin : public IGraphicsPlugin {
     XrGraphicsBindingOpenGLWaylandKHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_OPENGL_WAYLAND_KHR};
 #endif
 
-    std::list<std::vector<XrSwapchainImageOpenGLKHR>> m_swapchainImageBuffers;
+    // A swapchain's image structs, packed for xrEnumerateSwapchainImages, and the depth texture each is rendered with.
+    struct SwapchainImageContext {
+        std::vector<XrSwapchainImageOpenGLKHR> images;
+        std::vector<GLuint> depthTextures;
+    };
+    std::list<SwapchainImageContext> m_swapchainImageContexts;
     GLuint m_swapchainFramebuffer{0};
     GLuint m_program{0};
-    GLint m_modelViewProjectionUniformLocation{0};
+    GLint m_viewProjectionUniformLocation{0};
+    GLuint m_multiViewProgram{0};  // Only created when GL_OVR_multiview2 is available
+    GLint m_multiViewViewProjectionUniformLocation{0};
     GLint m_vertexAttribCoords{0};
     GLint m_vertexAttribColor{0};
+    GLint m_vertexAttribModel{0};
     GLuint m_vao{0};
     GLuint m_cubeVertexBuffer{0};
     GLuint m_cubeIndexBuffer{0};
 
-    // Map color buffer to associated depth buffer. This map is populated on demand.
-    std::map<uint32_t, uint32_t> m_colorToDepthMap;
+    // Per-instance model transforms of the cubes, a segment of m_instanceCapacity transforms for each view drawn.
+    ksGpuRingBuffer m_instanceBuffer{};
+    GLsizei m_instanceCapacity{0};
+
+    ksGpuTimer m_gpuTimer{};  // Only times frames when timer queries are available
+    bool m_gpuTimerCreated{false};
+    std::string m_frameRecordsFile;  // Where gfxwrapper's frame records are exported on exit, if anywhere
 };
 }  // namespace
 
@@ -1,12 +1,15 @@
 #include "pch.h"
 #include "common.h"
 #include "geometry.h"
+#include "options.h"
 #include "graphicsplugin.h"
 
 #ifdef XR_USE_GRAPHICS_API_VULKAN
 
 #include <common/xr_linear.h>
 #include <array>
+#include <fstream>
+#include <sstream>
 
 #ifdef USE_ONLINE_VULKAN_SHADERC
 #include <shaderc/shaderc.hpp>
@@ -99,11 +102,12 @@ constexpr char VertexShaderGlsl[] =
 
     layout (std140, push_constant) uniform buf
     {
-        mat4 mvp;
+        mat4 viewProjection;
     } ubuf;
 
     layout (location = 0) in vec3 Position;
     layout (location = 1) in vec3 Color;
+    layout (location = 2) in mat4 Model;
 
     layout (location = 0) out vec4 oColor;
     out gl_PerVertex
@@ -113,8 +117,9 @@ constexpr char VertexShaderGlsl[] =
 
     void main()
     {
-        oColor.rgba  = Color.rgba;
-        gl_Position = ubuf.mvp * Position;
+        oColor.rgb  = Color.rgb;
+        oColor.a  = 1.0;
+        gl_Position = ubuf.viewProjection * (Model * vec4(Position, 1));
     }
 )_";
 
@@ -132,37 +137,172 @@ constexpr char FragmentShaderGlsl[] =
         FragColor = oColor;
     }
 )_";
+#else
+// The shaders of vulkan_shaders, compiled to SPIR-V by the build or, without a shader compiler, precompiled there.
+constexpr uint32_t VertexShaderSpirv[] =
+#include "vert.spv"
+    ;
+
+constexpr uint32_t FragmentShaderSpirv[] =
+#include "frag.spv"
+    ;
 #endif  // USE_ONLINE_VULKAN_SHADERC
 
+// A range of one of MemoryAllocator's blocks, to bind a buffer or image to at offset
+struct MemoryAllocation {
+    VkDeviceMemory memory{VK_NULL_HANDLE};
+    VkDeviceSize offset{0};
+    VkDeviceSize size{0};
+    void* mapped{nullptr};  // Host address of offset, when the memory is host-visible
+    uint32_t memoryTypeIndex{0};
+    size_t blockIndex{0};
+};
+
+// MemoryAllocator - carves buffers and images out of large VkDeviceMemory blocks, kept per memory type, rather than
+// making a vkAllocateMemory call for each of them.  Host-visible blocks stay mapped for their lifetime.
 struct MemoryAllocator {
+    static const VkDeviceSize blockSize = 16 * 1024 * 1024;
+
+    MemoryAllocator() {}
+
+    ~MemoryAllocator() {
+        if (m_vkDevice) {
+            for (std::vector<MemoryBlock>& blocks : m_blocks) {
+                for (MemoryBlock& block : blocks) {
+                    if (block.mapped) vkUnmapMemory(m_vkDevice, block.memory);
+                    vkFreeMemory(m_vkDevice, block.memory, nullptr);
+                }
+            }
+        }
+    }
+
     void Init(VkPhysicalDevice physicalDevice, VkDevice device) {
         m_vkDevice = device;
         vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memProps);
+        VkPhysicalDeviceProperties props{};
+        vkGetPhysicalDeviceProperties(physicalDevice, &props);
+        m_granularity = props.limits.bufferImageGranularity;
     }
 
     static const VkFlags defaultFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-    void Allocate(VkMemoryRequirements const& memReqs, VkDeviceMemory* mem, VkFlags flags = defaultFlags,
-                  const void* pNext = nullptr) const {
+    MemoryAllocation Allocate(VkMemoryRequirements const& memReqs, VkFlags flags = defaultFlags) {
+        // Buffers and optimally tiled images share blocks, so keep each allocation to granularity pages of its own.
+        const VkDeviceSize alignment = std::max(memReqs.alignment, m_granularity);
+        const VkDeviceSize size = AlignUp(memReqs.size, m_granularity);
+
+        MemoryAllocation allocation;
+        allocation.memoryTypeIndex = FindMemoryType(memReqs.memoryTypeBits, flags);
+        allocation.size = size;
+
+        std::vector<MemoryBlock>& blocks = m_blocks[allocation.memoryTypeIndex];
+        size_t blockIndex = 0;
+        while (blockIndex < blocks.size() && !blocks[blockIndex].Take(size, alignment, &allocation.offset)) {
+            ++blockIndex;
+        }
+        if (blockIndex == blocks.size()) {
+            blocks.push_back(CreateBlock(allocation.memoryTypeIndex, size > blockSize ? size : blockSize));
+            if (!blocks.back().Take(size, alignment, &allocation.offset)) THROW("Failed to sub-allocate memory");
+        }
+
+        const MemoryBlock& block = blocks[blockIndex];
+        allocation.memory = block.memory;
+        allocation.blockIndex = blockIndex;
+        if (block.mapped) allocation.mapped = static_cast<uint8_t*>(block.mapped) + allocation.offset;
+        return allocation;
+    }
+
+    // Returns the range to its block.  Blocks are kept for later allocations until the allocator is destroyed.
+    void Free(MemoryAllocation& allocation) {
+        if (allocation.memory != VK_NULL_HANDLE) {
+            m_blocks[allocation.memoryTypeIndex][allocation.blockIndex].Give(allocation.offset, allocation.size);
+        }
+        allocation = {};
+    }
+
+   private:
+    struct Range {
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    struct MemoryBlock {
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        void* mapped{nullptr};
+        std::vector<Range> free;  // Ordered by offset, never adjacent
+
+        // First fit: takes size bytes at an offset aligned to alignment from the first free range they fit in.
+        bool Take(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset) {
+            for (auto it = free.begin(); it != free.end(); ++it) {
+                const VkDeviceSize start = AlignUp(it->offset, alignment);
+                const VkDeviceSize end = it->offset + it->size;
+                if (start + size <= end) {
+                    const Range before{it->offset, start - it->offset};
+                    const Range after{start + size, end - (start + size)};
+                    it = free.erase(it);
+                    if (after.size > 0) it = free.insert(it, after);
+                    if (before.size > 0) free.insert(it, before);
+                    *offset = start;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Puts a range back, merging it with the free ranges either side.
+        void Give(VkDeviceSize offset, VkDeviceSize size) {
+            auto it = std::lower_bound(free.begin(), free.end(), offset,
+                                       [](const Range& range, VkDeviceSize value) { return range.offset < value; });
+            it = free.insert(it, Range{offset, size});
+            auto next = it + 1;
+            if (next != free.end() && it->offset + it->size == next->offset) {
+                it->size += next->size;
+                it = free.erase(next) - 1;
+            }
+            if (it != free.begin()) {
+                auto prev = it - 1;
+                if (prev->offset + prev->size == it->offset) {
+                    prev->size += it->size;
+                    free.erase(it);
+                }
+            }
+        }
+    };
+
+    static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+    }
+
+    uint32_t FindMemoryType(uint32_t memoryTypeBits, VkFlags flags) const {
         // Search memtypes to find first index with those properties
         for (uint32_t i = 0; i < m_memProps.memoryTypeCount; ++i) {
-            if (memReqs.memoryTypeBits & (1 << i)) {
+            if (memoryTypeBits & (1 << i)) {
                 // Type is available, does it match user properties?
                 if ((m_memProps.memoryTypes[i].propertyFlags & flags) == flags) {
-                    VkMemoryAllocateInfo memAlloc{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, pNext};
-                    memAlloc.allocationSize = memReqs.size;
-                    memAlloc.memoryTypeIndex = i;
-                    CHECK_VKCMD(vkAllocateMemory(m_vkDevice, &memAlloc, nullptr, mem));
-                    return;
+                    return i;
                 }
             }
         }
         THROW("Memory format not supported");
     }
 
-   private:
+    MemoryBlock CreateBlock(uint32_t memoryTypeIndex, VkDeviceSize size) const {
+        MemoryBlock block;
+        VkMemoryAllocateInfo memAlloc{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        memAlloc.allocationSize = size;
+        memAlloc.memoryTypeIndex = memoryTypeIndex;
+        CHECK_VKCMD(vkAllocateMemory(m_vkDevice, &memAlloc, nullptr, &block.memory));
+        if (m_memProps.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            CHECK_VKCMD(vkMapMemory(m_vkDevice, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped));
+        }
+        block.free.push_back(Range{0, size});
+        return block;
+    }
+
     VkDevice m_vkDevice{VK_NULL_HANDLE};
     VkPhysicalDeviceMemoryProperties m_memProps{};
+    VkDeviceSize m_granularity{1};
+    std::array<std::vector<MemoryBlock>, VK_MAX_MEMORY_TYPES> m_blocks;
 };
 
 // CmdBuffer - manage VkCommandBuffer state
@@ -273,7 +413,7 @@ struct CmdBuffer {
 
     bool Wait() {
         // Waiting on a not-in-flight command buffer is a no-op
-        if (state == CmdBufferState::Initialized) return true;
+        if (state == CmdBufferState::Initialized || state == CmdBufferState::Executable) return true;
 
         CHECK_CBSTATE(CmdBufferState::Executing);
 
@@ -372,9 +512,9 @@ struct ShaderProgram {
 // VertexBuffer base class
 struct VertexBufferBase {
     VkBuffer idxBuf{VK_NULL_HANDLE};
-    VkDeviceMemory idxMem{VK_NULL_HANDLE};
+    MemoryAllocation idxMem{};
     VkBuffer vtxBuf{VK_NULL_HANDLE};
-    VkDeviceMemory vtxMem{VK_NULL_HANDLE};
+    MemoryAllocation vtxMem{};
     VkVertexInputBindingDescription bindDesc{};
     std::vector<VkVertexInputAttributeDescription> attrDesc{};
     struct {
@@ -387,20 +527,18 @@ struct VertexBufferBase {
     ~VertexBufferBase() {
         if (m_vkDevice) {
             if (idxBuf) vkDestroyBuffer(m_vkDevice, idxBuf, nullptr);
-            if (idxMem) vkFreeMemory(m_vkDevice, idxMem, nullptr);
+            m_memAllocator->Free(idxMem);
             if (vtxBuf) vkDestroyBuffer(m_vkDevice, vtxBuf, nullptr);
-            if (vtxMem) vkFreeMemory(m_vkDevice, vtxMem, nullptr);
+            m_memAllocator->Free(vtxMem);
         }
         idxBuf = VK_NULL_HANDLE;
-        idxMem = VK_NULL_HANDLE;
         vtxBuf = VK_NULL_HANDLE;
-        vtxMem = VK_NULL_HANDLE;
         bindDesc = {};
         attrDesc.clear();
         count = {0, 0};
     }
 
-    void Init(VkDevice device, const MemoryAllocator* memAllocator, const std::vector<VkVertexInputAttributeDescription>& attr) {
+    void Init(VkDevice device, MemoryAllocator* memAllocator, const std::vector<VkVertexInputAttributeDescription>& attr) {
         m_vkDevice = device;
         m_memAllocator = memAllocator;
         attrDesc = attr;
@@ -408,14 +546,15 @@ struct VertexBufferBase {
 
    protected:
     VkDevice m_vkDevice{VK_NULL_HANDLE};
-    void AllocateBufferMemory(VkBuffer buf, VkDeviceMemory* mem) const {
+    void AllocateBufferMemory(VkBuffer buf, MemoryAllocation* mem) const {
         VkMemoryRequirements memReq = {};
         vkGetBufferMemoryRequirements(m_vkDevice, buf, &memReq);
-        m_memAllocator->Allocate(memReq, mem);
+        *mem = m_memAllocator->Allocate(memReq);
+        CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, buf, mem->memory, mem->offset));
     }
 
    private:
-    const MemoryAllocator* m_memAllocator{nullptr};
+    MemoryAllocator* m_memAllocator{nullptr};
 };
 
 // VertexBuffer template to wrap the indices and vertices
@@ -427,13 +566,11 @@ struct VertexBuffer : public VertexBufferBase {
         bufInfo.size = sizeof(uint16_t) * idxCount;
         CHECK_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &idxBuf));
         AllocateBufferMemory(idxBuf, &idxMem);
-        CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, idxBuf, idxMem, 0));
 
         bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
         bufInfo.size = sizeof(T) * vtxCount;
         CHECK_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &vtxBuf));
         AllocateBufferMemory(vtxBuf, &vtxMem);
-        CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, vtxBuf, vtxMem, 0));
 
         bindDesc.binding = 0;
         bindDesc.stride = sizeof(T);
@@ -445,20 +582,97 @@ struct VertexBuffer : public VertexBufferBase {
     }
 
     void UpdateIndicies(const uint16_t* data, uint32_t elements, uint32_t offset = 0) {
-        uint16_t* map = nullptr;
-        CHECK_VKCMD(vkMapMemory(m_vkDevice, idxMem, sizeof(map[0]) * offset, sizeof(map[0]) * elements, 0, (void**)&map));
+        uint16_t* map = static_cast<uint16_t*>(idxMem.mapped) + offset;
         for (size_t i = 0; i < elements; ++i) map[i] = data[i];
-        vkUnmapMemory(m_vkDevice, idxMem);
     }
 
     void UpdateVertices(const T* data, uint32_t elements, uint32_t offset = 0) {
-        T* map = nullptr;
-        CHECK_VKCMD(vkMapMemory(m_vkDevice, vtxMem, sizeof(map[0]) * offset, sizeof(map[0]) * elements, 0, (void**)&map));
+        T* map = static_cast<T*>(vtxMem.mapped) + offset;
         for (size_t i = 0; i < elements; ++i) map[i] = data[i];
-        vkUnmapMemory(m_vkDevice, vtxMem);
     }
 };
 
+// The per-instance model transform of the vertex shader: a mat4 read from its own vertex binding, a location per column
+constexpr uint32_t InstanceBinding = 1;
+constexpr uint32_t InstanceFirstLocation = 2;
+
+// DynamicBuffer - host-coherent memory, which MemoryAllocator keeps mapped, for data rewritten every frame such as the
+// cube transforms.  Each frame in flight has its own, so writing to it is a plain store with no map, flush or wait.
+struct DynamicBuffer {
+    static const VkDeviceSize initialCapacity = 64 * 1024;
+
+    DynamicBuffer() {}
+
+    ~DynamicBuffer() {
+        Reset();
+        Release(m_buf, m_mem);
+    }
+
+    void Init(VkDevice device, MemoryAllocator* memAllocator) {
+        m_vkDevice = device;
+        m_memAllocator = memAllocator;
+    }
+
+    // Space for size bytes at an offset that is a multiple of alignment, to bind as *buffer at *offset.  When the buffer is
+    // full it is replaced by a larger one; the old one is kept until Reset, for the commands already recorded to read.
+    void* Allocate(VkDeviceSize size, VkDeviceSize alignment, VkBuffer* buffer, VkDeviceSize* offset) {
+        VkDeviceSize start = (m_used + alignment - 1) / alignment * alignment;
+        if (start + size > m_capacity) {
+            if (m_buf != VK_NULL_HANDLE) m_retired.push_back({m_buf, m_mem});
+            const VkDeviceSize grown = m_capacity > 0 ? 2 * m_capacity : initialCapacity;
+            Create(size > grown ? size : grown);
+            start = 0;
+        }
+        m_used = start + size;
+        *buffer = m_buf;
+        *offset = start;
+        return static_cast<uint8_t*>(m_mem.mapped) + start;
+    }
+
+    // Starts writing from the beginning again.  Only call it once the GPU has finished the frame that last used it.
+    void Reset() {
+        for (Retired& retired : m_retired) {
+            Release(retired.buf, retired.mem);
+        }
+        m_retired.clear();
+        m_used = 0;
+    }
+
+   private:
+    struct Retired {
+        VkBuffer buf;
+        MemoryAllocation mem;
+    };
+
+    void Create(VkDeviceSize capacity) {
+        VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        bufInfo.size = capacity;
+        CHECK_VKCMD(vkCreateBuffer(m_vkDevice, &bufInfo, nullptr, &m_buf));
+        VkMemoryRequirements memReq = {};
+        vkGetBufferMemoryRequirements(m_vkDevice, m_buf, &memReq);
+        m_mem = m_memAllocator->Allocate(memReq);
+        CHECK_VKCMD(vkBindBufferMemory(m_vkDevice, m_buf, m_mem.memory, m_mem.offset));
+        m_capacity = capacity;
+    }
+
+    void Release(VkBuffer& buf, MemoryAllocation& mem) {
+        if (m_vkDevice) {
+            if (buf) vkDestroyBuffer(m_vkDevice, buf, nullptr);
+            m_memAllocator->Free(mem);
+        }
+        buf = VK_NULL_HANDLE;
+    }
+
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+    MemoryAllocator* m_memAllocator{nullptr};
+    VkBuffer m_buf{VK_NULL_HANDLE};
+    MemoryAllocation m_mem{};
+    VkDeviceSize m_capacity{0};
+    VkDeviceSize m_used{0};
+    std::vector<Retired> m_retired;
+};
+
 // RenderPass wrapper
 struct RenderPass {
     VkFormat colorFmt{};
@@ -517,6 +731,19 @@ struct RenderPass {
             subpass.pDepthStencilAttachment = &depthRef;
         }
 
+        // The command buffers of one frame can still be executing when the next frame's are submitted, and every image
+        // of a swapchain shares one depth buffer, so wait for earlier passes to finish with the attachments first.
+        VkSubpassDependency dependency = {};
+        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependency.dstSubpass = 0;
+        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                   VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        rpInfo.dependencyCount = 1;
+        rpInfo.pDependencies = &dependency;
+
         CHECK_VKCMD(vkCreateRenderPass(m_vkDevice, &rpInfo, nullptr, &pass));
 
         return true;
@@ -619,7 +846,7 @@ struct RenderTarget {
     VkDevice m_vkDevice{VK_NULL_HANDLE};
 };
 
-// Simple vertex MVP xform & color fragment shader layout
+// Simple vertex view-projection xform & color fragment shader layout
 struct PipelineLayout {
     VkPipelineLayout layout{VK_NULL_HANDLE};
 
@@ -635,7 +862,7 @@ struct PipelineLayout {
     void Create(VkDevice device) {
         m_vkDevice = device;
 
-        // MVP matrix is a push_constant
+        // View-projection matrix is a push_constant; the model transforms are per-instance vertex attributes
         VkPushConstantRange pcr = {};
         pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
         pcr.offset = 0;
@@ -651,6 +878,86 @@ struct PipelineLayout {
     VkDevice m_vkDevice{VK_NULL_HANDLE};
 };
 
+// VkPipelineCache wrapper.  The cache is kept in a file between runs, so that a pipeline compiled once need not be
+// compiled again; the file is named for the device and driver that wrote it, as no other can use the data.
+struct PipelineCache {
+    VkPipelineCache cache{VK_NULL_HANDLE};
+
+    PipelineCache() {}
+
+    ~PipelineCache() {
+        if (m_vkDevice) {
+            if (cache) vkDestroyPipelineCache(m_vkDevice, cache, nullptr);
+        }
+        cache = VK_NULL_HANDLE;
+    }
+
+    void Create(VkPhysicalDevice physDevice, VkDevice device) {
+        m_vkDevice = device;
+
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(physDevice, &props);
+        std::ostringstream fileName;
+        fileName << "hello_xr_pipeline_cache_" << std::hex << std::setfill('0');
+        for (uint8_t byte : props.pipelineCacheUUID) {
+            fileName << std::setw(2) << (uint32_t)byte;
+        }
+        fileName << "_" << std::setw(8) << props.driverVersion << ".bin";
+        m_fileName = fileName.str();
+
+        // Drivers should reject data that isn't theirs, but a file that was cut short or is from elsewhere isn't
+        // passed on to them at all.
+        std::vector<char> data;
+        std::ifstream file(m_fileName, std::ios::binary);
+        if (file) {
+            data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        if (!IsCompatible(data, props)) {
+            data.clear();
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+        CHECK_VKCMD(vkCreatePipelineCache(m_vkDevice, &cacheInfo, nullptr, &cache));
+
+        if (!data.empty()) {
+            Log::Write(Log::Level::Verbose, Fmt("Loaded %zu bytes of pipeline cache from %s", data.size(), m_fileName.c_str()));
+        }
+    }
+
+    // Writes the cache, with every pipeline created with it so far, to its file.
+    void Save() {
+        size_t size = 0;
+        CHECK_VKCMD(vkGetPipelineCacheData(m_vkDevice, cache, &size, nullptr));
+        std::vector<char> data(size);
+        CHECK_VKCMD(vkGetPipelineCacheData(m_vkDevice, cache, &size, data.data()));
+
+        std::ofstream file(m_fileName, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), size);
+        if (!file) {
+            Log::Write(Log::Level::Warning, Fmt("Unable to save the pipeline cache to %s", m_fileName.c_str()));
+        }
+    }
+
+   private:
+    // Whether data starts with a version one header for this device: its size, version, vendor and device IDs, and
+    // pipeline cache UUID.
+    static bool IsCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& props) {
+        uint32_t header[4];
+        if (data.size() < sizeof(header) + VK_UUID_SIZE) {
+            return false;
+        }
+        memcpy(header, data.data(), sizeof(header));
+        return header[0] >= sizeof(header) + VK_UUID_SIZE && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+               header[2] == props.vendorID && header[3] == props.deviceID &&
+               memcmp(data.data() + sizeof(header), props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    VkDevice m_vkDevice{VK_NULL_HANDLE};
+    std::string m_fileName;
+};
+
 // Pipeline wrapper for rendering pipeline state
 struct Pipeline {
     VkPipeline pipe{VK_NULL_HANDLE};
@@ -662,18 +969,27 @@ struct Pipeline {
     void Dynamic(VkDynamicState state) { dynamicStateEnables.emplace_back(state); }
 
     void Create(VkDevice device, VkExtent2D size, const PipelineLayout& layout, const RenderPass& rp, const ShaderProgram& sp,
-                const VertexBufferBase& vb) {
+                const VertexBufferBase& vb, const PipelineCache& cache) {
         m_vkDevice = device;
 
         VkPipelineDynamicStateCreateInfo dynamicState{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
         dynamicState.dynamicStateCount = (uint32_t)dynamicStateEnables.size();
         dynamicState.pDynamicStates = dynamicStateEnables.data();
 
+        // Per-vertex geometry from vb, and the per-instance model transforms
+        std::array<VkVertexInputBindingDescription, 2> bindDesc = {
+            {vb.bindDesc, {InstanceBinding, sizeof(XrMatrix4x4f), VK_VERTEX_INPUT_RATE_INSTANCE}}};
+        std::vector<VkVertexInputAttributeDescription> attrDesc = vb.attrDesc;
+        for (uint32_t column = 0; column < 4; ++column) {
+            attrDesc.push_back({InstanceFirstLocation + column, InstanceBinding, VK_FORMAT_R32G32B32A32_SFLOAT,
+                                (uint32_t)(column * 4 * sizeof(float))});
+        }
+
         VkPipelineVertexInputStateCreateInfo vi{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-        vi.vertexBindingDescriptionCount = 1;
-        vi.pVertexBindingDescriptions = &vb.bindDesc;
-        vi.vertexAttributeDescriptionCount = (uint32_t)vb.attrDesc.size();
-        vi.pVertexAttributeDescriptions = vb.attrDesc.data();
+        vi.vertexBindingDescriptionCount = (uint32_t)bindDesc.size();
+        vi.pVertexBindingDescriptions = bindDesc.data();
+        vi.vertexAttributeDescriptionCount = (uint32_t)attrDesc.size();
+        vi.pVertexAttributeDescriptions = attrDesc.data();
 
         VkPipelineInputAssemblyStateCreateInfo ia{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
         ia.primitiveRestartEnable = VK_FALSE;
@@ -760,7 +1076,7 @@ struct Pipeline {
         pipeInfo.layout = layout.layout;
         pipeInfo.renderPass = rp.pass;
         pipeInfo.subpass = 0;
-        CHECK_VKCMD(vkCreateGraphicsPipelines(m_vkDevice, VK_NULL_HANDLE, 1, &pipeInfo, nullptr, &pipe));
+        CHECK_VKCMD(vkCreateGraphicsPipelines(m_vkDevice, cache.cache, 1, &pipeInfo, nullptr, &pipe));
     }
 
     void Release() {
@@ -775,19 +1091,20 @@ struct Pipeline {
 };
 
 struct DepthBuffer {
-    VkDeviceMemory depthMemory{VK_NULL_HANDLE};
+    MemoryAllocation depthMemory{};
     VkImage depthImage{VK_NULL_HANDLE};
 
     DepthBuffer() {}
 
     ~DepthBuffer() {
         if (depthImage) vkDestroyImage(m_vkDevice, depthImage, nullptr);
-        if (depthMemory) vkFreeMemory(m_vkDevice, depthMemory, nullptr);
+        if (m_memAllocator) m_memAllocator->Free(depthMemory);
     }
 
     void Create(VkDevice device, MemoryAllocator* memAllocator, VkFormat depthFormat,
                 const XrSwapchainCreateInfo& swapchainCreateInfo) {
         m_vkDevice = device;
+        m_memAllocator = memAllocator;
 
         VkExtent2D size = {swapchainCreateInfo.width, swapchainCreateInfo.height};
 
@@ -809,12 +1126,13 @@ struct DepthBuffer {
 
         VkMemoryRequirements memRequirements{};
         vkGetImageMemoryRequirements(device, depthImage, &memRequirements);
-        memAllocator->Allocate(memRequirements, &depthMemory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        CHECK_VKCMD(vkBindImageMemory(device, depthImage, depthMemory, 0));
+        depthMemory = memAllocator->Allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        CHECK_VKCMD(vkBindImageMemory(device, depthImage, depthMemory.memory, depthMemory.offset));
     }
 
    private:
     VkDevice m_vkDevice{VK_NULL_HANDLE};
+    MemoryAllocator* m_memAllocator{nullptr};
 };
 
 struct SwapchainImageContext {
@@ -830,7 +1148,8 @@ struct SwapchainImageContext {
 
     std::vector<XrSwapchainImageBaseHeader*> Create(VkDevice device, MemoryAllocator* memAllocator, uint32_t capacity,
                                                     const XrSwapchainCreateInfo& swapchainCreateInfo, const PipelineLayout& layout,
-                                                    const ShaderProgram& sp, const VertexBuffer<Geometry::Vertex>& vb) {
+                                                    const ShaderProgram& sp, const VertexBuffer<Geometry::Vertex>& vb,
+                                                    const PipelineCache& cache) {
         m_vkDevice = device;
 
         size = {swapchainCreateInfo.width, swapchainCreateInfo.height};
@@ -840,7 +1159,10 @@ struct SwapchainImageContext {
 
         depthBuffer.Create(m_vkDevice, memAllocator, depthFormat, swapchainCreateInfo);
         rp.Create(m_vkDevice, colorFormat, depthFormat);
-        pipe.Create(m_vkDevice, size, layout, rp, sp, vb);
+        // The viewport and scissor are set for each view, to its image rect.
+        pipe.Dynamic(VK_DYNAMIC_STATE_VIEWPORT);
+        pipe.Dynamic(VK_DYNAMIC_STATE_SCISSOR);
+        pipe.Create(m_vkDevice, size, layout, rp, sp, vb, cache);
 
         swapchainImages.resize(capacity);
         renderTarget.resize(capacity);
@@ -853,6 +1175,12 @@ struct SwapchainImageContext {
         return bases;
     }
 
+    bool Contains(const XrSwapchainImageBaseHeader* swapchainImageHeader) const {
+        auto p = reinterpret_cast<const XrSwapchainImageVulkanKHR*>(swapchainImageHeader);
+        const std::less<const XrSwapchainImageVulkanKHR*> before;
+        return !before(p, swapchainImages.data()) && before(p, swapchainImages.data() + swapchainImages.size());
+    }
+
     uint32_t ImageIndex(const XrSwapchainImageBaseHeader* swapchainImageHeader) {
         auto p = reinterpret_cast<const XrSwapchainImageVulkanKHR*>(swapchainImageHeader);
         return (uint32_t)(p - &swapchainImages[0]);
@@ -1100,7 +1428,36 @@ void Swapchain::Present(VkQueue queue, VkSemaphore drawComplete) {
 #endif  // defined(USE_MIRROR_WINDOW)
 
 struct VulkanGraphicsPlugin : public IGraphicsPlugin {
-    VulkanGraphicsPlugin(const std::shared_ptr<Options>&, std::shared_ptr<IPlatformPlugin>){};
+    VulkanGraphicsPlugin(const std::shared_ptr<Options>& options, std::shared_ptr<IPlatformPlugin>)
+        : m_recordThreads(options->RecordThreads){};
+
+    ~VulkanGraphicsPlugin() override {
+        {
+            std::lock_guard<std::mutex> lock(m_recordMutex);
+            m_recordStop = true;
+        }
+        m_recordCondition.notify_all();
+        for (const std::unique_ptr<CubeRecorder>& recorder : m_cubeRecorders) {
+            if (recorder->thread.joinable()) {
+                recorder->thread.join();
+            }
+        }
+
+        // The command buffers can't be freed while the GPU may still be executing them
+        for (FrameResources& frame : m_frames) {
+            for (auto& cmdBuffer : frame.cmdBuffers) {
+                cmdBuffer->Wait();
+            }
+            if (frame.timestamps != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(m_vkDevice, frame.timestamps, nullptr);
+            }
+        }
+        for (const std::unique_ptr<CubeRecorder>& recorder : m_cubeRecorders) {
+            for (CubeRecorder::FramePool& framePool : recorder->framePools) {
+                vkDestroyCommandPool(m_vkDevice, framePool.pool, nullptr);
+            }
+        }
+    }
 
     std::vector<std::string> GetInstanceExtensions() const override { return {XR_KHR_VULKAN_ENABLE_EXTENSION_NAME}; }
 
@@ -1187,6 +1544,13 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
             }
         }
 
+        // The GPU can only be timed if the queue writes timestamps.
+        if (queueFamilyProps[m_queueFamilyIndex].timestampValidBits != 0) {
+            VkPhysicalDeviceProperties deviceProps;
+            vkGetPhysicalDeviceProperties(m_vkPhysicalDevice, &deviceProps);
+            m_timestampPeriod = deviceProps.limits.timestampPeriod;
+        }
+
         uint32_t deviceExtensionNamesSize = 0;
         CHECK_XRCMD(xrGetVulkanDeviceExtensionsKHR(instance, systemId, 0, &deviceExtensionNamesSize, nullptr));
         std::vector<char> deviceExtensionNames(deviceExtensionNamesSize);
@@ -1213,6 +1577,7 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         vkGetDeviceQueue(m_vkDevice, queueInfo.queueFamilyIndex, 0, &m_vkQueue);
 
         m_memAllocator.Init(m_vkPhysicalDevice, m_vkDevice);
+        m_pipelineCache.Create(m_vkPhysicalDevice, m_vkDevice);
 
         InitializeResources();
 
@@ -1247,12 +1612,8 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         auto vertexSPIRV = CompileGlslShader("vertex", shaderc_glsl_default_vertex_shader, VertexShaderGlsl);
         auto fragmentSPIRV = CompileGlslShader("fragment", shaderc_glsl_default_fragment_shader, FragmentShaderGlsl);
 #else
-        std::vector<uint32_t> vertexSPIRV =
-#include "vert.spv"
-            ;
-        std::vector<uint32_t> fragmentSPIRV =
-#include "frag.spv"
-            ;
+        const std::vector<uint32_t> vertexSPIRV(std::begin(VertexShaderSpirv), std::end(VertexShaderSpirv));
+        const std::vector<uint32_t> fragmentSPIRV(std::begin(FragmentShaderSpirv), std::end(FragmentShaderSpirv));
 #endif
         if (vertexSPIRV.empty()) THROW("Failed to compile vertex shader");
         if (fragmentSPIRV.empty()) THROW("Failed to compile fragment shader");
@@ -1279,6 +1640,16 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         m_drawBuffer.UpdateIndicies(Geometry::c_cubeIndices, numCubeIdicies, 0);
         m_drawBuffer.UpdateVertices(Geometry::c_cubeVertices, numCubeVerticies, 0);
 
+        for (FrameResources& frame : m_frames) {
+            frame.dynamicBuffer.Init(m_vkDevice, &m_memAllocator);
+            if (m_timestampPeriod != 0) {
+                VkQueryPoolCreateInfo queryPoolInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+                queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+                queryPoolInfo.queryCount = 2 * MaxTimedViews;
+                CHECK_VKCMD(vkCreateQueryPool(m_vkDevice, &queryPoolInfo, nullptr, &frame.timestamps));
+            }
+        }
+
 #if defined(USE_MIRROR_WINDOW)
         m_swapchain.Create(m_vkInstance, m_vkPhysicalDevice, m_vkDevice, m_graphicsBinding.queueFamilyIndex);
 
@@ -1318,26 +1689,47 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
         m_swapchainImageContexts.push_back({});
         SwapchainImageContext& swapchainImageContext = m_swapchainImageContexts.back();
 
-        std::vector<XrSwapchainImageBaseHeader*> bases = swapchainImageContext.Create(
-            m_vkDevice, &m_memAllocator, capacity, swapchainCreateInfo, m_pipelineLayout, m_shaderProgram, m_drawBuffer);
+        std::vector<XrSwapchainImageBaseHeader*> bases =
+            swapchainImageContext.Create(m_vkDevice, &m_memAllocator, capacity, swapchainCreateInfo, m_pipelineLayout,
+                                         m_shaderProgram, m_drawBuffer, m_pipelineCache);
 
-        // Map every swapchainImage base pointer to this context
-        for (auto& base : bases) {
-            m_swapchainImageContextMap.emplace(std::make_pair(base, &swapchainImageContext));
-        }
+        // Saved as soon as the context's pipeline is in it, in case the program doesn't get to exit cleanly.
+        m_pipelineCache.Save();
 
         return bases;
     }
 
+    // The context of the swapchain that swapchainImage belongs to.  There are only as many contexts as swapchains, one
+    // or two, so this is quicker than a map from every image to its context.
+    SwapchainImageContext* FindSwapchainImageContext(const XrSwapchainImageBaseHeader* swapchainImage) {
+        for (SwapchainImageContext& context : m_swapchainImageContexts) {
+            if (context.Contains(swapchainImage)) {
+                return &context;
+            }
+        }
+        THROW("Swapchain image was not allocated by this graphics plugin");
+    }
+
     void RenderView(const XrCompositionLayerProjectionView& layerView, const XrSwapchainImageBaseHeader* swapchainImage,
                     int64_t /*swapchainFormat*/, const std::vector<Cube>& cubes) override {
         CHECK(layerView.subImage.imageArrayIndex == 0);  // Texture arrays not supported.
 
-        auto swapchainContext = m_swapchainImageContextMap[swapchainImage];
+        SwapchainImageContext* const swapchainContext = FindSwapchainImageContext(swapchainImage);
         uint32_t imageIndex = swapchainContext->ImageIndex(swapchainImage);
 
-        m_cmdBuffer.Reset();
-        m_cmdBuffer.Begin();
+        CmdBuffer& cmdBuffer = NextCmdBuffer();
+        cmdBuffer.Reset();
+        cmdBuffer.Begin();
+
+        // Time the view's commands with a pair of timestamps, outside the render pass as their reset has to be.
+        FrameResources& frame = m_frames[m_frameIndex];
+        const bool timed = m_gpuTimerActive && frame.timestamps != VK_NULL_HANDLE && frame.timedViews < MaxTimedViews;
+        const uint32_t timestampQuery = 2 * frame.timedViews;
+        if (timed) {
+            frame.timedViews++;
+            vkCmdResetQueryPool(cmdBuffer.buf, frame.timestamps, timestampQuery, 2);
+            vkCmdWriteTimestamp(cmdBuffer.buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestamps, timestampQuery);
+        }
 
         // Bind and clear eye render target
         static XrColor4f darkSlateGrey = {0.184313729f, 0.309803933f, 0.309803933f, 1.0f};
@@ -1354,47 +1746,67 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
 
         swapchainContext->BindRenderTarget(imageIndex, &renderPassBeginInfo);
 
-        vkCmdBeginRenderPass(m_cmdBuffer.buf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-        vkCmdBindPipeline(m_cmdBuffer.buf, VK_PIPELINE_BIND_POINT_GRAPHICS, swapchainContext->pipe.pipe);
-
-        // Bind index and vertex buffers
-        vkCmdBindIndexBuffer(m_cmdBuffer.buf, m_drawBuffer.idxBuf, 0, VK_INDEX_TYPE_UINT16);
-        VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(m_cmdBuffer.buf, 0, 1, &m_drawBuffer.vtxBuf, &offset);
-
         // Compute the view-projection transform.
         // Note all matrixes (including OpenXR's) are column-major, right-handed.
         const auto& pose = layerView.pose;
         XrMatrix4x4f proj;
         XrMatrix4x4f_CreateProjectionFov(&proj, GRAPHICS_VULKAN, layerView.fov, 0.05f, 100.0f);
-        XrMatrix4x4f toView;
-        XrVector3f scale{1.f, 1.f, 1.f};
-        XrMatrix4x4f_CreateTranslationRotationScale(&toView, &pose.position, &pose.orientation, &scale);
         XrMatrix4x4f view;
-        XrMatrix4x4f_InvertRigidBody(&view, &toView);
+        XrMatrix4x4f_CreateViewFromPose(&view, &pose);
         XrMatrix4x4f vp;
         XrMatrix4x4f_Multiply(&vp, &proj, &view);
 
-        // Render each cube
-        for (const Cube& cube : cubes) {
-            // Compute the model-view-projection transform and push it.
-            XrMatrix4x4f model;
-            XrMatrix4x4f_CreateTranslationRotationScale(&model, &cube.Pose.position, &cube.Pose.orientation, &cube.Scale);
-            XrMatrix4x4f mvp;
-            XrMatrix4x4f_Multiply(&mvp, &vp, &model);
-            vkCmdPushConstants(m_cmdBuffer.buf, m_pipelineLayout.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mvp.m), &mvp.m[0]);
-
-            // Draw the cube.
-            vkCmdDrawIndexed(m_cmdBuffer.buf, m_drawBuffer.count.idx, 1, 0, 0, 0);
+        const uint32_t cubeCount = (uint32_t)cubes.size();
+        const uint32_t sliceCount = CubeSliceCount(cubeCount);
+        if (sliceCount > 1) {
+            // The render pass is left to the recorders' secondary command buffers, each with a slice of the cubes.
+            vkCmdBeginRenderPass(cmdBuffer.buf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            RecordCubeSlices(swapchainContext->pipe.pipe, renderPassBeginInfo, layerView.subImage.imageRect, vp, cubes, sliceCount);
+            vkCmdExecuteCommands(cmdBuffer.buf, sliceCount, m_recordedSlices.data());
+        } else if (!cubes.empty()) {
+            vkCmdBeginRenderPass(cmdBuffer.buf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+            vkCmdBindPipeline(cmdBuffer.buf, VK_PIPELINE_BIND_POINT_GRAPHICS, swapchainContext->pipe.pipe);
+            VkViewport viewport;
+            VkRect2D scissor;
+            ImageRectViewport(layerView.subImage.imageRect, &viewport, &scissor);
+            vkCmdSetViewport(cmdBuffer.buf, 0, 1, &viewport);
+            vkCmdSetScissor(cmdBuffer.buf, 0, 1, &scissor);
+
+            // Render all the cubes with one instanced draw.
+            // Write every cube's model transform straight into the frame's dynamic buffer.
+            VkBuffer instanceBuffer;
+            VkDeviceSize instanceOffset;
+            void* instances = frame.dynamicBuffer.Allocate(sizeof(XrMatrix4x4f) * cubeCount, sizeof(XrMatrix4x4f), &instanceBuffer,
+                                                           &instanceOffset);
+            XrMatrix4x4f_CreateTranslationRotationScaleArray(static_cast<XrMatrix4x4f*>(instances), &cubes[0].Pose, sizeof(Cube),
+                                                             &cubes[0].Scale, sizeof(Cube), (int)cubeCount);
+
+            // Bind index, vertex and instance buffers
+            vkCmdBindIndexBuffer(cmdBuffer.buf, m_drawBuffer.idxBuf, 0, VK_INDEX_TYPE_UINT16);
+            const std::array<VkBuffer, 2> vertexBuffers = {{m_drawBuffer.vtxBuf, instanceBuffer}};
+            const std::array<VkDeviceSize, 2> offsets = {{0, instanceOffset}};
+            vkCmdBindVertexBuffers(cmdBuffer.buf, 0, (uint32_t)vertexBuffers.size(), vertexBuffers.data(), offsets.data());
+
+            // Push the view-projection transform.
+            vkCmdPushConstants(cmdBuffer.buf, m_pipelineLayout.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(vp.m), &vp.m[0]);
+
+            // Draw the cubes.
+            vkCmdDrawIndexed(cmdBuffer.buf, m_drawBuffer.count.idx, cubeCount, 0, 0, 0);
+        } else {
+            vkCmdBeginRenderPass(cmdBuffer.buf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
         }
 
-        vkCmdEndRenderPass(m_cmdBuffer.buf);
+        vkCmdEndRenderPass(cmdBuffer.buf);
 
-        m_cmdBuffer.End();
-        m_cmdBuffer.Exec(m_vkQueue);
-        // XXX Should double-buffer the command buffers, for now just flush
-        m_cmdBuffer.Wait();
+        if (timed) {
+            vkCmdWriteTimestamp(cmdBuffer.buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestamps, timestampQuery + 1);
+        }
+
+        cmdBuffer.End();
+        cmdBuffer.Exec(m_vkQueue);
+        // Not waited for here: the runtime orders its own work after what was submitted before the image was released,
+        // and BeginFrame waits before this command buffer is recorded again.
 
 #if defined(USE_MIRROR_WINDOW)
         // Cycle the window's swapchain on the last view rendered
@@ -1405,10 +1817,265 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
 #endif
     }
 
+    void BeginFrame() override {
+        // Move on to the oldest frame's command buffers and dynamic buffer, waiting for the GPU to finish with them so they
+        // can be reused.  xrWaitFrame has already throttled the application, so this rarely has to wait.
+        m_frameIndex = (m_frameIndex + 1) % FramesInFlight;
+        WaitForFrame(m_frames[m_frameIndex]);
+    }
+
+    void BeginGpuTimer() override { m_gpuTimerActive = true; }
+
+    void EndGpuTimer() override { m_gpuTimerActive = false; }
+
+    int64_t GetGpuFrameTime() const override { return m_gpuFrameTime; }
+
    private:
+    // The resources of one frame: a command buffer for each view rendered, the dynamic data they read, and a pair of
+    // timestamps for each view timed.
+    struct FrameResources {
+        std::vector<std::unique_ptr<CmdBuffer>> cmdBuffers;
+        size_t used = 0;
+        DynamicBuffer dynamicBuffer;
+        VkQueryPool timestamps{VK_NULL_HANDLE};  // Only created when the queue writes timestamps
+        uint32_t timedViews = 0;
+    };
+
+    // A frame's command buffers are recorded while the previous frame's may still be executing.
+    static constexpr uint32_t FramesInFlight = 2;
+
+    // The views of a frame past this many go untimed.
+    static constexpr uint32_t MaxTimedViews = 4;
+
+    void WaitForFrame(FrameResources& frame) {
+        for (size_t i = 0; i < frame.used; ++i) {
+            if (!frame.cmdBuffers[i]->Wait()) THROW("Failed to wait for command buffer");
+        }
+        frame.used = 0;
+        frame.dynamicBuffer.Reset();
+        const size_t frameIndex = &frame - m_frames.data();
+        for (const std::unique_ptr<CubeRecorder>& recorder : m_cubeRecorders) {
+            CubeRecorder::FramePool& framePool = recorder->framePools[frameIndex];
+            if (framePool.used != 0) {
+                CHECK_VKCMD(vkResetCommandPool(m_vkDevice, framePool.pool, 0));
+                framePool.used = 0;
+            }
+        }
+
+        // Having finished, the frame's timestamps can be read without waiting.  Its GPU time is the sum of its views'.
+        if (frame.timedViews != 0) {
+            std::array<uint64_t, 2 * MaxTimedViews> timestamps;
+            if (vkGetQueryPoolResults(m_vkDevice, frame.timestamps, 0, 2 * frame.timedViews, sizeof(timestamps),
+                                      timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+                uint64_t ticks = 0;
+                for (uint32_t view = 0; view < frame.timedViews; ++view) {
+                    ticks += timestamps[2 * view + 1] - timestamps[2 * view];
+                }
+                m_gpuFrameTime = (int64_t)(ticks * m_timestampPeriod);
+            }
+            frame.timedViews = 0;
+        }
+    }
+
+    // Records a slice of each view's cubes, from their model transforms to their draw, into a secondary command buffer for
+    // the view's render pass.  All but the first, which the rendering thread records, have a thread of their own.
+    struct CubeRecorder {
+        // The secondary command buffers of a frame in flight, in a pool only the recorder's thread allocates from.
+        struct FramePool {
+            VkCommandPool pool{VK_NULL_HANDLE};
+            std::vector<VkCommandBuffer> bufs;
+            size_t used = 0;
+        };
+        std::array<FramePool, FramesInFlight> framePools;
+        VkCommandBuffer recorded{VK_NULL_HANDLE};  // The slice just recorded
+        std::exception_ptr error;                   // Thrown while recording, rethrown by RecordCubeSlices
+        std::thread thread;
+    };
+
+    // What the recorders need to record their slices of a view's cubes.
+    struct CubeSlices {
+        const std::vector<Cube>* cubes = nullptr;
+        uint32_t sliceCount = 0;
+        uint32_t sliceSize = 0;
+        XrMatrix4x4f* instances = nullptr;
+        VkBuffer instanceBuffer{VK_NULL_HANDLE};
+        VkDeviceSize instanceOffset = 0;
+        VkPipeline pipeline{VK_NULL_HANDLE};
+        VkCommandBufferInheritanceInfo inheritance{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+        VkViewport viewport{};
+        VkRect2D scissor{};
+        XrMatrix4x4f viewProjection;
+    };
+
+    // The viewport and scissor that render to an image rect.
+    static void ImageRectViewport(const XrRect2Di& imageRect, VkViewport* viewport, VkRect2D* scissor) {
+        const float x = (float)imageRect.offset.x;
+        const float y = (float)imageRect.offset.y;
+        const float width = (float)imageRect.extent.width;
+        const float height = (float)imageRect.extent.height;
+#if defined(ORIGIN_BOTTOM_LEFT)
+        // Flipped view so origin is bottom-left like GL (requires VK_KHR_maintenance1)
+        *viewport = {x, y + height, width, -height, 0.0f, 1.0f};
+#else
+        // Will invert y after projection
+        *viewport = {x, y, width, height, 0.0f, 1.0f};
+#endif
+        scissor->offset = {imageRect.offset.x, imageRect.offset.y};
+        scissor->extent = {(uint32_t)imageRect.extent.width, (uint32_t)imageRect.extent.height};
+    }
+
+    // Fewer cubes than this per slice and the threads cost more than they save.
+    static constexpr uint32_t MinCubesPerSlice = 256;
+
+    // How many slices to record a view with that many cubes in, 1 to record it all inline.
+    uint32_t CubeSliceCount(uint32_t cubeCount) const {
+        const uint32_t fullSlices = cubeCount / MinCubesPerSlice;
+        return fullSlices < m_recordThreads + 1 ? fullSlices : m_recordThreads + 1;
+    }
+
+    // Records the cubes in sliceCount secondary command buffers, left in m_recordedSlices in order.
+    void RecordCubeSlices(VkPipeline pipeline, const VkRenderPassBeginInfo& renderPassBeginInfo, const XrRect2Di& imageRect,
+                          const XrMatrix4x4f& viewProjection, const std::vector<Cube>& cubes, uint32_t sliceCount) {
+        while (m_cubeRecorders.size() < sliceCount) {
+            std::unique_ptr<CubeRecorder> recorder(new CubeRecorder());
+            for (CubeRecorder::FramePool& framePool : recorder->framePools) {
+                VkCommandPoolCreateInfo cmdPoolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+                cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                cmdPoolInfo.queueFamilyIndex = m_queueFamilyIndex;
+                CHECK_VKCMD(vkCreateCommandPool(m_vkDevice, &cmdPoolInfo, nullptr, &framePool.pool));
+            }
+            const uint32_t slice = (uint32_t)m_cubeRecorders.size();
+            if (slice > 0) {
+                // Started from the current batch, so as not to look at m_cubeSlices before the next is published.
+                CubeRecorder* const recorderPointer = recorder.get();
+                const uint64_t batch = m_recordBatch;
+                recorder->thread =
+                    std::thread([this, recorderPointer, slice, batch] { CubeRecorderThread(*recorderPointer, slice, batch); });
+            }
+            m_cubeRecorders.push_back(std::move(recorder));
+        }
+
+        // The transforms go in one allocation, each recorder writing its own part of it, as the buffer isn't thread safe.
+        const uint32_t cubeCount = (uint32_t)cubes.size();
+        CubeSlices& job = m_cubeSlices;
+        job.cubes = &cubes;
+        job.sliceCount = sliceCount;
+        job.sliceSize = (cubeCount + sliceCount - 1) / sliceCount;
+        job.instances = static_cast<XrMatrix4x4f*>(m_frames[m_frameIndex].dynamicBuffer.Allocate(
+            sizeof(XrMatrix4x4f) * cubeCount, sizeof(XrMatrix4x4f), &job.instanceBuffer, &job.instanceOffset));
+        job.pipeline = pipeline;
+        job.inheritance.renderPass = renderPassBeginInfo.renderPass;
+        job.inheritance.subpass = 0;
+        job.inheritance.framebuffer = renderPassBeginInfo.framebuffer;
+        ImageRectViewport(imageRect, &job.viewport, &job.scissor);
+        job.viewProjection = viewProjection;
+        {
+            std::lock_guard<std::mutex> lock(m_recordMutex);
+            m_recordPending = sliceCount - 1;
+            m_recordBatch++;
+        }
+        m_recordCondition.notify_all();
+
+        RecordCubeSlice(*m_cubeRecorders[0], 0);
+        {
+            std::unique_lock<std::mutex> lock(m_recordMutex);
+            m_recordDoneCondition.wait(lock, [this] { return m_recordPending == 0; });
+        }
+
+        m_recordedSlices.resize(sliceCount);
+        for (uint32_t slice = 0; slice < sliceCount; ++slice) {
+            CubeRecorder& recorder = *m_cubeRecorders[slice];
+            if (recorder.error) {
+                const std::exception_ptr error = recorder.error;
+                recorder.error = nullptr;
+                std::rethrow_exception(error);
+            }
+            m_recordedSlices[slice] = recorder.recorded;
+        }
+    }
+
+    void RecordCubeSlice(CubeRecorder& recorder, uint32_t slice) {
+        try {
+            const CubeSlices& job = m_cubeSlices;
+            const uint32_t first = slice * job.sliceSize;
+            const uint32_t cubeCount = (uint32_t)job.cubes->size();
+            const uint32_t count = cubeCount - first < job.sliceSize ? cubeCount - first : job.sliceSize;
+            const Cube* const cubes = job.cubes->data() + first;
+            XrMatrix4x4f_CreateTranslationRotationScaleArray(job.instances + first, &cubes[0].Pose, sizeof(Cube), &cubes[0].Scale,
+                                                             sizeof(Cube), (int)count);
+
+            CubeRecorder::FramePool& framePool = recorder.framePools[m_frameIndex];
+            if (framePool.used == framePool.bufs.size()) {
+                VkCommandBufferAllocateInfo cmd{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+                cmd.commandPool = framePool.pool;
+                cmd.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                cmd.commandBufferCount = 1;
+                VkCommandBuffer buf;
+                CHECK_VKCMD(vkAllocateCommandBuffers(m_vkDevice, &cmd, &buf));
+                framePool.bufs.push_back(buf);
+            }
+            const VkCommandBuffer buf = framePool.bufs[framePool.used++];
+
+            VkCommandBufferBeginInfo cmdBeginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+            cmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            cmdBeginInfo.pInheritanceInfo = &job.inheritance;
+            CHECK_VKCMD(vkBeginCommandBuffer(buf, &cmdBeginInfo));
+
+            vkCmdBindPipeline(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, job.pipeline);
+            vkCmdSetViewport(buf, 0, 1, &job.viewport);
+            vkCmdSetScissor(buf, 0, 1, &job.scissor);
+            vkCmdBindIndexBuffer(buf, m_drawBuffer.idxBuf, 0, VK_INDEX_TYPE_UINT16);
+            const std::array<VkBuffer, 2> vertexBuffers = {{m_drawBuffer.vtxBuf, job.instanceBuffer}};
+            const std::array<VkDeviceSize, 2> offsets = {{0, job.instanceOffset}};
+            vkCmdBindVertexBuffers(buf, 0, (uint32_t)vertexBuffers.size(), vertexBuffers.data(), offsets.data());
+            vkCmdPushConstants(buf, m_pipelineLayout.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(job.viewProjection.m),
+                               &job.viewProjection.m[0]);
+            vkCmdDrawIndexed(buf, m_drawBuffer.count.idx, count, 0, 0, first);
+
+            CHECK_VKCMD(vkEndCommandBuffer(buf));
+            recorder.recorded = buf;
+        } catch (...) {
+            recorder.error = std::current_exception();
+        }
+    }
+
+    // Records the slice of the given index of every view with that many slices or more.
+    void CubeRecorderThread(CubeRecorder& recorder, uint32_t slice, uint64_t batch) {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_recordMutex);
+                m_recordCondition.wait(lock, [this, batch] { return m_recordStop || m_recordBatch != batch; });
+                if (m_recordStop) {
+                    return;
+                }
+                batch = m_recordBatch;
+                if (slice >= m_cubeSlices.sliceCount) {
+                    continue;
+                }
+            }
+
+            RecordCubeSlice(recorder, slice);
+
+            std::lock_guard<std::mutex> lock(m_recordMutex);
+            if (--m_recordPending == 0) {
+                m_recordDoneCondition.notify_one();
+            }
+        }
+    }
+
+    // The current frame's next command buffer, created the first time that many views are rendered in a frame.
+    CmdBuffer& NextCmdBuffer() {
+        FrameResources& frame = m_frames[m_frameIndex];
+        if (frame.used == frame.cmdBuffers.size()) {
+            frame.cmdBuffers.emplace_back(new CmdBuffer());
+            if (!frame.cmdBuffers.back()->Init(m_vkDevice, m_queueFamilyIndex)) THROW("Failed to create command buffer");
+        }
+        return *frame.cmdBuffers[frame.used++];
+    }
+
     XrGraphicsBindingVulkanKHR m_graphicsBinding{XR_TYPE_GRAPHICS_BINDING_VULKAN_KHR};
+    MemoryAllocator m_memAllocator{};  // Before everything allocated from it, so that it is destroyed after them
     std::list<SwapchainImageContext> m_swapchainImageContexts;
-    std::map<const XrSwapchainImageBaseHeader*, SwapchainImageContext*> m_swapchainImageContextMap;
 
     VkInstance m_vkInstance{VK_NULL_HANDLE};
     VkPhysicalDevice m_vkPhysicalDevice{VK_NULL_HANDLE};
@@ -1418,12 +2085,30 @@ struct VulkanGraphicsPlugin : public IGraphicsPlugin {
     VkSemaphore m_vkDrawDone{VK_NULL_HANDLE};
     uint32_t m_vkDeviceLocalHeap = 0;
 
-    MemoryAllocator m_memAllocator{};
     ShaderProgram m_shaderProgram{};
-    CmdBuffer m_cmdBuffer{};
+    CmdBuffer m_cmdBuffer{};  // For work done once, at initialization
+    std::array<FrameResources, FramesInFlight> m_frames;
+    uint32_t m_frameIndex = 0;
+    float m_timestampPeriod = 0;  // Nanoseconds per timestamp tick, or 0 if the queue doesn't write timestamps
+    bool m_gpuTimerActive = false;
+    int64_t m_gpuFrameTime = -1;
     PipelineLayout m_pipelineLayout{};
+    PipelineCache m_pipelineCache{};
     VertexBuffer<Geometry::Vertex> m_drawBuffer{};
 
+    // With Options::RecordThreads, RenderView hands slices of the cubes to the recorders; m_recordBatch is incremented to
+    // start the recorder threads on the view published in m_cubeSlices.
+    const uint32_t m_recordThreads;
+    std::vector<std::unique_ptr<CubeRecorder>> m_cubeRecorders;
+    std::vector<VkCommandBuffer> m_recordedSlices;
+    CubeSlices m_cubeSlices;
+    std::mutex m_recordMutex;
+    std::condition_variable m_recordCondition;
+    std::condition_variable m_recordDoneCondition;
+    uint64_t m_recordBatch{0};
+    uint32_t m_recordPending{0};  // Recorder threads still recording
+    bool m_recordStop{false};
+
 #if defined(USE_MIRROR_WINDOW)
     Swapchain m_swapchain{};
 #endif
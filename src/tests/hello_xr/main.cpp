@@ -11,12 +11,20 @@ void ShowHelp() {
     // TODO: Improve/update when things are more settled.
     Log::Write(Log::Level::Info,
                "HelloXr --graphics|-g <Graphics API> [--formfactor|-ff <Form factor>] [--viewconfig|-vc <View config>] "
-               "[--blendmode|-bm <Blend mode>] [--space|-s <Space>]");
+               "[--blendmode|-bm <Blend mode>] [--space|-s <Space>] [--pipelined|-p] [--parallelviews|-pv] "
+               "[--recordthreads|-rt <Count>] [--dynamicresolution|-dr] [--hud|-hud] "
+               "[--frametimes|-ft <File>]");
     Log::Write(Log::Level::Info, "Graphics APIs:            D3D11, D3D12, OpenGLES, OpenGL, Vulkan");
     Log::Write(Log::Level::Info, "Form factors:             Hmd, Handheld");
     Log::Write(Log::Level::Info, "View configurations:      Mono, Stereo");
     Log::Write(Log::Level::Info, "Environment blend modes:  Opaque, Additive, AlphaBlend");
     Log::Write(Log::Level::Info, "Spaces:                   View, Local, Stage");
+    Log::Write(Log::Level::Info, "Pipelined:                render on a separate thread from xrWaitFrame and input");
+    Log::Write(Log::Level::Info, "Parallel views:           record each view on its own thread (D3D11)");
+    Log::Write(Log::Level::Info, "Record threads:           worker threads to record the cubes of each view with (Vulkan)");
+    Log::Write(Log::Level::Info, "Dynamic resolution:       scale the views' image rects to the GPU time");
+    Log::Write(Log::Level::Info, "HUD:                      a quad layer rendered once, in front of the views");
+    Log::Write(Log::Level::Info, "Frame times:              CSV file, or Chrome trace if the name ends in .json");
 }
 
 bool UpdateOptionsFromCommandLine(Options& options, int argc, char* argv[]) {
@@ -42,6 +50,18 @@ bool UpdateOptionsFromCommandLine(Options& options, int argc, char* argv[]) {
             options.EnvironmentBlendMode = getNextArg();
         } else if (EqualsIgnoreCase(arg, "--space") || EqualsIgnoreCase(arg, "-s")) {
             options.AppSpace = getNextArg();
+        } else if (EqualsIgnoreCase(arg, "--pipelined") || EqualsIgnoreCase(arg, "-p")) {
+            options.Pipelined = true;
+        } else if (EqualsIgnoreCase(arg, "--parallelviews") || EqualsIgnoreCase(arg, "-pv")) {
+            options.ParallelViews = true;
+        } else if (EqualsIgnoreCase(arg, "--recordthreads") || EqualsIgnoreCase(arg, "-rt")) {
+            options.RecordThreads = (uint32_t)std::stoul(getNextArg());
+        } else if (EqualsIgnoreCase(arg, "--dynamicresolution") || EqualsIgnoreCase(arg, "-dr")) {
+            options.DynamicResolution = true;
+        } else if (EqualsIgnoreCase(arg, "--hud") || EqualsIgnoreCase(arg, "-hud")) {
+            options.Hud = true;
+        } else if (EqualsIgnoreCase(arg, "--frametimes") || EqualsIgnoreCase(arg, "-ft")) {
+            options.FrameTimesFile = getNextArg();
         } else if (EqualsIgnoreCase(arg, "--verbose") || EqualsIgnoreCase(arg, "-v")) {
             Log::SetLevel(Log::Level::Verbose);
         } else if (EqualsIgnoreCase(arg, "--help") || EqualsIgnoreCase(arg, "-h")) {
@@ -108,7 +128,7 @@ int main(int argc, char* argv[]) {
                     program->RenderFrame();
                 } else {
                     // Throttle loop since xrWaitFrame won't be called.
-                    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+                    program->WaitForEvents();
                 }
             }
 
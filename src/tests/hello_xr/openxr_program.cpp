@@ -4,6 +4,10 @@
 #include "platformplugin.h"
 #include "graphicsplugin.h"
 #include "openxr_program.h"
+#include "allocationcounter.h"
+#include "frametimes.h"
+#include "actionstates.h"
+#include "resolutionscaler.h"
 #include <common/xr_linear.h>
 #include <array>
 
@@ -13,6 +17,10 @@ namespace {
 #define strcpy_s(dest, source) strncpy((dest), (source), sizeof(dest))
 #endif
 
+// The bounds of the interval WaitForEvents polls for events at.
+constexpr std::chrono::milliseconds MinEventPollInterval{1};
+constexpr std::chrono::milliseconds MaxEventPollInterval{250};
+
 namespace Side {
 const int LEFT = 0;
 const int RIGHT = 1;
@@ -115,12 +123,130 @@ inline std::string GetXrPathString(XrInstance instance, XrPath path) {
     return pathStr;
 }
 
+// Locates a batch of spaces in one base space at one time.  A small batch is located in turn on the calling thread; from
+// ParallelThreshold spaces up, it is split between the calling thread and a few workers, as xrLocateSpace may be called
+// from any thread.  The workers are only started by the first batch that large, so a scene with a handful of spaces
+// never pays for them.  None of the extensions in this registry locates several spaces in one call; a runtime that
+// offered one would be used from Locate.
+class SpaceLocator {
+   public:
+    static constexpr size_t ParallelThreshold = 64;
+    static constexpr uint32_t MaxWorkerCount = 3;
+
+    SpaceLocator() {
+        const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        m_workerCount = hardwareThreads > MaxWorkerCount ? MaxWorkerCount : (hardwareThreads > 0 ? hardwareThreads - 1 : 0);
+    }
+
+    ~SpaceLocator() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_startCondition.notify_all();
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    // Locates spaces[i] into locations[i], which must be initialized XrSpaceLocation structures, and stores the result of
+    // each in results[i].
+    void Locate(const XrSpace* spaces, size_t count, XrSpace baseSpace, XrTime time, XrSpaceLocation* locations,
+                XrResult* results) {
+        m_spaces = spaces;
+        m_count = count;
+        m_baseSpace = baseSpace;
+        m_time = time;
+        m_locations = locations;
+        m_results = results;
+
+        if (count < ParallelThreshold || m_workerCount == 0) {
+            LocatePart(0, 1);
+            return;
+        }
+
+        if (m_workers.empty()) {
+            for (uint32_t worker = 0; worker < m_workerCount; worker++) {
+                m_workers.emplace_back([this, worker] { WorkerThread(worker); });
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batch++;
+            m_pendingWorkers = m_workerCount;
+        }
+        m_startCondition.notify_all();
+
+        LocatePart(0, m_workerCount + 1);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock, [this] { return m_pendingWorkers == 0; });
+    }
+
+   private:
+    // Locates the part of the batch with the given index, of partCount equal parts.
+    void LocatePart(size_t part, size_t partCount) {
+        const size_t end = m_count * (part + 1) / partCount;
+        for (size_t i = m_count * part / partCount; i < end; i++) {
+            m_results[i] = xrLocateSpace(m_spaces[i], m_baseSpace, m_time, &m_locations[i]);
+        }
+    }
+
+    void WorkerThread(uint32_t worker) {
+        uint64_t batch = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_startCondition.wait(lock, [this, batch] { return m_stop || m_batch != batch; });
+                if (m_stop) {
+                    return;
+                }
+                batch = m_batch;
+            }
+
+            // The calling thread takes the first part.
+            LocatePart(worker + 1, m_workerCount + 1);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pendingWorkers == 0) {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+
+    uint32_t m_workerCount{0};
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_startCondition;
+    std::condition_variable m_doneCondition;
+    uint64_t m_batch{0};  // Incremented to start the workers on a batch
+    uint32_t m_pendingWorkers{0};
+    bool m_stop{false};
+
+    // The batch being located, published to the workers by m_mutex
+    const XrSpace* m_spaces{nullptr};
+    size_t m_count{0};
+    XrSpace m_baseSpace{XR_NULL_HANDLE};
+    XrTime m_time{0};
+    XrSpaceLocation* m_locations{nullptr};
+    XrResult* m_results{nullptr};
+};
+
 struct OpenXrProgram : IOpenXrProgram {
     OpenXrProgram(const std::shared_ptr<Options>& options, const std::shared_ptr<IPlatformPlugin>& platformPlugin,
                   const std::shared_ptr<IGraphicsPlugin>& graphicsPlugin)
-        : m_options(options), m_platformPlugin(platformPlugin), m_graphicsPlugin(graphicsPlugin) {}
+        : m_options(options), m_platformPlugin(platformPlugin), m_graphicsPlugin(graphicsPlugin) {
+        if (!m_options->FrameTimesFile.empty()) {
+            m_frameTimes.reset(new FrameTimesRecorder(m_options->FrameTimesFile));
+        }
+        if (m_options->DynamicResolution) {
+            m_resolutionScaler.reset(new ResolutionScaler());
+        }
+    }
 
     ~OpenXrProgram() {
+        StopRenderThread();
+
         if (m_input.actionSet != XR_NULL_HANDLE) {
             for (auto hand : {Side::LEFT, Side::RIGHT}) {
                 xrDestroySpace(m_input.handSpace[hand]);
@@ -132,6 +258,14 @@ struct OpenXrProgram : IOpenXrProgram {
             xrDestroySwapchain(swapchain.handle);
         }
 
+        if (m_hudSwapchain.handle != XR_NULL_HANDLE) {
+            xrDestroySwapchain(m_hudSwapchain.handle);
+        }
+
+        if (m_hudSpace != XR_NULL_HANDLE) {
+            xrDestroySpace(m_hudSpace);
+        }
+
         for (XrSpace visualizedSpace : m_visualizedSpaces) {
             xrDestroySpace(visualizedSpace);
         }
@@ -355,6 +489,12 @@ struct OpenXrProgram : IOpenXrProgram {
         std::array<XrSpace, Side::COUNT> handSpace;
         std::array<float, Side::COUNT> handScale;
         std::array<XrBool32, Side::COUNT> renderHand;
+
+        // The states of the input actions for each hand, by their index in states
+        ActionStates states;
+        std::array<uint32_t, Side::COUNT> grabState;
+        std::array<uint32_t, Side::COUNT> quitState;
+        std::array<uint32_t, Side::COUNT> poseState;
     };
 
     void InitializeActions() {
@@ -407,6 +547,13 @@ struct OpenXrProgram : IOpenXrProgram {
             CHECK_XRCMD(xrCreateAction(m_input.actionSet, &actionInfo, &m_input.quitAction));
         }
 
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            const XrPath subactionPath = m_input.handSubactionPath[hand];
+            m_input.grabState[hand] = m_input.states.Add(m_input.grabAction, XR_ACTION_TYPE_FLOAT_INPUT, subactionPath);
+            m_input.quitState[hand] = m_input.states.Add(m_input.quitAction, XR_ACTION_TYPE_BOOLEAN_INPUT, subactionPath);
+            m_input.poseState[hand] = m_input.states.Add(m_input.poseAction, XR_ACTION_TYPE_POSE_INPUT, subactionPath);
+        }
+
         std::array<XrPath, Side::COUNT> selectPath;
         std::array<XrPath, Side::COUNT> squeezeValuePath;
         std::array<XrPath, Side::COUNT> squeezeClickPath;
@@ -560,6 +707,11 @@ struct OpenXrProgram : IOpenXrProgram {
             XrReferenceSpaceCreateInfo referenceSpaceCreateInfo = GetXrReferenceSpaceCreateInfo(m_options->AppSpace);
             CHECK_XRCMD(xrCreateReferenceSpace(m_session, &referenceSpaceCreateInfo, &m_appSpace));
         }
+
+        if (m_options->Hud) {
+            XrReferenceSpaceCreateInfo referenceSpaceCreateInfo = GetXrReferenceSpaceCreateInfo("View");
+            CHECK_XRCMD(xrCreateReferenceSpace(m_session, &referenceSpaceCreateInfo, &m_hudSpace));
+        }
     }
 
     void CreateSwapchains() override {
@@ -593,9 +745,6 @@ struct OpenXrProgram : IOpenXrProgram {
         CHECK_XRCMD(xrEnumerateViewConfigurationViews(m_instance, m_systemId, m_viewConfigType, viewCount, &viewCount,
                                                       m_configViews.data()));
 
-        // Create and cache view buffer for xrLocateViews later.
-        m_views.resize(viewCount, {XR_TYPE_VIEW});
-
         // Create the swapchain and get the images.
         if (viewCount > 0) {
             // Select a swapchain format.
@@ -620,19 +769,48 @@ struct OpenXrProgram : IOpenXrProgram {
                 Log::Write(Log::Level::Verbose, Fmt("Swapchain Formats: %s", swapchainFormatsString.c_str()));
             }
 
-            // Create a swapchain for each view.
-            for (uint32_t i = 0; i < viewCount; i++) {
+            // Ahead of the views' swapchains, so that theirs are still the last images the graphics plugin allocated.
+            if (m_options->Hud) {
+                CreateHudSwapchain();
+            }
+
+            // When the graphics plugin can render every view in one pass and the views all want the same size of image,
+            // create a single swapchain with an array layer for each view. Otherwise create a swapchain for each view.
+            const XrViewConfigurationView& firstView = m_configViews[0];
+            m_multiView = m_graphicsPlugin->SupportsMultiView(viewCount) &&
+                          std::all_of(m_configViews.begin(), m_configViews.end(), [&](const XrViewConfigurationView& view) {
+                              return view.recommendedImageRectWidth == firstView.recommendedImageRectWidth &&
+                                     view.recommendedImageRectHeight == firstView.recommendedImageRectHeight &&
+                                     view.recommendedSwapchainSampleCount == firstView.recommendedSwapchainSampleCount;
+                          });
+            const uint32_t swapchainCount = m_multiView ? 1 : viewCount;
+            const uint32_t arraySize = m_multiView ? viewCount : 1;
+
+            for (uint32_t i = 0; i < swapchainCount; i++) {
                 const XrViewConfigurationView& vp = m_configViews[i];
-                Log::Write(Log::Level::Info,
-                           Fmt("Creating swapchain for view %d with dimensions Width=%d Height=%d SampleCount=%d", i,
-                               vp.recommendedImageRectWidth, vp.recommendedImageRectHeight, vp.recommendedSwapchainSampleCount));
+                // With dynamic resolution the images are as large as the views are ever scaled to, within the maximum.
+                uint32_t width = vp.recommendedImageRectWidth;
+                uint32_t height = vp.recommendedImageRectHeight;
+                if (m_resolutionScaler) {
+                    width = std::min((uint32_t)std::ceil(width * ResolutionScaler::MaxScale), vp.maxImageRectWidth);
+                    height = std::min((uint32_t)std::ceil(height * ResolutionScaler::MaxScale), vp.maxImageRectHeight);
+                }
+                if (m_multiView) {
+                    Log::Write(Log::Level::Info, Fmt("Creating swapchain for all %d views with dimensions Width=%d Height=%d "
+                                                     "SampleCount=%d",
+                                                     viewCount, width, height, vp.recommendedSwapchainSampleCount));
+                } else {
+                    Log::Write(Log::Level::Info, Fmt("Creating swapchain for view %d with dimensions Width=%d Height=%d "
+                                                     "SampleCount=%d",
+                                                     i, width, height, vp.recommendedSwapchainSampleCount));
+                }
 
                 // Create the swapchain.
                 XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
-                swapchainCreateInfo.arraySize = 1;
+                swapchainCreateInfo.arraySize = arraySize;
                 swapchainCreateInfo.format = m_colorSwapchainFormat;
-                swapchainCreateInfo.width = vp.recommendedImageRectWidth;
-                swapchainCreateInfo.height = vp.recommendedImageRectHeight;
+                swapchainCreateInfo.width = width;
+                swapchainCreateInfo.height = height;
                 swapchainCreateInfo.mipCount = 1;
                 swapchainCreateInfo.faceCount = 1;
                 swapchainCreateInfo.sampleCount = vp.recommendedSwapchainSampleCount;
@@ -651,11 +829,48 @@ struct OpenXrProgram : IOpenXrProgram {
                     m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
                 CHECK_XRCMD(xrEnumerateSwapchainImages(swapchain.handle, imageCount, &imageCount, swapchainImages[0]));
 
-                m_swapchainImages.insert(std::make_pair(swapchain.handle, std::move(swapchainImages)));
+                m_swapchainImages.push_back(std::move(swapchainImages));
             }
         }
     }
 
+    // The HUD's swapchain has a single static image, which can only be acquired once: it is rendered the first frame that
+    // is, and from then on the runtime composites the same image for as long as the session lasts.
+    void CreateHudSwapchain() {
+        Log::Write(Log::Level::Info, Fmt("Creating static swapchain for the HUD with dimensions Width=%d Height=%d", HudImageWidth,
+                                         HudImageHeight));
+
+        XrSwapchainCreateInfo swapchainCreateInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+        swapchainCreateInfo.createFlags = XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT;
+        swapchainCreateInfo.arraySize = 1;
+        swapchainCreateInfo.format = m_colorSwapchainFormat;
+        swapchainCreateInfo.width = HudImageWidth;
+        swapchainCreateInfo.height = HudImageHeight;
+        swapchainCreateInfo.mipCount = 1;
+        swapchainCreateInfo.faceCount = 1;
+        swapchainCreateInfo.sampleCount = 1;
+        swapchainCreateInfo.usageFlags = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+        m_hudSwapchain.width = swapchainCreateInfo.width;
+        m_hudSwapchain.height = swapchainCreateInfo.height;
+        CHECK_XRCMD(xrCreateSwapchain(m_session, &swapchainCreateInfo, &m_hudSwapchain.handle));
+
+        uint32_t imageCount;
+        CHECK_XRCMD(xrEnumerateSwapchainImages(m_hudSwapchain.handle, 0, &imageCount, nullptr));
+        m_hudSwapchainImages = m_graphicsPlugin->AllocateSwapchainImageStructs(imageCount, swapchainCreateInfo);
+        CHECK_XRCMD(xrEnumerateSwapchainImages(m_hudSwapchain.handle, imageCount, &imageCount, m_hudSwapchainImages[0]));
+
+        // Head-locked, a little below the middle of the view.
+        m_hudLayer = {XR_TYPE_COMPOSITION_LAYER_QUAD};
+        m_hudLayer.space = m_hudSpace;
+        m_hudLayer.eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+        m_hudLayer.subImage.swapchain = m_hudSwapchain.handle;
+        m_hudLayer.subImage.imageRect.offset = {0, 0};
+        m_hudLayer.subImage.imageRect.extent = {m_hudSwapchain.width, m_hudSwapchain.height};
+        m_hudLayer.subImage.imageArrayIndex = 0;
+        m_hudLayer.pose = Math::Pose::Translation({0.0f, -0.15f, -1.0f});
+        m_hudLayer.size = {HudWidth, HudWidth * HudImageHeight / HudImageWidth};
+    }
+
     // Return event if one is available, otherwise return null.
     const XrEventDataBaseHeader* TryReadNextEvent() {
         // It is sufficient to clear the just the XrEventDataBuffer header to XR_TYPE_EVENT_DATA_BUFFER
@@ -681,6 +896,7 @@ struct OpenXrProgram : IOpenXrProgram {
 
         // Process all pending messages.
         while (const XrEventDataBaseHeader* event = TryReadNextEvent()) {
+            m_eventPollInterval = MinEventPollInterval;
             switch (event->type) {
                 case XR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING: {
                     const auto& instanceLossPending = *reinterpret_cast<const XrEventDataInstanceLossPending*>(event);
@@ -729,11 +945,15 @@ struct OpenXrProgram : IOpenXrProgram {
                 sessionBeginInfo.primaryViewConfigurationType = m_viewConfigType;
                 CHECK_XRCMD(xrBeginSession(m_session, &sessionBeginInfo));
                 m_sessionRunning = true;
+                if (m_options->Pipelined) {
+                    StartRenderThread();
+                }
                 break;
             }
             case XR_SESSION_STATE_STOPPING: {
                 CHECK(m_session != XR_NULL_HANDLE);
                 m_sessionRunning = false;
+                StopRenderThread();
                 CHECK_XRCMD(xrEndSession(m_session))
                 break;
             }
@@ -784,6 +1004,13 @@ struct OpenXrProgram : IOpenXrProgram {
                                          ((sourceName.size() > 0) ? sourceName.c_str() : " nothing")));
     }
 
+    void WaitForEvents() override {
+        // OpenXR has nothing to block on for an event, so this sleeps with a backoff: briefly after an event, as the
+        // state changes up to XR_SESSION_STATE_READY come in quick succession, and longer the longer nothing happens.
+        std::this_thread::sleep_for(m_eventPollInterval);
+        m_eventPollInterval = std::min(2 * m_eventPollInterval, MaxEventPollInterval);
+    }
+
     bool IsSessionRunning() const override { return m_sessionRunning; }
 
     bool IsSessionFocused() const override { return m_sessionState == XR_SESSION_STATE_FOCUSED; }
@@ -798,18 +1025,18 @@ struct OpenXrProgram : IOpenXrProgram {
             syncInfo.activeActionSets = &activeActionSet;
             CHECK_XRCMD(xrSyncActions(m_session, &syncInfo));
 
-            // Get pose and grab action state and start haptic vibrate when hand is 90% squeezed.
+            // Fetch every action state in one pass, then only react to what changed.  Vibrate while a hand is 90% squeezed;
+            // each vibration lasts the shortest duration, so it is applied again every frame.
+            const ActionStates& states = m_input.states;
+            m_input.states.Fetch(m_session);
             for (auto hand : {Side::LEFT, Side::RIGHT}) {
-                XrActionStateGetInfo getInfo{XR_TYPE_ACTION_STATE_GET_INFO};
-                getInfo.action = m_input.grabAction;
-                getInfo.subactionPath = m_input.handSubactionPath[hand];
-
-                XrActionStateFloat grabValue{XR_TYPE_ACTION_STATE_FLOAT};
-                CHECK_XRCMD(xrGetActionStateFloat(m_session, &getInfo, &grabValue));
-                if (grabValue.isActive) {
-                    // Scale the rendered hand by 1.0f (open) to 0.5f (fully squeezed).
-                    m_input.handScale[hand] = 1.0f - 0.5f * grabValue.currentState;
-                    if (grabValue.currentState > 0.9f) {
+                const uint32_t grab = m_input.grabState[hand];
+                if (states.IsActive(grab)) {
+                    if (states.Changed(grab)) {
+                        // Scale the rendered hand by 1.0f (open) to 0.5f (fully squeezed).
+                        m_input.handScale[hand] = 1.0f - 0.5f * states.Value(grab);
+                    }
+                    if (states.Value(grab) > 0.9f) {
                         XrHapticVibration vibration{XR_TYPE_HAPTIC_VIBRATION};
                         vibration.amplitude = 0.5;
                         vibration.duration = XR_MIN_HAPTIC_DURATION;
@@ -822,54 +1049,82 @@ struct OpenXrProgram : IOpenXrProgram {
                     }
                 }
 
-                getInfo.action = m_input.quitAction;
-                XrActionStateBoolean quitValue{XR_TYPE_ACTION_STATE_BOOLEAN};
-                CHECK_XRCMD(xrGetActionStateBoolean(m_session, &getInfo, &quitValue));
-                if (quitValue.isActive && quitValue.changedSinceLastSync && quitValue.currentState) {
+                const uint32_t quit = m_input.quitState[hand];
+                if (states.IsActive(quit) && states.Changed(quit) && states.Value(quit) != 0.0f) {
                     CHECK_XRCMD(xrRequestExitSession(m_session));
                 }
 
-                getInfo.action = m_input.poseAction;
-                XrActionStatePose poseState{XR_TYPE_ACTION_STATE_POSE};
-                CHECK_XRCMD(xrGetActionStatePose(m_session, &getInfo, &poseState));
-                m_input.renderHand[hand] = poseState.isActive;
+                m_input.renderHand[hand] = states.IsActive(m_input.poseState[hand]) ? XR_TRUE : XR_FALSE;
             }
         }
     }
 
+    // Everything needed to render a frame, once RenderFrame has waited for it and located the views and the cubes.  The
+    // containers keep their storage from one frame to the next, so that once they have grown a frame doesn't allocate.
+    struct FrameData {
+        XrFrameState frameState{XR_TYPE_FRAME_STATE};
+        bool viewsLocated{false};
+        std::vector<XrView> views;
+        std::vector<Cube> cubes;
+
+        // Filled in by SubmitFrame
+        std::vector<XrCompositionLayerBaseHeader*> layers;
+        XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
+        std::vector<XrCompositionLayerProjectionView> projectionLayerViews;
+        std::vector<const XrSwapchainImageBaseHeader*> swapchainImages;  // Without multiview, that of each view
+        float resolutionScale{1.0f};  // Of the recommended image size, with Options::DynamicResolution
+
+        FrameTimes times;  // Only kept when the frame times are recorded
+    };
+
+    // Logs the heap allocations the calling thread has made since its count was allocationCount.  A frame is expected to
+    // allocate only while the containers it reuses grow, so any other report points at a per-frame allocation.  The count
+    // includes whatever the runtime and the graphics driver allocate on this thread.
+    static void LogFrameAllocations(const char* stage, uint64_t allocationCount) {
+        const uint64_t frameAllocations = AllocationCounter::ThreadCount() - allocationCount;
+        if (frameAllocations != 0) {
+            Log::Write(Log::Level::Verbose, Fmt("%s made %llu heap allocations", stage, (unsigned long long)frameAllocations));
+        }
+    }
+
     void RenderFrame() override {
         CHECK(m_session != XR_NULL_HANDLE);
+        const uint64_t allocationCount = AllocationCounter::ThreadCount();
+
+        if (m_frameTimes) {
+            m_frame.times = {};
+            m_frame.times.FrameIndex = m_frameCount++;
+            m_frame.times.WaitStart = m_frameTimes->Now();
+        }
 
         XrFrameWaitInfo frameWaitInfo{XR_TYPE_FRAME_WAIT_INFO};
-        XrFrameState frameState{XR_TYPE_FRAME_STATE};
-        CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &frameState));
+        m_frame.frameState = {XR_TYPE_FRAME_STATE};
+        CHECK_XRCMD(xrWaitFrame(m_session, &frameWaitInfo, &m_frame.frameState));
 
-        XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
-        CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+        if (m_frameTimes) {
+            m_frame.times.WaitDuration = m_frameTimes->Now() - m_frame.times.WaitStart;
+        }
 
-        std::vector<XrCompositionLayerBaseHeader*> layers;
-        XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
-        std::vector<XrCompositionLayerProjectionView> projectionLayerViews;
-        if (frameState.shouldRender) {
-            if (RenderLayer(frameState.predictedDisplayTime, projectionLayerViews, layer)) {
-                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&layer));
-            }
+        m_frame.viewsLocated = m_frame.frameState.shouldRender && LocateFrame(m_frame);
+
+        if (m_options->Pipelined) {
+            // Hand the frame to the render thread, and return to poll events and input for the next one while it renders.
+            SubmitToRenderThread();
+        } else {
+            SubmitFrame(m_frame);
         }
 
-        XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
-        frameEndInfo.displayTime = frameState.predictedDisplayTime;
-        frameEndInfo.environmentBlendMode = m_environmentBlendMode;
-        frameEndInfo.layerCount = (uint32_t)layers.size();
-        frameEndInfo.layers = layers.data();
-        CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+        LogFrameAllocations("RenderFrame", allocationCount);
     }
 
-    bool RenderLayer(XrTime predictedDisplayTime, std::vector<XrCompositionLayerProjectionView>& projectionLayerViews,
-                     XrCompositionLayerProjection& layer) {
+    // Locates the views and the cubes to draw at the frame's predicted display time.
+    bool LocateFrame(FrameData& frame) {
         XrResult res;
+        const XrTime predictedDisplayTime = frame.frameState.predictedDisplayTime;
 
+        frame.views.resize(m_configViews.size(), {XR_TYPE_VIEW});
         XrViewState viewState{XR_TYPE_VIEW_STATE};
-        uint32_t viewCapacityInput = (uint32_t)m_views.size();
+        uint32_t viewCapacityInput = (uint32_t)frame.views.size();
         uint32_t viewCountOutput;
 
         XrViewLocateInfo viewLocateInfo{XR_TYPE_VIEW_LOCATE_INFO};
@@ -877,56 +1132,168 @@ struct OpenXrProgram : IOpenXrProgram {
         viewLocateInfo.displayTime = predictedDisplayTime;
         viewLocateInfo.space = m_appSpace;
 
-        res = xrLocateViews(m_session, &viewLocateInfo, &viewState, viewCapacityInput, &viewCountOutput, m_views.data());
+        res = xrLocateViews(m_session, &viewLocateInfo, &viewState, viewCapacityInput, &viewCountOutput, frame.views.data());
         CHECK_XRRESULT(res, "xrLocateViews");
-        if (XR_UNQUALIFIED_SUCCESS(res)) {
-            CHECK(viewCountOutput == viewCapacityInput);
-            CHECK(viewCountOutput == m_configViews.size());
-            CHECK(viewCountOutput == m_swapchains.size());
-
-            projectionLayerViews.resize(viewCountOutput);
-
-            // For each locatable space that we want to visualize, render a 25cm cube.
-            std::vector<Cube> cubes;
+        if (!XR_UNQUALIFIED_SUCCESS(res)) {
+            Log::Write(Log::Level::Verbose, Fmt("xrLocateViews returned qualified success code: %s", to_string(res)));
+            return false;
+        }
+        CHECK(viewCountOutput == viewCapacityInput);
+        CHECK(viewCountOutput == m_configViews.size());
+
+        // Locate every space there is a cube for in one batch: the visualized spaces, then the hands being rendered.
+        // Note renderHand will only be true when the application has focus.
+        m_locateSpaces.assign(m_visualizedSpaces.begin(), m_visualizedSpaces.end());
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            if (m_input.renderHand[hand]) {
+                m_locateSpaces.push_back(m_input.handSpace[hand]);
+            }
+        }
+        m_spaceLocations.assign(m_locateSpaces.size(), {XR_TYPE_SPACE_LOCATION});
+        m_spaceLocateResults.resize(m_locateSpaces.size());
+        m_spaceLocator.Locate(m_locateSpaces.data(), m_locateSpaces.size(), m_appSpace, predictedDisplayTime,
+                              m_spaceLocations.data(), m_spaceLocateResults.data());
+
+        // For each locatable space that we want to visualize, render a 25cm cube.
+        std::vector<Cube>& cubes = frame.cubes;
+        cubes.clear();
+
+        size_t located = 0;
+        for (; located < m_visualizedSpaces.size(); located++) {
+            const XrSpaceLocation& spaceLocation = m_spaceLocations[located];
+            res = m_spaceLocateResults[located];
+            CHECK_XRRESULT(res, "xrLocateSpace");
+            if (XR_UNQUALIFIED_SUCCESS(res)) {
+                if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
+                    (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
+                    cubes.push_back(Cube{spaceLocation.pose, {0.25f, 0.25f, 0.25f}});
+                }
+            } else {
+                Log::Write(Log::Level::Verbose, Fmt("Unable to locate a visualized reference space in app space: %d", res));
+            }
+        }
 
-            for (XrSpace visualizedSpace : m_visualizedSpaces) {
-                XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION};
-                res = xrLocateSpace(visualizedSpace, m_appSpace, predictedDisplayTime, &spaceLocation);
+        // Render a 10cm cube scaled by grabAction for each hand.
+        for (auto hand : {Side::LEFT, Side::RIGHT}) {
+            if (m_input.renderHand[hand]) {
+                const XrSpaceLocation& spaceLocation = m_spaceLocations[located];
+                res = m_spaceLocateResults[located++];
                 CHECK_XRRESULT(res, "xrLocateSpace");
                 if (XR_UNQUALIFIED_SUCCESS(res)) {
                     if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
                         (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
-                        cubes.push_back(Cube{spaceLocation.pose, {0.25f, 0.25f, 0.25f}});
+                        float scale = 0.1f * m_input.handScale[hand];
+                        cubes.push_back(Cube{spaceLocation.pose, {scale, scale, scale}});
                     }
                 } else {
-                    Log::Write(Log::Level::Verbose, Fmt("Unable to locate a visualized reference space in app space: %d", res));
+                    const char* handName[] = {"left", "right"};
+                    Log::Write(Log::Level::Verbose,
+                               Fmt("Unable to locate %s hand action space in app space: %d", handName[hand], res));
                 }
             }
+        }
 
-            // Render a 10cm cube scaled by grabAction for each hand. Note renderHand will only be true when the application has
-            // focus.
-            for (auto hand : {Side::LEFT, Side::RIGHT}) {
-                if (m_input.renderHand[hand]) {
-                    XrSpaceLocation spaceLocation{XR_TYPE_SPACE_LOCATION};
-                    res = xrLocateSpace(m_input.handSpace[hand], m_appSpace, predictedDisplayTime, &spaceLocation);
-                    CHECK_XRRESULT(res, "xrLocateSpace");
-                    if (XR_UNQUALIFIED_SUCCESS(res)) {
-                        if ((spaceLocation.locationFlags & XR_SPACE_LOCATION_POSITION_VALID_BIT) != 0 &&
-                            (spaceLocation.locationFlags & XR_SPACE_LOCATION_ORIENTATION_VALID_BIT) != 0) {
-                            float scale = 0.1f * m_input.handScale[hand];
-                            cubes.push_back(Cube{spaceLocation.pose, {scale, scale, scale}});
-                        }
-                    } else {
-                        const char* handName[] = {"left", "right"};
-                        Log::Write(Log::Level::Verbose,
-                                   Fmt("Unable to locate %s hand action space in app space: %d", handName[hand], res));
-                    }
+        return true;
+    }
+
+    // Begins, renders and ends a frame that RenderFrame waited for and located.
+    void SubmitFrame(FrameData& frame) {
+        if (m_frameTimes) {
+            frame.times.SubmitStart = m_frameTimes->Now();
+        }
+
+        XrFrameBeginInfo frameBeginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+        CHECK_XRCMD(xrBeginFrame(m_session, &frameBeginInfo));
+        m_graphicsPlugin->BeginFrame();
+        if (m_frameTimes || m_resolutionScaler) {
+            m_graphicsPlugin->BeginGpuTimer();
+        }
+        if (m_resolutionScaler) {
+            frame.resolutionScale =
+                m_resolutionScaler->Update(m_graphicsPlugin->GetGpuFrameTime(), frame.frameState.predictedDisplayPeriod);
+        }
+
+        std::vector<XrCompositionLayerBaseHeader*>& layers = frame.layers;
+        layers.clear();
+        if (frame.viewsLocated) {
+            RenderLayer(frame);
+            layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&frame.layer));
+
+            if (m_hudSwapchain.handle != XR_NULL_HANDLE) {
+                if (!m_hudRendered) {
+                    RenderHud();
+                    m_hudRendered = true;
                 }
+                layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&m_hudLayer));
+            }
+        }
+
+        XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO};
+        frameEndInfo.displayTime = frame.frameState.predictedDisplayTime;
+        frameEndInfo.environmentBlendMode = m_environmentBlendMode;
+        frameEndInfo.layerCount = (uint32_t)layers.size();
+        frameEndInfo.layers = layers.data();
+        if (m_frameTimes || m_resolutionScaler) {
+            m_graphicsPlugin->EndGpuTimer();
+        }
+        CHECK_XRCMD(xrEndFrame(m_session, &frameEndInfo));
+
+        if (m_frameTimes) {
+            FrameTimes& times = frame.times;
+            times.SubmitDuration = m_frameTimes->Now() - times.SubmitStart;
+            times.GpuDuration = m_graphicsPlugin->GetGpuFrameTime();
+            times.PredictedDisplayTime = frame.frameState.predictedDisplayTime;
+            times.PredictedDisplayPeriod = frame.frameState.predictedDisplayPeriod;
+            times.ShouldRender = frame.frameState.shouldRender == XR_TRUE;
+            times.LayerCount = (uint32_t)layers.size();
+            m_frameTimes->Record(times);
+        }
+    }
+
+    void RenderLayer(FrameData& frame) {
+        const std::vector<XrView>& views = frame.views;
+        const std::vector<Cube>& cubes = frame.cubes;
+        std::vector<XrCompositionLayerProjectionView>& projectionLayerViews = frame.projectionLayerViews;
+        XrCompositionLayerProjection& layer = frame.layer;
+        const uint32_t viewCountOutput = (uint32_t)views.size();
+        CHECK(m_swapchains.size() == (m_multiView ? 1 : viewCountOutput));
+
+        projectionLayerViews.resize(viewCountOutput);
+
+        if (m_multiView) {
+            // Every view is in its own layer of the one swapchain, which is acquired, rendered to in a single pass, and
+            // released.
+            const Swapchain viewSwapchain = m_swapchains[0];
+
+            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+
+            uint32_t swapchainImageIndex;
+            CHECK_XRCMD(xrAcquireSwapchainImage(viewSwapchain.handle, &acquireInfo, &swapchainImageIndex));
+
+            WaitSwapchainImage(viewSwapchain.handle, 0);
+
+            for (uint32_t i = 0; i < viewCountOutput; i++) {
+                projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+                projectionLayerViews[i].pose = views[i].pose;
+                projectionLayerViews[i].fov = views[i].fov;
+                projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
+                projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
+                projectionLayerViews[i].subImage.imageRect.extent = ViewImageExtent(viewSwapchain, m_configViews[0], frame);
+                projectionLayerViews[i].subImage.imageArrayIndex = i;
             }
 
-            // Render view to the appropriate part of the swapchain image.
+            const XrSwapchainImageBaseHeader* const swapchainImage = m_swapchainImages[0][swapchainImageIndex];
+            m_graphicsPlugin->RenderMultiView(projectionLayerViews, swapchainImage, m_colorSwapchainFormat, cubes);
+
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            CHECK_XRCMD(xrReleaseSwapchainImage(viewSwapchain.handle, &releaseInfo));
+        } else {
+            // Each view has a separate swapchain.  All of them are acquired up front, each image waited for only when its
+            // view is about to be rendered, which the graphics plugin may record concurrently, and then all of them
+            // released.
+            std::vector<const XrSwapchainImageBaseHeader*>& swapchainImages = frame.swapchainImages;
+            swapchainImages.resize(viewCountOutput);
             for (uint32_t i = 0; i < viewCountOutput; i++) {
-                // Each view has a separate swapchain which is acquired, rendered to, and released.
                 const Swapchain viewSwapchain = m_swapchains[i];
 
                 XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
@@ -934,33 +1301,161 @@ struct OpenXrProgram : IOpenXrProgram {
                 uint32_t swapchainImageIndex;
                 CHECK_XRCMD(xrAcquireSwapchainImage(viewSwapchain.handle, &acquireInfo, &swapchainImageIndex));
 
-                XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
-                waitInfo.timeout = XR_INFINITE_DURATION;
-                CHECK_XRCMD(xrWaitSwapchainImage(viewSwapchain.handle, &waitInfo));
-
                 projectionLayerViews[i] = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
-                projectionLayerViews[i].pose = m_views[i].pose;
-                projectionLayerViews[i].fov = m_views[i].fov;
+                projectionLayerViews[i].pose = views[i].pose;
+                projectionLayerViews[i].fov = views[i].fov;
                 projectionLayerViews[i].subImage.swapchain = viewSwapchain.handle;
                 projectionLayerViews[i].subImage.imageRect.offset = {0, 0};
-                projectionLayerViews[i].subImage.imageRect.extent = {viewSwapchain.width, viewSwapchain.height};
+                projectionLayerViews[i].subImage.imageRect.extent = ViewImageExtent(viewSwapchain, m_configViews[i], frame);
 
-                const XrSwapchainImageBaseHeader* const swapchainImage =
-                    m_swapchainImages[viewSwapchain.handle][swapchainImageIndex];
-                m_graphicsPlugin->RenderView(projectionLayerViews[i], swapchainImage, m_colorSwapchainFormat, cubes);
+                swapchainImages[i] = m_swapchainImages[i][swapchainImageIndex];
+            }
+
+            m_graphicsPlugin->RenderViews(projectionLayerViews, swapchainImages, m_colorSwapchainFormat, cubes,
+                                          [this](size_t view) { WaitSwapchainImage(m_swapchains[view].handle, (uint32_t)view); });
 
+            for (uint32_t i = 0; i < viewCountOutput; i++) {
                 XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
-                CHECK_XRCMD(xrReleaseSwapchainImage(viewSwapchain.handle, &releaseInfo));
+                CHECK_XRCMD(xrReleaseSwapchainImage(m_swapchains[i].handle, &releaseInfo));
             }
+        }
 
-            layer.space = m_appSpace;
-            layer.viewCount = (uint32_t)projectionLayerViews.size();
-            layer.views = projectionLayerViews.data();
-            return true;
-        } else {
-            Log::Write(Log::Level::Verbose, Fmt("xrLocateViews returned qualified success code: %s", to_string(res)));
-            return false;
+        layer.space = m_appSpace;
+        layer.viewCount = (uint32_t)projectionLayerViews.size();
+        layer.views = projectionLayerViews.data();
+    }
+
+    // Renders the HUD's content, a cube seen from straight in front, to the static image of its swapchain.  The graphics
+    // plugin renders it as it would a projection view, onto the same background.
+    void RenderHud() {
+        XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+        uint32_t swapchainImageIndex;
+        CHECK_XRCMD(xrAcquireSwapchainImage(m_hudSwapchain.handle, &acquireInfo, &swapchainImageIndex));
+
+        WaitSwapchainImage(m_hudSwapchain.handle, (uint32_t)m_configViews.size());
+
+        XrCompositionLayerProjectionView hudView{XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW};
+        hudView.pose = Math::Pose::Identity();
+        const float halfWidth = std::atan(0.5f);
+        const float halfHeight = std::atan(0.5f * HudImageHeight / HudImageWidth);
+        hudView.fov = {-halfWidth, halfWidth, halfHeight, -halfHeight};
+        hudView.subImage.swapchain = m_hudSwapchain.handle;
+        hudView.subImage.imageRect.offset = {0, 0};
+        hudView.subImage.imageRect.extent = {m_hudSwapchain.width, m_hudSwapchain.height};
+
+        // Turned 45 degrees about a diagonal axis, so that three of its faces show.
+        const std::vector<Cube> cubes = {Cube{{{0.2706f, 0.2706f, 0.0f, 0.9239f}, {0.0f, 0.0f, -1.0f}}, {0.2f, 0.2f, 0.2f}}};
+        m_graphicsPlugin->RenderView(hudView, m_hudSwapchainImages[swapchainImageIndex], m_colorSwapchainFormat, cubes);
+
+        XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+        CHECK_XRCMD(xrReleaseSwapchainImage(m_hudSwapchain.handle, &releaseInfo));
+    }
+
+    // The part of a swapchain's images, from their origin, that a view is rendered to: all of them, unless the views
+    // are scaled to the frame's resolution scale.
+    XrExtent2Di ViewImageExtent(const Swapchain& swapchain, const XrViewConfigurationView& configView,
+                                const FrameData& frame) const {
+        if (!m_resolutionScaler) {
+            return {swapchain.width, swapchain.height};
+        }
+        const int32_t width = (int32_t)(configView.recommendedImageRectWidth * frame.resolutionScale + 0.5f);
+        const int32_t height = (int32_t)(configView.recommendedImageRectHeight * frame.resolutionScale + 0.5f);
+        return {std::max(1, std::min(width, swapchain.width)), std::max(1, std::min(height, swapchain.height))};
+    }
+
+    // How long xrWaitSwapchainImage is given before a still busy image is reported, and how long before it is given up on.
+    static constexpr XrDuration SwapchainWaitTimeout = 100 * 1000 * 1000;
+    static constexpr XrDuration SwapchainWaitLimit = 5LL * 1000 * 1000 * 1000;
+
+    // Waits for the acquired image of a swapchain, logging every SwapchainWaitTimeout it is still not ready for so that a
+    // stall shows up in the log instead of hanging the frame without a word.
+    void WaitSwapchainImage(XrSwapchain swapchain, uint32_t view) {
+        XrSwapchainImageWaitInfo waitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+        waitInfo.timeout = SwapchainWaitTimeout;
+        XrDuration waited = 0;
+        for (;;) {
+            const XrResult res = xrWaitSwapchainImage(swapchain, &waitInfo);
+            CHECK_XRRESULT(res, "xrWaitSwapchainImage");
+            if (res != XR_TIMEOUT_EXPIRED) {
+                break;
+            }
+            waited += SwapchainWaitTimeout;
+            if (waited >= SwapchainWaitLimit) {
+                THROW(Fmt("Swapchain image of view %u not ready after %lld ms", view, (long long)(waited / 1000000)));
+            }
+            Log::Write(Log::Level::Warning,
+                       Fmt("Still waiting for the swapchain image of view %u after %lld ms", view, (long long)(waited / 1000000)));
+        }
+        if (waited > 0) {
+            Log::Write(Log::Level::Warning,
+                       Fmt("Swapchain image of view %u was ready after more than %lld ms", view, (long long)(waited / 1000000)));
+        }
+    }
+
+    // Waits for the render thread to take the previous frame, then gives it this one.
+    void SubmitToRenderThread() {
+        std::unique_lock<std::mutex> lock(m_renderMutex);
+        m_renderCondition.wait(lock, [this] { return !m_framePending || m_renderError; });
+        if (m_renderError) {
+            std::rethrow_exception(m_renderError);
+        }
+        std::swap(m_frame, m_pendingFrame);
+        m_framePending = true;
+        m_renderCondition.notify_all();
+    }
+
+    void StartRenderThread() {
+        CHECK(!m_renderThread.joinable());
+        m_stopRenderThread = false;
+        m_renderError = nullptr;
+        m_graphicsPlugin->UnbindFromCurrentThread();
+        m_renderThread = std::thread([this] { RenderThread(); });
+    }
+
+    // Lets the render thread finish every frame it has been given, then joins it.
+    void StopRenderThread() {
+        if (!m_renderThread.joinable()) {
+            return;
         }
+        {
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            m_stopRenderThread = true;
+        }
+        m_renderCondition.notify_all();
+        m_renderThread.join();
+        m_graphicsPlugin->BindToCurrentThread();
+    }
+
+    // Begins, renders and ends each frame handed over by SubmitToRenderThread, concurrently with the xrWaitFrame, input
+    // and space location of the next, as the spec allows xrWaitFrame to be called from another thread than xrBeginFrame.
+    void RenderThread() {
+        FrameData frame;
+        try {
+            m_graphicsPlugin->BindToCurrentThread();
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(m_renderMutex);
+                    m_renderCondition.wait(lock, [this] { return m_framePending || m_stopRenderThread; });
+                    if (!m_framePending) {
+                        break;
+                    }
+                    std::swap(frame, m_pendingFrame);
+                    m_framePending = false;
+                }
+                m_renderCondition.notify_all();
+
+                const uint64_t allocationCount = AllocationCounter::ThreadCount();
+                SubmitFrame(frame);
+                LogFrameAllocations("SubmitFrame", allocationCount);
+            }
+        } catch (...) {
+            // Rethrown on the main thread the next time it submits a frame.
+            std::lock_guard<std::mutex> lock(m_renderMutex);
+            m_renderError = std::current_exception();
+            m_framePending = false;
+            m_renderCondition.notify_all();
+        }
+        m_graphicsPlugin->UnbindFromCurrentThread();
     }
 
    private:
@@ -978,17 +1473,49 @@ struct OpenXrProgram : IOpenXrProgram {
     XrViewConfigurationProperties m_viewConfig{};
     std::vector<XrViewConfigurationView> m_configViews;
     std::vector<Swapchain> m_swapchains;
-    std::map<XrSwapchain, std::vector<XrSwapchainImageBaseHeader*>> m_swapchainImages;
-    std::vector<XrView> m_views;
+    bool m_multiView{false};  // One swapchain with a layer for each view, rather than a swapchain for each
+    std::vector<std::vector<XrSwapchainImageBaseHeader*>> m_swapchainImages;  // Indexed like m_swapchains
     int64_t m_colorSwapchainFormat{-1};
 
+    // With Options::Hud, a head-locked quad layer HudWidth meters wide, showing an image of HudImageWidth by HudImageHeight
+    static constexpr int32_t HudImageWidth = 512;
+    static constexpr int32_t HudImageHeight = 256;
+    static constexpr float HudWidth = 0.4f;
+    XrSpace m_hudSpace{XR_NULL_HANDLE};
+    Swapchain m_hudSwapchain{XR_NULL_HANDLE, 0, 0};
+    std::vector<XrSwapchainImageBaseHeader*> m_hudSwapchainImages;
+    XrCompositionLayerQuad m_hudLayer{XR_TYPE_COMPOSITION_LAYER_QUAD};
+    bool m_hudRendered{false};  // Only used by the thread that submits the frames
+
     std::vector<XrSpace> m_visualizedSpaces;
 
+    // The spaces located for each frame, with their locations and results, kept to reuse their storage
+    std::vector<XrSpace> m_locateSpaces;
+    std::vector<XrSpaceLocation> m_spaceLocations;
+    std::vector<XrResult> m_spaceLocateResults;
+    SpaceLocator m_spaceLocator;
+
+    FrameData m_frame;  // Filled in by RenderFrame
+    std::unique_ptr<FrameTimesRecorder> m_frameTimes;  // Set when the frame times are recorded
+    std::unique_ptr<ResolutionScaler> m_resolutionScaler;  // Set with Options::DynamicResolution
+    uint64_t m_frameCount{0};
+
+    // With Options::Pipelined, frames are rendered on m_renderThread.  m_pendingFrame takes one at a time from RenderFrame
+    // to the render thread, which swaps it for the frame it has just finished so that nothing is reallocated.
+    std::thread m_renderThread;
+    std::mutex m_renderMutex;
+    std::condition_variable m_renderCondition;
+    FrameData m_pendingFrame;
+    bool m_framePending{false};
+    bool m_stopRenderThread{false};
+    std::exception_ptr m_renderError;
+
     // Application's current lifecycle state according to the runtime
     XrSessionState m_sessionState{XR_SESSION_STATE_UNKNOWN};
     bool m_sessionRunning{false};
 
     XrEventDataBuffer m_eventDataBuffer;
+    std::chrono::milliseconds m_eventPollInterval{MinEventPollInterval};  // How long WaitForEvents next sleeps for
     InputState m_input{XR_NULL_HANDLE};
 };
 }  // namespace
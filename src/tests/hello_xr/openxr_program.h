@@ -20,6 +20,9 @@ struct IOpenXrProgram {
     // Process any events in the event queue.
     virtual void PollEvents(bool* exitRenderLoop, bool* requestRestart) = 0;
 
+    // Wait for an event to arrive, for a while at most, in place of xrWaitFrame while the session isn't running.
+    virtual void WaitForEvents() = 0;
+
     // Manage session lifecycle to track if RenderFrame should be called.
     virtual bool IsSessionRunning() const = 0;
 
@@ -10,4 +10,23 @@ struct Options {
     std::string EnvironmentBlendMode{"Opaque"};
 
     std::string AppSpace{"Local"};
+
+    // Render each frame on a thread of its own while the main thread waits for, and locates, the next.
+    bool Pipelined{false};
+
+    // Record the views of a frame concurrently, each on a thread of its own, where the graphics plugin supports it.
+    bool ParallelViews{false};
+
+    // Worker threads to record each view's cubes with, alongside the rendering thread, where the graphics plugin supports
+    // it.  0 to record them all on the rendering thread.
+    uint32_t RecordThreads{0};
+
+    // Render the views to a part of larger swapchain images, scaled every frame to keep their GPU time within budget.
+    bool DynamicResolution{false};
+
+    // Show a head-locked HUD on a quad layer of its own, rendered once to a static swapchain image rather than every frame.
+    bool Hud{false};
+
+    // Where to write the times of every frame, as CSV or, if it ends in .json, as a Chrome trace.  Empty for none.
+    std::string FrameTimesFile;
 };
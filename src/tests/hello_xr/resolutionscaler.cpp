@@ -0,0 +1,34 @@
+#include "pch.h"
+#include "common.h"
+#include "resolutionscaler.h"
+#include <cmath>
+
+namespace {
+// The share of the display period the views may take on the GPU, leaving the rest to the runtime's compositor.
+constexpr double BudgetFraction = 0.8;
+
+// How far from the budget the GPU time may be before the scale changes.
+constexpr double DeadBand = 0.1;
+
+// The most the scale changes by in one update.
+constexpr double MaxStepDown = 0.9;
+constexpr double MaxStepUp = 1.02;
+
+double Clamp(double value, double low, double high) { return value < low ? low : (value > high ? high : value); }
+}  // namespace
+
+float ResolutionScaler::Update(int64_t gpuTime, XrDuration displayPeriod) {
+    if (gpuTime <= 0 || displayPeriod <= 0 || gpuTime == m_lastGpuTime) {
+        return m_scale;
+    }
+    m_lastGpuTime = gpuTime;
+
+    const double ratio = BudgetFraction * (double)displayPeriod / (double)gpuTime;
+    if (ratio > 1.0 - DeadBand && ratio < 1.0 + DeadBand) {
+        return m_scale;
+    }
+
+    const double step = Clamp(std::sqrt(ratio), MaxStepDown, MaxStepUp);
+    m_scale = (float)Clamp(m_scale * step, MinScale, MaxScale);
+    return m_scale;
+}
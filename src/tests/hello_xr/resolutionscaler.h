@@ -0,0 +1,18 @@
+#pragma once
+
+// Picks the scale of the recommended image size to render each frame's views at, so that their GPU time stays within a
+// budget of the display period.  The GPU time goes with the number of pixels, the square of the scale, so the scale
+// moves by the square root of how far the time is from the budget: quickly down, slowly up, and not at all while the
+// time is close enough to the budget.
+struct ResolutionScaler {
+    static constexpr float MinScale = 0.5f;
+    static constexpr float MaxScale = 1.5f;
+
+    // Updates the scale from the GPU time of a recent frame, or -1 if there is none yet, and the display period, both in
+    // nanoseconds.  A GPU time the same as the last one is taken to be of the same frame and ignored.  Returns the scale.
+    float Update(int64_t gpuTime, XrDuration displayPeriod);
+
+   private:
+    float m_scale{1.0f};
+    int64_t m_lastGpuTime{-1};
+};
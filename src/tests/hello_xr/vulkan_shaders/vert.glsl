@@ -6,11 +6,12 @@
 
 layout (std140, push_constant) uniform buf
 {
-    mat4 mvp;
+    mat4 viewProjection;
 } ubuf;
 
 layout (location = 0) in vec3 Position;
 layout (location = 1) in vec3 Color;
+layout (location = 2) in mat4 Model;
 
 layout (location = 0) out vec4 oColor;
 out gl_PerVertex
@@ -22,5 +23,5 @@ void main()
 {
     oColor.rgb  = Color.rgb;
     oColor.a  = 1.0;
-    gl_Position = ubuf.mvp * vec4(Position, 1);
+    gl_Position = ubuf.viewProjection * (Model * vec4(Position, 1));
 }
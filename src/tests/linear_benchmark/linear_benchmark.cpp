@@ -0,0 +1,212 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the throughput of the math kernels in xr_linear.h, once built with XR_LINEAR_NO_SIMD and once as
+// xr_linear.h builds them by default, so that the SIMD paths can be compared against the plain C paths they stand in
+// for and a change that slows either of them down shows up.
+//
+// Every kernel works through the same arrays of matrices, poses, vectors and bounds, sized to stay in the cache, for a
+// number of passes.  The batched kernels take the whole array in one call; the others are called once per element.
+// Only an optimized build gives meaningful numbers.
+//
+// Usage: linear_benchmark [--iterations=<passes over the data>] [--format=text|csv]
+
+#include "linear_benchmark.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+const uint32_t kDefaultIterations = 2000;
+const size_t kElementCount = 1024;
+
+struct BenchmarkResult {
+    double ns_per_op;
+    double ops_per_second;
+};
+
+// A small generator, so that every run times the same data.
+class BenchmarkRandom {
+   public:
+    // A value in [low, high).
+    float Next(float low, float high) {
+        _state = _state * 1664525u + 1013904223u;
+        return low + (high - low) * static_cast<float>(_state >> 8) / static_cast<float>(1u << 24);
+    }
+
+   private:
+    uint32_t _state = 1;
+};
+
+void CreateData(LinearBenchmarkData& data) {
+    BenchmarkRandom random;
+    const size_t count = kElementCount;
+    data.count = count;
+
+    data.matrices.resize(count);
+    data.rigidBodies.resize(count);
+    data.poses.resize(count);
+    data.scales.resize(count);
+    data.vectors.resize(count);
+    data.mins.resize(count);
+    data.maxs.resize(count);
+    data.minX.resize(count);
+    data.minY.resize(count);
+    data.minZ.resize(count);
+    data.maxX.resize(count);
+    data.maxY.resize(count);
+    data.maxZ.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        XrPosef& pose = data.poses[i];
+        pose.position = {random.Next(-20.0f, 20.0f), random.Next(-20.0f, 20.0f), random.Next(-20.0f, 20.0f)};
+        XrQuaternionf orientation = {random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f),
+                                     random.Next(-1.0f, 1.0f)};
+        const float length = std::sqrt(orientation.x * orientation.x + orientation.y * orientation.y +
+                                       orientation.z * orientation.z + orientation.w * orientation.w);
+        pose.orientation = {orientation.x / length, orientation.y / length, orientation.z / length, orientation.w / length};
+        data.scales[i] = {random.Next(0.5f, 2.0f), random.Next(0.5f, 2.0f), random.Next(0.5f, 2.0f)};
+
+        XrMatrix4x4f_CreateTranslationRotationScale(&data.matrices[i], &pose.position, &pose.orientation, &data.scales[i]);
+        const XrVector3f unitScale = {1.0f, 1.0f, 1.0f};
+        XrMatrix4x4f_CreateTranslationRotationScale(&data.rigidBodies[i], &pose.position, &pose.orientation, &unitScale);
+
+        data.vectors[i] = {pose.position.x, pose.position.y, pose.position.z, 1.0f};
+
+        const XrVector3f extent = {random.Next(0.1f, 2.0f), random.Next(0.1f, 2.0f), random.Next(0.1f, 2.0f)};
+        data.mins[i] = {pose.position.x - extent.x, pose.position.y - extent.y, pose.position.z - extent.z};
+        data.maxs[i] = {pose.position.x + extent.x, pose.position.y + extent.y, pose.position.z + extent.z};
+        data.minX[i] = data.mins[i].x;
+        data.minY[i] = data.mins[i].y;
+        data.minZ[i] = data.mins[i].z;
+        data.maxX[i] = data.maxs[i].x;
+        data.maxY[i] = data.maxs[i].y;
+        data.maxZ[i] = data.maxs[i].z;
+    }
+
+    // Looking down -z from a little way back, so that some of the bounds are culled and some are not.
+    const XrPosef eye = {{0.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 1.5f, 5.0f}};
+    XrMatrix4x4f projection;
+    XrMatrix4x4f_CreateProjection(&projection, GRAPHICS_OPENGL, -1.0f, 1.0f, 1.0f, -1.0f, 0.05f, 100.0f);
+    XrMatrix4x4f_CreateViewFromPose(&data.view, &eye);
+    XrMatrix4x4f_Multiply(&data.viewProjection, &projection, &data.view);
+
+    data.resultMatrices.resize(count);
+    data.resultPoses.resize(count);
+    data.resultVectors.resize(count);
+    data.resultMins.resize(count);
+    data.resultMaxs.resize(count);
+    data.visibleBits.resize((count + 31) / 32);
+}
+
+BenchmarkResult TimeKernel(LinearBenchmarkData& data, const LinearBenchmarkKernel& kernel, uint32_t iterations,
+                           float& checksum) {
+    // One pass first, so the data is in the cache
+    checksum += kernel.run(data, 1);
+
+    auto start = std::chrono::steady_clock::now();
+    checksum += kernel.run(data, iterations);
+    auto end = std::chrono::steady_clock::now();
+
+    const double ops = static_cast<double>(iterations) * static_cast<double>(data.count);
+    const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    BenchmarkResult result;
+    result.ns_per_op = ns / ops;
+    result.ops_per_second = ns > 0.0 ? ops * 1e9 / ns : 0.0;
+    return result;
+}
+
+void PrintTextHeader(uint32_t iterations) {
+    std::cout << "xr_linear.h kernels, " << kElementCount << " elements x " << iterations
+              << " passes, vector path: " << GetVectorKernelsPath() << std::endl;
+    std::cout << std::left << std::setw(38) << "kernel" << std::right << std::setw(12) << "scalar ns" << std::setw(12)
+              << "vector ns" << std::setw(14) << "scalar Mop/s" << std::setw(14) << "vector Mop/s" << std::setw(10)
+              << "speedup" << std::endl;
+}
+
+void PrintTextResult(const char* name, const BenchmarkResult& scalar, const BenchmarkResult& vector) {
+    const double speedup = vector.ns_per_op > 0.0 ? scalar.ns_per_op / vector.ns_per_op : 0.0;
+    std::cout << std::left << std::setw(38) << name << std::right << std::fixed << std::setprecision(2) << std::setw(12)
+              << scalar.ns_per_op << std::setw(12) << vector.ns_per_op << std::setw(14) << scalar.ops_per_second / 1e6
+              << std::setw(14) << vector.ops_per_second / 1e6 << std::setw(9) << speedup << "x" << std::endl;
+}
+
+void PrintCsvHeader() { std::cout << "kernel,variant,ns_per_op,ops_per_second" << std::endl; }
+
+void PrintCsvResult(const char* name, const char* variant, const BenchmarkResult& result) {
+    std::cout << name << "," << variant << "," << std::fixed << std::setprecision(3) << result.ns_per_op << ","
+              << std::setprecision(0) << result.ops_per_second << std::endl;
+}
+
+}  // namespace
+
+void LinearBenchmarkTouch(LinearBenchmarkData& data) {
+    // Nothing to do: being out of sight of the kernels is enough
+    (void)data;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t iterations = kDefaultIterations;
+    bool csv = false;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string argument = argv[arg];
+        if (argument.compare(0, 13, "--iterations=") == 0) {
+            iterations = static_cast<uint32_t>(std::strtoul(argument.c_str() + 13, nullptr, 10));
+        } else if (argument == "--format=csv") {
+            csv = true;
+        } else if (argument == "--format=text") {
+            csv = false;
+        } else {
+            iterations = 0;
+        }
+        if (iterations == 0) {
+            std::cerr << "Usage: linear_benchmark [--iterations=<passes over the data>] [--format=text|csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    LinearBenchmarkData data;
+    CreateData(data);
+
+    size_t scalar_count = 0;
+    size_t vector_count = 0;
+    const LinearBenchmarkKernel* scalar_kernels = GetScalarKernels(scalar_count);
+    const LinearBenchmarkKernel* vector_kernels = GetVectorKernels(vector_count);
+
+    if (csv) {
+        PrintCsvHeader();
+    } else {
+        PrintTextHeader(iterations);
+    }
+
+    float checksum = 0.0f;
+    for (size_t kernel = 0; kernel < scalar_count && kernel < vector_count; ++kernel) {
+        BenchmarkResult scalar = TimeKernel(data, scalar_kernels[kernel], iterations, checksum);
+        BenchmarkResult vector = TimeKernel(data, vector_kernels[kernel], iterations, checksum);
+        if (csv) {
+            PrintCsvResult(scalar_kernels[kernel].name, "scalar", scalar);
+            PrintCsvResult(vector_kernels[kernel].name, "vector", vector);
+        } else {
+            PrintTextResult(scalar_kernels[kernel].name, scalar, vector);
+        }
+    }
+
+    // Keeps the results alive; a NaN would mean one of the kernels produced garbage from sensible input
+    return std::isnan(checksum) ? 1 : 0;
+}
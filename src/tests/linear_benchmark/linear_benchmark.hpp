@@ -0,0 +1,69 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Shared between linear_benchmark.cpp, which prepares the data and times the kernels, and the scalar and vector
+// builds of the kernels themselves.
+
+#pragma once
+
+#include "xr_linear.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The inputs every kernel reads and the outputs it writes, one element of each per operation.
+struct LinearBenchmarkData {
+    size_t count = 0;
+
+    // Inputs
+    std::vector<XrMatrix4x4f> matrices;     // translation, rotation and non-uniform scale
+    std::vector<XrMatrix4x4f> rigidBodies;  // translation and rotation only
+    std::vector<XrPosef> poses;
+    std::vector<XrVector3f> scales;
+    std::vector<XrVector4f> vectors;
+    std::vector<XrVector3f> mins;
+    std::vector<XrVector3f> maxs;
+    std::vector<float> minX, minY, minZ;  // mins and maxs again, as separate arrays of each component
+    std::vector<float> maxX, maxY, maxZ;
+    XrMatrix4x4f view;
+    XrMatrix4x4f viewProjection;
+
+    // Outputs
+    std::vector<XrMatrix4x4f> resultMatrices;
+    std::vector<XrPosef> resultPoses;
+    std::vector<XrVector4f> resultVectors;
+    std::vector<XrVector3f> resultMins;
+    std::vector<XrVector3f> resultMaxs;
+    std::vector<uint32_t> visibleBits;
+};
+
+// One kernel: run does passes over every element of the data, and returns something computed from the results so
+// that none of the work can be left out.
+struct LinearBenchmarkKernel {
+    const char* name;
+    float (*run)(LinearBenchmarkData& data, uint32_t passes);
+};
+
+// The kernels built with XR_LINEAR_NO_SIMD, and as xr_linear.h builds them by default.  Both lists hold the same
+// kernels in the same order.
+const LinearBenchmarkKernel* GetScalarKernels(size_t& count);
+const LinearBenchmarkKernel* GetVectorKernels(size_t& count);
+
+// The SIMD instructions the vector kernels were built for, or "none" if xr_linear.h has no SIMD path for the target.
+const char* GetVectorKernelsPath();
+
+// Defined apart from the kernels so that the compiler has to assume each pass reads and writes all of the data.
+void LinearBenchmarkTouch(LinearBenchmarkData& data);
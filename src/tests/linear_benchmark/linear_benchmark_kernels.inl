@@ -0,0 +1,197 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// The kernels timed by linear_benchmark.  Included once by linear_benchmark_scalar.cpp, with XR_LINEAR_NO_SIMD
+// defined, and once by linear_benchmark_vector.cpp, without it.  The functions in xr_linear.h are static, so each of
+// the two gets its own build of them.
+
+#include "linear_benchmark.hpp"
+
+namespace {
+
+float RunMultiply(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrMatrix4x4f_Multiply(&data.resultMatrices[i], &data.view, &data.matrices[i]);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMatrices[0].m[12];
+}
+
+float RunMultiplyArray(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        XrMatrix4x4f_MultiplyArray(data.resultMatrices.data(), &data.view, data.matrices.data(), count);
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMatrices[0].m[12];
+}
+
+float RunInvert(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrMatrix4x4f_Invert(&data.resultMatrices[i], &data.matrices[i]);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMatrices[0].m[12];
+}
+
+float RunInvertRigidBody(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrMatrix4x4f_InvertRigidBody(&data.resultMatrices[i], &data.rigidBodies[i]);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMatrices[0].m[12];
+}
+
+float RunCreateFromQuaternion(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrMatrix4x4f_CreateFromQuaternion(&data.resultMatrices[i], &data.poses[i].orientation);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMatrices[0].m[0];
+}
+
+float RunCreateTranslationRotationScale(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrMatrix4x4f_CreateTranslationRotationScale(&data.resultMatrices[i], &data.poses[i].position,
+                                                        &data.poses[i].orientation, &data.scales[i]);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMatrices[0].m[12];
+}
+
+float RunCreateTranslationRotationScaleArray(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        XrMatrix4x4f_CreateTranslationRotationScaleArray(data.resultMatrices.data(), data.poses.data(), sizeof(XrPosef),
+                                                         data.scales.data(), sizeof(XrVector3f), count);
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMatrices[0].m[12];
+}
+
+float RunCreateViewFromPose(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrMatrix4x4f_CreateViewFromPose(&data.resultMatrices[i], &data.poses[i]);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMatrices[0].m[12];
+}
+
+float RunTransformVector4f(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrMatrix4x4f_TransformVector4f(&data.resultVectors[i], &data.viewProjection, &data.vectors[i]);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultVectors[0].w;
+}
+
+float RunTransformBounds(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrMatrix4x4f_TransformBounds(&data.resultMins[i], &data.resultMaxs[i], &data.matrices[i], &data.mins[i],
+                                         &data.maxs[i]);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultMins[0].x;
+}
+
+float RunCullBounds(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    int culled = 0;
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            culled += XrMatrix4x4f_CullBounds(&data.viewProjection, &data.mins[i], &data.maxs[i]) ? 1 : 0;
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return static_cast<float>(culled);
+}
+
+float RunCullBoundsArray(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    const XrBoundsArraysf bounds = {data.minX.data(), data.minY.data(), data.minZ.data(),
+                                    data.maxX.data(), data.maxY.data(), data.maxZ.data()};
+    int visible = 0;
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        visible += XrMatrix4x4f_CullBoundsArray(data.visibleBits.data(), &data.viewProjection, &bounds, count);
+        LinearBenchmarkTouch(data);
+    }
+    return static_cast<float>(visible);
+}
+
+float RunQuaternionMultiply(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrQuaternionf_Multiply(&data.resultPoses[i].orientation, &data.poses[i].orientation,
+                                   &data.poses[count - 1 - i].orientation);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultPoses[0].orientation.w;
+}
+
+float RunPoseMultiply(LinearBenchmarkData& data, uint32_t passes) {
+    const int count = static_cast<int>(data.count);
+    for (uint32_t pass = 0; pass < passes; ++pass) {
+        for (int i = 0; i < count; ++i) {
+            XrPosef_Multiply(&data.resultPoses[i], &data.poses[i], &data.poses[count - 1 - i]);
+        }
+        LinearBenchmarkTouch(data);
+    }
+    return data.resultPoses[0].position.x;
+}
+
+const LinearBenchmarkKernel kKernels[] = {
+    {"Multiply", RunMultiply},
+    {"MultiplyArray", RunMultiplyArray},
+    {"Invert", RunInvert},
+    {"InvertRigidBody", RunInvertRigidBody},
+    {"CreateFromQuaternion", RunCreateFromQuaternion},
+    {"CreateTranslationRotationScale", RunCreateTranslationRotationScale},
+    {"CreateTranslationRotationScaleArray", RunCreateTranslationRotationScaleArray},
+    {"CreateViewFromPose", RunCreateViewFromPose},
+    {"TransformVector4f", RunTransformVector4f},
+    {"TransformBounds", RunTransformBounds},
+    {"CullBounds", RunCullBounds},
+    {"CullBoundsArray", RunCullBoundsArray},
+    {"QuaternionMultiply", RunQuaternionMultiply},
+    {"PoseMultiply", RunPoseMultiply},
+};
+
+}  // namespace
@@ -0,0 +1,24 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// The linear_benchmark kernels on the plain C paths of xr_linear.h.
+
+#define XR_LINEAR_NO_SIMD
+#include "linear_benchmark_kernels.inl"
+
+const LinearBenchmarkKernel* GetScalarKernels(size_t& count) {
+    count = sizeof(kKernels) / sizeof(kKernels[0]);
+    return kKernels;
+}
@@ -16,6 +16,15 @@
 //
 
 // We do not need any graphics.
+//
+// Usage: runtime_list [--format=text|json] [--timing]
+//
+// --format=json prints the same information as one JSON object, for scripts.  --timing also reports how long each phase of
+// the loader's work took (finding and parsing the runtime and API layer manifests, opening their libraries and negotiating
+// with them, and so on) for each runtime and layer involved, by turning on the loader's XR_LOADER_TRACE_FILE tracing for
+// this run and reading the trace back.  If XR_LOADER_TRACE_FILE is already set, that file is used and kept.  Manifests the
+// loader finds unchanged in its manifest cache are not parsed again, so set XR_LOADER_DISABLE_MANIFEST_CACHE=1 as well to
+// time their parsing.
 
 #if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
 #define _CRT_SECURE_NO_WARNINGS
@@ -28,8 +37,15 @@
 #include <string.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <string>
 #include <vector>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 // Struct that does book keeping of what a
 // OpenXr application need to keep track of.
 struct Program {
@@ -41,6 +57,7 @@ struct Program {
 
    public:
     Program() {
+        instance = XR_NULL_HANDLE;
         numPhysDevs = 0;
         physDevs = nullptr;
     }
@@ -58,13 +75,224 @@ struct Program {
     }
 };
 
+// One phase of the loader's work, as read back from its trace file.
+struct TimingEvent {
+    std::string phase;
+    std::string detail;
+    uint32_t thread;
+    uint32_t depth;
+    double startMs;
+    double durationMs;
+};
+
+// Print a string as a JSON string literal.
+static void PrintJsonString(const char* value) {
+    putchar('"');
+    for (const char* c = value; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            printf("\\%c", *c);
+        } else if ((unsigned char)*c < 0x20) {
+            printf("\\u%04x", (unsigned int)*c);
+        } else {
+            putchar(*c);
+        }
+    }
+    putchar('"');
+}
+
+// Point the loader's startup tracing at a file of our own, unless the user already did.  This has to happen before the
+// first call into the loader, since the loader only looks at the variable once.  Returns the file to read the trace from,
+// and whether it is ours to remove afterwards.
+static bool EnableLoaderTrace(std::string* traceFile, bool* removeAfterwards) {
+    const char* existing = getenv("XR_LOADER_TRACE_FILE");
+    if (existing != NULL && existing[0] != '\0') {
+        *traceFile = existing;
+        *removeAfterwards = false;
+        return true;
+    }
+#if defined(_WIN32)
+    char directory[MAX_PATH];
+    char filename[MAX_PATH];
+    if (GetTempPathA(MAX_PATH, directory) == 0 || GetTempFileNameA(directory, "xrt", 0, filename) == 0) {
+        return false;
+    }
+    if (_putenv_s("XR_LOADER_TRACE_FILE", filename) != 0) {
+        DeleteFileA(filename);
+        return false;
+    }
+#else
+    const char* directory = getenv("TMPDIR");
+    std::string pattern = (directory != NULL && directory[0] != '\0') ? directory : "/tmp";
+    pattern += "/runtime_list_trace_XXXXXX";
+    std::vector<char> filename(pattern.begin(), pattern.end());
+    filename.push_back('\0');
+    int fd = mkstemp(filename.data());
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    if (setenv("XR_LOADER_TRACE_FILE", filename.data(), 1) != 0) {
+        unlink(filename.data());
+        return false;
+    }
+#endif
+    *traceFile = &filename[0];
+    *removeAfterwards = true;
+    return true;
+}
+
+// Find "key": in one line of the trace and return where its value starts, or NULL.
+static const char* FindTraceValue(const std::string& line, const char* key) {
+    std::string quoted = std::string("\"") + key + "\":";
+    size_t position = line.find(quoted);
+    if (position == std::string::npos) {
+        return NULL;
+    }
+    return line.c_str() + position + quoted.size();
+}
+
+// Read the JSON string literal starting at value, undoing the escapes the loader writes.
+static std::string ReadTraceString(const char* value) {
+    std::string result;
+    if (value == NULL || *value != '"') {
+        return result;
+    }
+    for (const char* c = value + 1; *c != '\0' && *c != '"'; c++) {
+        if (*c == '\\' && c[1] != '\0') {
+            c++;
+            if (*c == 'u' && strlen(c) >= 5) {
+                result += (char)strtoul(std::string(c + 1, 4).c_str(), NULL, 16);
+                c += 4;
+            } else {
+                result += *c;
+            }
+        } else {
+            result += *c;
+        }
+    }
+    return result;
+}
+
+// Read back the complete events in the loader's trace file, which it writes one event to a line, in the order they were
+// recorded.  Each event is nested under the still-running event before it on the same thread, which is how the loader's
+// own phases are nested.
+static std::vector<TimingEvent> ReadLoaderTrace(const std::string& traceFile) {
+    std::vector<TimingEvent> events;
+    FILE* file = fopen(traceFile.c_str(), "r");
+    if (file == NULL) {
+        return events;
+    }
+    std::string line;
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), file) != NULL) {
+        line += buffer;
+        if (line.empty() || line[line.size() - 1] != '\n') {
+            continue;
+        }
+        const char* phaseType = FindTraceValue(line, "ph");
+        const char* start = FindTraceValue(line, "ts");
+        const char* duration = FindTraceValue(line, "dur");
+        const char* thread = FindTraceValue(line, "tid");
+        if (phaseType != NULL && strncmp(phaseType, "\"X\"", 3) == 0 && start != NULL && duration != NULL && thread != NULL) {
+            TimingEvent event;
+            event.phase = ReadTraceString(FindTraceValue(line, "name"));
+            event.detail = ReadTraceString(FindTraceValue(line, "detail"));
+            event.thread = (uint32_t)strtoul(thread, NULL, 10);
+            event.depth = 0;
+            event.startMs = strtod(start, NULL) / 1000.0;
+            event.durationMs = strtod(duration, NULL) / 1000.0;
+            events.push_back(event);
+        }
+        line.clear();
+    }
+    fclose(file);
+
+    // Events are written as they end, so an enclosing phase comes after the phases inside it: put them in start order,
+    // keeping the enclosing phase first when two start together.
+    std::vector<TimingEvent> sorted;
+    for (size_t i = 0; i < events.size(); i++) {
+        size_t position = sorted.size();
+        while (position > 0 && (sorted[position - 1].startMs > events[i].startMs ||
+                                (sorted[position - 1].startMs == events[i].startMs &&
+                                 sorted[position - 1].durationMs < events[i].durationMs))) {
+            position--;
+        }
+        sorted.insert(sorted.begin() + position, events[i]);
+    }
+    for (size_t i = 0; i < sorted.size(); i++) {
+        uint32_t depth = 0;
+        for (size_t j = i; j > 0; j--) {
+            const TimingEvent& outer = sorted[j - 1];
+            if (outer.thread == sorted[i].thread && outer.startMs + outer.durationMs >= sorted[i].startMs + sorted[i].durationMs) {
+                depth = outer.depth + 1;
+                break;
+            }
+        }
+        sorted[i].depth = depth;
+    }
+    return sorted;
+}
+
+static void PrintTimingText(const std::vector<TimingEvent>& events) {
+    printf("Loader timing\n");
+    if (events.empty()) {
+        printf("\tNothing recorded; this loader may have been built without XR_LOADER_TRACE_FILE support\n");
+        return;
+    }
+    printf("\t%10s %10s  %s\n", "start ms", "ms", "phase");
+    for (const TimingEvent& event : events) {
+        printf("\t%10.3f %10.3f  %*s%s", event.startMs, event.durationMs, (int)(event.depth * 2), "", event.phase.c_str());
+        if (!event.detail.empty()) {
+            printf(": %s", event.detail.c_str());
+        }
+        if (event.thread != 1) {
+            printf(" (thread %" PRIu32 ")", event.thread);
+        }
+        printf("\n");
+    }
+}
+
+static void PrintTimingJson(const std::vector<TimingEvent>& events) {
+    printf("  \"timing\": [");
+    for (size_t i = 0; i < events.size(); i++) {
+        printf("%s\n    {\"phase\": ", i == 0 ? "" : ",");
+        PrintJsonString(events[i].phase.c_str());
+        printf(", \"detail\": ");
+        PrintJsonString(events[i].detail.c_str());
+        printf(", \"thread\": %" PRIu32 ", \"depth\": %" PRIu32 ", \"startMs\": %.3f, \"durationMs\": %.3f}", events[i].thread,
+               events[i].depth, events[i].startMs, events[i].durationMs);
+    }
+    printf("%s]", events.empty() ? "" : "\n  ");
+}
+
 // This below function is written in as close to "C style" as
 // possible, so users of C (and other languages) are not too
 // bogged down with C++ism. The cleanup code is hidden in
 // the struct so the example is lighter but still correct.
-int main() {
-    Program program = {};
+int main(int argc, char* argv[]) {
+    bool json = false;
+    bool timing = false;
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--format=json") == 0) {
+            json = true;
+        } else if (strcmp(argv[arg], "--format=text") == 0) {
+            json = false;
+        } else if (strcmp(argv[arg], "--timing") == 0) {
+            timing = true;
+        } else {
+            fprintf(stderr, "Usage: runtime_list [--format=text|json] [--timing]\n");
+            return 1;
+        }
+    }
+
+    std::string traceFile;
+    bool removeTraceFile = false;
+    if (timing && !EnableLoaderTrace(&traceFile, &removeTraceFile)) {
+        fprintf(stderr, "Failed to create a file for the loader trace.\n");
+        return 1;
+    }
 
+    Program program;
     // Start with creating a instance.
     XrInstanceCreateInfo instanceCreateInfo = {};
     instanceCreateInfo.type = XR_TYPE_INSTANCE_CREATE_INFO;
@@ -77,6 +305,20 @@ int main() {
 
     if (xrCreateInstance(&instanceCreateInfo, &program.instance) != XR_SUCCESS) {
         fprintf(stderr, "Failed to create XR instance.\n");
+        // The timing is still worth having: it shows how far the loader got.
+        if (timing) {
+            std::vector<TimingEvent> events = ReadLoaderTrace(traceFile);
+            if (removeTraceFile) {
+                remove(traceFile.c_str());
+            }
+            if (json) {
+                printf("{\n");
+                PrintTimingJson(events);
+                printf("\n}\n");
+            } else {
+                PrintTimingText(events);
+            }
+        }
         return 1;
     }
 
@@ -88,32 +330,98 @@ int main() {
     XrSystemId systemId;
     if (xrGetSystem(program.instance, &systemGetInfo, &systemId) != XR_SUCCESS) {
         fprintf(stderr, "Failed to get system for HMD form factor.\n");
+        xrDestroyInstance(program.instance);
+        program.instance = XR_NULL_HANDLE;
+        if (removeTraceFile) {
+            remove(traceFile.c_str());
+        }
         return 1;
     }
 
-    // Print information about the system.
+    // Gather information about the system.
     XrSystemProperties systemProperties = {};
     systemProperties.type = XR_TYPE_SYSTEM_PROPERTIES;
 
     xrGetSystemProperties(program.instance, systemId, &systemProperties);
 
-    printf("Evaluating system\n");
-    printf("\t           name: '%s'\n", systemProperties.systemName);
-    printf("\t       vendorId: 0x%" PRIx32 "\n", systemProperties.vendorId);
-    printf("\t       systemId: 0x%" PRIx64 "\n", systemProperties.systemId);
-    printf("\t     systemName: %s\n", systemProperties.systemName);
-
-    uint32_t size;
+    uint32_t size = 0;
     xrEnumerateInstanceExtensionProperties(nullptr, 0, &size, nullptr);
     std::vector<XrExtensionProperties> extensions;
     for (uint32_t i = 0; i < size; i++) {
         extensions.push_back(XrExtensionProperties{XR_TYPE_EXTENSION_PROPERTIES, nullptr});
     }
     xrEnumerateInstanceExtensionProperties(nullptr, size, &size, extensions.data());
+    extensions.resize(size);
+
+    size = 0;
+    xrEnumerateApiLayerProperties(0, &size, nullptr);
+    std::vector<XrApiLayerProperties> layers;
+    for (uint32_t i = 0; i < size; i++) {
+        layers.push_back(XrApiLayerProperties{XR_TYPE_API_LAYER_PROPERTIES, nullptr});
+    }
+    xrEnumerateApiLayerProperties(size, &size, layers.data());
+    layers.resize(size);
+
+    // Every call into the loader rewrites the trace, including xrDestroyInstance, so destroy the instance first to have
+    // the trace hold everything and be left alone once it has been read.
+    std::vector<TimingEvent> events;
+    if (timing) {
+        xrDestroyInstance(program.instance);
+        program.instance = XR_NULL_HANDLE;
+        events = ReadLoaderTrace(traceFile);
+        if (removeTraceFile) {
+            remove(traceFile.c_str());
+        }
+    }
+
+    if (json) {
+        printf("{\n  \"system\": {\"name\": ");
+        PrintJsonString(systemProperties.systemName);
+        printf(", \"vendorId\": %" PRIu32 ", \"systemId\": %" PRIu64 "},\n", systemProperties.vendorId,
+               (uint64_t)systemProperties.systemId);
+        printf("  \"instanceExtensions\": [");
+        for (size_t i = 0; i < extensions.size(); i++) {
+            printf("%s\n    {\"name\": ", i == 0 ? "" : ",");
+            PrintJsonString(extensions[i].extensionName);
+            printf(", \"version\": %" PRIu32 "}", extensions[i].extensionVersion);
+        }
+        printf("%s],\n", extensions.empty() ? "" : "\n  ");
+        printf("  \"apiLayers\": [");
+        for (size_t i = 0; i < layers.size(); i++) {
+            printf("%s\n    {\"name\": ", i == 0 ? "" : ",");
+            PrintJsonString(layers[i].layerName);
+            printf(", \"specVersion\": \"%d.%d.%d\", \"layerVersion\": %" PRIu32 ", \"description\": ",
+                   (int)XR_VERSION_MAJOR(layers[i].specVersion), (int)XR_VERSION_MINOR(layers[i].specVersion),
+                   (int)XR_VERSION_PATCH(layers[i].specVersion), layers[i].layerVersion);
+            PrintJsonString(layers[i].description);
+            printf("}");
+        }
+        printf("%s]", layers.empty() ? "" : "\n  ");
+        if (timing) {
+            printf(",\n");
+            PrintTimingJson(events);
+        }
+        printf("\n}\n");
+    } else {
+        printf("Evaluating system\n");
+        printf("\t           name: '%s'\n", systemProperties.systemName);
+        printf("\t       vendorId: 0x%" PRIx32 "\n", systemProperties.vendorId);
+        printf("\t       systemId: 0x%" PRIx64 "\n", systemProperties.systemId);
+        printf("\t     systemName: %s\n", systemProperties.systemName);
+
+        printf("List instance extensions\n");
+        for (XrExtensionProperties extension : extensions) {
+            printf("\t%s %d\n", extension.extensionName, extension.extensionVersion);
+        }
+
+        printf("List API layers\n");
+        for (XrApiLayerProperties layer : layers) {
+            printf("\t%s %" PRIu32 ": %s\n", layer.layerName, layer.layerVersion, layer.description);
+        }
 
-    printf("List instance extensions\n");
-    for (XrExtensionProperties extension : extensions) {
-        printf("\t%s %d\n", extension.extensionName, extension.extensionVersion);
+        if (timing) {
+            PrintTimingText(events);
+        }
     }
 
     // The program struct will do cleanup for us.
@@ -0,0 +1,149 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+// Copyright (c) 2017-2019 Valve Corporation
+// Copyright (c) 2017-2019 LunarG, Inc.
+// Copyright (c) 2019 Collabora, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Follows the messages a running OpenXR application's loader publishes to shared memory when XR_LOADER_SHARED_LOG is
+// set, and prints them as they arrive, for watching a session from outside the application.  The layout of the shared
+// memory is described in src/common/loader_shared_log.h.
+//
+// Usage: loader_log_viewer <name>
+//   where <name> is the value of XR_LOADER_SHARED_LOG in the application's environment.  Start the viewer first, or any
+//   time while the application runs: it waits for the shared memory to appear, and exits once the application's loader
+//   has gone away and every message has been printed.
+
+#if defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+#define _CRT_SECURE_NO_WARNINGS
+#endif  // defined(_MSC_VER) && !defined(_CRT_SECURE_NO_WARNINGS)
+
+#include "loader_shared_log.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t kMappedSize = sizeof(XrLoaderSharedLogHeader);
+
+// Map the header, then the whole ring once the header says how big it is.  Returns nullptr if it does not exist (yet).
+XrLoaderSharedLogHeader* OpenSharedLog(const std::string& object_name) {
+#if defined(_WIN32)
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_WRITE, FALSE, object_name.c_str());
+    if (nullptr == mapping) {
+        return nullptr;
+    }
+    // The view keeps the mapping alive after the handle is closed
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+    CloseHandle(mapping);
+    return static_cast<XrLoaderSharedLogHeader*>(data);
+#else
+    int fd = shm_open(object_name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    void* data = MAP_FAILED;
+    struct stat info = {};
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) > kMappedSize) {
+        data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    return (MAP_FAILED == data) ? nullptr : static_cast<XrLoaderSharedLogHeader*>(data);
+#endif
+}
+
+void PrintRecord(const XrLoaderSharedLogRecord& record, const char* text) {
+    const std::time_t seconds = static_cast<std::time_t>(record.timestamp / 1000000000);
+    const int milliseconds = static_cast<int>((record.timestamp / 1000000) % 1000);
+    char time_text[32] = {};
+    std::strftime(time_text, sizeof(time_text), "%H:%M:%S", std::localtime(&seconds));
+    printf("%s.%03d %.*s", time_text, milliseconds, static_cast<int>(record.text_length), text);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: loader_log_viewer <name>\n");
+        return 1;
+    }
+    const std::string object_name = XrLoaderSharedLogObjectName(argv[1]);
+
+    XrLoaderSharedLogHeader* header = nullptr;
+    while (nullptr == (header = OpenSharedLog(object_name))) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    // The loader sets the magic number once the rest of the header is filled in
+    while (*static_cast<volatile uint32_t*>(&header->magic) != XrLoaderSharedLogHeader::kMagic) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->version != XrLoaderSharedLogHeader::kVersion) {
+        fprintf(stderr, "Unsupported loader shared log version %u\n", header->version);
+        return 1;
+    }
+    printf("Following loader messages of process %u\n", header->process_id);
+
+    const uint64_t capacity = header->capacity;
+    const uint8_t* records = reinterpret_cast<const uint8_t*>(header) + sizeof(XrLoaderSharedLogHeader);
+    uint64_t read_position = header->read_position.load(std::memory_order_relaxed);
+    uint64_t reported_dropped = 0;
+    for (;;) {
+        // Check whether the writer is done before looking for records, so that none published before it closed are missed
+        const bool closed = header->closed.load(std::memory_order_acquire) != 0;
+        const uint64_t write_position = header->write_position.load(std::memory_order_acquire);
+        while (read_position < write_position) {
+            const size_t offset = static_cast<size_t>(read_position & (capacity - 1));
+            XrLoaderSharedLogRecord record;
+            memcpy(&record.size, records + offset, sizeof(record.size));
+            if (record.size == 0) {
+                read_position += capacity - offset;
+                continue;
+            }
+            memcpy(&record, records + offset, sizeof(record));
+            PrintRecord(record, reinterpret_cast<const char*>(records + offset + sizeof(record)));
+            read_position += record.size;
+        }
+        header->read_position.store(read_position, std::memory_order_release);
+
+        const uint64_t dropped = header->dropped.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped) {
+            printf("... %llu messages dropped because the viewer fell behind\n",
+                   static_cast<unsigned long long>(dropped - reported_dropped));
+            reported_dropped = dropped;
+        }
+        fflush(stdout);
+        if (closed) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures how long it takes to find the manifest files in a directory, the way the loader searches each API layer
+// directory, in a scratch directory tree holding thousands of files of which only some are manifests.
+//
+// Each directory is scanned two ways:
+//  - names:   FileSysUtilsFindFilesInPath, then FileSysUtilsIsRegularFile on every entry
+//  - entries: FileSysUtilsFindEntriesInPath, using the types that come with the listing
+//
+// The tree is created in the current directory and removed again afterwards.
+//
+// Usage: filesystem_benchmark [--files=<files per directory>] [--iterations=<scans per directory>]
+
+#include "filesystem_utils.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const uint32_t kDefaultFiles = 4000;
+const uint32_t kDefaultIterations = 20;
+const uint32_t kDirectories = 4;
+// One file in this many is a manifest, and one in this many again is a subdirectory named like one.
+const uint32_t kManifestEvery = 10;
+const uint32_t kSubdirectoryEvery = 50;
+const char* const kTreeName = "filesystem_benchmark_tree";
+
+void RemoveEmptyDirectory(const std::string& path) {
+#if defined(_WIN32)
+    _rmdir(path.c_str());
+#else
+    rmdir(path.c_str());
+#endif
+}
+
+bool EndsWithJson(const std::string& name) { return name.size() >= 5 && name.compare(name.size() - 5, 5, ".json") == 0; }
+
+// Find the manifest files the way the loader did before FileSysUtilsFindEntriesInPath.
+size_t ScanByName(const std::string& directory) {
+    std::vector<std::string> files;
+    FileSysUtilsFindFilesInPath(directory, files);
+    size_t manifests = 0;
+    for (const std::string& file : files) {
+        std::string full_path;
+        FileSysUtilsCombinePaths(directory, file, full_path);
+        if (FileSysUtilsIsRegularFile(full_path) && EndsWithJson(file)) {
+            ++manifests;
+        }
+    }
+    return manifests;
+}
+
+size_t ScanByEntry(const std::string& directory) {
+    std::vector<FileSysUtilsDirectoryEntry> entries;
+    FileSysUtilsFindEntriesInPath(directory, entries);
+    size_t manifests = 0;
+    for (const FileSysUtilsDirectoryEntry& entry : entries) {
+        if (entry.is_regular_file && EndsWithJson(entry.name)) {
+            ++manifests;
+        }
+    }
+    return manifests;
+}
+
+// The files created in each directory, and whether each is a subdirectory.
+std::vector<std::pair<std::string, bool>> TreeContents(uint32_t files) {
+    std::vector<std::pair<std::string, bool>> contents;
+    for (uint32_t file = 0; file < files; ++file) {
+        if (file % kSubdirectoryEvery == 0) {
+            contents.emplace_back("subdirectory_" + std::to_string(file) + ".json", true);
+        } else if (file % kManifestEvery == 0) {
+            contents.emplace_back("XrApiLayer_" + std::to_string(file) + ".json", false);
+        } else {
+            contents.emplace_back("library_" + std::to_string(file) + ".so", false);
+        }
+    }
+    return contents;
+}
+
+bool CreateTree(const std::vector<std::string>& directories, const std::vector<std::pair<std::string, bool>>& contents) {
+    for (const std::string& directory : directories) {
+        if (!FileSysUtilsCreateDirectories(directory)) {
+            std::cerr << "Could not create " << directory << std::endl;
+            return false;
+        }
+        for (const auto& item : contents) {
+            std::string full_path;
+            FileSysUtilsCombinePaths(directory, item.first, full_path);
+            if (item.second) {
+                FileSysUtilsCreateDirectories(full_path);
+            } else {
+                std::ofstream file(full_path);
+                file << "{}";
+            }
+        }
+    }
+    return true;
+}
+
+void RemoveTree(const std::vector<std::string>& directories, const std::vector<std::pair<std::string, bool>>& contents) {
+    for (const std::string& directory : directories) {
+        for (const auto& item : contents) {
+            std::string full_path;
+            FileSysUtilsCombinePaths(directory, item.first, full_path);
+            if (item.second) {
+                RemoveEmptyDirectory(full_path);
+            } else {
+                std::remove(full_path.c_str());
+            }
+        }
+        RemoveEmptyDirectory(directory);
+    }
+    RemoveEmptyDirectory(kTreeName);
+}
+
+// Returns the average time taken to scan each directory once, in microseconds.
+double TimeScans(size_t (*scan)(const std::string&), const std::vector<std::string>& directories, uint32_t iterations,
+                 size_t& manifests) {
+    manifests = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+        for (const std::string& directory : directories) {
+            manifests += scan(directory);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    manifests /= iterations * directories.size();
+    return std::chrono::duration<double, std::micro>(elapsed).count() / (iterations * directories.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t files = kDefaultFiles;
+    uint32_t iterations = kDefaultIterations;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string argument = argv[arg];
+        if (argument.compare(0, 8, "--files=") == 0) {
+            files = static_cast<uint32_t>(std::strtoul(argument.c_str() + 8, nullptr, 10));
+        } else if (argument.compare(0, 13, "--iterations=") == 0) {
+            iterations = static_cast<uint32_t>(std::strtoul(argument.c_str() + 13, nullptr, 10));
+        } else {
+            files = 0;
+        }
+        if (files == 0 || iterations == 0) {
+            std::cerr << "Usage: filesystem_benchmark [--files=<files per directory>] [--iterations=<scans per directory>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> directories;
+    for (uint32_t directory = 0; directory < kDirectories; ++directory) {
+        std::string full_path;
+        FileSysUtilsCombinePaths(kTreeName, "directory_" + std::to_string(directory), full_path);
+        directories.push_back(full_path);
+    }
+    const std::vector<std::pair<std::string, bool>> contents = TreeContents(files);
+    if (!CreateTree(directories, contents)) {
+        RemoveTree(directories, contents);
+        return 1;
+    }
+
+    size_t name_manifests = 0;
+    size_t entry_manifests = 0;
+    // Warm the file system caches first, so that neither way pays for reading the directories from disk.
+    TimeScans(ScanByName, directories, 1, name_manifests);
+    double name_us = TimeScans(ScanByName, directories, iterations, name_manifests);
+    double entry_us = TimeScans(ScanByEntry, directories, iterations, entry_manifests);
+
+    RemoveTree(directories, contents);
+
+    std::cout << "Scanning " << directories.size() << " directories of " << files << " files, " << iterations
+              << " times each" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  names:   " << std::setw(10) << name_us << " us per directory, " << name_manifests << " manifests"
+              << std::endl;
+    std::cout << "  entries: " << std::setw(10) << entry_us << " us per directory, " << entry_manifests << " manifests"
+              << std::endl;
+    size_t expected_manifests = 0;
+    for (const auto& item : contents) {
+        if (!item.second && EndsWithJson(item.first)) {
+            ++expected_manifests;
+        }
+    }
+    return (entry_manifests == expected_manifests) ? 0 : 1;
+}
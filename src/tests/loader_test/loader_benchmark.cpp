@@ -0,0 +1,393 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the per-call cost of getting from the application to the runtime through the loader,
+// using the test runtime so that the runtime side of each call is as close to free as possible.
+//
+// Every representative command is timed with 0, 1 and 4 pass-through API layers enabled, from 1 to 16
+// threads, and fetched three ways:
+//  - export: the loader's exported entry point (always a trampoline)
+//  - gipa:   the pointer returned by xrGetInstanceProcAddr
+//  - direct: the pointer returned by xrGetInstanceProcAddr with XR_LOADER_DIRECT_DISPATCH=1
+//  - stats:  the exported entry point with XR_EXTX_loader_call_statistics enabled
+//
+// Run from the loader_test build directory so the resources folder can be found.
+//
+// Usage: loader_benchmark [--iterations=<calls per thread>] [--format=text|csv]
+
+#include "filesystem_utils.hpp"
+#include "loader_test_utils.hpp"
+
+#include "xr_dependencies.h"
+#include <openxr/openxr.h>
+#include <openxr/openxr_loader_statistics.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint64_t kDefaultIterations = 200000;
+const uint32_t kLayerCounts[] = {0, 1, 4};
+const uint32_t kThreadCounts[] = {1, 2, 4, 8, 16};
+
+enum BenchmarkDispatch {
+    BENCHMARK_DISPATCH_EXPORT = 0,
+    BENCHMARK_DISPATCH_GIPA,
+    BENCHMARK_DISPATCH_DIRECT,
+    BENCHMARK_DISPATCH_STATISTICS
+};
+const char* const kDispatchNames[] = {"export", "gipa", "direct", "stats"};
+
+// The handles and entry points every timed command works with.
+struct BenchmarkContext {
+    XrInstance instance = XR_NULL_HANDLE;
+    XrSession session = XR_NULL_HANDLE;
+    XrSpace space = XR_NULL_HANDLE;
+    XrActionSet action_set = XR_NULL_HANDLE;
+    XrAction action = XR_NULL_HANDLE;
+
+    PFN_xrLocateSpace LocateSpace = nullptr;
+    PFN_xrSyncActions SyncActions = nullptr;
+    PFN_xrGetActionStateFloat GetActionStateFloat = nullptr;
+    PFN_xrEndFrame EndFrame = nullptr;
+    PFN_xrPollEvent PollEvent = nullptr;
+};
+
+void RunLocateSpace(const BenchmarkContext& context, uint64_t iterations) {
+    XrSpaceLocation location = {XR_TYPE_SPACE_LOCATION};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        context.LocateSpace(context.space, context.space, 1, &location);
+    }
+}
+
+void RunSyncActions(const BenchmarkContext& context, uint64_t iterations) {
+    XrActiveActionSet active_set = {context.action_set, XR_NULL_PATH};
+    XrActionsSyncInfo sync_info = {XR_TYPE_ACTIONS_SYNC_INFO};
+    sync_info.countActiveActionSets = 1;
+    sync_info.activeActionSets = &active_set;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        context.SyncActions(context.session, &sync_info);
+    }
+}
+
+void RunGetActionStateFloat(const BenchmarkContext& context, uint64_t iterations) {
+    XrActionStateGetInfo get_info = {XR_TYPE_ACTION_STATE_GET_INFO};
+    get_info.action = context.action;
+    XrActionStateFloat state = {XR_TYPE_ACTION_STATE_FLOAT};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        context.GetActionStateFloat(context.session, &get_info, &state);
+    }
+}
+
+void RunEndFrame(const BenchmarkContext& context, uint64_t iterations) {
+    XrFrameEndInfo end_info = {XR_TYPE_FRAME_END_INFO};
+    end_info.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        end_info.displayTime = static_cast<XrTime>(i + 1);
+        context.EndFrame(context.session, &end_info);
+    }
+}
+
+void RunPollEvent(const BenchmarkContext& context, uint64_t iterations) {
+    XrEventDataBuffer event_data = {XR_TYPE_EVENT_DATA_BUFFER};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        context.PollEvent(context.instance, &event_data);
+    }
+}
+
+struct BenchmarkCommand {
+    const char* name;
+    void (*run)(const BenchmarkContext& context, uint64_t iterations);
+};
+
+const BenchmarkCommand kCommands[] = {
+    {"xrLocateSpace", RunLocateSpace},   {"xrSyncActions", RunSyncActions}, {"xrGetActionStateFloat", RunGetActionStateFloat},
+    {"xrEndFrame", RunEndFrame},         {"xrPollEvent", RunPollEvent},
+};
+
+struct BenchmarkResult {
+    uint32_t layers;
+    uint32_t threads;
+    BenchmarkDispatch dispatch;
+    const char* command;
+    // Mean latency of a single call, averaged over all threads.
+    double ns_per_call;
+    // Combined throughput of all threads.
+    double calls_per_second;
+};
+
+std::string ResourcePath(const char* folder, const char* file) {
+    std::string path;
+    FileSysUtilsGetCurrentPath(path);
+    path += TEST_DIRECTORY_SYMBOL;
+    path += "resources";
+    path += TEST_DIRECTORY_SYMBOL;
+    path += folder;
+    if (nullptr != file) {
+        path += TEST_DIRECTORY_SYMBOL;
+        path += file;
+    }
+    return path;
+}
+
+void ConfigureLayers(uint32_t layer_count) {
+    if (layer_count == 0) {
+        LoaderTestUnsetEnvironmentVariable("XR_ENABLE_API_LAYERS");
+        LoaderTestUnsetEnvironmentVariable("XR_API_LAYER_PATH");
+        return;
+    }
+    std::string layers;
+    for (uint32_t layer = 0; layer < layer_count; ++layer) {
+        if (layer > 0) {
+            layers += TEST_PATH_SEPARATOR;
+        }
+        layers += "XR_APILAYER_benchmark_" + std::to_string(layer);
+    }
+    LoaderTestSetEnvironmentVariable("XR_API_LAYER_PATH", ResourcePath("benchmark_layers", nullptr));
+    LoaderTestSetEnvironmentVariable("XR_ENABLE_API_LAYERS", layers);
+}
+
+template <typename FunctionType>
+bool GetFunction(XrInstance instance, const char* name, FunctionType& function) {
+    function = nullptr;
+    XrResult result = xrGetInstanceProcAddr(instance, name, reinterpret_cast<PFN_xrVoidFunction*>(&function));
+    if (XR_FAILED(result) || nullptr == function) {
+        std::cerr << "xrGetInstanceProcAddr failed for " << name << " with " << std::to_string(result) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void DestroyContext(BenchmarkContext& context) {
+    if (context.action != XR_NULL_HANDLE) {
+        xrDestroyAction(context.action);
+    }
+    if (context.action_set != XR_NULL_HANDLE) {
+        xrDestroyActionSet(context.action_set);
+    }
+    if (context.space != XR_NULL_HANDLE) {
+        xrDestroySpace(context.space);
+    }
+    if (context.session != XR_NULL_HANDLE) {
+        xrDestroySession(context.session);
+    }
+    if (context.instance != XR_NULL_HANDLE) {
+        xrDestroyInstance(context.instance);
+    }
+    context = BenchmarkContext();
+}
+
+bool CreateContext(BenchmarkDispatch dispatch, BenchmarkContext& context) {
+    if (dispatch == BENCHMARK_DISPATCH_DIRECT) {
+        LoaderTestSetEnvironmentVariable("XR_LOADER_DIRECT_DISPATCH", "1");
+    } else {
+        LoaderTestUnsetEnvironmentVariable("XR_LOADER_DIRECT_DISPATCH");
+    }
+
+    XrInstanceCreateInfo create_info = {XR_TYPE_INSTANCE_CREATE_INFO};
+    strcpy(create_info.applicationInfo.applicationName, "Loader Benchmark");
+    create_info.applicationInfo.applicationVersion = 1;
+    strcpy(create_info.applicationInfo.engineName, "Loader Benchmark");
+    create_info.applicationInfo.engineVersion = 1;
+    create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+    const char* const statistics_extension = XR_EXTX_LOADER_CALL_STATISTICS_EXTENSION_NAME;
+    if (dispatch == BENCHMARK_DISPATCH_STATISTICS) {
+        create_info.enabledExtensionCount = 1;
+        create_info.enabledExtensionNames = &statistics_extension;
+    }
+    XrResult result = xrCreateInstance(&create_info, &context.instance);
+    if (XR_FAILED(result)) {
+        std::cerr << "xrCreateInstance failed with " << std::to_string(result) << std::endl;
+        context.instance = XR_NULL_HANDLE;
+        return false;
+    }
+
+    // Always create the objects through the exported trampolines so the loader knows about them.
+    XrSystemGetInfo system_get_info = {XR_TYPE_SYSTEM_GET_INFO};
+    system_get_info.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    XrSessionCreateInfo session_create_info = {XR_TYPE_SESSION_CREATE_INFO};
+    XrReferenceSpaceCreateInfo space_create_info = {XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+    space_create_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+    space_create_info.poseInReferenceSpace.orientation.w = 1.0f;
+    XrActionSetCreateInfo action_set_create_info = {XR_TYPE_ACTION_SET_CREATE_INFO};
+    strcpy(action_set_create_info.actionSetName, "benchmark");
+    strcpy(action_set_create_info.localizedActionSetName, "Benchmark");
+    XrActionCreateInfo action_create_info = {XR_TYPE_ACTION_CREATE_INFO};
+    action_create_info.actionType = XR_ACTION_TYPE_FLOAT_INPUT;
+    strcpy(action_create_info.actionName, "trigger");
+    strcpy(action_create_info.localizedActionName, "Trigger");
+
+    if (XR_FAILED(xrGetSystem(context.instance, &system_get_info, &system_id)) ||
+        (session_create_info.systemId = system_id, XR_FAILED(xrCreateSession(context.instance, &session_create_info,
+                                                                             &context.session))) ||
+        XR_FAILED(xrCreateReferenceSpace(context.session, &space_create_info, &context.space)) ||
+        XR_FAILED(xrCreateActionSet(context.instance, &action_set_create_info, &context.action_set)) ||
+        XR_FAILED(xrCreateAction(context.action_set, &action_create_info, &context.action))) {
+        std::cerr << "Failed creating the benchmark session objects" << std::endl;
+        DestroyContext(context);
+        return false;
+    }
+
+    if (dispatch == BENCHMARK_DISPATCH_EXPORT || dispatch == BENCHMARK_DISPATCH_STATISTICS) {
+        context.LocateSpace = xrLocateSpace;
+        context.SyncActions = xrSyncActions;
+        context.GetActionStateFloat = xrGetActionStateFloat;
+        context.EndFrame = xrEndFrame;
+        context.PollEvent = xrPollEvent;
+    } else if (!GetFunction(context.instance, "xrLocateSpace", context.LocateSpace) ||
+               !GetFunction(context.instance, "xrSyncActions", context.SyncActions) ||
+               !GetFunction(context.instance, "xrGetActionStateFloat", context.GetActionStateFloat) ||
+               !GetFunction(context.instance, "xrEndFrame", context.EndFrame) ||
+               !GetFunction(context.instance, "xrPollEvent", context.PollEvent)) {
+        DestroyContext(context);
+        return false;
+    }
+    return true;
+}
+
+// Run the command on thread_count threads at once, each making `iterations` calls.
+void TimeCommand(const BenchmarkContext& context, const BenchmarkCommand& command, uint32_t thread_count, uint64_t iterations,
+                 double& ns_per_call, double& calls_per_second) {
+    std::vector<double> thread_ns(thread_count, 0.0);
+    std::atomic<uint32_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+
+    for (uint32_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            // Warm up caches and branch predictors before the clock starts.
+            command.run(context, iterations / 10 + 1);
+            ready.fetch_add(1);
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            auto start = std::chrono::steady_clock::now();
+            command.run(context, iterations);
+            auto end = std::chrono::steady_clock::now();
+            thread_ns[t] = std::chrono::duration<double, std::nano>(end - start).count();
+        });
+    }
+    while (ready.load() != thread_count) {
+        std::this_thread::yield();
+    }
+    auto wall_start = std::chrono::steady_clock::now();
+    go.store(true);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    auto wall_end = std::chrono::steady_clock::now();
+
+    double total_ns = 0.0;
+    for (double ns : thread_ns) {
+        total_ns += ns;
+    }
+    ns_per_call = total_ns / (static_cast<double>(iterations) * thread_count);
+    double wall_seconds = std::chrono::duration<double>(wall_end - wall_start).count();
+    calls_per_second = (wall_seconds > 0.0) ? (static_cast<double>(iterations) * thread_count) / wall_seconds : 0.0;
+}
+
+void PrintTextHeader(uint64_t iterations) {
+    std::cout << "Starting loader_benchmark (" << iterations << " calls per thread per measurement)" << std::endl
+              << "--------------------" << std::endl;
+    std::cout << std::left << std::setw(8) << "layers" << std::setw(9) << "threads" << std::setw(10) << "dispatch"
+              << std::setw(24) << "command" << std::right << std::setw(12) << "ns/call" << std::setw(16) << "Mcalls/s"
+              << std::endl;
+}
+
+void PrintTextResult(const BenchmarkResult& result) {
+    std::cout << std::left << std::setw(8) << result.layers << std::setw(9) << result.threads << std::setw(10)
+              << kDispatchNames[result.dispatch] << std::setw(24) << result.command << std::right << std::fixed
+              << std::setprecision(2) << std::setw(12) << result.ns_per_call << std::setw(16)
+              << result.calls_per_second / 1000000.0 << std::endl;
+}
+
+void PrintCsvHeader() { std::cout << "layers,threads,dispatch,command,ns_per_call,calls_per_second" << std::endl; }
+
+void PrintCsvResult(const BenchmarkResult& result) {
+    std::cout << result.layers << "," << result.threads << "," << kDispatchNames[result.dispatch] << "," << result.command << ","
+              << std::fixed << std::setprecision(3) << result.ns_per_call << "," << std::setprecision(0)
+              << result.calls_per_second << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = kDefaultIterations;
+    bool csv = false;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string argument = argv[arg];
+        if (argument.compare(0, 13, "--iterations=") == 0) {
+            iterations = std::strtoull(argument.c_str() + 13, nullptr, 10);
+        } else if (argument == "--format=csv") {
+            csv = true;
+        } else if (argument == "--format=text") {
+            csv = false;
+        } else {
+            iterations = 0;
+        }
+        if (iterations == 0) {
+            std::cerr << "Usage: loader_benchmark [--iterations=<calls per thread>] [--format=text|csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    LoaderTestSetEnvironmentVariable("XR_RUNTIME_JSON", ResourcePath("runtimes", "test_runtime.json"));
+
+    if (csv) {
+        PrintCsvHeader();
+    } else {
+        PrintTextHeader(iterations);
+    }
+
+    bool success = true;
+    for (uint32_t layers : kLayerCounts) {
+        ConfigureLayers(layers);
+        for (uint32_t dispatch = BENCHMARK_DISPATCH_EXPORT; dispatch <= BENCHMARK_DISPATCH_STATISTICS; ++dispatch) {
+            BenchmarkContext context;
+            if (!CreateContext(static_cast<BenchmarkDispatch>(dispatch), context)) {
+                success = false;
+                continue;
+            }
+            for (const BenchmarkCommand& command : kCommands) {
+                for (uint32_t threads : kThreadCounts) {
+                    BenchmarkResult result = {layers, threads, static_cast<BenchmarkDispatch>(dispatch), command.name, 0.0, 0.0};
+                    TimeCommand(context, command, threads, iterations, result.ns_per_call, result.calls_per_second);
+                    if (csv) {
+                        PrintCsvResult(result);
+                    } else {
+                        PrintTextResult(result);
+                    }
+                }
+            }
+            DestroyContext(context);
+        }
+    }
+
+    LoaderTestUnsetEnvironmentVariable("XR_LOADER_DIRECT_DISPATCH");
+    LoaderTestUnsetEnvironmentVariable("XR_ENABLE_API_LAYERS");
+    LoaderTestUnsetEnvironmentVariable("XR_API_LAYER_PATH");
+    LoaderTestUnsetEnvironmentVariable("XR_RUNTIME_JSON");
+    return success ? 0 : 1;
+}
@@ -20,15 +20,23 @@
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
 #include <vector>
 
 #include "filesystem_utils.hpp"
 #include "loader_test_utils.hpp"
+#include "manifest_file_cache.hpp"
+#include "manifest_json_reader.hpp"
 
 #include "hex_and_handles.h"
 
 #include "xr_dependencies.h"
 #include <openxr/openxr.h>
+#include <openxr/openxr_loader_statistics.h>
 #include <openxr/openxr_platform.h>
 
 #include <type_traits>
@@ -48,6 +56,53 @@ void CleanupEnvironmentVariables() {
     LoaderTestUnsetEnvironmentVariable("XR_RUNTIME_JSON");
 }
 
+// Records what the sample runtime offers that the tests after TestCreateDestroyInstance depend on.
+void NoteRuntimeExtension(const char* extension_name) {
+    if (!strcmp(extension_name, XR_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
+        g_debug_utils_exists = true;
+    }
+#ifdef XR_USE_GRAPHICS_API_OPENGL
+    if (!strcmp(extension_name, XR_KHR_OPENGL_ENABLE_EXTENSION_NAME) && g_graphics_api_to_use == GRAPHICS_API_UNKONWN) {
+        g_graphics_api_to_use = GRAPHICS_API_OPENGL;
+    }
+#endif  // XR_USE_GRAPHICS_API_OPENGL
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+    if (!strcmp(extension_name, XR_KHR_VULKAN_ENABLE_EXTENSION_NAME)) {
+        g_graphics_api_to_use = GRAPHICS_API_VULKAN;
+    }
+#endif  // XR_USE_GRAPHICS_API_VULKAN
+#ifdef XR_USE_GRAPHICS_API_D3D11
+    if (!strcmp(extension_name, XR_KHR_D3D11_ENABLE_EXTENSION_NAME) && g_graphics_api_to_use == GRAPHICS_API_UNKONWN) {
+        g_graphics_api_to_use = GRAPHICS_API_D3D;
+    }
+#endif  // XR_USE_GRAPHICS_API_D3D11
+}
+
+// Finds out what the sample runtime offers the way TestCreateDestroyInstance does, for a test that runs
+// without it having run first in the same process.
+void DetectRuntimeExtensions() {
+    std::string current_path;
+    std::string sample_impl_runtime_path;
+    if (!FileSysUtilsGetCurrentPath(current_path) ||
+        !FileSysUtilsCombinePaths(current_path, "../../impl/openxr_sample_impl.json", sample_impl_runtime_path)) {
+        return;
+    }
+    LoaderTestSetEnvironmentVariable("XR_RUNTIME_JSON", sample_impl_runtime_path);
+
+    uint32_t extension_count = 0;
+    if (XR_SUCCESS == xrEnumerateInstanceExtensionProperties(nullptr, 0, &extension_count, nullptr) && 0 < extension_count) {
+        XrExtensionProperties empty_properties = {XR_TYPE_EXTENSION_PROPERTIES};
+        std::vector<XrExtensionProperties> properties(extension_count, empty_properties);
+        if (XR_SUCCESS == xrEnumerateInstanceExtensionProperties(nullptr, extension_count, &extension_count, properties.data())) {
+            for (uint32_t ext = 0; ext < extension_count; ++ext) {
+                NoteRuntimeExtension(properties[ext].extensionName);
+            }
+        }
+    }
+
+    CleanupEnvironmentVariables();
+}
+
 // Test the xrEnumerateApiLayerProperties function through the loader.
 void TestEnumLayers(uint32_t& total, uint32_t& passed, uint32_t& skipped, uint32_t& failed) {
     uint32_t local_total = 0;
@@ -236,13 +291,14 @@ void TestEnumInstanceExtensions(uint32_t& total, uint32_t& passed, uint32_t& ski
                     // NOTE: Implicit layers will still be present, need to figure out what to do here.
                     LoaderTestUnsetEnvironmentVariable("XR_ENABLE_API_LAYERS");
                     LoaderTestUnsetEnvironmentVariable("XR_API_LAYER_PATH");
-                    expected_extension_count = 3;
+                    // The runtime's three, plus XR_EXT_debug_utils and XR_EXTX_loader_call_statistics from the loader
+                    expected_extension_count = 5;
                     break;
                 default:
                     subtest_name = "with explicit API layers";
                     LoaderTestSetEnvironmentVariable("XR_API_LAYER_PATH", "resources/layers");
                     LoaderTestSetEnvironmentVariable("XR_ENABLE_API_LAYERS", "XR_APILAYER_LUNARG_test");
-                    expected_extension_count = 4;
+                    expected_extension_count = 6;
                     break;
             }
 
@@ -517,26 +573,7 @@ DEFINE_TEST(TestCreateDestroyInstance) {
                 valid_extension_name_array[0] = properties[0].extensionName;
                 missing_extensions = false;
                 for (uint32_t ext = 0; ext < properties.size(); ++ext) {
-                    if (!strcmp(properties[ext].extensionName, XR_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
-                        g_debug_utils_exists = true;
-                    }
-#ifdef XR_USE_GRAPHICS_API_OPENGL
-                    if (!strcmp(properties[ext].extensionName, XR_KHR_OPENGL_ENABLE_EXTENSION_NAME) &&
-                        g_graphics_api_to_use == GRAPHICS_API_UNKONWN) {
-                        g_graphics_api_to_use = GRAPHICS_API_OPENGL;
-                    }
-#endif  // XR_USE_GRAPHICS_API_OPENGL
-#ifdef XR_USE_GRAPHICS_API_VULKAN
-                    if (!strcmp(properties[ext].extensionName, XR_KHR_VULKAN_ENABLE_EXTENSION_NAME)) {
-                        g_graphics_api_to_use = GRAPHICS_API_VULKAN;
-                    }
-#endif  // XR_USE_GRAPHICS_API_VULKAN
-#ifdef XR_USE_GRAPHICS_API_D3D11
-                    if (!strcmp(properties[ext].extensionName, XR_KHR_D3D11_ENABLE_EXTENSION_NAME) &&
-                        g_graphics_api_to_use == GRAPHICS_API_UNKONWN) {
-                        g_graphics_api_to_use = GRAPHICS_API_D3D;
-                    }
-#endif  // XR_USE_GRAPHICS_API_D3D11
+                    NoteRuntimeExtension(properties[ext].extensionName);
                 }
             }
         }
@@ -745,7 +782,7 @@ DEFINE_TEST(TestCreateDestroySession) {
         system_get_info.type = XR_TYPE_SYSTEM_GET_INFO;
         system_get_info.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
 
-        XrSystemId systemId;
+        XrSystemId systemId = XR_NULL_SYSTEM_ID;
         TEST_EQUAL(xrGetSystem(instance, &system_get_info, &systemId), XR_SUCCESS, "xrGetSystem");
 
         if (systemId) {
@@ -1640,7 +1677,7 @@ DEFINE_TEST(TestDebugUtils) {
             memset(&system_get_info, 0, sizeof(system_get_info));
             system_get_info.type = XR_TYPE_SYSTEM_GET_INFO;
             system_get_info.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
-            XrSystemId systemId;
+            XrSystemId systemId = XR_NULL_SYSTEM_ID;
             TEST_EQUAL(xrGetSystem(instance, &system_get_info, &systemId), XR_SUCCESS, "xrGetSystem");
 
             if (systemId) {
@@ -1967,15 +2004,543 @@ DEFINE_TEST(TestDebugUtils) {
     TEST_REPORT(TestDebugUtils)
 }
 
+// Test the loader's own call statistics extension against the test runtime.
+DEFINE_TEST(TestLoaderCallStatistics) {
+    INIT_TEST(TestLoaderCallStatistics)
+
+    try {
+        std::string current_path;
+        std::string test_runtime_path;
+        if (!FileSysUtilsGetCurrentPath(current_path) ||
+            !FileSysUtilsCombinePaths(current_path, "resources/runtimes/test_runtime.json", test_runtime_path)) {
+            std::cout << "FAILED to set runtime path!" << std::endl;
+            throw - 1;
+        }
+        LoaderTestSetEnvironmentVariable("XR_RUNTIME_JSON", test_runtime_path);
+
+        const char* const extension_names[1] = {XR_EXTX_LOADER_CALL_STATISTICS_EXTENSION_NAME};
+        XrInstanceCreateInfo instance_create_info = {XR_TYPE_INSTANCE_CREATE_INFO};
+        strcpy(instance_create_info.applicationInfo.applicationName, "Loader Test");
+        instance_create_info.applicationInfo.applicationVersion = 688;
+        strcpy(instance_create_info.applicationInfo.engineName, "Infinite Improbability Drive");
+        instance_create_info.applicationInfo.engineVersion = 42;
+        instance_create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+
+        // Without the extension enabled, its commands are not available.
+        XrInstance instance = XR_NULL_HANDLE;
+        PFN_xrGetLoaderCallStatisticsEXTX get_call_statistics = nullptr;
+        PFN_xrResetLoaderCallStatisticsEXTX reset_call_statistics = nullptr;
+        TEST_EQUAL(xrCreateInstance(&instance_create_info, &instance), XR_SUCCESS, "Creating instance without call statistics")
+        if (XR_NULL_HANDLE != instance) {
+            TEST_EQUAL(xrGetInstanceProcAddr(instance, "xrGetLoaderCallStatisticsEXTX",
+                                             reinterpret_cast<PFN_xrVoidFunction*>(&get_call_statistics)),
+                       XR_ERROR_FUNCTION_UNSUPPORTED, "xrGetLoaderCallStatisticsEXTX unavailable when not enabled")
+            xrDestroyInstance(instance);
+            instance = XR_NULL_HANDLE;
+        }
+
+        instance_create_info.enabledExtensionCount = 1;
+        instance_create_info.enabledExtensionNames = extension_names;
+        TEST_EQUAL(xrCreateInstance(&instance_create_info, &instance), XR_SUCCESS, "Creating instance with call statistics")
+        if (XR_NULL_HANDLE != instance) {
+            TEST_EQUAL(xrGetInstanceProcAddr(instance, "xrGetLoaderCallStatisticsEXTX",
+                                             reinterpret_cast<PFN_xrVoidFunction*>(&get_call_statistics)),
+                       XR_SUCCESS, "Get xrGetLoaderCallStatisticsEXTX")
+            TEST_EQUAL(xrGetInstanceProcAddr(instance, "xrResetLoaderCallStatisticsEXTX",
+                                             reinterpret_cast<PFN_xrVoidFunction*>(&reset_call_statistics)),
+                       XR_SUCCESS, "Get xrResetLoaderCallStatisticsEXTX")
+            PFN_xrPollEvent poll_event = nullptr;
+            TEST_EQUAL(
+                xrGetInstanceProcAddr(instance, "xrPollEvent", reinterpret_cast<PFN_xrVoidFunction*>(&poll_event)),
+                XR_SUCCESS, "Get xrPollEvent")
+
+            if (nullptr != get_call_statistics && nullptr != reset_call_statistics && nullptr != poll_event) {
+                // Calls through both the exported entry point and the xrGetInstanceProcAddr pointer are counted.
+                XrEventDataBuffer event_data = {XR_TYPE_EVENT_DATA_BUFFER};
+                for (uint32_t call = 0; call < 10; ++call) {
+                    xrPollEvent(instance, &event_data);
+                    poll_event(instance, &event_data);
+                }
+
+                uint32_t statistic_count = 0;
+                TEST_EQUAL(get_call_statistics(instance, 0, &statistic_count, nullptr), XR_SUCCESS,
+                           "Query call statistics count")
+                std::vector<XrLoaderCallStatisticsEXTX> statistics(statistic_count);
+                TEST_EQUAL(get_call_statistics(instance, statistic_count, &statistic_count, statistics.data()), XR_SUCCESS,
+                           "Query call statistics")
+                const XrLoaderCallStatisticsEXTX* poll_event_statistics = nullptr;
+                for (uint32_t statistic = 0; statistic < statistic_count; ++statistic) {
+                    if (0 == strcmp(statistics[statistic].commandName, "xrPollEvent")) {
+                        poll_event_statistics = &statistics[statistic];
+                    }
+                }
+                TEST_NOT_EQUAL(poll_event_statistics, nullptr, "xrPollEvent has call statistics")
+                if (nullptr != poll_event_statistics) {
+                    uint64_t histogram_calls = 0;
+                    for (uint64_t bucket_calls : poll_event_statistics->latencyHistogram) {
+                        histogram_calls += bucket_calls;
+                    }
+                    TEST_EQUAL(poll_event_statistics->callCount, 20u, "xrPollEvent call count")
+                    TEST_EQUAL(histogram_calls, 20u, "xrPollEvent latency histogram call count")
+                }
+
+                TEST_EQUAL(reset_call_statistics(instance), XR_SUCCESS, "Reset call statistics")
+                TEST_EQUAL(get_call_statistics(instance, 0, &statistic_count, nullptr), XR_SUCCESS,
+                           "Query call statistics count after reset")
+                TEST_EQUAL(statistic_count, 0u, "No call statistics after reset")
+            }
+            xrDestroyInstance(instance);
+        }
+    } catch (...) {
+        TEST_FAIL("Exception triggered during test, automatic failure")
+    }
+
+    // Cleanup
+    CleanupEnvironmentVariables();
+
+    // Output results for this test
+    TEST_REPORT(TestLoaderCallStatistics)
+}
+
+// Independent instances created and destroyed on several threads at once must all succeed.
+DEFINE_TEST(TestParallelCreateDestroyInstance) {
+    INIT_TEST(TestParallelCreateDestroyInstance)
+
+    try {
+        std::string current_path;
+        std::string test_runtime_path;
+        if (!FileSysUtilsGetCurrentPath(current_path) ||
+            !FileSysUtilsCombinePaths(current_path, "resources/runtimes/test_runtime.json", test_runtime_path)) {
+            std::cout << "FAILED to set runtime path!" << std::endl;
+            throw - 1;
+        }
+        LoaderTestSetEnvironmentVariable("XR_RUNTIME_JSON", test_runtime_path);
+
+        XrInstanceCreateInfo instance_create_info = {XR_TYPE_INSTANCE_CREATE_INFO};
+        strcpy(instance_create_info.applicationInfo.applicationName, "Loader Test");
+        instance_create_info.applicationInfo.applicationVersion = 688;
+        strcpy(instance_create_info.applicationInfo.engineName, "Infinite Improbability Drive");
+        instance_create_info.applicationInfo.engineVersion = 42;
+        instance_create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+
+        const uint32_t thread_count = 8;
+        const uint32_t instances_per_thread = 25;
+        std::atomic<uint32_t> created{0};
+        std::atomic<uint32_t> destroyed{0};
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 0; thread < thread_count; ++thread) {
+            threads.emplace_back([&]() {
+                for (uint32_t iteration = 0; iteration < instances_per_thread; ++iteration) {
+                    XrInstance instance = XR_NULL_HANDLE;
+                    if (XR_SUCCESS == xrCreateInstance(&instance_create_info, &instance) && XR_NULL_HANDLE != instance) {
+                        ++created;
+                        if (XR_SUCCESS == xrDestroyInstance(instance)) {
+                            ++destroyed;
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        TEST_EQUAL(created.load(), thread_count * instances_per_thread, "Instances created in parallel")
+        TEST_EQUAL(destroyed.load(), thread_count * instances_per_thread, "Instances destroyed in parallel")
+
+        // The runtime must have been unloaded again once every instance was gone.
+        XrInstance instance = XR_NULL_HANDLE;
+        TEST_EQUAL(xrCreateInstance(&instance_create_info, &instance), XR_SUCCESS, "Creating instance after parallel use")
+        if (XR_NULL_HANDLE != instance) {
+            TEST_EQUAL(xrDestroyInstance(instance), XR_SUCCESS, "Destroying instance after parallel use")
+        }
+    } catch (...) {
+        TEST_FAIL("Exception triggered during test, automatic failure")
+    }
+
+    // Cleanup
+    CleanupEnvironmentVariables();
+
+    // Output results for this test
+    TEST_REPORT(TestParallelCreateDestroyInstance)
+}
+
+// A handle whose instance has been looked up recently must still be rejected once that instance is destroyed.
+DEFINE_TEST(TestHandleAfterDestroyInstance) {
+    INIT_TEST(TestHandleAfterDestroyInstance)
+
+    try {
+        std::string current_path;
+        std::string test_runtime_path;
+        if (!FileSysUtilsGetCurrentPath(current_path) ||
+            !FileSysUtilsCombinePaths(current_path, "resources/runtimes/test_runtime.json", test_runtime_path)) {
+            std::cout << "FAILED to set runtime path!" << std::endl;
+            throw - 1;
+        }
+        LoaderTestSetEnvironmentVariable("XR_RUNTIME_JSON", test_runtime_path);
+
+        XrInstanceCreateInfo instance_create_info = {XR_TYPE_INSTANCE_CREATE_INFO};
+        strcpy(instance_create_info.applicationInfo.applicationName, "Loader Test");
+        instance_create_info.applicationInfo.applicationVersion = 688;
+        strcpy(instance_create_info.applicationInfo.engineName, "Infinite Improbability Drive");
+        instance_create_info.applicationInfo.engineVersion = 42;
+        instance_create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+
+        XrInstance instance = XR_NULL_HANDLE;
+        TEST_EQUAL(xrCreateInstance(&instance_create_info, &instance), XR_SUCCESS, "Creating instance")
+        if (XR_NULL_HANDLE != instance) {
+            XrSystemGetInfo system_get_info = {XR_TYPE_SYSTEM_GET_INFO};
+            system_get_info.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+            XrSystemId system_id = XR_NULL_SYSTEM_ID;
+            XrSessionCreateInfo session_create_info = {XR_TYPE_SESSION_CREATE_INFO};
+            XrSession session = XR_NULL_HANDLE;
+            XrReferenceSpaceCreateInfo space_create_info = {XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+            space_create_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+            space_create_info.poseInReferenceSpace.orientation.w = 1.0f;
+            XrSpace space = XR_NULL_HANDLE;
+            XrSpaceLocation location = {XR_TYPE_SPACE_LOCATION};
+
+            TEST_EQUAL(xrGetSystem(instance, &system_get_info, &system_id), XR_SUCCESS, "Getting system")
+            session_create_info.systemId = system_id;
+            TEST_EQUAL(xrCreateSession(instance, &session_create_info, &session), XR_SUCCESS, "Creating session")
+            TEST_EQUAL(xrCreateReferenceSpace(session, &space_create_info, &space), XR_SUCCESS, "Creating reference space")
+            TEST_EQUAL(xrLocateSpace(space, space, 1, &location), XR_SUCCESS, "Locating space")
+            TEST_EQUAL(xrLocateSpace(space, space, 2, &location), XR_SUCCESS, "Locating space again")
+
+            // Leave the session and space for xrDestroyInstance to clean up.
+            TEST_EQUAL(xrDestroyInstance(instance), XR_SUCCESS, "Destroying instance")
+            TEST_EQUAL(xrLocateSpace(space, space, 3, &location), XR_ERROR_HANDLE_INVALID,
+                       "Locating space of destroyed instance")
+        }
+    } catch (...) {
+        TEST_FAIL("Exception triggered during test, automatic failure")
+    }
+
+    // Cleanup
+    CleanupEnvironmentVariables();
+
+    // Output results for this test
+    TEST_REPORT(TestHandleAfterDestroyInstance)
+}
+
+// An explicit API layer manifest for TestManifestReader, with extra members spliced in at the end of "api_layer".
+static std::string ReaderTestLayerManifest(const std::string& extra_members, const std::string& description = "Test_description") {
+    std::string manifest = "{\n";
+    manifest += "    \"file_format_version\": \"1.0.0\",\n";
+    manifest += "    \"api_layer\": {\n";
+    manifest += "        \"name\": \"XR_APILAYER_LUNARG_reader\",\n";
+    manifest += "        \"library_path\": \"./libXrApiLayer_reader.so\",\n";
+    manifest += "        \"api_version\": \"1.0\",\n";
+    manifest += "        \"implementation_version\": \"3\",\n";
+    manifest += "        \"description\": \"" + description + "\",\n";
+    manifest += "        \"instance_extensions\": [{\"name\": \"XR_KHR_fake_ext\", \"extension_version\": \"12\"}]";
+    manifest += extra_members;
+    manifest += "\n    }\n}\n";
+    return manifest;
+}
+
+// The quick manifest readers must read the manifests they accept exactly as jsoncpp would, and decline everything else
+// so that the jsoncpp path (and its error messages) handles it.
+DEFINE_TEST(TestManifestReader) {
+    INIT_TEST(TestManifestReader)
+
+    try {
+        ManifestRecord record = {};
+        const std::string good_layer = ReaderTestLayerManifest("");
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER, good_layer, record), true,
+                   "Accepting a plain API layer manifest")
+        TEST_EQUAL(record.layer_name, std::string("XR_APILAYER_LUNARG_reader"), "Reading the layer name")
+        TEST_EQUAL(record.library_path, std::string("./libXrApiLayer_reader.so"), "Reading the library path")
+        TEST_EQUAL(record.description, std::string("Test_description"), "Reading the description")
+        TEST_EQUAL(record.api_version.major == 1 && record.api_version.minor == 0, true, "Reading the API version")
+        TEST_EQUAL(record.implementation_version, 3U, "Reading the implementation version")
+        TEST_EQUAL(record.instance_extensions.size() == 1 && record.instance_extensions[0].name == "XR_KHR_fake_ext" &&
+                       record.instance_extensions[0].extension_version == 12,
+                   true, "Reading the instance extensions")
+
+        record = {};
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER,
+                                              ReaderTestLayerManifest("", "a \\\"b\\\" c\\\\d\\/e\\tf\\ng"), record),
+                   true, "Accepting simple escapes")
+        TEST_EQUAL(record.description, std::string("a \"b\" c\\d/e\tf\ng"), "Replacing simple escapes")
+
+        // Declined manifests leave the record as it was.
+        record = {};
+        record.layer_name = "untouched";
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER, ReaderTestLayerManifest("", "caf\\u00e9"),
+                                              record),
+                   false, "Declining \\u escapes")
+        TEST_EQUAL(record.layer_name, std::string("untouched"), "Leaving the record alone when declining")
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER,
+                                              ReaderTestLayerManifest(",\n        \"description\": \"again\""), record),
+                   false, "Declining a duplicated member")
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER,
+                                              ReaderTestLayerManifest(",\n        \"functions\": {\"xrA\": \"B\", \"xrA\": \"C\"}"),
+                                              record),
+                   false, "Declining a duplicated function name")
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER,
+                                              "{\"file_format_version\": \"1.0.0\"," + good_layer.substr(1), record),
+                   false, "Declining a duplicated file_format_version")
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER, ReaderTestLayerManifest(" // comment"), record),
+                   false, "Declining a line comment")
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER, ReaderTestLayerManifest(" /* comment */"), record),
+                   false, "Declining a block comment")
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER, ReaderTestLayerManifest(","), record), false,
+                   "Declining a trailing comma")
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER, "{\"file_format_version\": \"1.0.0\"}", record),
+                   false, "Declining a manifest without an api_layer")
+
+        // Every truncation of a good manifest, short of its final newline, must be declined.
+        uint32_t accepted_truncations = 0;
+        for (size_t size = 0; size + 1 < good_layer.size(); ++size) {
+            ManifestRecord truncated_record = {};
+            if (ReadApiLayerManifestRecord(MANIFEST_TYPE_EXPLICIT_API_LAYER, good_layer.substr(0, size), truncated_record)) {
+                accepted_truncations++;
+            }
+        }
+        TEST_EQUAL(accepted_truncations, 0U, "Declining truncated manifests")
+
+        // Implicit layers must name a disable environment variable.
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_IMPLICIT_API_LAYER, good_layer, record), false,
+                   "Declining an implicit layer without disable_environment")
+        record = {};
+        TEST_EQUAL(ReadApiLayerManifestRecord(MANIFEST_TYPE_IMPLICIT_API_LAYER,
+                                              ReaderTestLayerManifest(",\n        \"disable_environment\": \"DISABLE_READER\""),
+                                              record),
+                   true, "Accepting an implicit layer with disable_environment")
+        TEST_EQUAL(record.disable_environment, std::string("DISABLE_READER"), "Reading disable_environment")
+
+        const std::string good_runtime =
+            "{\"file_format_version\": \"1.0.0\", \"runtime\": {\"library_path\": \"libruntime.so\", "
+            "\"instance_extensions\": [{\"name\": \"XR_KHR_fake_ext\", \"extension_version\": 7}], "
+            "\"functions\": {\"xrFunction\": \"RuntimeFunction\"}}}";
+        record = {};
+        TEST_EQUAL(ReadRuntimeManifestRecord(good_runtime, record), true, "Accepting a runtime manifest")
+        TEST_EQUAL(record.library_path == "libruntime.so" && record.instance_extensions.size() == 1 &&
+                       record.instance_extensions[0].extension_version == 7 && record.functions_renamed.size() == 1 &&
+                       record.functions_renamed[0].second == "RuntimeFunction",
+                   true, "Reading the runtime manifest")
+        std::string fractional_runtime = good_runtime;
+        fractional_runtime.replace(fractional_runtime.find(": 7}"), 4, ": 7.5}");
+        TEST_EQUAL(ReadRuntimeManifestRecord(fractional_runtime, record), false, "Declining a fractional extension version")
+        TEST_EQUAL(ReadRuntimeManifestRecord("{\"file_format_version\": \"1.0.0\", \"runtime\": {}}", record), false,
+                   "Declining a runtime manifest without library_path")
+    } catch (...) {
+        TEST_FAIL("Exception triggered during test, automatic failure")
+    }
+
+    // Output results for this test
+    TEST_REPORT(TestManifestReader)
+}
+
+// A layer that reports which commands it intercepts must not be called for the others, even though its
+// xrGetInstanceProcAddr hands them out.
+DEFINE_TEST(TestInterceptedCommands) {
+    INIT_TEST(TestInterceptedCommands)
+
+    try {
+        std::string current_path;
+        std::string test_runtime_path;
+        std::string layer_path;
+        if (!FileSysUtilsGetCurrentPath(current_path) ||
+            !FileSysUtilsCombinePaths(current_path, "resources/runtimes/test_runtime.json", test_runtime_path) ||
+            !FileSysUtilsCombinePaths(current_path, "resources/pass_through_layers", layer_path)) {
+            std::cout << "FAILED to set runtime or layer path!" << std::endl;
+            throw - 1;
+        }
+        LoaderTestSetEnvironmentVariable("XR_RUNTIME_JSON", test_runtime_path);
+        LoaderTestSetEnvironmentVariable("XR_API_LAYER_PATH", layer_path);
+
+        XrInstanceCreateInfo instance_create_info = {XR_TYPE_INSTANCE_CREATE_INFO};
+        strcpy(instance_create_info.applicationInfo.applicationName, "Loader Test");
+        instance_create_info.applicationInfo.applicationVersion = 688;
+        strcpy(instance_create_info.applicationInfo.engineName, "Infinite Improbability Drive");
+        instance_create_info.applicationInfo.engineVersion = 42;
+        instance_create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+
+        // The layer writes the number of xrPollEvent calls that reached it over the runtime name.
+        struct InterceptCase {
+            const char* layer_name;
+            const char* expected_runtime_name;
+        };
+        const InterceptCase intercept_cases[] = {
+            {"XR_APILAYER_pass_through_properties", "0 xrPollEvent calls"},
+            {"XR_APILAYER_pass_through_poll_event", "5 xrPollEvent calls"},
+        };
+        for (const InterceptCase& intercept_case : intercept_cases) {
+            const char* const layer_names[1] = {intercept_case.layer_name};
+            instance_create_info.enabledApiLayerCount = 1;
+            instance_create_info.enabledApiLayerNames = layer_names;
+
+            XrInstance instance = XR_NULL_HANDLE;
+            std::string subtest_name = std::string("Creating instance with ") + intercept_case.layer_name;
+            TEST_EQUAL(xrCreateInstance(&instance_create_info, &instance), XR_SUCCESS, subtest_name)
+            if (XR_NULL_HANDLE == instance) {
+                continue;
+            }
+
+            XrEventDataBuffer event_data = {XR_TYPE_EVENT_DATA_BUFFER};
+            for (uint32_t call = 0; call < 5; ++call) {
+                xrPollEvent(instance, &event_data);
+            }
+            XrInstanceProperties instance_properties = {XR_TYPE_INSTANCE_PROPERTIES};
+            subtest_name = std::string("xrGetInstanceProperties through ") + intercept_case.layer_name;
+            TEST_EQUAL(xrGetInstanceProperties(instance, &instance_properties), XR_SUCCESS, subtest_name)
+            subtest_name = std::string("xrPollEvent calls that reached ") + intercept_case.layer_name;
+            TEST_EQUAL(std::string(instance_properties.runtimeName), std::string(intercept_case.expected_runtime_name),
+                       subtest_name)
+
+            xrDestroyInstance(instance);
+        }
+    } catch (...) {
+        TEST_FAIL("Exception triggered during test, automatic failure")
+    }
+
+    // Cleanup
+    CleanupEnvironmentVariables();
+
+    // Output results for this test
+    TEST_REPORT(TestInterceptedCommands)
+}
+
+typedef void (*LoaderTestFunction)(uint32_t& total, uint32_t& passed, uint32_t& skipped, uint32_t& failed);
+
+struct LoaderTest {
+    const char* name;
+    LoaderTestFunction function;
+    // Whether the test relies on what TestCreateDestroyInstance found out about the runtime
+    bool needs_runtime_extensions;
+};
+
+const LoaderTest kLoaderTests[] = {
+    {"TestEnumLayers", TestEnumLayers, false},
+    {"TestEnumInstanceExtensions", TestEnumInstanceExtensions, false},
+    {"TestCreateDestroyInstance", TestCreateDestroyInstance, false},
+    {"TestGetSystem", TestGetSystem, true},
+    {"TestCreateDestroySession", TestCreateDestroySession, true},
+    {"TestDebugUtils", TestDebugUtils, true},
+    {"TestLoaderCallStatistics", TestLoaderCallStatistics, false},
+    {"TestParallelCreateDestroyInstance", TestParallelCreateDestroyInstance, false},
+    {"TestHandleAfterDestroyInstance", TestHandleAfterDestroyInstance, false},
+    {"TestManifestReader", TestManifestReader, false},
+    {"TestInterceptedCommands", TestInterceptedCommands, false},
+};
+const size_t kLoaderTestCount = sizeof(kLoaderTests) / sizeof(kLoaderTests[0]);
+
+// The last line a test run with --test prints, for the parent process to add up.
+const char kTotalsPrefix[] = "loader_test totals: ";
+
+struct LoaderTestRun {
+    std::string output;
+    uint32_t total = 0;
+    uint32_t passed = 0;
+    uint32_t skipped = 0;
+    uint32_t failed = 0;
+};
+
+// Runs one test in a process of its own, so that the environment variables it sets and the state the
+// loader keeps can't leak into any other test.  The child starts from this process's environment, which
+// never has the test variables set.  What it writes to standard error is kept along with its output, and
+// a child still running after timeout_seconds is killed and counts as failed.
+void RunTestInSubprocess(const std::string& executable, const LoaderTest& test, uint32_t timeout_seconds, LoaderTestRun& run) {
+    int status = 0;
+    bool timed_out = false;
+    if (!LoaderTestRunProcess(executable, std::string("--test=") + test.name, timeout_seconds, run.output, status, timed_out)) {
+        run.output = std::string("    ") + test.name + ": Failed to start\n\n";
+        run.total = run.failed = 1;
+        return;
+    }
+
+    size_t totals = run.output.rfind(kTotalsPrefix);
+    if (timed_out || std::string::npos == totals ||
+        4 != sscanf(run.output.c_str() + totals + strlen(kTotalsPrefix), "%u %u %u %u", &run.total, &run.passed,
+                    &run.skipped, &run.failed)) {
+        // Crashed or hung part way through: whatever it printed is kept, and it counts as a failure
+        run.total = run.passed = run.skipped = run.failed = 0;
+        if (timed_out) {
+            run.output += std::string("\n    ") + test.name + ": Failed, killed after running for " +
+                          std::to_string(timeout_seconds) + " seconds\n\n";
+        } else {
+            run.output += std::string("\n    ") + test.name + ": Failed, exited with status " + std::to_string(status) +
+                          " before reporting\n\n";
+        }
+        run.total += 1;
+        run.failed += 1;
+        return;
+    }
+    run.output.erase(totals);
+}
+
+// Runs every test in a subprocess, as many at a time as there are cores unless told otherwise, and prints
+// their output in the usual order once they are all done.
+void RunTestsInParallel(const std::string& executable, uint32_t jobs, uint32_t timeout_seconds, uint32_t& total,
+                        uint32_t& passed, uint32_t& skipped, uint32_t& failed) {
+    if (0 == jobs) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    jobs = std::min(jobs, static_cast<uint32_t>(kLoaderTestCount));
+
+    std::vector<LoaderTestRun> runs(kLoaderTestCount);
+    std::atomic<size_t> next_test{0};
+    std::vector<std::thread> workers;
+    for (uint32_t job = 0; job < jobs; ++job) {
+        workers.emplace_back([&]() {
+            for (size_t test = next_test++; test < kLoaderTestCount; test = next_test++) {
+                RunTestInSubprocess(executable, kLoaderTests[test], timeout_seconds, runs[test]);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (const LoaderTestRun& run : runs) {
+        std::cout << run.output;
+        total += run.total;
+        passed += run.passed;
+        skipped += run.skipped;
+        failed += run.failed;
+    }
+}
+
+// Usage: loader_test [--serial | --jobs=<parallel tests> | --timeout=<seconds> | --test=<test name>]
+//  - by default each test runs in a subprocess of its own, in parallel
+//  - --timeout is how long each subprocess gets before it is killed, two minutes unless told otherwise
+//  - --serial runs them one after another in this process, as they always used to
+//  - --test runs just the one, in this process; it is how the subprocesses are started
 int main(int argc, char* argv[]) {
     uint32_t total_tests = 0;
     uint32_t total_passed = 0;
     uint32_t total_skipped = 0;
     uint32_t total_failed = 0;
 
-    // Unused for now.
-    (void)argc;
-    (void)argv;
+    bool serial = false;
+    uint32_t jobs = 0;
+    uint32_t timeout_seconds = 120;
+    const LoaderTest* single_test = nullptr;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string argument = argv[arg];
+        if (argument == "--serial") {
+            serial = true;
+        } else if (argument.compare(0, 7, "--jobs=") == 0) {
+            jobs = static_cast<uint32_t>(std::strtoul(argument.c_str() + 7, nullptr, 10));
+        } else if (argument.compare(0, 10, "--timeout=") == 0) {
+            timeout_seconds = static_cast<uint32_t>(std::strtoul(argument.c_str() + 10, nullptr, 10));
+        } else if (argument.compare(0, 7, "--test=") == 0) {
+            for (const LoaderTest& test : kLoaderTests) {
+                if (argument.compare(7, std::string::npos, test.name) == 0) {
+                    single_test = &test;
+                }
+            }
+            if (nullptr == single_test) {
+                std::cout << "Unknown test " << argument.substr(7) << std::endl;
+                return 1;
+            }
+        } else {
+            std::cout << "Usage: loader_test [--serial | --jobs=<parallel tests> | --timeout=<seconds> | --test=<test name>]"
+                      << std::endl;
+            return 1;
+        }
+    }
 
 #if FILTER_OUT_LOADER_ERRORS == 1
     // Re-direct std::cerr to a string since we're intentionally causing errors and we don't
@@ -1985,14 +2550,30 @@ int main(int argc, char* argv[]) {
     original_cerr = std::cerr.rdbuf(buffer.rdbuf());
 #endif
 
+    if (nullptr != single_test) {
+        CleanupEnvironmentVariables();
+        if (single_test->needs_runtime_extensions) {
+            DetectRuntimeExtensions();
+        }
+        single_test->function(total_tests, total_passed, total_skipped, total_failed);
+        CleanupEnvironmentVariables();
+#if FILTER_OUT_LOADER_ERRORS == 1
+        std::cerr.rdbuf(original_cerr);
+#endif
+        std::cout << kTotalsPrefix << total_tests << " " << total_passed << " " << total_skipped << " " << total_failed
+                  << std::endl;
+        return 0;
+    }
+
     std::cout << "Starting loader_test" << std::endl << "--------------------" << std::endl;
 
-    TestEnumLayers(total_tests, total_passed, total_skipped, total_failed);
-    TestEnumInstanceExtensions(total_tests, total_passed, total_skipped, total_failed);
-    TestCreateDestroyInstance(total_tests, total_passed, total_skipped, total_failed);
-    TestGetSystem(total_tests, total_passed, total_skipped, total_failed);
-    TestCreateDestroySession(total_tests, total_passed, total_skipped, total_failed);
-    TestDebugUtils(total_tests, total_passed, total_skipped, total_failed);
+    if (serial) {
+        for (const LoaderTest& test : kLoaderTests) {
+            test.function(total_tests, total_passed, total_skipped, total_failed);
+        }
+    } else {
+        RunTestsInParallel(argv[0], jobs, timeout_seconds, total_tests, total_passed, total_skipped, total_failed);
+    }
 
 #if FILTER_OUT_LOADER_ERRORS == 1
     // Restore std::cerr to the original buffer
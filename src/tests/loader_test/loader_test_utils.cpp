@@ -27,6 +27,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#if defined(XR_OS_LINUX) || defined(XR_OS_APPLE)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
 #if defined(XR_OS_WINDOWS)
 
 bool LoaderTestSetEnvironmentVariable(const std::string &variable, const std::string &value) {
@@ -102,4 +115,146 @@ bool LoaderTestUnsetEnvironmentVariable(const std::string &variable) {
 
 #error "Unsupported platform"
 
-#endif
\ No newline at end of file
+#endif
+
+#if defined(XR_OS_WINDOWS)
+
+bool LoaderTestRunProcess(const std::string &executable, const std::string &argument, uint32_t timeout_seconds,
+                          std::string &output, int &exit_status, bool &timed_out) {
+    SECURITY_ATTRIBUTES security_attributes = {sizeof(SECURITY_ATTRIBUTES), nullptr, FALSE};
+    HANDLE read_pipe = nullptr;
+    HANDLE write_pipe = nullptr;
+    if (!CreatePipe(&read_pipe, &write_pipe, &security_attributes, 0)) {
+        return false;
+    }
+
+    std::string command_line = "\"" + executable + "\" " + argument;
+    STARTUPINFOA startup_info = {};
+    startup_info.cb = sizeof(startup_info);
+    startup_info.dwFlags = STARTF_USESTDHANDLES;
+    startup_info.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    startup_info.hStdOutput = write_pipe;
+    startup_info.hStdError = write_pipe;
+    PROCESS_INFORMATION process_info = {};
+    BOOL created;
+    {
+        // A process inherits every inheritable handle, so the write end is only made inheritable while this one
+        // starts: were another thread's child to hold it too, reading would not end until that child did.
+        static std::mutex create_process_mutex;
+        std::lock_guard<std::mutex> lock(create_process_mutex);
+        SetHandleInformation(write_pipe, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+        created = CreateProcessA(nullptr, &command_line[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup_info,
+                                 &process_info);
+        SetHandleInformation(write_pipe, HANDLE_FLAG_INHERIT, 0);
+    }
+    CloseHandle(write_pipe);
+    if (!created) {
+        CloseHandle(read_pipe);
+        return false;
+    }
+
+    // ReadFile can't wait with a timeout on an anonymous pipe, so the reading is left to a thread of its own.
+    std::thread reader([&output, read_pipe]() {
+        char buffer[4096];
+        DWORD bytes_read = 0;
+        while (ReadFile(read_pipe, buffer, sizeof(buffer), &bytes_read, nullptr) && 0 < bytes_read) {
+            output.append(buffer, bytes_read);
+        }
+    });
+    timed_out = WAIT_TIMEOUT == WaitForSingleObject(process_info.hProcess, timeout_seconds * 1000);
+    if (timed_out) {
+        TerminateProcess(process_info.hProcess, 1);
+        WaitForSingleObject(process_info.hProcess, INFINITE);
+    }
+    reader.join();
+    DWORD exit_code = 0;
+    GetExitCodeProcess(process_info.hProcess, &exit_code);
+    exit_status = static_cast<int>(exit_code);
+    CloseHandle(process_info.hThread);
+    CloseHandle(process_info.hProcess);
+    CloseHandle(read_pipe);
+    return true;
+}
+
+#elif defined(XR_OS_LINUX) || defined(XR_OS_APPLE)
+
+bool LoaderTestRunProcess(const std::string &executable, const std::string &argument, uint32_t timeout_seconds,
+                          std::string &output, int &exit_status, bool &timed_out) {
+    // Close-on-exec, so that a child another thread starts does not hold the write end open, and reading end with it
+    int pipe_fds[2];
+#if defined(XR_OS_LINUX)
+    if (0 != pipe2(pipe_fds, O_CLOEXEC)) {
+        return false;
+    }
+#else
+    if (0 != pipe(pipe_fds)) {
+        return false;
+    }
+    fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+    pid_t child = fork();
+    if (child < 0) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        return false;
+    }
+    if (0 == child) {
+        // Only async-signal-safe calls from here on: the parent may have other threads
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        dup2(pipe_fds[1], STDERR_FILENO);
+        execlp(executable.c_str(), executable.c_str(), argument.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+    close(pipe_fds[1]);
+
+    timed_out = false;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_seconds);
+    char buffer[4096];
+    for (;;) {
+        auto remaining =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            kill(child, SIGKILL);
+            timed_out = true;
+            break;
+        }
+        pollfd poll_fd = {pipe_fds[0], POLLIN, 0};
+        int ready = poll(&poll_fd, 1, static_cast<int>(remaining));
+        if (ready <= 0) {
+            if (ready < 0 && EINTR != errno) {
+                break;
+            }
+            continue;
+        }
+        ssize_t bytes_read = read(pipe_fds[0], buffer, sizeof(buffer));
+        if (0 < bytes_read) {
+            output.append(buffer, static_cast<size_t>(bytes_read));
+        } else if (0 == bytes_read || EINTR != errno) {
+            break;
+        }
+    }
+    close(pipe_fds[0]);
+
+    // The deadline still holds for a child that closed its output without exiting
+    int status = 0;
+    for (;;) {
+        pid_t waited = waitpid(child, &status, timed_out ? 0 : WNOHANG);
+        if (waited == child || (waited < 0 && EINTR != errno)) {
+            break;
+        }
+        if (0 == waited) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                kill(child, SIGKILL);
+                timed_out = true;
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    }
+    exit_status = WIFSIGNALED(status) ? 128 + WTERMSIG(status) : WEXITSTATUS(status);
+    return true;
+}
+
+#endif
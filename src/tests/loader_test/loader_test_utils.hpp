@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #if defined(XR_OS_LINUX) || defined(XR_OS_APPLE)
@@ -37,3 +38,9 @@
 bool LoaderTestSetEnvironmentVariable(const std::string& variable, const std::string& value);
 bool LoaderTestGetEnvironmentVariable(const std::string& variable, std::string& value);
 bool LoaderTestUnsetEnvironmentVariable(const std::string& variable);
+
+// Runs the executable with one argument and collects what it writes to standard output and standard error, in the order
+// it wrote it.  A process still running after timeout_seconds is killed, and timed_out set.  exit_status is the process's
+// exit code, or 128 plus the signal number if a signal ended it.  Returns false if the process could not be started.
+bool LoaderTestRunProcess(const std::string& executable, const std::string& argument, uint32_t timeout_seconds,
+                          std::string& output, int& exit_status, bool& timed_out);
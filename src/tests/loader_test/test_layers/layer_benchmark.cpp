@@ -0,0 +1,176 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Pass-through API layer used by loader_benchmark to measure the cost of a layer in the call chain.
+//
+// One library provides up to kMaxBenchmarkLayers layers named XR_APILAYER_benchmark_<index>, so a single
+// build can stack several of them.  Every layer gets its own set of functions (instantiated from the
+// templates below) with its own "next" pointers, since the loader may put them all in the same chain.
+
+#include <cstdlib>
+#include <cstring>
+
+#include "xr_dependencies.h"
+#include <openxr/openxr.h>
+
+#include "loader_interfaces.h"
+
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define LAYER_EXPORT __attribute__((visibility("default")))
+#elif defined(__SUNPRO_C) && (__SUNPRO_C >= 0x590)
+#define LAYER_EXPORT __attribute__((visibility("default")))
+#else
+#define LAYER_EXPORT
+#endif
+
+namespace {
+
+const int kMaxBenchmarkLayers = 4;
+const char kBenchmarkLayerPrefix[] = "XR_APILAYER_benchmark_";
+
+struct NextFunctions {
+    PFN_xrGetInstanceProcAddr GetInstanceProcAddr;
+    PFN_xrLocateSpace LocateSpace;
+    PFN_xrSyncActions SyncActions;
+    PFN_xrGetActionStateFloat GetActionStateFloat;
+    PFN_xrEndFrame EndFrame;
+    PFN_xrPollEvent PollEvent;
+};
+
+NextFunctions g_next[kMaxBenchmarkLayers];
+
+template <int Index>
+XrResult XRAPI_CALL BenchmarkLayerLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation *location) {
+    return g_next[Index].LocateSpace(space, baseSpace, time, location);
+}
+
+template <int Index>
+XrResult XRAPI_CALL BenchmarkLayerSyncActions(XrSession session, const XrActionsSyncInfo *syncInfo) {
+    return g_next[Index].SyncActions(session, syncInfo);
+}
+
+template <int Index>
+XrResult XRAPI_CALL BenchmarkLayerGetActionStateFloat(XrSession session, const XrActionStateGetInfo *getInfo,
+                                                      XrActionStateFloat *state) {
+    return g_next[Index].GetActionStateFloat(session, getInfo, state);
+}
+
+template <int Index>
+XrResult XRAPI_CALL BenchmarkLayerEndFrame(XrSession session, const XrFrameEndInfo *frameEndInfo) {
+    return g_next[Index].EndFrame(session, frameEndInfo);
+}
+
+template <int Index>
+XrResult XRAPI_CALL BenchmarkLayerPollEvent(XrInstance instance, XrEventDataBuffer *eventData) {
+    return g_next[Index].PollEvent(instance, eventData);
+}
+
+template <int Index>
+XrResult XRAPI_CALL BenchmarkLayerGetInstanceProcAddr(XrInstance instance, const char *name, PFN_xrVoidFunction *function) {
+    if (0 == strcmp(name, "xrGetInstanceProcAddr")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(BenchmarkLayerGetInstanceProcAddr<Index>);
+    } else if (0 == strcmp(name, "xrLocateSpace")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(BenchmarkLayerLocateSpace<Index>);
+    } else if (0 == strcmp(name, "xrSyncActions")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(BenchmarkLayerSyncActions<Index>);
+    } else if (0 == strcmp(name, "xrGetActionStateFloat")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(BenchmarkLayerGetActionStateFloat<Index>);
+    } else if (0 == strcmp(name, "xrEndFrame")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(BenchmarkLayerEndFrame<Index>);
+    } else if (0 == strcmp(name, "xrPollEvent")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(BenchmarkLayerPollEvent<Index>);
+    } else if (nullptr != g_next[Index].GetInstanceProcAddr) {
+        return g_next[Index].GetInstanceProcAddr(instance, name, function);
+    } else {
+        *function = nullptr;
+    }
+    return *function ? XR_SUCCESS : XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+template <int Index>
+XrResult XRAPI_CALL BenchmarkLayerCreateApiLayerInstance(const XrInstanceCreateInfo *info, const XrApiLayerCreateInfo *apiLayerInfo,
+                                                         XrInstance *instance) {
+    if (nullptr == apiLayerInfo || nullptr == apiLayerInfo->nextInfo) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    const XrApiLayerNextInfo *next_info = apiLayerInfo->nextInfo;
+
+    XrApiLayerCreateInfo next_api_layer_info = *apiLayerInfo;
+    next_api_layer_info.nextInfo = next_info->next;
+    XrResult result = next_info->nextCreateApiLayerInstance(info, &next_api_layer_info, instance);
+    if (XR_FAILED(result)) {
+        return result;
+    }
+
+    NextFunctions &next = g_next[Index];
+    next.GetInstanceProcAddr = next_info->nextGetInstanceProcAddr;
+    next.GetInstanceProcAddr(*instance, "xrLocateSpace", reinterpret_cast<PFN_xrVoidFunction *>(&next.LocateSpace));
+    next.GetInstanceProcAddr(*instance, "xrSyncActions", reinterpret_cast<PFN_xrVoidFunction *>(&next.SyncActions));
+    next.GetInstanceProcAddr(*instance, "xrGetActionStateFloat",
+                             reinterpret_cast<PFN_xrVoidFunction *>(&next.GetActionStateFloat));
+    next.GetInstanceProcAddr(*instance, "xrEndFrame", reinterpret_cast<PFN_xrVoidFunction *>(&next.EndFrame));
+    next.GetInstanceProcAddr(*instance, "xrPollEvent", reinterpret_cast<PFN_xrVoidFunction *>(&next.PollEvent));
+    return XR_SUCCESS;
+}
+
+template <int Index>
+void FillLayerRequest(XrNegotiateApiLayerRequest *layerRequest) {
+    layerRequest->getInstanceProcAddr = BenchmarkLayerGetInstanceProcAddr<Index>;
+    layerRequest->createApiLayerInstance = BenchmarkLayerCreateApiLayerInstance<Index>;
+}
+
+}  // namespace
+
+extern "C" {
+
+// Function used to negotiate an interface betewen the loader and a layer.
+LAYER_EXPORT XrResult xrNegotiateLoaderApiLayerInterface(const XrNegotiateLoaderInfo *loaderInfo, const char *layerName,
+                                                         XrNegotiateApiLayerRequest *layerRequest) {
+    if (nullptr == loaderInfo || nullptr == layerRequest || nullptr == layerName ||
+        loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+        loaderInfo->structVersion != XR_LOADER_INFO_STRUCT_VERSION || loaderInfo->structSize != sizeof(XrNegotiateLoaderInfo) ||
+        layerRequest->structType != XR_LOADER_INTERFACE_STRUCT_API_LAYER_REQUEST ||
+        layerRequest->structVersion != XR_API_LAYER_INFO_STRUCT_VERSION ||
+        layerRequest->structSize != sizeof(XrNegotiateApiLayerRequest) ||
+        loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_API_LAYER_VERSION ||
+        loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_API_LAYER_VERSION) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    if (0 != strncmp(layerName, kBenchmarkLayerPrefix, sizeof(kBenchmarkLayerPrefix) - 1)) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+
+    switch (atoi(layerName + sizeof(kBenchmarkLayerPrefix) - 1)) {
+        case 0:
+            FillLayerRequest<0>(layerRequest);
+            break;
+        case 1:
+            FillLayerRequest<1>(layerRequest);
+            break;
+        case 2:
+            FillLayerRequest<2>(layerRequest);
+            break;
+        case 3:
+            FillLayerRequest<3>(layerRequest);
+            break;
+        default:
+            return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    layerRequest->layerInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+    layerRequest->layerApiVersion = XR_CURRENT_API_VERSION;
+    return XR_SUCCESS;
+}
+
+}  // extern "C"
@@ -0,0 +1,162 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// API layer used by loader_test to check that the loader sends the commands a layer does not report through
+// xrEnumerateApiLayerInterceptedCommands straight past it.
+//
+// The library provides two layers.  Both hand out their own xrGetInstanceProperties and xrPollEvent, and count the
+// xrPollEvent calls that reach them.  XR_APILAYER_pass_through_properties reports only xrGetInstanceProperties, so the
+// loader should never call its xrPollEvent, while XR_APILAYER_pass_through_poll_event reports both.  The count is
+// written over the runtime name xrGetInstanceProperties returns, which is how the test reads it back.
+
+#include <cstdio>
+#include <cstring>
+
+#include "xr_dependencies.h"
+#include <openxr/openxr.h>
+
+#include "loader_interfaces.h"
+
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define LAYER_EXPORT __attribute__((visibility("default")))
+#elif defined(__SUNPRO_C) && (__SUNPRO_C >= 0x590)
+#define LAYER_EXPORT __attribute__((visibility("default")))
+#else
+#define LAYER_EXPORT
+#endif
+
+namespace {
+
+const char kPropertiesLayerName[] = "XR_APILAYER_pass_through_properties";
+const char kPollEventLayerName[] = "XR_APILAYER_pass_through_poll_event";
+
+const char *const kPropertiesLayerCommands[] = {"xrGetInstanceProperties"};
+const char *const kPollEventLayerCommands[] = {"xrGetInstanceProperties", "xrPollEvent"};
+
+PFN_xrGetInstanceProcAddr g_next_get_instance_proc_addr = nullptr;
+PFN_xrGetInstanceProperties g_next_get_instance_properties = nullptr;
+PFN_xrPollEvent g_next_poll_event = nullptr;
+uint32_t g_poll_event_calls = 0;
+
+XrResult XRAPI_CALL PassThroughLayerGetInstanceProperties(XrInstance instance, XrInstanceProperties *instanceProperties) {
+    XrResult result = g_next_get_instance_properties(instance, instanceProperties);
+    if (XR_SUCCEEDED(result)) {
+        snprintf(instanceProperties->runtimeName, XR_MAX_RUNTIME_NAME_SIZE, "%u xrPollEvent calls", g_poll_event_calls);
+    }
+    return result;
+}
+
+XrResult XRAPI_CALL PassThroughLayerPollEvent(XrInstance instance, XrEventDataBuffer *eventData) {
+    ++g_poll_event_calls;
+    return g_next_poll_event(instance, eventData);
+}
+
+XrResult XRAPI_CALL PassThroughLayerGetInstanceProcAddr(XrInstance instance, const char *name, PFN_xrVoidFunction *function) {
+    if (0 == strcmp(name, "xrGetInstanceProcAddr")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(PassThroughLayerGetInstanceProcAddr);
+    } else if (0 == strcmp(name, "xrGetInstanceProperties")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(PassThroughLayerGetInstanceProperties);
+    } else if (0 == strcmp(name, "xrPollEvent")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(PassThroughLayerPollEvent);
+    } else if (nullptr != g_next_get_instance_proc_addr) {
+        return g_next_get_instance_proc_addr(instance, name, function);
+    } else {
+        *function = nullptr;
+    }
+    return *function ? XR_SUCCESS : XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+XrResult XRAPI_CALL PassThroughLayerCreateApiLayerInstance(const XrInstanceCreateInfo *info,
+                                                           const XrApiLayerCreateInfo *apiLayerInfo, XrInstance *instance) {
+    if (nullptr == apiLayerInfo || nullptr == apiLayerInfo->nextInfo) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    const XrApiLayerNextInfo *next_info = apiLayerInfo->nextInfo;
+
+    XrApiLayerCreateInfo next_api_layer_info = *apiLayerInfo;
+    next_api_layer_info.nextInfo = next_info->next;
+    XrResult result = next_info->nextCreateApiLayerInstance(info, &next_api_layer_info, instance);
+    if (XR_FAILED(result)) {
+        return result;
+    }
+
+    g_next_get_instance_proc_addr = next_info->nextGetInstanceProcAddr;
+    g_next_get_instance_proc_addr(*instance, "xrGetInstanceProperties",
+                                  reinterpret_cast<PFN_xrVoidFunction *>(&g_next_get_instance_properties));
+    g_next_get_instance_proc_addr(*instance, "xrPollEvent", reinterpret_cast<PFN_xrVoidFunction *>(&g_next_poll_event));
+    g_poll_event_calls = 0;
+    return XR_SUCCESS;
+}
+
+}  // namespace
+
+extern "C" {
+
+// Function used to negotiate an interface betewen the loader and a layer.
+LAYER_EXPORT XrResult xrNegotiateLoaderApiLayerInterface(const XrNegotiateLoaderInfo *loaderInfo, const char *layerName,
+                                                         XrNegotiateApiLayerRequest *layerRequest) {
+    if (nullptr == loaderInfo || nullptr == layerRequest || nullptr == layerName ||
+        loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+        loaderInfo->structVersion != XR_LOADER_INFO_STRUCT_VERSION || loaderInfo->structSize != sizeof(XrNegotiateLoaderInfo) ||
+        layerRequest->structType != XR_LOADER_INTERFACE_STRUCT_API_LAYER_REQUEST ||
+        layerRequest->structVersion != XR_API_LAYER_INFO_STRUCT_VERSION ||
+        layerRequest->structSize != sizeof(XrNegotiateApiLayerRequest) ||
+        loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_API_LAYER_VERSION ||
+        loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_API_LAYER_VERSION) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+    if (0 != strcmp(layerName, kPropertiesLayerName) && 0 != strcmp(layerName, kPollEventLayerName)) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+
+    layerRequest->layerInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+    layerRequest->layerApiVersion = XR_CURRENT_API_VERSION;
+    layerRequest->getInstanceProcAddr = PassThroughLayerGetInstanceProcAddr;
+    layerRequest->createApiLayerInstance = PassThroughLayerCreateApiLayerInstance;
+    return XR_SUCCESS;
+}
+
+// Reports the commands each of the two layers intercepts.
+LAYER_EXPORT XrResult xrEnumerateApiLayerInterceptedCommands(const char *apiLayerName, uint32_t commandCapacityInput,
+                                                             uint32_t *commandCountOutput, const char **commands) {
+    if (nullptr == apiLayerName || nullptr == commandCountOutput) {
+        return XR_ERROR_VALIDATION_FAILURE;
+    }
+    const char *const *layer_commands = nullptr;
+    uint32_t layer_command_count = 0;
+    if (0 == strcmp(apiLayerName, kPropertiesLayerName)) {
+        layer_commands = kPropertiesLayerCommands;
+        layer_command_count = sizeof(kPropertiesLayerCommands) / sizeof(kPropertiesLayerCommands[0]);
+    } else if (0 == strcmp(apiLayerName, kPollEventLayerName)) {
+        layer_commands = kPollEventLayerCommands;
+        layer_command_count = sizeof(kPollEventLayerCommands) / sizeof(kPollEventLayerCommands[0]);
+    } else {
+        return XR_ERROR_API_LAYER_NOT_PRESENT;
+    }
+
+    *commandCountOutput = layer_command_count;
+    if (0 == commandCapacityInput) {
+        return XR_SUCCESS;
+    }
+    if (commandCapacityInput < layer_command_count || nullptr == commands) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (uint32_t command = 0; command < layer_command_count; ++command) {
+        commands[command] = layer_commands[command];
+    }
+    return XR_SUCCESS;
+}
+
+}  // extern "C"
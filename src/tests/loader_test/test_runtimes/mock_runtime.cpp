@@ -0,0 +1,764 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// A runtime for benchmarking the loader and API layers end to end without a headset.  Unlike test_runtime, which only
+// has to get loader_test through its checks, it implements the commands an application calls every frame, headless:
+//  - the session goes through its states as a real one does, reported through xrPollEvent
+//  - xrWaitFrame paces the frames at a set refresh rate and predicts their display times
+//  - xrLocateViews and xrLocateSpace return a head gently swaying over time
+//  - swapchains hand out their images in turn, without any graphics resources behind them
+//  - actions are all active, at rest
+//
+// Its timing is set with environment variables, all optional:
+//  - XR_MOCK_RUNTIME_REFRESH_RATE:           display refresh rate in Hz, 90 by default
+//  - XR_MOCK_RUNTIME_LOCATE_LATENCY_NS:      CPU time xrLocateSpace and xrLocateViews take
+//  - XR_MOCK_RUNTIME_SYNC_LATENCY_NS:        CPU time xrSyncActions takes
+//  - XR_MOCK_RUNTIME_END_FRAME_LATENCY_NS:   CPU time xrEndFrame takes
+//  - XR_MOCK_RUNTIME_SWAPCHAIN_WAIT_NS:      time xrWaitSwapchainImage blocks, as if for the compositor
+// The CPU times are spent spinning, as a runtime doing work would; the swapchain wait sleeps.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "xr_dependencies.h"
+#include <openxr/openxr.h>
+#include <openxr/openxr_reflection.h>
+
+#include "hex_and_handles.h"
+#include "loader_interfaces.h"
+#include "platform_utils.hpp"
+
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define RUNTIME_EXPORT __attribute__((visibility("default")))
+#elif defined(__SUNPRO_C) && (__SUNPRO_C >= 0x590)
+#define RUNTIME_EXPORT __attribute__((visibility("default")))
+#else
+#define RUNTIME_EXPORT
+#endif
+
+namespace {
+
+const uint32_t kSwapchainImageCount = 3;
+const uint32_t kViewWidth = 1024;
+const uint32_t kViewHeight = 1024;
+const float kEyeSeparation = 0.064f;
+
+struct MockConfig {
+    XrDuration frame_period = 1000000000 / 90;
+    XrDuration locate_latency = 0;
+    XrDuration sync_latency = 0;
+    XrDuration end_frame_latency = 0;
+    XrDuration swapchain_wait = 0;
+};
+
+struct MockSession {
+    XrSessionState state = XR_SESSION_STATE_UNKNOWN;
+    XrTime next_frame_time = 0;  // When the next xrWaitFrame returns
+};
+
+struct MockSwapchain {
+    uint32_t next_image = 0;
+};
+
+// Everything the runtime keeps, behind one lock.  The per-frame commands that need none of it don't take the lock.
+struct MockRuntime {
+    std::mutex mutex;
+    MockConfig config;
+    std::unordered_map<uint64_t, MockSession> sessions;
+    std::unordered_map<uint64_t, MockSwapchain> swapchains;
+    std::deque<XrEventDataSessionStateChanged> events;
+    std::vector<std::string> paths;  // Path i + 1 is paths[i]
+};
+
+MockRuntime g_runtime;
+std::atomic<uint64_t> g_next_handle{1};
+
+template <typename HandleType>
+HandleType MockNewHandle() {
+    uint64_t handle = g_next_handle++;
+    return TreatIntegerAsHandle<HandleType>(handle);
+}
+
+XrTime MockNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Burns the CPU for the given time, as a runtime doing that much work would.
+void MockSpin(XrDuration duration) {
+    if (duration <= 0) {
+        return;
+    }
+    const XrTime end = MockNow() + duration;
+    while (MockNow() < end) {
+    }
+}
+
+XrDuration MockEnvironmentValue(const char *name, XrDuration default_value) {
+    char *value = PlatformUtilsGetEnv(name);
+    XrDuration result = default_value;
+    if (nullptr != value) {
+        result = static_cast<XrDuration>(std::strtoll(value, nullptr, 10));
+        PlatformUtilsFreeEnv(value);
+    }
+    return result;
+}
+
+MockConfig MockReadConfig() {
+    MockConfig config;
+    const XrDuration refresh_rate = MockEnvironmentValue("XR_MOCK_RUNTIME_REFRESH_RATE", 90);
+    config.frame_period = 1000000000 / (refresh_rate > 0 ? refresh_rate : 90);
+    config.locate_latency = MockEnvironmentValue("XR_MOCK_RUNTIME_LOCATE_LATENCY_NS", 0);
+    config.sync_latency = MockEnvironmentValue("XR_MOCK_RUNTIME_SYNC_LATENCY_NS", 0);
+    config.end_frame_latency = MockEnvironmentValue("XR_MOCK_RUNTIME_END_FRAME_LATENCY_NS", 0);
+    config.swapchain_wait = MockEnvironmentValue("XR_MOCK_RUNTIME_SWAPCHAIN_WAIT_NS", 0);
+    return config;
+}
+
+// Queues the session's move to each of the states in turn.  Call with the runtime locked.
+void MockQueueStates(XrSession session, MockSession &mock_session, std::initializer_list<XrSessionState> states) {
+    for (XrSessionState state : states) {
+        XrEventDataSessionStateChanged event = {XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED};
+        event.session = session;
+        event.state = state;
+        event.time = MockNow();
+        g_runtime.events.push_back(event);
+        mock_session.state = state;
+    }
+}
+
+// The two-call idiom for an array of the runtime's values.
+template <typename T>
+XrResult MockEnumerate(const T *values, uint32_t count, uint32_t capacity_input, uint32_t *count_output, T *output) {
+    *count_output = count;
+    if (capacity_input == 0) {
+        return XR_SUCCESS;
+    }
+    if (capacity_input < count) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        output[i] = values[i];
+    }
+    return XR_SUCCESS;
+}
+
+XrResult MockEnumerateString(const char *value, uint32_t capacity_input, uint32_t *count_output, char *buffer) {
+    const uint32_t count = static_cast<uint32_t>(strlen(value)) + 1;
+    *count_output = count;
+    if (capacity_input == 0) {
+        return XR_SUCCESS;
+    }
+    if (capacity_input < count) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    memcpy(buffer, value, count);
+    return XR_SUCCESS;
+}
+
+// The head's pose at a time: at standing height, turning slowly from side to side.
+XrPosef MockHeadPose(XrTime time) {
+    const double seconds = static_cast<double>(time) / 1e9;
+    const float half_yaw = static_cast<float>(0.1 * std::sin(seconds * 0.5));
+    XrPosef pose;
+    pose.orientation = {0.0f, std::sin(half_yaw), 0.0f, std::cos(half_yaw)};
+    pose.position = {0.0f, 1.6f, 0.0f};
+    return pose;
+}
+
+}  // namespace
+
+extern "C" {
+
+XrResult MockRuntimeXrCreateInstance(const XrInstanceCreateInfo *info, XrInstance *instance) {
+    {
+        std::lock_guard<std::mutex> lock(g_runtime.mutex);
+        g_runtime.config = MockReadConfig();
+    }
+    *instance = MockNewHandle<XrInstance>();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrDestroyInstance(XrInstance instance) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    g_runtime.events.clear();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetInstanceProperties(XrInstance instance, XrInstanceProperties *instanceProperties) {
+    instanceProperties->runtimeVersion = XR_MAKE_VERSION(0, 1, 0);
+    strcpy(instanceProperties->runtimeName, "Mock Runtime");
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t propertyCapacityInput,
+                                                           uint32_t *propertyCountOutput, XrExtensionProperties *properties) {
+    if (nullptr != layerName) {
+        return XR_ERROR_API_LAYER_NOT_PRESENT;
+    }
+    // Headless only: there are no graphics behind the swapchains
+    *propertyCountOutput = 1;
+    if (0 != propertyCapacityInput) {
+        strcpy(properties[0].extensionName, XR_MND_HEADLESS_EXTENSION_NAME);
+        properties[0].extensionVersion = XR_MND_headless_SPEC_VERSION;
+    }
+    return XR_SUCCESS;
+}
+
+// Layers such as the API dump one name the results and structure types they see through these, so the mock needs them
+// even though applications benchmarked against it seldom call them.
+XrResult MockRuntimeXrResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE]) {
+#define MOCK_RESULT_CASE(name, val) \
+    case name:                      \
+        strcpy(buffer, #name);      \
+        return XR_SUCCESS;
+    switch (value) {
+        XR_LIST_ENUM_XrResult(MOCK_RESULT_CASE)
+        default:
+            break;
+    }
+#undef MOCK_RESULT_CASE
+    snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "%s_%d", XR_SUCCEEDED(value) ? "XR_UNKNOWN_SUCCESS" : "XR_UNKNOWN_FAILURE",
+             static_cast<int>(value));
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrStructureTypeToString(XrInstance instance, XrStructureType value,
+                                            char buffer[XR_MAX_STRUCTURE_NAME_SIZE]) {
+#define MOCK_STRUCTURE_TYPE_CASE(name, val) \
+    case name:                              \
+        strcpy(buffer, #name);              \
+        return XR_SUCCESS;
+    switch (value) {
+        XR_LIST_ENUM_XrStructureType(MOCK_STRUCTURE_TYPE_CASE)
+        default:
+            break;
+    }
+#undef MOCK_STRUCTURE_TYPE_CASE
+    snprintf(buffer, XR_MAX_STRUCTURE_NAME_SIZE, "XR_UNKNOWN_STRUCTURE_TYPE_%d", static_cast<int>(value));
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrPollEvent(XrInstance instance, XrEventDataBuffer *eventData) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    if (g_runtime.events.empty()) {
+        return XR_EVENT_UNAVAILABLE;
+    }
+    memcpy(eventData, &g_runtime.events.front(), sizeof(XrEventDataSessionStateChanged));
+    g_runtime.events.pop_front();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrStringToPath(XrInstance instance, const char *pathString, XrPath *path) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    for (size_t i = 0; i < g_runtime.paths.size(); ++i) {
+        if (g_runtime.paths[i] == pathString) {
+            *path = i + 1;
+            return XR_SUCCESS;
+        }
+    }
+    g_runtime.paths.push_back(pathString);
+    *path = g_runtime.paths.size();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrPathToString(XrInstance instance, XrPath path, uint32_t bufferCapacityInput, uint32_t *bufferCountOutput,
+                                   char *buffer) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    if (path == XR_NULL_PATH || path > g_runtime.paths.size()) {
+        return XR_ERROR_PATH_INVALID;
+    }
+    return MockEnumerateString(g_runtime.paths[path - 1].c_str(), bufferCapacityInput, bufferCountOutput, buffer);
+}
+
+XrResult MockRuntimeXrGetSystem(XrInstance instance, const XrSystemGetInfo *getInfo, XrSystemId *systemId) {
+    if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) {
+        return XR_ERROR_FORM_FACTOR_UNAVAILABLE;
+    }
+    *systemId = 1;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties *properties) {
+    properties->systemId = systemId;
+    properties->vendorId = 0;
+    strcpy(properties->systemName, "Mock HMD");
+    properties->graphicsProperties.maxSwapchainImageWidth = 2 * kViewWidth;
+    properties->graphicsProperties.maxSwapchainImageHeight = 2 * kViewHeight;
+    properties->graphicsProperties.maxLayerCount = XR_MIN_COMPOSITION_LAYERS_SUPPORTED;
+    properties->trackingProperties.orientationTracking = XR_TRUE;
+    properties->trackingProperties.positionTracking = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEnumerateViewConfigurations(XrInstance instance, XrSystemId systemId,
+                                                  uint32_t viewConfigurationTypeCapacityInput,
+                                                  uint32_t *viewConfigurationTypeCountOutput,
+                                                  XrViewConfigurationType *viewConfigurationTypes) {
+    const XrViewConfigurationType types[] = {XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, XR_VIEW_CONFIGURATION_TYPE_PRIMARY_MONO};
+    return MockEnumerate(types, 2, viewConfigurationTypeCapacityInput, viewConfigurationTypeCountOutput, viewConfigurationTypes);
+}
+
+XrResult MockRuntimeXrGetViewConfigurationProperties(XrInstance instance, XrSystemId systemId,
+                                                     XrViewConfigurationType viewConfigurationType,
+                                                     XrViewConfigurationProperties *configurationProperties) {
+    configurationProperties->viewConfigurationType = viewConfigurationType;
+    configurationProperties->fovMutable = XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEnumerateViewConfigurationViews(XrInstance instance, XrSystemId systemId,
+                                                      XrViewConfigurationType viewConfigurationType, uint32_t viewCapacityInput,
+                                                      uint32_t *viewCountOutput, XrViewConfigurationView *views) {
+    const uint32_t count = viewConfigurationType == XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO ? 2 : 1;
+    *viewCountOutput = count;
+    if (viewCapacityInput == 0) {
+        return XR_SUCCESS;
+    }
+    if (viewCapacityInput < count) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        views[i].recommendedImageRectWidth = kViewWidth;
+        views[i].maxImageRectWidth = 2 * kViewWidth;
+        views[i].recommendedImageRectHeight = kViewHeight;
+        views[i].maxImageRectHeight = 2 * kViewHeight;
+        views[i].recommendedSwapchainSampleCount = 1;
+        views[i].maxSwapchainSampleCount = 1;
+    }
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId systemId,
+                                                     XrViewConfigurationType viewConfigurationType,
+                                                     uint32_t environmentBlendModeCapacityInput,
+                                                     uint32_t *environmentBlendModeCountOutput,
+                                                     XrEnvironmentBlendMode *environmentBlendModes) {
+    const XrEnvironmentBlendMode modes[] = {XR_ENVIRONMENT_BLEND_MODE_OPAQUE};
+    return MockEnumerate(modes, 1, environmentBlendModeCapacityInput, environmentBlendModeCountOutput, environmentBlendModes);
+}
+
+XrResult MockRuntimeXrCreateSession(XrInstance instance, const XrSessionCreateInfo *createInfo, XrSession *session) {
+    *session = MockNewHandle<XrSession>();
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    MockSession &mock_session = g_runtime.sessions[MakeHandleGeneric(*session)];
+    MockQueueStates(*session, mock_session, {XR_SESSION_STATE_IDLE, XR_SESSION_STATE_READY});
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrDestroySession(XrSession session) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    g_runtime.sessions.erase(MakeHandleGeneric(session));
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrBeginSession(XrSession session, const XrSessionBeginInfo *beginInfo) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    auto found = g_runtime.sessions.find(MakeHandleGeneric(session));
+    if (found == g_runtime.sessions.end()) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (found->second.state != XR_SESSION_STATE_READY) {
+        return XR_ERROR_SESSION_NOT_READY;
+    }
+    found->second.next_frame_time = MockNow();
+    MockQueueStates(session, found->second,
+                    {XR_SESSION_STATE_SYNCHRONIZED, XR_SESSION_STATE_VISIBLE, XR_SESSION_STATE_FOCUSED});
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrRequestExitSession(XrSession session) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    auto found = g_runtime.sessions.find(MakeHandleGeneric(session));
+    if (found == g_runtime.sessions.end()) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    MockQueueStates(session, found->second,
+                    {XR_SESSION_STATE_VISIBLE, XR_SESSION_STATE_SYNCHRONIZED, XR_SESSION_STATE_STOPPING});
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEndSession(XrSession session) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    auto found = g_runtime.sessions.find(MakeHandleGeneric(session));
+    if (found == g_runtime.sessions.end()) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    if (found->second.state != XR_SESSION_STATE_STOPPING) {
+        return XR_ERROR_SESSION_NOT_STOPPING;
+    }
+    MockQueueStates(session, found->second, {XR_SESSION_STATE_IDLE, XR_SESSION_STATE_EXITING});
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrWaitFrame(XrSession session, const XrFrameWaitInfo *frameWaitInfo, XrFrameState *frameState) {
+    XrTime wake_time;
+    XrDuration period;
+    bool should_render;
+    {
+        std::lock_guard<std::mutex> lock(g_runtime.mutex);
+        auto found = g_runtime.sessions.find(MakeHandleGeneric(session));
+        if (found == g_runtime.sessions.end()) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+        MockSession &mock_session = found->second;
+        period = g_runtime.config.frame_period;
+
+        // Frames start on the display's refresh: an application that has fallen behind waits for the next one.
+        const XrTime now = MockNow();
+        if (mock_session.next_frame_time < now) {
+            mock_session.next_frame_time += (now - mock_session.next_frame_time + period - 1) / period * period;
+        }
+        wake_time = mock_session.next_frame_time;
+        mock_session.next_frame_time += period;
+        should_render = mock_session.state == XR_SESSION_STATE_VISIBLE || mock_session.state == XR_SESSION_STATE_FOCUSED;
+    }
+
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(wake_time)));
+
+    // Displayed a frame after the application is woken up to render it
+    frameState->predictedDisplayTime = wake_time + period;
+    frameState->predictedDisplayPeriod = period;
+    frameState->shouldRender = should_render ? XR_TRUE : XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrBeginFrame(XrSession session, const XrFrameBeginInfo *frameBeginInfo) { return XR_SUCCESS; }
+
+XrResult MockRuntimeXrEndFrame(XrSession session, const XrFrameEndInfo *frameEndInfo) {
+    MockSpin(g_runtime.config.end_frame_latency);
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEnumerateReferenceSpaces(XrSession session, uint32_t spaceCapacityInput, uint32_t *spaceCountOutput,
+                                               XrReferenceSpaceType *spaces) {
+    const XrReferenceSpaceType types[] = {XR_REFERENCE_SPACE_TYPE_VIEW, XR_REFERENCE_SPACE_TYPE_LOCAL,
+                                          XR_REFERENCE_SPACE_TYPE_STAGE};
+    return MockEnumerate(types, 3, spaceCapacityInput, spaceCountOutput, spaces);
+}
+
+XrResult MockRuntimeXrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo *createInfo, XrSpace *space) {
+    *space = MockNewHandle<XrSpace>();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetReferenceSpaceBoundsRect(XrSession session, XrReferenceSpaceType referenceSpaceType, XrExtent2Df *bounds) {
+    bounds->width = 0.0f;
+    bounds->height = 0.0f;
+    return XR_SPACE_BOUNDS_UNAVAILABLE;
+}
+
+XrResult MockRuntimeXrCreateActionSpace(XrSession session, const XrActionSpaceCreateInfo *createInfo, XrSpace *space) {
+    *space = MockNewHandle<XrSpace>();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrDestroySpace(XrSpace space) { return XR_SUCCESS; }
+
+XrResult MockRuntimeXrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation *location) {
+    MockSpin(g_runtime.config.locate_latency);
+    location->locationFlags = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT |
+                              XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT | XR_SPACE_LOCATION_POSITION_TRACKED_BIT;
+    location->pose = MockHeadPose(time);
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrLocateViews(XrSession session, const XrViewLocateInfo *viewLocateInfo, XrViewState *viewState,
+                                  uint32_t viewCapacityInput, uint32_t *viewCountOutput, XrView *views) {
+    const uint32_t count = viewLocateInfo->viewConfigurationType == XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO ? 2 : 1;
+    *viewCountOutput = count;
+    if (viewCapacityInput == 0) {
+        return XR_SUCCESS;
+    }
+    if (viewCapacityInput < count) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+
+    MockSpin(g_runtime.config.locate_latency);
+    viewState->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT |
+                                XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+    const XrPosef head = MockHeadPose(viewLocateInfo->displayTime);
+    for (uint32_t i = 0; i < count; ++i) {
+        views[i].pose = head;
+        if (count == 2) {
+            // The eyes sit either side of the head along its x axis, which the slight yaw barely turns
+            views[i].pose.position.x += (i == 0 ? -0.5f : 0.5f) * kEyeSeparation;
+        }
+        views[i].fov = {-0.785398f, 0.785398f, 0.785398f, -0.785398f};
+    }
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput, uint32_t *formatCountOutput,
+                                                int64_t *formats) {
+    // An sRGB RGBA8 format in each graphics API's numbering: GL_SRGB8_ALPHA8, VK_FORMAT_R8G8B8A8_SRGB and
+    // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB.
+    const int64_t values[] = {0x8C43, 43, 29};
+    return MockEnumerate(values, 3, formatCapacityInput, formatCountOutput, formats);
+}
+
+XrResult MockRuntimeXrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo *createInfo, XrSwapchain *swapchain) {
+    *swapchain = MockNewHandle<XrSwapchain>();
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    g_runtime.swapchains[MakeHandleGeneric(*swapchain)] = MockSwapchain();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrDestroySwapchain(XrSwapchain swapchain) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    g_runtime.swapchains.erase(MakeHandleGeneric(swapchain));
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t *imageCountOutput,
+                                               XrSwapchainImageBaseHeader *images) {
+    // The images are left as the application set them up: there is nothing to put in them.
+    *imageCountOutput = kSwapchainImageCount;
+    if (imageCapacityInput != 0 && imageCapacityInput < kSwapchainImageCount) {
+        return XR_ERROR_SIZE_INSUFFICIENT;
+    }
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo *acquireInfo,
+                                            uint32_t *index) {
+    std::lock_guard<std::mutex> lock(g_runtime.mutex);
+    auto found = g_runtime.swapchains.find(MakeHandleGeneric(swapchain));
+    if (found == g_runtime.swapchains.end()) {
+        return XR_ERROR_HANDLE_INVALID;
+    }
+    *index = found->second.next_image;
+    found->second.next_image = (found->second.next_image + 1) % kSwapchainImageCount;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo *waitInfo) {
+    const XrDuration wait = g_runtime.config.swapchain_wait;
+    if (wait <= 0) {
+        return XR_SUCCESS;
+    }
+    if (waitInfo->timeout != XR_INFINITE_DURATION && waitInfo->timeout < wait) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(waitInfo->timeout > 0 ? waitInfo->timeout : 0));
+        return XR_TIMEOUT_EXPIRED;
+    }
+    std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo *releaseInfo) {
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo *createInfo, XrActionSet *actionSet) {
+    *actionSet = MockNewHandle<XrActionSet>();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrDestroyActionSet(XrActionSet actionSet) { return XR_SUCCESS; }
+
+XrResult MockRuntimeXrCreateAction(XrActionSet actionSet, const XrActionCreateInfo *createInfo, XrAction *action) {
+    *action = MockNewHandle<XrAction>();
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrDestroyAction(XrAction action) { return XR_SUCCESS; }
+
+XrResult MockRuntimeXrSuggestInteractionProfileBindings(XrInstance instance,
+                                                        const XrInteractionProfileSuggestedBinding *suggestedBindings) {
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrAttachSessionActionSets(XrSession session, const XrSessionActionSetsAttachInfo *attachInfo) {
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetCurrentInteractionProfile(XrSession session, XrPath topLevelUserPath,
+                                                   XrInteractionProfileState *interactionProfile) {
+    interactionProfile->interactionProfile = XR_NULL_PATH;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrSyncActions(XrSession session, const XrActionsSyncInfo *syncInfo) {
+    MockSpin(g_runtime.config.sync_latency);
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStateBoolean *state) {
+    state->currentState = XR_FALSE;
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = 0;
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetActionStateFloat(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStateFloat *state) {
+    state->currentState = 0.0f;
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = 0;
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetActionStateVector2f(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStateVector2f *state) {
+    state->currentState = {0.0f, 0.0f};
+    state->changedSinceLastSync = XR_FALSE;
+    state->lastChangeTime = 0;
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetActionStatePose(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStatePose *state) {
+    state->isActive = XR_TRUE;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrEnumerateBoundSourcesForAction(XrSession session, const XrBoundSourcesForActionEnumerateInfo *enumerateInfo,
+                                                     uint32_t sourceCapacityInput, uint32_t *sourceCountOutput, XrPath *sources) {
+    *sourceCountOutput = 0;
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrGetInputSourceLocalizedName(XrSession session, const XrInputSourceLocalizedNameGetInfo *getInfo,
+                                                  uint32_t bufferCapacityInput, uint32_t *bufferCountOutput, char *buffer) {
+    return MockEnumerateString("", bufferCapacityInput, bufferCountOutput, buffer);
+}
+
+XrResult MockRuntimeXrApplyHapticFeedback(XrSession session, const XrHapticActionInfo *hapticActionInfo,
+                                          const XrHapticBaseHeader *hapticFeedback) {
+    return XR_SUCCESS;
+}
+
+XrResult MockRuntimeXrStopHapticFeedback(XrSession session, const XrHapticActionInfo *hapticActionInfo) { return XR_SUCCESS; }
+
+XrResult MockRuntimeXrGetInstanceProcAddr(XrInstance instance, const char *name, PFN_xrVoidFunction *function);
+
+}  // extern "C"
+
+namespace {
+
+#define MOCK_RUNTIME_FUNCTION(name) \
+    { "xr" #name, reinterpret_cast<PFN_xrVoidFunction>(MockRuntimeXr##name) }
+
+struct MockFunction {
+    const char *name;
+    PFN_xrVoidFunction function;
+};
+
+const MockFunction kMockFunctions[] = {
+    MOCK_RUNTIME_FUNCTION(GetInstanceProcAddr),
+    MOCK_RUNTIME_FUNCTION(EnumerateInstanceExtensionProperties),
+    MOCK_RUNTIME_FUNCTION(CreateInstance),
+    MOCK_RUNTIME_FUNCTION(DestroyInstance),
+    MOCK_RUNTIME_FUNCTION(GetInstanceProperties),
+    MOCK_RUNTIME_FUNCTION(PollEvent),
+    MOCK_RUNTIME_FUNCTION(ResultToString),
+    MOCK_RUNTIME_FUNCTION(StructureTypeToString),
+    MOCK_RUNTIME_FUNCTION(StringToPath),
+    MOCK_RUNTIME_FUNCTION(PathToString),
+    MOCK_RUNTIME_FUNCTION(GetSystem),
+    MOCK_RUNTIME_FUNCTION(GetSystemProperties),
+    MOCK_RUNTIME_FUNCTION(EnumerateViewConfigurations),
+    MOCK_RUNTIME_FUNCTION(GetViewConfigurationProperties),
+    MOCK_RUNTIME_FUNCTION(EnumerateViewConfigurationViews),
+    MOCK_RUNTIME_FUNCTION(EnumerateEnvironmentBlendModes),
+    MOCK_RUNTIME_FUNCTION(CreateSession),
+    MOCK_RUNTIME_FUNCTION(DestroySession),
+    MOCK_RUNTIME_FUNCTION(BeginSession),
+    MOCK_RUNTIME_FUNCTION(RequestExitSession),
+    MOCK_RUNTIME_FUNCTION(EndSession),
+    MOCK_RUNTIME_FUNCTION(WaitFrame),
+    MOCK_RUNTIME_FUNCTION(BeginFrame),
+    MOCK_RUNTIME_FUNCTION(EndFrame),
+    MOCK_RUNTIME_FUNCTION(EnumerateReferenceSpaces),
+    MOCK_RUNTIME_FUNCTION(CreateReferenceSpace),
+    MOCK_RUNTIME_FUNCTION(GetReferenceSpaceBoundsRect),
+    MOCK_RUNTIME_FUNCTION(CreateActionSpace),
+    MOCK_RUNTIME_FUNCTION(DestroySpace),
+    MOCK_RUNTIME_FUNCTION(LocateSpace),
+    MOCK_RUNTIME_FUNCTION(LocateViews),
+    MOCK_RUNTIME_FUNCTION(EnumerateSwapchainFormats),
+    MOCK_RUNTIME_FUNCTION(CreateSwapchain),
+    MOCK_RUNTIME_FUNCTION(DestroySwapchain),
+    MOCK_RUNTIME_FUNCTION(EnumerateSwapchainImages),
+    MOCK_RUNTIME_FUNCTION(AcquireSwapchainImage),
+    MOCK_RUNTIME_FUNCTION(WaitSwapchainImage),
+    MOCK_RUNTIME_FUNCTION(ReleaseSwapchainImage),
+    MOCK_RUNTIME_FUNCTION(CreateActionSet),
+    MOCK_RUNTIME_FUNCTION(DestroyActionSet),
+    MOCK_RUNTIME_FUNCTION(CreateAction),
+    MOCK_RUNTIME_FUNCTION(DestroyAction),
+    MOCK_RUNTIME_FUNCTION(SuggestInteractionProfileBindings),
+    MOCK_RUNTIME_FUNCTION(AttachSessionActionSets),
+    MOCK_RUNTIME_FUNCTION(GetCurrentInteractionProfile),
+    MOCK_RUNTIME_FUNCTION(SyncActions),
+    MOCK_RUNTIME_FUNCTION(GetActionStateBoolean),
+    MOCK_RUNTIME_FUNCTION(GetActionStateFloat),
+    MOCK_RUNTIME_FUNCTION(GetActionStateVector2f),
+    MOCK_RUNTIME_FUNCTION(GetActionStatePose),
+    MOCK_RUNTIME_FUNCTION(EnumerateBoundSourcesForAction),
+    MOCK_RUNTIME_FUNCTION(GetInputSourceLocalizedName),
+    MOCK_RUNTIME_FUNCTION(ApplyHapticFeedback),
+    MOCK_RUNTIME_FUNCTION(StopHapticFeedback),
+};
+
+#undef MOCK_RUNTIME_FUNCTION
+
+}  // namespace
+
+extern "C" {
+
+XrResult MockRuntimeXrGetInstanceProcAddr(XrInstance instance, const char *name, PFN_xrVoidFunction *function) {
+    *function = nullptr;
+    for (const MockFunction &entry : kMockFunctions) {
+        if (0 == strcmp(name, entry.name)) {
+            *function = entry.function;
+            break;
+        }
+    }
+    return *function ? XR_SUCCESS : XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+// Function used to negotiate an interface betewen the loader and a runtime.
+RUNTIME_EXPORT XrResult xrNegotiateLoaderRuntimeInterface(const XrNegotiateLoaderInfo *loaderInfo,
+                                                          XrNegotiateRuntimeRequest *runtimeRequest) {
+    if (nullptr == loaderInfo || nullptr == runtimeRequest || loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+        loaderInfo->structVersion != XR_LOADER_INFO_STRUCT_VERSION || loaderInfo->structSize != sizeof(XrNegotiateLoaderInfo) ||
+        runtimeRequest->structType != XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST ||
+        runtimeRequest->structVersion != XR_RUNTIME_INFO_STRUCT_VERSION ||
+        runtimeRequest->structSize != sizeof(XrNegotiateRuntimeRequest) ||
+        loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION ||
+        loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION ||
+        loaderInfo->maxInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION ||
+        loaderInfo->minApiVersion < XR_MAKE_VERSION(0, 1, 0) || loaderInfo->minApiVersion >= XR_MAKE_VERSION(1, 1, 0)) {
+        return XR_ERROR_INITIALIZATION_FAILED;
+    }
+
+    runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+    runtimeRequest->runtimeApiVersion = XR_CURRENT_API_VERSION;
+    runtimeRequest->getInstanceProcAddr = reinterpret_cast<PFN_xrGetInstanceProcAddr>(MockRuntimeXrGetInstanceProcAddr);
+
+    return XR_SUCCESS;
+}
+
+}  // extern "C"
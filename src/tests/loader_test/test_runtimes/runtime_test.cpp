@@ -17,12 +17,14 @@
 // Author: Mark Young <marky@lunarg.com>
 //
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
 #include "xr_dependencies.h"
 #include <openxr/openxr.h>
 
+#include "hex_and_handles.h"
 #include "loader_interfaces.h"
 
 #if defined(__GNUC__) && __GNUC__ >= 4
@@ -33,24 +35,98 @@
 #define RUNTIME_EXPORT
 #endif
 
+// Hand out distinct, non-null handles so the loader can track them.
+static std::atomic<uint64_t> g_next_handle{1};
+
+template <typename HandleType>
+static HandleType RuntimeTestNewHandle() {
+    uint64_t handle = g_next_handle++;
+    return TreatIntegerAsHandle<HandleType>(handle);
+}
+
 extern "C" {
 
-XrResult RuntimeTestXrCreateInstance(const XrInstanceCreateInfo *info, XrInstance *instance) { return XR_SUCCESS; }
+XrResult RuntimeTestXrCreateInstance(const XrInstanceCreateInfo *info, XrInstance *instance) {
+    *instance = RuntimeTestNewHandle<XrInstance>();
+    return XR_SUCCESS;
+}
 
 XrResult RuntimeTestXrDestroyInstance(XrInstance instance) { return XR_SUCCESS; }
 
+XrResult RuntimeTestXrGetInstanceProperties(XrInstance instance, XrInstanceProperties *instanceProperties) {
+    instanceProperties->runtimeVersion = XR_MAKE_VERSION(0, 1, 0);
+    strcpy(instanceProperties->runtimeName, "Test Runtime");
+    return XR_SUCCESS;
+}
+
+XrResult RuntimeTestXrGetSystem(XrInstance instance, const XrSystemGetInfo *getInfo, XrSystemId *systemId) {
+    *systemId = 1;
+    return XR_SUCCESS;
+}
+
+XrResult RuntimeTestXrCreateSession(XrInstance instance, const XrSessionCreateInfo *createInfo, XrSession *session) {
+    *session = RuntimeTestNewHandle<XrSession>();
+    return XR_SUCCESS;
+}
+
+XrResult RuntimeTestXrDestroySession(XrSession session) { return XR_SUCCESS; }
+
+XrResult RuntimeTestXrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo *createInfo, XrSpace *space) {
+    *space = RuntimeTestNewHandle<XrSpace>();
+    return XR_SUCCESS;
+}
+
+XrResult RuntimeTestXrDestroySpace(XrSpace space) { return XR_SUCCESS; }
+
+XrResult RuntimeTestXrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo *createInfo, XrActionSet *actionSet) {
+    *actionSet = RuntimeTestNewHandle<XrActionSet>();
+    return XR_SUCCESS;
+}
+
+XrResult RuntimeTestXrDestroyActionSet(XrActionSet actionSet) { return XR_SUCCESS; }
+
+XrResult RuntimeTestXrCreateAction(XrActionSet actionSet, const XrActionCreateInfo *createInfo, XrAction *action) {
+    *action = RuntimeTestNewHandle<XrAction>();
+    return XR_SUCCESS;
+}
+
+XrResult RuntimeTestXrDestroyAction(XrAction action) { return XR_SUCCESS; }
+
+// Cheap, side-effect free commands used to measure the cost of getting through the loader.
+XrResult RuntimeTestXrPollEvent(XrInstance instance, XrEventDataBuffer *eventData) { return XR_EVENT_UNAVAILABLE; }
+
+XrResult RuntimeTestXrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation *location) {
+    location->locationFlags = 0;
+    return XR_SUCCESS;
+}
+
+XrResult RuntimeTestXrSyncActions(XrSession session, const XrActionsSyncInfo *syncInfo) { return XR_SUCCESS; }
+
+XrResult RuntimeTestXrGetActionStateFloat(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStateFloat *state) {
+    state->currentState = 0.0f;
+    state->isActive = XR_FALSE;
+    return XR_SUCCESS;
+}
+
+XrResult RuntimeTestXrEndFrame(XrSession session, const XrFrameEndInfo *frameEndInfo) { return XR_SUCCESS; }
+
 XrResult RuntimeTestXrEnumerateInstanceExtensionProperties(const char *layerName, uint32_t propertyCapacityInput,
                                                            uint32_t *propertyCountOutput, XrExtensionProperties *properties) {
     if (nullptr != layerName) {
         return XR_ERROR_API_LAYER_NOT_PRESENT;
     }
-    // Return 2 fake extensions, just to test
-    *propertyCountOutput = 2;
+    // Return 2 fake extensions, just to test, and headless, since sessions need no graphics binding here
+    *propertyCountOutput = 3;
     if (0 != propertyCapacityInput) {
+        if (propertyCapacityInput < 3) {
+            return XR_ERROR_SIZE_INSUFFICIENT;
+        }
         strcpy(properties[0].extensionName, "XR_KHR_fake_ext1");
         properties[0].extensionVersion = 57;
         strcpy(properties[1].extensionName, "XR_KHR_fake_ext2");
         properties[1].extensionVersion = 3;
+        strcpy(properties[2].extensionName, XR_MND_HEADLESS_EXTENSION_NAME);
+        properties[2].extensionVersion = XR_MND_headless_SPEC_VERSION;
     }
     return XR_SUCCESS;
 }
@@ -64,6 +140,36 @@ XrResult RuntimeTestXrGetInstanceProcAddr(XrInstance instance, const char *name,
         *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrCreateInstance);
     } else if (0 == strcmp(name, "xrDestroyInstance")) {
         *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrDestroyInstance);
+    } else if (0 == strcmp(name, "xrGetInstanceProperties")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrGetInstanceProperties);
+    } else if (0 == strcmp(name, "xrPollEvent")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrPollEvent);
+    } else if (0 == strcmp(name, "xrGetSystem")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrGetSystem);
+    } else if (0 == strcmp(name, "xrCreateSession")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrCreateSession);
+    } else if (0 == strcmp(name, "xrDestroySession")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrDestroySession);
+    } else if (0 == strcmp(name, "xrCreateReferenceSpace")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrCreateReferenceSpace);
+    } else if (0 == strcmp(name, "xrDestroySpace")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrDestroySpace);
+    } else if (0 == strcmp(name, "xrCreateActionSet")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrCreateActionSet);
+    } else if (0 == strcmp(name, "xrDestroyActionSet")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrDestroyActionSet);
+    } else if (0 == strcmp(name, "xrCreateAction")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrCreateAction);
+    } else if (0 == strcmp(name, "xrDestroyAction")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrDestroyAction);
+    } else if (0 == strcmp(name, "xrLocateSpace")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrLocateSpace);
+    } else if (0 == strcmp(name, "xrSyncActions")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrSyncActions);
+    } else if (0 == strcmp(name, "xrGetActionStateFloat")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrGetActionStateFloat);
+    } else if (0 == strcmp(name, "xrEndFrame")) {
+        *function = reinterpret_cast<PFN_xrVoidFunction>(RuntimeTestXrEndFrame);
     } else {
         *function = nullptr;
     }
@@ -87,7 +193,7 @@ RUNTIME_EXPORT XrResult xrNegotiateLoaderRuntimeInterface(const XrNegotiateLoade
     }
 
     runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
-    runtimeRequest->runtimeApiVersion = XR_MAKE_VERSION(0, 1, 0);
+    runtimeRequest->runtimeApiVersion = XR_CURRENT_API_VERSION;
     runtimeRequest->getInstanceProcAddr = reinterpret_cast<PFN_xrGetInstanceProcAddr>(RuntimeTestXrGetInstanceProcAddr);
 
     return XR_SUCCESS;
@@ -0,0 +1,326 @@
+// Copyright (c) 2017-2019 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Measures the per-call cost of XR_APILAYER_LUNARG_core_validation, using the test runtime so that the runtime
+// side of each call is as close to free as possible.
+//
+// Each command called every frame is timed on its own, and then all of them in turn as one frame, first with no
+// API layers and then with core validation at each XR_CORE_VALIDATION_LEVEL:
+//  - none:     no API layers, the baseline the overhead is measured against
+//  - lifetime: only the handles of create and destroy commands are checked
+//  - handles:  the handles of every command are checked
+//  - full:     everything is checked
+//
+// XR_CORE_VALIDATION_COUNTERS is set while core validation is enabled, so the layer writes out how many handle,
+// parent, enum and next chain checks each measurement made, and how long they took, to standard error as the
+// instance is destroyed.
+//
+// Run from the loader_test build directory so the resources folder can be found.
+//
+// Usage: validation_benchmark [--iterations=<calls per measurement>] [--format=text|csv]
+
+#include "filesystem_utils.hpp"
+#include "loader_test_utils.hpp"
+
+#include "xr_dependencies.h"
+#include <openxr/openxr.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint64_t kDefaultIterations = 200000;
+
+struct ValidationConfig {
+    const char* name;
+    // nullptr for no API layers
+    const char* level;
+};
+const ValidationConfig kConfigs[] = {
+    {"none", nullptr},
+    {"lifetime", "lifetime"},
+    {"handles", "handles"},
+    {"full", "full"},
+};
+
+// The handles every timed command works with.
+struct BenchmarkContext {
+    XrInstance instance = XR_NULL_HANDLE;
+    XrSession session = XR_NULL_HANDLE;
+    XrSpace space = XR_NULL_HANDLE;
+    XrSpace base_space = XR_NULL_HANDLE;
+    XrActionSet action_set = XR_NULL_HANDLE;
+    XrAction action = XR_NULL_HANDLE;
+};
+
+void RunPollEvent(const BenchmarkContext& context, uint64_t iterations) {
+    XrEventDataBuffer event_data = {XR_TYPE_EVENT_DATA_BUFFER};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        xrPollEvent(context.instance, &event_data);
+    }
+}
+
+void RunSyncActions(const BenchmarkContext& context, uint64_t iterations) {
+    XrActiveActionSet active_set = {context.action_set, XR_NULL_PATH};
+    XrActionsSyncInfo sync_info = {XR_TYPE_ACTIONS_SYNC_INFO};
+    sync_info.countActiveActionSets = 1;
+    sync_info.activeActionSets = &active_set;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        xrSyncActions(context.session, &sync_info);
+    }
+}
+
+void RunGetActionStateFloat(const BenchmarkContext& context, uint64_t iterations) {
+    XrActionStateGetInfo get_info = {XR_TYPE_ACTION_STATE_GET_INFO};
+    get_info.action = context.action;
+    XrActionStateFloat state = {XR_TYPE_ACTION_STATE_FLOAT};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        xrGetActionStateFloat(context.session, &get_info, &state);
+    }
+}
+
+void RunLocateSpace(const BenchmarkContext& context, uint64_t iterations) {
+    XrSpaceLocation location = {XR_TYPE_SPACE_LOCATION};
+    for (uint64_t i = 0; i < iterations; ++i) {
+        xrLocateSpace(context.space, context.base_space, static_cast<XrTime>(i + 1), &location);
+    }
+}
+
+void RunFrame(const BenchmarkContext& context, uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+        RunPollEvent(context, 1);
+        RunSyncActions(context, 1);
+        RunGetActionStateFloat(context, 1);
+        RunLocateSpace(context, 1);
+    }
+}
+
+struct BenchmarkCommand {
+    const char* name;
+    void (*run)(const BenchmarkContext& context, uint64_t iterations);
+};
+
+const BenchmarkCommand kCommands[] = {
+    {"xrPollEvent", RunPollEvent},       {"xrSyncActions", RunSyncActions}, {"xrGetActionStateFloat", RunGetActionStateFloat},
+    {"xrLocateSpace", RunLocateSpace},   {"frame", RunFrame},
+};
+const size_t kCommandCount = sizeof(kCommands) / sizeof(kCommands[0]);
+
+struct BenchmarkResult {
+    const char* config;
+    const char* command;
+    double ns_per_call;
+    // Compared to the same command with no API layers.
+    double overhead_ns;
+};
+
+std::string ResourcePath(const char* folder, const char* file) {
+    std::string path;
+    FileSysUtilsGetCurrentPath(path);
+    path += TEST_DIRECTORY_SYMBOL;
+    path += "resources";
+    path += TEST_DIRECTORY_SYMBOL;
+    path += folder;
+    if (nullptr != file) {
+        path += TEST_DIRECTORY_SYMBOL;
+        path += file;
+    }
+    return path;
+}
+
+void ConfigureValidation(const ValidationConfig& config) {
+    if (nullptr == config.level) {
+        LoaderTestUnsetEnvironmentVariable("XR_ENABLE_API_LAYERS");
+        LoaderTestUnsetEnvironmentVariable("XR_API_LAYER_PATH");
+        LoaderTestUnsetEnvironmentVariable("XR_CORE_VALIDATION_LEVEL");
+        LoaderTestUnsetEnvironmentVariable("XR_CORE_VALIDATION_COUNTERS");
+        return;
+    }
+    LoaderTestSetEnvironmentVariable("XR_API_LAYER_PATH", ResourcePath("validation_layers", nullptr));
+    LoaderTestSetEnvironmentVariable("XR_ENABLE_API_LAYERS", "XR_APILAYER_LUNARG_core_validation");
+    LoaderTestSetEnvironmentVariable("XR_CORE_VALIDATION_LEVEL", config.level);
+    LoaderTestSetEnvironmentVariable("XR_CORE_VALIDATION_COUNTERS", "1");
+}
+
+void DestroyContext(BenchmarkContext& context) {
+    if (context.action != XR_NULL_HANDLE) {
+        xrDestroyAction(context.action);
+    }
+    if (context.action_set != XR_NULL_HANDLE) {
+        xrDestroyActionSet(context.action_set);
+    }
+    if (context.base_space != XR_NULL_HANDLE) {
+        xrDestroySpace(context.base_space);
+    }
+    if (context.space != XR_NULL_HANDLE) {
+        xrDestroySpace(context.space);
+    }
+    if (context.session != XR_NULL_HANDLE) {
+        xrDestroySession(context.session);
+    }
+    if (context.instance != XR_NULL_HANDLE) {
+        xrDestroyInstance(context.instance);
+    }
+    context = BenchmarkContext();
+}
+
+bool CreateContext(BenchmarkContext& context) {
+    XrInstanceCreateInfo create_info = {XR_TYPE_INSTANCE_CREATE_INFO};
+    strcpy(create_info.applicationInfo.applicationName, "Validation Benchmark");
+    create_info.applicationInfo.applicationVersion = 1;
+    strcpy(create_info.applicationInfo.engineName, "Validation Benchmark");
+    create_info.applicationInfo.engineVersion = 1;
+    create_info.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+    // The test runtime has no graphics, so the session is created without a graphics binding.
+    const char* const headless_extension = XR_MND_HEADLESS_EXTENSION_NAME;
+    create_info.enabledExtensionCount = 1;
+    create_info.enabledExtensionNames = &headless_extension;
+    XrResult result = xrCreateInstance(&create_info, &context.instance);
+    if (XR_FAILED(result)) {
+        std::cerr << "xrCreateInstance failed with " << std::to_string(result) << std::endl;
+        context.instance = XR_NULL_HANDLE;
+        return false;
+    }
+
+    XrSystemGetInfo system_get_info = {XR_TYPE_SYSTEM_GET_INFO};
+    system_get_info.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+    XrSystemId system_id = XR_NULL_SYSTEM_ID;
+    XrSessionCreateInfo session_create_info = {XR_TYPE_SESSION_CREATE_INFO};
+    XrReferenceSpaceCreateInfo space_create_info = {XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+    space_create_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
+    space_create_info.poseInReferenceSpace.orientation.w = 1.0f;
+    XrReferenceSpaceCreateInfo base_space_create_info = space_create_info;
+    base_space_create_info.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+    XrActionSetCreateInfo action_set_create_info = {XR_TYPE_ACTION_SET_CREATE_INFO};
+    strcpy(action_set_create_info.actionSetName, "benchmark");
+    strcpy(action_set_create_info.localizedActionSetName, "Benchmark");
+    XrActionCreateInfo action_create_info = {XR_TYPE_ACTION_CREATE_INFO};
+    action_create_info.actionType = XR_ACTION_TYPE_FLOAT_INPUT;
+    strcpy(action_create_info.actionName, "trigger");
+    strcpy(action_create_info.localizedActionName, "Trigger");
+
+    if (XR_FAILED(xrGetSystem(context.instance, &system_get_info, &system_id)) ||
+        (session_create_info.systemId = system_id, XR_FAILED(xrCreateSession(context.instance, &session_create_info,
+                                                                             &context.session))) ||
+        XR_FAILED(xrCreateReferenceSpace(context.session, &space_create_info, &context.space)) ||
+        XR_FAILED(xrCreateReferenceSpace(context.session, &base_space_create_info, &context.base_space)) ||
+        XR_FAILED(xrCreateActionSet(context.instance, &action_set_create_info, &context.action_set)) ||
+        XR_FAILED(xrCreateAction(context.action_set, &action_create_info, &context.action))) {
+        std::cerr << "Failed creating the benchmark session objects" << std::endl;
+        DestroyContext(context);
+        return false;
+    }
+    return true;
+}
+
+// Returns the mean time of one call, in nanoseconds.
+double TimeCommand(const BenchmarkContext& context, const BenchmarkCommand& command, uint64_t iterations) {
+    // Warm up caches and branch predictors before the clock starts.
+    command.run(context, iterations / 10 + 1);
+    auto start = std::chrono::steady_clock::now();
+    command.run(context, iterations);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+}
+
+void PrintTextHeader(uint64_t iterations) {
+    std::cout << "Starting validation_benchmark (" << iterations << " calls per measurement)" << std::endl
+              << "--------------------" << std::endl;
+    std::cout << std::left << std::setw(10) << "level" << std::setw(24) << "command" << std::right << std::setw(12) << "ns/call"
+              << std::setw(14) << "overhead ns" << std::endl;
+}
+
+void PrintTextResult(const BenchmarkResult& result) {
+    std::cout << std::left << std::setw(10) << result.config << std::setw(24) << result.command << std::right << std::fixed
+              << std::setprecision(2) << std::setw(12) << result.ns_per_call << std::setw(14) << result.overhead_ns << std::endl;
+}
+
+void PrintCsvHeader() { std::cout << "level,command,ns_per_call,overhead_ns" << std::endl; }
+
+void PrintCsvResult(const BenchmarkResult& result) {
+    std::cout << result.config << "," << result.command << "," << std::fixed << std::setprecision(3) << result.ns_per_call
+              << "," << result.overhead_ns << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = kDefaultIterations;
+    bool csv = false;
+    for (int arg = 1; arg < argc; ++arg) {
+        std::string argument = argv[arg];
+        if (argument.compare(0, 13, "--iterations=") == 0) {
+            iterations = std::strtoull(argument.c_str() + 13, nullptr, 10);
+        } else if (argument == "--format=csv") {
+            csv = true;
+        } else if (argument == "--format=text") {
+            csv = false;
+        } else {
+            iterations = 0;
+        }
+        if (iterations == 0) {
+            std::cerr << "Usage: validation_benchmark [--iterations=<calls per measurement>] [--format=text|csv]" << std::endl;
+            return 1;
+        }
+    }
+
+    LoaderTestSetEnvironmentVariable("XR_RUNTIME_JSON", ResourcePath("runtimes", "test_runtime.json"));
+
+    if (csv) {
+        PrintCsvHeader();
+    } else {
+        PrintTextHeader(iterations);
+    }
+
+    bool success = true;
+    std::vector<double> baseline_ns(kCommandCount, 0.0);
+    for (const ValidationConfig& config : kConfigs) {
+        ConfigureValidation(config);
+        for (size_t command = 0; command < kCommandCount; ++command) {
+            // One instance per measurement, so the layer's check counters cover just this command.
+            BenchmarkContext context;
+            if (!CreateContext(context)) {
+                success = false;
+                continue;
+            }
+            BenchmarkResult result = {config.name, kCommands[command].name, 0.0, 0.0};
+            result.ns_per_call = TimeCommand(context, kCommands[command], iterations);
+            if (nullptr == config.level) {
+                baseline_ns[command] = result.ns_per_call;
+            }
+            result.overhead_ns = result.ns_per_call - baseline_ns[command];
+            if (csv) {
+                PrintCsvResult(result);
+            } else {
+                PrintTextResult(result);
+            }
+            std::cout.flush();
+            DestroyContext(context);
+        }
+    }
+
+    LoaderTestUnsetEnvironmentVariable("XR_ENABLE_API_LAYERS");
+    LoaderTestUnsetEnvironmentVariable("XR_API_LAYER_PATH");
+    LoaderTestUnsetEnvironmentVariable("XR_CORE_VALIDATION_LEVEL");
+    LoaderTestUnsetEnvironmentVariable("XR_CORE_VALIDATION_COUNTERS");
+    LoaderTestUnsetEnvironmentVariable("XR_RUNTIME_JSON");
+    return success ? 0 : 1;
+}